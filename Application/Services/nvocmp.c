@@ -654,6 +654,8 @@ static void       NVOCMP_changePageState(NVOCMP_nvHandle_t *pNvHandle, uint8_t p
                                          NVOCMP_pageState_t state);
 static void       NVOCMP_setPageState(NVOCMP_nvHandle_t *pNvHandle, uint8_t pg,
                                       NVOCMP_pageState_t state);
+static void       NVOCMP_setPageInactive(NVOCMP_nvHandle_t *pNvHandle, uint8_t pg);
+static bool       NVOCMP_isTailItem(NVOCMP_nvHandle_t *pNvHandle, NVOCMP_itemHdr_t *pHdr);
 static void       NVOCMP_setItemInactive(NVOCMP_nvHandle_t *pNvHandle, uint8_t pg,
                                          uint16_t iOfs);
 static uint8_t    NVOCMP_readItem(NVOCMP_itemHdr_t *iHdr, uint16_t ofs, uint16_t len,
@@ -2277,7 +2279,7 @@ static void NVOCMP_initNv(NVOCMP_nvHandle_t *pNvHandle)
         if(pNvHandle->actOffset > NVOCMP_PGDATAOFS + NVOCMP_ITEMHDRLEN)
         {
           NVOCMP_readHeader(pNvHandle->actPage, pNvHandle->actOffset - NVOCMP_ITEMHDRLEN , &iHdr, false);
-          if(iHdr.stats & NVOCMP_FOLLOWBIT)
+          if(NVOCMP_isTailItem(pNvHandle, &iHdr))
           {
             status = NVOCMP_findItem(pNvHandle, pNvHandle->actPage, pNvHandle->actOffset - NVOCMP_ITEMHDRLEN - iHdr.len,
                             &iHdr, NVOCMP_FINDSTRICT, NULL);
@@ -2288,6 +2290,7 @@ static void NVOCMP_initNv(NVOCMP_nvHandle_t *pNvHandle)
           }
           else
           {
+            NVOCMP_setPageInactive(pNvHandle, pNvHandle->actPage);
             NVOCMP_compactPage(pNvHandle, 0);
           }
         }
@@ -2490,7 +2493,7 @@ static void NVOCMP_initNv(NVOCMP_nvHandle_t *pNvHandle)
       if(pNvHandle->actOffset > NVOCMP_PGDATAOFS + NVOCMP_ITEMHDRLEN)
       {
         NVOCMP_readHeader(pNvHandle->actPage, pNvHandle->actOffset - NVOCMP_ITEMHDRLEN , &iHdr, false);
-        if(iHdr.stats & NVOCMP_FOLLOWBIT)
+        if(NVOCMP_isTailItem(pNvHandle, &iHdr))
         {
           status = NVOCMP_findItem(pNvHandle, pNvHandle->actPage, pNvHandle->actOffset - NVOCMP_ITEMHDRLEN - iHdr.len,
                           &iHdr, NVOCMP_FINDSTRICT, NULL);
@@ -2501,6 +2504,7 @@ static void NVOCMP_initNv(NVOCMP_nvHandle_t *pNvHandle)
         }
         else
         {
+          NVOCMP_setPageInactive(pNvHandle, pNvHandle->actPage);
           compact = true;
         }
       }
@@ -2601,7 +2605,7 @@ static void NVOCMP_initNv(NVOCMP_nvHandle_t *pNvHandle)
       if(pNvHandle->actOffset > NVOCMP_PGDATAOFS + NVOCMP_ITEMHDRLEN)
       {
         NVOCMP_readHeader(pNvHandle->actPage, pNvHandle->actOffset - NVOCMP_ITEMHDRLEN , &iHdr, false);
-        if(iHdr.stats & NVOCMP_FOLLOWBIT)
+        if(NVOCMP_isTailItem(pNvHandle, &iHdr))
         {
           status = NVOCMP_findItem(pNvHandle, pNvHandle->actPage, pNvHandle->actOffset - NVOCMP_ITEMHDRLEN - iHdr.len,
                           &iHdr, NVOCMP_FINDSTRICT, NULL);
@@ -2612,6 +2616,7 @@ static void NVOCMP_initNv(NVOCMP_nvHandle_t *pNvHandle)
         }
         else
         {
+          NVOCMP_setPageInactive(pNvHandle, pNvHandle->actPage);
           compact = true;
         }
       }
@@ -3276,6 +3281,46 @@ static void NVOCMP_setItemInactive(NVOCMP_nvHandle_t *pNvHandle, uint8_t pg,
     // Mark the item as inactive
     NVOCMP_writeByte(pg, iOfs + NVOCMP_HDRVLDOFS, tmp);
 
+    NVOCMP_setPageInactive(pNvHandle, pg);
+}
+
+/******************************************************************************
+ * @fn      NVOCMP_isTailItem
+ *
+ * @brief   Check that the header read at the end of the active page ends a
+ *          whole item, rather than the data of one cut short by a reset
+ *
+ * @param   pNvHandle - pointer to NV handle
+ * @param   pHdr - header read at the end of the active page
+ *
+ * @return  true if the item is whole
+ */
+static bool NVOCMP_isTailItem(NVOCMP_nvHandle_t *pNvHandle, NVOCMP_itemHdr_t *pHdr)
+{
+    uint16_t ofs = pNvHandle->actOffset - NVOCMP_ITEMHDRLEN;
+
+    return((pHdr->stats & NVOCMP_FOLLOWBIT) &&
+           (ofs >= pHdr->len + NVOCMP_PGDATAOFS) &&
+           ((ofs == pHdr->len + NVOCMP_PGDATAOFS) ||
+            (NVOCMP_readByte(pNvHandle->actPage, ofs - pHdr->len - 1) == NVOCMP_SIGNATURE)) &&
+           !NVOCMP_verifyCRC(ofs - pHdr->len, pHdr->len, pHdr->crc8, pNvHandle->actPage, false));
+}
+
+/******************************************************************************
+ * @fn      NVOCMP_setPageInactive
+ *
+ * @brief   Mark a page as holding inactive items, so that compaction of the
+ *          page is not skipped.  A partly written item is one of them.
+ *
+ * @param   pNvHandle - pointer to NV handle
+ * @param   pg - page to mark
+ *
+ * @return  none
+ */
+static void NVOCMP_setPageInactive(NVOCMP_nvHandle_t *pNvHandle, uint8_t pg)
+{
+    uint8_t tmp;
+
     if(pNvHandle->pageInfo[pg].allActive)
     {
       tmp = NVOCMP_readByte(pg, NVOCMP_PGHDRVER);
@@ -3639,6 +3684,7 @@ static int8_t NVOCMP_findItem(NVOCMP_nvHandle_t *pNvHandle, uint8_t pg, uint16_t
 #ifdef NVOCMP_GPRAM
               NVOCMP_restoreCache(vm);
 #endif
+              NVOCMP_setPageInactive(pNvHandle, p);
               NVOCMP_compactPage(pNvHandle, 0);
               p = NVOCMP_INCPAGE(pNvHandle->actPage);
               ofs = 0;
@@ -3775,6 +3821,7 @@ static int8_t NVOCMP_findItem(NVOCMP_nvHandle_t *pNvHandle, uint8_t pg, uint16_t
               // Something is corrupted, compact to fix
               NVOCMP_ALERT(false, "No item following current item, "
                       "compaction needed.")
+              NVOCMP_setPageInactive(pNvHandle, p);
               NVOCMP_compactPage(pNvHandle, 0);
 #if (NVOCMP_NVPAGES > NVOCMP_NVTWOP)
               p = NVOCMP_INCPAGE(pNvHandle->actPage);
@@ -4231,6 +4278,7 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
 {
     bool needScan = false;
     bool needSkip = false;
+    bool verify = true;
     bool dstFull = false;
     uint16_t dstOff;
     uint16_t endOff;
@@ -4320,6 +4368,12 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
             {
                 needScan = true;
             }
+            else if(verify && (srcOff > dataLen + NVOCMP_PGDATAOFS) &&
+                    (NVOCMP_readByte(srcPg, srcOff - dataLen - 1) != NVOCMP_SIGNATURE))
+            {
+                // Items are packed, one not preceded by a header is not one
+                needScan = true;
+            }
             else
             {
               if(!(srcHdr.stats & NVOCMP_VALIDIDBIT) && srcHdr.stats & NVOCMP_ACTIVEIDBIT)
@@ -4332,7 +4386,6 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
                   // Invalid CRC, corruption
                   NVOCMP_ALERT(false, "Item CRC incorrect!")
                   needScan = true;
-                  srcOff--;
                 }
                 else
                 {
@@ -4340,6 +4393,14 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
                   needSkip = false;
                 }
               }
+              else if(verify &&
+                      NVOCMP_verifyCRC(srcOff - dataLen, dataLen, srcHdr.crc8, srcPg, false))
+              {
+                // The last header in the page, or one found by a signature
+                // scan, may lie in the data of a partly written item: skip
+                // by its length only if the item checks
+                needScan = true;
+              }
               else
               {
                 needScan = false;
@@ -4347,10 +4408,14 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
               }
             }
 
+            verify = needScan;
             if(needScan)
             {
               // Detected a problem, find next header (scan for signature)
               NVOCMP_ALERT(false, "Attempting to find signature...")
+              // Resume just below the rejected signature byte so a torn item
+              // shorter than a header does not hide the header before it
+              srcOff += NVOCMP_HDRSIGOFS;
               bool foundSig = NVOCMP_findSignature(srcPg, &srcOff);
               if(!foundSig)
               {
@@ -4471,6 +4536,7 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
 {
     bool needScan = false;
     bool needSkip = false;
+    bool verify = true;
     uint16_t dstOff;
     uint16_t endOff;
     uint16_t srcOff;
@@ -4534,6 +4600,12 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
                 NVOCMP_ALERT(false, "Item header corrupted, data length too long.")
                 needScan = true;
             }
+            else if(verify && (srcOff > dataLen + NVOCMP_PGDATAOFS) &&
+                    (NVOCMP_readByte(srcPg, srcOff - dataLen - 1) != NVOCMP_SIGNATURE))
+            {
+                // Items are packed, one not preceded by a header is not one
+                needScan = true;
+            }
             else
             {
               if(!(srcHdr.stats & NVOCMP_VALIDIDBIT) && (srcHdr.stats & NVOCMP_ACTIVEIDBIT)) //valid bit is ok
@@ -4544,7 +4616,6 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
                   // Invalid CRC, corruption
                   NVOCMP_ALERT(false, "Item CRC incorrect!")
                   needScan = true;
-                  srcOff--;
                 }
                 else
                 {
@@ -4552,6 +4623,14 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
                   needSkip = false;
                 }
               }
+              else if(verify &&
+                      NVOCMP_verifyCRC(srcOff - dataLen, dataLen, srcHdr.crc8, srcPg, false))
+              {
+                // The last header in the page, or one found by a signature
+                // scan, may lie in the data of a partly written item: skip
+                // by its length only if the item checks
+                needScan = true;
+              }
               else
               {
                 needScan = false;
@@ -4559,10 +4638,14 @@ static NVOCMP_compactStatus_t NVOCMP_compact(NVOCMP_nvHandle_t *pNvHandle)
               }
             }
 
+            verify = needScan;
             if(needScan)
             {
               // Detected a problem, find next header (scan for signature)
               NVOCMP_ALERT(false, "Attempting to find signature...")
+              // Resume just below the rejected signature byte so a torn item
+              // shorter than a header does not hide the header before it
+              srcOff += NVOCMP_HDRSIGOFS;
               bool foundSig = NVOCMP_findSignature(srcPg, &srcOff);
               if(!foundSig)
               {
@@ -44,6 +44,7 @@
 #include "ti_zstack_config.h"
 #include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/BIOS.h>
 
 #include "rom_jt_154.h"
@@ -119,6 +120,18 @@
 #define STACK_TASK_PRIORITY   5
 #define STACK_TASK_STACK_SIZE 3072
 
+/* Consecutive runs of a service function while lower priority ones are ready */
+#ifndef STACK_TASK_RUN_BUDGET
+#define STACK_TASK_RUN_BUDGET 4
+#endif
+
+/* Wait (ms) after which a ready service function runs ahead of higher priority ones */
+#ifndef STACK_TASK_STARVE_MS
+#define STACK_TASK_STARVE_MS  20
+#endif
+
+#define STACK_TASK_NONE       0xFF
+
 
 typedef uint32_t (*pZTaskEventHandlerFn)( uint8_t task_id, uint32_t event );
 
@@ -236,6 +249,14 @@ const uint8_t zstackTasksCnt = sizeof(zstackTasksArr) / sizeof(zstackTasksArr[0]
 /* */
 uint32_t **pTasksEvents;
 
+/* Scheduler state and run-time accounting, one per entry of zstackTasksArr */
+static stackTaskStats_t stackTaskStats[sizeof(zstackTasksArr) / sizeof(zstackTasksArr[0])];
+static uint32_t stackTaskReadySince[sizeof(zstackTasksArr) / sizeof(zstackTasksArr[0])];
+static uint8_t stackTaskReady[sizeof(zstackTasksArr) / sizeof(zstackTasksArr[0])];
+static uint8_t stackTaskYielded[sizeof(zstackTasksArr) / sizeof(zstackTasksArr[0])];
+static uint8_t stackTaskLastIdx = STACK_TASK_NONE;
+static uint8_t stackTaskRunStreak = 0;
+
 /*********************************************************************
  * FUNCTIONS
  */
@@ -244,6 +265,8 @@ static void zmain_ext_addr( uint8_t *pExtAddr );
 static void stackInit(void);
 static void stackServiceFxnsInit( void );
 static void stackTaskFxn(UArg a0, UArg a1);
+static void stackTaskRun(void);
+static uint8_t stackTaskSelect(uint32_t now);
 
 /*********************************************************************
  * @fn      stackTask_init
@@ -466,32 +489,238 @@ static void stackTaskFxn(UArg a0, UArg a1)
       /* Block here until TIRTOS task gets an event */
       Semaphore_pend(stackSemHandle, BIOS_WAIT_FOREVER);
 
-      uint8_t idx = 0;
+      stackTaskRun();
+    }
+}
 
-     // copy the priority-based round-robin scheduler from OSAL
-      do {
-        if (*(pTasksEvents[idx]))  // Task is highest priority that is ready.
-        {
-          break;
-        }
-      } while (++idx < zstackTasksCnt);
+/**************************************************************************************************
+ * @fn          stackTaskRun
+ *
+ * @brief       One pass of the stack task: run the service function stackTaskSelect() picks and
+ *              account for it.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+static void stackTaskRun(void)
+{
+  uint32_t start = Clock_getTicks();
+  uint8_t idx = stackTaskSelect(start);
 
-      if (idx < zstackTasksCnt)
-      {
-        uint32_t events, key;
+  if (idx < zstackTasksCnt)
+  {
+    uint32_t events, key, ticks;
+
+    key = OsalPort_enterCS();
+    events = *(pTasksEvents[idx]);
+    *(pTasksEvents[idx]) = 0;  // Clear the Events for this task.
+    OsalPort_leaveCS(key);
+
+    events = (zstackTasksArr[idx])( 0U, events );
+
+    key = OsalPort_enterCS();
+    *(pTasksEvents[idx]) |= events;  // Add back unprocessed events to the current task.
+    OsalPort_leaveCS(key);
 
-        key = OsalPort_enterCS();
-        events = *(pTasksEvents[idx]);
-        *(pTasksEvents[idx]) = 0;  // Clear the Events for this task.
-        OsalPort_leaveCS(key);
+    // Run-time accounting
+    ticks = Clock_getTicks() - start;
+    stackTaskStats[idx].runCnt++;
+    stackTaskStats[idx].runTicks += ticks;
+    if (ticks > stackTaskStats[idx].maxRunTicks)
+    {
+      stackTaskStats[idx].maxRunTicks = ticks;
+    }
 
-        events = (zstackTasksArr[idx])( 0U, events );
+    ticks = start - stackTaskReadySince[idx];
+    if (ticks > stackTaskStats[idx].maxWaitTicks)
+    {
+      stackTaskStats[idx].maxWaitTicks = ticks;
+    }
+    stackTaskReady[idx] = FALSE;  // Waits again from the next pass if events are left
 
-        key = OsalPort_enterCS();
-        *(pTasksEvents[idx]) |= events;  // Add back unprocessed events to the current task.
-        OsalPort_leaveCS(key);
+    if (idx == stackTaskLastIdx)
+    {
+      stackTaskRunStreak++;
+    }
+    else
+    {
+      stackTaskLastIdx = idx;
+      stackTaskRunStreak = 1;
+    }
+    if (stackTaskRunStreak >= STACK_TASK_RUN_BUDGET)
+    {
+      stackTaskYielded[idx] = TRUE;  // Out of budget until the others ready have had a turn
+      stackTaskRunStreak = 0;
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          stackTaskSelect
+ *
+ * @brief       Pick the service function to run: the highest priority one that is ready, unless
+ *              it has used its run budget while lower priority ones wait, or a lower priority
+ *              one has waited longer than STACK_TASK_STARVE_MS.  One out of budget runs again
+ *              once every other ready one has had a turn.
+ *
+ * input parameters
+ *
+ * @param       now - current Clock ticks
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      index in zstackTasksArr, zstackTasksCnt if none is ready.
+ **************************************************************************************************
+ */
+static uint8_t stackTaskSelect(uint32_t now)
+{
+  uint32_t starveTicks = (STACK_TASK_STARVE_MS * 1000) / Clock_tickPeriod;
+  uint32_t wait, maxWait = 0;
+  uint8_t sel = STACK_TASK_NONE;
+  uint8_t skipped = STACK_TASK_NONE;
+  uint8_t starved = STACK_TASK_NONE;
+  uint8_t idx;
+
+  for (idx = 0; idx < zstackTasksCnt; idx++)
+  {
+    if (*(pTasksEvents[idx]) == 0)
+    {
+      stackTaskReady[idx] = FALSE;
+      stackTaskYielded[idx] = FALSE;
+      continue;
+    }
+
+    if (stackTaskReady[idx] == FALSE)
+    {
+      stackTaskReady[idx] = TRUE;
+      stackTaskReadySince[idx] = now;
+    }
+
+    if (sel == STACK_TASK_NONE)
+    {
+      if (stackTaskYielded[idx] == FALSE)
+      {
+        sel = idx;
+      }
+      else if (skipped == STACK_TASK_NONE)
+      {
+        skipped = idx;  // Out of budget, give the others ready a turn
       }
     }
+
+    wait = now - stackTaskReadySince[idx];
+    if ((wait >= starveTicks) && (wait > maxWait))
+    {
+      maxWait = wait;
+      starved = idx;
+    }
+  }
+
+  if ((starved != STACK_TASK_NONE) && (starved != sel))
+  {
+    stackTaskStats[starved].boostCnt++;
+    sel = starved;
+  }
+  else if (sel == STACK_TASK_NONE)
+  {
+    // Every one ready has had its turn, start a new round
+    memset(stackTaskYielded, FALSE, sizeof(stackTaskYielded));
+    sel = skipped;
+  }
+  else if (skipped != STACK_TASK_NONE)
+  {
+    stackTaskStats[skipped].yieldCnt++;
+  }
+
+  return (sel == STACK_TASK_NONE) ? zstackTasksCnt : sel;
+}
+
+/**************************************************************************************************
+ * @fn          stackTask_getTaskStats
+ *
+ * @brief       Read the run-time accounting of a stack service function.
+ *
+ * input parameters
+ *
+ * @param       idx - index of the service function, in scheduling priority order
+ *
+ * output parameters
+ *
+ * @param       pStats - accounting of the service function
+ *
+ * @return      TRUE if idx is valid, FALSE otherwise.
+ **************************************************************************************************
+ */
+uint8_t stackTask_getTaskStats(uint8_t idx, stackTaskStats_t *pStats)
+{
+  uint32_t key;
+
+  if (idx >= zstackTasksCnt)
+  {
+    return FALSE;
+  }
+
+  key = OsalPort_enterCS();
+  *pStats = stackTaskStats[idx];
+  OsalPort_leaveCS(key);
+
+  return TRUE;
+}
+
+/**************************************************************************************************
+ * @fn          stackTask_getTaskCnt
+ *
+ * @brief       Number of stack service functions run by the stack task.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      service function count.
+ **************************************************************************************************
+ */
+uint8_t stackTask_getTaskCnt(void)
+{
+  return zstackTasksCnt;
+}
+
+/**************************************************************************************************
+ * @fn          stackTask_clearTaskStats
+ *
+ * @brief       Clear the run-time accounting of all stack service functions.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void stackTask_clearTaskStats(void)
+{
+  uint32_t key;
+
+  key = OsalPort_enterCS();
+  memset(stackTaskStats, 0, sizeof(stackTaskStats));
+  OsalPort_leaveCS(key);
 }
 
 /**************************************************************************************************
@@ -54,6 +54,7 @@ extern "C"
 /*********************************************************************
  * INCLUDES
  */
+#include <ti/sysbios/knl/Task.h>
 #include "zstackconfig.h"
 
 /*********************************************************************
@@ -68,6 +69,17 @@ extern "C"
  * TYPEDEFS
  */
 
+// Run-time accounting of a stack service function, times in Clock ticks
+typedef struct
+{
+  uint32_t runCnt;        // Calls of the service function
+  uint32_t runTicks;      // Total time spent in the service function
+  uint32_t maxRunTicks;   // Longest call
+  uint32_t maxWaitTicks;  // Longest time from ready to called
+  uint16_t boostCnt;      // Calls ahead of higher priority ones after starving
+  uint16_t yieldCnt;      // Passes given to lower priority ones after the run budget
+} stackTaskStats_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -119,6 +131,21 @@ extern uint8_t stackTask_getStackServiceId(void);
  */
 extern Task_Handle* stackTaskGetTaskHndl(void);
 
+/*
+ * Read the run-time accounting of the stack service function at idx
+ */
+extern uint8_t stackTask_getTaskStats(uint8_t idx, stackTaskStats_t *pStats);
+
+/*
+ * Number of stack service functions
+ */
+extern uint8_t stackTask_getTaskCnt(void);
+
+/*
+ * Clear the run-time accounting of all stack service functions
+ */
+extern void stackTask_clearTaskStats(void);
+
 /*********************************************************************
 *********************************************************************/
 
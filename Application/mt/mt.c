@@ -289,17 +289,70 @@ void MT_Init(void)
 #if !defined(NPI)
 void MT_BuildAndSendZToolResponse(uint8_t cmdType, uint8_t cmdId, uint8_t dataLen, uint8_t *pData)
 {
-  uint8_t *msg_ptr;
+  uint8_t *pRspData;
 
-  if ((msg_ptr = MT_TransportAlloc((mtRpcCmdType_t)(cmdType & 0xE0), dataLen)) != NULL)
+  if ((pRspData = MT_AllocZToolResponse(cmdType, cmdId, dataLen)) != NULL)
   {
-    msg_ptr[MT_RPC_POS_LEN] = dataLen;
-    msg_ptr[MT_RPC_POS_CMD0] = cmdType;
-    msg_ptr[MT_RPC_POS_CMD1] = cmdId;
-    (void)OsalPort_memcpy(msg_ptr+MT_RPC_POS_DAT0, pData, dataLen);
+    (void)OsalPort_memcpy(pRspData, pData, dataLen);
+
+    MT_SendZToolResponse(pRspData);
+  }
+}
+
+/***************************************************************************************************
+ * @fn      MT_AllocZToolResponse
+ *
+ * @brief   Allocate a ZTOOL msg in the transport buffer, for messages that are serialized in
+ *          place instead of copied by MT_BuildAndSendZToolResponse()
+ *
+ * @param   uint8_t cmdType - include type and subsystem
+ *          uint8_t cmdId - command ID
+ *          byte dataLen
+ *
+ * @return  pointer to the data field of the msg, NULL if fail to allocate the memory
+ ***************************************************************************************************/
+uint8_t *MT_AllocZToolResponse(uint8_t cmdType, uint8_t cmdId, uint8_t dataLen)
+{
+  uint8_t *msg_ptr;
 
-    MT_TransportSend(msg_ptr);
+  if ((msg_ptr = MT_TransportAlloc((mtRpcCmdType_t)(cmdType & 0xE0), dataLen)) == NULL)
+  {
+    return NULL;
   }
+
+  msg_ptr[MT_RPC_POS_LEN] = dataLen;
+  msg_ptr[MT_RPC_POS_CMD0] = cmdType;
+  msg_ptr[MT_RPC_POS_CMD1] = cmdId;
+
+  return (msg_ptr + MT_RPC_POS_DAT0);
+}
+
+/***************************************************************************************************
+ * @fn      MT_SendZToolResponse
+ *
+ * @brief   Send a ZTOOL msg allocated by MT_AllocZToolResponse()
+ *
+ * @param   byte *pData - data field returned by MT_AllocZToolResponse()
+ *
+ * @return  void
+ ***************************************************************************************************/
+void MT_SendZToolResponse(uint8_t *pData)
+{
+  MT_TransportSend(pData - MT_RPC_POS_DAT0);
+}
+
+/***************************************************************************************************
+ * @fn      MT_TxQueueFull
+ *
+ * @brief   Check the transport for a backlog of messages to the host
+ *
+ * @param   void
+ *
+ * @return  FALSE, MT_TransportSend() writes to the serial port before returning
+ ***************************************************************************************************/
+uint8_t MT_TxQueueFull(void)
+{
+  return FALSE;
 }
 #endif /* NPI */
 /***************************************************************************************************
@@ -104,6 +104,14 @@ extern "C"
 #define MT_SYS_ZDIAGS_SAVE_STATS_TO_NV       0x1B
 #define MT_SYS_OSAL_NV_READ_EXT              0x1C
 #define MT_SYS_OSAL_NV_WRITE_EXT             0x1D
+#define MT_SYS_EVENT_LOG_READ                0x1E
+#define MT_SYS_STACK_TASK_STATS              0x1F
+#define MT_SYS_TPC_CONFIG                    0x20
+#define MT_SYS_CHAN_ACCESS_STATS             0x21
+#define MT_SYS_QUIRK_SET                     0x22
+#define MT_SYS_QUIRK_READ                    0x23
+#define MT_SYS_UTC_DISCIPLINE                0x24
+#define MT_SYS_UTC_TIME_SERVER               0x25
 
 /* Extended Non-Vloatile Memory */
 #define MT_SYS_NV_CREATE                     0x30
@@ -250,12 +258,19 @@ extern "C"
 #define MT_AF_DATA_RETRIEVE                  0x12
 #define MT_AF_APSF_CONFIG_SET                0x13
 #define MT_AF_APSF_CONFIG_GET                0x14
+#define MT_AF_DELIVERY_MODE_SET              0x15
+#define MT_AF_PROFILE_RULES_SET              0x16
+#define MT_AF_UNKNOWN_GROUP_SET              0x17
+#define MT_AF_DATA_DEDUP                     0x18
+#define MT_AF_TX_CLASS_SET                   0x19
+#define MT_AF_TX_CLASS_STATS                 0x1A
 
 /* AREQ to host */
 #define MT_AF_DATA_CONFIRM                   0x80
 #define MT_AF_INCOMING_MSG                   0x81
 #define MT_AF_INCOMING_MSG_EXT               0x82
 #define MT_AF_REFLECT_ERROR                  0x83
+#define MT_AF_INCOMING_MSG_MULTI             0x84
 
 /***************************************************************************************************
  * ZDO COMMANDS
@@ -320,6 +335,11 @@ extern "C"
 #define MT_ZDO_EXT_SEC_APS_REMOVE_REQ        0x51
 #define MT_ZDO_FORCE_CONCENTRATOR_CHANGE     0x52
 #define MT_ZDO_EXT_SET_PARAMS                0x53
+#define MT_ZDO_LEAVE_IND_MODE_SET            0x54
+#define MT_ZDO_CHAN_MIGRATE_STATUS           0x55
+#define MT_ZDO_CHILD_AGING_STATS             0x56
+#define MT_ZDO_CHAN_MIGRATE_ENABLE           0x57
+#define MT_ZDO_CB_STATS                      0x58
 
 
 /* AREQ to host */
@@ -365,6 +385,8 @@ extern "C"
 #define MT_ZDO_TC_DEVICE_IND                 0xCA
 #define MT_ZDO_PERMIT_JOIN_IND               0xCB
 #define MT_ZDO_SET_REJOIN_PARAMS             0xCC
+#define MT_ZDO_LEAVE_BATCH_IND               0xCD
+#define MT_ZDO_CHAN_MIGRATE_IND              0xCE
 
 #define MT_ZDO_MSG_CB_INCOMING               0xFF
 
@@ -441,6 +463,8 @@ extern "C"
 #define MT_UTIL_SRNG_GENERATE                0x4C
 #endif
 #define MT_UTIL_BIND_ADD_ENTRY               0x4D
+#define MT_UTIL_NBR_MGR_CONFIG               0x4E
+#define MT_UTIL_NBR_MGR_STATS                0x4F
 
 #define MT_UTIL_ASSOC_REMOVE                 0x63 // Custom command
 #define MT_UTIL_ASSOC_ADD                    0x64 // Custom command
@@ -486,9 +510,11 @@ extern "C"
 #define MT_APP_CNF_BDB_ZED_ATTEMPT_RECOVER_NWK             0x0A
 #define MT_APP_CNF_BDB_SET_DEFAULT_PARENT_INFO             0x0B
 #define MT_APP_CNF_SET_POLL_RATE_TYPE                      0x0C
+#define MT_APP_CNF_BDB_SET_CHAN_EVAL                       0x0D
 
 
 #define MT_APP_CNF_BDB_COMMISSIONING_NOTIFICATION          0x80
+#define MT_APP_CNF_BDB_CHAN_EVAL_NOTIFICATION              0x81
 //Application debug commands
 #define MT_APP_CNF_SET_NWK_FRAME_COUNTER                   0xFF
 
@@ -599,6 +625,8 @@ extern "C"
 #define MT_ZNP_BASIC_RSP_EVENT          0x2000
 #endif
 
+#define MT_AF_TX_CLASS_EVT              0x4000
+
 /* Message Command IDs */
 #define CMD_SERIAL_MSG                  0x01
 #define CMD_DEBUG_MSG                   0x02
@@ -651,6 +679,10 @@ extern "C"
 #define SPI_DEBUGTRACE_BIT              0x4000
 
 #define SPI_0DATA_MSG_LEN                5
+
+/* Bytes ahead of the data field returned by MT_AllocZToolResponse(), in the OSAL
+ * message holding it: SOF + LEN + CMD0 + CMD1, for both the MT and NPI transports */
+#define MT_RSP_DATA_OFS                  (1 + MT_RPC_FRAME_HDR_SZ)
 #define SPI_RESP_MSG_LEN_DEFAULT         6
 
 #define LEN_MAC_BEACON_MSDU             15
@@ -896,6 +928,21 @@ extern MT_msg_queue_t *_pCurQueueElem;
  */
 extern void MT_BuildAndSendZToolResponse(uint8_t cmdType, uint8_t cmdId, uint8_t dataLen, uint8_t *dataPtr);
 
+/*
+ * Allocate a ZTool response message to be serialized in place, returns its data field
+ */
+extern uint8_t *MT_AllocZToolResponse(uint8_t cmdType, uint8_t cmdId, uint8_t dataLen);
+
+/*
+ * Send a ZTool response message from MT_AllocZToolResponse()
+ */
+extern void MT_SendZToolResponse(uint8_t *pData);
+
+/*
+ * TRUE when the transport to the host has a backlog of queued messages
+ */
+extern uint8_t MT_TxQueueFull(void);
+
 /*
  * Temp test function
  */
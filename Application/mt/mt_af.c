@@ -48,6 +48,7 @@
 #include "mt_af.h"
 #include "mt_zdo.h"
 #include "nwk.h"
+#include "nwk_bufs.h"
 
 #if defined ( INTER_PAN ) || defined ( BDB_TL_INITIATOR ) || defined ( BDB_TL_TARGET )
 #include "stub_aps.h"
@@ -67,6 +68,54 @@
 #define MT_AF_EXEC_DLY  1000
 #endif
 
+/* Host data requests tracked until their confirm, to catch host retransmissions */
+#if !defined MT_AF_DEDUP_MAX
+#define MT_AF_DEDUP_MAX  8
+#endif
+
+/* Time in ms a data request is tracked when its confirm does not come */
+#if !defined MT_AF_DEDUP_TTL
+#define MT_AF_DEDUP_TTL  5000
+#endif
+
+/* Traffic class scheduling of host data requests at start up, the host turns it on and off with
+ * MT_AF_TX_CLASS_STATS. While it is off every request is passed on at once. */
+#if !defined MT_AF_TX_CLASS_ENABLE
+#define MT_AF_TX_CLASS_ENABLE       FALSE
+#endif
+
+/* NWK data buffers waiting or sent to the MAC above which a traffic class is held back */
+#if !defined MT_AF_TX_CLASS_NORMAL_LOAD
+#define MT_AF_TX_CLASS_NORMAL_LOAD  8
+#endif
+#if !defined MT_AF_TX_CLASS_BULK_LOAD
+#define MT_AF_TX_CLASS_BULK_LOAD    4
+#endif
+
+/* Default number of held back requests per class */
+#if !defined MT_AF_TX_CLASS_NORMAL_DEPTH
+#define MT_AF_TX_CLASS_NORMAL_DEPTH 8
+#endif
+#if !defined MT_AF_TX_CLASS_BULK_DEPTH
+#define MT_AF_TX_CLASS_BULK_DEPTH   16
+#endif
+
+/* Normal requests passed on in a row before a waiting bulk request gets its turn */
+#if !defined MT_AF_TX_CLASS_QUOTA
+#define MT_AF_TX_CLASS_QUOTA        4
+#endif
+
+/* Requests passed on per MT_AF_TX_CLASS_EVT and the poll time in ms while some are held back */
+#define MT_AF_TX_CLASS_BURST        4
+#define MT_AF_TX_CLASS_DLY          20
+
+#if !defined MT_AF_TX_CLASS_RULES_MAX
+#define MT_AF_TX_CLASS_RULES_MAX    8
+#endif
+
+/* MT_AF_TX_CLASS_SET cluster ID selecting the class of clusters without a rule */
+#define MT_AF_TX_CLASS_DEFAULT_CID  0xFFFF
+
 /* ------------------------------------------------------------------------------------------------
  *                                           Typedefs
  * ------------------------------------------------------------------------------------------------
@@ -85,6 +134,47 @@ typedef struct
   uint8_t tick;
 } mtAfDataReq_t;
 
+typedef struct
+{
+  afAddrType_t dstAddr;
+  uint32_t hash;              // Hash of the payload
+  uint32_t time;              // System clock when it was sent, 0 when the entry is free
+  uint16_t cId;
+  uint16_t dataLen;
+  uint8_t srcEP;
+  uint8_t transId;
+  uint8_t dupCnt;             // Retransmissions of the host attached to it
+} mtAfInFlight_t;
+
+typedef struct _mtAfTxClassReq_t
+{
+  struct _mtAfTxClassReq_t *next;
+  afAddrType_t dstAddr;
+  uint16_t cId;
+  uint16_t dataLen;
+  uint8_t srcEP;
+  uint8_t transId;
+  uint8_t txOpts;
+  uint8_t radius;
+} mtAfTxClassReq_t;           // The payload follows
+
+typedef struct
+{
+  uint8_t limit;              // Maximum number of held back requests
+  uint8_t depth;              // Held back requests
+  uint8_t maxDepth;           // High water mark of depth
+  mtAfTxClassReq_t *pHead;
+  mtAfTxClassReq_t *pTail;
+  uint32_t sentCnt;           // Requests passed on to the NWK layer
+  uint32_t dropCnt;           // Requests refused because the class was full
+} mtAfTxClass_t;
+
+typedef struct
+{
+  uint16_t cId;
+  uint8_t txClass;            // MT_AF_TX_CLASS_NONE when the rule is free
+} mtAfTxClassRule_t;
+
 typedef struct _mtAfInMsgList_t
 {
   struct _mtAfInMsgList_t *next;
@@ -101,6 +191,37 @@ typedef struct _mtAfInMsgList_t
 mtAfInMsgList_t *pMtAfInMsgList = NULL;
 mtAfDataReq_t *pMtAfDataReq = NULL;
 
+static mtAfInFlight_t mtAfInFlight[MT_AF_DEDUP_MAX];
+static uint8_t mtAfDedupEnabled = FALSE;  // Enabled by the host with MT_AF_DATA_DEDUP
+static uint32_t mtAfDedupCnt = 0;
+
+static mtAfTxClass_t mtAfTxClass[MT_AF_TX_CLASS_CNT] =
+{
+  { 0 },
+  { MT_AF_TX_CLASS_NORMAL_DEPTH },
+  { MT_AF_TX_CLASS_BULK_DEPTH }
+};
+
+/* Load of the NWK data buffers from which each class is held back */
+static const uint8_t mtAfTxClassLoad[MT_AF_TX_CLASS_CNT] =
+{
+  0xFF,
+  MT_AF_TX_CLASS_NORMAL_LOAD,
+  MT_AF_TX_CLASS_BULK_LOAD
+};
+
+static mtAfTxClassRule_t mtAfTxClassRules[MT_AF_TX_CLASS_RULES_MAX] =
+{
+  { 0x0019, MT_AF_TX_CLASS_BULK },          // OTA Upgrade
+  { 0x0006, MT_AF_TX_CLASS_INTERACTIVE },   // On/Off
+  { 0x0008, MT_AF_TX_CLASS_INTERACTIVE },   // Level Control
+  { 0x0300, MT_AF_TX_CLASS_INTERACTIVE }    // Color Control
+};
+
+static uint8_t mtAfTxClassEnabled = MT_AF_TX_CLASS_ENABLE;
+static uint8_t mtAfTxClassDefault = MT_AF_TX_CLASS_NORMAL;
+static uint8_t mtAfTxClassRun = 0;
+
 /* ------------------------------------------------------------------------------------------------
  *                                        Global Variables
  * ------------------------------------------------------------------------------------------------
@@ -110,6 +231,8 @@ mtAfDataReq_t *pMtAfDataReq = NULL;
 uint16_t _afCallbackSub;
 #endif
 
+uint8_t MT_AfDeliveryMode = MT_AF_DELIVERY_PER_ENDPOINT;
+
 /* ------------------------------------------------------------------------------------------------
  *                                        Local Functions
  * ------------------------------------------------------------------------------------------------
@@ -128,6 +251,25 @@ static void MT_AfDataRetrieve(uint8_t *pBuf);
 static void MT_AfDataStore(uint8_t *pBuf);
 static void MT_AfAPSF_ConfigSet(uint8_t *pBuf);
 static void MT_AfAPSF_ConfigGet(uint8_t *pBuf);
+static void MT_AfDeliveryModeSet(uint8_t *pBuf);
+static void MT_AfProfileRulesSet(uint8_t *pBuf);
+static void MT_AfUnknownGroupSet(uint8_t *pBuf);
+static uint8_t MT_AfIncomingSink(afIncomingMSGPacket_t *pMsg);
+static uint8_t MT_AfIncomingSinkMulti(afIncomingMSGPacket_t *pMsg, uint8_t *pEpMap, uint8_t epMapLen);
+static void MT_AfDataDedup(uint8_t *pBuf);
+static void MT_AfTxClassSet(uint8_t *pBuf);
+static void MT_AfTxClassStats(uint8_t *pBuf);
+static uint8_t MT_AfTxClassGet(uint16_t cId, uint8_t txOpts);
+static uint8_t MT_AfTxClassBufLoad(void);
+static uint8_t MT_AfTxClassHeld(uint8_t txClass);
+static uint8_t MT_AfTxClassQueue(uint8_t txClass, afAddrType_t *dstAddr, uint8_t srcEP,
+                                 uint16_t cId, uint16_t dataLen, uint8_t *pData,
+                                 uint8_t transId, uint8_t txOpts, uint8_t radius);
+static uint32_t MT_AfPayloadHash(uint8_t *pData, uint16_t len);
+static mtAfInFlight_t *MT_AfInFlightFind(afAddrType_t *dstAddr, uint8_t srcEP, uint16_t cId,
+                                         uint8_t transId, uint16_t dataLen, uint32_t hash);
+static void MT_AfInFlightAdd(afAddrType_t *dstAddr, uint8_t srcEP, uint16_t cId,
+                             uint8_t transId, uint16_t dataLen, uint32_t hash);
 
 
 /**************************************************************************************************
@@ -246,6 +388,30 @@ uint8_t MT_AfCommandProcessing(uint8_t *pBuf)
       MT_AfAPSF_ConfigGet(pBuf);
       break;
 
+    case MT_AF_DELIVERY_MODE_SET:
+      MT_AfDeliveryModeSet(pBuf);
+      break;
+
+    case MT_AF_PROFILE_RULES_SET:
+      MT_AfProfileRulesSet(pBuf);
+      break;
+
+    case MT_AF_UNKNOWN_GROUP_SET:
+      MT_AfUnknownGroupSet(pBuf);
+      break;
+
+    case MT_AF_DATA_DEDUP:
+      MT_AfDataDedup(pBuf);
+      break;
+
+    case MT_AF_TX_CLASS_SET:
+      MT_AfTxClassSet(pBuf);
+      break;
+
+    case MT_AF_TX_CLASS_STATS:
+      MT_AfTxClassStats(pBuf);
+      break;
+
     default:
       status = MT_RPC_ERR_COMMAND_ID;
       break;
@@ -287,6 +453,12 @@ static void MT_AfRegister(uint8_t *pBuf)
     {
       OsalPort_free( epDesc );
     }
+    else
+    {
+      // Serialize incoming data for the host without the MT task round trip
+      (void)afSetIncomingCB( epDesc->endPoint, MT_AfIncomingSink );
+      (void)afSetIncomingMultiCB( epDesc->endPoint, MT_AfIncomingSinkMulti );
+    }
   }
 
   /* Build and send back the response */
@@ -440,7 +612,54 @@ static void MT_AfDataRequest(uint8_t *pBuf)
   }
   else
   {
-    retValue = AF_DataRequest(&dstAddr, epDesc, cId, dataLen, pBuf, &transId, txOpts, radius);
+    mtAfInFlight_t *pInFlight = NULL;
+    uint32_t hash = 0;
+
+    if (mtAfDedupEnabled)
+    {
+      hash = MT_AfPayloadHash(pBuf, dataLen);
+      pInFlight = MT_AfInFlightFind(&dstAddr, epDesc->endPoint, cId, transId, dataLen, hash);
+    }
+
+    if (pInFlight != NULL)
+    {
+      // The host retransmitted a request that is still in flight, it gets the confirm of the
+      // request on the air instead of a second copy of the frame.
+      if (pInFlight->dupCnt < 0xFF)
+      {
+        pInFlight->dupCnt++;
+      }
+      mtAfDedupCnt++;
+      retValue = afStatus_SUCCESS;
+    }
+    else
+    {
+      uint8_t txClass = MT_AfTxClassGet(cId, txOpts);
+      uint8_t sentTransId = transId;
+
+      txOpts &= ~MT_AF_TX_OPTIONS_BULK;
+
+      if (MT_AfTxClassHeld(txClass))
+      {
+        // The confirm follows when the request is passed on by MT_AfTxClassExec()
+        retValue = MT_AfTxClassQueue(txClass, &dstAddr, epDesc->endPoint, cId, dataLen, pBuf,
+                                     transId, txOpts, radius);
+      }
+      else
+      {
+        retValue = AF_DataRequest(&dstAddr, epDesc, cId, dataLen, pBuf, &transId, txOpts, radius);
+
+        if (retValue == afStatus_SUCCESS)
+        {
+          mtAfTxClass[txClass - 1].sentCnt++;
+        }
+      }
+
+      if ((retValue == afStatus_SUCCESS) && mtAfDedupEnabled)
+      {
+        MT_AfInFlightAdd(&dstAddr, epDesc->endPoint, cId, sentTransId, dataLen, hash);
+      }
+    }
   }
 
   if (MT_RPC_CMD_SREQ == (cmd0 & MT_RPC_CMD_TYPE_MASK))
@@ -606,13 +825,45 @@ static void MT_AfInterPanCtl(uint8_t *pBuf)
 void MT_AfDataConfirm(afDataConfirm_t *pMsg)
 {
   uint8_t retArray[3];
+  uint16_t cnfCnt = 1;
+  mtAfInFlight_t *pOldest = NULL;
+  uint8_t i;
+
+  // The oldest tracked request of this endpoint and transaction is the one confirmed
+  for (i = 0; i < MT_AF_DEDUP_MAX; i++)
+  {
+    if ((mtAfInFlight[i].time != 0) &&
+        (mtAfInFlight[i].srcEP == pMsg->endpoint) &&
+        (mtAfInFlight[i].transId == pMsg->transID) &&
+        ((pOldest == NULL) || ((int32_t)(mtAfInFlight[i].time - pOldest->time) < 0)))
+    {
+      pOldest = &mtAfInFlight[i];
+    }
+  }
+
+  if (pOldest != NULL)
+  {
+    // Every retransmission attached to the request gets its own confirm
+    cnfCnt += pOldest->dupCnt;
+    pOldest->time = 0;
+  }
 
   retArray[0] = pMsg->hdr.status;
   retArray[1] = pMsg->endpoint;
   retArray[2] = pMsg->transID;
 
   /* Build and send back the response */
-  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_AF), MT_AF_DATA_CONFIRM, 3, retArray);
+  while (cnfCnt--)
+  {
+    MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_AF), MT_AF_DATA_CONFIRM, 3, retArray);
+  }
+
+  // A NWK data buffer was released, held back requests may go now
+  if ((mtAfTxClass[MT_AF_TX_CLASS_NORMAL - 1].pHead != NULL) ||
+      (mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].pHead != NULL))
+  {
+    (void)OsalPort_setEvent(MT_TaskID, MT_AF_TX_CLASS_EVT);
+  }
 }
 
 /***************************************************************************************************
@@ -639,6 +890,55 @@ void MT_AfReflectError(afReflectError_t *pMsg)
   MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_AF), MT_AF_REFLECT_ERROR, 6, retArray);
 }
 
+/***************************************************************************************************
+ * @fn          MT_AfIncomingSink
+ *
+ * @brief       AF incoming callback of the host endpoints, serializes the data straight into the
+ *              transport buffer.  The data is left to be queued to the MT task while the
+ *              transport has a backlog, or while earlier indications are still queued there so
+ *              the host gets them in order.
+ *
+ * @param       pMsg - Incoming AF data, only valid during the call.
+ *
+ * @return      TRUE if the data was taken, FALSE to queue it to the MT task
+ ***************************************************************************************************/
+static uint8_t MT_AfIncomingSink(afIncomingMSGPacket_t *pMsg)
+{
+  if ( MT_TxQueueFull() || (OsalPort_msgFind( MT_TaskID, AF_INCOMING_MSG_CMD ) != NULL) )
+  {
+    return FALSE;
+  }
+
+  MT_AfIncomingMsg( pMsg );
+
+  return TRUE;
+}
+
+/***************************************************************************************************
+ * @fn          MT_AfIncomingSinkMulti
+ *
+ * @brief       AF incoming multi callback of the host endpoints, forwards a frame matched by
+ *              several of them as one MT_AF_INCOMING_MSG_MULTI when the host selected
+ *              MT_AF_DELIVERY_COALESCED.  Otherwise, or under the conditions that make
+ *              MT_AfIncomingSink() decline, AF delivers the frame per endpoint.
+ *
+ * @param       pMsg - Incoming AF data, only valid during the call.
+ * @param       pEpMap - bitmap of the matched host endpoints.
+ * @param       epMapLen - number of bytes in pEpMap.
+ *
+ * @return      TRUE if the data was taken, FALSE to deliver it per endpoint
+ ***************************************************************************************************/
+static uint8_t MT_AfIncomingSinkMulti(afIncomingMSGPacket_t *pMsg, uint8_t *pEpMap, uint8_t epMapLen)
+{
+  if ( (MT_AfDeliveryMode != MT_AF_DELIVERY_COALESCED) || MT_TxQueueFull() ||
+       (OsalPort_msgFind( MT_TaskID, AF_INCOMING_MSG_CMD ) != NULL) )
+  {
+    return FALSE;
+  }
+
+  return MT_AfIncomingMsgMulti( pMsg, pEpMap, epMapLen );
+}
+
 /***************************************************************************************************
  * @fn          MT_AfIncomingMsg
  *
@@ -688,8 +988,9 @@ void MT_AfIncomingMsg(afIncomingMSGPacket_t *pMsg)
     respLen -= dataLen;  // Zero data bytes are sent with an over-sized incoming indication.
   }
 
-  // Attempt to allocate memory for the response packet.
-  if ((pRsp = OsalPort_malloc(respLen)) == NULL)
+  // Attempt to allocate the response packet, it is serialized straight into the transport buffer.
+  if ((pRsp = MT_AllocZToolResponse(((uint8_t)MT_RPC_CMD_AREQ|(uint8_t)MT_RPC_SYS_AF),
+                                    cmd, (uint8_t)respLen)) == NULL)
   {
     if (pItem != NULL)
     {
@@ -804,10 +1105,109 @@ void MT_AfIncomingMsg(afIncomingMSGPacket_t *pMsg)
   // messages result radius
   *pTmp = pMsg->radius;
 
-  /* Build and send back the response */
-  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ|(uint8_t)MT_RPC_SYS_AF), cmd, respLen, pRsp);
+  /* Send back the response */
+  MT_SendZToolResponse(pRsp);
+}
+
+/***************************************************************************************************
+ * @fn          MT_AfIncomingMsgMulti
+ *
+ * @brief       Forward AF Incoming data matched by several host endpoints as a single
+ *              MT_AF_INCOMING_MSG_MULTI indication.  The destination endpoint of
+ *              MT_AF_INCOMING_MSG_EXT is replaced by a bitmap of the matched endpoints
+ *              (bit n of byte n/8 set for endpoint n).
+ *
+ * @param       pMsg - Incoming AF data.
+ * @param       pEpMap - bitmap of matched host endpoints.
+ * @param       epMapLen - number of bytes in pEpMap.
+ *
+ * @return      TRUE if the indication was sent, FALSE if it does not fit in one MT frame.
+ ***************************************************************************************************/
+uint8_t MT_AfIncomingMsgMulti(afIncomingMSGPacket_t *pMsg, uint8_t *pEpMap, uint8_t epMapLen)
+{
+  #define MT_AF_INC_MSG_MULTI_LEN  29
+
+  uint16_t dataLen = pMsg->cmd.DataLength;
+  uint16_t respLen = MT_AF_INC_MSG_MULTI_LEN + epMapLen + dataLen;
+  uint8_t *pRsp, *pTmp;
+
+  if (respLen > (uint16_t)MT_RPC_DATA_MAX)
+  {
+    return FALSE;
+  }
+
+  // Serialize straight into the transport buffer
+  if ((pRsp = MT_AllocZToolResponse(((uint8_t)MT_RPC_CMD_AREQ|(uint8_t)MT_RPC_SYS_AF),
+                                    MT_AF_INCOMING_MSG_MULTI, (uint8_t)respLen)) == NULL)
+  {
+    return FALSE;
+  }
+  pTmp = pRsp;
+
+  /* Group ID */
+  *pTmp++ = LO_UINT16(pMsg->groupId);
+  *pTmp++ = HI_UINT16(pMsg->groupId);
+
+  /* Cluster ID */
+  *pTmp++ = LO_UINT16(pMsg->clusterId);
+  *pTmp++ = HI_UINT16(pMsg->clusterId);
+
+  /* Source Address */
+  *pTmp++ = pMsg->srcAddr.addrMode;
+  if (pMsg->srcAddr.addrMode == afAddr64Bit)
+  {
+    (void)OsalPort_memcpy(pTmp, pMsg->srcAddr.addr.extAddr, Z_EXTADDR_LEN);
+  }
+  else
+  {
+    (void)memset(pTmp, 0, Z_EXTADDR_LEN);
+    pTmp[0] = LO_UINT16(pMsg->srcAddr.addr.shortAddr);
+    pTmp[1] = HI_UINT16(pMsg->srcAddr.addr.shortAddr);
+  }
+  pTmp += Z_EXTADDR_LEN;
+
+  /* Source EP and PAN ID */
+  *pTmp++ = pMsg->srcAddr.endPoint;
+  *pTmp++ = LO_UINT16(pMsg->srcAddr.panId);
+  *pTmp++ = HI_UINT16(pMsg->srcAddr.panId);
+
+  /* Matched destination EPs */
+  *pTmp++ = epMapLen;
+  (void)OsalPort_memcpy(pTmp, pEpMap, epMapLen);
+  pTmp += epMapLen;
+
+  /* WasBroadCast */
+  *pTmp++ = pMsg->wasBroadcast;
+
+  /* LinkQuality */
+  *pTmp++ = pMsg->LinkQuality;
+
+  /* SecurityUse */
+  *pTmp++ = pMsg->SecurityUse;
+
+  /* Timestamp */
+  OsalPort_bufferUint32( pTmp, pMsg->timestamp );
+  pTmp += 4;
+
+  /* Data Length */
+  *pTmp++ = LO_UINT16(dataLen);
+  *pTmp++ = HI_UINT16(dataLen);
+
+  /* Data */
+  (void)OsalPort_memcpy(pTmp, pMsg->cmd.Data, dataLen);
+  pTmp += dataLen;
 
-  (void)OsalPort_free(pRsp);
+  // MAC Source address
+  *pTmp++ = LO_UINT16(pMsg->macSrcAddr);
+  *pTmp++ = HI_UINT16(pMsg->macSrcAddr);
+
+  // messages result radius
+  *pTmp = pMsg->radius;
+
+  /* Send back the response */
+  MT_SendZToolResponse(pRsp);
+
+  return TRUE;
 }
 
 /**************************************************************************************************
@@ -996,5 +1396,744 @@ static void MT_AfAPSF_ConfigGet(uint8_t *pBuf)
                                        MT_AF_APSF_CONFIG_GET, 2, buf );
 }
 
+/**************************************************************************************************
+ * @fn          MT_AfDeliveryModeSet
+ *
+ * @brief       Select how frames matching several host endpoints (broadcast endpoint or
+ *              groupcast) are forwarded: one indication per endpoint or a single
+ *              MT_AF_INCOMING_MSG_MULTI.  Firmware-owned endpoints are not affected.
+ *              Frames the transport can't take at once still go per endpoint, through
+ *              the MT task.
+ *
+ * input parameters
+ *
+ * @param       pBuf - Pointer to the received buffer.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void MT_AfDeliveryModeSet(uint8_t *pBuf)
+{
+  uint8_t rtrn = afStatus_INVALID_PARAMETER;
+  uint8_t mode = pBuf[MT_RPC_POS_DAT0];
+
+  if ((mode == MT_AF_DELIVERY_PER_ENDPOINT) || (mode == MT_AF_DELIVERY_COALESCED))
+  {
+    MT_AfDeliveryMode = mode;
+    rtrn = afStatus_SUCCESS;
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_AF),
+                                       MT_AF_DELIVERY_MODE_SET, 1, &rtrn );
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfProfileRulesSet
+ *
+ * @brief       This function is the MT proxy for afSetProfileRules().
+ *              Payload: policy, rule count, then per rule the profile ID (LE) and endpoint.
+ *
+ * input parameters
+ *
+ * @param       pBuf - Pointer to the received buffer.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void MT_AfProfileRulesSet(uint8_t *pBuf)
+{
+  afProfileRule_t rules[AF_PROFILE_RULES_MAX];
+  uint8_t rtrn = afStatus_INVALID_PARAMETER;
+  uint8_t policy, numRules, i;
+  uint8_t len = pBuf[MT_RPC_POS_LEN];
+
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+  policy = *pBuf++;
+  numRules = *pBuf++;
+
+  if ((len >= 2) &&
+      ((policy == AF_PROFILE_POLICY_DEFAULT) ||
+       ((numRules <= AF_PROFILE_RULES_MAX) && (len >= (2 + (numRules * 3))))))
+  {
+    if (policy == AF_PROFILE_POLICY_DEFAULT)
+    {
+      numRules = 0;
+    }
+
+    for (i = 0; i < numRules; i++)
+    {
+      rules[i].profileID = OsalPort_buildUint16( pBuf );
+      rules[i].endPoint = pBuf[2];
+      pBuf += 3;
+    }
+
+    rtrn = afSetProfileRules(policy, numRules, rules);
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_AF),
+                                       MT_AF_PROFILE_RULES_SET, 1, &rtrn );
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfUnknownGroupSet
+ *
+ * @brief       This function is the MT proxy for afSetUnknownGroupEp().
+ *              Payload: endpoint getting groupcasts for groups without local members,
+ *              AF_UNKNOWN_GROUP_DROP (0) to drop them.
+ *
+ * input parameters
+ *
+ * @param       pBuf - Pointer to the received buffer.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void MT_AfUnknownGroupSet(uint8_t *pBuf)
+{
+  uint8_t rtrn = afStatus_INVALID_PARAMETER;
+  uint8_t endPoint = pBuf[MT_RPC_POS_DAT0];
+
+  if (endPoint != AF_BROADCAST_ENDPOINT)
+  {
+    afSetUnknownGroupEp(endPoint);
+    rtrn = afStatus_SUCCESS;
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_AF),
+                                       MT_AF_UNKNOWN_GROUP_SET, 1, &rtrn );
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfDataDedup
+ *
+ * @brief       Control the deduplication of host data requests that are still in flight and
+ *              read its counter.
+ *              Payload: | enable | clear |
+ *              enable: 0 - disable (default), 1 - enable, 0xFF - leave as is.
+ *              clear != 0 clears the counter after it is read.
+ *
+ * input parameters
+ *
+ * @param       pBuf - Pointer to the received buffer.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void MT_AfDataDedup(uint8_t *pBuf)
+{
+  uint8_t retArray[7];
+  uint8_t inFlight = 0;
+  uint32_t now = MAP_osal_GetSystemClock();
+  uint8_t i;
+
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  if (pBuf[0] != 0xFF)
+  {
+    mtAfDedupEnabled = (pBuf[0] != 0) ? TRUE : FALSE;
+  }
+
+  for (i = 0; i < MT_AF_DEDUP_MAX; i++)
+  {
+    if ((mtAfInFlight[i].time != 0) && ((now - mtAfInFlight[i].time) < MT_AF_DEDUP_TTL))
+    {
+      inFlight++;
+    }
+  }
+
+  /* | status | enabled | inFlight | dedupCnt | */
+  retArray[0] = afStatus_SUCCESS;
+  retArray[1] = mtAfDedupEnabled;
+  retArray[2] = inFlight;
+  (void)OsalPort_bufferUint32(&retArray[3], mtAfDedupCnt);
+
+  if (pBuf[1] != 0)
+  {
+    mtAfDedupCnt = 0;
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_AF),
+                                       MT_AF_DATA_DEDUP, sizeof(retArray), retArray );
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfTxClassSet
+ *
+ * @brief       Set the outbound traffic class of a cluster. The rules apply while the classes
+ *              are enabled with MT_AF_TX_CLASS_STATS.
+ *              Payload: | cId | class |
+ *              cId MT_AF_TX_CLASS_DEFAULT_CID sets the class of clusters without a rule.
+ *              class MT_AF_TX_CLASS_NONE removes the rule of the cluster.
+ *
+ * input parameters
+ *
+ * @param       pBuf - Pointer to the received buffer.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void MT_AfTxClassSet(uint8_t *pBuf)
+{
+  mtAfTxClassRule_t *pFree = NULL;
+  uint8_t rtrn = afStatus_SUCCESS;
+  uint16_t cId;
+  uint8_t txClass;
+  uint8_t i;
+
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+  cId = OsalPort_buildUint16(pBuf);
+  txClass = pBuf[2];
+
+  if (txClass > MT_AF_TX_CLASS_CNT)
+  {
+    rtrn = afStatus_INVALID_PARAMETER;
+  }
+  else if (cId == MT_AF_TX_CLASS_DEFAULT_CID)
+  {
+    if (txClass == MT_AF_TX_CLASS_NONE)
+    {
+      rtrn = afStatus_INVALID_PARAMETER;
+    }
+    else
+    {
+      mtAfTxClassDefault = txClass;
+    }
+  }
+  else
+  {
+    for (i = 0; i < MT_AF_TX_CLASS_RULES_MAX; i++)
+    {
+      if (mtAfTxClassRules[i].txClass == MT_AF_TX_CLASS_NONE)
+      {
+        if (pFree == NULL)
+        {
+          pFree = &mtAfTxClassRules[i];
+        }
+      }
+      else if (mtAfTxClassRules[i].cId == cId)
+      {
+        break;
+      }
+    }
+
+    if (i < MT_AF_TX_CLASS_RULES_MAX)
+    {
+      mtAfTxClassRules[i].txClass = txClass;
+    }
+    else if (txClass != MT_AF_TX_CLASS_NONE)
+    {
+      if (pFree == NULL)
+      {
+        rtrn = afStatus_MEM_FAIL;
+      }
+      else
+      {
+        pFree->cId = cId;
+        pFree->txClass = txClass;
+      }
+    }
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_AF),
+                                       MT_AF_TX_CLASS_SET, 1, &rtrn );
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfTxClassStats
+ *
+ * @brief       Turn the traffic classes on or off, set the depth limits of the held back
+ *              classes and read the class counters.
+ *              Payload: | enable | normalLimit | bulkLimit | clear |
+ *              enable: 0 - disable, 1 - enable, 0xFF - leave as is. Requests held back when
+ *              the classes are disabled are still passed on in order.
+ *              A limit of 0 leaves it as is, clear != 0 clears the counters after they are read.
+ *              Response: | status | enabled | load |
+ *                          per class: depth | limit | maxDepth | sent | dropped |
+ *
+ * input parameters
+ *
+ * @param       pBuf - Pointer to the received buffer.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void MT_AfTxClassStats(uint8_t *pBuf)
+{
+  uint8_t retArray[3 + (MT_AF_TX_CLASS_CNT * 11)];
+  uint8_t *pTmp = retArray;
+  mtAfTxClass_t *pClass;
+  uint8_t i;
+
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  if (pBuf[0] != 0xFF)
+  {
+    mtAfTxClassEnabled = (pBuf[0] != 0) ? TRUE : FALSE;
+  }
+  if (pBuf[1] != 0)
+  {
+    mtAfTxClass[MT_AF_TX_CLASS_NORMAL - 1].limit = pBuf[1];
+  }
+  if (pBuf[2] != 0)
+  {
+    mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].limit = pBuf[2];
+  }
+
+  *pTmp++ = afStatus_SUCCESS;
+  *pTmp++ = mtAfTxClassEnabled;
+  *pTmp++ = MT_AfTxClassBufLoad();
+
+  for (i = 0; i < MT_AF_TX_CLASS_CNT; i++)
+  {
+    pClass = &mtAfTxClass[i];
+
+    *pTmp++ = pClass->depth;
+    *pTmp++ = pClass->limit;
+    *pTmp++ = pClass->maxDepth;
+    pTmp = OsalPort_bufferUint32(pTmp, pClass->sentCnt);
+    pTmp = OsalPort_bufferUint32(pTmp, pClass->dropCnt);
+
+    if (pBuf[3] != 0)
+    {
+      pClass->maxDepth = pClass->depth;
+      pClass->sentCnt = 0;
+      pClass->dropCnt = 0;
+    }
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_AF),
+                                       MT_AF_TX_CLASS_STATS, sizeof(retArray), retArray );
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfTxClassGet
+ *
+ * @brief       Outbound traffic class of a host data request: bulk when the request asks for it
+ *              with MT_AF_TX_OPTIONS_BULK, else the class of its cluster. Interactive for every
+ *              request while the classes are disabled.
+ *
+ * input parameters
+ *
+ * @param       cId - Cluster ID.
+ * @param       txOpts - Transmit options of the request.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      MT_AF_TX_CLASS_INTERACTIVE, MT_AF_TX_CLASS_NORMAL or MT_AF_TX_CLASS_BULK.
+ */
+static uint8_t MT_AfTxClassGet(uint16_t cId, uint8_t txOpts)
+{
+  uint8_t i;
+
+  if (!mtAfTxClassEnabled)
+  {
+    return MT_AF_TX_CLASS_INTERACTIVE;
+  }
+
+  if (txOpts & MT_AF_TX_OPTIONS_BULK)
+  {
+    return MT_AF_TX_CLASS_BULK;
+  }
+
+  for (i = 0; i < MT_AF_TX_CLASS_RULES_MAX; i++)
+  {
+    if ((mtAfTxClassRules[i].txClass != MT_AF_TX_CLASS_NONE) && (mtAfTxClassRules[i].cId == cId))
+    {
+      return mtAfTxClassRules[i].txClass;
+    }
+  }
+
+  return mtAfTxClassDefault;
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfTxClassBufLoad
+ *
+ * @brief       Number of NWK data buffers waiting for or sent to the MAC.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Load of the NWK data buffers.
+ */
+static uint8_t MT_AfTxClassBufLoad(void)
+{
+  return (nwkDB_CountTypes(NWK_DATABUF_WAITING) + nwkDB_CountTypes(NWK_DATABUF_SENT));
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfTxClassHeld
+ *
+ * @brief       Check whether a new request of a class has to be held back. It is when the NWK
+ *              data buffers are loaded or when older requests of the class are still held, to
+ *              keep the order within the class.
+ *
+ * input parameters
+ *
+ * @param       txClass - Traffic class.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      TRUE if the request has to be held back.
+ */
+static uint8_t MT_AfTxClassHeld(uint8_t txClass)
+{
+  if (txClass == MT_AF_TX_CLASS_INTERACTIVE)
+  {
+    return FALSE;
+  }
+
+  if (mtAfTxClass[txClass - 1].pHead != NULL)
+  {
+    return TRUE;
+  }
+
+  return (MT_AfTxClassBufLoad() >= mtAfTxClassLoad[txClass - 1]) ? TRUE : FALSE;
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfTxClassQueue
+ *
+ * @brief       Hold back a host data request in its class.
+ *
+ * input parameters
+ *
+ * @param       txClass - Traffic class.
+ * @param       dstAddr - Destination address.
+ * @param       srcEP - Source endpoint.
+ * @param       cId - Cluster ID.
+ * @param       dataLen - Payload length.
+ * @param       pData - Payload.
+ * @param       transId - Transaction ID.
+ * @param       txOpts - Transmit options.
+ * @param       radius - Radius.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      afStatus_SUCCESS, afStatus_MEM_FAIL when the class is full or out of memory.
+ */
+static uint8_t MT_AfTxClassQueue(uint8_t txClass, afAddrType_t *dstAddr, uint8_t srcEP,
+                                 uint16_t cId, uint16_t dataLen, uint8_t *pData,
+                                 uint8_t transId, uint8_t txOpts, uint8_t radius)
+{
+  mtAfTxClass_t *pClass = &mtAfTxClass[txClass - 1];
+  mtAfTxClassReq_t *pReq;
+
+  if ((pClass->depth >= pClass->limit) ||
+      ((pReq = OsalPort_malloc(sizeof(mtAfTxClassReq_t) + dataLen)) == NULL))
+  {
+    pClass->dropCnt++;
+    return afStatus_MEM_FAIL;
+  }
+
+  pReq->next = NULL;
+  pReq->dstAddr = *dstAddr;
+  pReq->cId = cId;
+  pReq->dataLen = dataLen;
+  pReq->srcEP = srcEP;
+  pReq->transId = transId;
+  pReq->txOpts = txOpts;
+  pReq->radius = radius;
+  (void)OsalPort_memcpy(pReq + 1, pData, dataLen);
+
+  if ((mtAfTxClass[MT_AF_TX_CLASS_NORMAL - 1].pHead == NULL) &&
+      (mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].pHead == NULL))
+  {
+    // Poll the NWK data buffers until everything held back is passed on
+    if (ZSuccess != OsalPortTimers_startTimer(MT_TaskID, MT_AF_TX_CLASS_EVT, MT_AF_TX_CLASS_DLY))
+    {
+      (void)OsalPort_setEvent(MT_TaskID, MT_AF_TX_CLASS_EVT);
+    }
+  }
+
+  if (pClass->pHead == NULL)
+  {
+    pClass->pHead = pReq;
+  }
+  else
+  {
+    pClass->pTail->next = pReq;
+  }
+  pClass->pTail = pReq;
+
+  if (++(pClass->depth) > pClass->maxDepth)
+  {
+    pClass->maxDepth = pClass->depth;
+  }
+
+  return afStatus_SUCCESS;
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfTxClassExec
+ *
+ * @brief       Pass held back host data requests on to the NWK layer as the load of the NWK
+ *              data buffers allows. Normal requests go first; after MT_AF_TX_CLASS_QUOTA of them
+ *              in a row a waiting bulk request gets its turn. A request that the NWK layer
+ *              refuses is reported to the host in its data confirm.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+void MT_AfTxClassExec(void)
+{
+  mtAfTxClass_t *pNormal = &mtAfTxClass[MT_AF_TX_CLASS_NORMAL - 1];
+  mtAfTxClass_t *pBulk = &mtAfTxClass[MT_AF_TX_CLASS_BULK - 1];
+  mtAfTxClass_t *pClass;
+  mtAfTxClassReq_t *pReq;
+  endPointDesc_t *epDesc;
+  afDataConfirm_t cnf;
+  uint8_t burst = MT_AF_TX_CLASS_BURST;
+  uint8_t bulkReady;
+  uint8_t load;
+
+  while (burst--)
+  {
+    load = MT_AfTxClassBufLoad();
+    bulkReady = ((pBulk->pHead != NULL) && (load < MT_AF_TX_CLASS_BULK_LOAD)) ? TRUE : FALSE;
+
+    if ((pNormal->pHead != NULL) && (load < MT_AF_TX_CLASS_NORMAL_LOAD) &&
+        !(bulkReady && (mtAfTxClassRun >= MT_AF_TX_CLASS_QUOTA)))
+    {
+      pClass = pNormal;
+      mtAfTxClassRun++;
+    }
+    else if (bulkReady)
+    {
+      pClass = pBulk;
+      mtAfTxClassRun = 0;
+    }
+    else
+    {
+      break;
+    }
+
+    pReq = pClass->pHead;
+    pClass->pHead = pReq->next;
+    pClass->depth--;
+
+    // The endpoint may have been deleted while the request was held back
+    if ((epDesc = afFindEndPointDesc(pReq->srcEP)) == NULL)
+    {
+      cnf.hdr.status = afStatus_INVALID_PARAMETER;
+    }
+    else
+    {
+      cnf.hdr.status = AF_DataRequest(&(pReq->dstAddr), epDesc, pReq->cId, pReq->dataLen,
+                                      (uint8_t *)(pReq + 1), &(pReq->transId), pReq->txOpts,
+                                      pReq->radius);
+    }
+
+    if (cnf.hdr.status == afStatus_SUCCESS)
+    {
+      pClass->sentCnt++;
+    }
+    else
+    {
+      cnf.hdr.event = AF_DATA_CONFIRM_CMD;
+      cnf.endpoint = pReq->srcEP;
+      cnf.transID = pReq->transId;
+      cnf.clusterID = pReq->cId;
+      MT_AfDataConfirm(&cnf);
+    }
+
+    (void)OsalPort_free(pReq);
+  }
+
+  if (pBulk->pHead == NULL)
+  {
+    mtAfTxClassRun = 0;
+  }
+
+  if ((pNormal->pHead != NULL) || (pBulk->pHead != NULL))
+  {
+    if (ZSuccess != OsalPortTimers_startTimer(MT_TaskID, MT_AF_TX_CLASS_EVT, MT_AF_TX_CLASS_DLY))
+    {
+      (void)OsalPort_setEvent(MT_TaskID, MT_AF_TX_CLASS_EVT);
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfPayloadHash
+ *
+ * @brief       FNV-1a hash of a data request payload.
+ *
+ * input parameters
+ *
+ * @param       pData - Payload.
+ * @param       len - Payload length.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Hash.
+ */
+static uint32_t MT_AfPayloadHash(uint8_t *pData, uint16_t len)
+{
+  uint32_t hash = 2166136261UL;
+
+  while (len--)
+  {
+    hash ^= *pData++;
+    hash *= 16777619UL;
+  }
+
+  return hash;
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfInFlightFind
+ *
+ * @brief       Find a host data request that is still in flight, retiring the ones whose
+ *              confirm did not come within MT_AF_DEDUP_TTL.
+ *
+ * input parameters
+ *
+ * @param       dstAddr - Destination address.
+ * @param       srcEP - Source endpoint.
+ * @param       cId - Cluster ID.
+ * @param       transId - Transaction ID.
+ * @param       dataLen - Payload length.
+ * @param       hash - Payload hash.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The in-flight request, NULL if none matches.
+ */
+static mtAfInFlight_t *MT_AfInFlightFind(afAddrType_t *dstAddr, uint8_t srcEP, uint16_t cId,
+                                         uint8_t transId, uint16_t dataLen, uint32_t hash)
+{
+  uint32_t now = MAP_osal_GetSystemClock();
+  mtAfInFlight_t *pItem;
+  uint8_t i;
+
+  for (i = 0; i < MT_AF_DEDUP_MAX; i++)
+  {
+    pItem = &mtAfInFlight[i];
+
+    if (pItem->time == 0)
+    {
+      continue;
+    }
+
+    if ((now - pItem->time) >= MT_AF_DEDUP_TTL)
+    {
+      pItem->time = 0;
+      continue;
+    }
+
+    if ((pItem->srcEP == srcEP) && (pItem->transId == transId) && (pItem->cId == cId) &&
+        (pItem->dataLen == dataLen) && (pItem->hash == hash) &&
+        (pItem->dstAddr.addrMode == dstAddr->addrMode) &&
+        (pItem->dstAddr.endPoint == dstAddr->endPoint) &&
+        (pItem->dstAddr.panId == dstAddr->panId))
+    {
+      if (dstAddr->addrMode == afAddr64Bit)
+      {
+        if (osal_ExtAddrEqual(pItem->dstAddr.addr.extAddr, dstAddr->addr.extAddr))
+        {
+          return pItem;
+        }
+      }
+      else if (pItem->dstAddr.addr.shortAddr == dstAddr->addr.shortAddr)
+      {
+        return pItem;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/**************************************************************************************************
+ * @fn          MT_AfInFlightAdd
+ *
+ * @brief       Track a host data request until its confirm. The request is not tracked when
+ *              the table is full.
+ *
+ * input parameters
+ *
+ * @param       dstAddr - Destination address.
+ * @param       srcEP - Source endpoint.
+ * @param       cId - Cluster ID.
+ * @param       transId - Transaction ID.
+ * @param       dataLen - Payload length.
+ * @param       hash - Payload hash.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void MT_AfInFlightAdd(afAddrType_t *dstAddr, uint8_t srcEP, uint16_t cId,
+                             uint8_t transId, uint16_t dataLen, uint32_t hash)
+{
+  mtAfInFlight_t *pItem;
+  uint8_t i;
+
+  for (i = 0; i < MT_AF_DEDUP_MAX; i++)
+  {
+    pItem = &mtAfInFlight[i];
+
+    if (pItem->time == 0)
+    {
+      pItem->dstAddr = *dstAddr;
+      pItem->hash = hash;
+      pItem->cId = cId;
+      pItem->dataLen = dataLen;
+      pItem->srcEP = srcEP;
+      pItem->transId = transId;
+      pItem->dupCnt = 0;
+      pItem->time = MAP_osal_GetSystemClock();
+      if (pItem->time == 0)
+      {
+        pItem->time = 1;
+      }
+      return;
+    }
+  }
+}
+
 /***************************************************************************************************
 ***************************************************************************************************/
@@ -61,6 +61,21 @@
 #define SPI_AF_CB_TYPE                  0x0900
 #endif
 
+/* Delivery of frames matching several host endpoints (MT_AF_DELIVERY_MODE_SET) */
+#define MT_AF_DELIVERY_PER_ENDPOINT     0x00  // One MT_AF_INCOMING_MSG per endpoint
+#define MT_AF_DELIVERY_COALESCED        0x01  // One MT_AF_INCOMING_MSG_MULTI per frame
+
+/* Outbound traffic classes of host data requests (MT_AF_TX_CLASS_SET) */
+#define MT_AF_TX_CLASS_NONE             0x00  // No class rule for the cluster
+#define MT_AF_TX_CLASS_INTERACTIVE      0x01  // Always passed on at once
+#define MT_AF_TX_CLASS_NORMAL           0x02  // Held back while the NWK data buffers are loaded
+#define MT_AF_TX_CLASS_BULK             0x03  // Held back earlier, served after normal traffic
+#define MT_AF_TX_CLASS_CNT              3
+
+/* MT_AF_DATA_REQUEST transmit option sending the request in the bulk class whatever its
+ * cluster while the classes are enabled, it is not passed on to the NWK layer */
+#define MT_AF_TX_OPTIONS_BULK           0x01
+
 #if defined ( INTER_PAN ) || defined ( BDB_TL_INITIATOR ) || defined ( BDB_TL_TARGET )
 typedef enum {
   InterPanClr,
@@ -73,12 +88,18 @@ typedef enum {
  * GLOBAL VARIABLES
  ***************************************************************************************************/
 extern uint16_t _afCallbackSub;
+extern uint8_t MT_AfDeliveryMode;
 
 /*
  * AF housekeeping executive.
  */
 extern void MT_AfExec(void);
 
+/*
+ * Pass held back host data requests on to the NWK layer.
+ */
+extern void MT_AfTxClassExec(void);
+
 /*
  * Process AF commands
  */
@@ -89,6 +110,11 @@ extern uint8_t MT_AfCommandProcessing(uint8_t *pBuf);
  */
 extern void MT_AfIncomingMsg(afIncomingMSGPacket_t *pMsg);
 
+/*
+ * Forward AF Incoming data once for all matched host endpoints.
+ */
+extern uint8_t MT_AfIncomingMsgMulti(afIncomingMSGPacket_t *pMsg, uint8_t *pEpMap, uint8_t epMapLen);
+
 /*
  * Process the callback subscription for Data confirm
  */
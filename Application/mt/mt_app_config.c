@@ -50,6 +50,7 @@
 #include "bdb.h"
 #include "bdb_interface.h"
 #include "zd_app.h"
+#include "zd_nwk_mgr.h"
 #include "osal_nv.h"
 
 #include "zstack.h"
@@ -70,6 +71,9 @@ static void MT_AppCnfSetAllowRejoinTCPolicy(uint8_t *pBuf);
 
 static void MT_AppCnfBDBSetChannel(uint8_t* pBuf);
 static void MT_AppCnfBDBStartCommissioning(uint8_t* pBuf);
+#if defined ( ZIGBEE_FREQ_AGILITY )
+static void MT_AppCnfBDBSetChanEval(uint8_t* pBuf);
+#endif
 #if (ZG_BUILD_COORDINATOR_TYPE)
     static void MT_AppCnfBDBSetTCRequireKeyExchange(uint8_t *pBuf);
     static void MT_AppCnfBDBAddInstallCode(uint8_t *pBuf);
@@ -127,6 +131,11 @@ uint8_t MT_AppCnfCommandProcessing(uint8_t *pBuf)
     case MT_APP_CNF_BDB_SET_CHANNEL:
       MT_AppCnfBDBSetChannel(pBuf);
     break;
+#if defined ( ZIGBEE_FREQ_AGILITY )
+    case MT_APP_CNF_BDB_SET_CHAN_EVAL:
+      MT_AppCnfBDBSetChanEval(pBuf);
+    break;
+#endif
 
 #if (ZG_BUILD_COORDINATOR_TYPE)
       case MT_APP_CNF_BDB_ADD_INSTALLCODE:
@@ -179,6 +188,97 @@ void MT_AppCnfCommissioningNotification(bdbCommissioningModeMsg_t* bdbCommission
   MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_APP_CNF), MT_APP_CNF_BDB_COMMISSIONING_NOTIFICATION, sizeof(bdbCommissioningModeMsg_t), retArray);
 }
 
+#if defined ( ZIGBEE_FREQ_AGILITY )
+/***************************************************************************************************
+* @fn      MT_AppCnfBDBChanEvalNotification
+*
+* @brief   Notify the host processor about the formation channel evaluation scores
+*
+*          | channel | passes | wifiChannels | 16 * (mean | peak | score) |
+*          |    1    |   1    |      2       |          16 * 3           |
+*
+* @param   channel - channel picked for formation, 0 if none
+*
+* @return  void
+***************************************************************************************************/
+void MT_AppCnfBDBChanEvalNotification(uint8_t channel)
+{
+  ZDNwkMgr_ChanEvalCfg_t cfg;
+  ZDNwkMgr_ChanEvalScore_t score;
+  uint8_t *pRspData;
+  uint8_t *pRsp;
+  uint8_t i;
+
+  ZDNwkMgr_ChanEvalGetConfig(&cfg);
+
+  pRspData = MT_AllocZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_APP_CNF),
+                                   MT_APP_CNF_BDB_CHAN_EVAL_NOTIFICATION,
+                                   4 + (ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS * 3));
+  if(pRspData != NULL)
+  {
+    pRsp = pRspData;
+    *pRsp++ = channel;
+    *pRsp++ = cfg.passes;
+    *pRsp++ = LO_UINT16(cfg.wifiChannels);
+    *pRsp++ = HI_UINT16(cfg.wifiChannels);
+
+    for(i = 0; i < ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS; i++)
+    {
+      ZDNwkMgr_ChanEvalGetScore(i + ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL, &score);
+      *pRsp++ = score.mean;
+      *pRsp++ = score.peak;
+      *pRsp++ = score.score;
+    }
+
+    MT_SendZToolResponse(pRspData);
+  }
+}
+
+/***************************************************************************************************
+* @fn      MT_AppCnfBDBSetChanEval
+*
+* @brief   Configure the channel evaluation done before network formation
+*
+*          | passes | scanDuration | interval | wifiChannels |
+*          |   1    |      1       |    2     |      2       |
+*
+*          passes 0 disables the evaluation, wifiChannels has bit (n - 1) set for
+*          Wi-Fi channel n in use nearby.
+*
+* @param   pBuf - pointer to received buffer
+*
+* @return  void
+***************************************************************************************************/
+static void MT_AppCnfBDBSetChanEval(uint8_t* pBuf)
+{
+  ZDNwkMgr_ChanEvalCfg_t cfg;
+  uint8_t retValue = ZSuccess;
+  uint8_t cmdId;
+
+  /* parse header */
+  cmdId = pBuf[MT_RPC_POS_CMD1];
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  cfg.passes = *pBuf++;
+  cfg.scanDuration = *pBuf++;
+  cfg.interval = OsalPort_buildUint16(pBuf);
+  pBuf += sizeof(uint16_t);
+  cfg.wifiChannels = OsalPort_buildUint16(pBuf);
+
+  if(cfg.scanDuration > 14)
+  {
+    retValue = ZInvalidParameter;
+  }
+  else
+  {
+    ZDNwkMgr_ChanEvalConfig(&cfg);
+  }
+
+  /* Build and send back the response */
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_APP_CNF), cmdId, 1, &retValue);
+}
+#endif
+
 
 /***************************************************************************************************
 * @fn      MT_AppCnfBDBStartCommissioning
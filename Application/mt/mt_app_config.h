@@ -71,6 +71,11 @@ extern uint8_t MT_AppCnfCommandProcessing(uint8_t *pBuf);
  */
 extern void MT_AppCnfCommissioningNotification(bdbCommissioningModeMsg_t* bdbCommissioningModeMsg);
 
+/*
+ * @brief   Notify the host processor about the formation channel evaluation scores
+ */
+extern void MT_AppCnfBDBChanEvalNotification(uint8_t channel);
+
 #endif /* MT_APP_CNF_FUNC */
 
 
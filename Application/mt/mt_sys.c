@@ -60,9 +60,16 @@
 #if defined( FEATURE_SYSTEM_STATS )
 #include "zdiags.h"
 #endif
+#include <ti/sysbios/knl/Clock.h>
+#include "zstackstartup.h"
+#if defined( FEATURE_EVENT_LOG )
+#include "zevtlog.h"
+#endif
+#include "zquirk.h"
 
 #ifdef FEATURE_UTC_TIME
   #include "utc_clock.h"
+  #include "utc_timesrv.h"
 #endif //FEATURE_UTC_TIME
 
 #if defined( ENABLE_MT_SYS_RESET_SHUTDOWN )
@@ -79,6 +86,25 @@
 #define MT_ARSP_SYS ((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_SYS)
 #define MT_SRSP_SYS ((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_SYS)
 
+#if defined( FEATURE_EVENT_LOG )
+/* Serialized event log record: time, seqNum, type, info, nwkAddr, extAddr, param */
+#define MT_SYS_EVENT_LOG_REC_LEN     (4 + 2 + 1 + 1 + 2 + Z_EXTADDR_LEN + 1)
+#define MT_SYS_EVENT_LOG_MAX_RECS    ((MT_RPC_DATA_MAX - 2) / MT_SYS_EVENT_LOG_REC_LEN)
+#endif
+
+/* Serialized quirk entry: index, keyType, quirks, key */
+#define MT_SYS_QUIRK_REC_LEN         (1 + 1 + 1 + Z_EXTADDR_LEN)
+#define MT_SYS_QUIRK_MAX_RECS        ((MT_RPC_DATA_MAX - 3) / MT_SYS_QUIRK_REC_LEN)
+
+/* Serialized stack task accounting: runCnt, runTicks, maxRunTicks, maxWaitTicks, boostCnt, yieldCnt */
+#define MT_SYS_STACK_TASK_REC_LEN    (4 + 4 + 4 + 4 + 2 + 2)
+#define MT_SYS_STACK_TASK_MAX_RECS   ((MT_RPC_DATA_MAX - 8) / MT_SYS_STACK_TASK_REC_LEN)
+
+/* Serialized channel access outcomes: channel, txCnt, ccaFailCnt, noAckCnt, overflowCnt */
+#define MT_SYS_CHAN_ACCESS_HDR_LEN   (1 + 1 + 3 + (ZMAC_CSMA_NB_BINS * 4) + 1 + 1)
+#define MT_SYS_CHAN_ACCESS_REC_LEN   (1 + 4 + 4 + 4 + 4)
+#define MT_SYS_CHAN_ACCESS_MAX_RECS  ((MT_RPC_DATA_MAX - MT_SYS_CHAN_ACCESS_HDR_LEN) / MT_SYS_CHAN_ACCESS_REC_LEN)
+
 /* Max possible MT response length, limited by TX buffer and sizeof uint8_t */
 #define MT_MAX_RSP_LEN  255
 
@@ -161,6 +187,8 @@ static void MT_SysStackTune(uint8_t *pBuf);
 #ifdef FEATURE_UTC_TIME
 static void MT_SysSetUtcTime(uint8_t *pBuf);
 static void MT_SysGetUtcTime(void);
+static void MT_SysUtcDiscipline(uint8_t *pBuf);
+static void MT_SysUtcTimeServer(uint8_t *pBuf);
 #endif //FEATURE_UTC_TIME
 static void MT_SysSetTxPower(uint8_t *pBuf);
 #if !defined( CC26XX ) && !defined (DeviceFamily_CC26X2) && !defined (DeviceFamily_CC13X2) && !defined (DeviceFamily_CC26X2X7) && !defined (DeviceFamily_CC13X2X7)
@@ -191,6 +219,14 @@ static void MT_SysZDiagsGetStatsAttr(uint8_t *pBuf);
 static void MT_SysZDiagsRestoreStatsFromNV(void);
 static void MT_SysZDiagsSaveStatsToNV(void);
 #endif /* FEATURE_SYSTEM_STATS */
+#if defined( FEATURE_EVENT_LOG )
+static void MT_SysEventLogRead(uint8_t *pBuf);
+#endif /* FEATURE_EVENT_LOG */
+static void MT_SysStackTaskStats(uint8_t *pBuf);
+static void MT_SysTpcConfig(uint8_t *pBuf);
+static void MT_SysChanAccessStats(uint8_t *pBuf);
+static void MT_SysQuirkSet(uint8_t *pBuf);
+static void MT_SysQuirkRead(uint8_t *pBuf);
 #if defined( ENABLE_MT_SYS_RESET_SHUTDOWN )
 static void powerOffSoc(void);
 #endif /* ENABLE_MT_SYS_RESET_SHUTDOWN */
@@ -268,6 +304,14 @@ uint8_t MT_SysCommandProcessing(uint8_t *pBuf)
     case MT_SYS_GET_TIME:
       MT_SysGetUtcTime();
       break;
+
+    case MT_SYS_UTC_DISCIPLINE:
+      MT_SysUtcDiscipline(pBuf);
+      break;
+
+    case MT_SYS_UTC_TIME_SERVER:
+      MT_SysUtcTimeServer(pBuf);
+      break;
 #endif // FEATURE_UTC_TIME
     case MT_SYS_SET_TX_POWER:
       MT_SysSetTxPower(pBuf);
@@ -347,6 +391,32 @@ uint8_t MT_SysCommandProcessing(uint8_t *pBuf)
       break;
 #endif /* FEATURE_SYSTEM_STATS */
 
+#if defined( FEATURE_EVENT_LOG )
+    case MT_SYS_EVENT_LOG_READ:
+      MT_SysEventLogRead(pBuf);
+      break;
+#endif /* FEATURE_EVENT_LOG */
+
+    case MT_SYS_STACK_TASK_STATS:
+      MT_SysStackTaskStats(pBuf);
+      break;
+
+    case MT_SYS_TPC_CONFIG:
+      MT_SysTpcConfig(pBuf);
+      break;
+
+    case MT_SYS_CHAN_ACCESS_STATS:
+      MT_SysChanAccessStats(pBuf);
+      break;
+
+    case MT_SYS_QUIRK_SET:
+      MT_SysQuirkSet(pBuf);
+      break;
+
+    case MT_SYS_QUIRK_READ:
+      MT_SysQuirkRead(pBuf);
+      break;
+
     default:
       status = MT_RPC_ERR_COMMAND_ID;
       break;
@@ -1611,6 +1681,83 @@ static void MT_SysGetUtcTime(void)
   }
 }
 
+/******************************************************************************
+ * @fn      MT_SysUtcDiscipline
+ *
+ * @brief   Discipline the UTC clock from a host sync point.
+ *
+ * @param   pBuf - pointer to the data
+ *
+ *          | utcTime | msec |
+ *          |    4    |  2   |
+ *
+ * @return  None
+ *****************************************************************************/
+static void MT_SysUtcDiscipline(uint8_t *pBuf)
+{
+  uint8_t rsp[8];
+  UTCDiscipline disc;
+  UTCTime utcSecs;
+  uint16_t msec;
+
+  /* Skip over RPC header */
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  utcSecs = OsalPort_buildUint32( pBuf, 4 );
+  msec = OsalPort_buildUint16( &pBuf[4] );
+
+  if ( (utcSecs == 0) || (msec > 999) )
+  {
+    rsp[0] = ZInvalidParameter;
+    rsp[1] = 0;
+  }
+  else
+  {
+    rsp[0] = ZSuccess;
+    rsp[1] = UTC_discipline( utcSecs, msec );
+  }
+
+  /* Offset measured and rate correction */
+  UTC_getDiscipline( &disc );
+  OsalPort_bufferUint32( &rsp[2], (uint32_t)disc.offsetMSec );
+  rsp[6] = LO_UINT16( disc.driftPpm );
+  rsp[7] = HI_UINT16( disc.driftPpm );
+
+  MT_BuildAndSendZToolResponse( MT_SRSP_SYS, MT_SYS_UTC_DISCIPLINE,
+                                sizeof(rsp), rsp );
+}
+
+/******************************************************************************
+ * @fn      MT_SysUtcTimeServer
+ *
+ * @brief   Set the ZCL Time cluster server endpoint and local time.
+ *
+ * @param   pBuf - pointer to the data
+ *
+ *          | endpoint | timeZone | dstStart | dstEnd | dstShift |
+ *          |    1     |    4     |    4     |   4    |    4     |
+ *
+ *          endpoint 0 removes the server.
+ *
+ * @return  None
+ *****************************************************************************/
+static void MT_SysUtcTimeServer(uint8_t *pBuf)
+{
+  uint8_t retStat;
+
+  /* Skip over RPC header */
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  retStat = UTC_timeServerConfig( pBuf[0],
+                                  (int32_t)OsalPort_buildUint32( &pBuf[1], 4 ),
+                                  OsalPort_buildUint32( &pBuf[5], 4 ),
+                                  OsalPort_buildUint32( &pBuf[9], 4 ),
+                                  (int32_t)OsalPort_buildUint32( &pBuf[13], 4 ) );
+
+  MT_BuildAndSendZToolResponse( MT_SRSP_SYS, MT_SYS_UTC_TIME_SERVER,
+                                sizeof(retStat), &retStat );
+}
+
 #endif //FEATURE_UTC_TIME
 
 /******************************************************************************
@@ -1762,6 +1909,392 @@ static void MT_SysZDiagsSaveStatsToNV(void)
                                 sizeof(retBuf), retBuf);
 }
 #endif /* FEATURE_SYSTEM_STATS */
+
+#if defined ( FEATURE_EVENT_LOG )
+/******************************************************************************
+ * @fn      MT_SysEventLogRead
+ *
+ * @brief   Read records of the network event log, newest first.
+ *
+ * @param   uint8_t pBuf - pointer to the data
+ *
+ *          | type | nwkAddr | skip |
+ *          |  1   |    2    |  2   |
+ *
+ *          type 0xFF and nwkAddr 0xFFFE return all records.
+ *
+ * @return  None
+ *****************************************************************************/
+static void MT_SysEventLogRead(uint8_t *pBuf)
+{
+  zevtlogRecord_t *pRecs;
+  uint8_t *pRspData;
+  uint8_t *pRsp;
+  uint8_t type;
+  uint8_t count = 0;
+  uint8_t idx;
+  uint16_t nwkAddr;
+  uint16_t skip;
+
+  /* parse header */
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  type = *pBuf++;
+  nwkAddr = OsalPort_buildUint16( pBuf );
+  pBuf += 2;
+  skip = OsalPort_buildUint16( pBuf );
+
+  pRecs = OsalPort_malloc( MT_SYS_EVENT_LOG_MAX_RECS * sizeof( zevtlogRecord_t ) );
+  if ( pRecs != NULL )
+  {
+    count = ZEvtLogRead( type, nwkAddr, skip, MT_SYS_EVENT_LOG_MAX_RECS, pRecs );
+  }
+
+  /* | status | count | count * record | */
+  pRspData = MT_AllocZToolResponse( MT_SRSP_SYS, MT_SYS_EVENT_LOG_READ,
+                                    2 + (count * MT_SYS_EVENT_LOG_REC_LEN) );
+  if ( pRspData != NULL )
+  {
+    pRsp = pRspData;
+    *pRsp++ = (pRecs != NULL) ? ZSuccess : ZMemError;
+    *pRsp++ = count;
+
+    for ( idx = 0; idx < count; idx++ )
+    {
+      pRsp = OsalPort_bufferUint32( pRsp, pRecs[idx].time );
+      *pRsp++ = LO_UINT16( pRecs[idx].seqNum );
+      *pRsp++ = HI_UINT16( pRecs[idx].seqNum );
+      *pRsp++ = pRecs[idx].type;
+      *pRsp++ = pRecs[idx].info;
+      *pRsp++ = LO_UINT16( pRecs[idx].nwkAddr );
+      *pRsp++ = HI_UINT16( pRecs[idx].nwkAddr );
+      pRsp = OsalPort_memcpy( pRsp, pRecs[idx].extAddr, Z_EXTADDR_LEN );
+      *pRsp++ = pRecs[idx].param;
+    }
+
+    MT_SendZToolResponse( pRspData );
+  }
+
+  if ( pRecs != NULL )
+  {
+    OsalPort_free( pRecs );
+  }
+}
+#endif /* FEATURE_EVENT_LOG */
+
+/******************************************************************************
+ * @fn      MT_SysStackTaskStats
+ *
+ * @brief   Read the run-time accounting of the stack service functions, in
+ *          scheduling priority order (MT first).
+ *
+ * @param   uint8_t pBuf - pointer to the data
+ *
+ *          | startIdx | clear |
+ *          |    1     |   1   |
+ *
+ *          clear != 0 clears the accounting after it is read.
+ *
+ * @return  None
+ *****************************************************************************/
+static void MT_SysStackTaskStats(uint8_t *pBuf)
+{
+  stackTaskStats_t stats;
+  uint8_t *pRspData;
+  uint8_t *pRsp;
+  uint8_t startIdx;
+  uint8_t clear;
+  uint8_t count = 0;
+  uint8_t taskCnt = stackTask_getTaskCnt();
+
+  /* parse header */
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  startIdx = pBuf[0];
+  clear = pBuf[1];
+
+  if ( startIdx < taskCnt )
+  {
+    count = taskCnt - startIdx;
+    if ( count > MT_SYS_STACK_TASK_MAX_RECS )
+    {
+      count = MT_SYS_STACK_TASK_MAX_RECS;
+    }
+  }
+
+  /* | status | tickPeriod | taskCnt | startIdx | count | count * record | */
+  pRspData = MT_AllocZToolResponse( MT_SRSP_SYS, MT_SYS_STACK_TASK_STATS,
+                                    8 + (count * MT_SYS_STACK_TASK_REC_LEN) );
+  if ( pRspData != NULL )
+  {
+    pRsp = pRspData;
+    *pRsp++ = ( startIdx < taskCnt ) ? ZSuccess : ZInvalidParameter;
+    pRsp = OsalPort_bufferUint32( pRsp, Clock_tickPeriod );
+    *pRsp++ = taskCnt;
+    *pRsp++ = startIdx;
+    *pRsp++ = count;
+
+    while ( count-- )
+    {
+      (void)stackTask_getTaskStats( startIdx++, &stats );
+      pRsp = OsalPort_bufferUint32( pRsp, stats.runCnt );
+      pRsp = OsalPort_bufferUint32( pRsp, stats.runTicks );
+      pRsp = OsalPort_bufferUint32( pRsp, stats.maxRunTicks );
+      pRsp = OsalPort_bufferUint32( pRsp, stats.maxWaitTicks );
+      *pRsp++ = LO_UINT16( stats.boostCnt );
+      *pRsp++ = HI_UINT16( stats.boostCnt );
+      *pRsp++ = LO_UINT16( stats.yieldCnt );
+      *pRsp++ = HI_UINT16( stats.yieldCnt );
+    }
+
+    MT_SendZToolResponse( pRspData );
+  }
+
+  if ( clear )
+  {
+    stackTask_clearTaskStats();
+  }
+}
+
+/******************************************************************************
+ * @fn      MT_SysTpcConfig
+ *
+ * @brief   Configure the per-destination transmit power control. The power
+ *          set with MT_SYS_SET_TX_POWER stays the upper limit.
+ *
+ * @param   uint8_t pBuf - pointer to the data
+ *
+ *          | enabled | margin | sensitivity | fallback |
+ *          |    1    |   1    |      1      |    1     |
+ *
+ *          enabled == 0xFF only reads the current configuration.
+ *
+ * @return  None
+ *****************************************************************************/
+static void MT_SysTpcConfig(uint8_t *pBuf)
+{
+  ZMacTpcCfg_t cfg;
+  uint8_t retArray[5];
+
+  /* parse header */
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  retArray[0] = ZSuccess;
+
+  if ( pBuf[0] != 0xFF )
+  {
+    cfg.enabled = pBuf[0];
+    cfg.margin = pBuf[1];
+    cfg.sensitivity = (int8_t)pBuf[2];
+    cfg.fallback = pBuf[3];
+
+    retArray[0] = ZMacTpcConfig( &cfg );
+  }
+
+  ZMacTpcGetConfig( &cfg );
+  retArray[1] = cfg.enabled;
+  retArray[2] = cfg.margin;
+  retArray[3] = (uint8_t)cfg.sensitivity;
+  retArray[4] = cfg.fallback;
+
+  /* | status | enabled | margin | sensitivity | fallback | */
+  MT_BuildAndSendZToolResponse( MT_SRSP_SYS, MT_SYS_TPC_CONFIG,
+                                sizeof(retArray), retArray );
+}
+
+/******************************************************************************
+ * @fn      MT_SysChanAccessStats
+ *
+ * @brief   Read the MAC channel access statistics and control the adaptive
+ *          CSMA controller.
+ *
+ * @param   uint8_t pBuf - pointer to the data
+ *
+ *          | startChannel | ctrl | clear |
+ *          |      1       |  1   |   1   |
+ *
+ *          ctrl: 0 - disable, 1 - enable, 0xFF - leave the controller as is.
+ *          clear != 0 clears the statistics after they are read.
+ *          Only channels that have carried data requests are reported.
+ *
+ * @return  None
+ *****************************************************************************/
+static void MT_SysChanAccessStats(uint8_t *pBuf)
+{
+  ZMacChanAccessStats_t stats;
+  ZMacCsmaParams_t params;
+  uint32_t hist[ZMAC_CSMA_NB_BINS];
+  uint8_t *pRspData;
+  uint8_t *pRsp;
+  uint8_t status;
+  uint8_t count;
+  uint8_t channel;
+  uint8_t level;
+  uint8_t clear;
+  uint8_t i;
+
+  /* parse header */
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  channel = pBuf[0];
+  if ( pBuf[1] != 0xFF )
+  {
+    ZMacCsmaCtrlEnable( pBuf[1] ? TRUE : FALSE );
+  }
+  clear = pBuf[2];
+
+  level = ZMacCsmaCtrlGet( &params );
+  ZMacChanAccessGetBackoffHist( hist );
+
+  status = ZMacChanAccessGetStats( channel, &stats );
+
+  /* count the channels that have carried data requests */
+  count = 0;
+  for ( i = channel; ZMacChanAccessGetStats( i, &stats ) == ZMacSuccess; i++ )
+  {
+    if ( (stats.txCnt != 0) && (count < MT_SYS_CHAN_ACCESS_MAX_RECS) )
+    {
+      count++;
+    }
+  }
+
+  /* | status | level | minBe | maxBe | maxBackoffs | hist | startChannel | count | count * record | */
+  pRspData = MT_AllocZToolResponse( MT_SRSP_SYS, MT_SYS_CHAN_ACCESS_STATS,
+                                    MT_SYS_CHAN_ACCESS_HDR_LEN + (count * MT_SYS_CHAN_ACCESS_REC_LEN) );
+  if ( pRspData != NULL )
+  {
+    pRsp = pRspData;
+    *pRsp++ = status;
+    *pRsp++ = level;
+    *pRsp++ = params.minBe;
+    *pRsp++ = params.maxBe;
+    *pRsp++ = params.maxBackoffs;
+    for ( i = 0; i < ZMAC_CSMA_NB_BINS; i++ )
+    {
+      pRsp = OsalPort_bufferUint32( pRsp, hist[i] );
+    }
+    *pRsp++ = channel;
+    *pRsp++ = count;
+
+    while ( count != 0 )
+    {
+      (void)ZMacChanAccessGetStats( channel, &stats );
+      if ( stats.txCnt != 0 )
+      {
+        *pRsp++ = channel;
+        pRsp = OsalPort_bufferUint32( pRsp, stats.txCnt );
+        pRsp = OsalPort_bufferUint32( pRsp, stats.ccaFailCnt );
+        pRsp = OsalPort_bufferUint32( pRsp, stats.noAckCnt );
+        pRsp = OsalPort_bufferUint32( pRsp, stats.overflowCnt );
+        count--;
+      }
+      channel++;
+    }
+
+    MT_SendZToolResponse( pRspData );
+  }
+
+  if ( clear )
+  {
+    ZMacChanAccessClear();
+  }
+}
+
+/******************************************************************************
+ * @fn      MT_SysQuirkSet
+ *
+ * @brief   Add, change or remove an entry of the device quirk table.
+ *
+ * @param   uint8_t pBuf - pointer to the data
+ *
+ *          | keyType | key | quirks |
+ *          |    1    |  8  |   1    |
+ *
+ *          quirks 0 removes the entry, keyType 0xFF clears the table.
+ *
+ * @return  None
+ *****************************************************************************/
+static void MT_SysQuirkSet(uint8_t *pBuf)
+{
+  uint8_t status;
+  uint8_t len = pBuf[MT_RPC_POS_LEN];
+
+  /* parse header */
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  if ( len < (2 + Z_EXTADDR_LEN) )
+  {
+    status = ZInvalidParameter;
+  }
+  else
+  {
+    status = ZQuirkSet( pBuf[0], &pBuf[1], pBuf[1 + Z_EXTADDR_LEN] );
+  }
+
+  MT_BuildAndSendZToolResponse( MT_SRSP_SYS, MT_SYS_QUIRK_SET, 1, &status );
+}
+
+/******************************************************************************
+ * @fn      MT_SysQuirkRead
+ *
+ * @brief   Read the used entries of the device quirk table.
+ *
+ * @param   uint8_t pBuf - pointer to the data
+ *
+ *          | startIndex |
+ *          |     1      |
+ *
+ * @return  None
+ *****************************************************************************/
+static void MT_SysQuirkRead(uint8_t *pBuf)
+{
+  zquirkEntry_t entry;
+  uint8_t *pRspData;
+  uint8_t *pRsp;
+  uint8_t start;
+  uint8_t count = 0;
+  uint8_t idx;
+
+  /* parse header */
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+
+  start = pBuf[0];
+
+  /* count the used entries */
+  for ( idx = start; ZQuirkRead( idx, &entry ) && (count < MT_SYS_QUIRK_MAX_RECS); idx++ )
+  {
+    if ( entry.keyType != ZQUIRK_KEY_NONE )
+    {
+      count++;
+    }
+  }
+
+  /* | status | startIndex | count | count * record | */
+  pRspData = MT_AllocZToolResponse( MT_SRSP_SYS, MT_SYS_QUIRK_READ,
+                                    3 + (count * MT_SYS_QUIRK_REC_LEN) );
+  if ( pRspData != NULL )
+  {
+    pRsp = pRspData;
+    *pRsp++ = ZSuccess;
+    *pRsp++ = start;
+    *pRsp++ = count;
+
+    for ( idx = start; count != 0; idx++ )
+    {
+      (void)ZQuirkRead( idx, &entry );
+      if ( entry.keyType != ZQUIRK_KEY_NONE )
+      {
+        *pRsp++ = idx;
+        *pRsp++ = entry.keyType;
+        *pRsp++ = entry.quirks;
+        pRsp = OsalPort_memcpy( pRsp, entry.key, Z_EXTADDR_LEN );
+        count--;
+      }
+    }
+
+    MT_SendZToolResponse( pRspData );
+  }
+}
 #endif /* MT_SYS_FUNC */
 
 /******************************************************************************
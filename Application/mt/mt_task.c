@@ -54,6 +54,15 @@
 #include "mt_znp.h"
 #endif  /* MT_ZNP_FUNC */
 
+/***************************************************************************************************
+ * CONSTANTS
+ ***************************************************************************************************/
+
+/* Host commands processed per MT task run, the stack scheduler runs other tasks in between */
+#if !defined( MT_MSG_BUDGET )
+#define MT_MSG_BUDGET  4
+#endif
+
 /***************************************************************************************************
  * LOCAL FUNCTIONS
  ***************************************************************************************************/
@@ -110,6 +119,7 @@ void MT_TaskInit(uint8_t task_id)
 uint32_t MT_ProcessEvent(uint8_t task_id, uint32_t events)
 {
   mtOSALSerialData_t *pMsg;
+  uint8_t budget = MT_MSG_BUDGET;
 
   if ( events & SYS_EVENT_MSG )
   {
@@ -118,6 +128,12 @@ uint32_t MT_ProcessEvent(uint8_t task_id, uint32_t events)
       MT_ProcessIncomingCommand(pMsg);
       OsalPort_msgDeallocate((uint8_t *)pMsg);
       // if pMsg->msg exists, MT_ProcessIncomingCommand will free the memory
+
+      if ( --budget == 0 )
+      {
+        /* Yield to the other stack tasks, OsalPort_msgReceive() signaled the rest */
+        break;
+      }
     }
     /* Return unproccessed events */
     return (events ^ SYS_EVENT_MSG);
@@ -142,6 +158,12 @@ uint32_t MT_ProcessEvent(uint8_t task_id, uint32_t events)
     MT_AfExec();
     return (events ^ MT_AF_EXEC_EVT);
   }
+
+  if ( events & MT_AF_TX_CLASS_EVT )
+  {
+    MT_AfTxClassExec();
+    return (events ^ MT_AF_TX_CLASS_EVT);
+  }
 #endif  /* NONWK */
 
   /* Handle MT_SYS_OSAL_START_TIMER callbacks */
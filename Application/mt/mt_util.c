@@ -60,6 +60,7 @@
 #include "assoc_list.h"
 #include "zd_app.h"
 #include "zd_sec_mgr.h"
+#include "nwk_nbrmgr.h"
 #endif
 
 #if defined MT_SRNG
@@ -133,6 +134,8 @@ static void MT_UtilAssocAdd(uint8_t * pBuf);
 static void MT_UtilAssocFindDevice(uint8_t *pBuf);
 static void MT_UtilAssocGetWithAddress(uint8_t *pBuf);
 static void MT_UtilBindAddEntry(uint8_t *pBuf);
+static void MT_UtilNbrMgrConfig(uint8_t *pBuf);
+static void MT_UtilNbrMgrStats(uint8_t *pBuf);
 static void packDev_t(uint8_t *pBuf, associated_devices_t *pDev);
 static void packBindEntry_t(uint8_t *pBuf, BindingEntry_t *pBind);
 static void MT_UtilSync(void);
@@ -282,6 +285,14 @@ uint8_t MT_UtilCommandProcessing(uint8_t *pBuf)
       MT_UtilAssocAdd(pBuf);
       break;
       
+  case MT_UTIL_NBR_MGR_CONFIG:
+    MT_UtilNbrMgrConfig(pBuf);
+    break;
+
+  case MT_UTIL_NBR_MGR_STATS:
+    MT_UtilNbrMgrStats(pBuf);
+    break;
+
   case MT_UTIL_SYNC_REQ:
     MT_UtilSync();
     break;
@@ -1438,6 +1449,56 @@ static void MT_UtilAssocAdd(uint8_t * pBuf)
         MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_UTIL), cmdId, 1, &retValue);
     }
 
+/***************************************************************************************************
+ * @fn      MT_UtilNbrMgrConfig
+ *
+ * @brief   Set the number of neighbors kept and the replacement hysteresis.
+ *
+ * @param   pBuf - pointer to the received buffer, | limit | hysteresis |
+ *
+ * @return  void
+ ***************************************************************************************************/
+static void MT_UtilNbrMgrConfig(uint8_t *pBuf)
+{
+  uint8_t cmdId = pBuf[MT_RPC_POS_CMD1];
+  uint8_t retValue;
+
+  pBuf += MT_RPC_FRAME_HDR_SZ;
+  retValue = NwkNbrMgr_Config(pBuf[0], pBuf[1]);
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_UTIL), cmdId, 1, &retValue);
+}
+
+/***************************************************************************************************
+ * @fn      MT_UtilNbrMgrStats
+ *
+ * @brief   Get the neighbor table counters.
+ *
+ * @param   pBuf - pointer to the received buffer, | clear |
+ *
+ * @return  void
+ ***************************************************************************************************/
+static void MT_UtilNbrMgrStats(uint8_t *pBuf)
+{
+  uint8_t cmdId = pBuf[MT_RPC_POS_CMD1];
+  uint8_t buf[9];
+  nwkNbrMgrStats_t stats;
+
+  NwkNbrMgr_GetStats(&stats, pBuf[MT_RPC_FRAME_HDR_SZ]);
+
+  buf[0] = stats.used;
+  buf[1] = stats.limit;
+  buf[2] = stats.nextHops;
+  buf[3] = LO_UINT16(stats.passes);
+  buf[4] = HI_UINT16(stats.passes);
+  buf[5] = LO_UINT16(stats.evicted);
+  buf[6] = HI_UINT16(stats.evicted);
+  buf[7] = LO_UINT16(stats.rejected);
+  buf[8] = HI_UINT16(stats.rejected);
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP | (uint8_t)MT_RPC_SYS_UTIL), cmdId, sizeof(buf), buf);
+}
+
 /***************************************************************************************************
  * @fn      MT_UtilAssocFindDevice
  *
@@ -52,6 +52,8 @@
 #include "zd_profile.h"
 #include "zd_object.h"
 #include "zd_app.h"
+#include "zd_nwk_mgr.h"
+#include "nwk_childage.h"
 #include "aps_groups.h"
 #include "bdb_interface.h"
 
@@ -92,6 +94,21 @@
 #define MT_ZDO_EXT_RX_IDLE_RX_ON_CONFIG 2
 #define MT_ZDO_EXT_RX_IDLE_SLEEPY_CONFIG 3
 
+// Number of MT buffers kept for ZDO indications, see MT_ZdoCbReserve().  Each is allocated
+// at MT_RPC_DATA_MAX on first use and never freed, about 1 KB of heap held for good at 4.
+#if !defined ( MT_ZDO_CB_RING_SIZE )
+  #define MT_ZDO_CB_RING_SIZE  4
+#endif
+
+// Bounded writer for a ZDO indication serialized in its MT buffer
+typedef struct
+{
+  uint8_t *pData;   // data field of the MT buffer
+  uint8_t len;      // reserved data length
+  uint8_t pos;      // bytes written
+  uint8_t status;   // ZSuccess or ZBufferFull
+} mtZdoCbWriter_t;
+
 #if defined ( MT_ZDO_EXTENSIONS )
 typedef struct
 {
@@ -107,11 +124,21 @@ typedef struct
 uint32_t _zdoCallbackSub;
 uint8_t *pBeaconIndBuf = NULL;
 
+// ZDO indications lost because no MT buffer was available or the writer overflowed
+uint16_t MT_ZdoCbDropCnt = 0;
+
+// Forwarding of the leaves of other devices, MT_ZDO_LEAVE_IND_*
+uint8_t MT_ZdoLeaveIndMode = MT_ZDO_LEAVE_IND_PER_DEVICE;
+
 /**************************************************************************************************
  * LOCAL VARIABLES
  **************************************************************************************************/
 bool ignoreIndication = FALSE;
 
+// Data fields of the MT buffers reused for ZDO indications.  MT ZDO holds a reference on each
+// of them, so the transport releasing a buffer after sending it returns it to the ring.
+static uint8_t *mtZdoCbRing[MT_ZDO_CB_RING_SIZE];
+
 /**************************************************************************************************
  * LOCAL FUNCTIONS
  **************************************************************************************************/
@@ -157,8 +184,19 @@ static void MT_ZdoNwkAddrOfInterestReq( uint8_t *pBuf );
 static void MT_ZdoStartupFromApp(uint8_t *pBuf);
 static void MT_ZdoRegisterForZDOMsg(uint8_t *pBuf);
 static void MT_ZdoRemoveRegisteredCB(uint8_t *pBuf);
+static void MT_ZdoLeaveIndModeSet(uint8_t *pBuf);
+static void MT_ZdoChanMigrateStatus(uint8_t *pBuf);
+static void MT_ZdoChanMigrateEnable(uint8_t *pBuf);
+static void MT_ZdoChildAgingStats(uint8_t *pBuf);
+static void MT_ZdoCbStats(uint8_t *pBuf);
 #endif /* MT_ZDO_FUNC */
 
+static uint8_t MT_ZdoCbReserve( mtZdoCbWriter_t *pW, uint8_t cmdId, uint8_t len );
+static void MT_ZdoCbPutUint8( mtZdoCbWriter_t *pW, uint8_t val );
+static void MT_ZdoCbPutUint16( mtZdoCbWriter_t *pW, uint16_t val );
+static void MT_ZdoCbPutBuf( mtZdoCbWriter_t *pW, const uint8_t *pBuf, uint8_t len );
+static void MT_ZdoCbCommit( mtZdoCbWriter_t *pW );
+
 #if defined (MT_ZDO_CB_FUNC)
 static uint8_t MT_ZdoHandleExceptions( afIncomingMSGPacket_t *pData, zdoIncomingMsg_t *inMsg );
 void MT_ZdoAddrRspCB( ZDO_NwkIEEEAddrResp_t *pMsg, uint16_t clusterID );
@@ -167,6 +205,10 @@ void MT_ZdoBindUnbindRspCB( uint16_t clusterID, uint16_t srcAddr, uint8_t status
 void* MT_ZdoSrcRtgCB( void *pStr );
 static void *MT_ZdoConcentratorIndCB(void *pStr);
 static void *MT_ZdoLeaveInd(void *vPtr);
+static void *MT_ZdoLeaveBatchInd(void *vPtr);
+static void *MT_ZdoChanMigrateInd(void *vPtr);
+static void MT_ZdoLeaveIndSend( uint16_t srcAddr, uint8_t *extAddr, uint8_t request,
+                                uint8_t removeChildren, uint8_t rejoin );
 void *MT_ZdoTcDeviceInd( void *params );
 void *MT_ZdoPermitJoinInd( void *duration );
 #endif /* MT_ZDO_CB_FUNC */
@@ -211,6 +253,8 @@ void MT_ZdoInit(void)
   ZDO_RegisterForZdoCB(ZDO_SRC_RTG_IND_CBID, &MT_ZdoSrcRtgCB);
   ZDO_RegisterForZdoCB(ZDO_CONCENTRATOR_IND_CBID, &MT_ZdoConcentratorIndCB);
   ZDO_RegisterForZdoCB(ZDO_LEAVE_IND_CBID, &MT_ZdoLeaveInd);
+  ZDO_RegisterForZdoCB(ZDO_LEAVE_BATCH_IND_CBID, &MT_ZdoLeaveBatchInd);
+  ZDO_RegisterForZdoCB(ZDO_CHAN_MIGRATE_CBID, &MT_ZdoChanMigrateInd);
   ZDO_RegisterForZdoCB(ZDO_PERMIT_JOIN_CBID, &MT_ZdoPermitJoinInd);
   ZDO_RegisterForZdoCB(ZDO_TC_DEVICE_CBID, &MT_ZdoTcDeviceInd);
 #endif
@@ -420,6 +464,26 @@ uint8_t MT_ZdoCommandProcessing(uint8_t* pBuf)
       MT_ZdoRemoveRegisteredCB(pBuf);
       break;
 
+    case MT_ZDO_LEAVE_IND_MODE_SET:
+      MT_ZdoLeaveIndModeSet(pBuf);
+      break;
+
+    case MT_ZDO_CHAN_MIGRATE_STATUS:
+      MT_ZdoChanMigrateStatus(pBuf);
+      break;
+
+    case MT_ZDO_CHAN_MIGRATE_ENABLE:
+      MT_ZdoChanMigrateEnable(pBuf);
+      break;
+
+    case MT_ZDO_CHILD_AGING_STATS:
+      MT_ZdoChildAgingStats(pBuf);
+      break;
+
+    case MT_ZDO_CB_STATS:
+      MT_ZdoCbStats(pBuf);
+      break;
+
 #if defined ( MT_ZDO_EXTENSIONS )
 #if ( ZG_BUILD_COORDINATOR_TYPE )
     case MT_ZDO_EXT_UPDATE_NWK_KEY:
@@ -2137,9 +2201,325 @@ void MT_ZdoRemoveRegisteredCB(uint8_t *pBuf)
   }
 }
 
+/*************************************************************************************************
+ * @fn      MT_ZdoLeaveIndModeSet
+ *
+ * @brief   Select how the leaves of other devices are forwarded: one MT_ZDO_LEAVE_IND per
+ *          device or one MT_ZDO_LEAVE_BATCH_IND per batch of leaves held by ZDApp.
+ *
+ * @param   pBuf  - MT message data
+ *
+ * @return  void
+ *************************************************************************************************/
+static void MT_ZdoLeaveIndModeSet(uint8_t *pBuf)
+{
+  uint8_t status = ZInvalidParameter;
+  uint8_t mode = pBuf[MT_RPC_POS_DAT0];
+
+  if ((mode == MT_ZDO_LEAVE_IND_PER_DEVICE) || (mode == MT_ZDO_LEAVE_IND_COALESCED))
+  {
+    MT_ZdoLeaveIndMode = mode;
+    status = ZSuccess;
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP|(uint8_t)MT_RPC_SYS_ZDO),
+                               MT_ZDO_LEAVE_IND_MODE_SET, 1, &status);
+}
+
+/*************************************************************************************************
+ * @fn      MT_ZdoChanMigrateStatus
+ *
+ * @brief   Report the progress of the last channel migration:
+ *          | status | state | channel | oldChannel | total | heard | recovered | pending |
+ *
+ * @param   pBuf  - MT message data
+ *
+ * @return  void
+ *************************************************************************************************/
+static void MT_ZdoChanMigrateStatus(uint8_t *pBuf)
+{
+  ZDNwkMgr_MigrateReport_t report;
+  uint8_t buf[12];
+  uint8_t *pOut = buf;
+
+  (void)pBuf;
+
+  ZDNwkMgr_MigrateGetReport( &report );
+
+  *pOut++ = ZSuccess;
+  *pOut++ = report.state;
+  *pOut++ = report.channel;
+  *pOut++ = report.oldChannel;
+  *pOut++ = LO_UINT16( report.total );
+  *pOut++ = HI_UINT16( report.total );
+  *pOut++ = LO_UINT16( report.heard );
+  *pOut++ = HI_UINT16( report.heard );
+  *pOut++ = LO_UINT16( report.recovered );
+  *pOut++ = HI_UINT16( report.recovered );
+  *pOut++ = LO_UINT16( report.pending );
+  *pOut++ = HI_UINT16( report.pending );
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP|(uint8_t)MT_RPC_SYS_ZDO),
+                               MT_ZDO_CHAN_MIGRATE_STATUS, sizeof( buf ), buf);
+}
+
+/*************************************************************************************************
+ * @fn      MT_ZdoChanMigrateEnable
+ *
+ * @brief   Turn the channel migration on or off: | enable |, off by default.
+ *
+ * @param   pBuf  - MT message data
+ *
+ * @return  void
+ *************************************************************************************************/
+static void MT_ZdoChanMigrateEnable(uint8_t *pBuf)
+{
+  uint8_t status = ZSuccess;
+
+  ZDNwkMgr_MigrateEnable( (pBuf[MT_RPC_POS_DAT0] != 0) ? TRUE : FALSE );
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP|(uint8_t)MT_RPC_SYS_ZDO),
+                               MT_ZDO_CHAN_MIGRATE_ENABLE, 1, &status);
+}
+
+/*************************************************************************************************
+ * @fn      MT_ZdoChildAgingStats
+ *
+ * @brief   Report the end device child aging and the children per negotiated timeout:
+ *          | status | active | children | aged | nextDue 4 | NWK_CHILD_AGE_TIMEOUTS * count 2 |
+ *
+ * @param   pBuf  - MT message data, | clear |, TRUE clears the aged count
+ *
+ * @return  void
+ *************************************************************************************************/
+static void MT_ZdoChildAgingStats(uint8_t *pBuf)
+{
+  nwkChildAgeStats_t stats;
+  uint8_t buf[10 + (NWK_CHILD_AGE_TIMEOUTS * 2)];
+  uint8_t *pOut = buf;
+  uint8_t i;
+
+  NwkChildAge_GetStats( &stats, pBuf[MT_RPC_FRAME_HDR_SZ] );
+
+  *pOut++ = ZSuccess;
+  *pOut++ = stats.active;
+  *pOut++ = LO_UINT16( stats.children );
+  *pOut++ = HI_UINT16( stats.children );
+  *pOut++ = LO_UINT16( stats.aged );
+  *pOut++ = HI_UINT16( stats.aged );
+  pOut = OsalPort_bufferUint32( pOut, stats.nextDue );
+
+  for ( i = 0; i < NWK_CHILD_AGE_TIMEOUTS; i++ )
+  {
+    *pOut++ = LO_UINT16( stats.timeouts[i] );
+    *pOut++ = HI_UINT16( stats.timeouts[i] );
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP|(uint8_t)MT_RPC_SYS_ZDO),
+                               MT_ZDO_CHILD_AGING_STATS, sizeof( buf ), buf);
+}
+
+/*************************************************************************************************
+ * @fn      MT_ZdoCbStats
+ *
+ * @brief   Report the ZDO indications dropped and the buffers of the indication ring:
+ *          | status | dropped 2 | ring size | ring buffers allocated | ring buffers busy |
+ *
+ * @param   pBuf  - MT message data, | clear |, TRUE clears the dropped count
+ *
+ * @return  void
+ *************************************************************************************************/
+static void MT_ZdoCbStats(uint8_t *pBuf)
+{
+  uint8_t buf[6];
+  uint8_t idx;
+
+  buf[0] = ZSuccess;
+  buf[1] = LO_UINT16( MT_ZdoCbDropCnt );
+  buf[2] = HI_UINT16( MT_ZdoCbDropCnt );
+  buf[3] = MT_ZDO_CB_RING_SIZE;
+  buf[4] = 0;
+  buf[5] = 0;
+
+  for ( idx = 0; idx < MT_ZDO_CB_RING_SIZE; idx++ )
+  {
+    if ( mtZdoCbRing[idx] != NULL )
+    {
+      buf[4]++;
+
+      // Still held by the transport
+      if ( (OsalPort_MSG_REF( mtZdoCbRing[idx] - MT_RSP_DATA_OFS )
+            & OsalPort_MSG_REF_CNT_MASK) > 1 )
+      {
+        buf[5]++;
+      }
+    }
+  }
+
+  if ( pBuf[MT_RPC_FRAME_HDR_SZ] )
+  {
+    MT_ZdoCbDropCnt = 0;
+  }
+
+  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_SRSP|(uint8_t)MT_RPC_SYS_ZDO),
+                               MT_ZDO_CB_STATS, sizeof( buf ), buf);
+}
+
 #endif /* MT_ZDO_FUNC */
 
 
+/***************************************************************************************************
+ * @fn      MT_ZdoCbReserve
+ *
+ * @brief   Reserve the MT AREQ buffer of a ZDO indication.  A ring buffer already released by the
+ *          transport is reused when there is one, a new transport buffer is allocated otherwise.
+ *
+ * @param   pW - writer to set up
+ *          cmdId - MT ZDO AREQ command ID
+ *          len - exact length of the indication data
+ *
+ * @return  TRUE if the writer is ready, FALSE if the indication is dropped
+ ***************************************************************************************************/
+static uint8_t MT_ZdoCbReserve( mtZdoCbWriter_t *pW, uint8_t cmdId, uint8_t len )
+{
+  uint8_t *pData = NULL;
+  uint8_t idx;
+
+  if ( len > MT_RPC_DATA_MAX )
+  {
+    MT_ZdoCbDropCnt++;
+    return ( FALSE );
+  }
+
+  for ( idx = 0; idx < MT_ZDO_CB_RING_SIZE; idx++ )
+  {
+    uint8_t *pMsg;
+
+    if ( mtZdoCbRing[idx] == NULL )
+    {
+      // Filled on first use, with buffers large enough for any indication
+      mtZdoCbRing[idx] = MT_AllocZToolResponse( 0, 0, MT_RPC_DATA_MAX );
+      if ( mtZdoCbRing[idx] == NULL )
+      {
+        break;
+      }
+    }
+
+    // Free once the reference of the ring is the only one left
+    pMsg = mtZdoCbRing[idx] - MT_RSP_DATA_OFS;
+    if ( ((OsalPort_MSG_REF( pMsg ) & OsalPort_MSG_REF_CNT_MASK) == 1)
+        && (OsalPort_msgRetain( pMsg ) == OsalPort_SUCCESS) )
+    {
+      pData = mtZdoCbRing[idx];
+      break;
+    }
+  }
+
+  if ( pData == NULL )
+  {
+    // Ring busy, the indication gets a buffer of its own
+    pData = MT_AllocZToolResponse( 0, 0, len );
+    if ( pData == NULL )
+    {
+      MT_ZdoCbDropCnt++;
+      return ( FALSE );
+    }
+  }
+
+  pData[MT_RPC_POS_LEN - MT_RPC_POS_DAT0] = len;
+  pData[MT_RPC_POS_CMD0 - MT_RPC_POS_DAT0] = (uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO;
+  pData[MT_RPC_POS_CMD1 - MT_RPC_POS_DAT0] = cmdId;
+
+  pW->pData = pData;
+  pW->len = len;
+  pW->pos = 0;
+  pW->status = ZSuccess;
+
+  return ( TRUE );
+}
+
+/***************************************************************************************************
+ * @fn      MT_ZdoCbPutUint8
+ *
+ * @brief   Write a byte of a ZDO indication.
+ *
+ * @param   pW - writer from MT_ZdoCbReserve()
+ *          val - value to write
+ *
+ * @return  none
+ ***************************************************************************************************/
+static void MT_ZdoCbPutUint8( mtZdoCbWriter_t *pW, uint8_t val )
+{
+  MT_ZdoCbPutBuf( pW, &val, 1 );
+}
+
+/***************************************************************************************************
+ * @fn      MT_ZdoCbPutUint16
+ *
+ * @brief   Write a little endian 16-bit value of a ZDO indication.
+ *
+ * @param   pW - writer from MT_ZdoCbReserve()
+ *          val - value to write
+ *
+ * @return  none
+ ***************************************************************************************************/
+static void MT_ZdoCbPutUint16( mtZdoCbWriter_t *pW, uint16_t val )
+{
+  uint8_t buf[2];
+
+  buf[0] = LO_UINT16( val );
+  buf[1] = HI_UINT16( val );
+
+  MT_ZdoCbPutBuf( pW, buf, 2 );
+}
+
+/***************************************************************************************************
+ * @fn      MT_ZdoCbPutBuf
+ *
+ * @brief   Write bytes of a ZDO indication, the writer is marked ZBufferFull instead of
+ *          writing past the reserved length.
+ *
+ * @param   pW - writer from MT_ZdoCbReserve()
+ *          pBuf - bytes to write
+ *          len - number of bytes
+ *
+ * @return  none
+ ***************************************************************************************************/
+static void MT_ZdoCbPutBuf( mtZdoCbWriter_t *pW, const uint8_t *pBuf, uint8_t len )
+{
+  if ( (pW->status != ZSuccess) || (len > (uint8_t)(pW->len - pW->pos)) )
+  {
+    pW->status = ZBufferFull;
+    return;
+  }
+
+  (void)OsalPort_memcpy( pW->pData + pW->pos, pBuf, len );
+  pW->pos += len;
+}
+
+/***************************************************************************************************
+ * @fn      MT_ZdoCbCommit
+ *
+ * @brief   Send a ZDO indication written in place.  An indication that was not written exactly
+ *          to its reserved length is dropped.
+ *
+ * @param   pW - writer from MT_ZdoCbReserve()
+ *
+ * @return  none
+ ***************************************************************************************************/
+static void MT_ZdoCbCommit( mtZdoCbWriter_t *pW )
+{
+  if ( (pW->status == ZSuccess) && (pW->pos == pW->len) )
+  {
+    MT_SendZToolResponse( pW->pData );
+  }
+  else
+  {
+    MT_ZdoCbDropCnt++;
+    OsalPort_msgDeallocate( pW->pData - MT_RSP_DATA_OFS );
+  }
+}
+
 /***************************************************************************************************
  * Callback handling function
  ***************************************************************************************************/
@@ -2157,8 +2537,13 @@ void MT_ZdoRemoveRegisteredCB(uint8_t *pBuf)
  */
 void MT_ZdoStateChangeCB(OsalPort_EventHdr *pMsg)
 {
-  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
-                                       MT_ZDO_STATE_CHANGE_IND, 1, &pMsg->status);
+  mtZdoCbWriter_t w;
+
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_STATE_CHANGE_IND, 1 ) )
+  {
+    MT_ZdoCbPutUint8( &w, pMsg->status );
+    MT_ZdoCbCommit( &w );
+  }
 }
 
 /***************************************************************************************************
@@ -2173,7 +2558,7 @@ void MT_ZdoStateChangeCB(OsalPort_EventHdr *pMsg)
  ***************************************************************************************************/
 void MT_ZdoDirectCB( afIncomingMSGPacket_t *pData, zdoIncomingMsg_t *inMsg )
 {
-  uint8_t len, *pBuf;
+  mtZdoCbWriter_t w;
   uint16_t origClusterId;
 
   // save original value because MT_ZdoHandleExceptions() function could modify pData->clusterId
@@ -2188,20 +2573,22 @@ void MT_ZdoDirectCB( afIncomingMSGPacket_t *pData, zdoIncomingMsg_t *inMsg )
   /* ZDO data starts after one-byte sequence number and the msg buffer length includes
    * two bytes for srcAddr.
    */
-  len = pData->cmd.DataLength - 1 + sizeof(uint16_t);
-
-  if (NULL != (pBuf = (uint8_t *)OsalPort_malloc(len)))
+  if ( (pData->cmd.DataLength == 0) ||
+       (pData->cmd.DataLength - 1 + sizeof(uint16_t) > MT_RPC_DATA_MAX) )
   {
-    uint8_t id = MT_ZDO_CID_TO_AREQ_ID(pData->clusterId);
+    MT_ZdoCbDropCnt++;
+    return;
+  }
 
-    pBuf[0] = LO_UINT16(pData->srcAddr.addr.shortAddr);
-    pBuf[1] = HI_UINT16(pData->srcAddr.addr.shortAddr);
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_CID_TO_AREQ_ID(pData->clusterId),
+                        (uint8_t)(pData->cmd.DataLength - 1 + sizeof(uint16_t)) ) )
+  {
+    MT_ZdoCbPutUint16( &w, pData->srcAddr.addr.shortAddr );
 
     /* copy ZDO data, skipping one-byte sequence number */
-    OsalPort_memcpy(pBuf+2, (pData->cmd.Data + 1), pData->cmd.DataLength-1);
+    MT_ZdoCbPutBuf( &w, (pData->cmd.Data + 1), (uint8_t)(pData->cmd.DataLength - 1) );
 
-    MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO), id, len, pBuf);
-    OsalPort_free(pBuf);
+    MT_ZdoCbCommit( &w );
   }
 }
 
@@ -2277,37 +2664,34 @@ static uint8_t MT_ZdoHandleExceptions( afIncomingMSGPacket_t *pData, zdoIncoming
  */
 void MT_ZdoAddrRspCB( ZDO_NwkIEEEAddrResp_t *pMsg, uint16_t clusterID )
 {
-  uint8_t   listLen, len, *pBuf;
+  uint8_t listLen, idx;
+  mtZdoCbWriter_t w;
 
   /* both ZDO_NwkAddrResp_t and ZDO_IEEEAddrResp_t must be the same */
 
   /* get length, sanity check length */
   listLen = pMsg->numAssocDevs;
-
-  /* calculate msg length */
-  len = MT_ZDO_ADDR_RSP_LEN + (listLen * sizeof(uint16_t));
-
-  /* get buffer */
-  if (NULL != (pBuf = (uint8_t *)OsalPort_malloc(len)))
+  if ( listLen > (MT_RPC_DATA_MAX - MT_ZDO_ADDR_RSP_LEN) / sizeof(uint16_t) )
   {
-    uint8_t id = MT_ZDO_CID_TO_AREQ_ID(clusterID);
-    uint8_t *pTmp = pBuf;
-
-    *pTmp++ = pMsg->status;
-
-    osal_cpyExtAddr(pTmp, pMsg->extAddr);
-    pTmp += Z_EXTADDR_LEN;
-
-    *pTmp++ = LO_UINT16(pMsg->nwkAddr);
-    *pTmp++ = HI_UINT16(pMsg->nwkAddr);
+    MT_ZdoCbDropCnt++;
+    return;
+  }
 
-    *pTmp++ = pMsg->startIndex;
-    *pTmp++ = listLen;
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_CID_TO_AREQ_ID(clusterID),
+                        MT_ZDO_ADDR_RSP_LEN + (listLen * sizeof(uint16_t)) ) )
+  {
+    MT_ZdoCbPutUint8( &w, pMsg->status );
+    MT_ZdoCbPutBuf( &w, pMsg->extAddr, Z_EXTADDR_LEN );
+    MT_ZdoCbPutUint16( &w, pMsg->nwkAddr );
+    MT_ZdoCbPutUint8( &w, pMsg->startIndex );
+    MT_ZdoCbPutUint8( &w, listLen );
 
-    MT_Word2Buf(pTmp, pMsg->devList, listLen);
+    for ( idx = 0; idx < listLen; idx++ )
+    {
+      MT_ZdoCbPutUint16( &w, pMsg->devList[idx] );
+    }
 
-    MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO), id, len, pBuf);
-    OsalPort_free(pBuf);
+    MT_ZdoCbCommit( &w );
   }
 }
 
@@ -2322,27 +2706,16 @@ void MT_ZdoAddrRspCB( ZDO_NwkIEEEAddrResp_t *pMsg, uint16_t clusterID )
  */
 void MT_ZdoEndDevAnnceCB( ZDO_DeviceAnnce_t *pMsg, uint16_t srcAddr )
 {
-  uint8_t *pBuf;
+  mtZdoCbWriter_t w;
 
-  if (NULL != (pBuf = (uint8_t *)OsalPort_malloc(MT_ZDO_END_DEVICE_ANNCE_IND_LEN)))
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_END_DEVICE_ANNCE_IND, MT_ZDO_END_DEVICE_ANNCE_IND_LEN ) )
   {
-    uint8_t *pTmp = pBuf;
-
-    *pTmp++ = LO_UINT16(srcAddr);
-    *pTmp++ = HI_UINT16(srcAddr);
-
-    *pTmp++ = LO_UINT16(pMsg->nwkAddr);
-    *pTmp++ = HI_UINT16(pMsg->nwkAddr);
+    MT_ZdoCbPutUint16( &w, srcAddr );
+    MT_ZdoCbPutUint16( &w, pMsg->nwkAddr );
+    MT_ZdoCbPutBuf( &w, pMsg->extAddr, Z_EXTADDR_LEN );
+    MT_ZdoCbPutUint8( &w, pMsg->capabilities );
 
-    osal_cpyExtAddr(pTmp, pMsg->extAddr);
-    pTmp += Z_EXTADDR_LEN;
-
-    *pTmp = pMsg->capabilities;
-
-    MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
-                                         MT_ZDO_END_DEVICE_ANNCE_IND,
-                                         MT_ZDO_END_DEVICE_ANNCE_IND_LEN, pBuf);
-    OsalPort_free(pBuf);
+    MT_ZdoCbCommit( &w );
   }
 }
 
@@ -2357,35 +2730,27 @@ void MT_ZdoEndDevAnnceCB( ZDO_DeviceAnnce_t *pMsg, uint16_t srcAddr )
  */
 void* MT_ZdoSrcRtgCB( void *pStr )
 {
-  uint8_t len, *pBuf;
+  mtZdoCbWriter_t w;
   zdoSrcRtg_t *pSrcRtg = pStr;
+  uint8_t idx, relayCnt;
 
-  // srcAddr (2) + relayCnt (1) + relayList( relaycnt * 2 )
-  len = 2 + 1 + pSrcRtg->relayCnt * sizeof(uint16_t);
+  // No relay to report without a relay list
+  relayCnt = (pSrcRtg->pRelayList != NULL) ? pSrcRtg->relayCnt : 0;
 
-  if (NULL != (pBuf = (uint8_t *)OsalPort_malloc(len)))
+  // srcAddr (2) + relayCnt (1) + relayList( relaycnt * 2 )
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_SRC_RTG_IND, 2 + 1 + relayCnt * sizeof(uint16_t) ) )
   {
-    uint8_t idx, *pTmp = pBuf;
-    uint16_t *pRelay;
-
     // Packet payload
-    *pTmp++ = LO_UINT16(pSrcRtg->srcAddr);
-    *pTmp++ = HI_UINT16(pSrcRtg->srcAddr);
-    *pTmp++ = pSrcRtg->relayCnt;
+    MT_ZdoCbPutUint16( &w, pSrcRtg->srcAddr );
+    MT_ZdoCbPutUint8( &w, relayCnt );
 
     // Relay List
-    if( ( pRelay = pSrcRtg->pRelayList ) != NULL )
+    for ( idx = 0; idx < relayCnt; idx++ )
     {
-      for( idx = 0; idx < pSrcRtg->relayCnt; idx ++ )
-      {
-        *pTmp++ = LO_UINT16(*pRelay);
-        *pTmp++ = HI_UINT16(*pRelay);
-        pRelay++;
-      }
+      MT_ZdoCbPutUint16( &w, pSrcRtg->pRelayList[idx] );
     }
-    MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
-                                         MT_ZDO_SRC_RTG_IND, len, pBuf);
-    OsalPort_free(pBuf);
+
+    MT_ZdoCbCommit( &w );
   }
 
   return NULL;
@@ -2402,16 +2767,18 @@ void* MT_ZdoSrcRtgCB( void *pStr )
  ***************************************************************************************************/
 void *MT_ZdoConcentratorIndCB(void *pStr)
 {
-  uint8_t buf[MT_ZDO_CONCENTRATOR_IND_LEN], *pTmp = buf;
+  mtZdoCbWriter_t w;
   zdoConcentratorInd_t *pInd = (zdoConcentratorInd_t *)pStr;
 
-  *pTmp++ = LO_UINT16(pInd->nwkAddr);
-  *pTmp++ = HI_UINT16(pInd->nwkAddr);
-  pTmp = OsalPort_memcpy(pTmp, pInd->extAddr, Z_EXTADDR_LEN);
-  *pTmp = pInd->pktCost;
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_CONCENTRATOR_IND_CB, MT_ZDO_CONCENTRATOR_IND_LEN ) )
+  {
+    MT_ZdoCbPutUint16( &w, pInd->nwkAddr );
+    MT_ZdoCbPutBuf( &w, pInd->extAddr, Z_EXTADDR_LEN );
+    MT_ZdoCbPutUint8( &w, pInd->pktCost );
+
+    MT_ZdoCbCommit( &w );
+  }
 
-  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
-                                    MT_ZDO_CONCENTRATOR_IND_CB, MT_ZDO_CONCENTRATOR_IND_LEN, buf);
   return NULL;
 }
 
@@ -2427,17 +2794,151 @@ void *MT_ZdoConcentratorIndCB(void *pStr)
 static void *MT_ZdoLeaveInd(void *vPtr)
 {
   NLME_LeaveInd_t *pInd = (NLME_LeaveInd_t *)vPtr;
-  uint8_t buf[sizeof(NLME_LeaveInd_t)];
 
-  buf[0] = LO_UINT16(pInd->srcAddr);
-  buf[1] = HI_UINT16(pInd->srcAddr);
-  (void)OsalPort_memcpy(buf+2, pInd->extAddr, Z_EXTADDR_LEN);
-  buf[2+Z_EXTADDR_LEN] = pInd->request;
-  buf[3+Z_EXTADDR_LEN] = pInd->removeChildren;
-  buf[4+Z_EXTADDR_LEN] = pInd->rejoin;
+  MT_ZdoLeaveIndSend( pInd->srcAddr, pInd->extAddr, pInd->request,
+                      pInd->removeChildren, pInd->rejoin );
+
+  return NULL;
+}
+
+/***************************************************************************************************
+ * @fn          MT_ZdoLeaveIndSend
+ *
+ * @brief       Send one MT_ZDO_LEAVE_IND.
+ *
+ * @param       srcAddr, extAddr, request, removeChildren, rejoin - the leave indication
+ *
+ * @return      None
+ ***************************************************************************************************/
+static void MT_ZdoLeaveIndSend( uint16_t srcAddr, uint8_t *extAddr, uint8_t request,
+                                uint8_t removeChildren, uint8_t rejoin )
+{
+  mtZdoCbWriter_t w;
+
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_LEAVE_IND, 5+Z_EXTADDR_LEN ) )
+  {
+    MT_ZdoCbPutUint16( &w, srcAddr );
+    MT_ZdoCbPutBuf( &w, extAddr, Z_EXTADDR_LEN );
+    MT_ZdoCbPutUint8( &w, request );
+    MT_ZdoCbPutUint8( &w, removeChildren );
+    MT_ZdoCbPutUint8( &w, rejoin );
+
+    MT_ZdoCbCommit( &w );
+  }
+}
+
+/***************************************************************************************************
+ * @fn          MT_ZdoLeaveBatchInd
+ *
+ * @brief       Handle the batch of leaves of other devices from ZDApp.  In per device mode
+ *              the NLME leave indications are sent one by one as before and the aged out
+ *              children in MT_ZDO_LEAVE_BATCH_IND, in coalesced mode the whole
+ *              batch is sent in as few MT_ZDO_LEAVE_BATCH_IND as fit:
+ *              | count | count * (nwkAddr 2 | extAddr 8 | reason | request | removeChildren |
+ *              rejoin) |
+ *
+ * @param       vPtr - Pointer to the zdoLeaveBatch_t.
+ *
+ * @return      NULL
+ ***************************************************************************************************/
+static void *MT_ZdoLeaveBatchInd(void *vPtr)
+{
+  zdoLeaveBatch_t *pBatch = (zdoLeaveBatch_t *)vPtr;
+  zdoLeaveRec_t *pRec = pBatch->pRecs;
+  uint8_t left = pBatch->count;
+  mtZdoCbWriter_t w;
+  uint8_t cnt;
+
+  if ( MT_ZdoLeaveIndMode == MT_ZDO_LEAVE_IND_PER_DEVICE )
+  {
+    left = 0;
+    for ( cnt = 0; cnt < pBatch->count; cnt++, pRec++ )
+    {
+      // Only NLME leave indications were ever sent one by one, leaves
+      // this device asked for were never indicated
+      if ( pRec->reason == ZDO_LEAVE_REASON_IND )
+      {
+        MT_ZdoLeaveIndSend( pRec->nwkAddr, pRec->extAddr, pRec->request,
+                            pRec->removeChildren, pRec->rejoin );
+      }
+      else if ( pRec->reason == ZDO_LEAVE_REASON_AGED )
+      {
+        left++;
+      }
+    }
+
+    // Aged out children only go in MT_ZDO_LEAVE_BATCH_IND
+    pRec = pBatch->pRecs;
+  }
+
+  while ( left > 0 )
+  {
+    cnt = left;
+    if ( cnt > ((MT_RPC_DATA_MAX - 1) / (6 + Z_EXTADDR_LEN)) )
+    {
+      cnt = (MT_RPC_DATA_MAX - 1) / (6 + Z_EXTADDR_LEN);
+    }
+
+    if ( MT_ZdoCbReserve( &w, MT_ZDO_LEAVE_BATCH_IND, 1 + (cnt * (6 + Z_EXTADDR_LEN)) ) == FALSE )
+    {
+      break;
+    }
+
+    MT_ZdoCbPutUint8( &w, cnt );
+    left -= cnt;
+
+    for ( ; cnt > 0; pRec++ )
+    {
+      if ( (MT_ZdoLeaveIndMode == MT_ZDO_LEAVE_IND_PER_DEVICE) &&
+           (pRec->reason != ZDO_LEAVE_REASON_AGED) )
+      {
+        continue;
+      }
+
+      cnt--;
+      MT_ZdoCbPutUint16( &w, pRec->nwkAddr );
+      MT_ZdoCbPutBuf( &w, pRec->extAddr, Z_EXTADDR_LEN );
+      MT_ZdoCbPutUint8( &w, pRec->reason );
+      MT_ZdoCbPutUint8( &w, pRec->request );
+      MT_ZdoCbPutUint8( &w, pRec->removeChildren );
+      MT_ZdoCbPutUint8( &w, pRec->rejoin );
+    }
+
+    MT_ZdoCbCommit( &w );
+  }
+
+  return NULL;
+}
+
+/***************************************************************************************************
+ * @fn          MT_ZdoChanMigrateInd
+ *
+ * @brief       Handle the channel migration progress callback from the network manager, sent
+ *              after every old channel window and when the migration is done:
+ *              | state | channel | oldChannel | total | heard | recovered | pending |
+ *
+ * @param       vPtr - Pointer to the ZDNwkMgr_MigrateReport_t.
+ *
+ * @return      NULL
+ ***************************************************************************************************/
+static void *MT_ZdoChanMigrateInd(void *vPtr)
+{
+  ZDNwkMgr_MigrateReport_t *pReport = (ZDNwkMgr_MigrateReport_t *)vPtr;
+  mtZdoCbWriter_t w;
+
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_CHAN_MIGRATE_IND, 11 ) )
+  {
+    MT_ZdoCbPutUint8( &w, pReport->state );
+    MT_ZdoCbPutUint8( &w, pReport->channel );
+    MT_ZdoCbPutUint8( &w, pReport->oldChannel );
+    MT_ZdoCbPutUint16( &w, pReport->total );
+    MT_ZdoCbPutUint16( &w, pReport->heard );
+    MT_ZdoCbPutUint16( &w, pReport->recovered );
+    MT_ZdoCbPutUint16( &w, pReport->pending );
+
+    MT_ZdoCbCommit( &w );
+  }
 
-  MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
-                                       MT_ZDO_LEAVE_IND, 5+Z_EXTADDR_LEN, buf);
   return NULL;
 }
 
@@ -2453,16 +2954,16 @@ static void *MT_ZdoLeaveInd(void *vPtr)
 void *MT_ZdoTcDeviceInd( void *params )
 {
   ZDO_TC_Device_t *pDev = (ZDO_TC_Device_t *)params;
-  uint8_t buf[12];
+  mtZdoCbWriter_t w;
 
-  buf[0] = LO_UINT16( pDev->nwkAddr );
-  buf[1] = HI_UINT16( pDev->nwkAddr );
-  (void)OsalPort_memcpy( &buf[2], pDev->extAddr, Z_EXTADDR_LEN);
-  buf[2+Z_EXTADDR_LEN] = LO_UINT16( pDev->parentAddr );
-  buf[3+Z_EXTADDR_LEN] = HI_UINT16( pDev->parentAddr );
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_TC_DEVICE_IND, 12 ) )
+  {
+    MT_ZdoCbPutUint16( &w, pDev->nwkAddr );
+    MT_ZdoCbPutBuf( &w, pDev->extAddr, Z_EXTADDR_LEN );
+    MT_ZdoCbPutUint16( &w, pDev->parentAddr );
 
-  MT_BuildAndSendZToolResponse( ((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
-                                       MT_ZDO_TC_DEVICE_IND, 12, buf );
+    MT_ZdoCbCommit( &w );
+  }
 
   return ( NULL );
 }
@@ -2485,8 +2986,13 @@ void *MT_ZdoPermitJoinInd( void *duration )
     // callback decide how to act.
     if ((( *(uint8_t*)duration == 0x00 ) && ( NLME_PermitJoining )) || (( *(uint8_t*)duration != 0x00 ) && ( ! NLME_PermitJoining )))
     {
-      MT_BuildAndSendZToolResponse( ((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
-                                       MT_ZDO_PERMIT_JOIN_IND, 1, (uint8_t *)duration );
+      mtZdoCbWriter_t w;
+
+      if ( MT_ZdoCbReserve( &w, MT_ZDO_PERMIT_JOIN_IND, 1 ) )
+      {
+        MT_ZdoCbPutUint8( &w, *(uint8_t *)duration );
+        MT_ZdoCbCommit( &w );
+      }
     }
   }
 
@@ -2505,30 +3011,27 @@ void *MT_ZdoPermitJoinInd( void *duration )
  */
 void MT_ZdoSendMsgCB(zdoIncomingMsg_t *pMsg)
 {
-  uint8_t len = pMsg->asduLen + 9;
-  uint8_t *pBuf = (uint8_t *)OsalPort_malloc(len);
+  mtZdoCbWriter_t w;
 
-  if (pBuf != NULL)
+  if ( pMsg->asduLen > MT_RPC_DATA_MAX - 9 )
   {
-    uint8_t *pTmp = pBuf;
+    MT_ZdoCbDropCnt++;
+    return;
+  }
 
+  if ( MT_ZdoCbReserve( &w, MT_ZDO_MSG_CB_INCOMING, pMsg->asduLen + 9 ) )
+  {
     // Assuming exclusive use of network short addresses.
-    *pTmp++ = LO_UINT16(pMsg->srcAddr.addr.shortAddr);
-    *pTmp++ = HI_UINT16(pMsg->srcAddr.addr.shortAddr);
-    *pTmp++ = pMsg->wasBroadcast;
-    *pTmp++ = LO_UINT16(pMsg->clusterID);
-    *pTmp++ = HI_UINT16(pMsg->clusterID);
-    *pTmp++ = pMsg->SecurityUse;
-    *pTmp++ = pMsg->TransSeq;
+    MT_ZdoCbPutUint16( &w, pMsg->srcAddr.addr.shortAddr );
+    MT_ZdoCbPutUint8( &w, pMsg->wasBroadcast );
+    MT_ZdoCbPutUint16( &w, pMsg->clusterID );
+    MT_ZdoCbPutUint8( &w, pMsg->SecurityUse );
+    MT_ZdoCbPutUint8( &w, pMsg->TransSeq );
     // Skipping asduLen since it can be deduced from the RPC packet length.
-    *pTmp++ = LO_UINT16(pMsg->macDestAddr);
-    *pTmp++ = HI_UINT16(pMsg->macDestAddr);
-    (void)OsalPort_memcpy(pTmp, pMsg->asdu, pMsg->asduLen);
-
-    MT_BuildAndSendZToolResponse(((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
-                                         MT_ZDO_MSG_CB_INCOMING, len, pBuf);
+    MT_ZdoCbPutUint16( &w, pMsg->macDestAddr );
+    MT_ZdoCbPutBuf( &w, pMsg->asdu, pMsg->asduLen );
 
-    OsalPort_free(pBuf);
+    MT_ZdoCbCommit( &w );
   }
 }
 
@@ -53,6 +53,15 @@
  * GLOBAL VARIABLES
  ***************************************************************************************************/
 extern uint32_t _zdoCallbackSub;
+extern uint16_t MT_ZdoCbDropCnt;
+extern uint8_t MT_ZdoLeaveIndMode;
+
+/***************************************************************************************************
+ * CONSTANTS
+ ***************************************************************************************************/
+/* Forwarding of the leaves of other devices (MT_ZDO_LEAVE_IND_MODE_SET) */
+#define MT_ZDO_LEAVE_IND_PER_DEVICE     0x00  // One MT_ZDO_LEAVE_IND per leaving device
+#define MT_ZDO_LEAVE_IND_COALESCED      0x01  // MT_ZDO_LEAVE_BATCH_IND per batch of leaves
 
 /***************************************************************************************************
  * MACROS
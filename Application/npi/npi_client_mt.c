@@ -51,6 +51,9 @@
 #include "rom_jt_154.h"
 #include "npi_client.h"
 #include "npi_data.h"
+#include "npi_frame.h"
+#include "npi_task.h"
+#include "npi_config.h"
 #include <stdint.h>
 #include <string.h>
 #include "mt_rpc.h"
@@ -73,6 +76,69 @@ static uint8_t npiTaskID;
 // function prototypes
 // ****************************************************************************
 
+// ----------------------------------------------------------------------------
+//! \brief      Overload the MT function to allocate a ZTool Response.  The
+//!             message is built in an NPI frame buffer, so the NPI task can
+//!             send it without copying it again.
+//!
+//! \param[in]  cmdType -  MT Command field
+//! \param[in]  cmdId - MT Command ID
+//! \param[in]  datalen - lenght MT command
+//!
+//! \return     pointer to the data field of the message, NULL if out of
+//!             memory
+// ----------------------------------------------------------------------------
+uint8_t *MT_AllocZToolResponse(uint8_t cmdType, uint8_t cmdId, uint8_t dataLen)
+{
+    uint8_t *pRspMsg = NPIFrame_allocFrame(dataLen + MTRPC_FRAME_HDR_SZ);
+
+    if(pRspMsg == NULL)
+    {
+        return(NULL);
+    }
+
+    // populuate the MT header fields.
+    pRspMsg += NPIFRAME_HDR_SZ;
+    pRspMsg[MTRPC_POS_LEN] = dataLen;
+    pRspMsg[MTRPC_POS_CMD0] = cmdType;
+    pRspMsg[MTRPC_POS_CMD1] = cmdId;
+
+    return(pRspMsg + MTRPC_FRAME_HDR_SZ);
+}
+
+// ----------------------------------------------------------------------------
+//! \brief      Overload the MT function to send a ZTool Response allocated
+//!             by MT_AllocZToolResponse() to the NPI task.
+//!
+//! \param[in]  pData - data field returned by MT_AllocZToolResponse()
+//!
+//! \return     void
+// ----------------------------------------------------------------------------
+void MT_SendZToolResponse(uint8_t *pData)
+{
+    OsalPort_msgSend(npiTaskID, pData - MTRPC_FRAME_HDR_SZ - NPIFRAME_HDR_SZ);
+}
+
+// ----------------------------------------------------------------------------
+//! \brief      Overload the MT function checking for a transport backlog.
+//!             Messages sent now wait behind the ones already in the NPI
+//!             task's TX queue, and behind those MT_SendZToolResponse()
+//!             posted to the NPI task that it hasn't taken yet.
+//!
+//! \return     TRUE if both queues hold NPI_TX_QUEUE_MAX messages or more
+// ----------------------------------------------------------------------------
+uint8_t MT_TxQueueFull(void)
+{
+    uint16_t depth = NPITask_getTxQueueDepth();
+
+    if(depth < NPI_TX_QUEUE_MAX)
+    {
+        depth += OsalPort_msgCount(npiTaskID, NPI_TX_QUEUE_MAX - depth);
+    }
+
+    return (depth >= NPI_TX_QUEUE_MAX) ? TRUE : FALSE;
+}
+
 // ----------------------------------------------------------------------------
 //! \brief      Overload the MT function to Build and Send ZTool Response.
 //!             This function relays outgoing MT messages to the NPI task for
@@ -88,23 +154,17 @@ static uint8_t npiTaskID;
 void MT_BuildAndSendZToolResponse(uint8_t cmdType, uint8_t cmdId,
                                   uint8_t dataLen, uint8_t *pData)
 {
-    // allocate a message buffer to send message to NPI task.
-    uint8_t *pRspMsg = OsalPort_msgAllocate( dataLen + MTRPC_FRAME_HDR_SZ);
+    uint8_t *pRspData = MT_AllocZToolResponse(cmdType, cmdId, dataLen);
 
-    if(pRspMsg != NULL)
+    if(pRspData != NULL)
     {
-        // populuate the MT header fields.
-        pRspMsg[MTRPC_POS_LEN] = dataLen;
-        pRspMsg[MTRPC_POS_CMD0] = cmdType;
-        pRspMsg[MTRPC_POS_CMD1] = cmdId;
-
         if(dataLen > 0)
         {
-            memcpy(pRspMsg + MTRPC_FRAME_HDR_SZ, pData, dataLen);
+            memcpy(pRspData, pData, dataLen);
         }
 
         // Send the message
-        OsalPort_msgSend(npiTaskID, pRspMsg);
+        MT_SendZToolResponse(pRspData);
     }
 
     return;
@@ -102,6 +102,12 @@ extern "C"
 #define NPI_TL_BUF_SIZE         270
 #endif
 
+// ASYNC TX Queue depth at which producers with a fallback (e.g. the
+// synchronous AF incoming path) stop adding to it
+#ifndef NPI_TX_QUEUE_MAX
+#define NPI_TX_QUEUE_MAX        16
+#endif
+
 #define NPI_SPI_PAYLOAD_SIZE    255
 #define NPI_SPI_HDR_LEN         4
 
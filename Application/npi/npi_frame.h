@@ -62,6 +62,11 @@ extern "C"
 // defines
 // ****************************************************************************
 
+//! \brief Framing bytes in front of and behind a message in a buffer from
+//!        NPIFrame_allocFrame()
+#define NPIFRAME_HDR_SZ         1
+#define NPIFRAME_TRAILER_SZ     1
+
 // ****************************************************************************
 // typedefs
 // ****************************************************************************
@@ -93,6 +98,17 @@ typedef void (*npiIncomingFrameCBack_t)( uint8_t frameSize, uint8_t *pFrame,
 extern void NPIFrame_initialize(npiIncomingFrameCBack_t incomingFrameCB);
 
 
+// ----------------------------------------------------------------------------
+//! \brief      Allocate a buffer with room for the transport framing around
+//!             a message, so NPIFrame_frameMsg() can frame it in place.  The
+//!             message is written at offset NPIFRAME_HDR_SZ.
+//!
+//! \param[in]  msgLen    Length of the message.
+//!
+//! \return     Pointer to the frame buffer, NULL if out of memory
+// ----------------------------------------------------------------------------
+extern uint8_t *NPIFrame_allocFrame(uint16_t msgLen);
+
 // ----------------------------------------------------------------------------
 //! \brief      Bundles message into Transport Layer frame and NPIMSG_msg_t
 //!             container.  A transport layer specific version of this function
@@ -104,6 +120,18 @@ extern void NPIFrame_initialize(npiIncomingFrameCBack_t incomingFrameCB);
 // ----------------------------------------------------------------------------
 extern NPIMSG_msg_t * NPIFrame_frameMsg(uint8_t *pIncomingMsg);
 
+// ----------------------------------------------------------------------------
+//! \brief      Strips the transport framing NPIFrame_allocFrame() reserved
+//!             around a message.  Any other buffer is returned as is.
+//!
+//! \param[in]  pBuf     Pointer to message buffer.
+//! \param[in]  keep     TRUE to return the message inside a framed buffer,
+//!                      FALSE to move it to the start of the buffer.
+//!
+//! \return     Pointer to the unframed message
+// ----------------------------------------------------------------------------
+extern uint8_t *NPIFrame_unframeMsg(uint8_t *pBuf, uint8_t keep);
+
 // ----------------------------------------------------------------------------
 //! \brief      Collects serial message buffer.  Called based on events 
 //!             received from the transport layer.  When an entire message has 
@@ -103,6 +103,15 @@ static uint8_t tempDataLen;
  *---------------------------------------------------------------------------*/
 uint8_t npiframe_calcMTFCS(uint8_t *msg_ptr, uint8_t len);
 
+/*!----------------------------------------------------------------------------
+ * \brief  Tells a buffer from NPIFrame_allocFrame() from an unframed message.
+ *
+ * \param  pBuf      OSAL message buffer.
+ *
+ * \return     uint8_t   TRUE if the message in it is framed.
+ *---------------------------------------------------------------------------*/
+static uint8_t npiframe_isFramed(uint8_t *pBuf);
+
 /******************************************************************************
  Public Functions
  *****************************************************************************/
@@ -120,6 +129,32 @@ void NPIFrame_initialize(npiIncomingFrameCBack_t incomingFrameCB)
     incomingFrameCBFunc = incomingFrameCB;
 }
 
+// ----------------------------------------------------------------------------
+//! \brief      Allocate a buffer with room for the MT SOF in front of and
+//!             the FCS behind a message of msgLen bytes.  The message is
+//!             written at NPIFRAME_HDR_SZ and the buffer is then passed to
+//!             NPIFrame_frameMsg(), which frames it without a copy.
+//!
+//! \param  msgLen     Length of the MT message, header included.
+//!
+//! \return     Pointer to the frame buffer, NULL if out of memory
+// ----------------------------------------------------------------------------
+uint8_t *NPIFrame_allocFrame(uint16_t msgLen)
+{
+    uint8_t *pFrame;
+
+    pFrame = (uint8_t *)OsalPort_msgAllocate(NPIFRAME_HDR_SZ + msgLen +
+                                             NPIFRAME_TRAILER_SZ);
+    if(pFrame != NULL)
+    {
+        // mark the start of frame.  The OSAL message length, exactly the
+        // frame, is what tells the buffer from an unframed message.
+        pFrame[0] = MT_SOF;
+    }
+
+    return(pFrame);
+}
+
 // ----------------------------------------------------------------------------
 //! \brief      Bundles message into Transport Layer frame and NPIMSG_msg_t
 //!             container.  This is the MT specific version of this function.
@@ -128,9 +163,10 @@ void NPIFrame_initialize(npiIncomingFrameCBack_t incomingFrameCB)
 //!             bytes.  It then bundles the message in an NPIMSG_msg_t
 //!             container.
 //!
-//!             Note: becauase the SOF and FCS are added, the passed in buffer
-//!             is copied to a new buffer and then the passed in buffer is
-//!             free'd.
+//!             Note: a buffer from NPIFrame_allocFrame() already has room
+//!             for the SOF and FCS and is framed in place.  Any other
+//!             buffer is copied to a new buffer and then the passed in
+//!             buffer is free'd.
 //!
 //! \param  pIncomingMsg     Pointer to message buffer.
 //!
@@ -139,31 +175,47 @@ void NPIFrame_initialize(npiIncomingFrameCBack_t incomingFrameCB)
 NPIMSG_msg_t *NPIFrame_frameMsg(uint8_t *pIncomingMsg)
 {
     uint8_t *payload;
+    uint8_t framed = npiframe_isFramed(pIncomingMsg);
 
     NPIMSG_msg_t *npiMsg = (NPIMSG_msg_t *)OsalPort_malloc(sizeof(NPIMSG_msg_t));
 
     if(npiMsg != NULL)
     {
-        // extract the message length from the MT header bytes.
-        uint8_t inMsgLen = pIncomingMsg[MTRPC_POS_LEN] + MTRPC_FRAME_HDR_SZ;
+        uint8_t inMsgLen;
+
+        if(framed)
+        {
+            // the message already sits between the SOF and the FCS.
+            npiMsg->pBuf = pIncomingMsg;
+            payload = pIncomingMsg + NPIFRAME_HDR_SZ;
+        }
+        else
+        {
+            // allocate a new buffer that is the incoming buffer length + 2
+            // additional bytes for the SOF and FCS bytes.
+            npiMsg->pBuf = NPIFrame_allocFrame(pIncomingMsg[MTRPC_POS_LEN] +
+                                               MTRPC_FRAME_HDR_SZ);
+            payload = npiMsg->pBuf + NPIFRAME_HDR_SZ;
+        }
 
-        // allocate a new buffer that is the incoming buffer length + 2
-        // additional bytes for the SOF and FCS bytes.
-        if((npiMsg->pBuf = (uint8_t *)OsalPort_msgAllocate(inMsgLen + 2)) != NULL)
+        if(npiMsg->pBuf != NULL)
         {
-            // mark the start of frame.
-            npiMsg->pBuf[0] = MT_SOF;
-            payload = npiMsg->pBuf + 1;
+            if(!framed)
+            {
+                // copy the incoming buffer into the newly created buffer
+                memcpy(payload, pIncomingMsg, pIncomingMsg[MTRPC_POS_LEN] +
+                                              MTRPC_FRAME_HDR_SZ);
+            }
 
-            // copy the incoming buffer into the newly created buffer
-            memcpy(payload, pIncomingMsg, inMsgLen);
+            // extract the message length from the MT header bytes.
+            inMsgLen = payload[MTRPC_POS_LEN] + MTRPC_FRAME_HDR_SZ;
 
             // calculate and capture the FCS in the final byte.
-            npiMsg->pBuf[inMsgLen + 1] = npiframe_calcMTFCS(npiMsg->pBuf + 1,
+            npiMsg->pBuf[inMsgLen + 1] = npiframe_calcMTFCS(payload,
                                                             inMsgLen);
 #if defined(NPI_SREQRSP)
             // document message type (SYNC or ASYNC) in the NPI container.
-            if((pIncomingMsg[MTRPC_POS_CMD0] & MTRPC_CMD_TYPE_MASK) == MTRPC_CMD_SRSP)
+            if((payload[MTRPC_POS_CMD0] & MTRPC_CMD_TYPE_MASK) == MTRPC_CMD_SRSP)
             {
                 npiMsg->msgType = NPIMSG_Type_SYNCRSP;
             }
@@ -175,7 +227,7 @@ NPIMSG_msg_t *NPIFrame_frameMsg(uint8_t *pIncomingMsg)
             npiMsg->msgType = NPIMSG_Type_ASYNC;
 #endif
             // capture the included buffer size in the NPI container.
-            npiMsg->pBufSize = inMsgLen + 2;
+            npiMsg->pBufSize = inMsgLen + NPIFRAME_HDR_SZ + NPIFRAME_TRAILER_SZ;
         }
         else
         {
@@ -185,12 +237,47 @@ NPIMSG_msg_t *NPIFrame_frameMsg(uint8_t *pIncomingMsg)
         }
     }
 
-    /* No matter what happened, give back incoming buffer */
-    OsalPort_msgDeallocate(pIncomingMsg);
+    /* No matter what happened, give back incoming buffer unless it is
+     * now carried by the NPI container */
+    if((npiMsg == NULL) || (npiMsg->pBuf != pIncomingMsg))
+    {
+        OsalPort_msgDeallocate(pIncomingMsg);
+    }
 
     return(npiMsg);
 }
 
+// ----------------------------------------------------------------------------
+//! \brief      Strips the framing NPIFrame_allocFrame() reserved around a
+//!             message, for the NPI TX callbacks.  Any other buffer holds an
+//!             unframed message already and is returned as is.
+//!
+//! \param  pBuf     OSAL message buffer.
+//! \param  keep     TRUE to leave a framed buffer as it is and return the
+//!                  message inside it, FALSE to move the message to the start
+//!                  of the buffer, which is then an unframed OSAL message.
+//!
+//! \return     Pointer to the unframed message
+// ----------------------------------------------------------------------------
+uint8_t *NPIFrame_unframeMsg(uint8_t *pBuf, uint8_t keep)
+{
+    if(!npiframe_isFramed(pBuf))
+    {
+        return(pBuf);
+    }
+
+    if(keep)
+    {
+        return(pBuf + NPIFRAME_HDR_SZ);
+    }
+
+    // the SOF is dropped, the FCS byte left behind is unused
+    memmove(pBuf, pBuf + NPIFRAME_HDR_SZ,
+            pBuf[NPIFRAME_HDR_SZ + MTRPC_POS_LEN] + MTRPC_FRAME_HDR_SZ);
+
+    return(pBuf);
+}
+
 // ----------------------------------------------------------------------------
 //! \brief      Collects MT message buffer.  Used during serial data receipt.
 //!
@@ -334,6 +421,24 @@ void NPIFrame_collectFrameData(void)
 /******************************************************************************
  Local Functions
  *****************************************************************************/
+// ----------------------------------------------------------------------------
+//! \brief      Tell a buffer from NPIFrame_allocFrame() from an unframed
+//!             message.  The frame buffer starts with MT_SOF, which an
+//!             unframed MT message cannot (its length is at most
+//!             MT_RPC_DATA_MAX), and its OSAL message is exactly the frame.
+//!
+//! \param  pBuf     OSAL message buffer
+//!
+//! \return     uint8_t
+// ----------------------------------------------------------------------------
+static uint8_t npiframe_isFramed(uint8_t *pBuf)
+{
+    return((pBuf[0] == MT_SOF) &&
+           (OsalPort_MSG_LEN(pBuf) == (NPIFRAME_HDR_SZ + MTRPC_FRAME_HDR_SZ +
+                                       pBuf[NPIFRAME_HDR_SZ + MTRPC_POS_LEN] +
+                                       NPIFRAME_TRAILER_SZ)));
+}
+
 // ----------------------------------------------------------------------------
 //! \brief      Calculate the FCS of a message buffer by XOR'ing each uint8_t.
 //!         Remember to exclude SOP and FCS fields, so start at the CMD field.
@@ -137,6 +137,10 @@ Char npiTaskStack[NPITASK_STACK_SIZE];
 //!
 static Queue_Handle npiTxQueue;
 
+//! \brief Number of messages waiting in the ASYNC TX Queue
+//!
+static uint16_t npiTxQueueDepth = 0;
+
 //! \brief Handle for the ASYNC RX Queue
 //!
 static Queue_Handle npiRxQueue;
@@ -612,6 +616,17 @@ uint8_t NPITask_getServiceTaskId(void)
     return npiServiceTaskId;
 }
 
+// -----------------------------------------------------------------------------
+//! \brief      Number of messages waiting in the ASYNC TX Queue, for
+//!             producers that would rather hold data than add to a backlog.
+//!
+//! \return     uint16_t - queued message count
+// -----------------------------------------------------------------------------
+uint16_t NPITask_getTxQueueDepth(void)
+{
+    return npiTxQueueDepth;
+}
+
 // -----------------------------------------------------------------------------
 //! \brief      Register callback function to reroute incoming (from host)
 //!             NPI messages.
@@ -685,6 +700,7 @@ void NPITask_sendToHost(uint8_t *pMsg)
             case NPIMSG_Type_ASYNC:
             {
                 Queue_enqueue(npiTxQueue, &recPtr->_elem);
+                npiTxQueueDepth++;
                 npiServiceTaskEvents |= NPITASK_TX_READY_EVENT;
                 Semaphore_post(npiSemHandle);
                 break;
@@ -768,13 +784,14 @@ static void NPITask_processStackMsg(uint8_t *pMsg)
                 // Pass the message along to the application and the leave
                 // this function with an immediate return.
                 // The message needs to be free by the callback.
-                incomingTXEventAppCBFunc(pMsg);
+                incomingTXEventAppCBFunc(NPIFrame_unframeMsg(pMsg, FALSE));
                 return;
             }
             case ECHO:
             {
-                // Pass the message along to the application
-                incomingTXEventAppCBFunc(pMsg);
+                // Pass the message along to the application, the buffer
+                // stays framed for the host.
+                incomingTXEventAppCBFunc(NPIFrame_unframeMsg(pMsg, TRUE));
                 break;
             }
             case NONE:
@@ -816,6 +833,7 @@ static void NPITask_processStackMsg(uint8_t *pMsg)
                 case NPIMSG_Type_ASYNC:
                 {
                     Queue_enqueue(npiTxQueue, &recPtr->_elem);
+                    npiTxQueueDepth++;
                     npiServiceTaskEvents |= NPITASK_TX_READY_EVENT;
                     Semaphore_post(npiSemHandle);
                     break;
@@ -861,6 +879,8 @@ static void NPITask_ProcessTXQ(void)
 
     if (recPtr != NULL)
     {
+        npiTxQueueDepth--;
+
         NPITL_writeTL(recPtr->npiMsg->pBuf, recPtr->npiMsg->pBufSize);
 
         //free the Queue record
@@ -119,6 +119,13 @@ void NPITask_createTask();
  */
 uint8_t NPITask_getServiceTaskId(void);
 
+// -----------------------------------------------------------------------------
+//! \brief      Number of messages waiting in the ASYNC TX Queue.
+//!
+//! \return     uint16_t - queued message count
+// -----------------------------------------------------------------------------
+extern uint16_t NPITask_getTxQueueDepth(void);
+
 // -----------------------------------------------------------------------------
 //! \brief      Register callback function to reroute incoming (from host)
 //!             NPI messages.
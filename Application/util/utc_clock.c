@@ -50,6 +50,7 @@
  */
 
 #include <ti/drivers/dpl/ClockP.h>
+#include <ti/drivers/dpl/HwiP.h>
 #include "comdef.h"
 #include "utc_clock.h"
 
@@ -97,6 +98,21 @@ ClockP_Struct UTC_clock;
 // 1st of January 2000 UTC.
 UTCTime UTC_timeSeconds = 0;
 
+// Millisecond portion of time.
+static uint32_t UTC_timeMSec = 0;
+
+// Clock discipline state.
+static UTCDiscipline UTC_disc;
+
+// Rate correction carried over, in millionths of a millisecond.
+static int32_t UTC_driftCarry = 0;
+
+// Uncorrected milliseconds and error built up since the drift was last
+// estimated, only valid after a sync point.
+static uint8_t UTC_syncValid = FALSE;
+static uint32_t UTC_syncMSec = 0;
+static int32_t UTC_syncErrMSec = 0;
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
@@ -229,16 +245,47 @@ void UTC_timeUpdateHandler(void)
  */
 static void UTC_clockUpdate(uint32_t elapsedMSec)
 {
-  static uint32_t timeMSec = 0;
+  int32_t adjMSec;
+  int32_t slewMax;
+
+  // Keep the uncorrected time since the last drift estimate.
+  if (UTC_syncMSec < (0xFFFFFFFF - elapsedMSec))
+  {
+    UTC_syncMSec += elapsedMSec;
+  }
+
+  // Rate correction, the sub-millisecond part is carried over.
+  UTC_driftCarry += (int32_t)elapsedMSec * UTC_disc.driftPpm;
+  adjMSec = UTC_driftCarry / 1000000;
+  UTC_driftCarry -= adjMSec * 1000000;
+
+  // Slew out the remaining offset, a bounded part of the elapsed time at
+  // a time so the clock never steps or runs backwards.
+  slewMax = elapsedMSec / UTC_SLEW_DIV;
+  if (UTC_disc.slewMSec > slewMax)
+  {
+    adjMSec += slewMax;
+    UTC_disc.slewMSec -= slewMax;
+  }
+  else if (UTC_disc.slewMSec < -slewMax)
+  {
+    adjMSec -= slewMax;
+    UTC_disc.slewMSec += slewMax;
+  }
+  else
+  {
+    adjMSec += UTC_disc.slewMSec;
+    UTC_disc.slewMSec = 0;
+  }
 
   // Add elapsed milliseconds to the saved millisecond portion of time.
-  timeMSec += elapsedMSec;
+  UTC_timeMSec += (uint32_t)((int32_t)elapsedMSec + adjMSec);
 
   // Roll up milliseconds to the number of seconds.
-  if (timeMSec >= 1000)
+  if (UTC_timeMSec >= 1000)
   {
-    UTC_timeSeconds += timeMSec / 1000;
-    timeMSec = timeMSec % 1000;
+    UTC_timeSeconds += UTC_timeMSec / 1000;
+    UTC_timeMSec = UTC_timeMSec % 1000;
   }
 }
 
@@ -255,7 +302,19 @@ static void UTC_clockUpdate(uint32_t elapsedMSec)
  */
 void UTC_setClock(UTCTime newTime)
 {
+  uintptr_t key = HwiP_disable();
+
   UTC_timeSeconds = newTime;
+
+  // The fraction is unknown, so this can't be a drift reference.
+  UTC_disc.set = TRUE;
+  UTC_disc.lastSync = UTC_SYNC_STEP;
+  UTC_disc.offsetMSec = 0;
+  UTC_disc.slewMSec = 0;
+  UTC_disc.lastSetTime = newTime;
+  UTC_syncValid = FALSE;
+
+  HwiP_restore(key);
 }
 
 /*********************************************************************
@@ -275,6 +334,112 @@ UTCTime UTC_getClock(void)
   return (UTC_timeSeconds);
 }
 
+/*********************************************************************
+ * @fn      UTC_discipline
+ *
+ * @brief   Discipline the clock from a host sync point.  An offset up
+ *          to UTC_STEP_THRESHOLD is slewed out, and the error built up
+ *          since the last estimate corrects the rate once at least
+ *          UTC_DRIFT_MIN_INTERVAL has passed.  A larger offset, or the
+ *          first sync point, steps the clock.
+ *
+ * @param   newTime - Number of seconds since 0 hrs, 0 minutes,
+ *                    0 seconds, on the 1st of January 2000 UTC.
+ * @param   newMSec - Milliseconds into that second, 0-999.
+ *
+ * @return  UTC_SYNC_STEP or UTC_SYNC_SLEW
+ */
+uint8_t UTC_discipline(UTCTime newTime, uint16_t newMSec)
+{
+  uintptr_t key;
+  int64_t offset;
+  int32_t ppm;
+
+  key = HwiP_disable();
+
+  // Bring the clock up to date before comparing.
+  UTC_timeUpdateHandler();
+
+  offset = ((int64_t)(int32_t)(newTime - UTC_timeSeconds) * 1000) +
+           (int32_t)newMSec - (int32_t)UTC_timeMSec;
+
+  if (!UTC_disc.set || (offset > UTC_STEP_THRESHOLD) || (offset < -UTC_STEP_THRESHOLD))
+  {
+    UTC_timeSeconds = newTime;
+    UTC_timeMSec = newMSec;
+    UTC_disc.slewMSec = 0;
+    UTC_disc.lastSync = UTC_SYNC_STEP;
+    UTC_disc.offsetMSec = (offset > INT32_MAX) ? INT32_MAX :
+                          (offset < INT32_MIN) ? INT32_MIN : (int32_t)offset;
+  }
+  else
+  {
+    if (UTC_syncValid)
+    {
+      // The slew still pending was already known, the rest of the
+      // offset built up since the last sync point.
+      UTC_syncErrMSec += (int32_t)offset - UTC_disc.slewMSec;
+
+      if (UTC_syncMSec >= UTC_DRIFT_MIN_INTERVAL)
+      {
+        // Move halfway to the measured rate to ride out host jitter.
+        ppm = (int32_t)(((int64_t)UTC_syncErrMSec * 1000000) / UTC_syncMSec);
+        ppm = UTC_disc.driftPpm + (ppm / 2);
+
+        if (ppm > UTC_DRIFT_MAX_PPM)
+        {
+          ppm = UTC_DRIFT_MAX_PPM;
+        }
+        else if (ppm < -UTC_DRIFT_MAX_PPM)
+        {
+          ppm = -UTC_DRIFT_MAX_PPM;
+        }
+
+        UTC_disc.driftPpm = (int16_t)ppm;
+        UTC_syncMSec = 0;
+        UTC_syncErrMSec = 0;
+      }
+    }
+
+    UTC_disc.slewMSec = (int32_t)offset;
+    UTC_disc.lastSync = UTC_SYNC_SLEW;
+    UTC_disc.offsetMSec = (int32_t)offset;
+  }
+
+  if (!UTC_syncValid || (UTC_disc.lastSync == UTC_SYNC_STEP))
+  {
+    // New reference for the drift estimate.
+    UTC_syncValid = TRUE;
+    UTC_syncMSec = 0;
+    UTC_syncErrMSec = 0;
+  }
+
+  UTC_disc.set = TRUE;
+  UTC_disc.lastSetTime = newTime;
+
+  HwiP_restore(key);
+
+  return (UTC_disc.lastSync);
+}
+
+/*********************************************************************
+ * @fn      UTC_getDiscipline
+ *
+ * @brief   Gets the clock discipline state.
+ *
+ * @param   pState - output
+ *
+ * @return  none
+ */
+void UTC_getDiscipline(UTCDiscipline *pState)
+{
+  uintptr_t key = HwiP_disable();
+
+  *pState = UTC_disc;
+
+  HwiP_restore(key);
+}
+
 /*********************************************************************
  * @fn      UTC_convertUTCTime
  *
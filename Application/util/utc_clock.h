@@ -65,6 +65,30 @@ extern "C"
  * CONSTANTS
  */
 
+// Offsets above this many milliseconds are stepped, smaller ones slewed
+#ifndef UTC_STEP_THRESHOLD
+#define UTC_STEP_THRESHOLD      2000
+#endif
+
+// Slewing adds or removes at most 1/UTC_SLEW_DIV of the elapsed time
+#ifndef UTC_SLEW_DIV
+#define UTC_SLEW_DIV            20
+#endif
+
+// Largest rate correction, in parts per million
+#ifndef UTC_DRIFT_MAX_PPM
+#define UTC_DRIFT_MAX_PPM       500
+#endif
+
+// Shortest time between sync points used to estimate drift, in milliseconds
+#ifndef UTC_DRIFT_MIN_INTERVAL
+#define UTC_DRIFT_MIN_INTERVAL  60000
+#endif
+
+// UTC_discipline() results
+#define UTC_SYNC_STEP           0   // Clock set to the sync point
+#define UTC_SYNC_SLEW           1   // Offset slewed out, drift estimate updated
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -84,6 +108,17 @@ typedef struct
   uint16_t year;    // 2000+
 } UTCTimeStruct;
 
+// Clock discipline state
+typedef struct
+{
+  uint8_t set;            // TRUE once the clock was set or disciplined
+  uint8_t lastSync;       // UTC_SYNC_STEP or UTC_SYNC_SLEW
+  int16_t driftPpm;       // Rate correction applied, parts per million
+  int32_t offsetMSec;     // Offset measured at the last sync point
+  int32_t slewMSec;       // Offset still to be slewed out
+  UTCTime lastSetTime;    // Time of the last sync point
+} UTCDiscipline;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -120,6 +155,22 @@ extern void UTC_setClock( UTCTime newTime );
  */
 extern UTCTime UTC_getClock( void );
 
+/*
+ * Discipline the clock from a host sync point.  Small offsets are
+ * slewed out and feed the drift estimate, large ones step the clock.
+ *     newTime - number of seconds since 0 hrs, 0 minutes,
+ *               0 seconds, on the 1st of January 2000 UTC
+ *     newMSec - milliseconds into that second
+ *     returns: UTC_SYNC_STEP or UTC_SYNC_SLEW
+ */
+extern uint8_t UTC_discipline( UTCTime newTime, uint16_t newMSec );
+
+/*
+ * Gets the clock discipline state.
+ *     pState - output
+ */
+extern void UTC_getDiscipline( UTCDiscipline *pState );
+
 /*
  * Converts UTCTime to UTCTimeStruct
  *
@@ -0,0 +1,451 @@
+/******************************************************************************
+
+ @file  utc_timesrv.c
+
+ @brief This file contains the ZCL Time cluster server.  Read Attributes
+        of the Time cluster are answered on the device from the UTC
+        clock instead of being relayed to the host.
+
+ Group: WCS, BTS
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2004-2021, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcomdef.h"
+#include "af.h"
+#include "zd_app.h"
+#include "utc_clock.h"
+#include "utc_timesrv.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// ZCL frame control
+#define ZCL_FRAME_TYPE_MASK                 0x03
+#define ZCL_FRAME_TYPE_PROFILE_CMD          0x00
+#define ZCL_FRAME_MANU_SPECIFIC             0x04
+#define ZCL_FRAME_SERVER_CLIENT_DIR         0x08
+#define ZCL_FRAME_DISABLE_DEFAULT_RSP       0x10
+
+// ZCL general commands
+#define ZCL_CMD_READ                        0x00
+#define ZCL_CMD_READ_RSP                    0x01
+#define ZCL_CMD_DEFAULT_RSP                 0x0B
+
+// ZCL status
+#define ZCL_STATUS_SUCCESS                  0x00
+#define ZCL_STATUS_UNSUP_CLUSTER_COMMAND    0x81
+#define ZCL_STATUS_UNSUP_GENERAL_COMMAND    0x82
+#define ZCL_STATUS_UNSUPPORTED_ATTRIBUTE    0x86
+
+// ZCL data types
+#define ZCL_DATATYPE_BITMAP8                0x18
+#define ZCL_DATATYPE_UINT32                 0x23
+#define ZCL_DATATYPE_INT32                  0x2B
+#define ZCL_DATATYPE_UTC                    0xE2
+
+// Time cluster attributes
+#define ATTRID_TIME_TIME                    0x0000
+#define ATTRID_TIME_STATUS                  0x0001
+#define ATTRID_TIME_ZONE                    0x0002
+#define ATTRID_TIME_DST_START               0x0003
+#define ATTRID_TIME_DST_END                 0x0004
+#define ATTRID_TIME_DST_SHIFT               0x0005
+#define ATTRID_TIME_STANDARD_TIME           0x0006
+#define ATTRID_TIME_LOCAL_TIME              0x0007
+#define ATTRID_TIME_LAST_SET_TIME           0x0008
+
+// TimeStatus bits
+#define TIME_STATUS_MASTER                  0x01
+#define TIME_STATUS_SYNCHRONIZED            0x02
+
+// UTC time of a clock that was never set
+#define UTC_TIME_INVALID                    0xFFFFFFFF
+
+// Highest application endpoint
+#define UTC_TIMESRV_MAX_EP                  240
+
+// Header of a request or response without manufacturer code
+#define ZCL_HDR_LEN                         3
+
+// Attributes answered per Read Attributes, more than the cluster has
+#define UTC_TIMESRV_MAX_ATTRS               12
+
+// Attribute record of a response: ID, status, type and 32-bit value
+#define UTC_TIMESRV_REC_LEN                 8
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static cId_t UTC_timeSrvInClusters[] = { UTC_TIMESRV_CLUSTER_ID };
+
+static SimpleDescriptionFormat_t UTC_timeSrvSimpleDesc =
+{
+  0,                              // EndPoint, set when registered
+  UTC_TIMESRV_PROFILE_ID,         // AppProfId
+  0x0005,                         // AppDeviceId, configuration tool
+  0,                              // AppDevVer
+  0,                              // Reserved
+  1,                              // AppNumInClusters
+  UTC_timeSrvInClusters,          // pAppInClusterList
+  0,                              // AppNumOutClusters
+  NULL                            // pAppOutClusterList
+};
+
+static endPointDesc_t UTC_timeSrvEpDesc =
+{
+  0,                              // endPoint, set when registered
+  0,                              // epType
+  &ZDAppTaskID,                   // task_id, confirms of the responses go to ZDO
+  &UTC_timeSrvSimpleDesc,
+  noLatencyReqs
+};
+
+// Local time settings
+static int32_t UTC_timeSrvZone = 0;
+static uint32_t UTC_timeSrvDstStart = 0;
+static uint32_t UTC_timeSrvDstEnd = 0;
+static int32_t UTC_timeSrvDstShift = 0;
+
+static uint8_t UTC_timeSrvTransID = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static uint8_t UTC_timeSrvIncoming( afIncomingMSGPacket_t *pkt );
+static uint8_t *UTC_timeSrvReadAttr( uint8_t *pBuf, uint16_t attrId );
+static void UTC_timeSrvSend( afIncomingMSGPacket_t *pkt, uint8_t *pBuf, uint16_t len );
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      UTC_timeServerConfig
+ *
+ * @brief   Set the Time cluster server endpoint and the local time
+ *          settings.  The server is registered as an AF endpoint taking
+ *          its data through a synchronous callback.
+ *
+ * @param   endPoint - endpoint of the server, 0 to remove it
+ * @param   timeZone - offset of standard time from UTC, in seconds
+ * @param   dstStart - UTC time daylight saving time starts
+ * @param   dstEnd - UTC time daylight saving time ends
+ * @param   dstShift - offset of daylight saving time from standard
+ *                     time, in seconds
+ *
+ * @return  ZSuccess, ZInvalidParameter if the endpoint is taken,
+ *          ZMemError if it can't be registered
+ */
+uint8_t UTC_timeServerConfig( uint8_t endPoint, int32_t timeZone,
+                              uint32_t dstStart, uint32_t dstEnd,
+                              int32_t dstShift )
+{
+  endPointDesc_t *epDesc;
+
+  if ( endPoint > UTC_TIMESRV_MAX_EP )
+  {
+    return ( ZInvalidParameter );
+  }
+
+  if ( endPoint != UTC_timeSrvEpDesc.endPoint )
+  {
+    epDesc = afFindEndPointDesc( endPoint );
+    if ( (endPoint != 0) && (epDesc != NULL) && (epDesc != &UTC_timeSrvEpDesc) )
+    {
+      // Registered by the host
+      return ( ZInvalidParameter );
+    }
+
+    // The host may have removed it already
+    if ( (UTC_timeSrvEpDesc.endPoint != 0) &&
+         (afFindEndPointDesc( UTC_timeSrvEpDesc.endPoint ) == &UTC_timeSrvEpDesc) )
+    {
+      afDelete( UTC_timeSrvEpDesc.endPoint );
+    }
+
+    UTC_timeSrvEpDesc.endPoint = 0;
+    UTC_timeSrvSimpleDesc.EndPoint = 0;
+
+    if ( endPoint != 0 )
+    {
+      UTC_timeSrvEpDesc.endPoint = endPoint;
+      UTC_timeSrvSimpleDesc.EndPoint = endPoint;
+
+      if ( afRegisterExtended( &UTC_timeSrvEpDesc, NULL, NULL ) == NULL )
+      {
+        UTC_timeSrvEpDesc.endPoint = 0;
+        UTC_timeSrvSimpleDesc.EndPoint = 0;
+        return ( ZMemError );
+      }
+
+      (void)afSetIncomingCB( endPoint, UTC_timeSrvIncoming );
+    }
+  }
+
+  UTC_timeSrvZone = timeZone;
+  UTC_timeSrvDstStart = dstStart;
+  UTC_timeSrvDstEnd = dstEnd;
+  UTC_timeSrvDstShift = dstShift;
+
+  return ( ZSuccess );
+}
+
+/*********************************************************************
+ * @fn      UTC_timeServerEndpoint
+ *
+ * @brief   Gets the Time cluster server endpoint.
+ *
+ * @param   none
+ *
+ * @return  endpoint, 0 if none
+ */
+uint8_t UTC_timeServerEndpoint( void )
+{
+  return ( UTC_timeSrvEpDesc.endPoint );
+}
+
+/*********************************************************************
+ * @fn      UTC_timeSrvIncoming
+ *
+ * @brief   Take a ZCL frame for the server endpoint.  Read Attributes
+ *          of the Time cluster are answered, other commands get a
+ *          Default Response, other clusters are dropped.
+ *
+ * @param   pkt - incoming message, only valid during the call
+ *
+ * @return  TRUE, the message is always taken
+ */
+static uint8_t UTC_timeSrvIncoming( afIncomingMSGPacket_t *pkt )
+{
+  uint8_t rsp[ZCL_HDR_LEN + (UTC_TIMESRV_MAX_ATTRS * UTC_TIMESRV_REC_LEN)];
+  uint8_t *pData = pkt->cmd.Data;
+  uint8_t *pRsp;
+  uint16_t len = pkt->cmd.DataLength;
+  uint8_t frameCtrl;
+  uint8_t status;
+
+  if ( (pkt->clusterId != UTC_TIMESRV_CLUSTER_ID) || (len < ZCL_HDR_LEN) )
+  {
+    return ( TRUE );
+  }
+
+  frameCtrl = pData[0];
+
+  // No manufacturer attributes, and responses aren't for a server
+  if ( frameCtrl & (ZCL_FRAME_MANU_SPECIFIC | ZCL_FRAME_SERVER_CLIENT_DIR) )
+  {
+    return ( TRUE );
+  }
+
+  rsp[0] = ZCL_FRAME_TYPE_PROFILE_CMD | ZCL_FRAME_SERVER_CLIENT_DIR | ZCL_FRAME_DISABLE_DEFAULT_RSP;
+  rsp[1] = pData[1];
+
+  if ( ((frameCtrl & ZCL_FRAME_TYPE_MASK) == ZCL_FRAME_TYPE_PROFILE_CMD) &&
+       (pData[2] == ZCL_CMD_READ) )
+  {
+    rsp[2] = ZCL_CMD_READ_RSP;
+    pRsp = &rsp[ZCL_HDR_LEN];
+
+    for ( pData += ZCL_HDR_LEN, len -= ZCL_HDR_LEN;
+          (len >= 2) && ((pRsp + UTC_TIMESRV_REC_LEN) <= &rsp[sizeof( rsp )]);
+          pData += 2, len -= 2 )
+    {
+      pRsp = UTC_timeSrvReadAttr( pRsp, BUILD_UINT16( pData[0], pData[1] ) );
+    }
+
+    UTC_timeSrvSend( pkt, rsp, (uint16_t)(pRsp - rsp) );
+  }
+  else if ( !(frameCtrl & ZCL_FRAME_DISABLE_DEFAULT_RSP) && !pkt->wasBroadcast &&
+            (pkt->groupId == 0) )
+  {
+    if ( (frameCtrl & ZCL_FRAME_TYPE_MASK) == ZCL_FRAME_TYPE_PROFILE_CMD )
+    {
+      status = ZCL_STATUS_UNSUP_GENERAL_COMMAND;
+    }
+    else
+    {
+      // The Time cluster has no cluster commands
+      status = ZCL_STATUS_UNSUP_CLUSTER_COMMAND;
+    }
+
+    rsp[2] = ZCL_CMD_DEFAULT_RSP;
+    rsp[3] = pData[2];
+    rsp[4] = status;
+
+    UTC_timeSrvSend( pkt, rsp, ZCL_HDR_LEN + 2 );
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      UTC_timeSrvReadAttr
+ *
+ * @brief   Build the Read Attributes Response record of an attribute.
+ *
+ * @param   pBuf - where to build the record, room for
+ *                 UTC_TIMESRV_REC_LEN bytes
+ * @param   attrId - attribute
+ *
+ * @return  pointer past the record
+ */
+static uint8_t *UTC_timeSrvReadAttr( uint8_t *pBuf, uint16_t attrId )
+{
+  UTCDiscipline disc;
+  UTCTime now;
+  uint32_t value;
+  uint8_t type;
+
+  UTC_getDiscipline( &disc );
+  now = UTC_getClock();
+
+  *pBuf++ = LO_UINT16( attrId );
+  *pBuf++ = HI_UINT16( attrId );
+
+  switch ( attrId )
+  {
+    case ATTRID_TIME_TIME:
+      type = ZCL_DATATYPE_UTC;
+      value = disc.set ? now : UTC_TIME_INVALID;
+      break;
+
+    case ATTRID_TIME_STATUS:
+      // Set from the host, which is the time master of the network
+      *pBuf++ = ZCL_STATUS_SUCCESS;
+      *pBuf++ = ZCL_DATATYPE_BITMAP8;
+      *pBuf++ = disc.set ? (TIME_STATUS_MASTER | TIME_STATUS_SYNCHRONIZED) : 0;
+      return ( pBuf );
+
+    case ATTRID_TIME_ZONE:
+      type = ZCL_DATATYPE_INT32;
+      value = (uint32_t)UTC_timeSrvZone;
+      break;
+
+    case ATTRID_TIME_DST_START:
+      type = ZCL_DATATYPE_UINT32;
+      value = UTC_timeSrvDstStart;
+      break;
+
+    case ATTRID_TIME_DST_END:
+      type = ZCL_DATATYPE_UINT32;
+      value = UTC_timeSrvDstEnd;
+      break;
+
+    case ATTRID_TIME_DST_SHIFT:
+      type = ZCL_DATATYPE_INT32;
+      value = (uint32_t)UTC_timeSrvDstShift;
+      break;
+
+    case ATTRID_TIME_STANDARD_TIME:
+      type = ZCL_DATATYPE_UINT32;
+      value = disc.set ? (now + UTC_timeSrvZone) : UTC_TIME_INVALID;
+      break;
+
+    case ATTRID_TIME_LOCAL_TIME:
+      type = ZCL_DATATYPE_UINT32;
+      value = UTC_TIME_INVALID;
+      if ( disc.set )
+      {
+        value = now + UTC_timeSrvZone;
+        if ( (now >= UTC_timeSrvDstStart) && (now < UTC_timeSrvDstEnd) )
+        {
+          value += UTC_timeSrvDstShift;
+        }
+      }
+      break;
+
+    case ATTRID_TIME_LAST_SET_TIME:
+      type = ZCL_DATATYPE_UTC;
+      value = disc.set ? disc.lastSetTime : UTC_TIME_INVALID;
+      break;
+
+    default:
+      *pBuf++ = ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+      return ( pBuf );
+  }
+
+  *pBuf++ = ZCL_STATUS_SUCCESS;
+  *pBuf++ = type;
+  *pBuf++ = BREAK_UINT32( value, 0 );
+  *pBuf++ = BREAK_UINT32( value, 1 );
+  *pBuf++ = BREAK_UINT32( value, 2 );
+  *pBuf++ = BREAK_UINT32( value, 3 );
+
+  return ( pBuf );
+}
+
+/*********************************************************************
+ * @fn      UTC_timeSrvSend
+ *
+ * @brief   Send a response back to the source of a request.
+ *
+ * @param   pkt - request
+ * @param   pBuf - response frame
+ * @param   len - length of the response frame
+ *
+ * @return  none
+ */
+static void UTC_timeSrvSend( afIncomingMSGPacket_t *pkt, uint8_t *pBuf, uint16_t len )
+{
+  afAddrType_t dstAddr;
+
+  dstAddr.addrMode = afAddr16Bit;
+  dstAddr.addr.shortAddr = pkt->srcAddr.addr.shortAddr;
+  dstAddr.endPoint = pkt->srcAddr.endPoint;
+  dstAddr.panId = pkt->srcAddr.panId;
+
+  (void)AF_DataRequest( &dstAddr, &UTC_timeSrvEpDesc, UTC_TIMESRV_CLUSTER_ID, len, pBuf,
+                        &UTC_timeSrvTransID, AF_TX_OPTIONS_NONE, AF_DEFAULT_RADIUS );
+}
+
+/*********************************************************************
+*********************************************************************/
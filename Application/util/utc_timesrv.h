@@ -0,0 +1,114 @@
+/******************************************************************************
+
+ @file  utc_timesrv.h
+
+ @brief This file contains the ZCL Time cluster server answering time
+        reads on the device from the UTC clock.
+
+ Group: WCS, BTS
+ Target Device: cc13x2_26x2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2004-2021, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ 
+ 
+ *****************************************************************************/
+
+#ifndef UTC_TIMESRV_H
+#define UTC_TIMESRV_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "utc_clock.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Home Automation profile, the Time cluster server endpoint is in
+#define UTC_TIMESRV_PROFILE_ID      0x0104
+
+// Time cluster
+#define UTC_TIMESRV_CLUSTER_ID      0x000A
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Set the Time cluster server endpoint and the local time settings.
+ *     endPoint - endpoint of the server, 0 to remove it
+ *     timeZone - offset of standard time from UTC, in seconds
+ *     dstStart - UTC time daylight saving time starts
+ *     dstEnd - UTC time daylight saving time ends
+ *     dstShift - offset of daylight saving time from standard time,
+ *                in seconds
+ *     returns: ZSuccess, ZInvalidParameter if the endpoint is taken,
+ *              ZMemError if it can't be registered
+ */
+extern uint8_t UTC_timeServerConfig( uint8_t endPoint, int32_t timeZone,
+                                     uint32_t dstStart, uint32_t dstEnd,
+                                     int32_t dstShift );
+
+/*
+ * Gets the Time cluster server endpoint, 0 if none.
+ */
+extern uint8_t UTC_timeServerEndpoint( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTC_TIMESRV_H */
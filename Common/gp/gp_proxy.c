@@ -155,6 +155,7 @@ void zclGp_GpPairingCommandCB( zclGpPairing_t *pCmd )
 
     if(gp_getProxyTableByGpId(&gpdID, currEntry, &proxyTableIndex) == ZSuccess)
     {
+      gp_AliasSetInvalidate();
       gp_ResetProxyTblEntry(currEntry);
       zclport_writeNV(ZCL_PORT_PROXY_TABLE_NV_ID, proxyTableIndex,
                                PROXY_TBL_LEN,
@@ -592,6 +593,8 @@ uint8_t gp_ProxyTblInit(uint8_t resetTable)
 
  gp_ResetProxyTblEntry(emptyEntry);
 
+ gp_AliasSetInvalidate();
+
  for(i = 0; i < GPP_MAX_PROXY_TABLE_ENTRIES ; i++)
  {
    status = zclport_initializeNVItem(ZCL_PORT_PROXY_TABLE_NV_ID, i,
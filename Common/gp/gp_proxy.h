@@ -200,6 +200,12 @@ extern void gp_SetProxyCommissioningMode(bool enabled);
  */
 extern void gp_CheckAnnouncedDevice ( uint8_t *sinkIEEE, uint16_t sinkNwkAddr );
 
+/*
+ * @brief       Drop the in-RAM copy of the proxy table addresses after the
+ *              proxy table has been written
+ */
+extern void gp_AliasSetInvalidate( void );
+
 /*
  * @brief       Populate the given item data
  */
@@ -89,6 +89,16 @@ extern uint8_t gpAppEntity;
  * LOCAL VARIABLES
  */
 
+// In-RAM copy of the proxy table addresses an announced device can
+// conflict with, so device announces do not read the table from NV
+static struct
+{
+  uint16_t alias;
+  uint16_t grpAddr[2];
+} gpAliasSet[GPP_MAX_PROXY_TABLE_ENTRIES];
+static uint8_t gpAliasSetCnt = 0;
+static uint8_t gpAliasSetValid = FALSE;
+
  /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -100,6 +110,7 @@ static uint8_t pt_removeLightweightUnicastSink( uint8_t* pEntry, uint8_t* pAddr
 static uint8_t pt_addProxyGroup( uint8_t* pNew, uint8_t* pCurr );
 static uint8_t pt_removeProxyGroup( uint8_t* pEntry, uint16_t groupAddr );
 static uint16_t gp_pairingSetProxyTblOptions( uint32_t pairingOpt );
+static uint8_t pt_loadAliasSet( void );
 
 /*********************************************************************
  * PUBLIC FUNCTIONS
@@ -307,6 +318,8 @@ uint8_t gp_UpdateProxyTbl( uint8_t* pEntry, uint32_t options, uint8_t conflictRe
   // Copy the new entry pointer to array
   proxyTableCpy( &newEntry, pEntry );
 
+  gp_AliasSetInvalidate();
+
   for(i = 0; i < GPP_MAX_PROXY_TABLE_ENTRIES ; i++)
   {
     proxyTableIndex = i;
@@ -624,33 +637,25 @@ void gp_PairingUpdateProxyTbl( gpPairingCmd_t* payload )
 void gp_CheckAnnouncedDevice ( uint8_t *sinkIEEE, uint16_t sinkNwkAddr )
 {
   uint8_t i;
-  uint8_t status;
-  uint8_t ProxyTableEntry[PROXY_TBL_LEN];
 
 #if !(defined (USE_ICALL) || defined (OSAL_PORT2TIRTOS))
   uint8_t annceDelay;
 #endif
 
-  for(i = 0; i < GPP_MAX_PROXY_TABLE_ENTRIES ; i++)
-  {
-    status = gp_getProxyTableByIndex(i, ProxyTableEntry);
+  (void)sinkIEEE;
 
-    if(status == NV_OPER_FAILED)
-    {
-      // FAIL
-      return;
-    }
-
-    // if the entry is empty
-    if(status == NV_INVALID_DATA)
-    {
-      continue;
-    }
+  if(!gpAliasSetValid && !pt_loadAliasSet())
+  {
+    // FAIL
+    return;
+  }
 
+  for(i = 0; i < gpAliasSetCnt ; i++)
+  {
     // Compare for nwk alias address conflict
-    if(zcl_memcmp(&sinkNwkAddr, &ProxyTableEntry[PROXY_TBL_ALIAS], sizeof(uint16_t))        ||
-       zcl_memcmp(&sinkNwkAddr, &ProxyTableEntry[PROXY_TBL_1ST_GRP_ADDR], sizeof(uint16_t)) ||
-       zcl_memcmp(&sinkNwkAddr, &ProxyTableEntry[PROXY_TBL_2ND_GRP_ADDR], sizeof(uint16_t))   )
+    if((sinkNwkAddr == gpAliasSet[i].alias)   ||
+       (sinkNwkAddr == gpAliasSet[i].grpAddr[0]) ||
+       (sinkNwkAddr == gpAliasSet[i].grpAddr[1])   )
     {
 #if (defined (USE_ICALL) || defined (OSAL_PORT2TIRTOS))
       zstack_gpAddrConflict_t *pMsg;
@@ -683,35 +688,73 @@ void gp_CheckAnnouncedDevice ( uint8_t *sinkIEEE, uint16_t sinkNwkAddr )
       OsalPortTimers_startTimer(gp_TaskID, GP_PROXY_ALIAS_CONFLICT_TIMEOUT, annceDelay);
 #endif
     }
-
-    if(sinkIEEE)
-    {
-      //Check if one of the Sink IEEE is the same
-      if(zcl_memcmp(sinkIEEE, &ProxyTableEntry[PROXY_TBL_1ST_LSINK_ADDR], Z_EXTADDR_LEN))
-      {
-        // If Nwk address is different, then update the new address
-        if(!zcl_memcmp(&sinkNwkAddr, &ProxyTableEntry[PROXY_TBL_1ST_LSINK_ADDR + Z_EXTADDR_LEN], sizeof(uint16_t)))
-        {
-          zcl_memcpy( &ProxyTableEntry[PROXY_TBL_1ST_LSINK_ADDR + Z_EXTADDR_LEN], &sinkNwkAddr, sizeof(uint16_t));
-        }
-      }
-      else if(zcl_memcmp(sinkIEEE, &ProxyTableEntry[PROXY_TBL_2ND_LSINK_ADDR], Z_EXTADDR_LEN))
-      {
-        // If Nwk address is different, then update the new address
-        if (!zcl_memcmp(&sinkNwkAddr, &ProxyTableEntry[PROXY_TBL_2ND_LSINK_ADDR + Z_EXTADDR_LEN], sizeof(uint16_t)))
-        {
-          zcl_memcpy(&ProxyTableEntry[PROXY_TBL_2ND_LSINK_ADDR + Z_EXTADDR_LEN], &sinkNwkAddr, sizeof(uint16_t));
-        }
-      }
-    }
   }
   return;
 }
 
+/*********************************************************************
+ * @fn          gp_AliasSetInvalidate
+ *
+ * @brief       Drop the in-RAM copy of the proxy table addresses, it is
+ *              read again from NV on the next device announce
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+void gp_AliasSetInvalidate( void )
+{
+  gpAliasSetValid = FALSE;
+}
+
  /*********************************************************************
  * PRIVATE FUNCTIONS
  *********************************************************************/
 
+/*********************************************************************
+ * @fn          pt_loadAliasSet
+ *
+ * @brief       Read the alias and group addresses of the proxy table
+ *              entries in use from NV
+ *
+ * @param       none
+ *
+ * @return      TRUE if the proxy table could be read
+ */
+static uint8_t pt_loadAliasSet( void )
+{
+  uint8_t i;
+  uint8_t status;
+  uint8_t ProxyTableEntry[PROXY_TBL_LEN];
+
+  gpAliasSetCnt = 0;
+
+  for(i = 0; i < GPP_MAX_PROXY_TABLE_ENTRIES ; i++)
+  {
+    status = gp_getProxyTableByIndex(i, ProxyTableEntry);
+
+    if(status == NV_OPER_FAILED)
+    {
+      return FALSE;
+    }
+
+    // if the entry is empty
+    if(status == NV_INVALID_DATA)
+    {
+      continue;
+    }
+
+    zcl_memcpy(&gpAliasSet[gpAliasSetCnt].alias, &ProxyTableEntry[PROXY_TBL_ALIAS], sizeof(uint16_t));
+    zcl_memcpy(&gpAliasSet[gpAliasSetCnt].grpAddr[0], &ProxyTableEntry[PROXY_TBL_1ST_GRP_ADDR], sizeof(uint16_t));
+    zcl_memcpy(&gpAliasSet[gpAliasSetCnt].grpAddr[1], &ProxyTableEntry[PROXY_TBL_2ND_GRP_ADDR], sizeof(uint16_t));
+    gpAliasSetCnt++;
+  }
+
+  gpAliasSetValid = TRUE;
+
+  return TRUE;
+}
+
 /*********************************************************************
  * @fn          pt_getAlias
  *
@@ -50,6 +50,8 @@
 #include "zd_profile.h"
 #include "aps_frag.h"
 #include "rtg.h"
+#include "zquirk.h"
+#include "rtg_srctree.h"
 
 #if defined ( MT_AF_CB_FUNC )
   #include "mt_af.h"
@@ -68,6 +70,9 @@
  * MACROS
  */
 
+// Bytes in a bitmap with one bit per endpoint
+#define AF_EP_MAP_LEN  32
+
 /*********************************************************************
  * @fn      afSend
  *
@@ -100,16 +105,60 @@
 
 epList_t *epList;
 
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Built-in profile acceptance rules, the one list both tables below start from
+#define AF_PROFILE_RULES_DEFAULT                                          \
+  /* PGC410EU: https://github.com/Koenkk/zigbee2mqtt/issues/4055 */      \
+  { 0xFC01, 2 },
+
+static CONST afProfileRule_t afProfileRulesDefault[] =
+{
+  AF_PROFILE_RULES_DEFAULT
+};
+
+// Active rules, start out as afProfileRulesDefault
+static afProfileRule_t afProfileRules[AF_PROFILE_RULES_MAX] =
+{
+  AF_PROFILE_RULES_DEFAULT
+};
+static uint8_t afProfileRulesCnt = sizeof( afProfileRulesDefault ) / sizeof( afProfileRule_t );
+static uint8_t afProfilePolicy = AF_PROFILE_POLICY_MATCH;
+
+#if !defined ( APS_NO_GROUPS )
+static uint8_t afUnknownGroupEp = AF_UNKNOWN_GROUP_EP;
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
 
-static void afBuildMSGIncoming( aps_FrameFormat_t *aff, endPointDesc_t *epDesc,
+static void afBuildMSGIncoming( aps_FrameFormat_t *aff, epList_t *pList,
+                zAddrType_t *SrcAddress, uint16_t SrcPanId, NLDE_Signal_t *sig,
+                uint8_t nwkSeqNum, uint8_t SecurityUse, uint32_t timestamp, uint8_t radius,
+                uint8_t **ppAsdu );
+
+static void afFillMSGIncoming( afIncomingMSGPacket_t *MSGpkt, aps_FrameFormat_t *aff,
+                endPointDesc_t *epDesc, zAddrType_t *SrcAddress, uint16_t SrcPanId,
+                NLDE_Signal_t *sig, uint8_t nwkSeqNum, uint8_t SecurityUse,
+                uint32_t timestamp, uint8_t radius, uint8_t *asdu );
+
+static void afDeliverMulti( aps_FrameFormat_t *aff, epList_t *pList, uint8_t *epMap,
                 zAddrType_t *SrcAddress, uint16_t SrcPanId, NLDE_Signal_t *sig,
-                uint8_t nwkSeqNum, uint8_t SecurityUse, uint32_t timestamp, uint8_t radius );
+                uint8_t nwkSeqNum, uint8_t SecurityUse, uint32_t timestamp, uint8_t radius,
+                uint8_t **ppAsdu );
 
 static epList_t *afFindEndPointDescList( uint8_t EndPoint );
 
+static uint8_t afProfileAcceptEp( uint16_t profileID );
+
+#if !defined ( APS_NO_GROUPS )
+static uint8_t afGroupEpMap( uint16_t groupID, uint8_t *epMap );
+static epList_t *afEpMapNext( epList_t *pList, uint8_t *epMap );
+#endif
+
 static pDescCB afGetDescCB( endPointDesc_t *epDesc );
 
 /*********************************************************************
@@ -156,6 +205,8 @@ epList_t *afRegisterExtended( endPointDesc_t *epDesc, pDescCB descFn, pApplCB ap
     ep->apsfCfg.windowSize = APSF_DEFAULT_WINDOW_SIZE;
     ep->flags = eEP_AllowMatch;  // Default to allow Match Descriptor.
     ep->pfnApplCB = applFn;
+    ep->pfnIncomingCB = NULL;
+    ep->pfnIncomingMultiCB = NULL;
 
   #if (BDB_FINDING_BINDING_CAPABILITY_ENABLED==1)
     //Make sure we add at least one application endpoint
@@ -291,6 +342,14 @@ void afDataConfirm( uint8_t endPoint, uint8_t transID, uint16_t clusterID, ZStat
   if ( epDesc == NULL )
     return;
 
+#if defined ( RTG_SRC_TREE )
+  // A kept source route the frame failed over is not put back again
+  if ( ZSTACK_ROUTER_BUILD )
+  {
+    RTG_SrcTreeConfirm( endPoint, transID, status );
+  }
+#endif
+
   // Determine the incoming command type
   msgPtr = (afDataConfirm_t *)OsalPort_msgAllocate( sizeof(afDataConfirm_t) );
   if ( msgPtr )
@@ -398,33 +457,37 @@ void afIncomingData( aps_FrameFormat_t *aff, zAddrType_t *SrcAddress, uint16_t S
 {
   endPointDesc_t *epDesc = NULL;
   epList_t *pList = epList;
+  uint8_t *pAsdu = NULL;  // ASDU copy shared by all queued deliveries
+  uint8_t acceptEp;       // Endpoint accepting the profile regardless of its own
 #if !defined ( APS_NO_GROUPS )
-  uint8_t grpEp = APS_GROUPS_EP_NOT_FOUND;
+  uint8_t grpEpMap[AF_EP_MAP_LEN];  // Endpoints of the group
 #endif
+  uint8_t multiEpMap[AF_EP_MAP_LEN];  // Endpoints taking the frame at once
+  epList_t *pMulti = NULL;            // First of them
+  uint8_t multi;
+
+  // Frames to several endpoints may be taken once for all of them
+  multi = ( ((aff->FrmCtrl & APS_DELIVERYMODE_MASK) == APS_FC_DM_GROUP) ||
+            (aff->DstEndPoint == AF_BROADCAST_ENDPOINT) );
 
   if ( ((aff->FrmCtrl & APS_DELIVERYMODE_MASK) == APS_FC_DM_GROUP) )
   {
 #if !defined ( APS_NO_GROUPS )
-    // Find the first endpoint for this group
-    grpEp = aps_FindGroupForEndpoint( aff->GroupID, APS_GROUPS_FIND_FIRST );
-    if (grpEp == APS_GROUPS_EP_NOT_FOUND) {
-              // No endpoint found, default to endpoint 1.
-                  // In the original source code there is a return here.
-                  // This prevent the messags from being forwarded.
-                  // For our use-case we want to capture all messages.
-                  // Even if the coordinator is not in the group.
-            epDesc = afFindEndPointDesc(1);
-        
-    }
-    else {
-        epDesc = afFindEndPointDesc(grpEp);
-        
+    // Resolve the group to its endpoints once for the whole frame
+    if ( afGroupEpMap( aff->GroupID, grpEpMap ) == 0 )
+    {
+      if ( afUnknownGroupEp == AF_UNKNOWN_GROUP_DROP )
+        return;   // No endpoint in this group
+
+      // Not a member, still capture the frame on the configured endpoint
+      grpEpMap[afUnknownGroupEp / 8] |= BV( afUnknownGroupEp % 8 );
     }
-    //epDesc = afFindEndPointDesc( grpEp );
-    if ( epDesc == NULL )
+
+    pList = afEpMapNext( epList, grpEpMap );
+    if ( pList == NULL )
       return;   // Endpoint descriptor not found
 
-    pList = afFindEndPointDescList( epDesc->endPoint );
+    epDesc = pList->epDesc;
 #else
     return; // Not supported
 #endif
@@ -442,6 +505,21 @@ void afIncomingData( aps_FrameFormat_t *aff, zAddrType_t *SrcAddress, uint16_t S
     pList = afFindEndPointDescList( epDesc->endPoint );
   }
 
+  acceptEp = afProfileAcceptEp( aff->ProfileID );
+
+  if ( acceptEp == AF_PROFILE_RULE_NO_EP )
+  {
+    // Host loaded quirk of the source, accept its profile anyway
+    uint8_t quirks = ( SrcAddress->addrMode == Addr64Bit )
+                       ? ZQuirkLookupExt( SrcAddress->addr.extAddr )
+                       : ZQuirkLookupNwk( SrcAddress->addr.shortAddr );
+
+    if ( quirks & ZQUIRK_ANY_PROFILE )
+    {
+      acceptEp = AF_PROFILE_RULE_ANY_EP;
+    }
+  }
+
   while ( epDesc )
   {
     uint16_t epProfileID = 0xFFFE;  // Invalid Profile ID
@@ -461,43 +539,52 @@ void afIncomingData( aps_FrameFormat_t *aff, zAddrType_t *SrcAddress, uint16_t S
       epProfileID = epDesc->simpleDesc->AppProfId;
     }
 
-    // First part of verification is to make sure that:
-    // the local Endpoint ProfileID matches the received ProfileID OR
-    // the message is specifically send to ZDO (this excludes the broadcast endpoint) OR
-    // if the Wildcard ProfileID is received the message should not be sent to ZDO endpoint
+    // The local Endpoint ProfileID matches the received ProfileID OR
+    // the endpoint accepts the received ProfileID through the profile rules
+    // (ZDO profile on the ZDO endpoint, wildcard profile on application
+    // endpoints, host loaded quirks)
     if ( (aff->ProfileID == epProfileID) ||
-         ((epDesc->endPoint == ZDO_EP) && (aff->ProfileID == ZDO_PROFILE_ID)) ||
-         ((epDesc->endPoint != ZDO_EP) && (aff->ProfileID == ZDO_WILDCARD_PROFILE_ID)) || // Fix below is to support PGC410EU: https://github.com/Koenkk/zigbee2mqtt/issues/4055
-         ((epDesc->endPoint == 2) && (aff->ProfileID == 0xFC01)) )
+         (acceptEp == epDesc->endPoint) ||
+         ((acceptEp == AF_PROFILE_RULE_ANY_EP) && (epDesc->endPoint != ZDO_EP)) )
     {
-      // Save original endpoint
-      uint8_t endpoint = aff->DstEndPoint;
+      if ( multi && (pList->pfnIncomingMultiCB != NULL) &&
+           ((pMulti == NULL) || (pList->pfnIncomingMultiCB == pMulti->pfnIncomingMultiCB)) )
+      {
+        // Collect the endpoints sharing the callback, it gets the frame once
+        if ( pMulti == NULL )
+        {
+          pMulti = pList;
+          memset( multiEpMap, 0, sizeof( multiEpMap ) );
+        }
+        multiEpMap[epDesc->endPoint / 8] |= BV( epDesc->endPoint % 8 );
+      }
+      else
+      {
+        // Save original endpoint
+        uint8_t endpoint = aff->DstEndPoint;
 
-      // overwrite with descriptor's endpoint
-      aff->DstEndPoint = epDesc->endPoint;
+        // overwrite with descriptor's endpoint
+        aff->DstEndPoint = epDesc->endPoint;
 
-      afBuildMSGIncoming( aff, epDesc, SrcAddress, SrcPanId, sig,
-                         nwkSeqNum, SecurityUse, timestamp, radius );
+        afBuildMSGIncoming( aff, pList, SrcAddress, SrcPanId, sig,
+                           nwkSeqNum, SecurityUse, timestamp, radius, &pAsdu );
 
-      // Restore with original endpoint
-      aff->DstEndPoint = endpoint;
+        // Restore with original endpoint
+        aff->DstEndPoint = endpoint;
+      }
     }
 
     if ( ((aff->FrmCtrl & APS_DELIVERYMODE_MASK) == APS_FC_DM_GROUP) )
     {
 #if !defined ( APS_NO_GROUPS )
-      // Find the next endpoint for this group
-      grpEp = aps_FindGroupForEndpoint( aff->GroupID, grpEp );
-      if ( grpEp == APS_GROUPS_EP_NOT_FOUND )
-        return;   // No endpoint found
-
-      epDesc = afFindEndPointDesc( grpEp );
-      if ( epDesc == NULL )
-        return;   // Endpoint descriptor not found
-
-      pList = afFindEndPointDescList( epDesc->endPoint );
+      // Next registered endpoint of this group
+      pList = afEpMapNext( pList->nextDesc, grpEpMap );
+      if ( pList )
+        epDesc = pList->epDesc;
+      else
+        epDesc = NULL;
 #else
-      return;
+      break;
 #endif
     }
     else if ( aff->DstEndPoint == AF_BROADCAST_ENDPOINT )
@@ -511,6 +598,18 @@ void afIncomingData( aps_FrameFormat_t *aff, zAddrType_t *SrcAddress, uint16_t S
     else
       epDesc = NULL;
   }
+
+  if ( pMulti != NULL )
+  {
+    afDeliverMulti( aff, pMulti, multiEpMap, SrcAddress, SrcPanId, sig,
+                    nwkSeqNum, SecurityUse, timestamp, radius, &pAsdu );
+  }
+
+  if ( pAsdu != NULL )
+  {
+    // Drop the reference held while delivering, receivers keep their own
+    OsalPort_msgDeallocate( pAsdu );
+  }
 }
 
 /*********************************************************************
@@ -518,24 +617,109 @@ void afIncomingData( aps_FrameFormat_t *aff, zAddrType_t *SrcAddress, uint16_t S
  *
  * @brief       Build the message for the app
  *
+ *              Endpoints with an incoming callback, or intercepted by
+ *              MT, are served synchronously straight from the APS frame.
+ *              Queued messages reference one shared copy of the ASDU,
+ *              made on the first queued delivery and returned through
+ *              ppAsdu.
+ *
  * @param
+ * @param       ppAsdu - in/out shared ASDU copy of this frame
  *
- * @return      pointer to next in data buffer
+ * @return      none
  */
-static void afBuildMSGIncoming( aps_FrameFormat_t *aff, endPointDesc_t *epDesc,
+static void afBuildMSGIncoming( aps_FrameFormat_t *aff, epList_t *pList,
                  zAddrType_t *SrcAddress, uint16_t SrcPanId, NLDE_Signal_t *sig,
-                 uint8_t nwkSeqNum, uint8_t SecurityUse, uint32_t timestamp, uint8_t radius )
+                 uint8_t nwkSeqNum, uint8_t SecurityUse, uint32_t timestamp, uint8_t radius,
+                 uint8_t **ppAsdu )
 {
+  endPointDesc_t *epDesc = pList->epDesc;
   afIncomingMSGPacket_t *MSGpkt;
-  const uint8_t len = sizeof( afIncomingMSGPacket_t ) + aff->asduLength;
   uint8_t *asdu = aff->asdu;
-  MSGpkt = (afIncomingMSGPacket_t *)OsalPort_msgAllocate( len );
+  uint8_t direct = FALSE;
+
+  if ( pList->pfnIncomingCB != NULL )
+  {
+    afIncomingMSGPacket_t pkt;
+
+    afFillMSGIncoming( &pkt, aff, epDesc, SrcAddress, SrcPanId, sig,
+                       nwkSeqNum, SecurityUse, timestamp, radius, aff->asdu );
+
+    if ( pList->pfnIncomingCB( &pkt ) )
+    {
+      return;
+    }
+
+    // Not taken now, queue it to the endpoint's task below
+  }
+
+#if defined ( MT_AF_CB_FUNC )
+  // If ZDO or SAPI have registered for this endpoint, dont intercept it here.
+  // A frame the endpoint's sink declined goes to its task, not on directly.
+  if ( pList->pfnIncomingCB == NULL )
+  {
+    direct = AFCB_CHECK(CB_ID_AF_DATA_IND, *(epDesc->task_id)) ? TRUE : FALSE;
+  }
+#endif
+
+  if ( direct || (aff->asduLength == 0) )
+  {
+    MSGpkt = (afIncomingMSGPacket_t *)OsalPort_msgAllocate( sizeof( afIncomingMSGPacket_t ) );
+  }
+  else
+  {
+    if ( *ppAsdu == NULL )
+    {
+      *ppAsdu = OsalPort_msgAllocate( aff->asduLength );
+      if ( *ppAsdu == NULL )
+      {
+        return;
+      }
+      OsalPort_memcpy( *ppAsdu, aff->asdu, aff->asduLength );
+    }
+
+    asdu = *ppAsdu;
+    MSGpkt = (afIncomingMSGPacket_t *)OsalPort_msgAllocateRef( sizeof( afIncomingMSGPacket_t ), asdu );
+  }
 
   if ( MSGpkt == NULL )
   {
     return;
   }
 
+  afFillMSGIncoming( MSGpkt, aff, epDesc, SrcAddress, SrcPanId, sig,
+                     nwkSeqNum, SecurityUse, timestamp, radius, asdu );
+
+#if defined ( MT_AF_CB_FUNC )
+  if ( direct )
+  {
+    MT_AfIncomingMsg( (void *)MSGpkt );
+    // Release the memory.
+    OsalPort_msgDeallocate( (void *)MSGpkt );
+  }
+  else
+#endif
+  {
+    // Send message through task message.
+    OsalPort_msgSend( *(epDesc->task_id), (uint8_t *)MSGpkt );
+  }
+}
+
+/*********************************************************************
+ * @fn          afFillMSGIncoming
+ *
+ * @brief       Fill an incoming message packet from the APS frame
+ *
+ * @param       MSGpkt - packet to fill
+ * @param       asdu - payload the packet points to
+ *
+ * @return      none
+ */
+static void afFillMSGIncoming( afIncomingMSGPacket_t *MSGpkt, aps_FrameFormat_t *aff,
+                endPointDesc_t *epDesc, zAddrType_t *SrcAddress, uint16_t SrcPanId,
+                NLDE_Signal_t *sig, uint8_t nwkSeqNum, uint8_t SecurityUse,
+                uint32_t timestamp, uint8_t radius, uint8_t *asdu )
+{
   MSGpkt->hdr.event = AF_INCOMING_MSG_CMD;
   MSGpkt->groupId = aff->GroupID;
   MSGpkt->clusterId = aff->ClusterID;
@@ -557,28 +741,229 @@ static void afBuildMSGIncoming( aps_FrameFormat_t *aff, endPointDesc_t *epDesc,
 
   if ( MSGpkt->cmd.DataLength )
   {
-    MSGpkt->cmd.Data = (uint8_t *)(MSGpkt + 1);
-    OsalPort_memcpy( MSGpkt->cmd.Data, asdu, MSGpkt->cmd.DataLength );
+    MSGpkt->cmd.Data = asdu;
   }
   else
   {
     MSGpkt->cmd.Data = NULL;
   }
+}
 
-#if defined ( MT_AF_CB_FUNC )
-  // If ZDO or SAPI have registered for this endpoint, dont intercept it here
-  if (AFCB_CHECK(CB_ID_AF_DATA_IND, *(epDesc->task_id)))
+/*********************************************************************
+ * @fn          afDeliverMulti
+ *
+ * @brief       Hand a frame matched by several endpoints sharing an
+ *              incoming multi callback to that callback once, with the
+ *              map of the matched endpoints.  Delivers it per endpoint
+ *              if only one matched or the callback doesn't take it.
+ *
+ * @param       pList - first matched endpoint
+ * @param       epMap - AF_EP_MAP_LEN bytes, one bit per matched endpoint
+ * @param       ppAsdu - in/out shared ASDU copy of this frame
+ *
+ * @return      none
+ */
+static void afDeliverMulti( aps_FrameFormat_t *aff, epList_t *pList, uint8_t *epMap,
+                zAddrType_t *SrcAddress, uint16_t SrcPanId, NLDE_Signal_t *sig,
+                uint8_t nwkSeqNum, uint8_t SecurityUse, uint32_t timestamp, uint8_t radius,
+                uint8_t **ppAsdu )
+{
+  afIncomingMSGPacket_t MSGpkt;
+  endPointDesc_t *epDesc;
+  uint8_t endpoint;
+  uint8_t epMapLen = 0;
+  uint8_t epCnt = 0;
+  uint16_t ep;
+
+  for ( ep = 0; ep < (AF_EP_MAP_LEN * 8); ep++ )
   {
-    MT_AfIncomingMsg( (void *)MSGpkt );
-    // Release the memory.
-    OsalPort_msgDeallocate( (void *)MSGpkt );
+    if ( epMap[ep / 8] & BV( ep % 8 ) )
+    {
+      epMapLen = (uint8_t)((ep / 8) + 1);
+      epCnt++;
+    }
   }
-  else
+
+  if ( epCnt > 1 )
+  {
+    afFillMSGIncoming( &MSGpkt, aff, pList->epDesc, SrcAddress, SrcPanId, sig,
+                       nwkSeqNum, SecurityUse, timestamp, radius, aff->asdu );
+
+    if ( pList->pfnIncomingMultiCB( &MSGpkt, epMap, epMapLen ) )
+    {
+      return;
+    }
+  }
+
+  // Single endpoint or not taken, deliver per endpoint
+  endpoint = aff->DstEndPoint;
+  for ( ep = 0; ep < (uint16_t)(epMapLen * 8); ep++ )
+  {
+    if ( (epMap[ep / 8] & BV( ep % 8 )) &&
+         ((epDesc = afFindEndPointDesc( (uint8_t)ep )) != NULL) )
+    {
+      aff->DstEndPoint = epDesc->endPoint;
+      afBuildMSGIncoming( aff, afFindEndPointDescList( epDesc->endPoint ), SrcAddress,
+                          SrcPanId, sig, nwkSeqNum, SecurityUse, timestamp, radius, ppAsdu );
+    }
+  }
+  aff->DstEndPoint = endpoint;
+}
+
+/*********************************************************************
+ * @fn          afProfileAcceptEp
+ *
+ * @brief       Look up which endpoint accepts a received profile ID
+ *              even though it does not match its own profile.
+ *
+ * @param       profileID - received profile ID
+ *
+ * @return      endpoint, AF_PROFILE_RULE_ANY_EP or AF_PROFILE_RULE_NO_EP
+ */
+static uint8_t afProfileAcceptEp( uint16_t profileID )
+{
+  uint8_t x;
+
+  // Messages specifically sent to ZDO (this excludes the broadcast endpoint)
+  if ( profileID == ZDO_PROFILE_ID )
+  {
+    return ( ZDO_EP );
+  }
+
+  // Wildcard ProfileID is not sent to the ZDO endpoint
+  if ( profileID == ZDO_WILDCARD_PROFILE_ID )
+  {
+    return ( AF_PROFILE_RULE_ANY_EP );
+  }
+
+  for ( x = 0; x < afProfileRulesCnt; x++ )
+  {
+    if ( afProfileRules[x].profileID == profileID )
+    {
+      return ( afProfileRules[x].endPoint );
+    }
+  }
+
+  return ( (afProfilePolicy == AF_PROFILE_POLICY_ACCEPT_ALL) ? AF_PROFILE_RULE_ANY_EP
+                                                             : AF_PROFILE_RULE_NO_EP );
+}
+
+#if !defined ( APS_NO_GROUPS )
+/*********************************************************************
+ * @fn          afGroupEpMap
+ *
+ * @brief       Collect the endpoints of a group in one pass over the
+ *              group table.
+ *
+ * @param       groupID - received group ID
+ * @param       epMap - AF_EP_MAP_LEN bytes, one bit per endpoint
+ *
+ * @return      number of group table entries for the group
+ */
+static uint8_t afGroupEpMap( uint16_t groupID, uint8_t *epMap )
+{
+  apsGroupItem_t *pItem;
+  uint8_t cnt = 0;
+
+  memset( epMap, 0, AF_EP_MAP_LEN );
+
+  for ( pItem = apsGroupTable; pItem != NULL; pItem = pItem->next )
+  {
+    if ( pItem->group.ID == groupID )
+    {
+      epMap[pItem->endpoint / 8] |= BV( pItem->endpoint % 8 );
+      cnt++;
+    }
+  }
+
+  return ( cnt );
+}
+
+/*********************************************************************
+ * @fn          afEpMapNext
+ *
+ * @brief       Find the next registered endpoint set in an endpoint map.
+ *
+ * @param       pList - endpoint list entry to start from
+ * @param       epMap - AF_EP_MAP_LEN bytes, one bit per endpoint
+ *
+ * @return      endpoint list entry, NULL if none left
+ */
+static epList_t *afEpMapNext( epList_t *pList, uint8_t *epMap )
+{
+  uint8_t ep;
+
+  for ( ; pList != NULL; pList = pList->nextDesc )
+  {
+    ep = pList->epDesc->endPoint;
+    if ( epMap[ep / 8] & BV( ep % 8 ) )
+    {
+      break;
+    }
+  }
+
+  return ( pList );
+}
+
 #endif
+
+/*********************************************************************
+ * @fn          afSetUnknownGroupEp
+ *
+ * @brief       Set the endpoint getting groupcasts for groups that no
+ *              local endpoint is a member of.
+ *
+ * @param       endPoint - endpoint, AF_UNKNOWN_GROUP_DROP to drop them
+ *
+ * @return      none
+ */
+void afSetUnknownGroupEp( uint8_t endPoint )
+{
+#if !defined ( APS_NO_GROUPS )
+  afUnknownGroupEp = endPoint;
+#else
+  (void)endPoint;
+#endif
+}
+
+/*********************************************************************
+ * @fn          afSetProfileRules
+ *
+ * @brief       Replace the incoming profile acceptance rules.
+ *
+ * @param       policy - AF_PROFILE_POLICY_MATCH or AF_PROFILE_POLICY_ACCEPT_ALL
+ *                       for profiles without a rule, AF_PROFILE_POLICY_DEFAULT
+ *                       to restore the built-in rules (pRules is ignored)
+ * @param       numRules - number of rules in pRules
+ * @param       pRules - rules, one per profile ID
+ *
+ * @return      afStatus_SUCCESS, afStatus_INVALID_PARAMETER
+ */
+afStatus_t afSetProfileRules( uint8_t policy, uint8_t numRules, afProfileRule_t *pRules )
+{
+  if ( policy == AF_PROFILE_POLICY_DEFAULT )
   {
-    // Send message through task message.
-    OsalPort_msgSend( *(epDesc->task_id), (uint8_t *)MSGpkt );
+    afProfileRulesCnt = sizeof( afProfileRulesDefault ) / sizeof( afProfileRule_t );
+    OsalPort_memcpy( afProfileRules, afProfileRulesDefault, sizeof( afProfileRulesDefault ) );
+    afProfilePolicy = AF_PROFILE_POLICY_MATCH;
+
+    return ( afStatus_SUCCESS );
   }
+
+  if ( ((policy != AF_PROFILE_POLICY_MATCH) && (policy != AF_PROFILE_POLICY_ACCEPT_ALL)) ||
+       (numRules > AF_PROFILE_RULES_MAX) || ((numRules != 0) && (pRules == NULL)) )
+  {
+    return ( afStatus_INVALID_PARAMETER );
+  }
+
+  if ( numRules != 0 )
+  {
+    OsalPort_memcpy( afProfileRules, pRules, numRules * sizeof( afProfileRule_t ) );
+  }
+  afProfileRulesCnt = numRules;
+  afProfilePolicy = policy;
+
+  return ( afStatus_SUCCESS );
 }
 
 /*********************************************************************
@@ -615,6 +1000,7 @@ afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
   APSDE_DataReq_t req;
   afDataReqMTU_t mtu;
   epList_t *pList;
+  uint8_t srcRoute = TRUE;
 
   // Verify source end point
   if ( srcEP == NULL )
@@ -733,6 +1119,53 @@ afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
     req.txOptions |=  APS_TX_OPTIONS_PREPROCESS;
   }
 
+  // Host loaded quirks of a unicast destination
+  if ( (req.dstAddr.addrMode == Addr16Bit) || (req.dstAddr.addrMode == Addr64Bit) )
+  {
+    uint8_t quirks = ( req.dstAddr.addrMode == Addr64Bit )
+                       ? ZQuirkLookupExt( req.dstAddr.addr.extAddr )
+                       : ZQuirkLookupNwk( req.dstAddr.addr.shortAddr );
+
+    if ( quirks & ZQUIRK_APS_ACK )
+    {
+      req.txOptions |= APS_TX_OPTIONS_ACK;
+    }
+    else if ( quirks & ZQUIRK_NO_APS_ACK )
+    {
+      req.txOptions &= ~APS_TX_OPTIONS_ACK;
+    }
+
+    if ( (quirks & ZQUIRK_NO_SRC_ROUTE) && (req.dstAddr.addrMode == Addr16Bit) )
+    {
+      associated_devices_t *pAssoc = AssocGetWithShort( req.dstAddr.addr.shortAddr );
+
+      // Only a child is one hop away, other association entries are not
+      if ( (pAssoc != NULL) && (pAssoc->nodeRelation >= CHILD_RFD)
+          && (pAssoc->nodeRelation <= CHILD_FFD_RX_IDLE) )
+      {
+        req.txOptions |= APS_TX_OPTIONS_SKIP_ROUTING;
+      }
+      else
+      {
+        // Several hops away, routed hop by hop without a kept source route
+        srcRoute = FALSE;
+      }
+    }
+  }
+
+#if defined ( RTG_SRC_TREE )
+  // A source route that fell out of the source route table is put back
+  // from the relay store rather than discovering a route again
+  if ( ZSTACK_ROUTER_BUILD && srcRoute && (req.dstAddr.addrMode == Addr16Bit) &&
+       ((req.txOptions & APS_TX_OPTIONS_SKIP_ROUTING) == 0) &&
+       (req.dstAddr.addr.shortAddr != NLME_GetShortAddr()) )
+  {
+    (void)RTG_SrcTreeRestore( req.dstAddr.addr.shortAddr );
+  }
+#else
+  (void)srcRoute;  // Only read for the relay store
+#endif
+
   mtu.kvp = FALSE;
 
   if ( options & AF_SUPRESS_ROUTE_DISC_NETWORK )
@@ -813,6 +1246,14 @@ afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
 
   if ( stat == afStatus_SUCCESS )
   {
+#if defined ( RTG_SRC_TREE )
+    // Check the delivery over a kept source route in the data confirm
+    if ( ZSTACK_ROUTER_BUILD && (req.dstAddr.addrMode == Addr16Bit) )
+    {
+      RTG_SrcTreeSent( req.dstAddr.addr.shortAddr, srcEP->endPoint, *transID );
+    }
+#endif
+
     (*transID)++;
   }
 
@@ -852,6 +1293,12 @@ afStatus_t AF_DataRequestSrcRtg( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
 {
   uint8_t status;
 
+  /* A device with the no source route quirk is routed hop by hop */
+  if ( ZQuirkLookupNwk( dstAddr->addr.shortAddr ) & ZQUIRK_NO_SRC_ROUTE )
+  {
+    return AF_DataRequest( dstAddr, srcEP, cID, len, buf, transID, options, radius );
+  }
+
   /* Add the source route to the source routing table */
   status = RTG_AddSrcRtgEntry_Guaranteed( dstAddr->addr.shortAddr, relayCnt,
                                          pRelayList );
@@ -1257,5 +1704,80 @@ uint8_t afSetApplCB( uint8_t endPoint, pApplCB pApplFn )
   return ( FALSE );
 }
 
+/*********************************************************************
+ * @fn          afSetIncomingCB
+ *
+ * @brief       Sets the callback function taking incoming data for a
+ *              specific EndPoint synchronously, from the context that
+ *              received it.  The endpoint's task still gets the data
+ *              that the callback doesn't take.
+ *
+ * input parameters
+ *
+ * @param       endPoint - The specific EndPoint for which to set the callback.
+ * @param       pIncomingFn - A pointer to the callback function, NULL to
+ *                            queue all incoming data to the task again.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      TRUE if success, FALSE if endpoint not found
+ */
+uint8_t afSetIncomingCB( uint8_t endPoint, pIncomingCB pIncomingFn )
+{
+  epList_t *epSearch;
+
+  // Look for the endpoint
+  epSearch = afFindEndPointDescList( endPoint );
+
+  if ( epSearch )
+  {
+    epSearch->pfnIncomingCB = pIncomingFn;
+
+    return ( TRUE );
+  }
+
+  return ( FALSE );
+}
+
+/*********************************************************************
+ * @fn          afSetIncomingMultiCB
+ *
+ * @brief       Sets the callback function taking a groupcast or
+ *              broadcast endpoint frame once for all the endpoints it
+ *              matches.  The endpoints registering the same function
+ *              are served by one call.  What the callback doesn't take
+ *              is delivered per endpoint.
+ *
+ * input parameters
+ *
+ * @param       endPoint - The specific EndPoint for which to set the callback.
+ * @param       pIncomingMultiFn - A pointer to the callback function, NULL
+ *                                 to deliver per endpoint.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      TRUE if success, FALSE if endpoint not found
+ */
+uint8_t afSetIncomingMultiCB( uint8_t endPoint, pIncomingMultiCB pIncomingMultiFn )
+{
+  epList_t *epSearch;
+
+  // Look for the endpoint
+  epSearch = afFindEndPointDescList( endPoint );
+
+  if ( epSearch )
+  {
+    epSearch->pfnIncomingMultiCB = pIncomingMultiFn;
+
+    return ( TRUE );
+  }
+
+  return ( FALSE );
+}
+
 /**************************************************************************************************
 */
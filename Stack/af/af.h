@@ -76,6 +76,24 @@ extern "C"
 // Default Radius Count value
 #define AF_DEFAULT_RADIUS                  DEF_NWK_RADIUS
 
+// Incoming profile acceptance rules, see afSetProfileRules()
+#if !defined ( AF_PROFILE_RULES_MAX )
+  #define AF_PROFILE_RULES_MAX             8
+#endif
+#define AF_PROFILE_RULE_ANY_EP             0xFF   // Accepted by every application endpoint
+#define AF_PROFILE_RULE_NO_EP              0xFE   // Only accepted on a profile match
+
+#define AF_PROFILE_POLICY_MATCH            0x00   // Unlisted profiles need a profile match
+#define AF_PROFILE_POLICY_ACCEPT_ALL       0x01   // Unlisted profiles go to every application endpoint
+#define AF_PROFILE_POLICY_DEFAULT          0xFF   // Restore the built-in rules
+
+// Endpoint getting groupcasts for groups no local endpoint is a member of,
+// see afSetUnknownGroupEp().  Endpoint 1 forwards all group traffic to the host.
+#if !defined ( AF_UNKNOWN_GROUP_EP )
+  #define AF_UNKNOWN_GROUP_EP              1
+#endif
+#define AF_UNKNOWN_GROUP_DROP              0x00   // Drop groupcasts for unknown groups
+
 /*********************************************************************
  * Node Descriptor
  */
@@ -313,6 +331,20 @@ typedef void *(*pDescCB)( uint8_t type, uint8_t endpoint );
 //   is not duplicated of a pending message.
 typedef void (*pApplCB)( APSDE_DataReq_t *req );
 
+// Typedef for a callback function taking incoming data for an endpoint
+//   synchronously, instead of an AF_INCOMING_MSG_CMD message queued to
+//   the endpoint's task.  The packet and its data only live during the
+//   call.  Returns FALSE when the message can't be taken now, the message
+//   is then queued to the task as usual.
+typedef uint8_t (*pIncomingCB)( afIncomingMSGPacket_t *pkt );
+
+// Typedef for a callback function taking a frame sent to several
+//   endpoints (groupcast or broadcast endpoint) once for all of them.
+//   epMap has bit n of byte n/8 set for each matched endpoint n.  The
+//   packet lives during the call only.  Returns FALSE when the frame
+//   can't be taken this way, it is then delivered per endpoint.
+typedef uint8_t (*pIncomingMultiCB)( afIncomingMSGPacket_t *pkt, uint8_t *epMap, uint8_t epMapLen );
+
 // Descriptor types used in the above callback
 #define AF_DESCRIPTOR_SIMPLE            1
 #define AF_DESCRIPTOR_PROFILE_ID        2
@@ -336,6 +368,8 @@ typedef struct _epList_t {
   afAPSF_Config_t apsfCfg;
   eEP_Flags flags;
   pApplCB pfnApplCB;    // Don't use it if it has not been set to a valid function pointer by the application
+  pIncomingCB pfnIncomingCB;  // Don't use if this function pointer is NULL.
+  pIncomingMultiCB pfnIncomingMultiCB;  // Don't use if this function pointer is NULL.
 } epList_t;
 
 /*********************************************************************
@@ -356,6 +390,13 @@ typedef struct
   APSDE_DataReqMTU_t aps;
 } afDataReqMTU_t;
 
+// Accept frames with profileID on endPoint regardless of its own profile
+typedef struct
+{
+  uint16_t profileID;
+  uint8_t  endPoint;     // Endpoint or AF_PROFILE_RULE_ANY_EP
+} afProfileRule_t;
+
 /*********************************************************************
  * Globals
  */
@@ -513,6 +554,30 @@ afStatus_t afAPSF_ConfigSet(uint8_t endPoint, afAPSF_Config_t *pCfg);
   */
 uint8_t afSetApplCB( uint8_t endPoint, pApplCB pApplFn );
 
+ /*
+  *	afSetIncomingCB - Sets the callback function taking incoming data
+  *               synchronously for a specific EndPoint.
+  */
+uint8_t afSetIncomingCB( uint8_t endPoint, pIncomingCB pIncomingFn );
+
+ /*
+  *	afSetIncomingMultiCB - Sets the callback function taking a frame once
+  *               for all the endpoints it matches.
+  */
+uint8_t afSetIncomingMultiCB( uint8_t endPoint, pIncomingMultiCB pIncomingMultiFn );
+
+ /*
+  *	afSetProfileRules - replace the incoming profile acceptance rules and
+  *                     the policy for profiles without a rule.
+  */
+afStatus_t afSetProfileRules( uint8_t policy, uint8_t numRules, afProfileRule_t *pRules );
+
+ /*
+  *	afSetUnknownGroupEp - set the endpoint getting groupcasts for groups
+  *                     without local members, AF_UNKNOWN_GROUP_DROP to drop them.
+  */
+void afSetUnknownGroupEp( uint8_t endPoint );
+
 #ifdef __cplusplus
 }
 #endif
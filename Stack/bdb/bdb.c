@@ -56,7 +56,9 @@
 #include "zcl.h"
 #include "bdb_interface.h"
 #include "zstack.h"
+#include "zevtlog.h"
 #include "zglobals.h"
+#include "zd_nwk_mgr.h"
 
 #ifdef BDB_REPORTING
 #include "bdb_reporting.h"
@@ -220,6 +222,9 @@ static void gp_CBInit(void);
 static void bdb_TCProcessJoiningList(void);
 static ZStatus_t bdb_TCJoiningDeviceFree(bdb_joiningDeviceList_t* JoiningDeviceToRemove);
 #endif
+#if defined ( ZIGBEE_FREQ_AGILITY )
+static void bdb_nwkFormationChanEvalCB(uint8_t channel);
+#endif
 #if (ZG_BUILD_COORDINATOR_TYPE)
 static bdbGCB_TCLinkKeyExchangeProcess_t  pfnTCLinkKeyExchangeProcessCB = NULL;
 #endif
@@ -695,10 +700,13 @@ void bdb_TCProcessJoiningList(void)
         //search for the entry in the TCLK table
         keyNvIndex = APSME_SearchTCLinkKeyEntry(tempJoiningDescNode->bdbJoiningNodeEui64,&found, &TCLKDevEntry);
 
-        uint16_t nwkAddr;
+        uint16_t nwkAddr = INVALID_NODE_ADDR;
         //Look up nwkAddr before it is cleared by ZDSecMgrAddrClear
         AddrMgrNwkAddrLookup(tempJoiningDescNode->bdbJoiningNodeEui64, &nwkAddr);
 
+        ZEvtLogAdd(ZEVTLOG_TYPE_TC_KEY_EXCH, BDB_TC_LK_EXCH_PROCESS_EXCH_FAIL, 0,
+                   nwkAddr, tempJoiningDescNode->bdbJoiningNodeEui64);
+
         //Erase all the keys that got expired and did not update the key, except for those using an install code as long as TC is not mandating the key update.
         //These devices will keep their install code and may send APS encrypted msgs to TC.
         if(isTCLKExchangeRequired || (TCLKDevEntry.keyAttributes != ZG_PROVISIONAL_KEY) )
@@ -773,6 +781,12 @@ void bdb_TCjoiningDeviceComplete(uint8_t* JoiningExtAddr)
     {
       if(OsalPort_memcmp(tempJoiningDescNode->bdbJoiningNodeEui64,JoiningExtAddr,Z_EXTADDR_LEN))
       {
+        uint16_t nwkAddr = INVALID_NODE_ADDR;
+
+        AddrMgrNwkAddrLookup(tempJoiningDescNode->bdbJoiningNodeEui64, &nwkAddr);
+        ZEvtLogAdd(ZEVTLOG_TYPE_TC_KEY_EXCH, BDB_TC_LK_EXCH_PROCESS_EXCH_SUCCESS, 0,
+                   nwkAddr, tempJoiningDescNode->bdbJoiningNodeEui64);
+
         if(pfnTCLinkKeyExchangeProcessCB)
         {
           bdb_TCLinkKeyExchProcess_t bdb_TCLinkKeyExchProcess;
@@ -2180,6 +2194,45 @@ void bdb_setChannel(uint32_t channel)
 }
 
 
+ #if defined ( ZIGBEE_FREQ_AGILITY )
+ /*********************************************************************
+ * @fn          bdb_nwkFormationChanEvalCB
+ *
+ * @brief       Form the network on the channel picked by the formation
+ *              channel evaluation
+ *
+ * @param       channel - picked channel, 0 to form on the whole mask
+ *
+ * @return      none
+ */
+static void bdb_nwkFormationChanEvalCB(uint8_t channel)
+{
+  if(channel != 0)
+  {
+    bdb_setChannel((uint32_t)1 << channel);
+  }
+
+#ifdef MT_APP_CNF_FUNC
+  //Report the scores to the host processor
+  MT_AppCnfBDBChanEvalNotification(channel);
+#endif
+
+  //Commissioning may have been stopped while evaluating
+  if(bdbCommissioningProcedureState.bdbCommissioningState == BDB_COMMISSIONING_STATE_FORMATION)
+  {
+    //Same as bdb_nwkJoiningFormation(FALSE): ZR forms a distributed network, ZC a centralized one
+    if(ZG_DEVICE_RTRONLY_TYPE)
+    {
+      ZDOInitDeviceEx(100,1);
+    }
+    else
+    {
+      ZDOInitDeviceEx(100,0);
+    }
+  }
+}
+#endif
+
  /*********************************************************************
  * @fn          bdb_nwkJoiningFormation
  *
@@ -2204,6 +2257,14 @@ void bdb_nwkJoiningFormation(bool isJoining)
 
   if(vScanChannels)
   {
+#if defined ( ZIGBEE_FREQ_AGILITY )
+    //Narrow the mask down to the least interfered channel before forming
+    if(!isJoining && ZDNwkMgr_ChanEvalStart(vScanChannels, bdb_nwkFormationChanEvalCB))
+    {
+      return;
+    }
+#endif
+
     if(ZG_DEVICE_RTRONLY_TYPE)
     {
       if(isJoining)
@@ -0,0 +1,569 @@
+/**************************************************************************************************
+  Filename:       nwk_childage.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Deadline ordered end device child aging.  The children
+                  are kept in a min-heap by the time they age out.  A poll
+                  or keep alive moves one child down the heap, and an
+                  aging tick only looks at the children that are due
+                  instead of counting down every association list entry.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "rom_jt_154.h"
+#include "addr_mgr.h"
+#include "nwk_globals.h"
+#include "nwk_util.h"
+#include "assoc_list.h"
+#include "nwk_childage.h"
+
+/*********************************************************************
+ * MACROS
+ */
+#define NWK_CHILD_AGE_IS_CHILD( pDev )                                     \
+  ( ((pDev)->shortAddr != INVALID_NODE_ADDR) &&                            \
+    (((pDev)->nodeRelation == CHILD_RFD) ||                                \
+     ((pDev)->nodeRelation == CHILD_RFD_RX_IDLE)) &&                       \
+    ((pDev)->endDev.deviceTimeout != 0) &&                                 \
+    ((pDev)->endDev.deviceTimeout != TIMEOUT_NOT_USED) )
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define NWK_CHILD_AGE_NONE        0xFFFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint32_t deadline;    // Seconds clock the child ages out at
+  uint32_t timeout;     // Negotiated timeout it was scheduled with
+  uint16_t devIdx;      // Association list entry
+  uint16_t shortAddr;   // Child the entry was scheduled for
+} nwkChildAgeEntry_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+void (*pNwkChildAgedCB)( uint16_t nwkAddr, uint8_t *extAddr ) = NULL;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static nwkChildAgeEntry_t NwkChildAge_Heap[NWK_MAX_DEVICES];
+static uint16_t NwkChildAge_Pos[NWK_MAX_DEVICES];
+static uint16_t NwkChildAge_Cnt = 0;
+static uint16_t NwkChildAge_Cursor = 0;
+static uint16_t NwkChildAge_Aged = 0;
+static uint8_t NwkChildAge_Active = FALSE;
+
+// Seconds clock, kept from the system clock whatever the tick rate
+static uint32_t NwkChildAge_Now = 0;
+static uint32_t NwkChildAge_LastClock = 0;
+static uint32_t NwkChildAge_MSec = 0;
+
+// Refresh of the NWK layer, run before moving the child in the heap
+static uint8_t (*NwkChildAge_LibRefresh)( uint16_t nwkAddr ) = NULL;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void NwkChildAge_Tick( void );
+static uint8_t NwkChildAge_Refresh( uint16_t nwkAddr );
+static void NwkChildAge_Clock( void );
+static void NwkChildAge_SyncSlot( uint16_t devIdx, uint8_t refresh );
+static void NwkChildAge_Swap( uint16_t a, uint16_t b );
+static void NwkChildAge_Up( uint16_t i );
+static void NwkChildAge_Down( uint16_t i );
+static void NwkChildAge_HeapSet( uint16_t devIdx, uint32_t timeout );
+static void NwkChildAge_HeapRemove( uint16_t i );
+static uint8_t NwkChildAge_TimeoutIdx( uint32_t timeout );
+
+/****************************************************************************
+ * @fn          NwkChildAge_Init
+ *
+ * @brief       Take over the child aging tick and timeout refresh of the
+ *              NWK layer.  Call after NwkInitChildAging(), nothing is
+ *              taken over when that didn't enable the child aging.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+void NwkChildAge_Init( void )
+{
+  uint16_t x;
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    NwkChildAge_Pos[x] = NWK_CHILD_AGE_NONE;
+  }
+
+  NwkChildAge_Cnt = 0;
+  NwkChildAge_Cursor = 0;
+  NwkChildAge_Now = 0;
+  NwkChildAge_MSec = 0;
+  NwkChildAge_LastClock = MAP_osal_GetSystemClock();
+
+  if ( (pAssocChildAging != NULL) && (pAssocChildTableUpdateTimeout != NULL) )
+  {
+    NwkChildAge_LibRefresh = pAssocChildTableUpdateTimeout;
+    pAssocChildTableUpdateTimeout = NwkChildAge_Refresh;
+    pAssocChildAging = NwkChildAge_Tick;
+    NwkChildAge_Active = TRUE;
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_Clock
+ *
+ * @brief       Advance the seconds clock to the system clock.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void NwkChildAge_Clock( void )
+{
+  uint32_t clock = MAP_osal_GetSystemClock();
+
+  NwkChildAge_MSec += clock - NwkChildAge_LastClock;
+  NwkChildAge_LastClock = clock;
+
+  NwkChildAge_Now += NwkChildAge_MSec / 1000;
+  NwkChildAge_MSec %= 1000;
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_Tick
+ *
+ * @brief       Aging tick, replaces AssocChildAging().  Checks a few more
+ *              association list entries, then ages out the children that
+ *              are due.  An aged out child goes to the not my child list,
+ *              so it is told to leave when it polls again, its association
+ *              and neighbor entries are removed and ZDO is told.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void NwkChildAge_Tick( void )
+{
+  nwkChildAgeEntry_t *pTop;
+  associated_devices_t *pDev;
+  uint8_t extAddr[Z_EXTADDR_LEN];
+  uint8_t *pExtAddr;
+  uint16_t shortAddr;
+  uint8_t n;
+
+  NwkChildAge_Clock();
+
+  for ( n = 0; n < NWK_CHILD_AGE_SYNC_SLOTS; n++ )
+  {
+    NwkChildAge_SyncSlot( NwkChildAge_Cursor, FALSE );
+    if ( ++NwkChildAge_Cursor >= NWK_MAX_DEVICES )
+    {
+      NwkChildAge_Cursor = 0;
+    }
+  }
+
+  while ( (NwkChildAge_Cnt > 0) && (NwkChildAge_Heap[0].deadline <= NwkChildAge_Now) )
+  {
+    pTop = &NwkChildAge_Heap[0];
+    pDev = &AssociatedDevList[pTop->devIdx];
+    shortAddr = pTop->shortAddr;
+
+    NwkChildAge_HeapRemove( 0 );
+
+    if ( (pDev->shortAddr != shortAddr) || !NWK_CHILD_AGE_IS_CHILD( pDev ) )
+    {
+      // Left or replaced since it was scheduled
+      continue;
+    }
+
+    pDev->timeoutCounter = 0;
+    NwkChildAge_Aged++;
+
+    if ( pNwkNotMyChildListAdd != NULL )
+    {
+      (void)pNwkNotMyChildListAdd( shortAddr, pDev->endDev.deviceTimeout );
+    }
+
+    pExtAddr = AddrMgrExtAddrLookup( shortAddr, extAddr ) ? extAddr : NULL;
+
+    // Without its IEEE address the entry is freed in place
+    if ( (pExtAddr == NULL) || (AssocRemove( pExtAddr ) == FALSE) )
+    {
+      pDev->shortAddr = INVALID_NODE_ADDR;
+      pDev->nodeRelation = NOTUSED;
+    }
+    nwkNeighborRemove( shortAddr, _NIB.nwkPanId );
+
+    if ( pNwkChildAgedCB != NULL )
+    {
+      pNwkChildAgedCB( shortAddr, pExtAddr );
+    }
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_Refresh
+ *
+ * @brief       Timeout refresh on a poll or keep alive, replaces
+ *              AssocChildTableUpdateTimeout().
+ *
+ * @param       nwkAddr - child heard from
+ *
+ * @return      status of the NWK layer refresh
+ */
+static uint8_t NwkChildAge_Refresh( uint16_t nwkAddr )
+{
+  associated_devices_t *pDev;
+  uint8_t status;
+
+  status = NwkChildAge_LibRefresh( nwkAddr );
+
+  pDev = AssocGetWithShort( nwkAddr );
+  if ( pDev != NULL )
+  {
+    NwkChildAge_Clock();
+    NwkChildAge_SyncSlot( (uint16_t)(pDev - AssociatedDevList), TRUE );
+  }
+
+  return ( status );
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_Sync
+ *
+ * @brief       Schedule a child that just joined or rejoined.
+ *
+ * @param       nwkAddr - child
+ *
+ * @return      none
+ */
+void NwkChildAge_Sync( uint16_t nwkAddr )
+{
+  associated_devices_t *pDev;
+
+  if ( NwkChildAge_Active )
+  {
+    pDev = AssocGetWithShort( nwkAddr );
+    if ( pDev != NULL )
+    {
+      NwkChildAge_Clock();
+      NwkChildAge_SyncSlot( (uint16_t)(pDev - AssociatedDevList), TRUE );
+    }
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_SyncSlot
+ *
+ * @brief       Bring the heap in line with an association list entry.
+ *
+ * @param       devIdx - association list entry
+ * @param       refresh - TRUE if the child was just heard from, FALSE to
+ *                        only schedule it when it isn't yet
+ *
+ * @return      none
+ */
+static void NwkChildAge_SyncSlot( uint16_t devIdx, uint8_t refresh )
+{
+  associated_devices_t *pDev = &AssociatedDevList[devIdx];
+  uint16_t i = NwkChildAge_Pos[devIdx];
+
+  if ( NWK_CHILD_AGE_IS_CHILD( pDev ) && (refresh || (pDev->timeoutCounter != 0)) )
+  {
+    if ( refresh || (i == NWK_CHILD_AGE_NONE) ||
+         (NwkChildAge_Heap[i].shortAddr != pDev->shortAddr) ||
+         (NwkChildAge_Heap[i].timeout != pDev->endDev.deviceTimeout) )
+    {
+      NwkChildAge_HeapSet( devIdx, pDev->endDev.deviceTimeout );
+    }
+  }
+  else if ( i != NWK_CHILD_AGE_NONE )
+  {
+    NwkChildAge_HeapRemove( i );
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_HeapSet
+ *
+ * @brief       Schedule an association list entry to age out after its
+ *              timeout, adding it to the heap or moving it.
+ *
+ * @param       devIdx - association list entry
+ * @param       timeout - negotiated timeout, seconds
+ *
+ * @return      none
+ */
+static void NwkChildAge_HeapSet( uint16_t devIdx, uint32_t timeout )
+{
+  nwkChildAgeEntry_t *pEntry;
+  uint16_t i = NwkChildAge_Pos[devIdx];
+  uint8_t added = FALSE;
+  uint32_t old = 0;
+
+  if ( i == NWK_CHILD_AGE_NONE )
+  {
+    i = NwkChildAge_Cnt++;
+    NwkChildAge_Pos[devIdx] = i;
+    added = TRUE;
+  }
+
+  pEntry = &NwkChildAge_Heap[i];
+  if ( !added )
+  {
+    old = pEntry->deadline;
+  }
+
+  pEntry->deadline = NwkChildAge_Now + timeout;
+  pEntry->timeout = timeout;
+  pEntry->devIdx = devIdx;
+  pEntry->shortAddr = AssociatedDevList[devIdx].shortAddr;
+
+  if ( added || (pEntry->deadline < old) )
+  {
+    NwkChildAge_Up( i );
+  }
+  else
+  {
+    NwkChildAge_Down( i );
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_HeapRemove
+ *
+ * @brief       Remove a heap entry.
+ *
+ * @param       i - heap index
+ *
+ * @return      none
+ */
+static void NwkChildAge_HeapRemove( uint16_t i )
+{
+  uint16_t last = --NwkChildAge_Cnt;
+
+  NwkChildAge_Pos[NwkChildAge_Heap[i].devIdx] = NWK_CHILD_AGE_NONE;
+
+  if ( i != last )
+  {
+    NwkChildAge_Heap[i] = NwkChildAge_Heap[last];
+    NwkChildAge_Pos[NwkChildAge_Heap[i].devIdx] = i;
+
+    NwkChildAge_Up( i );
+    NwkChildAge_Down( NwkChildAge_Pos[NwkChildAge_Heap[i].devIdx] );
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_Swap
+ *
+ * @brief       Swap two heap entries.
+ *
+ * @param       a, b - heap indexes
+ *
+ * @return      none
+ */
+static void NwkChildAge_Swap( uint16_t a, uint16_t b )
+{
+  nwkChildAgeEntry_t tmp = NwkChildAge_Heap[a];
+
+  NwkChildAge_Heap[a] = NwkChildAge_Heap[b];
+  NwkChildAge_Heap[b] = tmp;
+
+  NwkChildAge_Pos[NwkChildAge_Heap[a].devIdx] = a;
+  NwkChildAge_Pos[NwkChildAge_Heap[b].devIdx] = b;
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_Up
+ *
+ * @brief       Move a heap entry up to its place.
+ *
+ * @param       i - heap index
+ *
+ * @return      none
+ */
+static void NwkChildAge_Up( uint16_t i )
+{
+  uint16_t parent;
+
+  while ( i > 0 )
+  {
+    parent = ( i - 1 ) / 2;
+    if ( NwkChildAge_Heap[parent].deadline <= NwkChildAge_Heap[i].deadline )
+    {
+      break;
+    }
+    NwkChildAge_Swap( i, parent );
+    i = parent;
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_Down
+ *
+ * @brief       Move a heap entry down to its place.
+ *
+ * @param       i - heap index
+ *
+ * @return      none
+ */
+static void NwkChildAge_Down( uint16_t i )
+{
+  uint16_t child;
+
+  for ( ;; )
+  {
+    child = ( 2 * i ) + 1;
+    if ( child >= NwkChildAge_Cnt )
+    {
+      break;
+    }
+
+    if ( ((child + 1) < NwkChildAge_Cnt) &&
+         (NwkChildAge_Heap[child + 1].deadline < NwkChildAge_Heap[child].deadline) )
+    {
+      child++;
+    }
+
+    if ( NwkChildAge_Heap[i].deadline <= NwkChildAge_Heap[child].deadline )
+    {
+      break;
+    }
+
+    NwkChildAge_Swap( i, child );
+    i = child;
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_Deadline
+ *
+ * @brief       Get when an association list entry ages out.  A poll or
+ *              keep alive moves it later.
+ *
+ * @param       devIdx - association list entry
+ *
+ * @return      seconds clock it ages out at, 0 if it isn't aged here
+ */
+uint32_t NwkChildAge_Deadline( uint16_t devIdx )
+{
+  if ( (devIdx >= NWK_MAX_DEVICES) || (NwkChildAge_Pos[devIdx] == NWK_CHILD_AGE_NONE) )
+  {
+    return ( 0 );
+  }
+
+  return ( NwkChildAge_Heap[NwkChildAge_Pos[devIdx]].deadline );
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_TimeoutIdx
+ *
+ * @brief       Map a negotiated timeout back to its timeoutValue[] entry.
+ *
+ * @param       timeout - seconds
+ *
+ * @return      timeoutValue[] index, the closest one not below it
+ */
+static uint8_t NwkChildAge_TimeoutIdx( uint32_t timeout )
+{
+  uint8_t idx;
+
+  if ( timeout <= timeoutValue[0] )
+  {
+    return ( 0 );
+  }
+
+  for ( idx = 1; idx < (NWK_CHILD_AGE_TIMEOUTS - 1); idx++ )
+  {
+    if ( timeout <= (timeoutValue[idx] * 60) )
+    {
+      break;
+    }
+  }
+
+  return ( idx );
+}
+
+/****************************************************************************
+ * @fn          NwkChildAge_GetStats
+ *
+ * @brief       Get the child aging counters and the histogram of the
+ *              negotiated timeouts of the tracked children.
+ *
+ * @param       pStats - output
+ * @param       clear - TRUE to clear the aged out count after
+ *
+ * @return      none
+ */
+void NwkChildAge_GetStats( nwkChildAgeStats_t *pStats, uint8_t clear )
+{
+  uint16_t i;
+
+  memset( pStats, 0, sizeof( nwkChildAgeStats_t ) );
+
+  pStats->active = NwkChildAge_Active;
+  pStats->children = NwkChildAge_Cnt;
+  pStats->aged = NwkChildAge_Aged;
+  pStats->nextDue = 0xFFFFFFFF;
+
+  if ( NwkChildAge_Cnt > 0 )
+  {
+    NwkChildAge_Clock();
+    pStats->nextDue = ( NwkChildAge_Heap[0].deadline > NwkChildAge_Now ) ?
+                      ( NwkChildAge_Heap[0].deadline - NwkChildAge_Now ) : 0;
+  }
+
+  for ( i = 0; i < NwkChildAge_Cnt; i++ )
+  {
+    pStats->timeouts[NwkChildAge_TimeoutIdx( NwkChildAge_Heap[i].timeout )]++;
+  }
+
+  if ( clear )
+  {
+    NwkChildAge_Aged = 0;
+  }
+}
+
+/*********************************************************************
+*********************************************************************/
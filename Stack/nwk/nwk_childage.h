@@ -0,0 +1,115 @@
+/**************************************************************************************************
+  Filename:       nwk_childage.h
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    This interface provides all the definitions for the
+                  deadline ordered end device child aging.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef NWK_CHILDAGE_H
+#define NWK_CHILDAGE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcomdef.h"
+#include "nwk_globals.h"
+#include "assoc_list.h"
+
+
+/*********************************************************************
+ * MACROS
+ */
+
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Association list entries checked per aging tick for children the
+// aging wasn't told about, and for those that are no children anymore
+#if !defined ( NWK_CHILD_AGE_SYNC_SLOTS )
+  #define NWK_CHILD_AGE_SYNC_SLOTS        8
+#endif
+
+// Entries of the end device timeout table, timeoutValue[]
+#define NWK_CHILD_AGE_TIMEOUTS            15
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t  active;      // TRUE when the child aging is enabled
+  uint16_t children;    // Children tracked
+  uint16_t aged;        // Children aged out
+  uint32_t nextDue;     // Seconds until the next child ages out, 0xFFFFFFFF if none
+  uint16_t timeouts[NWK_CHILD_AGE_TIMEOUTS];  // Tracked children per negotiated timeout
+} nwkChildAgeStats_t;
+
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Called for each child that aged out and was removed, extAddr is NULL
+// when its IEEE address isn't known.  Set by ZDO
+extern void (*pNwkChildAgedCB)( uint16_t nwkAddr, uint8_t *extAddr );
+
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern void NwkChildAge_Init( void );
+
+extern void NwkChildAge_Sync( uint16_t nwkAddr );
+
+extern uint32_t NwkChildAge_Deadline( uint16_t devIdx );
+
+extern void NwkChildAge_GetStats( nwkChildAgeStats_t *pStats, uint8_t clear );
+
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NWK_CHILDAGE_H */
@@ -51,6 +51,7 @@
 #include "aps.h"
 #include "ssp.h"
 #include "rtg.h"
+#include "nwk_childage.h"
 #include "zd_config.h"
 #include "zglobals.h"
 #include "zd_app.h"
@@ -333,6 +334,9 @@ void nwk_globals_init( void )
   {
     // Set the function pointers for the Child Aging feature
     NwkInitChildAging();
+
+    // Age the children by deadline instead of sweeping the list
+    NwkChildAge_Init();
   }
 }
 
@@ -0,0 +1,440 @@
+/**************************************************************************************************
+  Filename:       nwk_nbrmgr.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Neighbor table manager.  Every link status period the
+                  neighbors are scored from their smoothed LQI, link
+                  status age, outgoing cost and whether they are a next
+                  hop.  Off by default; with a limit below the table
+                  size the entries above it stay free so new neighbors
+                  get in and are scored, and past the limit a new
+                  neighbor stays only if it beats the worst kept one by
+                  a margin.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "rom_jt_154.h"
+#include "nwk.h"
+#include "nwk_globals.h"
+#include "nwk_util.h"
+#include "rtg.h"
+#include "nwk_nbrmgr.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define NWK_NBR_MGR_NO_SLOT       ( (neighborTableIndex_t)0xFFFF )
+
+// Slot flags
+#define NWK_NBR_MGR_NEW           0x01  // Not through a pass over the limit yet
+#define NWK_NBR_MGR_NEXT_HOP      0x02  // Next hop in the last pass
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+// Scoring state of a neighbor table entry
+typedef struct
+{
+  uint16_t addr;        // Neighbor the state belongs to
+  uint8_t  lqi;         // Smoothed LQI
+  uint8_t  score;
+  uint8_t  flags;       // NWK_NBR_MGR_NEW, NWK_NBR_MGR_NEXT_HOP
+} nwkNbrMgrSlot_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static nwkNbrMgrSlot_t NwkNbrMgr_Slot[MAX_NEIGHBOR_ENTRIES];
+static uint8_t NwkNbrMgr_Limit = NWK_NBR_MGR_LIMIT;
+static uint8_t NwkNbrMgr_Hysteresis = NWK_NBR_MGR_HYSTERESIS;
+static nwkNbrMgrStats_t NwkNbrMgr_Stats;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8_t NwkNbrMgr_Used( neighborEntry_t *pEntry );
+static neighborEntry_t *NwkNbrMgr_Find( uint16_t nwkAddr );
+static void NwkNbrMgr_MarkNextHop( uint16_t nwkAddr );
+static uint8_t NwkNbrMgr_Score( neighborEntry_t *pEntry, nwkNbrMgrSlot_t *pSlot );
+static neighborTableIndex_t NwkNbrMgr_Worst( uint8_t newOnes );
+static void NwkNbrMgr_Remove( neighborTableIndex_t x );
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_Used
+ *
+ * @brief       Check if a neighbor table entry is in use.
+ *
+ * @param       pEntry - neighbor table entry
+ *
+ * @return      TRUE if used
+ */
+static uint8_t NwkNbrMgr_Used( neighborEntry_t *pEntry )
+{
+  return ( pEntry->neighborAddress != INVALID_NODE_ADDR );
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_Find
+ *
+ * @brief       Find a neighbor by NWK address.
+ *
+ * @param       nwkAddr - NWK address of the neighbor
+ *
+ * @return      neighbor table entry, NULL if not found
+ */
+static neighborEntry_t *NwkNbrMgr_Find( uint16_t nwkAddr )
+{
+  neighborTableIndex_t x;
+
+  for ( x = 0; x < gMAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    if ( (neighborTable[x].neighborAddress == nwkAddr) && NwkNbrMgr_Used( &neighborTable[x] ) )
+    {
+      return ( &neighborTable[x] );
+    }
+  }
+
+  return ( NULL );
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_MarkNextHop
+ *
+ * @brief       Protect the neighbor used as next hop of a route.
+ *
+ * @param       nwkAddr - NWK address of the next hop
+ *
+ * @return      none
+ */
+static void NwkNbrMgr_MarkNextHop( uint16_t nwkAddr )
+{
+  neighborEntry_t *pEntry = NwkNbrMgr_Find( nwkAddr );
+
+  if ( pEntry != NULL )
+  {
+    NwkNbrMgr_Slot[pEntry - neighborTable].flags |= NWK_NBR_MGR_NEXT_HOP;
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_Score
+ *
+ * @brief       Score a neighbor, higher is better.  Neighbors of another
+ *              PAN score 0.
+ *
+ * @param       pEntry - neighbor table entry
+ * @param       pSlot - its scoring state, LQI already smoothed
+ *
+ * @return      score
+ */
+static uint8_t NwkNbrMgr_Score( neighborEntry_t *pEntry, nwkNbrMgrSlot_t *pSlot )
+{
+  int16_t score;
+  uint8_t cost = pEntry->linkInfo.txCost;
+
+  if ( pEntry->panId != _NIB.nwkPanId )
+  {
+    return ( 0 );
+  }
+
+  // Unknown outgoing cost counts as average
+  if ( (cost == 0) || (cost > MAX_LINK_COST) )
+  {
+    cost = ( MAX_LINK_COST + 1 ) / 2;
+  }
+
+  score = ( pSlot->lqi / 2 ) + ( (8 - cost) * NWK_NBR_MGR_COST_WEIGHT )
+          - ( pEntry->age * NWK_NBR_MGR_AGE_PENALTY );
+
+  if ( pSlot->flags & NWK_NBR_MGR_NEXT_HOP )
+  {
+    score += NWK_NBR_MGR_NEXT_HOP_BONUS;
+  }
+
+  if ( score < 0 )
+  {
+    score = 0;
+  }
+  else if ( score > 0xFF )
+  {
+    score = 0xFF;
+  }
+
+  return ( (uint8_t)score );
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_Worst
+ *
+ * @brief       Find the lowest scored neighbor that is not a next hop.
+ *
+ * @param       newOnes - TRUE among the new neighbors, FALSE among the kept ones
+ *
+ * @return      neighbor table index, NWK_NBR_MGR_NO_SLOT if none
+ */
+static neighborTableIndex_t NwkNbrMgr_Worst( uint8_t newOnes )
+{
+  neighborTableIndex_t worst = NWK_NBR_MGR_NO_SLOT;
+  neighborTableIndex_t x;
+  nwkNbrMgrSlot_t *pSlot;
+
+  for ( x = 0; x < gMAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    pSlot = &NwkNbrMgr_Slot[x];
+    if ( NwkNbrMgr_Used( &neighborTable[x] ) &&
+         ((pSlot->flags & NWK_NBR_MGR_NEXT_HOP) == 0) &&
+         (((pSlot->flags & NWK_NBR_MGR_NEW) != 0) == (newOnes != FALSE)) )
+    {
+      if ( (worst == NWK_NBR_MGR_NO_SLOT) || (pSlot->score < NwkNbrMgr_Slot[worst].score) )
+      {
+        worst = x;
+      }
+    }
+  }
+
+  return ( worst );
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_Remove
+ *
+ * @brief       Free a neighbor table entry.
+ *
+ * @param       x - neighbor table index
+ *
+ * @return      none
+ */
+static void NwkNbrMgr_Remove( neighborTableIndex_t x )
+{
+  nwkNeighborRemove( neighborTable[x].neighborAddress, neighborTable[x].panId );
+  NwkNbrMgr_Slot[x].addr = INVALID_NODE_ADDR;
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_Init
+ *
+ * @brief       Reset the scoring state.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+void NwkNbrMgr_Init( void )
+{
+  neighborTableIndex_t x;
+
+  for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    NwkNbrMgr_Slot[x].addr = INVALID_NODE_ADDR;
+  }
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_Process
+ *
+ * @brief       Scoring pass, run once per link status period.  While more
+ *              than the limit of entries are used, the worst new neighbor
+ *              is dropped unless it beats the worst kept neighbor by the
+ *              hysteresis, in which case that one is replaced.  Next hops
+ *              are never dropped.  With the default limit, the whole
+ *              table, nothing is ever dropped.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+void NwkNbrMgr_Process( void )
+{
+  neighborEntry_t *pEntry;
+  nwkNbrMgrSlot_t *pSlot;
+  neighborTableIndex_t x;
+  neighborTableIndex_t newWorst;
+  neighborTableIndex_t keptWorst;
+  rtgTableIndex_t r;
+  srcRtgTableIndex_t s;
+  uint8_t used = 0;
+
+  for ( x = 0; x < gMAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    pEntry = &neighborTable[x];
+    pSlot = &NwkNbrMgr_Slot[x];
+
+    if ( NwkNbrMgr_Used( pEntry ) )
+    {
+      if ( pSlot->addr != pEntry->neighborAddress )
+      {
+        pSlot->addr = pEntry->neighborAddress;
+        pSlot->lqi = pEntry->linkInfo.rxLqi;
+        pSlot->flags = NWK_NBR_MGR_NEW;
+      }
+      else
+      {
+        pSlot->lqi = (uint8_t)( ((uint16_t)pSlot->lqi * 3 + pEntry->linkInfo.rxLqi) / 4 );
+        pSlot->flags &= ~NWK_NBR_MGR_NEXT_HOP;
+      }
+      used++;
+    }
+    else
+    {
+      pSlot->addr = INVALID_NODE_ADDR;
+    }
+  }
+
+  // Next hops of the routes and first relays of the source routes
+  for ( r = 0; r < gMAX_RTG_ENTRIES; r++ )
+  {
+    if ( rtgTable[r].status == RT_ACTIVE )
+    {
+      NwkNbrMgr_MarkNextHop( rtgTable[r].nextHopAddress );
+    }
+  }
+
+  for ( s = 0; s < gMAX_RTG_SRC_ENTRIES; s++ )
+  {
+    if ( (rtgSrcTable[s].relayCount > 0) && (rtgSrcTable[s].relayList != NULL) )
+    {
+      NwkNbrMgr_MarkNextHop( rtgSrcTable[s].relayList[rtgSrcTable[s].relayCount - 1] );
+    }
+  }
+
+  NwkNbrMgr_Stats.nextHops = 0;
+  for ( x = 0; x < gMAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    pSlot = &NwkNbrMgr_Slot[x];
+    if ( pSlot->addr != INVALID_NODE_ADDR )
+    {
+      pSlot->score = NwkNbrMgr_Score( &neighborTable[x], pSlot );
+      if ( pSlot->flags & NWK_NBR_MGR_NEXT_HOP )
+      {
+        NwkNbrMgr_Stats.nextHops++;
+      }
+    }
+  }
+
+  while ( used > NwkNbrMgr_Limit )
+  {
+    newWorst = NwkNbrMgr_Worst( TRUE );
+    keptWorst = NwkNbrMgr_Worst( FALSE );
+
+    if ( (newWorst != NWK_NBR_MGR_NO_SLOT) &&
+         ((keptWorst == NWK_NBR_MGR_NO_SLOT) ||
+          (NwkNbrMgr_Slot[newWorst].score <=
+           (uint16_t)NwkNbrMgr_Slot[keptWorst].score + NwkNbrMgr_Hysteresis)) )
+    {
+      NwkNbrMgr_Remove( newWorst );
+      NwkNbrMgr_Stats.rejected++;
+    }
+    else if ( keptWorst != NWK_NBR_MGR_NO_SLOT )
+    {
+      NwkNbrMgr_Remove( keptWorst );
+      NwkNbrMgr_Stats.evicted++;
+    }
+    else
+    {
+      // Only next hops left
+      break;
+    }
+    used--;
+  }
+
+  // The new neighbors left have earned their place
+  for ( x = 0; x < gMAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    NwkNbrMgr_Slot[x].flags &= ~NWK_NBR_MGR_NEW;
+  }
+
+  NwkNbrMgr_Stats.used = used;
+  NwkNbrMgr_Stats.passes++;
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_Config
+ *
+ * @brief       Set the number of neighbors kept and the hysteresis.
+ *
+ * @param       limit - entries kept, 1 to gMAX_NEIGHBOR_ENTRIES, the
+ *                      maximum turns replacement off
+ * @param       hysteresis - score margin of a replacement
+ *
+ * @return      ZSuccess, ZInvalidParameter for a limit out of range
+ */
+ZStatus_t NwkNbrMgr_Config( uint8_t limit, uint8_t hysteresis )
+{
+  if ( (limit == 0) || (limit > gMAX_NEIGHBOR_ENTRIES) )
+  {
+    return ( ZInvalidParameter );
+  }
+
+  NwkNbrMgr_Limit = limit;
+  NwkNbrMgr_Hysteresis = hysteresis;
+
+  return ( ZSuccess );
+}
+
+/****************************************************************************
+ * @fn          NwkNbrMgr_GetStats
+ *
+ * @brief       Get the neighbor table counters.
+ *
+ * @param       pStats - output
+ * @param       clear - TRUE to clear the pass and churn counters after
+ *
+ * @return      none
+ */
+void NwkNbrMgr_GetStats( nwkNbrMgrStats_t *pStats, uint8_t clear )
+{
+  NwkNbrMgr_Stats.limit = NwkNbrMgr_Limit;
+  *pStats = NwkNbrMgr_Stats;
+
+  if ( clear )
+  {
+    NwkNbrMgr_Stats.passes = 0;
+    NwkNbrMgr_Stats.evicted = 0;
+    NwkNbrMgr_Stats.rejected = 0;
+  }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,125 @@
+/**************************************************************************************************
+  Filename:       nwk_nbrmgr.h
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    This interface provides all the definitions for the
+                  neighbor table manager.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef NWK_NBRMGR_H
+#define NWK_NBRMGR_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcomdef.h"
+#include "nwk_globals.h"
+#include "nwk_util.h"
+
+
+/*********************************************************************
+ * MACROS
+ */
+
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Default number of neighbors kept.  The whole table, the default, turns
+// replacement off; a lower limit keeps the entries above it free for new
+// neighbors to be heard and scored against the kept ones.
+#if !defined ( NWK_NBR_MGR_LIMIT )
+  #define NWK_NBR_MGR_LIMIT               MAX_NEIGHBOR_ENTRIES
+#endif
+
+// Score a new neighbor must beat the worst kept one by to replace it
+#if !defined ( NWK_NBR_MGR_HYSTERESIS )
+  #define NWK_NBR_MGR_HYSTERESIS          16
+#endif
+
+// ms between scoring passes, one link status period
+#if !defined ( NWK_NBR_MGR_PERIOD )
+  #define NWK_NBR_MGR_PERIOD              15000
+#endif
+
+// Score weights
+#define NWK_NBR_MGR_NEXT_HOP_BONUS        64    // Next hop of an active route or source route
+#define NWK_NBR_MGR_AGE_PENALTY           16    // Per link status period missed
+#define NWK_NBR_MGR_COST_WEIGHT           8     // Per outgoing link cost step below 8
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t  used;        // Neighbor table entries in use
+  uint8_t  limit;       // Entries kept after a pass
+  uint8_t  nextHops;    // Entries protected as next hops in the last pass
+  uint16_t passes;      // Scoring passes run
+  uint16_t evicted;     // Kept neighbors replaced by a better new one
+  uint16_t rejected;    // New neighbors dropped for not beating the worst kept one
+} nwkNbrMgrStats_t;
+
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern void NwkNbrMgr_Init( void );
+
+extern void NwkNbrMgr_Process( void );
+
+extern ZStatus_t NwkNbrMgr_Config( uint8_t limit, uint8_t hysteresis );
+
+extern void NwkNbrMgr_GetStats( nwkNbrMgrStats_t *pStats, uint8_t clear );
+
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NWK_NBRMGR_H */
@@ -0,0 +1,649 @@
+/**************************************************************************************************
+  Filename:       rtg_srctree.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Shared source route relay store.  Source routes learned
+                  from route records are kept as a tree of relays toward
+                  this device, each relay stored once with a reference
+                  count and each destination pointing at the relay
+                  nearest to it.  A route that fell out of the source
+                  route table is put back from here before data is sent.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "rom_jt_154.h"
+#include "nwk_globals.h"
+#include "rtg.h"
+#include "rtg_srctree.h"
+
+#if defined ( RTG_SRC_TREE )
+
+/*********************************************************************
+ * MACROS
+ */
+#define RTG_SRC_TREE_HASH( addr )  ( ((addr) ^ ((addr) >> 7)) % RTG_SRC_TREE_HASH_SIZE )
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+// Frame to a kept route waiting for its data confirm
+typedef struct
+{
+  uint16_t dstAddr;   // NWK address, INVALID_NODE_ADDR for a free entry
+  uint8_t endPoint;
+  uint8_t transID;
+} rtgSrcTreeSent_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static rtgSrcTreeNode_t RTG_SrcTreeNodes[RTG_SRC_TREE_NODES];
+static rtgSrcTreeDst_t RTG_SrcTreeDsts[RTG_SRC_TREE_DSTS];
+static uint16_t RTG_SrcTreeDstHash[RTG_SRC_TREE_HASH_SIZE];
+static uint16_t RTG_SrcTreeDstFree;
+static rtgSrcTreeSent_t RTG_SrcTreeSentList[RTG_SRC_TREE_SENT];
+static uint8_t RTG_SrcTreeSentNext;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16_t RTG_SrcTreeNow( void );
+static uint16_t RTG_SrcTreeFindNode( uint16_t addr );
+static uint16_t RTG_SrcTreeFindDst( uint16_t dstAddr );
+static uint16_t RTG_SrcTreeNewDst( uint16_t dstAddr );
+static void RTG_SrcTreeLink( uint16_t *pLink, uint16_t node );
+static void RTG_SrcTreeUnref( uint16_t node );
+static void RTG_SrcTreeDrop( uint16_t idx );
+static uint8_t RTG_SrcTreeEvict( void );
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeNow
+ *
+ * @brief       Seconds clock of the route stamps.
+ *
+ * @param       none
+ *
+ * @return      seconds, wrapping
+ */
+static uint16_t RTG_SrcTreeNow( void )
+{
+  return (uint16_t)( MAP_osal_GetSystemClock() / 1000 );
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeFindNode
+ *
+ * @brief       Find the node of a relay.
+ *
+ * @param       addr - NWK address of the relay
+ *
+ * @return      node index, RTG_SRC_TREE_NONE if not found
+ */
+static uint16_t RTG_SrcTreeFindNode( uint16_t addr )
+{
+  uint16_t x;
+
+  for ( x = 0; x < RTG_SRC_TREE_NODES; x++ )
+  {
+    if ( RTG_SrcTreeNodes[x].addr == addr )
+    {
+      return ( x );
+    }
+  }
+
+  return ( RTG_SRC_TREE_NONE );
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeFindDst
+ *
+ * @brief       Find the entry of a destination in its index bucket.
+ *
+ * @param       dstAddr - NWK address of the destination
+ *
+ * @return      entry index, RTG_SRC_TREE_NONE if not found
+ */
+static uint16_t RTG_SrcTreeFindDst( uint16_t dstAddr )
+{
+  uint16_t x;
+
+  if ( dstAddr == INVALID_NODE_ADDR )
+  {
+    return ( RTG_SRC_TREE_NONE );
+  }
+
+  for ( x = RTG_SrcTreeDstHash[RTG_SRC_TREE_HASH( dstAddr )];
+        x != RTG_SRC_TREE_NONE; x = RTG_SrcTreeDsts[x].next )
+  {
+    if ( RTG_SrcTreeDsts[x].dstAddr == dstAddr )
+    {
+      return ( x );
+    }
+  }
+
+  return ( RTG_SRC_TREE_NONE );
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeNewDst
+ *
+ * @brief       Take a free destination entry and put it in the index.
+ *
+ * @param       dstAddr - NWK address of the destination
+ *
+ * @return      entry index, RTG_SRC_TREE_NONE if there is no free entry
+ */
+static uint16_t RTG_SrcTreeNewDst( uint16_t dstAddr )
+{
+  uint16_t idx = RTG_SrcTreeDstFree;
+  uint16_t h;
+
+  if ( idx != RTG_SRC_TREE_NONE )
+  {
+    RTG_SrcTreeDstFree = RTG_SrcTreeDsts[idx].next;
+
+    h = RTG_SRC_TREE_HASH( dstAddr );
+    RTG_SrcTreeDsts[idx].dstAddr = dstAddr;
+    RTG_SrcTreeDsts[idx].node = RTG_SRC_TREE_NONE;
+    RTG_SrcTreeDsts[idx].next = RTG_SrcTreeDstHash[h];
+    RTG_SrcTreeDstHash[h] = idx;
+  }
+
+  return ( idx );
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeLink
+ *
+ * @brief       Point a relay or destination at another node, the new
+ *              node is referenced before the old one is released so a
+ *              path shared by both stays in place.
+ *
+ * @param       pLink - parent of a relay or node of a destination
+ * @param       node - node to point at, or RTG_SRC_TREE_NONE
+ *
+ * @return      none
+ */
+static void RTG_SrcTreeLink( uint16_t *pLink, uint16_t node )
+{
+  uint16_t old = *pLink;
+
+  if ( old != node )
+  {
+    if ( node != RTG_SRC_TREE_NONE )
+    {
+      RTG_SrcTreeNodes[node].refCnt++;
+    }
+
+    *pLink = node;
+    RTG_SrcTreeUnref( old );
+  }
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeUnref
+ *
+ * @brief       Release a reference to a node, freeing the nodes of the
+ *              path that are no longer used.
+ *
+ * @param       node - node index, or RTG_SRC_TREE_NONE
+ *
+ * @return      none
+ */
+static void RTG_SrcTreeUnref( uint16_t node )
+{
+  rtgSrcTreeNode_t *pNode;
+
+  while ( node != RTG_SRC_TREE_NONE )
+  {
+    pNode = &RTG_SrcTreeNodes[node];
+    if ( --pNode->refCnt > 0 )
+    {
+      break;
+    }
+
+    node = pNode->parent;
+    pNode->addr = INVALID_NODE_ADDR;
+    pNode->parent = RTG_SRC_TREE_NONE;
+  }
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeDrop
+ *
+ * @brief       Free a destination entry, taking it out of the index.
+ *
+ * @param       idx - entry index
+ *
+ * @return      none
+ */
+static void RTG_SrcTreeDrop( uint16_t idx )
+{
+  uint16_t *pLink = &RTG_SrcTreeDstHash[RTG_SRC_TREE_HASH( RTG_SrcTreeDsts[idx].dstAddr )];
+
+  while ( *pLink != idx )
+  {
+    pLink = &RTG_SrcTreeDsts[*pLink].next;
+  }
+  *pLink = RTG_SrcTreeDsts[idx].next;
+
+  RTG_SrcTreeLink( &RTG_SrcTreeDsts[idx].node, RTG_SRC_TREE_NONE );
+  RTG_SrcTreeDsts[idx].dstAddr = INVALID_NODE_ADDR;
+  RTG_SrcTreeDsts[idx].next = RTG_SrcTreeDstFree;
+  RTG_SrcTreeDstFree = idx;
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeEvict
+ *
+ * @brief       Free the destination with the oldest route record, after
+ *              freeing every expired one.
+ *
+ * @param       none
+ *
+ * @return      TRUE if an entry was freed
+ */
+static uint8_t RTG_SrcTreeEvict( void )
+{
+  uint16_t now = RTG_SrcTreeNow();
+  uint16_t oldest = RTG_SRC_TREE_NONE;
+  uint16_t oldestAge = 0;
+  uint16_t age;
+  uint16_t x;
+  uint8_t freed = FALSE;
+
+  for ( x = 0; x < RTG_SRC_TREE_DSTS; x++ )
+  {
+    if ( RTG_SrcTreeDsts[x].dstAddr != INVALID_NODE_ADDR )
+    {
+      age = now - RTG_SrcTreeDsts[x].stamp;
+      if ( age > RTG_SRC_TREE_EXPIRY )
+      {
+        RTG_SrcTreeDrop( x );
+        freed = TRUE;
+      }
+      else if ( (oldest == RTG_SRC_TREE_NONE) || (age > oldestAge) )
+      {
+        oldest = x;
+        oldestAge = age;
+      }
+    }
+  }
+
+  if ( (freed == FALSE) && (oldest != RTG_SRC_TREE_NONE) )
+  {
+    RTG_SrcTreeDrop( oldest );
+    freed = TRUE;
+  }
+
+  return ( freed );
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeInit
+ *
+ * @brief       Empty the store.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+void RTG_SrcTreeInit( void )
+{
+  uint16_t x;
+
+  for ( x = 0; x < RTG_SRC_TREE_NODES; x++ )
+  {
+    RTG_SrcTreeNodes[x].addr = INVALID_NODE_ADDR;
+    RTG_SrcTreeNodes[x].parent = RTG_SRC_TREE_NONE;
+    RTG_SrcTreeNodes[x].refCnt = 0;
+  }
+
+  for ( x = 0; x < RTG_SRC_TREE_DSTS; x++ )
+  {
+    RTG_SrcTreeDsts[x].dstAddr = INVALID_NODE_ADDR;
+    RTG_SrcTreeDsts[x].node = RTG_SRC_TREE_NONE;
+    RTG_SrcTreeDsts[x].next = ( x + 1 < RTG_SRC_TREE_DSTS ) ? ( x + 1 ) : RTG_SRC_TREE_NONE;
+  }
+  RTG_SrcTreeDstFree = 0;
+
+  for ( x = 0; x < RTG_SRC_TREE_HASH_SIZE; x++ )
+  {
+    RTG_SrcTreeDstHash[x] = RTG_SRC_TREE_NONE;
+  }
+
+  for ( x = 0; x < RTG_SRC_TREE_SENT; x++ )
+  {
+    RTG_SrcTreeSentList[x].dstAddr = INVALID_NODE_ADDR;
+  }
+  RTG_SrcTreeSentNext = 0;
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeAdd
+ *
+ * @brief       Keep the source route of a route record.  Each relay has
+ *              one path toward this device, the last one learned, so a
+ *              record re-parenting a relay moves every route through it
+ *              at once.  The same holds when the destination is itself
+ *              a relay of other routes.
+ *
+ * @param       dstAddr - NWK address of the destination
+ * @param       relayCnt - number of relays
+ * @param       pRelayList - relays, the one nearest to the destination first
+ *
+ * @return      ZSuccess, ZInvalidParameter for a path that is too long
+ *              or loops, ZMemError if there is no room
+ */
+ZStatus_t RTG_SrcTreeAdd( uint16_t dstAddr, uint8_t relayCnt, uint16_t *pRelayList )
+{
+  uint16_t parent = RTG_SRC_TREE_NONE;
+  uint16_t node;
+  uint16_t idx;
+  uint16_t freeNodes;
+  uint16_t x;
+  uint8_t need;
+  uint8_t i;
+  uint8_t j;
+
+  if ( (relayCnt > gMAX_SOURCE_ROUTE) || (dstAddr == INVALID_NODE_ADDR) )
+  {
+    return ( ZInvalidParameter );
+  }
+
+  for ( i = 0; i < relayCnt; i++ )
+  {
+    if ( pRelayList[i] == dstAddr )
+    {
+      return ( ZInvalidParameter );
+    }
+
+    for ( j = 0; j < i; j++ )
+    {
+      if ( pRelayList[j] == pRelayList[i] )
+      {
+        return ( ZInvalidParameter );
+      }
+    }
+  }
+
+  // Make room for the destination and the relays not stored yet
+  for ( ;; )
+  {
+    idx = RTG_SrcTreeFindDst( dstAddr );
+
+    need = 0;
+    for ( i = 0; i < relayCnt; i++ )
+    {
+      if ( RTG_SrcTreeFindNode( pRelayList[i] ) == RTG_SRC_TREE_NONE )
+      {
+        need++;
+      }
+    }
+
+    freeNodes = 0;
+    for ( x = 0; (x < RTG_SRC_TREE_NODES) && (freeNodes < need); x++ )
+    {
+      if ( RTG_SrcTreeNodes[x].addr == INVALID_NODE_ADDR )
+      {
+        freeNodes++;
+      }
+    }
+
+    if ( ((idx != RTG_SRC_TREE_NONE) || (RTG_SrcTreeDstFree != RTG_SRC_TREE_NONE))
+        && (freeNodes >= need) )
+    {
+      break;
+    }
+
+    if ( RTG_SrcTreeEvict() == FALSE )
+    {
+      return ( ZMemError );
+    }
+  }
+
+  // Relays from this device's side, each one re-parented onto the path
+  // just built above it, which holds none of the relays below
+  for ( i = relayCnt; i > 0; i-- )
+  {
+    node = RTG_SrcTreeFindNode( pRelayList[i - 1] );
+    if ( node == RTG_SRC_TREE_NONE )
+    {
+      node = RTG_SrcTreeFindNode( INVALID_NODE_ADDR );
+      RTG_SrcTreeNodes[node].addr = pRelayList[i - 1];
+      RTG_SrcTreeNodes[node].parent = RTG_SRC_TREE_NONE;
+      RTG_SrcTreeNodes[node].refCnt = 0;
+    }
+
+    RTG_SrcTreeLink( &RTG_SrcTreeNodes[node].parent, parent );
+    parent = node;
+  }
+
+  // The destination relays other routes, they follow its new path
+  node = RTG_SrcTreeFindNode( dstAddr );
+  if ( node != RTG_SRC_TREE_NONE )
+  {
+    RTG_SrcTreeLink( &RTG_SrcTreeNodes[node].parent, parent );
+  }
+
+  if ( idx == RTG_SRC_TREE_NONE )
+  {
+    idx = RTG_SrcTreeNewDst( dstAddr );
+  }
+
+  RTG_SrcTreeLink( &RTG_SrcTreeDsts[idx].node, parent );
+  RTG_SrcTreeDsts[idx].stamp = RTG_SrcTreeNow();
+
+  return ( ZSuccess );
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeGet
+ *
+ * @brief       Get the kept source route of a destination.
+ *
+ * @param       dstAddr - NWK address of the destination
+ * @param       pRelayCnt - output, number of relays
+ * @param       pRelayList - output, room for MAX_SOURCE_ROUTE relays,
+ *                           the one nearest to the destination first
+ *
+ * @return      TRUE if a route was found, not expired and not too long
+ */
+uint8_t RTG_SrcTreeGet( uint16_t dstAddr, uint8_t *pRelayCnt, uint16_t *pRelayList )
+{
+  uint16_t idx;
+  uint16_t node;
+  uint8_t cnt = 0;
+
+  idx = RTG_SrcTreeFindDst( dstAddr );
+  if ( idx == RTG_SRC_TREE_NONE )
+  {
+    return ( FALSE );
+  }
+
+  if ( (uint16_t)(RTG_SrcTreeNow() - RTG_SrcTreeDsts[idx].stamp) > RTG_SRC_TREE_EXPIRY )
+  {
+    RTG_SrcTreeDrop( idx );
+    return ( FALSE );
+  }
+
+  node = RTG_SrcTreeDsts[idx].node;
+  while ( node != RTG_SRC_TREE_NONE )
+  {
+    // A relay moved onto a longer path than a source route can carry
+    if ( cnt >= gMAX_SOURCE_ROUTE )
+    {
+      return ( FALSE );
+    }
+
+    pRelayList[cnt++] = RTG_SrcTreeNodes[node].addr;
+    node = RTG_SrcTreeNodes[node].parent;
+  }
+
+  *pRelayCnt = cnt;
+
+  return ( TRUE );
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeRemove
+ *
+ * @brief       Forget the route of a destination that left or could not
+ *              be reached over it.  Its node,
+ *              if it relays other routes, stays until they are gone.
+ *
+ * @param       dstAddr - NWK address of the destination
+ *
+ * @return      none
+ */
+void RTG_SrcTreeRemove( uint16_t dstAddr )
+{
+  uint16_t idx = RTG_SrcTreeFindDst( dstAddr );
+
+  if ( idx != RTG_SRC_TREE_NONE )
+  {
+    RTG_SrcTreeDrop( idx );
+  }
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeRestore
+ *
+ * @brief       Put the kept route of a destination back into the source
+ *              route table when it is no longer there, so data to it is
+ *              source routed instead of starting a route discovery.
+ *
+ * @param       dstAddr - NWK address of the destination
+ *
+ * @return      TRUE if the route was put back
+ */
+uint8_t RTG_SrcTreeRestore( uint16_t dstAddr )
+{
+  uint16_t relayList[MAX_SOURCE_ROUTE];
+  uint16_t *pList;
+  uint8_t relayCnt;
+
+  if ( RTG_GetRtgSrcEntry( dstAddr, &relayCnt, &pList ) == RTG_SUCCESS )
+  {
+    return ( FALSE );
+  }
+
+  if ( (RTG_SrcTreeGet( dstAddr, &relayCnt, relayList ) == FALSE) || (relayCnt == 0) )
+  {
+    return ( FALSE );
+  }
+
+  return ( RTG_AddSrcRtgEntry_Guaranteed( dstAddr, relayCnt, relayList ) == RTG_SUCCESS );
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeSent
+ *
+ * @brief       Wait for the data confirm of a frame to a destination with
+ *              a kept route, the oldest frame waited for is given up when
+ *              there is no room.
+ *
+ * @param       dstAddr - NWK address of the destination
+ * @param       endPoint - source endpoint of the frame
+ * @param       transID - transaction ID of the frame
+ *
+ * @return      none
+ */
+void RTG_SrcTreeSent( uint16_t dstAddr, uint8_t endPoint, uint8_t transID )
+{
+  rtgSrcTreeSent_t *pSent;
+
+  if ( RTG_SrcTreeFindDst( dstAddr ) == RTG_SRC_TREE_NONE )
+  {
+    return;
+  }
+
+  pSent = &RTG_SrcTreeSentList[RTG_SrcTreeSentNext];
+  pSent->dstAddr = dstAddr;
+  pSent->endPoint = endPoint;
+  pSent->transID = transID;
+
+  RTG_SrcTreeSentNext = ( RTG_SrcTreeSentNext + 1 ) % RTG_SRC_TREE_SENT;
+}
+
+/****************************************************************************
+ * @fn          RTG_SrcTreeConfirm
+ *
+ * @brief       Data confirm of a frame.  The kept route of a destination
+ *              a frame could not be delivered to is forgotten, so it is
+ *              not put back into the source route table again.
+ *
+ * @param       endPoint - source endpoint of the frame
+ * @param       transID - transaction ID of the frame
+ * @param       status - status of the data confirm
+ *
+ * @return      none
+ */
+void RTG_SrcTreeConfirm( uint8_t endPoint, uint8_t transID, ZStatus_t status )
+{
+  rtgSrcTreeSent_t *pSent;
+  uint8_t x;
+
+  for ( x = 0; x < RTG_SRC_TREE_SENT; x++ )
+  {
+    pSent = &RTG_SrcTreeSentList[x];
+    if ( (pSent->dstAddr != INVALID_NODE_ADDR) &&
+         (pSent->endPoint == endPoint) && (pSent->transID == transID) )
+    {
+      if ( status != ZSuccess )
+      {
+        RTG_SrcTreeRemove( pSent->dstAddr );
+      }
+
+      pSent->dstAddr = INVALID_NODE_ADDR;
+      break;
+    }
+  }
+}
+
+#endif // RTG_SRC_TREE
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,148 @@
+/**************************************************************************************************
+  Filename:       rtg_srctree.h
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    This interface provides all the definitions for the
+                  shared source route relay store.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef RTG_SRCTREE_H
+#define RTG_SRCTREE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcomdef.h"
+#include "nwk_globals.h"
+
+
+/*********************************************************************
+ * MACROS
+ */
+
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// The store is built in with RTG_SRC_TREE defined.  At the default
+// sizing it takes 23 * MAX_RTG_SRC_ENTRIES + 16 bytes of RAM, 4616
+// bytes with the 200 entries of preinclude.h.
+
+// Destinations whose source route is kept
+#if !defined ( RTG_SRC_TREE_DSTS )
+  #define RTG_SRC_TREE_DSTS               ( 2 * MAX_RTG_SRC_ENTRIES )
+#endif
+
+// Relays shared by the kept source routes
+#if !defined ( RTG_SRC_TREE_NODES )
+  #define RTG_SRC_TREE_NODES              ( MAX_RTG_SRC_ENTRIES / 2 )
+#endif
+
+// Buckets of the destination index
+#if !defined ( RTG_SRC_TREE_HASH_SIZE )
+  #define RTG_SRC_TREE_HASH_SIZE          RTG_SRC_TREE_DSTS
+#endif
+
+// Frames to kept routes whose data confirm is waited for
+#if !defined ( RTG_SRC_TREE_SENT )
+  #define RTG_SRC_TREE_SENT               4
+#endif
+
+// Seconds a route is kept without a new route record
+#if !defined ( RTG_SRC_TREE_EXPIRY )
+  #define RTG_SRC_TREE_EXPIRY             1800
+#endif
+
+// No node: the end of a relay path, or a route without relays
+#define RTG_SRC_TREE_NONE                 0xFFFF
+
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+// Relay, shared by every route passing through it
+typedef struct
+{
+  uint16_t addr;      // NWK address, INVALID_NODE_ADDR for a free node
+  uint16_t parent;    // Next relay toward this device, RTG_SRC_TREE_NONE for the last one
+  uint16_t refCnt;    // Relays and destinations whose path continues here
+} rtgSrcTreeNode_t;
+
+// Destination, points at the relay nearest to it
+typedef struct
+{
+  uint16_t dstAddr;   // NWK address, INVALID_NODE_ADDR for a free entry
+  uint16_t node;      // First relay from the destination, RTG_SRC_TREE_NONE for none
+  uint16_t stamp;     // Seconds clock of the last route record
+  uint16_t next;      // Next entry of its index bucket, or of the free entries
+} rtgSrcTreeDst_t;
+
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern void RTG_SrcTreeInit( void );
+
+extern ZStatus_t RTG_SrcTreeAdd( uint16_t dstAddr, uint8_t relayCnt, uint16_t *pRelayList );
+
+extern uint8_t RTG_SrcTreeGet( uint16_t dstAddr, uint8_t *pRelayCnt, uint16_t *pRelayList );
+
+extern void RTG_SrcTreeRemove( uint16_t dstAddr );
+
+extern uint8_t RTG_SrcTreeRestore( uint16_t dstAddr );
+
+extern void RTG_SrcTreeSent( uint16_t dstAddr, uint8_t endPoint, uint8_t transID );
+
+extern void RTG_SrcTreeConfirm( uint8_t endPoint, uint8_t transID, ZStatus_t status );
+
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTG_SRCTREE_H */
@@ -121,6 +121,9 @@ typedef struct _osalPort_schedule_t
 
 /***** Private function definitions *****/
 
+static void *OsalPort_msgLinkTarget( void *pMsg );
+static void *OsalPort_msgUnlink( void *pMsg );
+
 // DMM currently uses ICall Heap
 #ifdef USE_DMM
 extern void *ICall_heapMalloc(uint32_t size);
@@ -251,6 +254,7 @@ uint8_t * OsalPort_msgAllocate(uint16_t len )
         pHdr->next = NULL;
         pHdr->len = len;
         pHdr->dest_id = OsalPort_TASK_NO_TASK;
+        pHdr->refCnt = 1;
 
         pMsg = (uint8_t *)((uint8_t *)pHdr + sizeof( OsalPort_MsgHdr ));
     }
@@ -258,6 +262,45 @@ uint8_t * OsalPort_msgAllocate(uint16_t len )
     return pMsg;
 }
 
+/*********************************************************************
+ * @fn      OsalPort_msgAllocateRef
+ *
+ * @brief
+ *
+ *    This function allocates a message buffer that also holds a
+ *    reference to a shared buffer.  The reference is stored after the
+ *    visible payload and released when the message is deallocated.
+ *
+ * @param   uint16_t len - wanted buffer length
+ * @param   uint8_t *pShared - shared message buffer to reference
+ *
+ * @return  pointer to allocated buffer or NULL if allocation failed.
+ */
+uint8_t * OsalPort_msgAllocateRef( uint16_t len, uint8_t *pShared )
+{
+    uint8_t *pMsg;
+
+    if ( pShared == NULL )
+        return ( NULL );
+
+    if ( OsalPort_msgRetain( pShared ) != OsalPort_SUCCESS )
+        return ( NULL );
+
+    pMsg = OsalPort_msgAllocate( len + sizeof( uint8_t * ) );
+    if ( pMsg == NULL )
+    {
+        OsalPort_msgDeallocate( pShared );
+        return ( NULL );
+    }
+
+    // Hide the reference from the owner of the message
+    OsalPort_MSG_LEN( pMsg ) = len;
+    OsalPort_MSG_REF( pMsg ) |= OsalPort_MSG_REF_ATTACHED;
+    memcpy( pMsg + len, &pShared, sizeof( uint8_t * ) );
+
+    return pMsg;
+}
+
 /*********************************************************************
  * @fn      OsalPort_msgDeallocate
  *
@@ -275,6 +318,8 @@ uint8_t * OsalPort_msgAllocate(uint16_t len )
 uint8_t OsalPort_msgDeallocate( uint8_t *pMsg )
 {
     uint8_t *x;
+    uint8_t *pShared = NULL;
+    uint32_t key;
 
     if ( pMsg == NULL )
         return ( OsalPort_INVALID_MSG_POINTER );
@@ -283,13 +328,108 @@ uint8_t OsalPort_msgDeallocate( uint8_t *pMsg )
     if ( OsalPort_MSG_ID( pMsg ) != OsalPort_TASK_NO_TASK )
         return ( OsalPort_MSG_BUFFER_NOT_AVAIL );
 
+    // only the last reference to a shared buffer frees it
+    key = OsalPort_enterCS();
+    if ( (OsalPort_MSG_REF( pMsg ) & OsalPort_MSG_REF_CNT_MASK) > 1 )
+    {
+        OsalPort_MSG_REF( pMsg )--;
+        OsalPort_leaveCS(key);
+        return ( OsalPort_SUCCESS );
+    }
+    OsalPort_leaveCS(key);
+
+    if ( OsalPort_MSG_REF( pMsg ) & OsalPort_MSG_REF_ATTACHED )
+    {
+        memcpy( &pShared, pMsg + OsalPort_MSG_LEN( pMsg ), sizeof( uint8_t * ) );
+    }
+
     x = (uint8_t *)((uint8_t *)pMsg - sizeof( OsalPort_MsgHdr ));
 
     OsalPort_free( (void *)x );
 
+    if ( pShared != NULL )
+    {
+        OsalPort_msgDeallocate( pShared );
+    }
+
     return ( OsalPort_SUCCESS );
 }
 
+/*********************************************************************
+ * @fn      OsalPort_msgRetain
+ *
+ * @brief
+ *
+ *    Take an additional reference on a message buffer.
+ *
+ * @param   uint8_t *pMsg - pointer to message buffer
+ *
+ * @return  OsalPort_SUCCESS, OsalPort_MSG_BUFFER_NOT_AVAIL if the
+ *          reference count is saturated
+ */
+uint8_t OsalPort_msgRetain( uint8_t *pMsg )
+{
+    uint8_t status = OsalPort_MSG_BUFFER_NOT_AVAIL;
+    uint32_t key;
+
+    key = OsalPort_enterCS();
+    if ( (OsalPort_MSG_REF( pMsg ) & OsalPort_MSG_REF_CNT_MASK) < OsalPort_MSG_REF_CNT_MASK )
+    {
+        OsalPort_MSG_REF( pMsg )++;
+        status = OsalPort_SUCCESS;
+    }
+    OsalPort_leaveCS(key);
+
+    return status;
+}
+
+/*********************************************************************
+ * @fn      OsalPort_msgLinkTarget
+ *
+ * @brief
+ *
+ *    Resolve a queued message to the buffer seen by its receiver.
+ *
+ * @param   void *pMsg - queued message
+ *
+ * @return  the shared buffer if pMsg is a link, pMsg otherwise
+ */
+static void *OsalPort_msgLinkTarget( void *pMsg )
+{
+    uint8_t *pShared;
+
+    if ( (pMsg == NULL) || !(OsalPort_MSG_REF( pMsg ) & OsalPort_MSG_REF_LINK) )
+        return pMsg;
+
+    memcpy( &pShared, pMsg, sizeof( uint8_t * ) );
+
+    return pShared;
+}
+
+/*********************************************************************
+ * @fn      OsalPort_msgUnlink
+ *
+ * @brief
+ *
+ *    Replace a dequeued link with the shared buffer it refers to.  The
+ *    reference held by the link is handed over to the receiver.
+ *
+ * @param   void *pMsg - dequeued message
+ *
+ * @return  pointer to the message to deliver
+ */
+static void *OsalPort_msgUnlink( void *pMsg )
+{
+    void *pShared = OsalPort_msgLinkTarget( pMsg );
+
+    if ( pShared != pMsg )
+    {
+        OsalPort_free( (uint8_t *)pMsg - sizeof( OsalPort_MsgHdr ) );
+    }
+
+    return pShared;
+}
+
 /*********************************************************************
  * @fn      OsalPort_msgSend
  *
@@ -336,6 +476,59 @@ uint8_t OsalPort_msgSend( uint8_t destinationTask, uint8_t *pMsg )
     return OsalPort_INVALID_TASK;
 }
 
+/*********************************************************************
+ * @fn      OsalPort_msgSendShared
+ *
+ * @brief
+ *
+ *    This function is called by a task to deliver the same read-only
+ *    message buffer to another task without copying it.  A small link
+ *    is queued to the destination task and a reference is taken on the
+ *    buffer; the receiver gets the buffer itself from
+ *    OsalPort_msgReceive() and releases it with OsalPort_msgDeallocate().
+ *
+ * @param   uint8_t destinationTask - Send msg to Task ID
+ * @param   uint8_t *pMsg - pointer to message buffer to share
+ *
+ * @return  OsalPort_SUCCESS, OsalPort_INVALID_TASK, OsalPort_INVALID_MSG_POINTER,
+ *          OsalPort_MSG_BUFFER_NOT_AVAIL
+ */
+uint8_t OsalPort_msgSendShared( uint8_t destinationTask, uint8_t *pMsg )
+{
+    uint8_t *pLink;
+    uint8_t status;
+
+    if ( pMsg == NULL )
+    {
+        return OsalPort_INVALID_MSG_POINTER;
+    }
+
+    pLink = OsalPort_msgAllocate( sizeof( uint8_t * ) );
+    if ( pLink == NULL )
+    {
+        return OsalPort_MSG_BUFFER_NOT_AVAIL;
+    }
+
+    status = OsalPort_msgRetain( pMsg );
+    if ( status == OsalPort_SUCCESS )
+    {
+        memcpy( pLink, &pMsg, sizeof( uint8_t * ) );
+        OsalPort_MSG_REF( pLink ) |= OsalPort_MSG_REF_LINK;
+
+        status = OsalPort_msgSend( destinationTask, pLink );
+        if ( status == OsalPort_SUCCESS )
+        {
+            return status;
+        }
+
+        OsalPort_msgDeallocate( pMsg );
+    }
+
+    OsalPort_free( pLink - sizeof( OsalPort_MsgHdr ) );
+
+    return status;
+}
+
 /**************************************************************************************************
  * @fn          OsalPort_msgFind
  *
@@ -372,7 +565,7 @@ OsalPort_EventHdr* OsalPort_msgFind(uint8_t taskId, uint8_t event)
             // Look through the tasks queue for a message that matches the task_id and event parameters.
             while (pHdr != NULL)
             {
-              if (((OsalPort_EventHdr *)pHdr)->event == event)
+              if (((OsalPort_EventHdr *)OsalPort_msgLinkTarget(pHdr))->event == event)
               {
                 break;
               }
@@ -385,7 +578,53 @@ OsalPort_EventHdr* OsalPort_msgFind(uint8_t taskId, uint8_t event)
 
     OsalPort_leaveCS(key);
 
-    return (OsalPort_EventHdr *)pHdr;
+    return (OsalPort_EventHdr *)OsalPort_msgLinkTarget(pHdr);
+}
+
+/**************************************************************************************************
+ * @fn          OsalPort_msgCount
+ *
+ * @brief       This function counts the OSAL messages waiting in the queue of a task.
+ *
+ * input parameters
+ *
+ * @param       taskId - The ID of the task.
+ * @param       max - The count at which to stop looking.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The number of messages queued, at most max.
+ **************************************************************************************************
+ */
+uint16_t OsalPort_msgCount(uint8_t taskId, uint16_t max)
+{
+    uint8_t taskIdx;
+    uint32_t key;
+    uint16_t cnt = 0;
+    OsalPort_MsgHdr *pHdr;
+
+    key = OsalPort_enterCS();
+
+    /*find dest task */
+    for(taskIdx = 0; taskIdx < taskCnt; taskIdx++)
+    {
+        if(taskTbl[taskIdx].taskId == taskId)
+        {
+            for(pHdr = (OsalPort_MsgHdr*) taskTbl[taskIdx].qHandle;
+                (pHdr != NULL) && (cnt < max);
+                pHdr = OsalPort_MSG_NEXT(pHdr))
+            {
+                cnt++;
+            }
+            break;
+        }
+    }
+
+    OsalPort_leaveCS(key);
+
+    return cnt;
 }
 
 /*********************************************************************
@@ -427,7 +666,7 @@ uint8_t *OsalPort_msgReceive( uint8_t destinationTask )
         }
     }
 
-    return pMsg;
+    return OsalPort_msgUnlink( pMsg );
 }
 
 /*********************************************************************
@@ -706,7 +945,7 @@ OsalPort_EventHdr* OsalPort_msgFindDequeue(uint8_t taskId, uint8_t event)
             // Look through the tasks queue for a message that matches the task_id and event parameters.
             while (pHdr != NULL)
             {
-              if (((OsalPort_EventHdr *)pHdr)->event == event)
+              if (((OsalPort_EventHdr *)OsalPort_msgLinkTarget(pHdr))->event == event)
               {
 
                 if(pPrev == NULL)
@@ -731,7 +970,7 @@ OsalPort_EventHdr* OsalPort_msgFindDequeue(uint8_t taskId, uint8_t event)
 
     OsalPort_leaveCS(key);
 
-    return (OsalPort_EventHdr *)pHdr;
+    return (OsalPort_EventHdr *)OsalPort_msgUnlink(pHdr);
 }
 
 /*********************************************************************
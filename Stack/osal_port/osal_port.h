@@ -67,6 +67,7 @@ extern "C"
 #define OsalPort_MSG_Q_HEAD(pQ)      (*(pQ))
 #define OsalPort_MSG_LEN(pMsg)      ((OsalPort_MsgHdr *) (pMsg) - 1)->len
 #define OsalPort_MSG_ID(pMsg)      ((OsalPort_MsgHdr *) (pMsg) - 1)->dest_id
+#define OsalPort_MSG_REF(pMsg)      ((OsalPort_MsgHdr *) (pMsg) - 1)->refCnt
 
 #define OsalPort_OFFSET_OF(type, member) ((uint32) &(((type *) 0)->member))
 
@@ -93,6 +94,11 @@ extern "C"
 
 #define OsalPort_TASK_NO_TASK              0xFF
 
+/*** Message reference field (OsalPort_MsgHdr.refCnt) ***/
+#define OsalPort_MSG_REF_CNT_MASK          0x3F  // Outstanding references
+#define OsalPort_MSG_REF_ATTACHED          0x40  // Holds a shared buffer after the payload
+#define OsalPort_MSG_REF_LINK              0x80  // Queue link to a shared buffer
+
 #define OsalPort_PWR_CONSERVE 0
 #define OsalPort_PWR_HOLD     1
 
@@ -114,6 +120,10 @@ typedef struct
 
   uint16_t len;
   uint8_t  dest_id;
+
+  /* Reference count and flags of shared messages. Uses the trailing
+   * padding byte so the header size seen by ROM code is unchanged. */
+  uint8_t  refCnt;
 } OsalPort_MsgHdr;
 
 typedef struct
@@ -181,7 +191,9 @@ extern uint8_t * OsalPort_msgAllocate(uint16_t len );
  *
  *    This function is used to deallocate a message buffer. This function
  *    is called by a task (or processing element) after it has finished
- *    processing a received message.
+ *    processing a received message.  For a shared message only the
+ *    caller's reference is released; the buffer is freed with the last
+ *    one.
  *
  *
  * @param   uint8_t *pMsg - pointer to new message buffer
@@ -209,6 +221,62 @@ extern uint8_t OsalPort_msgDeallocate( uint8_t *pMsg );
  */
 extern uint8_t OsalPort_msgSend( uint8_t destinationTask, uint8_t *pMsg );
 
+/*********************************************************************
+ * @fn      OsalPort_msgSendShared
+ *
+ * @brief
+ *
+ *    This function is called by a task to deliver the same read-only
+ *    message buffer to several tasks without copying it.  Each call
+ *    takes a new reference on the buffer and queues a small link to
+ *    the destination task, which receives the original buffer from
+ *    OsalPort_msgReceive() and releases its reference with
+ *    OsalPort_msgDeallocate().  The sender keeps its own reference and
+ *    must release it with OsalPort_msgDeallocate() once the fan-out is
+ *    done.  Receivers must not modify or forward a shared message.
+ *
+ * @param   uint8_t destinationTask - Send msg to Task ID
+ * @param   uint8_t *pMsg - pointer to message buffer to share
+ *
+ * @return  SUCCESS, INVALID_TASK, INVALID_MSG_POINTER,
+ *          MSG_BUFFER_NOT_AVAIL
+ */
+extern uint8_t OsalPort_msgSendShared( uint8_t destinationTask, uint8_t *pMsg );
+
+/*********************************************************************
+ * @fn      OsalPort_msgRetain
+ *
+ * @brief
+ *
+ *    Take an additional reference on a message buffer.  The buffer is
+ *    only freed once OsalPort_msgDeallocate() has been called for every
+ *    reference, so an owner can keep a buffer across sends and reuse it
+ *    when the reference count drops back to its own.
+ *
+ * @param   uint8_t *pMsg - pointer to message buffer
+ *
+ * @return  SUCCESS, MSG_BUFFER_NOT_AVAIL if the reference count is
+ *          saturated
+ */
+extern uint8_t OsalPort_msgRetain( uint8_t *pMsg );
+
+/*********************************************************************
+ * @fn      OsalPort_msgAllocateRef
+ *
+ * @brief
+ *
+ *    This function allocates a message buffer, like OsalPort_msgAllocate(),
+ *    that also holds a reference to a shared buffer.  The reference is
+ *    released when the message is deallocated, so per-task messages can
+ *    point into a common payload (e.g. an ASDU) instead of copying it.
+ *
+ * @param   uint16_t len - wanted buffer length
+ * @param   uint8_t *pShared - shared message buffer to reference
+ *
+ * @return  pointer to allocated buffer or NULL if allocation failed.
+ */
+extern uint8_t * OsalPort_msgAllocateRef( uint16_t len, uint8_t *pShared );
+
 /*********************************************************************
  * @fn      OsalPort_msgReceive
  *
@@ -244,6 +312,25 @@ extern uint8_t *OsalPort_msgReceive( uint8_t taskId );
  */
 extern OsalPort_EventHdr* OsalPort_msgFind(uint8_t taskId, uint8_t event);
 
+/**************************************************************************************************
+ * @fn          OsalPort_msgCount
+ *
+ * @brief       This function counts the OSAL messages waiting in the queue of a task.
+ *
+ * input parameters
+ *
+ * @param       taskId - The ID of the task.
+ * @param       max - The count at which to stop looking.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The number of messages queued, at most max.
+ **************************************************************************************************
+ */
+extern uint16_t OsalPort_msgCount(uint8_t taskId, uint16_t max);
+
 /*********************************************************************
  * @fn      OsalPort_setEvent
  *
@@ -111,6 +111,8 @@ extern "C"
 #define ZCD_NV_EX_APS_KEY_DATA_TABLE      0x0006
 #define ZCD_NV_EX_NWK_SEC_MATERIAL_TABLE  0x0007
 #define ZCD_NV_EX_GROUP_TABLE             0x0008
+#define ZCD_NV_EX_EVENT_LOG               0x0009
+#define ZCD_NV_EX_QUIRK_TABLE             0x000A
 
 // ZCL Port NV IDs (Application Layer NV Items)
 #define ZCL_PORT_SCENE_TABLE_NV_ID        0x0001
@@ -0,0 +1,363 @@
+/**************************************************************************************************
+  Filename:       zevtlog.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Network lifecycle event log.  Fixed size records are
+                  kept in a circular set of NV blocks and written a
+                  block at a time.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "rom_jt_154.h"
+#include "osal_nv.h"
+#include "osal_port_timers.h"
+#include "zd_app.h"
+#include "zevtlog.h"
+
+#ifdef FEATURE_UTC_TIME
+  #include "utc_clock.h"
+#endif //FEATURE_UTC_TIME
+
+#if defined ( FEATURE_EVENT_LOG )
+/*********************************************************************
+ * MACROS
+ */
+// Wrap safe sequence number comparison
+#define ZEVTLOG_SEQ_NEWER( a, b )   ((int16_t)((uint16_t)(a) - (uint16_t)(b)) > 0)
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define ZEVTLOG_BLOCK_LEN   (ZEVTLOG_BLOCK_RECS * sizeof( zevtlogRecord_t ))
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+// Block being filled, it replaces the NV copy of block ZEvtLogHead
+static zevtlogRecord_t ZEvtLogBlock[ZEVTLOG_BLOCK_RECS];
+static uint8_t ZEvtLogHead;       // NV sub ID of the block being filled
+static uint8_t ZEvtLogCount;      // Records in ZEvtLogBlock
+static uint8_t ZEvtLogDirty;      // ZEvtLogBlock differs from its NV copy
+static uint16_t ZEvtLogSeqNum;    // Sequence number of the next record
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8_t ZEvtLogReadBlock( uint8_t block, zevtlogRecord_t *pRecs );
+static uint8_t ZEvtLogMatch( zevtlogRecord_t *pRec, uint8_t type, uint16_t nwkAddr );
+
+/****************************************************************************
+ * @fn          ZEvtLogReadBlock
+ *
+ * @brief       Read a block of the log from NV.
+ *
+ * @param       block - block number
+ * @param       pRecs - ZEVTLOG_BLOCK_RECS records, cleared when the block
+ *                      was never written
+ *
+ * @return      Number of records used in the block
+ */
+static uint8_t ZEvtLogReadBlock( uint8_t block, zevtlogRecord_t *pRecs )
+{
+  uint8_t count = 0;
+
+  memset( pRecs, 0, ZEVTLOG_BLOCK_LEN );
+
+  if ( (osal_nv_item_len_ex( ZCD_NV_EX_EVENT_LOG, block ) != ZEVTLOG_BLOCK_LEN)
+      || (osal_nv_read_ex( ZCD_NV_EX_EVENT_LOG, block, 0, ZEVTLOG_BLOCK_LEN, pRecs ) != SUCCESS) )
+  {
+    memset( pRecs, 0, ZEVTLOG_BLOCK_LEN );
+    return ( 0 );
+  }
+
+  // Records are appended in order, the first unused one ends the block
+  while ( (count < ZEVTLOG_BLOCK_RECS) && (pRecs[count].type != ZEVTLOG_TYPE_NONE) )
+  {
+    count++;
+  }
+
+  return ( count );
+}
+
+/****************************************************************************
+ * @fn          ZEvtLogMatch
+ *
+ * @brief       Check a record against the ZEvtLogRead() filter.
+ *
+ * @param       pRec - record
+ * @param       type - ZEVTLOG_TYPE_* or ZEVTLOG_TYPE_ANY
+ * @param       nwkAddr - device, or INVALID_NODE_ADDR for any
+ *
+ * @return      TRUE if the record matches
+ */
+static uint8_t ZEvtLogMatch( zevtlogRecord_t *pRec, uint8_t type, uint16_t nwkAddr )
+{
+  return ( (pRec->type != ZEVTLOG_TYPE_NONE)
+           && ((type == ZEVTLOG_TYPE_ANY) || (pRec->type == type))
+           && ((nwkAddr == INVALID_NODE_ADDR) || (pRec->nwkAddr == nwkAddr)) );
+}
+#endif // FEATURE_EVENT_LOG
+
+/****************************************************************************
+ * @fn          ZEvtLogInit
+ *
+ * @brief       Find the newest block of the log in NV and resume appending
+ *              to it, so records written before a reset or power cut are
+ *              kept.
+ *
+ * @param       none.
+ *
+ * @return      none.
+ */
+void ZEvtLogInit( void )
+{
+#if defined ( FEATURE_EVENT_LOG )
+  uint8_t block;
+  uint8_t count;
+  uint8_t found = FALSE;
+  uint16_t newest = 0;
+
+  ZEvtLogHead = 0;
+
+  for ( block = 0; block < ZEVTLOG_NUM_BLOCKS; block++ )
+  {
+    count = ZEvtLogReadBlock( block, ZEvtLogBlock );
+
+    if ( (count > 0)
+        && ((found == FALSE) || ZEVTLOG_SEQ_NEWER( ZEvtLogBlock[count - 1].seqNum, newest )) )
+    {
+      found = TRUE;
+      newest = ZEvtLogBlock[count - 1].seqNum;
+      ZEvtLogHead = block;
+    }
+  }
+
+  ZEvtLogSeqNum = newest + 1;
+  ZEvtLogCount = ZEvtLogReadBlock( ZEvtLogHead, ZEvtLogBlock );
+  ZEvtLogDirty = FALSE;
+
+  if ( ZEvtLogCount == ZEVTLOG_BLOCK_RECS )
+  {
+    // Newest block is full, continue over the oldest one
+    ZEvtLogHead = (ZEvtLogHead + 1) % ZEVTLOG_NUM_BLOCKS;
+    ZEvtLogCount = 0;
+    memset( ZEvtLogBlock, 0, ZEVTLOG_BLOCK_LEN );
+  }
+#endif // FEATURE_EVENT_LOG
+}
+
+/****************************************************************************
+ * @fn          ZEvtLogAdd
+ *
+ * @brief       Append a record to the log.  A full block is written to NV
+ *              right away, a partly filled one after ZEVTLOG_FLUSH_DELAY.
+ *
+ * @param       type - ZEVTLOG_TYPE_*
+ * @param       info - type specific
+ * @param       param - type specific
+ * @param       nwkAddr - device the event is about
+ * @param       extAddr - its IEEE address, NULL if not known
+ *
+ * @return      none.
+ */
+void ZEvtLogAdd( uint8_t type, uint8_t info, uint8_t param,
+                 uint16_t nwkAddr, uint8_t *extAddr )
+{
+#if defined ( FEATURE_EVENT_LOG )
+  zevtlogRecord_t *pRec = &ZEvtLogBlock[ZEvtLogCount];
+
+#ifdef FEATURE_UTC_TIME
+  pRec->time = UTC_getClock();
+#else
+  pRec->time = MAP_osal_GetSystemClock() / 1000;
+#endif
+  pRec->seqNum = ZEvtLogSeqNum++;
+  pRec->type = type;
+  pRec->info = info;
+  pRec->nwkAddr = nwkAddr;
+  if ( extAddr != NULL )
+  {
+    osal_cpyExtAddr( pRec->extAddr, extAddr );
+  }
+  else
+  {
+    memset( pRec->extAddr, 0, Z_EXTADDR_LEN );
+  }
+  pRec->param = param;
+  pRec->reserved = 0;
+
+  ZEvtLogCount++;
+  ZEvtLogDirty = TRUE;
+
+  if ( ZEvtLogCount == ZEVTLOG_BLOCK_RECS )
+  {
+    OsalPortTimers_stopTimer( ZDAppTaskID, ZDO_EVENT_LOG_FLUSH_EVT );
+    ZEvtLogFlush();
+  }
+  else if ( !OsalPortTimers_getTimerTimeout( ZDAppTaskID, ZDO_EVENT_LOG_FLUSH_EVT ) )
+  {
+    OsalPortTimers_startTimer( ZDAppTaskID, ZDO_EVENT_LOG_FLUSH_EVT, ZEVTLOG_FLUSH_DELAY );
+  }
+#else
+  (void)type;
+  (void)info;
+  (void)param;
+  (void)nwkAddr;
+  (void)extAddr;
+#endif // FEATURE_EVENT_LOG
+}
+
+/****************************************************************************
+ * @fn          ZEvtLogFlush
+ *
+ * @brief       Write the block being filled to NV, and move on to the next
+ *              block once it is full.
+ *
+ * @param       none.
+ *
+ * @return      none.
+ */
+void ZEvtLogFlush( void )
+{
+#if defined ( FEATURE_EVENT_LOG )
+  if ( ZEvtLogDirty )
+  {
+    if ( osal_nv_write_ex( ZCD_NV_EX_EVENT_LOG, ZEvtLogHead,
+                           ZEVTLOG_BLOCK_LEN, ZEvtLogBlock ) == NV_ITEM_UNINIT )
+    {
+      (void)osal_nv_item_init_ex( ZCD_NV_EX_EVENT_LOG, ZEvtLogHead,
+                                  ZEVTLOG_BLOCK_LEN, ZEvtLogBlock );
+    }
+
+    ZEvtLogDirty = FALSE;
+  }
+
+  if ( ZEvtLogCount == ZEVTLOG_BLOCK_RECS )
+  {
+    ZEvtLogHead = (ZEvtLogHead + 1) % ZEVTLOG_NUM_BLOCKS;
+    ZEvtLogCount = 0;
+    memset( ZEvtLogBlock, 0, ZEVTLOG_BLOCK_LEN );
+  }
+#endif // FEATURE_EVENT_LOG
+}
+
+/****************************************************************************
+ * @fn          ZEvtLogRead
+ *
+ * @brief       Read records of the log, newest first.
+ *
+ * @param       type - ZEVTLOG_TYPE_* to return, or ZEVTLOG_TYPE_ANY
+ * @param       nwkAddr - device to return, or INVALID_NODE_ADDR for any
+ * @param       skip - number of matching records to skip
+ * @param       maxRecs - size of pRecs
+ * @param       pRecs - matching records
+ *
+ * @return      Number of records returned in pRecs
+ */
+uint8_t ZEvtLogRead( uint8_t type, uint16_t nwkAddr, uint16_t skip,
+                     uint8_t maxRecs, zevtlogRecord_t *pRecs )
+{
+  uint8_t found = 0;
+
+#if defined ( FEATURE_EVENT_LOG )
+  uint8_t block = ZEvtLogHead;
+  uint8_t n;
+  int8_t idx;
+
+  for ( n = 0; (n < ZEVTLOG_NUM_BLOCKS) && (found < maxRecs); n++ )
+  {
+    uint8_t count;
+
+    if ( n == 0 )
+    {
+      count = ZEvtLogCount;
+    }
+    else
+    {
+      block = (block + ZEVTLOG_NUM_BLOCKS - 1) % ZEVTLOG_NUM_BLOCKS;
+      count = ZEVTLOG_BLOCK_RECS;
+    }
+
+    for ( idx = count - 1; (idx >= 0) && (found < maxRecs); idx-- )
+    {
+      zevtlogRecord_t *pRec = &pRecs[found];
+
+      if ( n == 0 )
+      {
+        *pRec = ZEvtLogBlock[idx];
+      }
+      else if ( (osal_nv_item_len_ex( ZCD_NV_EX_EVENT_LOG, block ) != ZEVTLOG_BLOCK_LEN)
+               || (osal_nv_read_ex( ZCD_NV_EX_EVENT_LOG, block, idx * sizeof( zevtlogRecord_t ),
+                                    sizeof( zevtlogRecord_t ), pRec ) != SUCCESS) )
+      {
+        break;  // Block never written
+      }
+
+      if ( ZEvtLogMatch( pRec, type, nwkAddr ) )
+      {
+        if ( skip > 0 )
+        {
+          skip--;
+        }
+        else
+        {
+          found++;
+        }
+      }
+    }
+  }
+#else
+  (void)type;
+  (void)nwkAddr;
+  (void)skip;
+  (void)maxRecs;
+  (void)pRecs;
+#endif // FEATURE_EVENT_LOG
+
+  return ( found );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,135 @@
+/**************************************************************************************************
+  Filename:       zevtlog.h
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    This interface provides all the definitions for the
+                  network lifecycle event log.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef ZEVTLOG_H
+#define ZEVTLOG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcomdef.h"
+
+
+/*********************************************************************
+ * MACROS
+ */
+
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Number of records written to NV together, and number of such blocks
+// kept in NV.  The log holds ZEVTLOG_BLOCK_RECS * ZEVTLOG_NUM_BLOCKS
+// records, the oldest block is overwritten when it is full.
+#if !defined ( ZEVTLOG_BLOCK_RECS )
+  #define ZEVTLOG_BLOCK_RECS              8
+#endif
+#if !defined ( ZEVTLOG_NUM_BLOCKS )
+  #define ZEVTLOG_NUM_BLOCKS              8
+#endif
+
+// Delay before a partly filled block is written to NV, in milliseconds
+#if !defined ( ZEVTLOG_FLUSH_DELAY )
+  #define ZEVTLOG_FLUSH_DELAY             10000
+#endif
+
+// Event types
+#define ZEVTLOG_TYPE_NONE                 0x00  // Unused record
+#define ZEVTLOG_TYPE_JOIN                 0x01  // info: NWK_ASSOC_* join type, param: capabilities
+#define ZEVTLOG_TYPE_LEAVE                0x02  // info: ZEVTLOG_LEAVE_* flags
+#define ZEVTLOG_TYPE_TC_KEY_EXCH          0x03  // info: BDB_TC_LK_EXCH_PROCESS_* status
+#define ZEVTLOG_TYPE_ADDR_CHANGE          0x04  // This device changed its short address
+#define ZEVTLOG_TYPE_NWK_STATUS           0x05  // info: NWKSTAT_* status code
+
+#define ZEVTLOG_TYPE_ANY                  0xFF  // ZEvtLogRead() filter for all types
+
+// ZEVTLOG_TYPE_LEAVE info flags
+#define ZEVTLOG_LEAVE_REQUEST             0x01
+#define ZEVTLOG_LEAVE_REMOVE_CHILDREN     0x02
+#define ZEVTLOG_LEAVE_REJOIN              0x04
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint32_t time;                      // Seconds, UTC with FEATURE_UTC_TIME, since reset otherwise
+  uint16_t seqNum;                    // Increments with every record, orders the log
+  uint8_t  type;                      // ZEVTLOG_TYPE_*
+  uint8_t  info;                      // Type specific, see ZEVTLOG_TYPE_*
+  uint16_t nwkAddr;                   // Device the event is about
+  uint8_t  extAddr[Z_EXTADDR_LEN];    // Its IEEE address, all 0 when not known
+  uint8_t  param;                     // Type specific, see ZEVTLOG_TYPE_*
+  uint8_t  reserved;
+} zevtlogRecord_t;
+
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern void ZEvtLogInit( void );
+
+extern void ZEvtLogAdd( uint8_t type, uint8_t info, uint8_t param,
+                        uint16_t nwkAddr, uint8_t *extAddr );
+
+extern void ZEvtLogFlush( void );
+
+extern uint8_t ZEvtLogRead( uint8_t type, uint16_t nwkAddr, uint16_t skip,
+                            uint8_t maxRecs, zevtlogRecord_t *pRecs );
+
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEVTLOG_H */
@@ -0,0 +1,487 @@
+/**************************************************************************************************
+  Filename:       zquirk.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host loaded device quirk table.  Entries keyed by IEEE
+                  address, manufacturer code or OUI select behaviors that
+                  the stack applies to a device at a few hook points.  The
+                  behaviors resolved for a device are cached by its
+                  address manager index.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "rom_jt_154.h"
+#include "osal_nv.h"
+#include "addr_mgr.h"
+#include "nwk.h"
+#include "nwk_globals.h"
+#include "zquirk.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define ZQUIRK_TABLE_LEN    (ZQUIRK_MAX_ENTRIES * sizeof( zquirkEntry_t ))
+
+// Devices whose resolved behaviors are cached, by address manager index
+#if !defined ( ZQUIRK_MAX_DEVICES )
+  #define ZQUIRK_MAX_DEVICES  NWK_MAX_ADDRESSES
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t  extAddr[Z_EXTADDR_LEN];  // Device the record was filled for
+  uint16_t manufCode;               // From its node descriptor, ZQUIRK_MANUF_UNKNOWN until seen
+  uint8_t  quirks;                  // Behaviors resolved for it
+  uint8_t  gen;                     // ZQuirkGen the behaviors were resolved with, 0 for none
+} zquirkDev_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static zquirkEntry_t ZQuirkTable[ZQUIRK_MAX_ENTRIES];
+static uint8_t ZQuirkCnt;         // Used entries in ZQuirkTable
+static uint8_t ZQuirkGen = 1;     // Changes with the table, stales the cached behaviors
+
+static zquirkDev_t ZQuirkDev[ZQUIRK_MAX_DEVICES];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8_t ZQuirkResolve( uint8_t *extAddr, uint16_t manufCode );
+static uint8_t ZQuirkEntryLookup( AddrMgrEntry_t *pEntry );
+static zquirkDev_t *ZQuirkDevGet( AddrMgrEntry_t *pEntry );
+static void ZQuirkChanged( void );
+
+/****************************************************************************
+ * @fn          ZQuirkResolve
+ *
+ * @brief       Find the behaviors of a device in the table.  An IEEE
+ *              address entry overrides a manufacturer code entry, which
+ *              overrides an OUI entry.
+ *
+ * @param       extAddr - IEEE address of the device
+ * @param       manufCode - its manufacturer code, or ZQUIRK_MANUF_UNKNOWN
+ *
+ * @return      ZQUIRK_* behaviors
+ */
+static uint8_t ZQuirkResolve( uint8_t *extAddr, uint16_t manufCode )
+{
+  zquirkEntry_t *pEntry;
+  uint8_t keyType = ZQUIRK_KEY_NONE;
+  uint8_t quirks = 0;
+  uint8_t match;
+  uint8_t i;
+
+  for ( i = 0; i < ZQUIRK_MAX_ENTRIES; i++ )
+  {
+    pEntry = &ZQuirkTable[i];
+
+    if ( pEntry->keyType <= keyType )
+    {
+      continue;   // Unused or not more specific than the match so far
+    }
+
+    switch ( pEntry->keyType )
+    {
+      case ZQUIRK_KEY_IEEE:
+        match = osal_ExtAddrEqual( pEntry->key, extAddr );
+        break;
+
+      case ZQUIRK_KEY_MANUF:
+        match = ( (manufCode != ZQUIRK_MANUF_UNKNOWN)
+                  && (BUILD_UINT16( pEntry->key[0], pEntry->key[1] ) == manufCode) );
+        break;
+
+      case ZQUIRK_KEY_OUI:
+        match = ( (pEntry->key[0] == extAddr[5])
+                  && (pEntry->key[1] == extAddr[6])
+                  && (pEntry->key[2] == extAddr[7]) );
+        break;
+
+      default:
+        match = FALSE;
+        break;
+    }
+
+    if ( match )
+    {
+      keyType = pEntry->keyType;
+      quirks = pEntry->quirks;
+    }
+  }
+
+  return ( quirks );
+}
+
+/****************************************************************************
+ * @fn          ZQuirkDevGet
+ *
+ * @brief       Cache record of an address manager entry.  A record left by
+ *              another device at the same index is restarted; the same
+ *              device under a new short address keeps its record.
+ *
+ * @param       pEntry - address manager entry
+ *
+ * @return      Record, NULL if the index is beyond the cache
+ */
+static zquirkDev_t *ZQuirkDevGet( AddrMgrEntry_t *pEntry )
+{
+  zquirkDev_t *pDev;
+
+  if ( pEntry->index >= ZQUIRK_MAX_DEVICES )
+  {
+    return ( NULL );
+  }
+
+  pDev = &ZQuirkDev[pEntry->index];
+
+  if ( !osal_ExtAddrEqual( pDev->extAddr, pEntry->extAddr ) )
+  {
+    osal_cpyExtAddr( pDev->extAddr, pEntry->extAddr );
+    pDev->manufCode = ZQUIRK_MANUF_UNKNOWN;
+    pDev->gen = 0;
+  }
+
+  return ( pDev );
+}
+
+/****************************************************************************
+ * @fn          ZQuirkEntryLookup
+ *
+ * @brief       Behaviors of an address manager entry, from its cache record
+ *              unless the table changed since they were resolved.
+ *
+ * @param       pEntry - address manager entry
+ *
+ * @return      ZQUIRK_* behaviors
+ */
+static uint8_t ZQuirkEntryLookup( AddrMgrEntry_t *pEntry )
+{
+  zquirkDev_t *pDev = ZQuirkDevGet( pEntry );
+
+  if ( pDev == NULL )
+  {
+    return ( ZQuirkResolve( pEntry->extAddr, ZQUIRK_MANUF_UNKNOWN ) );
+  }
+
+  if ( pDev->gen != ZQuirkGen )
+  {
+    pDev->quirks = ZQuirkResolve( pEntry->extAddr, pDev->manufCode );
+    pDev->gen = ZQuirkGen;
+  }
+
+  return ( pDev->quirks );
+}
+
+/****************************************************************************
+ * @fn          ZQuirkChanged
+ *
+ * @brief       Stale the cached behaviors and write the table to NV.
+ *
+ * @param       none.
+ *
+ * @return      none.
+ */
+static void ZQuirkChanged( void )
+{
+  uint16_t i;
+
+  if ( ++ZQuirkGen == 0 )
+  {
+    // Records resolved 255 changes ago would look current again
+    for ( i = 0; i < ZQUIRK_MAX_DEVICES; i++ )
+    {
+      ZQuirkDev[i].gen = 0;
+    }
+    ZQuirkGen = 1;
+  }
+
+  if ( osal_nv_write_ex( ZCD_NV_EX_QUIRK_TABLE, 0,
+                         ZQUIRK_TABLE_LEN, ZQuirkTable ) == NV_ITEM_UNINIT )
+  {
+    (void)osal_nv_item_init_ex( ZCD_NV_EX_QUIRK_TABLE, 0,
+                                ZQUIRK_TABLE_LEN, ZQuirkTable );
+  }
+}
+
+/****************************************************************************
+ * @fn          ZQuirkInit
+ *
+ * @brief       Restore the table from NV.
+ *
+ * @param       none.
+ *
+ * @return      none.
+ */
+void ZQuirkInit( void )
+{
+  uint16_t i;
+
+  ZQuirkCnt = 0;
+
+  if ( (osal_nv_item_len_ex( ZCD_NV_EX_QUIRK_TABLE, 0 ) != ZQUIRK_TABLE_LEN)
+      || (osal_nv_read_ex( ZCD_NV_EX_QUIRK_TABLE, 0, 0, ZQUIRK_TABLE_LEN, ZQuirkTable ) != SUCCESS) )
+  {
+    memset( ZQuirkTable, 0, ZQUIRK_TABLE_LEN );
+  }
+
+  for ( i = 0; i < ZQUIRK_MAX_ENTRIES; i++ )
+  {
+    if ( ZQuirkTable[i].keyType != ZQUIRK_KEY_NONE )
+    {
+      ZQuirkCnt++;
+    }
+  }
+
+  for ( i = 0; i < ZQUIRK_MAX_DEVICES; i++ )
+  {
+    memset( ZQuirkDev[i].extAddr, 0xFF, Z_EXTADDR_LEN );
+    ZQuirkDev[i].manufCode = ZQUIRK_MANUF_UNKNOWN;
+    ZQuirkDev[i].gen = 0;
+  }
+}
+
+/****************************************************************************
+ * @fn          ZQuirkSet
+ *
+ * @brief       Add, change or remove the entry of a key.
+ *
+ * @param       keyType - ZQUIRK_KEY_*, ZQUIRK_KEY_ALL to clear the table
+ * @param       key - see ZQUIRK_KEY_*, Z_EXTADDR_LEN bytes
+ * @param       quirks - ZQUIRK_* behaviors, 0 removes the entry
+ *
+ * @return      ZSuccess, ZInvalidParameter for an unknown key type,
+ *              ZNwkTableFull when no entry is free
+ */
+ZStatus_t ZQuirkSet( uint8_t keyType, uint8_t *key, uint8_t quirks )
+{
+  zquirkEntry_t entry;
+  zquirkEntry_t *pFree = NULL;
+  uint8_t i;
+
+  if ( keyType == ZQUIRK_KEY_ALL )
+  {
+    memset( ZQuirkTable, 0, ZQUIRK_TABLE_LEN );
+    ZQuirkCnt = 0;
+    ZQuirkChanged();
+    return ( ZSuccess );
+  }
+
+  if ( (keyType == ZQUIRK_KEY_NONE) || (keyType > ZQUIRK_KEY_IEEE) )
+  {
+    return ( ZInvalidParameter );
+  }
+
+  // Keep unused key bytes 0 so that keys compare as a whole
+  memset( &entry, 0, sizeof( entry ) );
+  entry.keyType = keyType;
+  entry.quirks = quirks;
+  if ( keyType == ZQUIRK_KEY_IEEE )
+  {
+    osal_cpyExtAddr( entry.key, key );
+  }
+  else
+  {
+    memcpy( entry.key, key, (keyType == ZQUIRK_KEY_OUI) ? 3 : 2 );
+  }
+
+  for ( i = 0; i < ZQUIRK_MAX_ENTRIES; i++ )
+  {
+    if ( ZQuirkTable[i].keyType == ZQUIRK_KEY_NONE )
+    {
+      if ( pFree == NULL )
+      {
+        pFree = &ZQuirkTable[i];
+      }
+    }
+    else if ( (ZQuirkTable[i].keyType == keyType)
+             && (memcmp( ZQuirkTable[i].key, entry.key, Z_EXTADDR_LEN ) == 0) )
+    {
+      break;
+    }
+  }
+
+  if ( i < ZQUIRK_MAX_ENTRIES )
+  {
+    if ( quirks == 0 )
+    {
+      memset( &ZQuirkTable[i], 0, sizeof( zquirkEntry_t ) );
+      ZQuirkCnt--;
+    }
+    else
+    {
+      ZQuirkTable[i].quirks = quirks;
+    }
+  }
+  else if ( quirks == 0 )
+  {
+    return ( ZSuccess );   // Nothing to remove
+  }
+  else if ( pFree == NULL )
+  {
+    return ( ZNwkTableFull );
+  }
+  else
+  {
+    *pFree = entry;
+    ZQuirkCnt++;
+  }
+
+  ZQuirkChanged();
+
+  return ( ZSuccess );
+}
+
+/****************************************************************************
+ * @fn          ZQuirkRead
+ *
+ * @brief       Read an entry of the table.
+ *
+ * @param       idx - entry index
+ * @param       pEntry - entry, keyType ZQUIRK_KEY_NONE when unused
+ *
+ * @return      FALSE when idx is beyond the table
+ */
+uint8_t ZQuirkRead( uint8_t idx, zquirkEntry_t *pEntry )
+{
+  if ( idx >= ZQUIRK_MAX_ENTRIES )
+  {
+    return ( FALSE );
+  }
+
+  *pEntry = ZQuirkTable[idx];
+
+  return ( TRUE );
+}
+
+/****************************************************************************
+ * @fn          ZQuirkLookupNwk
+ *
+ * @brief       Behaviors of a device by its short address.
+ *
+ * @param       nwkAddr - short address
+ *
+ * @return      ZQUIRK_* behaviors, 0 when its IEEE address is not known
+ */
+uint8_t ZQuirkLookupNwk( uint16_t nwkAddr )
+{
+  AddrMgrEntry_t entry;
+
+  if ( ZQuirkCnt == 0 )
+  {
+    return ( 0 );
+  }
+
+  entry.user = ADDRMGR_USER_DEFAULT;
+  entry.nwkAddr = nwkAddr;
+  if ( AddrMgrEntryLookupNwk( &entry ) == FALSE )
+  {
+    return ( 0 );
+  }
+
+  return ( ZQuirkEntryLookup( &entry ) );
+}
+
+/****************************************************************************
+ * @fn          ZQuirkLookupExt
+ *
+ * @brief       Behaviors of a device by its IEEE address.
+ *
+ * @param       extAddr - IEEE address
+ *
+ * @return      ZQUIRK_* behaviors
+ */
+uint8_t ZQuirkLookupExt( uint8_t *extAddr )
+{
+  AddrMgrEntry_t entry;
+
+  if ( ZQuirkCnt == 0 )
+  {
+    return ( 0 );
+  }
+
+  entry.user = ADDRMGR_USER_DEFAULT;
+  osal_cpyExtAddr( entry.extAddr, extAddr );
+  if ( AddrMgrEntryLookupExt( &entry ) == FALSE )
+  {
+    // Not in the address manager, manufacturer code entries cannot apply
+    return ( ZQuirkResolve( extAddr, ZQUIRK_MANUF_UNKNOWN ) );
+  }
+
+  return ( ZQuirkEntryLookup( &entry ) );
+}
+
+/****************************************************************************
+ * @fn          ZQuirkSetManufCode
+ *
+ * @brief       Record the manufacturer code of a device from its node
+ *              descriptor, for the manufacturer code entries.
+ *
+ * @param       nwkAddr - short address
+ * @param       manufCode - manufacturer code
+ *
+ * @return      none.
+ */
+void ZQuirkSetManufCode( uint16_t nwkAddr, uint16_t manufCode )
+{
+  AddrMgrEntry_t entry;
+  zquirkDev_t *pDev;
+
+  entry.user = ADDRMGR_USER_DEFAULT;
+  entry.nwkAddr = nwkAddr;
+  if ( (AddrMgrEntryLookupNwk( &entry ) == TRUE)
+      && ((pDev = ZQuirkDevGet( &entry )) != NULL)
+      && (pDev->manufCode != manufCode) )
+  {
+    pDev->manufCode = manufCode;
+    pDev->gen = 0;
+  }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,124 @@
+/**************************************************************************************************
+  Filename:       zquirk.h
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    This interface provides all the definitions for the
+                  host loaded device quirk table.
+
+
+  Copyright 2026 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef ZQUIRK_H
+#define ZQUIRK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcomdef.h"
+
+
+/*********************************************************************
+ * MACROS
+ */
+
+
+/*********************************************************************
+ * CONSTANTS
+ */
+// Number of quirk entries the host can load
+#if !defined ( ZQUIRK_MAX_ENTRIES )
+  #define ZQUIRK_MAX_ENTRIES              16
+#endif
+
+// Key types, a more specific key overrides a less specific one
+#define ZQUIRK_KEY_NONE                   0x00  // Unused entry
+#define ZQUIRK_KEY_OUI                    0x01  // key[0..2]: OUI, the upper 3 bytes of the IEEE address, LSB first
+#define ZQUIRK_KEY_MANUF                  0x02  // key[0..1]: manufacturer code of the node descriptor, LSB first
+#define ZQUIRK_KEY_IEEE                   0x03  // key: IEEE address
+
+#define ZQUIRK_KEY_ALL                    0xFF  // ZQuirkSet() key type clearing the whole table
+
+// Behaviors
+#define ZQUIRK_ANY_PROFILE                0x01  // AF accepts its frames on any application endpoint, whatever the profile
+#define ZQUIRK_APS_ACK                    0x02  // Unicasts to it always request an APS ACK
+#define ZQUIRK_NO_APS_ACK                 0x04  // Unicasts to it never request an APS ACK
+#define ZQUIRK_NO_SRC_ROUTE               0x08  // Unicasts to it go out one hop while it is a child, else without a kept or host source route
+
+// Manufacturer code of a device whose node descriptor was not seen
+#define ZQUIRK_MANUF_UNKNOWN              0xFFFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint8_t  keyType;                   // ZQUIRK_KEY_*
+  uint8_t  quirks;                    // ZQUIRK_* behaviors
+  uint8_t  key[Z_EXTADDR_LEN];        // See ZQUIRK_KEY_*, unused bytes are 0
+} zquirkEntry_t;
+
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern void ZQuirkInit( void );
+
+extern ZStatus_t ZQuirkSet( uint8_t keyType, uint8_t *key, uint8_t quirks );
+
+extern uint8_t ZQuirkRead( uint8_t idx, zquirkEntry_t *pEntry );
+
+extern uint8_t ZQuirkLookupNwk( uint16_t nwkAddr );
+
+extern uint8_t ZQuirkLookupExt( uint8_t *extAddr );
+
+extern void ZQuirkSetManufCode( uint16_t nwkAddr, uint16_t manufCode );
+
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZQUIRK_H */
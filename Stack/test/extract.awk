@@ -0,0 +1,172 @@
+#
+# Copies the top level items of a C file whose name matches the regular
+# expression "names" as a whole: macros with their "#if !defined"
+# default, types, variables, prototypes and function definitions, in
+# file order.  The host tests build the parts of a module too large to
+# build on the host this way, the items come out as they are in the tree.
+#
+#   awk -v names='afGroupEpMap|AF_EP_MAP_LEN' -f extract.awk af.c
+#
+# Items are found by their first line starting in column 0, as the
+# sources are laid out.
+#
+
+# Name declared by an item spanning lines[first..last]
+function itemName( first, last,    s, i, head )
+{
+  s = lines[last];
+  if ( s ~ /^}[^;]*;/ )
+  {
+    # Named at its closing brace: a struct typedef or variable
+    sub( /^}[ \t]*/, "", s );
+    if ( match( s, /^[A-Za-z_][A-Za-z0-9_]*/ ) )
+    {
+      return ( substr( s, RSTART, RLENGTH ) );
+    }
+  }
+
+  head = "";
+  for ( i = first; i <= last; i++ )
+  {
+    head = head " " lines[i];
+  }
+  sub( /[{=;].*/, "", head );
+
+  # Function pointer
+  if ( match( head, /\([ \t]*\*[ \t]*[A-Za-z_][A-Za-z0-9_]*[ \t]*\)/ ) )
+  {
+    s = substr( head, RSTART, RLENGTH );
+    gsub( /[^A-Za-z0-9_]/, "", s );
+    return ( s );
+  }
+
+  # Function, unless an array sized by an expression
+  if ( index( head, "(" ) && !(index( head, "[" ) && (index( head, "[" ) < index( head, "(" ))) )
+  {
+    sub( /[ \t]*\(.*/, "", head );
+  }
+  else
+  {
+    sub( /\[.*/, "", head );
+  }
+  sub( /[ \t]+$/, "", head );
+  match( head, /[A-Za-z_][A-Za-z0-9_]*$/ );
+  return ( substr( head, RSTART, RLENGTH ) );
+}
+
+function emit( first, last,    i )
+{
+  if ( itemName( first, last ) ~ names )
+  {
+    for ( i = first; i <= last; i++ )
+    {
+      print lines[i];
+    }
+    print "";
+  }
+}
+
+BEGIN {
+  names = "^(" names ")$";
+}
+
+{
+  lines[NR] = $0;
+}
+
+END {
+  n = NR;
+  i = 1;
+  while ( i <= n )
+  {
+    line = lines[i];
+
+    # Comments
+    if ( line ~ /^[ \t]*\/\*/ )
+    {
+      while ( (i < n) && (lines[i] !~ /\*\//) )
+      {
+        i++;
+      }
+      i++;
+      continue;
+    }
+
+    # Macro
+    if ( line ~ /^[ \t]*#[ \t]*define[ \t]/ )
+    {
+      first = i;
+      while ( (i < n) && (lines[i] ~ /\\$/) )
+      {
+        i++;
+      }
+      s = lines[first];
+      sub( /^[ \t]*#[ \t]*define[ \t]+/, "", s );
+      match( s, /^[A-Za-z_][A-Za-z0-9_]*/ );
+      if ( substr( s, RSTART, RLENGTH ) ~ names )
+      {
+        for ( j = first; j <= i; j++ )
+        {
+          print lines[j];
+        }
+      }
+      i++;
+      continue;
+    }
+
+    # Default of a macro: #if !defined X / #define X / #endif
+    if ( (line ~ /^#[ \t]*(if[ \t]+!defined|ifndef)/) &&
+         (i + 2 <= n) && (lines[i + 1] ~ /^[ \t]*#[ \t]*define[ \t]/) &&
+         (lines[i + 2] ~ /^[ \t]*#[ \t]*endif/) )
+    {
+      s = lines[i + 1];
+      sub( /^[ \t]*#[ \t]*define[ \t]+/, "", s );
+      match( s, /^[A-Za-z_][A-Za-z0-9_]*/ );
+      if ( substr( s, RSTART, RLENGTH ) ~ names )
+      {
+        print lines[i];
+        print lines[i + 1];
+        print lines[i + 2];
+      }
+      i += 3;
+      continue;
+    }
+
+    # C++ linkage of a header, not an item
+    if ( line ~ /^extern[ \t]+"C"/ )
+    {
+      if ( (i < n) && (lines[i + 1] ~ /^{/) )
+      {
+        i++;
+      }
+      i++;
+      continue;
+    }
+
+    # Declaration or definition
+    if ( line ~ /^[A-Za-z_]/ )
+    {
+      first = i;
+      for ( ;; )
+      {
+        if ( lines[i] ~ /^{/ )
+        {
+          # Body or initializer, up to the closing brace
+          while ( (i < n) && (lines[i] !~ /^}/) )
+          {
+            i++;
+          }
+          break;
+        }
+        if ( (lines[i] ~ /;[ \t]*(\/\/.*|\/\*.*)?$/) || (i >= n) )
+        {
+          break;
+        }
+        i++;
+      }
+      emit( first, i );
+    }
+
+    i++;
+  }
+}
@@ -0,0 +1,23 @@
+/* Host stand-in for addr_mgr.h: the address manager calls, implemented
+ * by the tests. */
+#ifndef ADDR_MGR_H
+#define ADDR_MGR_H
+
+#include "zcomdef.h"
+
+#define ADDRMGR_USER_DEFAULT  0x00
+
+typedef struct
+{
+  uint8_t  user;
+  uint16_t nwkAddr;
+  uint8_t  extAddr[Z_EXTADDR_LEN];
+  uint16_t index;
+} AddrMgrEntry_t;
+
+extern uint8_t AddrMgrExtAddrLookup( uint16_t nwkAddr, uint8_t* extAddr );
+extern uint8_t AddrMgrEntryLookupNwk( AddrMgrEntry_t* entry );
+extern uint8_t AddrMgrEntryLookupExt( AddrMgrEntry_t* entry );
+extern uint8_t AddrMgrEntryGet( AddrMgrEntry_t* entry );
+
+#endif
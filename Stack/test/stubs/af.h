@@ -0,0 +1,128 @@
+/* Host stand-in for af.h: the endpoint and message types, the calls are
+ * implemented by the tests. */
+#ifndef AF_H
+#define AF_H
+
+#include "zcomdef.h"
+
+#define AF_TX_OPTIONS_NONE    0
+#define AF_DESCRIPTOR_PROFILE_ID  2
+#define AF_DEFAULT_RADIUS     30
+
+#define afStatus_SUCCESS            ZSuccess
+#define afStatus_INVALID_PARAMETER  ZInvalidParameter
+#define afStatus_MEM_FAIL           ZMemError
+
+typedef ZStatus_t afStatus_t;
+
+typedef uint16_t cId_t;
+
+typedef struct
+{
+  uint8_t   EndPoint;
+  uint16_t  AppProfId;
+  uint16_t  AppDeviceId;
+  uint8_t   AppDevVer:4;
+  uint8_t   Reserved:4;
+  uint8_t   AppNumInClusters;
+  cId_t    *pAppInClusterList;
+  uint8_t   AppNumOutClusters;
+  cId_t    *pAppOutClusterList;
+} SimpleDescriptionFormat_t;
+
+typedef struct
+{
+  uint16_t  DataLength;
+  uint8_t  *Data;
+} afMSGCommandFormat_t;
+
+typedef enum
+{
+  noLatencyReqs,
+  fastBeacons,
+  slowBeacons
+} afNetworkLatencyReq_t;
+
+typedef enum
+{
+  afAddrNotPresent = AddrNotPresent,
+  afAddr16Bit      = Addr16Bit,
+  afAddr64Bit      = Addr64Bit,
+  afAddrGroup      = AddrGroup,
+  afAddrBroadcast  = AddrBroadcast
+} afAddrMode_t;
+
+typedef struct
+{
+  union
+  {
+    uint16_t    shortAddr;
+    ZLongAddr_t extAddr;
+  } addr;
+  afAddrMode_t addrMode;
+  uint8_t endPoint;
+  uint16_t panId;
+} afAddrType_t;
+
+typedef struct
+{
+  OsalPort_EventHdr hdr;
+  uint16_t groupId;
+  uint16_t clusterId;
+  afAddrType_t srcAddr;
+  uint16_t macDestAddr;
+  uint8_t endPoint;
+  uint8_t wasBroadcast;
+  uint8_t LinkQuality;
+  uint8_t correlation;
+  int8_t  rssi;
+  uint8_t SecurityUse;
+  uint32_t timestamp;
+  uint8_t nwkSeqNum;
+  afMSGCommandFormat_t cmd;
+  uint16_t macSrcAddr;
+  uint8_t radius;
+} afIncomingMSGPacket_t;
+
+typedef struct
+{
+  OsalPort_EventHdr hdr;
+  uint8_t endpoint;
+  uint8_t transID;
+  uint16_t clusterID;
+} afDataConfirm_t;
+
+typedef struct
+{
+  uint8_t endPoint;
+  uint8_t epType;
+  uint8_t *task_id;
+  SimpleDescriptionFormat_t *simpleDesc;
+  afNetworkLatencyReq_t latencyReq;
+} endPointDesc_t;
+
+typedef void *(*pDescCB)( uint8_t type, uint8_t endpoint );
+typedef void (*pApplCB)( void *req );
+typedef uint8_t (*pIncomingCB)( afIncomingMSGPacket_t *pkt );
+typedef uint8_t (*pIncomingMultiCB)( afIncomingMSGPacket_t *pkt, uint8_t *epMap, uint8_t epMapLen );
+
+typedef struct _epList_t
+{
+  struct _epList_t *nextDesc;
+  endPointDesc_t *epDesc;
+  pDescCB  pfnDescCB;
+  pApplCB pfnApplCB;
+  pIncomingCB pfnIncomingCB;
+  pIncomingMultiCB pfnIncomingMultiCB;
+} epList_t;
+
+extern epList_t *afRegisterExtended( endPointDesc_t *epDesc, pDescCB descFn, pApplCB applFn );
+extern afStatus_t afDelete( uint8_t EndPoint );
+extern endPointDesc_t *afFindEndPointDesc( uint8_t endPoint );
+extern uint8_t afSetIncomingCB( uint8_t endPoint, pIncomingCB pIncomingFn );
+extern uint8_t afSetIncomingMultiCB( uint8_t endPoint, pIncomingMultiCB pIncomingMultiFn );
+extern afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                                  uint16_t cID, uint16_t len, uint8_t *buf, uint8_t *transID,
+                                  uint8_t options, uint8_t radius );
+
+#endif
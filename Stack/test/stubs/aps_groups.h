@@ -0,0 +1,24 @@
+/* Host stand-in for aps_groups.h: the group table. */
+#ifndef APS_GROUPS_H
+#define APS_GROUPS_H
+
+#include "zcomdef.h"
+
+#define APS_GROUP_NAME_LEN  16
+
+typedef struct
+{
+  uint16_t ID;
+  uint8_t  name[APS_GROUP_NAME_LEN];
+} aps_Group_t;
+
+typedef struct apsGroupItem
+{
+  struct apsGroupItem *next;
+  uint8_t              endpoint;
+  aps_Group_t          group;
+} apsGroupItem_t;
+
+extern apsGroupItem_t *apsGroupTable;
+
+#endif
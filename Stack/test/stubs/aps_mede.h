@@ -0,0 +1,7 @@
+/* Host stand-in for aps_mede.h: nothing the modules under test use. */
+#ifndef APS_MEDE_H
+#define APS_MEDE_H
+
+#include "zcomdef.h"
+
+#endif
@@ -0,0 +1,45 @@
+/* Host stand-in for assoc_list.h: the association table. */
+#ifndef ASSOC_LIST_H
+#define ASSOC_LIST_H
+
+#include "zcomdef.h"
+#include "nwk_globals.h"
+#include "nwk_util.h"
+
+#define PARENT              0
+#define CHILD_RFD           1
+#define CHILD_RFD_RX_IDLE   2
+#define CHILD_FFD           3
+#define CHILD_FFD_RX_IDLE   4
+#define NEIGHBOR            5
+#define OTHER               6
+#define NOTUSED             0xFF
+
+#define TIMEOUT_NOT_USED    0xFFFFFFFF
+
+typedef struct
+{
+  uint8_t  endDevCfg;
+  uint32_t deviceTimeout;
+} aging_end_device_t;
+
+typedef struct
+{
+  uint16_t shortAddr;
+  uint16_t addrIdx;
+  byte nodeRelation;
+  byte devStatus;
+  byte assocCnt;
+  byte age;
+  linkInfo_t linkInfo;
+  aging_end_device_t endDev;
+  uint32_t timeoutCounter;
+  bool keepaliveRcv;
+} associated_devices_t;
+
+extern associated_devices_t AssociatedDevList[];
+
+extern associated_devices_t *AssocGetWithShort( uint16_t shortAddr );
+extern byte AssocRemove( byte *extAddr );
+
+#endif
@@ -0,0 +1,32 @@
+/* Host stand-in for comdef.h: the basic types and macros the modules
+ * under test use. */
+#ifndef COMDEF_H
+#define COMDEF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef int8_t  int8;
+typedef uint8_t byte;
+
+#ifndef TRUE
+  #define TRUE  1
+#endif
+#ifndef FALSE
+  #define FALSE 0
+#endif
+
+#define SUCCESS             0x00
+#define NV_ITEM_UNINIT      0x09
+#define NV_OPER_FAILED      0x0A
+#define NV_BAD_ITEM_LEN     0x0C
+
+#define BV( n )                   ( 1 << (n) )
+#define BUILD_UINT16( lo, hi )    ( (uint16_t)(((lo) & 0x00FF) + (((hi) & 0x00FF) << 8)) )
+#define LO_UINT16( a )            ( (a) & 0xFF )
+#define HI_UINT16( a )            ( ((a) >> 8) & 0xFF )
+#define BREAK_UINT32( var, n )    ( (uint8_t)(((var) >> ((n) * 8)) & 0xFF) )
+
+#endif
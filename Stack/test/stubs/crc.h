@@ -0,0 +1,13 @@
+/* Host stand-in for the pycrc generated crc.h of crc.c: the CRC-8 NVOCMP
+ * checks its items with. */
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t crc_t;
+
+extern crc_t crc_update( crc_t crc, const void *data, size_t data_len );
+
+#endif
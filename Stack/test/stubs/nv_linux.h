@@ -0,0 +1,30 @@
+/* Host stand-in for nv_linux.h: the flash NVOCMP is built over with
+ * NV_LINUX, implemented by the tests. */
+#ifndef NV_LINUX_H
+#define NV_LINUX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef void *NVS_Handle;
+
+typedef struct
+{
+  size_t sectorSize;
+  size_t regionSize;
+} NVS_Attrs;
+
+#define NVS_HANDLE                      ((NVS_Handle)1)
+#define FLASH_PAGE_SIZE                 0x2000
+
+#define NVOCMP_ASSERT( cond, message )
+#define NVOCMP_ALERT( cond, message )
+#define NVOCMP_FLASHACCESS( err )
+
+extern void NV_LINUX_init( void );
+extern void NV_LINUX_save( void );
+extern void NV_LINUX_read( uint8_t pg, uint16_t off, uint8_t *pBuf, uint16_t len );
+extern int NV_LINUX_write( uint8_t pg, uint16_t off, uint8_t *pBuf, uint16_t len );
+extern int NV_LINUX_erase( uint8_t pg );
+
+#endif
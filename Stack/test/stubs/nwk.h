@@ -0,0 +1,39 @@
+/* Host stand-in for nwk.h: the NIB fields and constants the modules under test use. */
+#ifndef NWK_H
+#define NWK_H
+
+#include "zcomdef.h"
+#include "nwk_globals.h"
+
+#define MAX_LINK_COST         7
+#define ED_SCAN_MAXCHANNELS   27
+
+typedef enum
+{
+  NWK_INIT,
+  NWK_JOINING_ORPHAN,
+  NWK_DISC,
+  NWK_JOINING,
+  NWK_ENDDEVICE,
+  PAN_CHNL_SELECTION,
+  PAN_CHNL_VERIFY,
+  PAN_STARTING,
+  NWK_ROUTER,
+  NWK_REJOINING
+} nwk_states_t;
+
+typedef struct
+{
+  uint16_t nwkPanId;
+  uint16_t nwkCoordAddress;
+  nwk_states_t nwkState;
+  uint8_t  nwkLogicalChannel;
+  uint8_t  nwkUpdateId;
+  uint8_t  BroadcastDeliveryTime;
+  uint16_t nwkManagerAddr;
+  uint16_t nwkTotalTransmissions;
+} nwkIB_t;
+
+extern nwkIB_t _NIB;
+
+#endif
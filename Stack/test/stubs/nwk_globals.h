@@ -0,0 +1,28 @@
+/* Host stand-in for nwk_globals.h: table sizes of the modules under test. */
+#ifndef NWK_GLOBALS_H
+#define NWK_GLOBALS_H
+
+#include "zcomdef.h"
+
+#if !defined ( NWK_MAX_DEVICES )
+  #define NWK_MAX_DEVICES     21
+#endif
+#define NWK_MAX_ADDRESSES     32
+#define MAX_NEIGHBOR_ENTRIES  16
+#define MAX_RTG_ENTRIES       8
+#define MAX_RTG_SRC_ENTRIES   8
+#define MAX_SOURCE_ROUTE      12
+
+typedef uint8_t neighborTableIndex_t;
+typedef uint8_t rtgTableIndex_t;
+typedef uint8_t srcRtgTableIndex_t;
+
+extern neighborTableIndex_t gMAX_NEIGHBOR_ENTRIES;
+extern rtgTableIndex_t gMAX_RTG_ENTRIES;
+extern srcRtgTableIndex_t gMAX_RTG_SRC_ENTRIES;
+extern uint8_t gMAX_SOURCE_ROUTE;
+
+// End device timeouts, index 0 in seconds, the others in minutes
+extern const uint32_t timeoutValue[];
+
+#endif
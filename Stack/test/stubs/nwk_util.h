@@ -0,0 +1,36 @@
+/* Host stand-in for nwk_util.h: the neighbor table and the hooks into
+ * the NWK library. */
+#ifndef NWK_UTIL_H
+#define NWK_UTIL_H
+
+#include "zcomdef.h"
+#include "nwk.h"
+
+typedef struct
+{
+  uint8_t  txCounter;
+  uint8_t  txCost;
+  uint8_t  rxLqi;
+  uint8_t  inKeySeqNum;
+  uint32_t inFrmCntr;
+  uint16_t txFailure;
+} linkInfo_t;
+
+typedef struct
+{
+  uint16_t  neighborAddress;
+  uint8_t   neighborExtAddr[Z_EXTADDR_LEN];
+  uint16_t  panId;
+  uint8_t   age;
+  linkInfo_t linkInfo;
+} neighborEntry_t;
+
+extern neighborEntry_t neighborTable[];
+
+extern void nwkNeighborRemove( uint16_t NeighborAddress, uint16_t PanId );
+
+extern void (*pAssocChildAging)( void );
+extern uint8_t (*pAssocChildTableUpdateTimeout)( uint16_t nwkAddr );
+extern uint8_t (*pNwkNotMyChildListAdd)( uint16_t devAddr, uint32_t timeoutValue );
+
+#endif
@@ -0,0 +1,14 @@
+/* Host stand-in for osal_nv.h: the NV calls, implemented by the tests or
+ * by osal_nv.c over NVOCMP. */
+#ifndef OSAL_NV_H
+#define OSAL_NV_H
+
+#include "zcomdef.h"
+
+extern void osal_nv_init( void *p );
+extern uint8_t osal_nv_item_init_ex( uint16_t id, uint16_t subId, uint16_t len, void *buf );
+extern uint8_t osal_nv_write_ex( uint16_t id, uint16_t subId, uint16_t len, void *buf );
+extern uint8_t osal_nv_read_ex( uint16_t id, uint16_t subId, uint16_t offset, uint16_t len, void *buf );
+extern uint16_t osal_nv_item_len_ex( uint16_t id, uint16_t subId );
+
+#endif
@@ -0,0 +1,12 @@
+/* Host stand-in for osal_port_timers.h: the timer calls, implemented by
+ * the tests. */
+#ifndef OSAL_PORT_TIMERS_H
+#define OSAL_PORT_TIMERS_H
+
+#include <stdint.h>
+
+extern uint8_t OsalPortTimers_startTimer( uint8_t taskId, uint32_t eventId, uint32_t timeoutValue );
+extern uint8_t OsalPortTimers_stopTimer( uint8_t taskId, uint32_t eventId );
+extern uint32_t OsalPortTimers_getTimerTimeout( uint8_t taskId, uint32_t eventId );
+
+#endif
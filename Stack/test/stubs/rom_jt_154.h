@@ -0,0 +1,11 @@
+/* Host stand-in for rom_jt_154.h: the clock is driven by the tests. */
+#ifndef ROM_JT_154_H
+#define ROM_JT_154_H
+
+#include <stdint.h>
+
+extern uint32_t ztestClock;
+
+#define MAP_osal_GetSystemClock()   ztestClock
+
+#endif
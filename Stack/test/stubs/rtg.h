@@ -0,0 +1,40 @@
+/* Host stand-in for rtg.h: the routing tables and the source route
+ * table calls, implemented by the tests. */
+#ifndef RTG_H
+#define RTG_H
+
+#include "zcomdef.h"
+#include "nwk_globals.h"
+
+#define RT_ACTIVE     1
+
+typedef enum
+{
+  RTG_SUCCESS,
+  RTG_FAIL
+} RTG_Status_t;
+
+typedef struct
+{
+  uint16_t dstAddress;
+  uint16_t nextHopAddress;
+  uint8_t  expiryTime;
+  uint8_t  status;
+  uint8_t  options;
+} rtgEntry_t;
+
+typedef struct
+{
+  uint8_t   expiryTime;
+  uint8_t   relayCount;
+  uint16_t  dstAddress;
+  uint16_t *relayList;
+} rtgSrcEntry_t;
+
+extern rtgEntry_t rtgTable[];
+extern rtgSrcEntry_t rtgSrcTable[];
+
+extern RTG_Status_t RTG_GetRtgSrcEntry( uint16_t dstAddr, uint8_t* pRelayCnt, uint16_t** ppRelayList );
+extern RTG_Status_t RTG_AddSrcRtgEntry_Guaranteed( uint16_t srcAddr, uint8_t relayCnt, uint16_t* pRelayList );
+
+#endif
@@ -0,0 +1,46 @@
+/* Host stand-in for the TI driver porting layer clock: system ticks are
+ * driven by the tests, the clock function of ClockP_construct() is kept
+ * for them to call. */
+#ifndef ti_dpl_ClockP__include
+#define ti_dpl_ClockP__include
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef void (*ClockP_Fxn)( uintptr_t arg );
+
+typedef struct
+{
+  uint32_t timeout;
+} ClockP_Struct;
+
+typedef struct
+{
+  bool      startFlag;
+  uint32_t  period;
+  uintptr_t arg;
+} ClockP_Params;
+
+typedef void *ClockP_Handle;
+
+extern uint32_t ztestTicks;       // System ticks
+extern uint32_t ztestTickPeriod;  // Microseconds per tick
+extern ClockP_Fxn ztestClockFxn;  // Function of the last clock constructed
+
+#define ClockP_getSystemTicks()       ztestTicks
+#define ClockP_getSystemTickPeriod()  ztestTickPeriod
+
+#define ClockP_Params_init( p )       memset( (p), 0, sizeof( ClockP_Params ) )
+
+static inline ClockP_Handle ClockP_construct( ClockP_Struct *pClock, ClockP_Fxn fxn,
+                                              uint32_t timeout, ClockP_Params *pParams )
+{
+  (void)pParams;
+  pClock->timeout = timeout;
+  ztestClockFxn = fxn;
+  return ( (ClockP_Handle)pClock );
+}
+
+#endif
@@ -0,0 +1,11 @@
+/* Host stand-in for the TI driver porting layer interrupts: nothing
+ * interrupts the tests. */
+#ifndef ti_dpl_HwiP__include
+#define ti_dpl_HwiP__include
+
+#include <stdint.h>
+
+#define HwiP_disable()        ( (uintptr_t)0 )
+#define HwiP_restore( key )   ( (void)(key) )
+
+#endif
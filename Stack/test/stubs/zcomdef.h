@@ -0,0 +1,55 @@
+/* Host stand-in for zcomdef.h: the types and status codes the modules
+ * under test use. */
+#ifndef ZCOMDEF_H
+#define ZCOMDEF_H
+
+#include "comdef.h"
+
+typedef uint8_t ZStatus_t;
+
+#define ZSuccess            0x00
+#define ZFailure            0x01
+#define ZInvalidParameter   0x02
+#define ZMemError           0x10
+#define ZApsNoAck           0xB7
+#define ZNwkTableFull       0xC7
+
+#define ZCD_NV_EX_LEGACY        0x0000
+#define ZCD_NV_EX_EVENT_LOG     0x0009
+#define ZCD_NV_EX_QUIRK_TABLE   0x000A
+
+enum
+{
+  AddrNotPresent = 0,
+  AddrGroup = 1,
+  Addr16Bit = 2,
+  Addr64Bit = 3,
+  AddrBroadcast = 15
+};
+
+#define Z_EXTADDR_LEN       8
+#define INVALID_NODE_ADDR   0xFFFE
+
+typedef byte ZLongAddr_t[Z_EXTADDR_LEN];
+
+typedef struct
+{
+  union
+  {
+    uint16_t    shortAddr;
+    ZLongAddr_t extAddr;
+  } addr;
+  byte addrMode;
+} zAddrType_t;
+
+#define osal_cpyExtAddr( a, b )     memcpy( (a), (b), Z_EXTADDR_LEN )
+#define osal_ExtAddrEqual( a, b )   ( memcmp( (a), (b), Z_EXTADDR_LEN ) == 0 )
+
+// OSAL message header
+typedef struct
+{
+  uint8_t event;
+  uint8_t status;
+} OsalPort_EventHdr;
+
+#endif
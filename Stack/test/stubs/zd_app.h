@@ -0,0 +1,11 @@
+/* Host stand-in for zd_app.h: the ZDO task ID and events. */
+#ifndef ZDAPP_H
+#define ZDAPP_H
+
+#include "zcomdef.h"
+
+#define ZDO_EVENT_LOG_FLUSH_EVT   0x2000
+
+extern uint8_t ZDAppTaskID;
+
+#endif
@@ -0,0 +1,14 @@
+/* Host stand-in for zstackconfig.h: the NV function pointers osal_nv.c
+ * calls through. */
+#ifndef ZSTACKCONFIG_H
+#define ZSTACKCONFIG_H
+
+#include <stdint.h>
+#include "nvintf.h"
+
+typedef struct
+{
+  NVINTF_nvFuncts_t nvFps;
+} zstack_Config_t;
+
+#endif
@@ -0,0 +1,183 @@
+/**************************************************************************************************
+  Filename:       test_af.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the endpoint map AF delivers a groupcast
+                  through: building it from the group table in one pass
+                  and walking the endpoint list against it.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "aps_groups.h"
+#include "af.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+apsGroupItem_t *apsGroupTable = NULL;
+
+#include "test_af_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define GROUPS_MAX  16
+#define EPS_MAX     8
+
+static apsGroupItem_t groupItems[GROUPS_MAX];
+static uint8_t groupCnt;
+
+static endPointDesc_t epDescs[EPS_MAX];
+static epList_t epItems[EPS_MAX];
+static epList_t *epList;
+static uint8_t epCnt;
+
+static void reset( void )
+{
+  apsGroupTable = NULL;
+  groupCnt = 0;
+  epList = NULL;
+  epCnt = 0;
+}
+
+// Add to the end of the group table, as aps_AddGroup() does
+static void groupAdd( uint16_t groupID, uint8_t endpoint )
+{
+  apsGroupItem_t *pItem = &groupItems[groupCnt++];
+  apsGroupItem_t **ppNext = &apsGroupTable;
+
+  memset( pItem, 0, sizeof( apsGroupItem_t ) );
+  pItem->endpoint = endpoint;
+  pItem->group.ID = groupID;
+
+  while ( *ppNext != NULL )
+  {
+    ppNext = &(*ppNext)->next;
+  }
+  *ppNext = pItem;
+}
+
+static void epAdd( uint8_t endPoint )
+{
+  epList_t *pItem = &epItems[epCnt];
+  epList_t **ppNext = &epList;
+
+  memset( pItem, 0, sizeof( epList_t ) );
+  epDescs[epCnt].endPoint = endPoint;
+  pItem->epDesc = &epDescs[epCnt++];
+
+  while ( *ppNext != NULL )
+  {
+    ppNext = &(*ppNext)->nextDesc;
+  }
+  *ppNext = pItem;
+}
+
+static uint8_t inMap( uint8_t *epMap, uint8_t endPoint )
+{
+  return ( (epMap[endPoint / 8] & BV( endPoint % 8 )) != 0 );
+}
+
+static uint16_t mapBits( uint8_t *epMap )
+{
+  uint16_t bits = 0;
+  uint16_t ep;
+
+  for ( ep = 0; ep < (AF_EP_MAP_LEN * 8); ep++ )
+  {
+    bits += inMap( epMap, (uint8_t)ep );
+  }
+
+  return ( bits );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testEmpty( void )
+{
+  uint8_t epMap[AF_EP_MAP_LEN];
+
+  reset();
+
+  memset( epMap, 0xA5, sizeof( epMap ) );
+  ZTEST_CHECK( afGroupEpMap( 0x0001, epMap ) == 0 );
+  ZTEST_CHECK( mapBits( epMap ) == 0 );
+
+  groupAdd( 0x0002, 10 );
+  ZTEST_CHECK( afGroupEpMap( 0x0001, epMap ) == 0 );
+  ZTEST_CHECK( mapBits( epMap ) == 0 );
+}
+
+static void testMap( void )
+{
+  uint8_t epMap[AF_EP_MAP_LEN];
+
+  reset();
+
+  groupAdd( 0x0001, 1 );
+  groupAdd( 0x0002, 8 );
+  groupAdd( 0x0001, 7 );
+  groupAdd( 0x0001, 8 );
+  groupAdd( 0x0003, 1 );
+  groupAdd( 0x0001, 240 );
+  groupAdd( 0xFFF0, 242 );
+
+  ZTEST_CHECK( afGroupEpMap( 0x0001, epMap ) == 4 );
+  ZTEST_CHECK( mapBits( epMap ) == 4 );
+  ZTEST_CHECK( inMap( epMap, 1 ) && inMap( epMap, 7 ) && inMap( epMap, 8 ) && inMap( epMap, 240 ) );
+
+  ZTEST_CHECK( afGroupEpMap( 0x0002, epMap ) == 1 );
+  ZTEST_CHECK( (mapBits( epMap ) == 1) && inMap( epMap, 8 ) );
+
+  ZTEST_CHECK( afGroupEpMap( 0xFFF0, epMap ) == 1 );
+  ZTEST_CHECK( (mapBits( epMap ) == 1) && inMap( epMap, 242 ) );
+}
+
+static void testNext( void )
+{
+  uint8_t epMap[AF_EP_MAP_LEN];
+  epList_t *pList;
+
+  reset();
+
+  epAdd( 10 );
+  epAdd( 1 );
+  epAdd( 20 );
+  epAdd( 8 );
+  epAdd( 240 );
+
+  groupAdd( 0x0001, 240 );
+  groupAdd( 0x0001, 1 );
+  groupAdd( 0x0001, 8 );
+  groupAdd( 0x0001, 30 );   // Not registered
+
+  ZTEST_CHECK( afGroupEpMap( 0x0001, epMap ) == 4 );
+
+  // In the order of the endpoint list
+  pList = afEpMapNext( epList, epMap );
+  ZTEST_CHECK( (pList != NULL) && (pList->epDesc->endPoint == 1) );
+  pList = afEpMapNext( pList->nextDesc, epMap );
+  ZTEST_CHECK( (pList != NULL) && (pList->epDesc->endPoint == 8) );
+  pList = afEpMapNext( pList->nextDesc, epMap );
+  ZTEST_CHECK( (pList != NULL) && (pList->epDesc->endPoint == 240) );
+  pList = afEpMapNext( pList->nextDesc, epMap );
+  ZTEST_CHECK( pList == NULL );
+
+  ZTEST_CHECK( afEpMapNext( NULL, epMap ) == NULL );
+
+  // No member registered
+  ZTEST_CHECK( afGroupEpMap( 0x0002, epMap ) == 0 );
+  ZTEST_CHECK( afEpMapNext( epList, epMap ) == NULL );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testEmpty );
+  ZTEST_RUN( testMap );
+  ZTEST_RUN( testNext );
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,943 @@
+/**************************************************************************************************
+  Filename:       test_af_incoming.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the delivery of incoming AF frames to the
+                  host endpoints: the frames matching several of them
+                  taken once through the incoming multi callback, the per
+                  endpoint fallback and the order kept behind queued
+                  indications.  The synchronous sink declines while the
+                  NPI task's TX and OSAL queues are full, and a serial
+                  link simulation checks the order and latency of sink
+                  and MT task delivery.  A replay of mixed traffic counts
+                  the MT indications and serial bytes of both delivery
+                  modes.
+**************************************************************************************************/
+
+#include <stdlib.h>
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "aps_groups.h"
+#include "af.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define ZDO_EP                      0
+#define AF_BROADCAST_ENDPOINT       0xFF
+#define AF_INCOMING_MSG_CMD         0x1A
+#define AF_UNKNOWN_GROUP_DROP       0
+#define AF_PROFILE_RULE_NO_EP       0xFE
+#define AF_PROFILE_RULE_ANY_EP      0xFF
+#define ZQUIRK_ANY_PROFILE          0x01
+
+#define APS_DELIVERYMODE_MASK       0x0C
+#define APS_FC_DM_UNICAST           0x00
+#define APS_FC_DM_GROUP             0x0C
+
+#define MT_RPC_CMD_AREQ             0x40
+#define MT_RPC_SYS_AF               4
+#define MT_RPC_DATA_MAX             250
+#define MT_AF_INCOMING_MSG          0x81
+#define MT_AF_INCOMING_MSG_EXT      0x82
+#define MT_AF_INCOMING_MSG_MULTI    0x84
+#define MT_AF_EXEC_EVT              0x0001
+
+// SOF, length, two command bytes and FCS around each MT frame
+#define MT_FRAME_OVHD               5
+
+#define MT_AF_DELIVERY_PER_ENDPOINT 0x00
+#define MT_AF_DELIVERY_COALESCED    0x01
+
+typedef struct
+{
+  uint8_t FrmCtrl;
+  uint8_t XtndFrmCtrl;
+  uint8_t DstEndPoint;
+  uint8_t SrcEndPoint;
+  uint16_t GroupID;
+  uint16_t ClusterID;
+  uint16_t ProfileID;
+  uint16_t macDestAddr;
+  uint8_t wasBroadcast;
+  uint8_t apsHdrLen;
+  uint8_t *asdu;
+  uint8_t asduLength;
+  uint8_t ApsCounter;
+  uint8_t transID;
+  uint8_t BlkCount;
+  uint8_t AckBits;
+  uint16_t macSrcAddr;
+} aps_FrameFormat_t;
+
+typedef struct
+{
+  uint8_t LinkQuality;
+  uint8_t correlation;
+  int8_t  rssi;
+} NLDE_Signal_t;
+
+uint8_t MT_TaskID = 3;
+static uint8_t appTaskID = 5;
+
+apsGroupItem_t *apsGroupTable = NULL;
+static uint8_t afUnknownGroupEp = AF_UNKNOWN_GROUP_DROP;
+static epList_t *epList = NULL;
+
+// NPI task: depth of its TX queue, its OSAL queue is in msgQueue
+static uint16_t npiTxDepth;
+
+uint16_t NPITask_getTxQueueDepth( void )
+{
+  return ( npiTxDepth );
+}
+
+static uint8_t afProfileAcceptEp( uint16_t profileID )
+{
+  (void)profileID;
+  return ( AF_PROFILE_RULE_NO_EP );
+}
+
+uint8_t ZQuirkLookupExt( uint8_t *extAddr )
+{
+  (void)extAddr;
+  return ( 0 );
+}
+
+uint8_t ZQuirkLookupNwk( uint16_t nwkAddr )
+{
+  (void)nwkAddr;
+  return ( 0 );
+}
+
+endPointDesc_t *afFindEndPointDesc( uint8_t endPoint )
+{
+  epList_t *pList;
+
+  for ( pList = epList; pList != NULL; pList = pList->nextDesc )
+  {
+    if ( pList->epDesc->endPoint == endPoint )
+    {
+      return ( pList->epDesc );
+    }
+  }
+
+  return ( NULL );
+}
+
+static epList_t *afFindEndPointDescList( uint8_t endPoint )
+{
+  epList_t *pList;
+
+  for ( pList = epList; pList != NULL; pList = pList->nextDesc )
+  {
+    if ( pList->epDesc->endPoint == endPoint )
+    {
+      return ( pList );
+    }
+  }
+
+  return ( NULL );
+}
+
+static void afCopyAddress( afAddrType_t *afAddr, zAddrType_t *zAddr )
+{
+  afAddr->addrMode = (afAddrMode_t)zAddr->addrMode;
+  memcpy( &afAddr->addr, &zAddr->addr, sizeof( afAddr->addr ) );
+}
+
+// OSAL messages with a reference count, and the queues of two tasks
+typedef struct
+{
+  uint8_t refCnt;
+  uint8_t *pShared;
+  uint8_t *pNext;
+  uint8_t task;
+} msgHdr_t;
+
+#define MSG_HDR( p )  ( (msgHdr_t *)(p) - 1 )
+
+static uint8_t *msgQueue;
+static uint16_t msgLive;
+static uint32_t msgAllocs;
+
+uint8_t *OsalPort_msgAllocate( uint16_t len )
+{
+  msgHdr_t *pHdr = malloc( sizeof( msgHdr_t ) + len );
+
+  memset( pHdr, 0, sizeof( msgHdr_t ) );
+  pHdr->refCnt = 1;
+  msgLive++;
+  msgAllocs++;
+
+  return ( (uint8_t *)(pHdr + 1) );
+}
+
+uint8_t *OsalPort_msgAllocateRef( uint16_t len, uint8_t *pShared )
+{
+  uint8_t *pMsg = OsalPort_msgAllocate( len );
+
+  MSG_HDR( pShared )->refCnt++;
+  MSG_HDR( pMsg )->pShared = pShared;
+
+  return ( pMsg );
+}
+
+uint8_t OsalPort_msgDeallocate( uint8_t *pMsg )
+{
+  uint8_t *pShared = MSG_HDR( pMsg )->pShared;
+
+  if ( --MSG_HDR( pMsg )->refCnt == 0 )
+  {
+    free( MSG_HDR( pMsg ) );
+    msgLive--;
+    if ( pShared != NULL )
+    {
+      OsalPort_msgDeallocate( pShared );
+    }
+  }
+
+  return ( 0 );
+}
+
+uint8_t OsalPort_msgSend( uint8_t destinationTask, uint8_t *pMsg )
+{
+  uint8_t **ppNext = &msgQueue;
+
+  while ( *ppNext != NULL )
+  {
+    ppNext = &MSG_HDR( *ppNext )->pNext;
+  }
+  *ppNext = pMsg;
+  MSG_HDR( pMsg )->pNext = NULL;
+  MSG_HDR( pMsg )->task = destinationTask;
+
+  return ( 0 );
+}
+
+uint16_t OsalPort_msgCount( uint8_t taskId, uint16_t max )
+{
+  uint8_t *pMsg;
+  uint16_t cnt = 0;
+
+  for ( pMsg = msgQueue; (pMsg != NULL) && (cnt < max); pMsg = MSG_HDR( pMsg )->pNext )
+  {
+    cnt += ( MSG_HDR( pMsg )->task == taskId );
+  }
+
+  return ( cnt );
+}
+
+OsalPort_EventHdr *OsalPort_msgFind( uint8_t taskId, uint8_t event )
+{
+  uint8_t *pMsg;
+
+  for ( pMsg = msgQueue; pMsg != NULL; pMsg = MSG_HDR( pMsg )->pNext )
+  {
+    if ( (MSG_HDR( pMsg )->task == taskId) && (((OsalPort_EventHdr *)pMsg)->event == event) )
+    {
+      return ( (OsalPort_EventHdr *)pMsg );
+    }
+  }
+
+  return ( NULL );
+}
+
+void *OsalPort_malloc( uint32_t size )
+{
+  return ( malloc( size ) );
+}
+
+void OsalPort_free( void *buf )
+{
+  free( buf );
+}
+
+void *OsalPort_memcpy( void *dst, const void *src, unsigned int len )
+{
+  return ( memcpy( dst, src, len ) );
+}
+
+uint8_t *OsalPort_bufferUint32( uint8_t *buf, uint32_t val )
+{
+  *buf++ = BREAK_UINT32( val, 0 );
+  *buf++ = BREAK_UINT32( val, 1 );
+  *buf++ = BREAK_UINT32( val, 2 );
+  *buf++ = BREAK_UINT32( val, 3 );
+
+  return ( buf );
+}
+
+uint8_t OsalPort_setEvent( uint8_t task, uint32_t event )
+{
+  (void)task;
+  (void)event;
+  return ( 0 );
+}
+
+uint8_t OsalPortTimers_startTimer( uint8_t task, uint32_t event, uint32_t timeout )
+{
+  (void)task;
+  (void)event;
+  (void)timeout;
+  return ( 0 );
+}
+
+// MT transport: counts the indications and their bytes on the wire
+static uint16_t mtRspLen;
+static uint8_t mtRspCmd;
+static uint32_t mtInds;
+static uint32_t mtBytes;
+static uint8_t mtLast[MT_RPC_DATA_MAX];
+static uint8_t mtLastCmd;
+static uint8_t mtLastLen;
+static uint8_t mtLastEps[256];      // Endpoints the indications were for
+static uint8_t mtToNpi = FALSE;     // Post the indications to the NPI task
+
+// Indication posted to the NPI task: the sequence number in its first
+// two data bytes and its size on the wire
+typedef struct
+{
+  uint16_t seq;
+  uint16_t bytes;
+} npiRsp_t;
+
+static uint8_t npiTaskNum = 9;
+
+uint8_t *MT_AllocZToolResponse( uint8_t cmdType, uint8_t cmdId, uint8_t datalen )
+{
+  (void)cmdType;
+  mtRspCmd = cmdId;
+  mtRspLen = datalen;
+
+  return ( malloc( datalen ) );
+}
+
+void MT_SendZToolResponse( uint8_t *pRsp )
+{
+  uint16_t ep;
+
+  mtInds++;
+  mtBytes += mtRspLen + MT_FRAME_OVHD;
+  memcpy( mtLast, pRsp, mtRspLen );
+  mtLastCmd = mtRspCmd;
+  mtLastLen = (uint8_t)mtRspLen;
+
+  // Destination endpoint, or the map of them
+  if ( mtRspCmd == MT_AF_INCOMING_MSG )
+  {
+    mtLastEps[pRsp[7]]++;
+
+    if ( mtToNpi )
+    {
+      npiRsp_t *pNpi = (npiRsp_t *)OsalPort_msgAllocate( sizeof( npiRsp_t ) );
+
+      pNpi->seq = BUILD_UINT16( pRsp[17], pRsp[18] );
+      pNpi->bytes = mtRspLen + MT_FRAME_OVHD;
+      OsalPort_msgSend( npiTaskNum, (uint8_t *)pNpi );
+    }
+  }
+  else if ( mtRspCmd == MT_AF_INCOMING_MSG_MULTI )
+  {
+    for ( ep = 0; ep < (uint16_t)(pRsp[16] * 8); ep++ )
+    {
+      if ( pRsp[17 + (ep / 8)] & BV( ep % 8 ) )
+      {
+        mtLastEps[ep]++;
+      }
+    }
+  }
+
+  free( pRsp );
+}
+
+uint8_t MT_TxQueueFull( void );
+void MT_AfIncomingMsg( afIncomingMSGPacket_t *pMsg );
+uint8_t MT_AfIncomingMsgMulti( afIncomingMSGPacket_t *pMsg, uint8_t *pEpMap, uint8_t epMapLen );
+
+#include "test_af_incoming_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define PROFILE_HA      0x0104
+#define GROUP_LIGHTS    0x0010
+#define EPS_MAX         8
+
+static SimpleDescriptionFormat_t simpleDescs[EPS_MAX];
+static endPointDesc_t epDescs[EPS_MAX];
+static epList_t epItems[EPS_MAX];
+static uint8_t epCnt;
+
+static apsGroupItem_t groupItems[EPS_MAX];
+static uint8_t groupCnt;
+
+static uint8_t asdu[255];
+static uint16_t frameSeq;
+
+static void reset( uint8_t mode )
+{
+  epList = NULL;
+  epCnt = 0;
+  apsGroupTable = NULL;
+  groupCnt = 0;
+  npiTxDepth = 0;
+  npiTaskID = npiTaskNum;
+  mtToNpi = FALSE;
+  frameSeq = 0;
+  MT_AfDeliveryMode = mode;
+  mtInds = 0;
+  mtBytes = 0;
+  memset( mtLastEps, 0, sizeof( mtLastEps ) );
+}
+
+// Endpoint of the host, registered through MT_AF_REGISTER, or of the firmware
+static void epAdd( uint8_t endPoint, uint8_t host )
+{
+  epList_t *pItem = &epItems[epCnt];
+  epList_t **ppNext = &epList;
+
+  memset( pItem, 0, sizeof( epList_t ) );
+  simpleDescs[epCnt].EndPoint = endPoint;
+  simpleDescs[epCnt].AppProfId = PROFILE_HA;
+  epDescs[epCnt].endPoint = endPoint;
+  epDescs[epCnt].task_id = host ? &MT_TaskID : &appTaskID;
+  epDescs[epCnt].simpleDesc = &simpleDescs[epCnt];
+  pItem->epDesc = &epDescs[epCnt++];
+
+  while ( *ppNext != NULL )
+  {
+    ppNext = &(*ppNext)->nextDesc;
+  }
+  *ppNext = pItem;
+
+  if ( host )
+  {
+    pItem->pfnIncomingCB = MT_AfIncomingSink;
+    pItem->pfnIncomingMultiCB = MT_AfIncomingSinkMulti;
+  }
+}
+
+static void groupAdd( uint16_t groupID, uint8_t endpoint )
+{
+  apsGroupItem_t *pItem = &groupItems[groupCnt++];
+  apsGroupItem_t **ppNext = &apsGroupTable;
+
+  memset( pItem, 0, sizeof( apsGroupItem_t ) );
+  pItem->endpoint = endpoint;
+  pItem->group.ID = groupID;
+
+  while ( *ppNext != NULL )
+  {
+    ppNext = &(*ppNext)->next;
+  }
+  *ppNext = pItem;
+}
+
+// A host with four endpoints, three of them in the lights group, and a
+// firmware endpoint in the group too
+static void hostSetup( uint8_t mode )
+{
+  reset( mode );
+
+  epAdd( 1, TRUE );
+  epAdd( 2, TRUE );
+  epAdd( 3, TRUE );
+  epAdd( 11, TRUE );
+  epAdd( 20, FALSE );
+
+  groupAdd( GROUP_LIGHTS, 1 );
+  groupAdd( GROUP_LIGHTS, 2 );
+  groupAdd( GROUP_LIGHTS, 11 );
+  groupAdd( GROUP_LIGHTS, 20 );
+}
+
+static void frameIn( uint8_t dm, uint8_t dstEP, uint16_t groupID, uint8_t len )
+{
+  aps_FrameFormat_t aff;
+  zAddrType_t srcAddr;
+  NLDE_Signal_t sig = { 200, 0, -40 };
+  uint8_t x;
+
+  memset( &aff, 0, sizeof( aff ) );
+  aff.FrmCtrl = dm;
+  aff.DstEndPoint = dstEP;
+  aff.SrcEndPoint = 1;
+  aff.GroupID = groupID;
+  aff.ClusterID = 0x0006;
+  aff.ProfileID = PROFILE_HA;
+  aff.asdu = asdu;
+  aff.asduLength = len;
+  aff.macSrcAddr = 0x4321;
+  for ( x = 0; x < len; x++ )
+  {
+    asdu[x] = (uint8_t)(x ^ len);
+  }
+
+  // Numbered in the first two bytes, in the order they came in
+  asdu[0] = LO_UINT16( frameSeq );
+  asdu[1] = HI_UINT16( frameSeq );
+  frameSeq++;
+
+  srcAddr.addrMode = Addr16Bit;
+  srcAddr.addr.shortAddr = 0x4321;
+
+  afIncomingData( &aff, &srcAddr, 0x1A62, &sig, 1, FALSE, 1000, 5 );
+}
+
+// The MT task serving its queue, the firmware task dropping its messages
+static uint16_t drain( void )
+{
+  uint8_t *pMsg;
+  uint16_t cnt = 0;
+
+  while ( (pMsg = msgQueue) != NULL )
+  {
+    msgQueue = MSG_HDR( pMsg )->pNext;
+    if ( MSG_HDR( pMsg )->task == MT_TaskID )
+    {
+      MT_AfIncomingMsg( (afIncomingMSGPacket_t *)pMsg );
+      cnt++;
+    }
+    OsalPort_msgDeallocate( pMsg );
+  }
+
+  return ( cnt );
+}
+
+// First message queued to a task, taken off the queue
+static uint8_t *msgTake( uint8_t task )
+{
+  uint8_t **ppMsg = &msgQueue;
+  uint8_t *pMsg;
+
+  while ( (pMsg = *ppMsg) != NULL )
+  {
+    if ( MSG_HDR( pMsg )->task == task )
+    {
+      *ppMsg = MSG_HDR( pMsg )->pNext;
+      return ( pMsg );
+    }
+    ppMsg = &MSG_HDR( pMsg )->pNext;
+  }
+
+  return ( NULL );
+}
+
+// The MT task serving its queue only
+static uint16_t mtTask( void )
+{
+  uint8_t *pMsg;
+  uint16_t cnt = 0;
+
+  while ( (pMsg = msgTake( MT_TaskID )) != NULL )
+  {
+    MT_AfIncomingMsg( (afIncomingMSGPacket_t *)pMsg );
+    OsalPort_msgDeallocate( pMsg );
+    cnt++;
+  }
+
+  return ( cnt );
+}
+
+static uint8_t firmwareQueued( void )
+{
+  uint8_t *pMsg;
+  uint8_t cnt = 0;
+
+  for ( pMsg = msgQueue; pMsg != NULL; pMsg = MSG_HDR( pMsg )->pNext )
+  {
+    cnt += ( MSG_HDR( pMsg )->task == appTaskID );
+  }
+
+  return ( cnt );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testPerEndpoint( void )
+{
+  hostSetup( MT_AF_DELIVERY_PER_ENDPOINT );
+
+  // Each host endpoint of the group gets its own indication
+  frameIn( APS_FC_DM_GROUP, 0, GROUP_LIGHTS, 10 );
+  ZTEST_CHECK( mtInds == 3 );
+  ZTEST_CHECK( mtLastEps[1] && mtLastEps[2] && mtLastEps[11] && !mtLastEps[3] );
+  ZTEST_CHECK( mtBytes == 3 * (20 + 10 + MT_FRAME_OVHD) );
+  ZTEST_CHECK( firmwareQueued() == 1 );
+  drain();
+  ZTEST_CHECK( msgLive == 0 );
+}
+
+static void testCoalesced( void )
+{
+  hostSetup( MT_AF_DELIVERY_COALESCED );
+
+  // One indication for the three host endpoints of the group
+  frameIn( APS_FC_DM_GROUP, 0, GROUP_LIGHTS, 10 );
+  ZTEST_CHECK( mtInds == 1 );
+  ZTEST_CHECK( mtLastCmd == MT_AF_INCOMING_MSG_MULTI );
+  ZTEST_CHECK( mtLastLen == 29 + 2 + 10 );
+  ZTEST_CHECK( (mtLast[16] == 2) && (mtLast[17] == (BV( 1 ) | BV( 2 ))) && (mtLast[18] == BV( 3 )) );
+  ZTEST_CHECK( mtBytes == 29 + 2 + 10 + MT_FRAME_OVHD );
+
+  // The firmware endpoint still gets its message
+  ZTEST_CHECK( firmwareQueued() == 1 );
+  drain();
+
+  // Broadcast endpoint: the four host endpoints at once
+  mtInds = 0;
+  memset( mtLastEps, 0, sizeof( mtLastEps ) );
+  frameIn( APS_FC_DM_UNICAST, AF_BROADCAST_ENDPOINT, 0, 4 );
+  ZTEST_CHECK( (mtInds == 1) && (mtLastCmd == MT_AF_INCOMING_MSG_MULTI) );
+  ZTEST_CHECK( mtLastEps[1] && mtLastEps[2] && mtLastEps[3] && mtLastEps[11] );
+  ZTEST_CHECK( firmwareQueued() == 1 );
+  drain();
+
+  // Unicast is unchanged
+  mtInds = 0;
+  frameIn( APS_FC_DM_UNICAST, 2, 0, 4 );
+  ZTEST_CHECK( (mtInds == 1) && (mtLastCmd == MT_AF_INCOMING_MSG) && (mtLast[7] == 2) );
+  ZTEST_CHECK( msgLive == 0 );
+}
+
+static void testSingleMember( void )
+{
+  hostSetup( MT_AF_DELIVERY_COALESCED );
+  groupAdd( 0x0020, 3 );
+
+  frameIn( APS_FC_DM_GROUP, 0, 0x0020, 10 );
+  ZTEST_CHECK( (mtInds == 1) && (mtLastCmd == MT_AF_INCOMING_MSG) && (mtLast[7] == 3) );
+  ZTEST_CHECK( msgLive == 0 );
+}
+
+static void testTooLarge( void )
+{
+  hostSetup( MT_AF_DELIVERY_COALESCED );
+
+  // Too large for one MT frame with the map, per endpoint instead
+  frameIn( APS_FC_DM_GROUP, 0, GROUP_LIGHTS, MT_RPC_DATA_MAX - 29 - 2 + 1 );
+  ZTEST_CHECK( mtInds == 3 );
+  ZTEST_CHECK( mtLastEps[1] && mtLastEps[2] && mtLastEps[11] );
+  drain();
+  ZTEST_CHECK( msgLive == 0 );
+}
+
+static void testBacklog( void )
+{
+  hostSetup( MT_AF_DELIVERY_COALESCED );
+
+  // The transport is full, the frame is queued per endpoint to MT
+  npiTxDepth = NPI_TX_QUEUE_MAX;
+  frameIn( APS_FC_DM_GROUP, 0, GROUP_LIGHTS, 10 );
+  ZTEST_CHECK( mtInds == 0 );
+
+  // Not overtaking the queued ones once there is room again
+  npiTxDepth = 0;
+  frameIn( APS_FC_DM_UNICAST, AF_BROADCAST_ENDPOINT, 0, 4 );
+  frameIn( APS_FC_DM_UNICAST, 1, 0, 4 );
+  ZTEST_CHECK( mtInds == 0 );
+
+  ZTEST_CHECK( drain() == 3 + 4 + 1 );
+  ZTEST_CHECK( mtInds == 3 + 4 + 1 );
+  ZTEST_CHECK( (mtLastCmd == MT_AF_INCOMING_MSG) && (mtLast[7] == 1) );
+  ZTEST_CHECK( msgLive == 0 );
+
+  // Queue drained, coalesced again
+  frameIn( APS_FC_DM_GROUP, 0, GROUP_LIGHTS, 10 );
+  ZTEST_CHECK( (mtInds == 3 + 4 + 1 + 1) && (mtLastCmd == MT_AF_INCOMING_MSG_MULTI) );
+  drain();
+}
+
+static void testNpiBacklog( void )
+{
+  uint8_t *pMsg;
+  uint16_t seq;
+
+  hostSetup( MT_AF_DELIVERY_PER_ENDPOINT );
+  mtToNpi = TRUE;
+
+  // Room for two more between the TX queue and the NPI task's queue
+  npiTxDepth = NPI_TX_QUEUE_MAX - 2;
+  frameIn( APS_FC_DM_UNICAST, 1, 0, 4 );
+  frameIn( APS_FC_DM_UNICAST, 1, 0, 4 );
+  ZTEST_CHECK( mtInds == 2 );
+  ZTEST_CHECK( OsalPort_msgCount( npiTaskNum, 0xFFFF ) == 2 );
+
+  // The TX queue alone has room, the responses posted to NPI fill it
+  frameIn( APS_FC_DM_UNICAST, 1, 0, 4 );
+  ZTEST_CHECK( mtInds == 2 );
+  ZTEST_CHECK( OsalPort_msgFind( MT_TaskID, AF_INCOMING_MSG_CMD ) != NULL );
+
+  // NPI takes its messages into the TX queue, still full
+  while ( (pMsg = msgTake( npiTaskNum )) != NULL )
+  {
+    OsalPort_msgDeallocate( pMsg );
+    npiTxDepth++;
+  }
+  frameIn( APS_FC_DM_UNICAST, 1, 0, 4 );
+  ZTEST_CHECK( mtInds == 2 );
+
+  // Sent out, but behind the ones queued to MT
+  npiTxDepth = 0;
+  frameIn( APS_FC_DM_UNICAST, 1, 0, 4 );
+  ZTEST_CHECK( mtInds == 2 );
+
+  ZTEST_CHECK( mtTask() == 3 );
+  frameIn( APS_FC_DM_UNICAST, 1, 0, 4 );
+  ZTEST_CHECK( mtInds == 6 );
+
+  // All six in order at the NPI task
+  for ( seq = 2; seq < 6; seq++ )
+  {
+    pMsg = msgTake( npiTaskNum );
+    ZTEST_CHECK( (pMsg != NULL) && (((npiRsp_t *)pMsg)->seq == seq) );
+    OsalPort_msgDeallocate( pMsg );
+  }
+  ZTEST_CHECK( msgQueue == NULL );
+  ZTEST_CHECK( msgLive == 0 );
+}
+
+/*********************************************************************
+ * SIMULATION
+ */
+// A host endpoint taking bursts of unicasts over a 115200 baud serial
+// link.  Each millisecond tick the CPU runs the stack task, then the NPI
+// task, then the MT task, in microseconds of work each.
+#define SIM_TICKS         60000
+#define SIM_UART_BYTES    11      // Per tick at 115200 baud
+#define SIM_TICK_US       1000
+#define SIM_STACK_US      400     // AF incoming frame
+#define SIM_SINK_US       150     // Serialized by the sink in the stack task
+#define SIM_MT_US         350     // Serialized by the MT task, with its dispatch
+#define SIM_NPI_US        50      // Taken into the TX queue
+#define SIM_FIFO          1024
+#define SIM_FRAMES        16384
+
+typedef struct
+{
+  uint32_t frames;
+  uint32_t fellBack;      // Declined by the sink, queued to MT
+  uint32_t allocs;        // OSAL messages, the NPI task's included
+  uint32_t outOfOrder;
+  uint32_t latencySum;
+  uint32_t latencyMax;
+  uint16_t npiPeak;       // TX queue and NPI task's queue
+} simResult_t;
+
+static uint32_t simBorn[SIM_FRAMES];
+static npiRsp_t simFifo[SIM_FIFO];
+
+static void simRun( uint8_t sink, simResult_t *pResult )
+{
+  uint32_t seed = 0xB0B;
+  uint32_t tick;
+  uint16_t burst = 0;
+  uint16_t head = 0;
+  uint16_t expect = 0;
+  uint16_t rx = 0;           // Frames heard, not yet taken by the stack
+  uint16_t budget = 0;
+  uint16_t depth;
+  uint32_t inds;
+  int32_t cpu = 0;
+  uint8_t *pMsg;
+  uint8_t x;
+
+  hostSetup( MT_AF_DELIVERY_PER_ENDPOINT );
+  mtToNpi = TRUE;
+  msgAllocs = 0;
+  memset( pResult, 0, sizeof( simResult_t ) );
+  if ( !sink )
+  {
+    // Before the sink: every frame goes through the MT task
+    for ( x = 0; x < epCnt; x++ )
+    {
+      epItems[x].pfnIncomingCB = NULL;
+      epItems[x].pfnIncomingMultiCB = NULL;
+    }
+  }
+
+  for ( tick = 0; tick < SIM_TICKS; tick++ )
+  {
+    // Bursts of 5 to 24 frames a tick apart, a frame every 25 ticks between
+    seed = (seed * 1103515245UL) + 12345UL;
+    if ( (burst == 0) && (((seed >> 8) % 300) == 0) )
+    {
+      burst = 5 + ((seed >> 16) % 20);
+    }
+    if ( (burst > 0) || (((seed >> 20) % 25) == 0) )
+    {
+      simBorn[(frameSeq + rx) % SIM_FRAMES] = tick;
+      rx++;
+      burst -= ( burst > 0 );
+    }
+
+    cpu += SIM_TICK_US;
+
+    // Stack task
+    while ( (rx > 0) && (cpu > 0) )
+    {
+      inds = mtInds;
+      frameIn( APS_FC_DM_UNICAST, 1, 0, (uint8_t)(10 + ((seed >> 4) % 31)) );
+      rx--;
+      pResult->frames++;
+      cpu -= SIM_STACK_US;
+      if ( mtInds != inds )
+      {
+        cpu -= SIM_SINK_US;
+      }
+      else if ( sink )
+      {
+        pResult->fellBack++;
+      }
+    }
+
+    // NPI task, then the MT task
+    while ( (cpu > 0) && ((pMsg = msgTake( npiTaskNum )) != NULL) )
+    {
+      simFifo[(head + npiTxDepth) % SIM_FIFO] = *(npiRsp_t *)pMsg;
+      npiTxDepth++;
+      OsalPort_msgDeallocate( pMsg );
+      cpu -= SIM_NPI_US;
+    }
+    while ( (cpu > 0) && ((pMsg = msgTake( MT_TaskID )) != NULL) )
+    {
+      MT_AfIncomingMsg( (afIncomingMSGPacket_t *)pMsg );
+      OsalPort_msgDeallocate( pMsg );
+      cpu -= SIM_MT_US;
+    }
+    if ( cpu > 0 )
+    {
+      cpu = 0;    // Idle time is not saved up
+    }
+
+    depth = npiTxDepth + OsalPort_msgCount( npiTaskNum, 0xFFFF );
+    if ( depth > pResult->npiPeak )
+    {
+      pResult->npiPeak = depth;
+    }
+
+    // Serial link
+    budget = ( npiTxDepth > 0 ) ? (budget + SIM_UART_BYTES) : 0;
+    while ( (npiTxDepth > 0) && (simFifo[head].bytes <= budget) )
+    {
+      uint32_t latency = tick - simBorn[simFifo[head].seq % SIM_FRAMES];
+
+      pResult->outOfOrder += ( simFifo[head].seq != expect );
+      expect = simFifo[head].seq + 1;
+      pResult->latencySum += latency;
+      if ( latency > pResult->latencyMax )
+      {
+        pResult->latencyMax = latency;
+      }
+      budget -= simFifo[head].bytes;
+      head = (head + 1) % SIM_FIFO;
+      npiTxDepth--;
+    }
+  }
+
+  while ( (pMsg = msgQueue) != NULL )
+  {
+    msgQueue = MSG_HDR( pMsg )->pNext;
+    OsalPort_msgDeallocate( pMsg );
+  }
+  pResult->allocs = msgAllocs;
+}
+
+static void testSerialLink( void )
+{
+  simResult_t queued;
+  simResult_t sink;
+
+  simRun( FALSE, &queued );
+  simRun( TRUE, &sink );
+
+  printf( "MT task: %lu frames, latency mean %lu max %lu ms, NPI backlog %u, %lu messages\n",
+          (unsigned long)queued.frames, (unsigned long)(queued.latencySum / queued.frames),
+          (unsigned long)queued.latencyMax, queued.npiPeak, (unsigned long)queued.allocs );
+  printf( "sink:    %lu frames, latency mean %lu max %lu ms, NPI backlog %u, %lu messages, %lu fell back\n",
+          (unsigned long)sink.frames, (unsigned long)(sink.latencySum / sink.frames),
+          (unsigned long)sink.latencyMax, sink.npiPeak, (unsigned long)sink.allocs,
+          (unsigned long)sink.fellBack );
+
+  ZTEST_CHECK( (queued.outOfOrder == 0) && (sink.outOfOrder == 0) );
+  ZTEST_CHECK( sink.fellBack > 0 );
+  ZTEST_CHECK( sink.latencySum < queued.latencySum );
+  ZTEST_CHECK( sink.allocs < queued.allocs );
+  ZTEST_CHECK( msgLive == 0 );
+}
+
+// Mixed traffic: unicasts, light group commands and broadcast endpoint
+// frames, some too large to coalesce
+static void replay( uint8_t mode, uint32_t *pInds, uint32_t *pBytes )
+{
+  uint32_t seed = 0xA11CE;
+  uint16_t x;
+  uint8_t len;
+  uint8_t pick;
+
+  hostSetup( mode );
+
+  for ( x = 0; x < 5000; x++ )
+  {
+    seed = (seed * 1103515245UL) + 12345UL;
+    pick = (uint8_t)((seed >> 8) % 20);
+    len = (uint8_t)(3 + ((seed >> 16) % 60));
+    if ( ((seed >> 24) % 50) == 0 )
+    {
+      len = 230;
+    }
+
+    if ( pick < 12 )
+    {
+      frameIn( APS_FC_DM_UNICAST, (pick < 6) ? 1 : 11, 0, len );
+    }
+    else if ( pick < 17 )
+    {
+      frameIn( APS_FC_DM_GROUP, 0, GROUP_LIGHTS, len );
+    }
+    else
+    {
+      frameIn( APS_FC_DM_UNICAST, AF_BROADCAST_ENDPOINT, 0, len );
+    }
+    drain();
+  }
+
+  *pInds = mtInds;
+  *pBytes = mtBytes;
+}
+
+static void testReplay( void )
+{
+  uint32_t inds[2];
+  uint32_t bytes[2];
+
+  replay( MT_AF_DELIVERY_PER_ENDPOINT, &inds[0], &bytes[0] );
+  replay( MT_AF_DELIVERY_COALESCED, &inds[1], &bytes[1] );
+
+  printf( "per endpoint: %lu indications, %lu bytes\n",
+          (unsigned long)inds[0], (unsigned long)bytes[0] );
+  printf( "coalesced:    %lu indications, %lu bytes\n",
+          (unsigned long)inds[1], (unsigned long)bytes[1] );
+
+  ZTEST_CHECK( inds[1] < inds[0] );
+  ZTEST_CHECK( bytes[1] < bytes[0] );
+  ZTEST_CHECK( msgLive == 0 );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testPerEndpoint );
+  ZTEST_RUN( testCoalesced );
+  ZTEST_RUN( testSingleMember );
+  ZTEST_RUN( testTooLarge );
+  ZTEST_RUN( testBacklog );
+  ZTEST_RUN( testNpiBacklog );
+  ZTEST_RUN( testSerialLink );
+  ZTEST_RUN( testReplay );
+
+  return ( ZTEST_RESULT );
+}
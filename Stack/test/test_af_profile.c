@@ -0,0 +1,317 @@
+/**************************************************************************************************
+  Filename:       test_af_profile.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the incoming profile acceptance rules: the
+                  built-in rules accept what the fixed chain of profile
+                  checks in afIncomingData() accepted, added quirks and
+                  the accept all policy, the parameter checks and the
+                  restore of the built-in rules.  A benchmark counts the
+                  profile comparisons per frame of the chain and of the
+                  rules as quirks are added.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "af.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define CONST                               const
+
+void *OsalPort_memcpy( void *dst, const void *src, unsigned int len )
+{
+  memcpy( dst, src, len );
+  return ( (uint8_t *)dst + len );
+}
+
+#include "test_af_profile_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define EP_CNT        6
+#define PROFILE_CNT   7
+
+// Endpoints and profiles the frames are checked against
+static const uint8_t eps[EP_CNT] = { ZDO_EP, 1, 2, 3, 8, 242 };
+static const uint16_t profiles[PROFILE_CNT] = { 0x0000, 0x0104, 0xC05E, 0xFC01, 0xFC02, 0x1234, 0xFFFF };
+
+// Profile comparisons of the last accepts() call
+static uint16_t cmpCnt;
+
+// Acceptance as afIncomingData() did it before the rules, with the quirks
+// added as further clauses of the chain
+static uint8_t legacyAccepts( uint8_t ep, uint16_t epProfileID, uint16_t profileID,
+                              const afProfileRule_t *pQuirks, uint8_t numQuirks )
+{
+  uint8_t x;
+
+  cmpCnt += 3;
+  if ( (profileID == epProfileID) ||
+       ((ep == ZDO_EP) && (profileID == ZDO_PROFILE_ID)) ||
+       ((ep != ZDO_EP) && (profileID == ZDO_WILDCARD_PROFILE_ID)) )
+  {
+    return ( TRUE );
+  }
+
+  for ( x = 0; x < numQuirks; x++ )
+  {
+    cmpCnt++;
+    if ( (profileID == pQuirks[x].profileID) &&
+         ((ep == pQuirks[x].endPoint) ||
+          ((pQuirks[x].endPoint == AF_PROFILE_RULE_ANY_EP) && (ep != ZDO_EP))) )
+    {
+      return ( TRUE );
+    }
+  }
+
+  return ( FALSE );
+}
+
+// Endpoint test of afIncomingData() against the looked up endpoint
+static uint8_t ruleAccepts( uint8_t acceptEp, uint8_t ep, uint16_t epProfileID, uint16_t profileID )
+{
+  cmpCnt++;
+  return ( (profileID == epProfileID) ||
+           (acceptEp == ep) ||
+           ((acceptEp == AF_PROFILE_RULE_ANY_EP) && (ep != ZDO_EP)) );
+}
+
+// Profile comparisons of the afProfileAcceptEp() lookup
+static uint16_t lookupCmps( uint16_t profileID )
+{
+  uint8_t x;
+
+  if ( (profileID == ZDO_PROFILE_ID) || (profileID == ZDO_WILDCARD_PROFILE_ID) )
+  {
+    return ( (profileID == ZDO_PROFILE_ID) ? 1 : 2 );
+  }
+
+  for ( x = 0; x < afProfileRulesCnt; x++ )
+  {
+    if ( afProfileRules[x].profileID == profileID )
+    {
+      break;
+    }
+  }
+
+  return ( 2 + ((x < afProfileRulesCnt) ? (x + 1) : x) );
+}
+
+// Every endpoint, endpoint profile and received profile accepted the same
+// by the chain with pQuirks and by the active rules
+static uint8_t sameAsLegacy( const afProfileRule_t *pQuirks, uint8_t numQuirks )
+{
+  uint8_t e, p, q;
+
+  for ( p = 0; p < PROFILE_CNT; p++ )
+  {
+    uint8_t acceptEp = afProfileAcceptEp( profiles[p] );
+
+    for ( e = 0; e < EP_CNT; e++ )
+    {
+      for ( q = 0; q < PROFILE_CNT; q++ )
+      {
+        if ( legacyAccepts( eps[e], profiles[q], profiles[p], pQuirks, numQuirks ) !=
+             ruleAccepts( acceptEp, eps[e], profiles[q], profiles[p] ) )
+        {
+          printf( "  ep %u profile 0x%04X received 0x%04X\n", eps[e], profiles[q], profiles[p] );
+          return ( FALSE );
+        }
+      }
+    }
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testDefaultRules( void )
+{
+  static const afProfileRule_t builtIn[] = { { 0xFC01, 2 } };
+
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_DEFAULT, 0, NULL ) == afStatus_SUCCESS );
+  ZTEST_CHECK( sameAsLegacy( builtIn, 1 ) );
+
+  ZTEST_CHECK( afProfileAcceptEp( ZDO_PROFILE_ID ) == ZDO_EP );
+  ZTEST_CHECK( afProfileAcceptEp( ZDO_WILDCARD_PROFILE_ID ) == AF_PROFILE_RULE_ANY_EP );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC01 ) == 2 );
+  ZTEST_CHECK( afProfileAcceptEp( 0x0104 ) == AF_PROFILE_RULE_NO_EP );
+}
+
+static void testQuirks( void )
+{
+  afProfileRule_t quirks[] =
+  {
+    { 0xFC01, 2 },
+    { 0xFC02, 8 },
+    { 0x1234, AF_PROFILE_RULE_ANY_EP },
+  };
+
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_MATCH, 3, quirks ) == afStatus_SUCCESS );
+  ZTEST_CHECK( sameAsLegacy( quirks, 3 ) );
+
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC02 ) == 8 );
+  ZTEST_CHECK( afProfileAcceptEp( 0x1234 ) == AF_PROFILE_RULE_ANY_EP );
+
+  // The rules are copied, changing the caller's table changes nothing
+  quirks[1].endPoint = 3;
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC02 ) == 8 );
+
+  // Dropping the built-in rule
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_MATCH, 0, NULL ) == afStatus_SUCCESS );
+  ZTEST_CHECK( sameAsLegacy( NULL, 0 ) );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC01 ) == AF_PROFILE_RULE_NO_EP );
+}
+
+static void testZdoProfile( void )
+{
+  afProfileRule_t rules[] =
+  {
+    { ZDO_PROFILE_ID, 1 },
+    { ZDO_WILDCARD_PROFILE_ID, ZDO_EP },
+  };
+  uint8_t e;
+
+  // The ZDO and wildcard profiles are not overridden by rules
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_ACCEPT_ALL, 2, rules ) == afStatus_SUCCESS );
+  ZTEST_CHECK( afProfileAcceptEp( ZDO_PROFILE_ID ) == ZDO_EP );
+  ZTEST_CHECK( afProfileAcceptEp( ZDO_WILDCARD_PROFILE_ID ) == AF_PROFILE_RULE_ANY_EP );
+
+  // Nor does the accept all policy take other profiles to ZDO
+  for ( e = 0; e < EP_CNT; e++ )
+  {
+    uint8_t acceptEp = afProfileAcceptEp( 0x0104 );
+
+    ZTEST_CHECK( acceptEp == AF_PROFILE_RULE_ANY_EP );
+    ZTEST_CHECK( ruleAccepts( acceptEp, eps[e], 0xC05E, 0x0104 ) == (eps[e] != ZDO_EP) );
+    ZTEST_CHECK( ruleAccepts( afProfileAcceptEp( ZDO_WILDCARD_PROFILE_ID ),
+                              eps[e], 0xC05E, ZDO_WILDCARD_PROFILE_ID ) == (eps[e] != ZDO_EP) );
+  }
+
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_DEFAULT, 0, NULL ) == afStatus_SUCCESS );
+}
+
+static void testPolicy( void )
+{
+  afProfileRule_t rules[] = { { 0xFC02, 8 } };
+
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_ACCEPT_ALL, 1, rules ) == afStatus_SUCCESS );
+
+  // A rule still limits its profile to its endpoint
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC02 ) == 8 );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC01 ) == AF_PROFILE_RULE_ANY_EP );
+  ZTEST_CHECK( afProfileAcceptEp( 0x0104 ) == AF_PROFILE_RULE_ANY_EP );
+
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_MATCH, 1, rules ) == afStatus_SUCCESS );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC01 ) == AF_PROFILE_RULE_NO_EP );
+  ZTEST_CHECK( afProfileAcceptEp( 0x0104 ) == AF_PROFILE_RULE_NO_EP );
+}
+
+static void testInvalid( void )
+{
+  afProfileRule_t rules[AF_PROFILE_RULES_MAX + 1];
+  uint8_t x;
+
+  for ( x = 0; x <= AF_PROFILE_RULES_MAX; x++ )
+  {
+    rules[x].profileID = 0xFC10 + x;
+    rules[x].endPoint = x + 1;
+  }
+
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_MATCH, 1, rules ) == afStatus_SUCCESS );
+
+  // A rejected call keeps the active rules
+  ZTEST_CHECK( afSetProfileRules( 0x02, 1, rules ) == afStatus_INVALID_PARAMETER );
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_MATCH, AF_PROFILE_RULES_MAX + 1, rules ) ==
+               afStatus_INVALID_PARAMETER );
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_ACCEPT_ALL, 1, NULL ) ==
+               afStatus_INVALID_PARAMETER );
+  ZTEST_CHECK( (afProfileRulesCnt == 1) && (afProfilePolicy == AF_PROFILE_POLICY_MATCH) );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC10 ) == 1 );
+
+  // A full table
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_MATCH, AF_PROFILE_RULES_MAX, rules ) ==
+               afStatus_SUCCESS );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC10 + AF_PROFILE_RULES_MAX - 1 ) == AF_PROFILE_RULES_MAX );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC10 + AF_PROFILE_RULES_MAX ) == AF_PROFILE_RULE_NO_EP );
+
+  // Restore, the rules passed along are ignored
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_DEFAULT, AF_PROFILE_RULES_MAX + 1, NULL ) ==
+               afStatus_SUCCESS );
+  ZTEST_CHECK( (afProfileRulesCnt == 1) && (afProfilePolicy == AF_PROFILE_POLICY_MATCH) );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC01 ) == 2 );
+  ZTEST_CHECK( afProfileAcceptEp( 0xFC10 ) == AF_PROFILE_RULE_NO_EP );
+}
+
+static void testCost( void )
+{
+  afProfileRule_t quirks[AF_PROFILE_RULES_MAX];
+  uint16_t legacyCmps[AF_PROFILE_RULES_MAX + 1];
+  uint16_t ruleCmps[AF_PROFILE_RULES_MAX + 1];
+  uint8_t numQuirks;
+  uint8_t x, e, p;
+
+  for ( x = 0; x < AF_PROFILE_RULES_MAX; x++ )
+  {
+    quirks[x].profileID = 0xFC01 + x;
+    quirks[x].endPoint = eps[1 + (x % (EP_CNT - 1))];
+  }
+
+  // Comparisons over one frame of each profile to endpoints of the HA
+  // profile, which none of the frames but the HA one matches
+  for ( numQuirks = 0; numQuirks <= AF_PROFILE_RULES_MAX; numQuirks++ )
+  {
+    ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_MATCH, numQuirks, quirks ) ==
+                 afStatus_SUCCESS );
+
+    legacyCmps[numQuirks] = 0;
+    ruleCmps[numQuirks] = 0;
+    for ( p = 0; p < PROFILE_CNT; p++ )
+    {
+      uint8_t acceptEp = afProfileAcceptEp( profiles[p] );
+
+      cmpCnt = 0;
+      for ( e = 0; e < EP_CNT; e++ )
+      {
+        legacyAccepts( eps[e], 0x0104, profiles[p], quirks, numQuirks );
+      }
+      legacyCmps[numQuirks] += cmpCnt;
+
+      cmpCnt = lookupCmps( profiles[p] );
+      for ( e = 0; e < EP_CNT; e++ )
+      {
+        ruleAccepts( acceptEp, eps[e], 0x0104, profiles[p] );
+      }
+      ruleCmps[numQuirks] += cmpCnt;
+    }
+
+    printf( "  %u quirks: %u comparisons chained, %u with the rules per %u frames\n",
+            numQuirks, legacyCmps[numQuirks], ruleCmps[numQuirks], PROFILE_CNT );
+  }
+
+  // The chain pays for each quirk on every endpoint, the rules once a frame
+  ZTEST_CHECK( ruleCmps[0] <= legacyCmps[0] );
+  ZTEST_CHECK( ruleCmps[AF_PROFILE_RULES_MAX] < legacyCmps[AF_PROFILE_RULES_MAX] );
+  ZTEST_CHECK( (ruleCmps[AF_PROFILE_RULES_MAX] - ruleCmps[0]) * EP_CNT <=
+               (legacyCmps[AF_PROFILE_RULES_MAX] - legacyCmps[0]) );
+
+  ZTEST_CHECK( afSetProfileRules( AF_PROFILE_POLICY_DEFAULT, 0, NULL ) == afStatus_SUCCESS );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testDefaultRules );
+  ZTEST_RUN( testQuirks );
+  ZTEST_RUN( testZdoProfile );
+  ZTEST_RUN( testPolicy );
+  ZTEST_RUN( testInvalid );
+  ZTEST_RUN( testCost );
+
+  return ( ZTEST_RESULT );
+}
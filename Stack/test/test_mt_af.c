@@ -0,0 +1,239 @@
+/**************************************************************************************************
+  Filename:       test_mt_af.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the MT AF data request deduplication: the
+                  payload hash and the table of requests in flight.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "af.h"
+#include "rom_jt_154.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+uint32_t ztestClock = 0;
+
+#include "test_mt_af_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+typedef struct
+{
+  afAddrType_t dstAddr;
+  uint8_t srcEP;
+  uint16_t cId;
+  uint8_t transId;
+  uint16_t dataLen;
+  uint32_t hash;
+} req_t;
+
+static void reset( void )
+{
+  memset( mtAfInFlight, 0, sizeof( mtAfInFlight ) );
+  ztestClock = 1000;
+}
+
+static req_t reqOf( uint8_t transId )
+{
+  static uint8_t payload[] = { 0x18, 0x01, 0x0A, 0x00, 0x00 };
+  req_t req;
+
+  memset( &req, 0, sizeof( req ) );
+  req.dstAddr.addrMode = afAddr16Bit;
+  req.dstAddr.addr.shortAddr = 0x1234;
+  req.dstAddr.endPoint = 0x22;
+  req.dstAddr.panId = 0;
+  req.srcEP = 1;
+  req.cId = 0x000A;
+  req.transId = transId;
+  req.dataLen = sizeof( payload );
+  req.hash = MT_AfPayloadHash( payload, sizeof( payload ) );
+
+  return ( req );
+}
+
+static mtAfInFlight_t *find( req_t *req )
+{
+  return ( MT_AfInFlightFind( &req->dstAddr, req->srcEP, req->cId, req->transId,
+                              req->dataLen, req->hash ) );
+}
+
+static void add( req_t *req )
+{
+  MT_AfInFlightAdd( &req->dstAddr, req->srcEP, req->cId, req->transId,
+                    req->dataLen, req->hash );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testHash( void )
+{
+  uint8_t a[] = "a";
+  uint8_t foobar[] = "foobar";
+  uint8_t ab[] = { 0x01, 0x02 };
+  uint8_t ba[] = { 0x02, 0x01 };
+
+  // FNV-1a reference values
+  ZTEST_CHECK( MT_AfPayloadHash( NULL, 0 ) == 0x811C9DC5UL );
+  ZTEST_CHECK( MT_AfPayloadHash( a, 1 ) == 0xE40C292CUL );
+  ZTEST_CHECK( MT_AfPayloadHash( foobar, 6 ) == 0xBF9CF968UL );
+
+  // Only the length given, in order
+  ZTEST_CHECK( MT_AfPayloadHash( foobar, 1 ) == MT_AfPayloadHash( (uint8_t *)"f", 1 ) );
+  ZTEST_CHECK( MT_AfPayloadHash( ab, 2 ) != MT_AfPayloadHash( ba, 2 ) );
+}
+
+static void testFind( void )
+{
+  mtAfInFlight_t *pItem;
+  req_t req = reqOf( 5 );
+  req_t other;
+
+  reset();
+
+  ZTEST_CHECK( find( &req ) == NULL );
+  add( &req );
+  pItem = find( &req );
+  ZTEST_CHECK( (pItem != NULL) && (pItem->time == 1000) && (pItem->dupCnt == 0) );
+
+  // Every field counts
+  other = req;
+  other.srcEP++;
+  ZTEST_CHECK( find( &other ) == NULL );
+  other = req;
+  other.cId++;
+  ZTEST_CHECK( find( &other ) == NULL );
+  other = req;
+  other.transId++;
+  ZTEST_CHECK( find( &other ) == NULL );
+  other = req;
+  other.dataLen++;
+  ZTEST_CHECK( find( &other ) == NULL );
+  other = req;
+  other.hash ^= 1;
+  ZTEST_CHECK( find( &other ) == NULL );
+  other = req;
+  other.dstAddr.addr.shortAddr++;
+  ZTEST_CHECK( find( &other ) == NULL );
+  other = req;
+  other.dstAddr.endPoint++;
+  ZTEST_CHECK( find( &other ) == NULL );
+  other = req;
+  other.dstAddr.panId = 0x1A62;
+  ZTEST_CHECK( find( &other ) == NULL );
+  other = req;
+  other.dstAddr.addrMode = afAddrGroup;
+  ZTEST_CHECK( find( &other ) == NULL );
+
+  // Groupcasts by the group ID
+  other.dstAddr.addr.shortAddr = 0x0001;
+  add( &other );
+  ZTEST_CHECK( find( &other ) != NULL );
+  other.dstAddr.addr.shortAddr = 0x0002;
+  ZTEST_CHECK( find( &other ) == NULL );
+}
+
+static void testExtAddr( void )
+{
+  req_t req = reqOf( 9 );
+  req_t other;
+  uint8_t i;
+
+  reset();
+
+  req.dstAddr.addrMode = afAddr64Bit;
+  for ( i = 0; i < Z_EXTADDR_LEN; i++ )
+  {
+    req.dstAddr.addr.extAddr[i] = 0x10 + i;
+  }
+  add( &req );
+  ZTEST_CHECK( find( &req ) != NULL );
+
+  other = req;
+  other.dstAddr.addr.extAddr[Z_EXTADDR_LEN - 1] ^= 0x80;
+  ZTEST_CHECK( find( &other ) == NULL );
+
+  // The short address of the same device is another destination
+  other = req;
+  other.dstAddr.addrMode = afAddr16Bit;
+  ZTEST_CHECK( find( &other ) == NULL );
+}
+
+static void testTtl( void )
+{
+  req_t req = reqOf( 1 );
+
+  reset();
+
+  add( &req );
+  ztestClock += MT_AF_DEDUP_TTL - 1;
+  ZTEST_CHECK( find( &req ) != NULL );
+
+  // Retired on the first look past its time
+  ztestClock++;
+  ZTEST_CHECK( find( &req ) == NULL );
+  ZTEST_CHECK( mtAfInFlight[0].time == 0 );
+
+  // Across the clock wrapping
+  ztestClock = 0xFFFFF000UL;
+  add( &req );
+  ztestClock = 0x00000100UL;
+  ZTEST_CHECK( find( &req ) != NULL );
+  ztestClock = (uint32_t)(0xFFFFF000UL + MT_AF_DEDUP_TTL);
+  ZTEST_CHECK( find( &req ) == NULL );
+
+  // Sent with the clock at 0, still tracked
+  ztestClock = 0;
+  add( &req );
+  ZTEST_CHECK( mtAfInFlight[0].time == 1 );
+  ztestClock = 1;
+  ZTEST_CHECK( find( &req ) == &mtAfInFlight[0] );
+}
+
+static void testFull( void )
+{
+  req_t req;
+  uint8_t i;
+
+  reset();
+
+  for ( i = 0; i < MT_AF_DEDUP_MAX; i++ )
+  {
+    req = reqOf( i );
+    add( &req );
+    ztestClock++;
+  }
+
+  // Not tracked, the others stay
+  req = reqOf( MT_AF_DEDUP_MAX );
+  add( &req );
+  ZTEST_CHECK( find( &req ) == NULL );
+  for ( i = 0; i < MT_AF_DEDUP_MAX; i++ )
+  {
+    req = reqOf( i );
+    ZTEST_CHECK( find( &req ) == &mtAfInFlight[i] );
+  }
+
+  // A confirmed one makes room
+  mtAfInFlight[3].time = 0;
+  req = reqOf( MT_AF_DEDUP_MAX );
+  add( &req );
+  ZTEST_CHECK( find( &req ) == &mtAfInFlight[3] );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testHash );
+  ZTEST_RUN( testFind );
+  ZTEST_RUN( testExtAddr );
+  ZTEST_RUN( testTtl );
+  ZTEST_RUN( testFull );
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,635 @@
+/**************************************************************************************************
+  Filename:       test_mt_af_txclass.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the outbound traffic classes of host data
+                  requests: the class of a request, holding it back, the
+                  order and quota they are passed on in and the run time
+                  enable.  A model of the NWK data buffers drained by the
+                  MAC measures the latency of each class under an OTA
+                  burst with the classes off and on.
+**************************************************************************************************/
+
+#include <stdlib.h>
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "af.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define MT_RPC_CMD_SRSP             0x60
+#define MT_RPC_SYS_AF               4
+#define MT_RPC_FRAME_HDR_SZ         3
+#define MT_AF_TX_CLASS_SET          0x19
+#define MT_AF_TX_CLASS_STATS        0x1A
+#define MT_AF_TX_CLASS_EVT          0x4000
+
+#define AF_DATA_CONFIRM_CMD         0xFD
+
+#define NWK_DATABUF_WAITING         1
+#define NWK_DATABUF_SENT            3
+
+#define TEST_EP                     8
+
+uint8_t MT_TaskID = 3;
+
+static endPointDesc_t epDesc = { TEST_EP };
+
+// The last SRSP
+static uint8_t rspCmd;
+static uint8_t rspBuf[64];
+
+// Timer of MT_AF_TX_CLASS_EVT, in the ticks of the model
+static uint32_t now;
+static uint8_t timerArmed;
+static uint32_t timerDue;
+
+// NWK data buffers in the order the MAC sends them, the NWK layer
+// refuses a request when all are in use
+#define NWK_BUFS_MAX     24
+static uint16_t nwkBufs[NWK_BUFS_MAX];   // Transaction IDs
+static uint8_t nwkHead;
+static uint8_t nwkCnt;
+static uint8_t nwkKeep = TRUE;           // FALSE: sent at once, no load
+static afStatus_t nwkRefuse = afStatus_SUCCESS;
+
+// Clusters passed on to the NWK layer in order
+static uint16_t txLog[64];
+static uint8_t txLogCnt;
+
+static uint8_t cnfCnt;
+static afDataConfirm_t cnfLast;
+
+static uint8_t *OsalPort_bufferUint32( uint8_t *buf, uint32_t val )
+{
+  *buf++ = BREAK_UINT32( val, 0 );
+  *buf++ = BREAK_UINT32( val, 1 );
+  *buf++ = BREAK_UINT32( val, 2 );
+  *buf++ = BREAK_UINT32( val, 3 );
+
+  return ( buf );
+}
+
+static uint16_t OsalPort_buildUint16( uint8_t *swapped )
+{
+  return ( BUILD_UINT16( swapped[0], swapped[1] ) );
+}
+
+static void *OsalPort_malloc( uint32_t size )
+{
+  return ( malloc( size ) );
+}
+
+static void OsalPort_free( void *ptr )
+{
+  free( ptr );
+}
+
+static void *OsalPort_memcpy( void *dst, const void *src, unsigned int len )
+{
+  return ( memcpy( dst, src, len ) );
+}
+
+static uint8_t OsalPortTimers_startTimer( uint8_t taskId, uint32_t eventId, uint32_t timeout )
+{
+  (void)taskId;
+  (void)eventId;
+  timerArmed = TRUE;
+  timerDue = now + timeout;
+
+  return ( ZSuccess );
+}
+
+static uint8_t OsalPort_setEvent( uint8_t destinationTask, uint32_t eventFlag )
+{
+  (void)destinationTask;
+  (void)eventFlag;
+  timerArmed = TRUE;
+  timerDue = now;
+
+  return ( ZSuccess );
+}
+
+static void MT_BuildAndSendZToolResponse( uint8_t cmdType, uint8_t cmdId, uint8_t dataLen,
+                                          uint8_t *pData )
+{
+  (void)cmdType;
+  rspCmd = cmdId;
+  memcpy( rspBuf, pData, dataLen );
+}
+
+static uint8_t nwkDB_CountTypes( uint8_t type )
+{
+  if ( nwkCnt == 0 )
+  {
+    return ( 0 );
+  }
+
+  // The head buffer is on the air, the others wait for the MAC
+  return ( (type == NWK_DATABUF_SENT) ? 1 : (nwkCnt - 1) );
+}
+
+endPointDesc_t *afFindEndPointDesc( uint8_t endPoint )
+{
+  return ( (endPoint == epDesc.endPoint) ? &epDesc : NULL );
+}
+
+afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                           uint16_t cID, uint16_t len, uint8_t *buf, uint8_t *transID,
+                           uint8_t options, uint8_t radius )
+{
+  (void)dstAddr;
+  (void)srcEP;
+  (void)len;
+  (void)buf;
+  (void)options;
+  (void)radius;
+
+  if ( nwkRefuse != afStatus_SUCCESS )
+  {
+    return ( nwkRefuse );
+  }
+  if ( nwkCnt >= NWK_BUFS_MAX )
+  {
+    return ( afStatus_MEM_FAIL );
+  }
+
+  if ( txLogCnt < (sizeof( txLog ) / sizeof( txLog[0] )) )
+  {
+    txLog[txLogCnt++] = cID;
+  }
+  if ( nwkKeep )
+  {
+    nwkBufs[(nwkHead + nwkCnt++) % NWK_BUFS_MAX] = *transID;
+  }
+
+  return ( afStatus_SUCCESS );
+}
+
+void MT_AfDataConfirm( afDataConfirm_t *pMsg )
+{
+  cnfCnt++;
+  cnfLast = *pMsg;
+}
+
+#include "test_mt_af_txclass_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define CID_ONOFF       0x0006
+#define CID_TEMP        0x0402
+#define CID_OTA         0x0019
+
+static void reset( uint8_t enabled )
+{
+  mtAfTxClassReq_t *pReq;
+  uint8_t i;
+
+  for ( i = 0; i < MT_AF_TX_CLASS_CNT; i++ )
+  {
+    while ( (pReq = mtAfTxClass[i].pHead) != NULL )
+    {
+      mtAfTxClass[i].pHead = pReq->next;
+      free( pReq );
+    }
+    mtAfTxClass[i].depth = 0;
+    mtAfTxClass[i].maxDepth = 0;
+    mtAfTxClass[i].sentCnt = 0;
+    mtAfTxClass[i].dropCnt = 0;
+  }
+  mtAfTxClass[MT_AF_TX_CLASS_NORMAL - 1].limit = MT_AF_TX_CLASS_NORMAL_DEPTH;
+  mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].limit = MT_AF_TX_CLASS_BULK_DEPTH;
+  mtAfTxClassEnabled = enabled;
+  mtAfTxClassDefault = MT_AF_TX_CLASS_NORMAL;
+  mtAfTxClassRun = 0;
+
+  now = 0;
+  timerArmed = FALSE;
+  nwkHead = 0;
+  nwkCnt = 0;
+  nwkKeep = TRUE;
+  nwkRefuse = afStatus_SUCCESS;
+  txLogCnt = 0;
+  cnfCnt = 0;
+}
+
+// The class part of MT_AfDataRequest()
+static uint8_t hostRequest( uint16_t cId, uint8_t txOpts, uint8_t transId )
+{
+  static uint8_t payload[] = { 0x00, 0x01, 0x02, 0x03 };
+  afAddrType_t dstAddr;
+  uint8_t txClass = MT_AfTxClassGet( cId, txOpts );
+  uint8_t status;
+
+  memset( &dstAddr, 0, sizeof( dstAddr ) );
+  dstAddr.addrMode = afAddr16Bit;
+  dstAddr.addr.shortAddr = 0x1234;
+  dstAddr.endPoint = 1;
+
+  txOpts &= ~MT_AF_TX_OPTIONS_BULK;
+
+  if ( MT_AfTxClassHeld( txClass ) )
+  {
+    return ( MT_AfTxClassQueue( txClass, &dstAddr, TEST_EP, cId, sizeof( payload ), payload,
+                                transId, txOpts, AF_DEFAULT_RADIUS ) );
+  }
+
+  status = AF_DataRequest( &dstAddr, &epDesc, cId, sizeof( payload ), payload, &transId,
+                           txOpts, AF_DEFAULT_RADIUS );
+  if ( status == afStatus_SUCCESS )
+  {
+    mtAfTxClass[txClass - 1].sentCnt++;
+  }
+
+  return ( status );
+}
+
+// Fill the NWK data buffers up to a load
+static void nwkLoad( uint8_t load )
+{
+  nwkHead = 0;
+  nwkCnt = 0;
+  while ( nwkCnt < load )
+  {
+    nwkBufs[nwkCnt++] = 0xFFFF;
+  }
+}
+
+static uint8_t classSet( uint16_t cId, uint8_t txClass )
+{
+  uint8_t frame[MT_RPC_FRAME_HDR_SZ + 3] = { 0 };
+
+  frame[MT_RPC_FRAME_HDR_SZ] = LO_UINT16( cId );
+  frame[MT_RPC_FRAME_HDR_SZ + 1] = HI_UINT16( cId );
+  frame[MT_RPC_FRAME_HDR_SZ + 2] = txClass;
+  MT_AfTxClassSet( frame );
+
+  return ( rspBuf[0] );
+}
+
+static void classStats( uint8_t enable, uint8_t normalLimit, uint8_t bulkLimit, uint8_t clear )
+{
+  uint8_t frame[MT_RPC_FRAME_HDR_SZ + 4] = { 0 };
+
+  frame[MT_RPC_FRAME_HDR_SZ] = enable;
+  frame[MT_RPC_FRAME_HDR_SZ + 1] = normalLimit;
+  frame[MT_RPC_FRAME_HDR_SZ + 2] = bulkLimit;
+  frame[MT_RPC_FRAME_HDR_SZ + 3] = clear;
+  MT_AfTxClassStats( frame );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testClassOf( void )
+{
+  reset( FALSE );
+
+  // Off: everything at once, the bulk option too
+  ZTEST_CHECK( MT_AfTxClassGet( CID_OTA, 0 ) == MT_AF_TX_CLASS_INTERACTIVE );
+  ZTEST_CHECK( MT_AfTxClassGet( CID_TEMP, MT_AF_TX_OPTIONS_BULK ) == MT_AF_TX_CLASS_INTERACTIVE );
+
+  reset( TRUE );
+
+  ZTEST_CHECK( MT_AfTxClassGet( CID_OTA, 0 ) == MT_AF_TX_CLASS_BULK );
+  ZTEST_CHECK( MT_AfTxClassGet( CID_ONOFF, 0 ) == MT_AF_TX_CLASS_INTERACTIVE );
+  ZTEST_CHECK( MT_AfTxClassGet( CID_TEMP, 0 ) == MT_AF_TX_CLASS_NORMAL );
+  ZTEST_CHECK( MT_AfTxClassGet( CID_ONOFF, MT_AF_TX_OPTIONS_BULK ) == MT_AF_TX_CLASS_BULK );
+}
+
+static void testRules( void )
+{
+  uint8_t i;
+
+  reset( TRUE );
+
+  ZTEST_CHECK( classSet( CID_TEMP, MT_AF_TX_CLASS_CNT + 1 ) == afStatus_INVALID_PARAMETER );
+  ZTEST_CHECK( classSet( MT_AF_TX_CLASS_DEFAULT_CID, MT_AF_TX_CLASS_NONE ) == afStatus_INVALID_PARAMETER );
+
+  ZTEST_CHECK( classSet( CID_TEMP, MT_AF_TX_CLASS_BULK ) == afStatus_SUCCESS );
+  ZTEST_CHECK( MT_AfTxClassGet( CID_TEMP, 0 ) == MT_AF_TX_CLASS_BULK );
+  ZTEST_CHECK( classSet( CID_TEMP, MT_AF_TX_CLASS_INTERACTIVE ) == afStatus_SUCCESS );
+  ZTEST_CHECK( MT_AfTxClassGet( CID_TEMP, 0 ) == MT_AF_TX_CLASS_INTERACTIVE );
+  ZTEST_CHECK( classSet( CID_TEMP, MT_AF_TX_CLASS_NONE ) == afStatus_SUCCESS );
+  ZTEST_CHECK( MT_AfTxClassGet( CID_TEMP, 0 ) == MT_AF_TX_CLASS_NORMAL );
+
+  ZTEST_CHECK( classSet( MT_AF_TX_CLASS_DEFAULT_CID, MT_AF_TX_CLASS_BULK ) == afStatus_SUCCESS );
+  ZTEST_CHECK( MT_AfTxClassGet( CID_TEMP, 0 ) == MT_AF_TX_CLASS_BULK );
+  ZTEST_CHECK( classSet( MT_AF_TX_CLASS_DEFAULT_CID, MT_AF_TX_CLASS_NORMAL ) == afStatus_SUCCESS );
+
+  // Four rules in the tree, then the table is full
+  for ( i = 0; i < (MT_AF_TX_CLASS_RULES_MAX - 4); i++ )
+  {
+    ZTEST_CHECK( classSet( 0x1000 + i, MT_AF_TX_CLASS_BULK ) == afStatus_SUCCESS );
+  }
+  ZTEST_CHECK( classSet( 0x2000, MT_AF_TX_CLASS_BULK ) == afStatus_MEM_FAIL );
+  ZTEST_CHECK( classSet( 0x1000, MT_AF_TX_CLASS_NONE ) == afStatus_SUCCESS );
+  ZTEST_CHECK( classSet( 0x2000, MT_AF_TX_CLASS_BULK ) == afStatus_SUCCESS );
+  for ( i = 1; i < (MT_AF_TX_CLASS_RULES_MAX - 4); i++ )
+  {
+    (void)classSet( 0x1000 + i, MT_AF_TX_CLASS_NONE );
+  }
+  (void)classSet( 0x2000, MT_AF_TX_CLASS_NONE );
+}
+
+static void testEnable( void )
+{
+  reset( FALSE );
+
+  // Leave as is
+  classStats( 0xFF, 0, 0, FALSE );
+  ZTEST_CHECK( (rspCmd == MT_AF_TX_CLASS_STATS) && (rspBuf[0] == afStatus_SUCCESS) );
+  ZTEST_CHECK( (rspBuf[1] == FALSE) && (mtAfTxClassEnabled == FALSE) );
+
+  // Off: an OTA request under load goes to the NWK layer at once
+  nwkLoad( MT_AF_TX_CLASS_BULK_LOAD );
+  ZTEST_CHECK( hostRequest( CID_OTA, 0, 1 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( (txLogCnt == 1) && (mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].depth == 0) );
+  ZTEST_CHECK( mtAfTxClass[MT_AF_TX_CLASS_INTERACTIVE - 1].sentCnt == 1 );
+
+  classStats( 1, 0, 0, FALSE );
+  ZTEST_CHECK( (rspBuf[1] == TRUE) && (mtAfTxClassEnabled == TRUE) );
+  ZTEST_CHECK( rspBuf[2] == (MT_AF_TX_CLASS_BULK_LOAD + 1) );
+
+  // On: held back
+  ZTEST_CHECK( hostRequest( CID_OTA, 0, 2 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( (txLogCnt == 1) && (mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].depth == 1) );
+  ZTEST_CHECK( timerArmed );
+
+  // Off again: new requests go at once, the held one still goes out
+  classStats( 0, 0, 0, FALSE );
+  ZTEST_CHECK( (rspBuf[1] == FALSE) && (mtAfTxClassEnabled == FALSE) );
+  ZTEST_CHECK( hostRequest( CID_OTA, 0, 3 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( txLogCnt == 2 );
+  nwkLoad( 0 );
+  MT_AfTxClassExec();
+  ZTEST_CHECK( (txLogCnt == 3) && (mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].depth == 0) );
+}
+
+static void testLimits( void )
+{
+  uint8_t i;
+
+  reset( TRUE );
+
+  classStats( 0xFF, 3, 2, FALSE );
+  ZTEST_CHECK( mtAfTxClass[MT_AF_TX_CLASS_NORMAL - 1].limit == 3 );
+  ZTEST_CHECK( mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].limit == 2 );
+
+  nwkLoad( MT_AF_TX_CLASS_NORMAL_LOAD );
+  for ( i = 0; i < 3; i++ )
+  {
+    ZTEST_CHECK( hostRequest( CID_OTA, 0, i ) == ((i < 2) ? afStatus_SUCCESS : afStatus_MEM_FAIL) );
+  }
+  ZTEST_CHECK( mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].dropCnt == 1 );
+
+  // | status | enabled | load | per class: depth | limit | maxDepth | sent | dropped |
+  classStats( 0xFF, 0, 0, TRUE );
+  ZTEST_CHECK( rspBuf[3 + ((MT_AF_TX_CLASS_BULK - 1) * 11)] == 2 );
+  ZTEST_CHECK( rspBuf[3 + ((MT_AF_TX_CLASS_BULK - 1) * 11) + 1] == 2 );
+  ZTEST_CHECK( rspBuf[3 + ((MT_AF_TX_CLASS_BULK - 1) * 11) + 2] == 2 );
+  ZTEST_CHECK( rspBuf[3 + ((MT_AF_TX_CLASS_BULK - 1) * 11) + 7] == 1 );
+  ZTEST_CHECK( mtAfTxClass[MT_AF_TX_CLASS_BULK - 1].dropCnt == 0 );
+}
+
+static void testHeld( void )
+{
+  reset( TRUE );
+
+  // Interactive never
+  nwkLoad( NWK_BUFS_MAX - 1 );
+  ZTEST_CHECK( MT_AfTxClassHeld( MT_AF_TX_CLASS_INTERACTIVE ) == FALSE );
+
+  // Bulk is held back from a lower load than normal
+  nwkLoad( MT_AF_TX_CLASS_BULK_LOAD - 1 );
+  ZTEST_CHECK( MT_AfTxClassHeld( MT_AF_TX_CLASS_BULK ) == FALSE );
+  nwkLoad( MT_AF_TX_CLASS_BULK_LOAD );
+  ZTEST_CHECK( MT_AfTxClassHeld( MT_AF_TX_CLASS_BULK ) == TRUE );
+  ZTEST_CHECK( MT_AfTxClassHeld( MT_AF_TX_CLASS_NORMAL ) == FALSE );
+  nwkLoad( MT_AF_TX_CLASS_NORMAL_LOAD );
+  ZTEST_CHECK( MT_AfTxClassHeld( MT_AF_TX_CLASS_NORMAL ) == TRUE );
+
+  // Behind a held request of its class, whatever the load
+  ZTEST_CHECK( hostRequest( CID_TEMP, 0, 1 ) == afStatus_SUCCESS );
+  nwkLoad( 0 );
+  ZTEST_CHECK( MT_AfTxClassHeld( MT_AF_TX_CLASS_NORMAL ) == TRUE );
+  ZTEST_CHECK( hostRequest( CID_TEMP, 0, 2 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( txLogCnt == 0 );
+
+  nwkKeep = FALSE;
+  MT_AfTxClassExec();
+  ZTEST_CHECK( (txLogCnt == 2) && (mtAfTxClass[MT_AF_TX_CLASS_NORMAL - 1].sentCnt == 2) );
+  ZTEST_CHECK( timerArmed );
+}
+
+static void testQuota( void )
+{
+  const uint16_t expect[] = { CID_TEMP, CID_TEMP, CID_TEMP, CID_TEMP, CID_OTA,
+                              CID_TEMP, CID_TEMP, CID_OTA, CID_OTA };
+  uint8_t i;
+
+  reset( TRUE );
+
+  nwkLoad( MT_AF_TX_CLASS_NORMAL_LOAD );
+  for ( i = 0; i < 6; i++ )
+  {
+    ZTEST_CHECK( hostRequest( CID_TEMP, 0, i ) == afStatus_SUCCESS );
+  }
+  for ( i = 0; i < 3; i++ )
+  {
+    ZTEST_CHECK( hostRequest( CID_OTA, 0, 10 + i ) == afStatus_SUCCESS );
+  }
+
+  // Still loaded
+  MT_AfTxClassExec();
+  ZTEST_CHECK( txLogCnt == 0 );
+
+  nwkLoad( 0 );
+  nwkKeep = FALSE;
+  for ( i = 0; (i < 4) && timerArmed; i++ )
+  {
+    timerArmed = FALSE;
+    MT_AfTxClassExec();
+  }
+  ZTEST_CHECK( !timerArmed );
+  ZTEST_CHECK( txLogCnt == sizeof( expect ) / sizeof( expect[0] ) );
+  ZTEST_CHECK( memcmp( txLog, expect, sizeof( expect ) ) == 0 );
+  ZTEST_CHECK( mtAfTxClassRun == 0 );
+}
+
+static void testRefused( void )
+{
+  reset( TRUE );
+
+  nwkLoad( MT_AF_TX_CLASS_NORMAL_LOAD );
+  ZTEST_CHECK( hostRequest( CID_TEMP, 0, 7 ) == afStatus_SUCCESS );
+  nwkLoad( 0 );
+  nwkRefuse = ZNwkTableFull;
+  MT_AfTxClassExec();
+  ZTEST_CHECK( (cnfCnt == 1) && (cnfLast.hdr.status == ZNwkTableFull) );
+  ZTEST_CHECK( (cnfLast.hdr.event == AF_DATA_CONFIRM_CMD) && (cnfLast.transID == 7) );
+  ZTEST_CHECK( (cnfLast.endpoint == TEST_EP) && (cnfLast.clusterID == CID_TEMP) );
+  ZTEST_CHECK( mtAfTxClass[MT_AF_TX_CLASS_NORMAL - 1].depth == 0 );
+
+  // The endpoint was deleted while the request was held back
+  nwkRefuse = afStatus_SUCCESS;
+  nwkLoad( MT_AF_TX_CLASS_NORMAL_LOAD );
+  ZTEST_CHECK( hostRequest( CID_TEMP, 0, 8 ) == afStatus_SUCCESS );
+  nwkLoad( 0 );
+  epDesc.endPoint = TEST_EP + 1;
+  MT_AfTxClassExec();
+  epDesc.endPoint = TEST_EP;
+  ZTEST_CHECK( (cnfCnt == 2) && (cnfLast.hdr.status == afStatus_INVALID_PARAMETER) );
+  ZTEST_CHECK( txLogCnt == 0 );
+}
+
+/*********************************************************************
+ * LATENCY
+ *
+ * The MAC sends the head NWK data buffer every MAC_FRAME_TICKS.  The
+ * host sends an OTA block every tick for the first BULK_BURST ticks of
+ * every BULK_PERIOD, a normal report every NORMAL_PERIOD and an On/Off
+ * command every INTERACTIVE_PERIOD.  The latency of a request is from
+ * the host sending it to the MAC sending it.
+ */
+#define MAC_FRAME_TICKS       4
+#define BULK_PERIOD           250
+#define BULK_BURST            16
+#define NORMAL_PERIOD         20
+#define INTERACTIVE_PERIOD    50
+#define RUN_TICKS             5000
+
+typedef struct
+{
+  uint32_t cnt;
+  uint32_t sum;
+  uint32_t max;
+  uint32_t refused;
+} latency_t;
+
+static uint32_t sentAt[256];
+static uint8_t classOfTrans[256];
+
+static void simulate( uint8_t enabled, latency_t *lat )
+{
+  uint8_t transId = 0;
+  uint8_t txClass;
+  uint16_t cId;
+  uint8_t i;
+
+  reset( enabled );
+  memset( lat, 0, sizeof( latency_t ) * MT_AF_TX_CLASS_CNT );
+
+  // Then run on until the queues are empty
+  for ( now = 0; (now < RUN_TICKS) || nwkCnt || timerArmed; now++ )
+  {
+    for ( i = 0; (i < 3) && (now < RUN_TICKS); i++ )
+    {
+      if ( i == 0 )
+      {
+        if ( (now % BULK_PERIOD) >= BULK_BURST )
+        {
+          continue;
+        }
+        cId = CID_OTA;
+        txClass = MT_AF_TX_CLASS_BULK;
+      }
+      else if ( i == 1 )
+      {
+        if ( (now % NORMAL_PERIOD) != 3 )
+        {
+          continue;
+        }
+        cId = CID_TEMP;
+        txClass = MT_AF_TX_CLASS_NORMAL;
+      }
+      else
+      {
+        if ( (now % INTERACTIVE_PERIOD) != 7 )
+        {
+          continue;
+        }
+        cId = CID_ONOFF;
+        txClass = MT_AF_TX_CLASS_INTERACTIVE;
+      }
+
+      sentAt[transId] = now;
+      classOfTrans[transId] = txClass;
+      if ( hostRequest( cId, 0, transId ) != afStatus_SUCCESS )
+      {
+        lat[txClass - 1].refused++;
+      }
+      transId++;
+    }
+
+    if ( timerArmed && (now >= timerDue) )
+    {
+      timerArmed = FALSE;
+      MT_AfTxClassExec();
+    }
+
+    if ( nwkCnt && ((now % MAC_FRAME_TICKS) == 0) )
+    {
+      uint8_t sent = (uint8_t)nwkBufs[nwkHead];
+      latency_t *pLat = &lat[classOfTrans[sent] - 1];
+      uint32_t t = now - sentAt[sent];
+
+      pLat->cnt++;
+      pLat->sum += t;
+      if ( t > pLat->max )
+      {
+        pLat->max = t;
+      }
+      nwkHead = (nwkHead + 1) % NWK_BUFS_MAX;
+      nwkCnt--;
+    }
+  }
+}
+
+static void testLatency( void )
+{
+  const char *names[MT_AF_TX_CLASS_CNT] = { "interactive", "normal", "bulk" };
+  latency_t off[MT_AF_TX_CLASS_CNT];
+  latency_t on[MT_AF_TX_CLASS_CNT];
+  uint8_t i;
+
+  simulate( FALSE, off );
+  simulate( TRUE, on );
+
+  for ( i = 0; i < MT_AF_TX_CLASS_CNT; i++ )
+  {
+    printf( "%-12s off: %4u sent, mean %3u max %3u ticks   on: %4u sent, mean %3u max %3u ticks\n",
+            names[i], (unsigned)off[i].cnt, (unsigned)(off[i].sum / off[i].cnt),
+            (unsigned)off[i].max, (unsigned)on[i].cnt, (unsigned)(on[i].sum / on[i].cnt),
+            (unsigned)on[i].max );
+
+    // Every request goes out either way
+    ZTEST_CHECK( (off[i].refused == 0) && (on[i].refused == 0) );
+    ZTEST_CHECK( off[i].cnt == on[i].cnt );
+  }
+
+  // Interactive requests wait behind no more than the normal load
+  ZTEST_CHECK( on[0].max <= ((MT_AF_TX_CLASS_NORMAL_LOAD + 1) * MAC_FRAME_TICKS) );
+  ZTEST_CHECK( on[0].max < off[0].max );
+  ZTEST_CHECK( on[1].max < off[1].max );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testClassOf );
+  ZTEST_RUN( testRules );
+  ZTEST_RUN( testEnable );
+  ZTEST_RUN( testLimits );
+  ZTEST_RUN( testHeld );
+  ZTEST_RUN( testQuota );
+  ZTEST_RUN( testRefused );
+  ZTEST_RUN( testLatency );
+
+  reset( FALSE );
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,1189 @@
+/**************************************************************************************************
+  Filename:       test_mt_zdo_cb.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the ZDO indications MT ZDO writes in
+                  place in its ring of MT buffers: the buffers reused
+                  once the transport released them, the own buffers
+                  taken while the ring is busy, the indications dropped
+                  and counted, MT_ZDO_CB_STATS and the leave batches of
+                  ZDApp in both leave indication modes.  A replay of
+                  indications behind a slow serial link counts the heap
+                  allocations and the heap held against the indications
+                  built in a temporary buffer and copied as before.
+                  Synthetic leave storms run through the leave batch of
+                  ZDApp on a simulated clock, counting the NV writes and
+                  the serial bytes against a leave handled alone.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "comdef.h"
+#include "osal_port.h"
+#include "osal_port_timers.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define HEAP_BLOCKS     256
+#define LINK_Q_MAX      64
+
+#define ZSuccess            0x00
+#define ZInvalidParameter   0x02
+#define ZBufferFull         0x11
+#define Z_EXTADDR_LEN       8
+
+typedef uint8_t ZStatus_t;
+
+#define osal_cpyExtAddr( a, b )     memcpy( (a), (b), Z_EXTADDR_LEN )
+#define osal_ExtAddrEqual( a, b )   ( memcmp( (a), (b), Z_EXTADDR_LEN ) == 0 )
+
+// A router with children, its NV saved ZDAPP_UPDATE_NWK_NV_TIME after
+// the first change as with the ZDO_NV_SAVE_RFDs default
+#define ZSTACK_ROUTER_BUILD         1
+#define ZSTACK_END_DEVICE_BUILD     0
+#define NODETYPE_ROUTER             0x01
+#define NODETYPE_DEVICE             0x02
+#define CAPINFO_DEVICETYPE_FFD      0x02
+#define ZDAPP_UPDATE_NWK_NV_TIME    2500
+#define ZMacRxOnIdle                0x52
+
+// Live heap blocks, a freed block is filled so stale reads show
+static void *heapBlocks[HEAP_BLOCKS];
+static uint16_t heapLive;
+static uint16_t heapFailIn;     // Fail the n-th allocation from now, 0 never
+static uint32_t heapAllocs;
+static uint32_t heapBytes;      // Bytes allocated and not freed yet
+static uint32_t heapPeak;
+
+void* OsalPort_malloc( uint32_t size )
+{
+  uint16_t x;
+  void *pBuf;
+
+  if ( heapFailIn && (--heapFailIn == 0) )
+  {
+    return ( NULL );
+  }
+
+  pBuf = malloc( size + sizeof( uint32_t ) );
+  if ( pBuf == NULL )
+  {
+    return ( NULL );
+  }
+  memcpy( pBuf, &size, sizeof( uint32_t ) );
+
+  for ( x = 0; x < HEAP_BLOCKS; x++ )
+  {
+    if ( heapBlocks[x] == NULL )
+    {
+      heapBlocks[x] = pBuf;
+      heapLive++;
+      heapAllocs++;
+      heapBytes += size;
+      if ( heapBytes > heapPeak )
+      {
+        heapPeak = heapBytes;
+      }
+      break;
+    }
+  }
+
+  return ( (uint8_t *)pBuf + sizeof( uint32_t ) );
+}
+
+void OsalPort_free( void* buf )
+{
+  uint8_t *pBuf = (uint8_t *)buf - sizeof( uint32_t );
+  uint32_t size;
+  uint16_t x;
+
+  for ( x = 0; x < HEAP_BLOCKS; x++ )
+  {
+    if ( heapBlocks[x] == pBuf )
+    {
+      heapBlocks[x] = NULL;
+      heapLive--;
+      memcpy( &size, pBuf, sizeof( uint32_t ) );
+      heapBytes -= size;
+      memset( buf, 0xDD, size );
+      free( pBuf );
+      return;
+    }
+  }
+
+  // Freed twice or never allocated
+  ZTEST_CHECK( x < HEAP_BLOCKS );
+}
+
+void *OsalPort_memcpy( void *dst, const void *src, unsigned int len )
+{
+  return ( memcpy( dst, src, len ) );
+}
+
+uint32_t OsalPort_enterCS( void )
+{
+  return ( 0 );
+}
+
+void OsalPort_leaveCS( uint32_t key )
+{
+  (void)key;
+}
+
+uint8_t *MT_AllocZToolResponse( uint8_t cmdType, uint8_t cmdId, uint8_t dataLen );
+void MT_SendZToolResponse( uint8_t *pData );
+void MT_BuildAndSendZToolResponse( uint8_t cmdType, uint8_t cmdId, uint8_t dataLen, uint8_t *pData );
+void AddrMgrWriteNVRequest( void );
+
+static struct
+{
+  uint8_t CapabilityFlags;
+} _NIB = { CAPINFO_DEVICETYPE_FFD };
+
+static struct
+{
+  uint8_t LogicalType;
+} ZDO_Config_Node_Descriptor = { NODETYPE_ROUTER };
+
+static uint8_t myExtAddr[Z_EXTADDR_LEN] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+
+// ZDApp timers on the simulated clock, the events they set and the
+// counts of the leave storms
+static uint32_t simClock;
+static uint32_t zdAppEvents;
+static uint32_t timerDue[2];
+static uint8_t timerOn[2];
+static uint32_t leaveCleanups;
+static uint32_t nvRequests;     // ZDApp_NwkWriteNVRequest calls
+static uint32_t nvWrites;       // ZDO_NWK_UPDATE_NV events, each saves the network state
+static uint32_t leaveResets;
+
+void ZEvtLogAdd( uint8_t type, uint8_t info, uint8_t param, uint16_t nwkAddr, uint8_t *extAddr )
+{
+  (void)type;
+  (void)info;
+  (void)param;
+  (void)nwkAddr;
+  (void)extAddr;
+}
+
+static uint8_t *NLME_GetExtAddr( void )
+{
+  return ( myExtAddr );
+}
+
+static uint16_t NLME_GetCoordShortAddr( void )
+{
+  return ( 0x0000 );
+}
+
+static void bdb_setFN( void )
+{
+}
+
+static uint8_t ZMacSetReq( uint8_t attr, uint8_t *pValue )
+{
+  (void)attr;
+  (void)pValue;
+
+  return ( ZSuccess );
+}
+
+static void ZDApp_LeaveReset( uint8_t ra )
+{
+  (void)ra;
+  leaveResets++;
+}
+
+// The security, binding, routing and neighbor tables it clears
+static void ZDApp_LeaveCleanup( uint16_t nwkAddr, uint8_t* extAddr,
+                                uint8_t removeChildren, uint8_t rejoin )
+{
+  (void)nwkAddr;
+  (void)extAddr;
+  (void)removeChildren;
+  (void)rejoin;
+  leaveCleanups++;
+}
+
+#include "test_mt_zdo_cb_items.c"
+
+// ZDO_LEAVE_BATCH_EVT and ZDO_NWK_UPDATE_NV
+static uint8_t timerIdx( uint32_t eventId )
+{
+  ZTEST_CHECK( (eventId == ZDO_LEAVE_BATCH_EVT) || (eventId == ZDO_NWK_UPDATE_NV) );
+
+  return ( (eventId == ZDO_LEAVE_BATCH_EVT) ? 0 : 1 );
+}
+
+uint8_t OsalPortTimers_startTimer( uint8_t taskId, uint32_t eventId, uint32_t timeoutValue )
+{
+  uint8_t idx = timerIdx( eventId );
+
+  (void)taskId;
+  timerOn[idx] = TRUE;
+  timerDue[idx] = simClock + timeoutValue;
+
+  return ( ZSuccess );
+}
+
+uint8_t OsalPortTimers_stopTimer( uint8_t taskId, uint32_t eventId )
+{
+  (void)taskId;
+  timerOn[timerIdx( eventId )] = FALSE;
+
+  return ( ZSuccess );
+}
+
+// Only ZDApp_NwkWriteNVRequest() asks for the NV update timer
+uint32_t OsalPortTimers_getTimerTimeout( uint8_t taskId, uint32_t eventId )
+{
+  uint8_t idx = timerIdx( eventId );
+
+  (void)taskId;
+  if ( eventId == ZDO_NWK_UPDATE_NV )
+  {
+    nvRequests++;
+  }
+
+  return ( timerOn[idx] ? (timerDue[idx] - simClock) + 1 : 0 );
+}
+
+uint8_t OsalPort_setEvent( uint8_t destinationTask, uint32_t eventFlag )
+{
+  (void)destinationTask;
+  zdAppEvents |= eventFlag;
+
+  return ( ZSuccess );
+}
+
+ZStatus_t NLME_LeaveRsp( NLME_LeaveRsp_t *rsp )
+{
+  (void)rsp;
+
+  return ( ZSuccess );
+}
+
+// Serial link: the messages sent and not on the wire yet, released by
+// linkDrain() as the NPI task does once it sent them
+static uint8_t *linkQ[LINK_Q_MAX];
+static uint8_t linkCnt;
+static uint32_t linkBytes;
+static uint8_t linkLast[MT_RPC_FRAME_HDR_SZ + MT_RPC_DATA_MAX];
+
+// Data field after SOF, LEN, CMD0 and CMD1, an FCS byte after it
+uint8_t *MT_AllocZToolResponse( uint8_t cmdType, uint8_t cmdId, uint8_t dataLen )
+{
+  uint8_t *pMsg = OsalPort_msgAllocate( MT_RSP_DATA_OFS + dataLen + 1 );
+
+  if ( pMsg == NULL )
+  {
+    return ( NULL );
+  }
+
+  pMsg[1 + MT_RPC_POS_LEN] = dataLen;
+  pMsg[1 + MT_RPC_POS_CMD0] = cmdType;
+  pMsg[1 + MT_RPC_POS_CMD1] = cmdId;
+
+  return ( pMsg + MT_RSP_DATA_OFS );
+}
+
+void MT_SendZToolResponse( uint8_t *pData )
+{
+  ZTEST_CHECK( linkCnt < LINK_Q_MAX );
+  linkQ[linkCnt++] = pData - MT_RSP_DATA_OFS;
+}
+
+void MT_BuildAndSendZToolResponse( uint8_t cmdType, uint8_t cmdId, uint8_t dataLen, uint8_t *pData )
+{
+  uint8_t *pRsp = MT_AllocZToolResponse( cmdType, cmdId, dataLen );
+
+  if ( pRsp != NULL )
+  {
+    memcpy( pRsp, pData, dataLen );
+    MT_SendZToolResponse( pRsp );
+  }
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+
+// Send up to cnt messages from the link, the last one kept in linkLast
+static void linkDrain( uint8_t cnt )
+{
+  uint8_t x;
+
+  if ( cnt > linkCnt )
+  {
+    cnt = linkCnt;
+  }
+
+  for ( x = 0; x < cnt; x++ )
+  {
+    uint8_t *pMsg = linkQ[x];
+    uint8_t len = MT_RPC_FRAME_HDR_SZ + pMsg[1 + MT_RPC_POS_LEN];
+
+    memcpy( linkLast, pMsg + 1, len );
+    linkBytes += 1 + len + 1;
+    ZTEST_CHECK( OsalPort_msgDeallocate( pMsg ) == OsalPort_SUCCESS );
+  }
+
+  memmove( linkQ, linkQ + cnt, (linkCnt - cnt) * sizeof( linkQ[0] ) );
+  linkCnt -= cnt;
+}
+
+// Ring buffers are held for good, the tests give them back to the heap
+static void ringFree( void )
+{
+  uint8_t idx;
+
+  for ( idx = 0; idx < MT_ZDO_CB_RING_SIZE; idx++ )
+  {
+    if ( mtZdoCbRing[idx] != NULL )
+    {
+      ZTEST_CHECK( OsalPort_msgDeallocate( mtZdoCbRing[idx] - MT_RSP_DATA_OFS ) == OsalPort_SUCCESS );
+      mtZdoCbRing[idx] = NULL;
+    }
+  }
+}
+
+static void reset( void )
+{
+  linkDrain( LINK_Q_MAX );
+  ringFree();
+  ZTEST_CHECK( heapLive == 0 );
+  heapFailIn = 0;
+  heapAllocs = 0;
+  heapPeak = heapBytes;
+  linkBytes = 0;
+  MT_ZdoCbDropCnt = 0;
+}
+
+static void annce( uint16_t srcAddr, uint16_t nwkAddr )
+{
+  ZDO_DeviceAnnce_t devAnnce;
+
+  devAnnce.nwkAddr = nwkAddr;
+  memset( devAnnce.extAddr, (uint8_t)nwkAddr, Z_EXTADDR_LEN );
+  devAnnce.capabilities = 0x8E;
+
+  MT_ZdoEndDevAnnceCB( &devAnnce, srcAddr );
+}
+
+static void srcRtg( uint16_t srcAddr, uint8_t relayCnt )
+{
+  uint16_t relays[8];
+  zdoSrcRtg_t rtg;
+  uint8_t x;
+
+  for ( x = 0; x < relayCnt; x++ )
+  {
+    relays[x] = srcAddr + x + 1;
+  }
+  rtg.srcAddr = srcAddr;
+  rtg.relayCnt = relayCnt;
+  rtg.pRelayList = relays;
+
+  (void)MT_ZdoSrcRtgCB( &rtg );
+}
+
+// MT_ZdoEndDevAnnceCB() and MT_ZdoSrcRtgCB() before the ring: a
+// temporary buffer copied into the MT buffer
+static void legacyAnnce( uint16_t srcAddr, uint16_t nwkAddr )
+{
+  uint8_t *pBuf;
+
+  if ( NULL != (pBuf = (uint8_t *)OsalPort_malloc( MT_ZDO_END_DEVICE_ANNCE_IND_LEN )) )
+  {
+    uint8_t *pTmp = pBuf;
+
+    *pTmp++ = LO_UINT16( srcAddr );
+    *pTmp++ = HI_UINT16( srcAddr );
+    *pTmp++ = LO_UINT16( nwkAddr );
+    *pTmp++ = HI_UINT16( nwkAddr );
+    memset( pTmp, (uint8_t)nwkAddr, Z_EXTADDR_LEN );
+    pTmp += Z_EXTADDR_LEN;
+    *pTmp = 0x8E;
+
+    MT_BuildAndSendZToolResponse( ((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
+                                  MT_ZDO_END_DEVICE_ANNCE_IND,
+                                  MT_ZDO_END_DEVICE_ANNCE_IND_LEN, pBuf );
+    OsalPort_free( pBuf );
+  }
+}
+
+static void legacySrcRtg( uint16_t srcAddr, uint8_t relayCnt )
+{
+  uint8_t len = 2 + 1 + relayCnt * sizeof( uint16_t );
+  uint8_t *pBuf;
+  uint8_t x;
+
+  if ( NULL != (pBuf = (uint8_t *)OsalPort_malloc( len )) )
+  {
+    uint8_t *pTmp = pBuf;
+
+    *pTmp++ = LO_UINT16( srcAddr );
+    *pTmp++ = HI_UINT16( srcAddr );
+    *pTmp++ = relayCnt;
+    for ( x = 0; x < relayCnt; x++ )
+    {
+      *pTmp++ = LO_UINT16( srcAddr + x + 1 );
+      *pTmp++ = HI_UINT16( srcAddr + x + 1 );
+    }
+
+    MT_BuildAndSendZToolResponse( ((uint8_t)MT_RPC_CMD_AREQ | (uint8_t)MT_RPC_SYS_ZDO),
+                                  MT_ZDO_SRC_RTG_IND, len, pBuf );
+    OsalPort_free( pBuf );
+  }
+}
+
+// MT_ZDO_CB_STATS, its SRSP left in linkLast
+static void stats( uint8_t clear )
+{
+  uint8_t cmd[MT_RPC_FRAME_HDR_SZ + 1] = { 1, 0x25, MT_ZDO_CB_STATS, 0 };
+
+  cmd[MT_RPC_FRAME_HDR_SZ] = clear;
+  MT_ZdoCbStats( cmd );
+  linkDrain( LINK_Q_MAX );
+
+  ZTEST_CHECK( linkLast[MT_RPC_POS_CMD1] == MT_ZDO_CB_STATS );
+  ZTEST_CHECK( linkLast[MT_RPC_POS_LEN] == 6 );
+}
+
+// A leave of the batch, its address in nwkAddr and extAddr
+static void leaveRec( zdoLeaveRec_t *pRec, uint16_t nwkAddr, uint8_t reason )
+{
+  memset( pRec, 0, sizeof( zdoLeaveRec_t ) );
+  pRec->nwkAddr = nwkAddr;
+  memset( pRec->extAddr, (uint8_t)nwkAddr, Z_EXTADDR_LEN );
+  pRec->reason = reason;
+  pRec->rejoin = (reason == ZDO_LEAVE_REASON_IND);
+}
+
+// Next message on the link, its data field
+static uint8_t *linkNext( uint8_t cmd1 )
+{
+  ZTEST_CHECK( linkCnt > 0 );
+  linkDrain( 1 );
+  ZTEST_CHECK( linkLast[MT_RPC_POS_CMD1] == cmd1 );
+
+  return ( linkLast + MT_RPC_FRAME_HDR_SZ );
+}
+
+static uint32_t rngState;
+
+static uint16_t rng( void )
+{
+  rngState = rngState * 1103515245 + 12345;
+  return ( (uint16_t)(rngState >> 16) );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+
+// The indication comes out as the legacy builder wrote it, in a ring
+// buffer taken back once the link sent it
+static void testInPlace( void )
+{
+  uint8_t legacy[MT_RPC_FRAME_HDR_SZ + MT_RPC_DATA_MAX];
+  uint16_t x;
+
+  reset();
+
+  legacyAnnce( 0x1234, 0xABCD );
+  linkDrain( 1 );
+  memcpy( legacy, linkLast, sizeof( legacy ) );
+
+  heapAllocs = 0;
+  for ( x = 0; x < 10; x++ )
+  {
+    annce( 0x1234, 0xABCD );
+    linkDrain( 1 );
+    ZTEST_CHECK( memcmp( linkLast, legacy, MT_RPC_FRAME_HDR_SZ + MT_ZDO_END_DEVICE_ANNCE_IND_LEN ) == 0 );
+  }
+
+  // One ring buffer for all of them, kept after the link released it
+  ZTEST_CHECK( heapAllocs == 1 );
+  ZTEST_CHECK( heapLive == 1 );
+  ZTEST_CHECK( mtZdoCbRing[0] != NULL );
+  ZTEST_CHECK( mtZdoCbRing[1] == NULL );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 0 );
+
+  // Variable length, same bytes as before
+  legacySrcRtg( 0x0042, 5 );
+  linkDrain( 1 );
+  memcpy( legacy, linkLast, sizeof( legacy ) );
+  srcRtg( 0x0042, 5 );
+  linkDrain( 1 );
+  ZTEST_CHECK( linkLast[MT_RPC_POS_LEN] == 2 + 1 + (5 * 2) );
+  ZTEST_CHECK( memcmp( linkLast, legacy, MT_RPC_FRAME_HDR_SZ + linkLast[MT_RPC_POS_LEN] ) == 0 );
+}
+
+// A busy ring gives the indication a buffer of its own, freed once sent
+static void testRingBusy( void )
+{
+  uint8_t x;
+
+  reset();
+
+  for ( x = 0; x < MT_ZDO_CB_RING_SIZE + 2; x++ )
+  {
+    annce( x, x );
+  }
+  ZTEST_CHECK( linkCnt == MT_ZDO_CB_RING_SIZE + 2 );
+  ZTEST_CHECK( heapLive == MT_ZDO_CB_RING_SIZE + 2 );
+
+  // In the order they were written
+  for ( x = 0; x < MT_ZDO_CB_RING_SIZE + 2; x++ )
+  {
+    linkDrain( 1 );
+    ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ] == x );
+  }
+  ZTEST_CHECK( heapLive == MT_ZDO_CB_RING_SIZE );
+
+  heapAllocs = 0;
+  for ( x = 0; x < MT_ZDO_CB_RING_SIZE; x++ )
+  {
+    annce( x, x );
+  }
+  ZTEST_CHECK( heapAllocs == 0 );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 0 );
+}
+
+// Indications that do not fit, are not written to length or find no
+// buffer are dropped and counted, the ring buffer taken back
+static void testDropped( void )
+{
+  mtZdoCbWriter_t w;
+  uint8_t x;
+
+  reset();
+
+  ZTEST_CHECK( MT_ZdoCbReserve( &w, MT_ZDO_SRC_RTG_IND, MT_RPC_DATA_MAX + 1 ) == FALSE );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 1 );
+
+  // Written past the reserved length
+  ZTEST_CHECK( MT_ZdoCbReserve( &w, MT_ZDO_SRC_RTG_IND, 3 ) == TRUE );
+  MT_ZdoCbPutUint16( &w, 0x1234 );
+  MT_ZdoCbPutUint16( &w, 0x5678 );
+  ZTEST_CHECK( w.status == ZBufferFull );
+  MT_ZdoCbCommit( &w );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 2 );
+
+  // Short of the reserved length
+  ZTEST_CHECK( MT_ZdoCbReserve( &w, MT_ZDO_SRC_RTG_IND, 3 ) == TRUE );
+  MT_ZdoCbPutUint16( &w, 0x1234 );
+  MT_ZdoCbCommit( &w );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 3 );
+  ZTEST_CHECK( linkCnt == 0 );
+
+  // Ring buffer back with the ring only
+  ZTEST_CHECK( heapLive == 1 );
+  ZTEST_CHECK( (OsalPort_MSG_REF( mtZdoCbRing[0] - MT_RSP_DATA_OFS ) & OsalPort_MSG_REF_CNT_MASK) == 1 );
+
+  // Ring busy and out of heap
+  for ( x = 0; x < MT_ZDO_CB_RING_SIZE; x++ )
+  {
+    annce( x, x );
+  }
+  heapFailIn = 1;
+  annce( 0x0101, 0x0101 );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 4 );
+  ZTEST_CHECK( linkCnt == MT_ZDO_CB_RING_SIZE );
+}
+
+// MT_ZDO_CB_STATS reports the dropped count and the ring
+static void testStats( void )
+{
+  uint8_t x;
+
+  reset();
+
+  stats( FALSE );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ] == ZSuccess );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 1] == 0 );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 3] == MT_ZDO_CB_RING_SIZE );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 4] == 0 );
+
+  for ( x = 0; x < MT_ZDO_CB_RING_SIZE; x++ )
+  {
+    annce( x, x );
+  }
+  linkDrain( 1 );
+  MT_ZdoCbDropCnt = 0x0102;
+
+  stats( FALSE );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 1] == 0x02 );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 2] == 0x01 );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 4] == MT_ZDO_CB_RING_SIZE );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 5] == MT_ZDO_CB_RING_SIZE - 1 );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 0x0102 );
+
+  stats( TRUE );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 1] == 0x02 );
+  ZTEST_CHECK( linkLast[MT_RPC_FRAME_HDR_SZ + 5] == 0 );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 0 );
+}
+
+/*********************************************************************
+ * SIMULATION
+ */
+
+// Heap allocations and heap held for a replay of announces and source
+// routes while the link sends 0 to 3 messages between two indications,
+// a backlog building up in bursts
+static void replay( uint8_t ring, uint32_t *pAllocs, uint32_t *pPeak, uint32_t *pHeld )
+{
+  static const uint8_t drains[4] = { 0, 1, 1, 3 };
+  uint16_t x;
+
+  reset();
+  rngState = 107;
+
+  for ( x = 0; x < 20000; x++ )
+  {
+    uint16_t r = rng();
+
+    if ( r & 1 )
+    {
+      if ( ring )
+      {
+        annce( x, x );
+      }
+      else
+      {
+        legacyAnnce( x, x );
+      }
+    }
+    else
+    {
+      if ( ring )
+      {
+        srcRtg( x, (r >> 1) % 6 );
+      }
+      else
+      {
+        legacySrcRtg( x, (r >> 1) % 6 );
+      }
+    }
+    linkDrain( drains[(r >> 4) & 3] );
+  }
+  linkDrain( LINK_Q_MAX );
+
+  *pAllocs = heapAllocs;
+  *pPeak = heapPeak;
+  *pHeld = heapBytes;
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 0 );
+}
+
+static void testHeapChurn( void )
+{
+  uint32_t ringAllocs, ringPeak, ringHeld;
+  uint32_t oldAllocs, oldPeak, oldHeld;
+  uint32_t oldBytes;
+
+  replay( FALSE, &oldAllocs, &oldPeak, &oldHeld );
+  oldBytes = linkBytes;
+  replay( TRUE, &ringAllocs, &ringPeak, &ringHeld );
+
+  printf( "zdo indications: %u allocs, peak %u, held %u bytes (temp buffer %u allocs, peak %u, held %u)\n",
+          (unsigned)ringAllocs, (unsigned)ringPeak, (unsigned)ringHeld,
+          (unsigned)oldAllocs, (unsigned)oldPeak, (unsigned)oldHeld );
+
+  // Same bytes on the wire
+  ZTEST_CHECK( linkBytes == oldBytes );
+  ZTEST_CHECK( oldAllocs == 2 * 20000 );
+  ZTEST_CHECK( ringAllocs * 4 < oldAllocs );
+  ZTEST_CHECK( oldHeld == 0 );
+
+  // The ring's heap held for good, about 1 KB at the default size
+  ZTEST_CHECK( ringHeld == MT_ZDO_CB_RING_SIZE
+                          * (sizeof( OsalPort_MsgHdr ) + MT_RSP_DATA_OFS + MT_RPC_DATA_MAX + 1) );
+  ZTEST_CHECK( ringHeld < 1200 );
+
+  reset();
+}
+
+// Aged out children only ever go in MT_ZDO_LEAVE_BATCH_IND, the NLME
+// leave indications one by one in per device mode
+static void testLeaveBatch( void )
+{
+  zdoLeaveRec_t recs[64];
+  zdoLeaveBatch_t batch;
+  uint8_t perInd = (MT_RPC_DATA_MAX - 1) / (6 + Z_EXTADDR_LEN);
+  uint8_t *pData;
+  uint8_t x;
+
+  reset();
+
+  leaveRec( &recs[0], 0x1111, ZDO_LEAVE_REASON_IND );
+  leaveRec( &recs[1], 0x2222, ZDO_LEAVE_REASON_CNF );
+  leaveRec( &recs[2], 0x3333, ZDO_LEAVE_REASON_AGED );
+  leaveRec( &recs[3], 0x4444, ZDO_LEAVE_REASON_AGED );
+  batch.count = 4;
+  batch.pRecs = recs;
+
+  MT_ZdoLeaveIndMode = MT_ZDO_LEAVE_IND_PER_DEVICE;
+  (void)MT_ZdoLeaveBatchInd( &batch );
+  ZTEST_CHECK( linkCnt == 2 );
+
+  pData = linkNext( MT_ZDO_LEAVE_IND );
+  ZTEST_CHECK( BUILD_UINT16( pData[0], pData[1] ) == 0x1111 );
+  ZTEST_CHECK( pData[2 + Z_EXTADDR_LEN + 2] == TRUE );
+
+  pData = linkNext( MT_ZDO_LEAVE_BATCH_IND );
+  ZTEST_CHECK( linkLast[MT_RPC_POS_LEN] == 1 + (2 * (6 + Z_EXTADDR_LEN)) );
+  ZTEST_CHECK( pData[0] == 2 );
+  ZTEST_CHECK( BUILD_UINT16( pData[1], pData[2] ) == 0x3333 );
+  ZTEST_CHECK( pData[3] == 0x33 );
+  ZTEST_CHECK( pData[3 + Z_EXTADDR_LEN] == ZDO_LEAVE_REASON_AGED );
+  ZTEST_CHECK( BUILD_UINT16( pData[15], pData[16] ) == 0x4444 );
+
+  // Coalesced, the whole batch
+  MT_ZdoLeaveIndMode = MT_ZDO_LEAVE_IND_COALESCED;
+  (void)MT_ZdoLeaveBatchInd( &batch );
+  ZTEST_CHECK( linkCnt == 1 );
+  pData = linkNext( MT_ZDO_LEAVE_BATCH_IND );
+  ZTEST_CHECK( pData[0] == 4 );
+  ZTEST_CHECK( BUILD_UINT16( pData[1 + (1 * (6 + Z_EXTADDR_LEN))],
+                             pData[2 + (1 * (6 + Z_EXTADDR_LEN))] ) == 0x2222 );
+
+  // A storm of aged children between two leaves, split over as few
+  // indications as fit
+  for ( x = 0; x < 64; x++ )
+  {
+    leaveRec( &recs[x], 0x0100 + x,
+              ((x == 0) || (x == 40)) ? ZDO_LEAVE_REASON_IND : ZDO_LEAVE_REASON_AGED );
+  }
+  batch.count = 64;
+
+  MT_ZdoLeaveIndMode = MT_ZDO_LEAVE_IND_PER_DEVICE;
+  (void)MT_ZdoLeaveBatchInd( &batch );
+  ZTEST_CHECK( linkCnt == 2 + ((62 + perInd - 1) / perInd) );
+
+  pData = linkNext( MT_ZDO_LEAVE_IND );
+  ZTEST_CHECK( BUILD_UINT16( pData[0], pData[1] ) == 0x0100 );
+  pData = linkNext( MT_ZDO_LEAVE_IND );
+  ZTEST_CHECK( BUILD_UINT16( pData[0], pData[1] ) == 0x0100 + 40 );
+
+  x = 1;
+  while ( linkCnt > 0 )
+  {
+    uint8_t cnt;
+    uint8_t i;
+
+    pData = linkNext( MT_ZDO_LEAVE_BATCH_IND );
+    cnt = pData[0];
+    ZTEST_CHECK( (cnt == perInd) || (linkCnt == 0) );
+
+    for ( i = 0; i < cnt; i++, x++ )
+    {
+      if ( x == 40 )
+      {
+        x++;
+      }
+      ZTEST_CHECK( BUILD_UINT16( pData[1 + (i * (6 + Z_EXTADDR_LEN))],
+                                 pData[2 + (i * (6 + Z_EXTADDR_LEN))] ) == 0x0100 + x );
+    }
+  }
+  ZTEST_CHECK( x == 64 );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 0 );
+
+  reset();
+}
+
+/*********************************************************************
+ * LEAVE STORMS
+ */
+#define STORM_ADDR      0x0100
+#define STORM_DEVS      256
+
+typedef struct
+{
+  const char *name;
+  uint16_t leaves;
+  uint8_t aged;           // Of 16 leaves, the children aged out
+  uint16_t gap;           // Most ms between two leaves
+  uint8_t ffd;            // NV saved on the timer, else at once
+} leaveStorm_t;
+
+typedef struct
+{
+  uint32_t nvRequests;
+  uint32_t nvWrites;
+  uint32_t cleanups;
+  uint32_t bytes;
+  uint32_t msgs;
+  uint32_t leaves;        // Leaves the host was told of
+  uint32_t held;          // Longest ms a leave was held from the host
+} stormCnt_t;
+
+static stormCnt_t stormCnt;
+static uint32_t leaveAt[STORM_DEVS];
+
+static void devExt( uint8_t *extAddr, uint16_t nwkAddr )
+{
+  memset( extAddr, 0xA5, Z_EXTADDR_LEN );
+  extAddr[0] = LO_UINT16( nwkAddr );
+  extAddr[1] = HI_UINT16( nwkAddr );
+}
+
+static void stormHeld( uint16_t nwkAddr )
+{
+  uint32_t held;
+
+  ZTEST_CHECK( (uint16_t)(nwkAddr - STORM_ADDR) < STORM_DEVS );
+  held = simClock - leaveAt[(uint16_t)(nwkAddr - STORM_ADDR)];
+
+  stormCnt.leaves++;
+  if ( held > stormCnt.held )
+  {
+    stormCnt.held = held;
+  }
+}
+
+// Send the link, the leaves it tells the host of counted
+static void stormDrain( void )
+{
+  while ( linkCnt > 0 )
+  {
+    uint8_t *pData = linkLast + MT_RPC_FRAME_HDR_SZ;
+    uint32_t bytes = linkBytes;
+    uint8_t x;
+
+    linkDrain( 1 );
+    stormCnt.bytes += linkBytes - bytes;
+    stormCnt.msgs++;
+
+    if ( linkLast[MT_RPC_POS_CMD1] == MT_ZDO_LEAVE_IND )
+    {
+      stormHeld( BUILD_UINT16( pData[0], pData[1] ) );
+    }
+    else if ( linkLast[MT_RPC_POS_CMD1] == MT_ZDO_LEAVE_BATCH_IND )
+    {
+      for ( x = 0; x < pData[0]; x++ )
+      {
+        stormHeld( BUILD_UINT16( pData[1 + (x * (6 + Z_EXTADDR_LEN))],
+                                 pData[2 + (x * (6 + Z_EXTADDR_LEN))] ) );
+      }
+    }
+  }
+}
+
+// The ZDApp task up to the time given: its events, then its timers as
+// they come due, the link sent after each
+static void simRun( uint32_t until )
+{
+  uint8_t idx;
+
+  for ( ;; )
+  {
+    if ( zdAppEvents & ZDO_LEAVE_BATCH_EVT )
+    {
+      ZDApp_ProcessLeaveBatch();
+    }
+    if ( zdAppEvents & ZDO_NWK_UPDATE_NV )
+    {
+      nvWrites++;
+    }
+    zdAppEvents = 0;
+    stormDrain();
+
+    idx = (timerOn[0] && (!timerOn[1] || (timerDue[0] <= timerDue[1]))) ? 0 : 1;
+    if ( !timerOn[idx] || (timerDue[idx] > until) )
+    {
+      break;
+    }
+
+    simClock = timerDue[idx];
+    timerOn[idx] = FALSE;
+    zdAppEvents |= (idx == 0) ? ZDO_LEAVE_BATCH_EVT : ZDO_NWK_UPDATE_NV;
+  }
+
+  if ( until > simClock )
+  {
+    simClock = until;
+  }
+}
+
+// ZDApp with MT ZDO registered as MT_ZdoInit() does
+static void leaveReset( uint8_t indMode, uint8_t ffd )
+{
+  reset();
+
+  memset( zdoCBFunc, 0, sizeof( zdoCBFunc ) );
+  (void)ZDO_RegisterForZdoCB( ZDO_LEAVE_IND_CBID, &MT_ZdoLeaveInd );
+  (void)ZDO_RegisterForZdoCB( ZDO_LEAVE_BATCH_IND_CBID, &MT_ZdoLeaveBatchInd );
+  MT_ZdoLeaveIndMode = indMode;
+  _NIB.CapabilityFlags = ffd ? CAPINFO_DEVICETYPE_FFD : 0;
+
+  ZDApp_LeaveBatchCnt = 0;
+  simClock = 0;
+  zdAppEvents = 0;
+  timerOn[0] = FALSE;
+  timerOn[1] = FALSE;
+  leaveCleanups = 0;
+  nvRequests = 0;
+  nvWrites = 0;
+  leaveResets = 0;
+  memset( &stormCnt, 0, sizeof( stormCnt ) );
+}
+
+// An NLME leave indication of another device, through ZDO_LeaveInd()
+// or as it was handled before the batch: its NV update asked and the
+// host told for each leave
+static void leaveInd( uint16_t nwkAddr, uint8_t legacy )
+{
+  NLME_LeaveInd_t ind;
+
+  ind.srcAddr = nwkAddr;
+  devExt( ind.extAddr, nwkAddr );
+  ind.request = FALSE;
+  ind.removeChildren = FALSE;
+  ind.rejoin = TRUE;
+  leaveAt[(uint16_t)(nwkAddr - STORM_ADDR)] = simClock;
+
+  if ( legacy )
+  {
+    ZDApp_LeaveUpdate( ind.srcAddr, ind.extAddr, ind.removeChildren, ind.rejoin );
+    if ( zdoCBFunc[ZDO_LEAVE_IND_CBID] != NULL )
+    {
+      (void)zdoCBFunc[ZDO_LEAVE_IND_CBID]( &ind );
+    }
+  }
+  else
+  {
+    ZDO_LeaveInd( &ind );
+  }
+}
+
+// A child the NWK layer aged out, before the batch only its NV update
+// was asked for
+static void childAged( uint16_t nwkAddr, uint8_t legacy )
+{
+  uint8_t extAddr[Z_EXTADDR_LEN];
+
+  devExt( extAddr, nwkAddr );
+  leaveAt[(uint16_t)(nwkAddr - STORM_ADDR)] = simClock;
+
+  if ( legacy )
+  {
+    ZDApp_NwkWriteNVRequest();
+  }
+  else
+  {
+    ZDApp_ChildAgedCB( nwkAddr, extAddr );
+  }
+}
+
+// The leaves of a storm a random 0 to gap ms apart, the same ones each
+// run, until the NV update and the last batch went out
+static void stormRun( const leaveStorm_t *pStorm, uint8_t legacy, uint8_t indMode, uint16_t *pAged )
+{
+  uint16_t x;
+
+  leaveReset( indMode, pStorm->ffd );
+  rngState = 120;
+  *pAged = 0;
+
+  for ( x = 0; x < pStorm->leaves; x++ )
+  {
+    uint16_t r = rng();
+
+    simRun( simClock + (r % (pStorm->gap + 1)) );
+    if ( ((r >> 8) & 15) < pStorm->aged )
+    {
+      childAged( STORM_ADDR + x, legacy );
+      (*pAged)++;
+    }
+    else
+    {
+      leaveInd( STORM_ADDR + x, legacy );
+    }
+    simRun( simClock );
+  }
+  simRun( simClock + ZDAPP_LEAVE_BATCH_DELAY + ZDAPP_UPDATE_NWK_NV_TIME );
+
+  ZTEST_CHECK( ZDApp_LeaveBatchCnt == 0 );
+  ZTEST_CHECK( !timerOn[0] && !timerOn[1] );
+  ZTEST_CHECK( MT_ZdoCbDropCnt == 0 );
+  ZTEST_CHECK( leaveResets == 0 );
+
+  stormCnt.nvRequests = nvRequests;
+  stormCnt.nvWrites = nvWrites;
+  stormCnt.cleanups = leaveCleanups;
+}
+
+// Leaves come out of the tables at once and go to the host together,
+// early when the batch is full or a held device comes back
+static void testLeaveHeld( void )
+{
+  NLME_LeaveInd_t ind;
+  uint8_t extAddr[Z_EXTADDR_LEN];
+  uint8_t x;
+
+  leaveReset( MT_ZDO_LEAVE_IND_COALESCED, TRUE );
+
+  leaveInd( STORM_ADDR, FALSE );
+  leaveInd( STORM_ADDR + 1, FALSE );
+  leaveInd( STORM_ADDR, FALSE );
+  ZTEST_CHECK( leaveCleanups == 3 );
+  ZTEST_CHECK( ZDApp_LeaveBatchCnt == 2 );
+  ZTEST_CHECK( nvRequests == 0 );
+
+  simRun( ZDAPP_LEAVE_BATCH_DELAY - 1 );
+  ZTEST_CHECK( stormCnt.leaves == 0 );
+  simRun( ZDAPP_LEAVE_BATCH_DELAY );
+  ZTEST_CHECK( stormCnt.msgs == 1 );
+  ZTEST_CHECK( stormCnt.leaves == 2 );
+  ZTEST_CHECK( stormCnt.held == ZDAPP_LEAVE_BATCH_DELAY );
+  ZTEST_CHECK( nvRequests == 1 );
+  ZTEST_CHECK( timerOn[1] && (timerDue[1] == ZDAPP_LEAVE_BATCH_DELAY + ZDAPP_UPDATE_NWK_NV_TIME) );
+
+  // Back before the batch ran: its leave goes out first
+  leaveInd( STORM_ADDR + 2, FALSE );
+  devExt( extAddr, STORM_ADDR + 3 );
+  ZDApp_LeaveBatchFlush( extAddr );
+  ZTEST_CHECK( ZDApp_LeaveBatchCnt == 1 );
+  devExt( extAddr, STORM_ADDR + 2 );
+  ZDApp_LeaveBatchFlush( extAddr );
+  ZTEST_CHECK( ZDApp_LeaveBatchCnt == 0 );
+  ZTEST_CHECK( !timerOn[0] );
+  simRun( simClock );
+  ZTEST_CHECK( stormCnt.leaves == 3 );
+
+  // A full batch goes at once, the next leave starts another
+  for ( x = 0; x <= ZDAPP_LEAVE_BATCH_MAX; x++ )
+  {
+    leaveInd( STORM_ADDR + 16 + x, FALSE );
+  }
+  ZTEST_CHECK( ZDApp_LeaveBatchCnt == 1 );
+  ZTEST_CHECK( timerOn[0] && (timerDue[0] == simClock + ZDAPP_LEAVE_BATCH_DELAY) );
+  simRun( simClock );
+  ZTEST_CHECK( stormCnt.leaves == 3 + ZDAPP_LEAVE_BATCH_MAX );
+  simRun( simClock + ZDAPP_LEAVE_BATCH_DELAY );
+  ZTEST_CHECK( stormCnt.leaves == 4 + ZDAPP_LEAVE_BATCH_MAX );
+
+  // A child aged out of unknown address is only saved
+  x = ZDApp_LeaveBatchCnt;
+  ZDApp_ChildAgedCB( STORM_ADDR + 40, NULL );
+  ZTEST_CHECK( ZDApp_LeaveBatchCnt == x );
+
+  // This device told to leave resets, nothing held
+  ind.srcAddr = STORM_ADDR + 41;
+  memcpy( ind.extAddr, myExtAddr, Z_EXTADDR_LEN );
+  ind.request = TRUE;
+  ind.removeChildren = FALSE;
+  ind.rejoin = TRUE;
+  leaveAt[41] = simClock;
+  ZDO_LeaveInd( &ind );
+  ZTEST_CHECK( leaveResets == 1 );
+  ZTEST_CHECK( ZDApp_LeaveBatchCnt == 0 );
+  ZTEST_CHECK( linkCnt == 1 );
+
+  reset();
+}
+
+// NV updates and serial bytes of the leave storms, handled alone as
+// before, batched and sent per device and batched and coalesced
+static void testLeaveStorms( void )
+{
+  static const leaveStorm_t storms[] =
+  {
+    // A router's children leaving as it powers down the network
+    { "burst",  200, 0,  4,   TRUE  },
+    // Children aging out after a power cut, some leaving
+    { "aged",   120, 14, 2,   TRUE  },
+    // Leaves seconds apart, nothing to batch
+    { "spread", 40,  0,  600, TRUE  },
+    // Neighbors leaving a device saving its NV at once
+    { "rfd",    40,  0,  20,  FALSE },
+  };
+  stormCnt_t old, dev, co;
+  uint16_t aged;
+  uint8_t s;
+
+  for ( s = 0; s < sizeof( storms ) / sizeof( storms[0] ); s++ )
+  {
+    const leaveStorm_t *pStorm = &storms[s];
+    uint16_t inds;
+
+    stormRun( pStorm, TRUE, MT_ZDO_LEAVE_IND_PER_DEVICE, &aged );
+    old = stormCnt;
+    stormRun( pStorm, FALSE, MT_ZDO_LEAVE_IND_PER_DEVICE, &aged );
+    dev = stormCnt;
+    stormRun( pStorm, FALSE, MT_ZDO_LEAVE_IND_COALESCED, &aged );
+    co = stormCnt;
+    inds = pStorm->leaves - aged;
+
+    printf( "leave storm %-6s: %u NV requests, %u NV writes, %u bytes in %u msgs, held %u ms "
+            "(per device %u bytes in %u msgs, alone %u NV requests, %u NV writes, %u bytes in %u msgs)\n",
+            pStorm->name, (unsigned)co.nvRequests, (unsigned)co.nvWrites,
+            (unsigned)co.bytes, (unsigned)co.msgs, (unsigned)co.held,
+            (unsigned)dev.bytes, (unsigned)dev.msgs,
+            (unsigned)old.nvRequests, (unsigned)old.nvWrites, (unsigned)old.bytes, (unsigned)old.msgs );
+
+    // Every leave cleaned up at once and told, aged out children
+    // only ever in the batch
+    ZTEST_CHECK( (old.cleanups == inds) && (dev.cleanups == inds) && (co.cleanups == inds) );
+    ZTEST_CHECK( old.leaves == inds );
+    ZTEST_CHECK( (dev.leaves == pStorm->leaves) && (co.leaves == pStorm->leaves) );
+    ZTEST_CHECK( old.held == 0 );
+    ZTEST_CHECK( (dev.held <= ZDAPP_LEAVE_BATCH_DELAY) && (co.held <= ZDAPP_LEAVE_BATCH_DELAY) );
+    ZTEST_CHECK( (dev.nvRequests == co.nvRequests) && (dev.nvWrites == co.nvWrites) );
+    ZTEST_CHECK( co.nvRequests <= old.nvRequests );
+    ZTEST_CHECK( co.nvWrites <= old.nvWrites );
+    if ( aged == 0 )
+    {
+      // Per device the host sees the same bytes, later
+      ZTEST_CHECK( (dev.bytes == old.bytes) && (dev.msgs == old.msgs) );
+    }
+
+    switch ( s )
+    {
+      case 0:
+        // The NV timer already saved once, the batch asks less often
+        // and sends a tenth of the messages
+        ZTEST_CHECK( co.nvWrites == old.nvWrites );
+        ZTEST_CHECK( co.nvRequests * 10 < old.nvRequests );
+        ZTEST_CHECK( (co.msgs * 10 < old.msgs) && (co.bytes < old.bytes) );
+        break;
+
+      case 2:
+        // Batches of one, two bytes longer each than MT_ZDO_LEAVE_IND
+        ZTEST_CHECK( co.nvWrites == old.nvWrites );
+        ZTEST_CHECK( co.bytes <= old.bytes + (2 * co.msgs) );
+        break;
+
+      case 3:
+        // Saved at once, each batch saves once instead of each leave
+        ZTEST_CHECK( old.nvWrites == pStorm->leaves );
+        ZTEST_CHECK( co.nvWrites * 8 < old.nvWrites );
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  reset();
+}
+
+int main( void )
+{
+  ZTEST_RUN( testInPlace );
+  ZTEST_RUN( testRingBusy );
+  ZTEST_RUN( testDropped );
+  ZTEST_RUN( testStats );
+  ZTEST_RUN( testHeapChurn );
+  ZTEST_RUN( testLeaveBatch );
+  ZTEST_RUN( testLeaveHeld );
+  ZTEST_RUN( testLeaveStorms );
+
+  reset();
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,490 @@
+/**************************************************************************************************
+  Filename:       test_npi_frame.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the MT responses the NPI task frames in
+                  the buffer they were built in: what the TX callbacks
+                  are given, the framed bytes that reach the host, the
+                  buffers left after each path and the bytes copied on
+                  the way, against messages sent unframed as before.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "comdef.h"
+#include "osal_port.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define HEAP_BLOCKS     64
+#define NPI_TASK_ID     3
+#define NPI_Q_MAX       16
+
+// Live heap blocks, a freed block is filled so stale reads show
+static void *heapBlocks[HEAP_BLOCKS];
+static uint16_t heapLive;
+static uint16_t heapFailIn;     // Fail the n-th allocation from now, 0 never
+static uint32_t heapAllocs;
+
+void* OsalPort_malloc( uint32_t size )
+{
+  uint16_t x;
+  void *pBuf;
+
+  if ( heapFailIn && (--heapFailIn == 0) )
+  {
+    return ( NULL );
+  }
+
+  pBuf = malloc( size + sizeof( uint32_t ) );
+  if ( pBuf == NULL )
+  {
+    return ( NULL );
+  }
+  memcpy( pBuf, &size, sizeof( uint32_t ) );
+
+  for ( x = 0; x < HEAP_BLOCKS; x++ )
+  {
+    if ( heapBlocks[x] == NULL )
+    {
+      heapBlocks[x] = pBuf;
+      heapLive++;
+      heapAllocs++;
+      break;
+    }
+  }
+
+  return ( (uint8_t *)pBuf + sizeof( uint32_t ) );
+}
+
+void OsalPort_free( void* buf )
+{
+  uint8_t *pBuf = (uint8_t *)buf - sizeof( uint32_t );
+  uint32_t size;
+  uint16_t x;
+
+  for ( x = 0; x < HEAP_BLOCKS; x++ )
+  {
+    if ( heapBlocks[x] == pBuf )
+    {
+      heapBlocks[x] = NULL;
+      heapLive--;
+      memcpy( &size, pBuf, sizeof( uint32_t ) );
+      memset( buf, 0xDD, size );
+      free( pBuf );
+      return;
+    }
+  }
+
+  // Freed twice or never allocated
+  ZTEST_CHECK( x < HEAP_BLOCKS );
+}
+
+uint32_t OsalPort_enterCS( void )
+{
+  return ( 0 );
+}
+
+void OsalPort_leaveCS( uint32_t key )
+{
+  (void)key;
+}
+
+// The NPI task's OSAL queue, run by npiTaskRun()
+static uint8_t *npiQ[NPI_Q_MAX];
+static uint8_t npiQCnt;
+
+uint8_t OsalPort_msgSend( uint8_t destinationTask, uint8_t *pMsg )
+{
+  ZTEST_CHECK( destinationTask == NPI_TASK_ID );
+  ZTEST_CHECK( npiQCnt < NPI_Q_MAX );
+  npiQ[npiQCnt++] = pMsg;
+  return ( OsalPort_SUCCESS );
+}
+
+// TI-RTOS queue and semaphore of the NPI task
+typedef struct Queue_Elem
+{
+  struct Queue_Elem *next;
+} Queue_Elem;
+
+typedef struct
+{
+  Queue_Elem *head;
+  Queue_Elem *tail;
+} Queue_Struct;
+
+typedef Queue_Struct *Queue_Handle;
+typedef void *Semaphore_Handle;
+
+static void Queue_enqueue( Queue_Handle pQ, Queue_Elem *pElem )
+{
+  pElem->next = NULL;
+  if ( pQ->tail != NULL )
+  {
+    pQ->tail->next = pElem;
+  }
+  else
+  {
+    pQ->head = pElem;
+  }
+  pQ->tail = pElem;
+}
+
+static void Semaphore_post( Semaphore_Handle handle )
+{
+  (void)handle;
+}
+
+// Bytes the framing path copies, the message built in place not counted
+static uint32_t bytesCopied;
+
+#define memcpy( d, s, n )   ( bytesCopied += (n), memcpy( (d), (s), (n) ) )
+#define memmove( d, s, n )  ( bytesCopied += (n), memmove( (d), (s), (n) ) )
+
+#include "test_npi_frame_items.c"
+
+#undef memcpy
+#undef memmove
+
+/*********************************************************************
+ * HELPERS
+ */
+#define CMD0      0x65
+#define CMD1      0x80
+
+static Queue_Struct txQ;
+static uint8_t txFrame[NPIFRAME_HDR_SZ + MTRPC_FRAME_HDR_SZ + MT_RPC_DATA_MAX + NPIFRAME_TRAILER_SZ];
+static uint16_t txFrameLen;
+static uint16_t txFrames;
+
+static uint8_t cbMsg[MTRPC_FRAME_HDR_SZ + MT_RPC_DATA_MAX];
+static uint16_t cbCnt;
+
+static void reset( void )
+{
+  ZTEST_CHECK( heapLive == 0 );
+  heapFailIn = 0;
+  heapAllocs = 0;
+  bytesCopied = 0;
+  npiQCnt = 0;
+  memset( &txQ, 0, sizeof( txQ ) );
+  npiTxQueue = &txQ;
+  npiTxQueueDepth = 0;
+  txFrameLen = 0;
+  txFrames = 0;
+  cbCnt = 0;
+  npiTaskID = NPI_TASK_ID;
+  NPITask_registerIncomingTXEventAppCB( NULL, NONE );
+}
+
+// The TX callbacks copy the message, as npiIncomingEventCBack_t asks
+static void txEcho( uint8_t *pMsg )
+{
+  memcpy( cbMsg, pMsg, pMsg[MTRPC_POS_LEN] + MTRPC_FRAME_HDR_SZ );
+  cbCnt++;
+}
+
+static void txIntercept( uint8_t *pMsg )
+{
+  txEcho( pMsg );
+  ZTEST_CHECK( OsalPort_msgDeallocate( pMsg ) == OsalPort_SUCCESS );
+}
+
+// The NPI task taking its OSAL messages
+static void npiTaskRun( void )
+{
+  uint8_t x;
+
+  for ( x = 0; x < npiQCnt; x++ )
+  {
+    NPITask_processStackMsg( npiQ[x] );
+  }
+  npiQCnt = 0;
+}
+
+// The transport sending the TX queue, as NPITask_ProcessTXQ() does
+static void txDrain( void )
+{
+  NPI_QueueRec *recPtr;
+
+  while ( (recPtr = (NPI_QueueRec *)txQ.head) != NULL )
+  {
+    txQ.head = recPtr->_elem.next;
+    if ( txQ.head == NULL )
+    {
+      txQ.tail = NULL;
+    }
+    npiTxQueueDepth--;
+
+    txFrameLen = recPtr->npiMsg->pBufSize;
+    memcpy( txFrame, recPtr->npiMsg->pBuf, txFrameLen );
+    txFrames++;
+
+    OsalPort_msgDeallocate( recPtr->npiMsg->pBuf );
+    OsalPort_free( recPtr->npiMsg );
+    OsalPort_free( recPtr );
+  }
+}
+
+static void fill( uint8_t *pData, uint8_t len, uint8_t seed )
+{
+  uint8_t x;
+
+  for ( x = 0; x < len; x++ )
+  {
+    pData[x] = (uint8_t)(seed + x);
+  }
+}
+
+// A response sent as an unframed OSAL message, as MT did before
+static void sendUnframed( uint8_t len, uint8_t *pData )
+{
+  uint8_t *pMsg = OsalPort_msgAllocate( MTRPC_FRAME_HDR_SZ + len );
+
+  if ( pMsg != NULL )
+  {
+    pMsg[MTRPC_POS_LEN] = len;
+    pMsg[MTRPC_POS_CMD0] = CMD0;
+    pMsg[MTRPC_POS_CMD1] = CMD1;
+    memcpy( pMsg + MTRPC_FRAME_HDR_SZ, pData, len );
+    bytesCopied += len;
+    OsalPort_msgSend( NPI_TASK_ID, pMsg );
+  }
+}
+
+// The message the callback was given
+static uint8_t cbIs( uint8_t len, uint8_t *pData )
+{
+  return ( (cbMsg[MTRPC_POS_LEN] == len) && (cbMsg[MTRPC_POS_CMD0] == CMD0) &&
+           (cbMsg[MTRPC_POS_CMD1] == CMD1) &&
+           (memcmp( cbMsg + MTRPC_FRAME_HDR_SZ, pData, len ) == 0) );
+}
+
+// The last frame sent to the host
+static uint8_t txIs( uint8_t len, uint8_t *pData )
+{
+  uint8_t *pMsg = txFrame + NPIFRAME_HDR_SZ;
+
+  return ( (txFrameLen == NPIFRAME_HDR_SZ + MTRPC_FRAME_HDR_SZ + len + NPIFRAME_TRAILER_SZ) &&
+           (txFrame[0] == MT_SOF) && (pMsg[MTRPC_POS_LEN] == len) &&
+           (pMsg[MTRPC_POS_CMD0] == CMD0) && (pMsg[MTRPC_POS_CMD1] == CMD1) &&
+           (memcmp( pMsg + MTRPC_FRAME_HDR_SZ, pData, len ) == 0) &&
+           (txFrame[txFrameLen - 1] == npiframe_calcMTFCS( pMsg, MTRPC_FRAME_HDR_SZ + len )) );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testFramed( void )
+{
+  uint8_t data[MT_RPC_DATA_MAX];
+
+  reset();
+  fill( data, sizeof( data ), 0x10 );
+
+  MT_BuildAndSendZToolResponse( CMD0, CMD1, 20, data );
+  ZTEST_CHECK( npiQCnt == 1 );
+  npiTaskRun();
+  txDrain();
+
+  // Framed where it was built, only the data is copied in
+  ZTEST_CHECK( (txFrames == 1) && txIs( 20, data ) );
+  ZTEST_CHECK( bytesCopied == 20 );
+  ZTEST_CHECK( heapLive == 0 );
+
+  // Largest and empty response
+  reset();
+  MT_BuildAndSendZToolResponse( CMD0, CMD1, MT_RPC_DATA_MAX, data );
+  MT_BuildAndSendZToolResponse( CMD0, CMD1, 0, data );
+  npiTaskRun();
+  ZTEST_CHECK( npiTxQueueDepth == 2 );
+  txDrain();
+  ZTEST_CHECK( (txFrames == 2) && txIs( 0, data ) );
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+// Data starting with the SOF value is not taken for a frame
+static void testUnframed( void )
+{
+  uint8_t data[MT_RPC_DATA_MAX];
+  uint8_t *pMsg;
+
+  reset();
+  fill( data, sizeof( data ), MT_SOF );
+
+  sendUnframed( 30, data );
+  npiTaskRun();
+  txDrain();
+  ZTEST_CHECK( (txFrames == 1) && txIs( 30, data ) );
+  ZTEST_CHECK( heapLive == 0 );
+
+  // Nor is a message in a larger buffer, whatever its bytes
+  reset();
+  pMsg = OsalPort_msgAllocate( 64 );
+  pMsg[0] = MT_SOF;
+  pMsg[1] = 30;
+  ZTEST_CHECK( NPIFrame_unframeMsg( pMsg, TRUE ) == pMsg );
+  ZTEST_CHECK( NPIFrame_unframeMsg( pMsg, FALSE ) == pMsg );
+  ZTEST_CHECK( (pMsg[0] == MT_SOF) && (pMsg[1] == 30) );
+  OsalPort_msgDeallocate( pMsg );
+}
+
+static void testEcho( void )
+{
+  uint8_t data[MT_RPC_DATA_MAX];
+
+  reset();
+  fill( data, sizeof( data ), 0x40 );
+  NPITask_registerIncomingTXEventAppCB( txEcho, ECHO );
+
+  // The callback gets the message without the SOF, the host the frame
+  MT_BuildAndSendZToolResponse( CMD0, CMD1, 12, data );
+  npiTaskRun();
+  ZTEST_CHECK( (cbCnt == 1) && cbIs( 12, data ) );
+  txDrain();
+  ZTEST_CHECK( (txFrames == 1) && txIs( 12, data ) );
+  ZTEST_CHECK( heapLive == 0 );
+
+  // Same as an unframed message
+  sendUnframed( 12, data + 1 );
+  npiTaskRun();
+  ZTEST_CHECK( (cbCnt == 2) && cbIs( 12, data + 1 ) );
+  txDrain();
+  ZTEST_CHECK( (txFrames == 2) && txIs( 12, data + 1 ) );
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void testIntercept( void )
+{
+  uint8_t data[MT_RPC_DATA_MAX];
+
+  reset();
+  fill( data, sizeof( data ), 0x80 );
+  NPITask_registerIncomingTXEventAppCB( txIntercept, INTERCEPT );
+
+  // The callback owns an unframed OSAL message and frees it
+  MT_BuildAndSendZToolResponse( CMD0, CMD1, MT_RPC_DATA_MAX, data );
+  npiTaskRun();
+  ZTEST_CHECK( (cbCnt == 1) && cbIs( MT_RPC_DATA_MAX, data ) );
+  ZTEST_CHECK( (txQ.head == NULL) && (npiTxQueueDepth == 0) );
+  ZTEST_CHECK( heapLive == 0 );
+
+  sendUnframed( 0, data );
+  npiTaskRun();
+  ZTEST_CHECK( (cbCnt == 2) && cbIs( 0, data ) );
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+// Every allocation of the path failing in turn leaves no buffer behind
+static void testOutOfMemory( void )
+{
+  uint8_t data[MT_RPC_DATA_MAX];
+  uint8_t fail;
+
+  fill( data, sizeof( data ), 0x22 );
+
+  for ( fail = 1; fail <= 4; fail++ )
+  {
+    reset();
+    heapFailIn = fail;
+    MT_BuildAndSendZToolResponse( CMD0, CMD1, 40, data );
+    npiTaskRun();
+    txDrain();
+    ZTEST_CHECK( txFrames == ((fail > 3) ? 1 : 0) );
+    ZTEST_CHECK( heapLive == 0 );
+
+    reset();
+    heapFailIn = fail;
+    sendUnframed( 40, data );
+    npiTaskRun();
+    txDrain();
+    ZTEST_CHECK( txFrames == ((fail > 4) ? 1 : 0) );
+    ZTEST_CHECK( heapLive == 0 );
+  }
+}
+
+// Responses of random lengths sent unframed and framed where they are
+// built, through each TX reroute
+static void replay( uint8_t framed, NPI_IncomingNPIEventRerouteType reroute,
+                    uint32_t *pCopied, uint32_t *pAllocs )
+{
+  uint8_t data[MT_RPC_DATA_MAX];
+  uint32_t seed = 0x5EED;
+  uint16_t x;
+  uint8_t len;
+
+  reset();
+  fill( data, sizeof( data ), 0 );
+  if ( reroute != NONE )
+  {
+    NPITask_registerIncomingTXEventAppCB( (reroute == ECHO) ? txEcho : txIntercept,
+                                          reroute );
+  }
+
+  for ( x = 0; x < 2000; x++ )
+  {
+    seed = (seed * 1103515245UL) + 12345UL;
+    len = (uint8_t)((seed >> 16) % (MT_RPC_DATA_MAX + 1));
+
+    if ( framed )
+    {
+      MT_BuildAndSendZToolResponse( CMD0, CMD1, len, data );
+    }
+    else
+    {
+      sendUnframed( len, data );
+    }
+    npiTaskRun();
+    txDrain();
+  }
+
+  *pCopied = bytesCopied;
+  *pAllocs = heapAllocs;
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void testReplay( void )
+{
+  static const char *names[] = { "none", "echo", "intercept" };
+  uint32_t copied[2];
+  uint32_t allocs[2];
+  uint8_t reroute;
+
+  for ( reroute = NONE; reroute <= INTERCEPT; reroute++ )
+  {
+    replay( FALSE, (NPI_IncomingNPIEventRerouteType)reroute, &copied[0], &allocs[0] );
+    replay( TRUE, (NPI_IncomingNPIEventRerouteType)reroute, &copied[1], &allocs[1] );
+
+    printf( "%-9s unframed: %lu bytes copied, %lu allocations\n", names[reroute],
+            (unsigned long)copied[0], (unsigned long)allocs[0] );
+    printf( "%-9s framed:   %lu bytes copied, %lu allocations\n", names[reroute],
+            (unsigned long)copied[1], (unsigned long)allocs[1] );
+
+    if ( reroute == INTERCEPT )
+    {
+      // Never framed, the message moves over the SOF once instead: the
+      // copy the unframed path makes to frame it
+      ZTEST_CHECK( copied[1] == (2 * copied[0]) + (2000 * MTRPC_FRAME_HDR_SZ) );
+      ZTEST_CHECK( allocs[1] == allocs[0] );
+    }
+    else
+    {
+      ZTEST_CHECK( copied[1] < copied[0] );
+      ZTEST_CHECK( allocs[1] < allocs[0] );
+    }
+  }
+}
+
+int main( void )
+{
+  ZTEST_RUN( testFramed );
+  ZTEST_RUN( testUnframed );
+  ZTEST_RUN( testEcho );
+  ZTEST_RUN( testIntercept );
+  ZTEST_RUN( testOutOfMemory );
+  ZTEST_RUN( testReplay );
+
+  return ( ZTEST_RESULT );
+}
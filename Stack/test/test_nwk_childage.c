@@ -0,0 +1,399 @@
+/**************************************************************************************************
+  Filename:       test_nwk_childage.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the end device child aging: the deadline
+                  heap against polls, replaced entries and the removal of
+                  aged children, with and without their IEEE address.
+                  Built with a 400 entry association list, every entry a
+                  child in testHeapMany.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "nwk_childage.h"
+#include "nwk_util.h"
+#include "addr_mgr.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+uint32_t ztestClock = 0;
+nwkIB_t _NIB = { 0x1234 };
+
+associated_devices_t AssociatedDevList[NWK_MAX_DEVICES];
+
+const uint32_t timeoutValue[NWK_CHILD_AGE_TIMEOUTS] =
+{
+  10, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384
+};
+
+void (*pAssocChildAging)( void ) = NULL;
+uint8_t (*pAssocChildTableUpdateTimeout)( uint16_t nwkAddr ) = NULL;
+uint8_t (*pNwkNotMyChildListAdd)( uint16_t devAddr, uint32_t timeoutValue ) = NULL;
+
+static uint8_t addrKnown = TRUE;      // AddrMgrExtAddrLookup() result
+static uint8_t assocRemoveOk = TRUE;  // AssocRemove() result
+static uint16_t libRefreshCnt = 0;
+static uint16_t notMyChildCnt = 0;
+static uint16_t nbrRemoved = INVALID_NODE_ADDR;
+
+// Children reported aged, in order
+static uint16_t agedAddr[NWK_MAX_DEVICES];
+static uint8_t agedHadExt[NWK_MAX_DEVICES];
+static uint16_t agedCnt = 0;
+
+static uint8_t extOf( uint16_t shortAddr, uint8_t *extAddr )
+{
+  memset( extAddr, 0, Z_EXTADDR_LEN );
+  extAddr[0] = LO_UINT16( shortAddr );
+  extAddr[1] = HI_UINT16( shortAddr );
+  extAddr[7] = 0xAA;
+  return ( TRUE );
+}
+
+uint8_t AddrMgrExtAddrLookup( uint16_t nwkAddr, uint8_t* extAddr )
+{
+  return ( addrKnown && extOf( nwkAddr, extAddr ) );
+}
+
+associated_devices_t *AssocGetWithShort( uint16_t shortAddr )
+{
+  uint16_t x;
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    if ( AssociatedDevList[x].shortAddr == shortAddr )
+    {
+      return ( &AssociatedDevList[x] );
+    }
+  }
+
+  return ( NULL );
+}
+
+byte AssocRemove( byte *extAddr )
+{
+  associated_devices_t *pDev;
+
+  if ( !assocRemoveOk )
+  {
+    return ( FALSE );
+  }
+
+  pDev = AssocGetWithShort( BUILD_UINT16( extAddr[0], extAddr[1] ) );
+  if ( pDev == NULL )
+  {
+    return ( FALSE );
+  }
+
+  pDev->shortAddr = INVALID_NODE_ADDR;
+  pDev->nodeRelation = NOTUSED;
+  return ( TRUE );
+}
+
+void nwkNeighborRemove( uint16_t NeighborAddress, uint16_t PanId )
+{
+  (void)PanId;
+  nbrRemoved = NeighborAddress;
+}
+
+static void libAging( void )
+{
+}
+
+// The NWK library restarts the timeout counter of a child that polled
+static uint8_t libRefresh( uint16_t nwkAddr )
+{
+  associated_devices_t *pDev = AssocGetWithShort( nwkAddr );
+
+  if ( pDev != NULL )
+  {
+    pDev->timeoutCounter = pDev->endDev.deviceTimeout;
+  }
+  libRefreshCnt++;
+  return ( ZSuccess );
+}
+
+static uint8_t notMyChildAdd( uint16_t devAddr, uint32_t timeout )
+{
+  (void)devAddr;
+  (void)timeout;
+  notMyChildCnt++;
+  return ( ZSuccess );
+}
+
+static void agedCB( uint16_t nwkAddr, uint8_t *extAddr )
+{
+  uint8_t exp[Z_EXTADDR_LEN];
+
+  agedAddr[agedCnt] = nwkAddr;
+  agedHadExt[agedCnt] = ( extAddr != NULL );
+  if ( extAddr != NULL )
+  {
+    (void)extOf( nwkAddr, exp );
+    ZTEST_CHECK( memcmp( extAddr, exp, Z_EXTADDR_LEN ) == 0 );
+  }
+  agedCnt++;
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+static void reset( void )
+{
+  nwkChildAgeStats_t stats;
+  uint16_t x;
+
+  ztestClock = 1000;
+  addrKnown = TRUE;
+  assocRemoveOk = TRUE;
+  libRefreshCnt = 0;
+  notMyChildCnt = 0;
+  nbrRemoved = INVALID_NODE_ADDR;
+  agedCnt = 0;
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    memset( &AssociatedDevList[x], 0, sizeof( associated_devices_t ) );
+    AssociatedDevList[x].shortAddr = INVALID_NODE_ADDR;
+    AssociatedDevList[x].nodeRelation = NOTUSED;
+  }
+
+  pAssocChildAging = libAging;
+  pAssocChildTableUpdateTimeout = libRefresh;
+  pNwkNotMyChildListAdd = notMyChildAdd;
+  pNwkChildAgedCB = agedCB;
+  NwkChildAge_Init();
+  NwkChildAge_GetStats( &stats, TRUE );
+}
+
+// Associate a child and tell the aging about it, as on a join
+static void childAdd( uint16_t x, uint16_t shortAddr, uint32_t timeout )
+{
+  associated_devices_t *pDev = &AssociatedDevList[x];
+
+  pDev->shortAddr = shortAddr;
+  pDev->addrIdx = x;
+  pDev->nodeRelation = CHILD_RFD;
+  pDev->endDev.deviceTimeout = timeout;
+  pDev->timeoutCounter = timeout;
+  NwkChildAge_Sync( shortAddr );
+}
+
+// Run the aging ticks of the next seconds
+static void runSeconds( uint32_t seconds )
+{
+  while ( seconds-- )
+  {
+    ztestClock += 1000;
+    pAssocChildAging();
+  }
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testInit( void )
+{
+  nwkChildAgeStats_t stats;
+
+  reset();
+
+  ZTEST_CHECK( pAssocChildAging != libAging );
+  ZTEST_CHECK( pAssocChildTableUpdateTimeout != libRefresh );
+  NwkChildAge_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.active == TRUE );
+  ZTEST_CHECK( stats.children == 0 );
+  ZTEST_CHECK( stats.nextDue == 0xFFFFFFFF );
+
+  // A device without end device aging keeps the library as it is
+  pAssocChildAging = NULL;
+  pAssocChildTableUpdateTimeout = libRefresh;
+  NwkChildAge_Init();
+  ZTEST_CHECK( pAssocChildTableUpdateTimeout == libRefresh );
+}
+
+static void testAgesInOrder( void )
+{
+  nwkChildAgeStats_t stats;
+
+  reset();
+
+  childAdd( 0, 0x0010, 120 );
+  childAdd( 1, 0x0011, 10 );
+  childAdd( 2, 0x0012, 60 );
+  ZTEST_CHECK( NwkChildAge_Deadline( 1 ) == 10 );
+  ZTEST_CHECK( NwkChildAge_Deadline( 3 ) == 0 );
+
+  NwkChildAge_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.children == 3 );
+  ZTEST_CHECK( stats.nextDue == 10 );
+  ZTEST_CHECK( stats.timeouts[0] == 1 );
+  ZTEST_CHECK( stats.timeouts[1] == 2 );
+
+  runSeconds( 9 );
+  ZTEST_CHECK( agedCnt == 0 );
+  runSeconds( 1 );
+  ZTEST_CHECK( (agedCnt == 1) && (agedAddr[0] == 0x0011) && agedHadExt[0] );
+  ZTEST_CHECK( nbrRemoved == 0x0011 );
+  ZTEST_CHECK( AssociatedDevList[1].shortAddr == INVALID_NODE_ADDR );
+
+  runSeconds( 50 );
+  ZTEST_CHECK( (agedCnt == 2) && (agedAddr[1] == 0x0012) );
+  runSeconds( 60 );
+  ZTEST_CHECK( (agedCnt == 3) && (agedAddr[2] == 0x0010) );
+  ZTEST_CHECK( notMyChildCnt == 3 );
+
+  NwkChildAge_GetStats( &stats, TRUE );
+  ZTEST_CHECK( (stats.children == 0) && (stats.aged == 3) );
+  NwkChildAge_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.aged == 0 );
+}
+
+static void testPollDelays( void )
+{
+  reset();
+
+  childAdd( 0, 0x0010, 10 );
+  childAdd( 1, 0x0011, 10 );
+
+  // 0x0010 polls every 8 seconds, 0x0011 goes quiet
+  runSeconds( 8 );
+  (void)pAssocChildTableUpdateTimeout( 0x0010 );
+  ZTEST_CHECK( libRefreshCnt == 1 );
+  ZTEST_CHECK( NwkChildAge_Deadline( 0 ) == 18 );
+  runSeconds( 2 );
+  ZTEST_CHECK( (agedCnt == 1) && (agedAddr[0] == 0x0011) );
+  runSeconds( 6 );
+  (void)pAssocChildTableUpdateTimeout( 0x0010 );
+  runSeconds( 8 );
+  (void)pAssocChildTableUpdateTimeout( 0x0010 );
+  ZTEST_CHECK( agedCnt == 1 );
+
+  // Stops polling
+  runSeconds( 9 );
+  ZTEST_CHECK( agedCnt == 1 );
+  runSeconds( 1 );
+  ZTEST_CHECK( (agedCnt == 2) && (agedAddr[1] == 0x0010) );
+}
+
+static void testReplaced( void )
+{
+  reset();
+
+  childAdd( 0, 0x0010, 10 );
+
+  // Left and the entry reused by a child the aging wasn't told about,
+  // the sync of the entries on the next tick picks it up
+  AssociatedDevList[0].shortAddr = 0x0020;
+  AssociatedDevList[0].endDev.deviceTimeout = 120;
+  AssociatedDevList[0].timeoutCounter = 120;
+  runSeconds( 10 );
+  ZTEST_CHECK( agedCnt == 0 );
+  ZTEST_CHECK( NwkChildAge_Deadline( 0 ) == 121 );
+
+  // No longer a child, dropped once the sync comes around to it
+  AssociatedDevList[0].nodeRelation = CHILD_FFD;
+  runSeconds( (NWK_MAX_DEVICES + NWK_CHILD_AGE_SYNC_SLOTS - 1) / NWK_CHILD_AGE_SYNC_SLOTS );
+  ZTEST_CHECK( NwkChildAge_Deadline( 0 ) == 0 );
+  runSeconds( 200 );
+  ZTEST_CHECK( agedCnt == 0 );
+}
+
+static void testNoExtAddr( void )
+{
+  reset();
+
+  childAdd( 0, 0x0010, 10 );
+  childAdd( 1, 0x0011, 10 );
+
+  // Without its IEEE address the entry is freed in place and the
+  // callback gets no address
+  addrKnown = FALSE;
+  runSeconds( 10 );
+  ZTEST_CHECK( agedCnt == 2 );
+  ZTEST_CHECK( !agedHadExt[0] && !agedHadExt[1] );
+  ZTEST_CHECK( AssociatedDevList[0].shortAddr == INVALID_NODE_ADDR );
+  ZTEST_CHECK( AssociatedDevList[0].nodeRelation == NOTUSED );
+  ZTEST_CHECK( AssociatedDevList[1].shortAddr == INVALID_NODE_ADDR );
+  ZTEST_CHECK( nbrRemoved == 0x0011 );
+
+  // Known, but not removed by the association list
+  childAdd( 2, 0x0012, 10 );
+  addrKnown = TRUE;
+  assocRemoveOk = FALSE;
+  runSeconds( 10 );
+  ZTEST_CHECK( (agedCnt == 3) && agedHadExt[2] );
+  ZTEST_CHECK( AssociatedDevList[2].shortAddr == INVALID_NODE_ADDR );
+  ZTEST_CHECK( AssociatedDevList[2].nodeRelation == NOTUSED );
+}
+
+static void testHeapMany( void )
+{
+  uint32_t lastPoll[NWK_MAX_DEVICES];
+  uint32_t period;
+  uint32_t due;
+  uint16_t x;
+  uint16_t i;
+  uint32_t s;
+
+  reset();
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    childAdd( x, 0x0100 + x, (x % 4 == 0) ? 10 : timeoutValue[1 + (x % 3)] * 60 );
+    lastPoll[x] = 0;
+  }
+
+  // The first two thirds poll at half their timeout, the rest go quiet
+  for ( s = 1; s <= 1200; s++ )
+  {
+    runSeconds( 1 );
+
+    for ( i = 0; i < agedCnt; i++ )
+    {
+      x = agedAddr[i] - 0x0100;
+      if ( lastPoll[x] != 0xFFFFFFFF )
+      {
+        due = lastPoll[x] + ( (x % 4 == 0) ? 10 : timeoutValue[1 + (x % 3)] * 60 );
+        ZTEST_CHECK( (s >= due) && (s <= due + 1) );
+        lastPoll[x] = 0xFFFFFFFF;
+      }
+    }
+
+    for ( x = 0; x < (2 * NWK_MAX_DEVICES) / 3; x++ )
+    {
+      period = AssociatedDevList[x].endDev.deviceTimeout / 2;
+      if ( (AssociatedDevList[x].shortAddr != INVALID_NODE_ADDR) && ((s % period) == 0) )
+      {
+        (void)pAssocChildTableUpdateTimeout( AssociatedDevList[x].shortAddr );
+        lastPoll[x] = s;
+      }
+    }
+  }
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    if ( x < (2 * NWK_MAX_DEVICES) / 3 )
+    {
+      ZTEST_CHECK( lastPoll[x] != 0xFFFFFFFF );
+    }
+    else
+    {
+      ZTEST_CHECK( lastPoll[x] == 0xFFFFFFFF );
+    }
+  }
+}
+
+int main( void )
+{
+  ZTEST_RUN( testInit );
+  ZTEST_RUN( testAgesInOrder );
+  ZTEST_RUN( testPollDelays );
+  ZTEST_RUN( testReplaced );
+  ZTEST_RUN( testNoExtAddr );
+  ZTEST_RUN( testHeapMany );
+
+  return ( ZTEST_RESULT );
+}
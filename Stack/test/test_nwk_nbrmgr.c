@@ -0,0 +1,504 @@
+/**************************************************************************************************
+  Filename:       test_nwk_nbrmgr.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the neighbor table manager: the scoring
+                  pass over the limit, the hysteresis, the protected
+                  next hops, and the table churn with 60 audible routers
+                  with the manager off, its default, and on.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "nwk_nbrmgr.h"
+#include "rtg.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define PAN_ID  0x1234
+
+// Limit the tests turn the manager on with
+#define TEST_LIMIT  ( MAX_NEIGHBOR_ENTRIES - 2 )
+
+// Simulated network: routers heard, link status periods, the NWK
+// layer's age limit and the routes through the neighbors
+#define SIM_ROUTERS     60
+#define SIM_PERIODS     200
+#define SIM_AGE_LIMIT   3
+#define SIM_ROUTES      4
+
+uint32_t ztestClock = 0;
+nwkIB_t _NIB = { PAN_ID };
+
+neighborEntry_t neighborTable[MAX_NEIGHBOR_ENTRIES];
+rtgEntry_t rtgTable[MAX_RTG_ENTRIES];
+rtgSrcEntry_t rtgSrcTable[MAX_RTG_SRC_ENTRIES];
+
+neighborTableIndex_t gMAX_NEIGHBOR_ENTRIES = MAX_NEIGHBOR_ENTRIES;
+rtgTableIndex_t gMAX_RTG_ENTRIES = MAX_RTG_ENTRIES;
+srcRtgTableIndex_t gMAX_RTG_SRC_ENTRIES = MAX_RTG_SRC_ENTRIES;
+
+void nwkNeighborRemove( uint16_t NeighborAddress, uint16_t PanId )
+{
+  uint8_t x;
+
+  for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    if ( (neighborTable[x].neighborAddress == NeighborAddress) &&
+         (neighborTable[x].panId == PanId) )
+    {
+      neighborTable[x].neighborAddress = INVALID_NODE_ADDR;
+    }
+  }
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+static void reset( void )
+{
+  nwkNbrMgrStats_t stats;
+  uint8_t x;
+
+  memset( rtgTable, 0, sizeof( rtgTable ) );
+  memset( rtgSrcTable, 0, sizeof( rtgSrcTable ) );
+  for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    memset( &neighborTable[x], 0, sizeof( neighborEntry_t ) );
+    neighborTable[x].neighborAddress = INVALID_NODE_ADDR;
+  }
+
+  (void)NwkNbrMgr_Config( TEST_LIMIT, NWK_NBR_MGR_HYSTERESIS );
+  NwkNbrMgr_GetStats( &stats, TRUE );
+  NwkNbrMgr_Init();
+}
+
+// Score of a fresh neighbor: lqi / 2 + (8 - cost) * 8
+static void nbrSet( uint8_t x, uint16_t addr, uint8_t lqi, uint8_t cost )
+{
+  neighborTable[x].neighborAddress = addr;
+  neighborTable[x].panId = PAN_ID;
+  neighborTable[x].age = 0;
+  neighborTable[x].linkInfo.rxLqi = lqi;
+  neighborTable[x].linkInfo.txCost = cost;
+}
+
+static int nbrIn( uint16_t addr )
+{
+  uint8_t x;
+
+  for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    if ( neighborTable[x].neighborAddress == addr )
+    {
+      return ( 1 );
+    }
+  }
+
+  return ( 0 );
+}
+
+// Fill the entries up to the limit and make them kept neighbors
+static void fillKept( uint8_t lqi, uint8_t cost )
+{
+  uint8_t x;
+
+  for ( x = 0; x < TEST_LIMIT; x++ )
+  {
+    nbrSet( x, 0x0100 + x, lqi, cost );
+  }
+  NwkNbrMgr_Process();
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testUnderLimit( void )
+{
+  nwkNbrMgrStats_t stats;
+  uint8_t x;
+
+  reset();
+
+  for ( x = 0; x < 10; x++ )
+  {
+    nbrSet( x, 0x0100 + x, 20, 7 );
+  }
+  NwkNbrMgr_Process();
+
+  NwkNbrMgr_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.used == 10 );
+  ZTEST_CHECK( stats.limit == TEST_LIMIT );
+  ZTEST_CHECK( stats.passes == 1 );
+  ZTEST_CHECK( (stats.evicted == 0) && (stats.rejected == 0) );
+  for ( x = 0; x < 10; x++ )
+  {
+    ZTEST_CHECK( nbrIn( 0x0100 + x ) );
+  }
+}
+
+static void testNewRejected( void )
+{
+  nwkNbrMgrStats_t stats;
+
+  reset();
+  fillKept( 200, 1 );
+
+  // Weak new neighbors in the headroom don't beat the kept ones
+  nbrSet( 14, 0x0200, 40, 7 );
+  nbrSet( 15, 0x0201, 60, 7 );
+  NwkNbrMgr_Process();
+
+  NwkNbrMgr_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.rejected == 2 );
+  ZTEST_CHECK( stats.evicted == 0 );
+  ZTEST_CHECK( stats.used == TEST_LIMIT );
+  ZTEST_CHECK( !nbrIn( 0x0200 ) && !nbrIn( 0x0201 ) );
+  ZTEST_CHECK( nbrIn( 0x0100 ) && nbrIn( 0x010D ) );
+}
+
+static void testNewReplaces( void )
+{
+  nwkNbrMgrStats_t stats;
+
+  reset();
+  fillKept( 100, 5 );
+
+  // The two weakest kept neighbors, one of them a next hop
+  nbrSet( 0, 0x0100, 20, 5 );
+  nbrSet( 1, 0x0101, 30, 5 );
+  nbrSet( 2, 0x0102, 40, 5 );
+  rtgTable[0].status = RT_ACTIVE;
+  rtgTable[0].nextHopAddress = 0x0100;
+
+  nbrSet( 14, 0x0200, 250, 1 );
+  nbrSet( 15, 0x0201, 240, 1 );
+  NwkNbrMgr_Process();
+
+  NwkNbrMgr_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.evicted == 2 );
+  ZTEST_CHECK( stats.rejected == 0 );
+  ZTEST_CHECK( stats.nextHops == 1 );
+  ZTEST_CHECK( nbrIn( 0x0200 ) && nbrIn( 0x0201 ) );
+  ZTEST_CHECK( nbrIn( 0x0100 ) );
+  ZTEST_CHECK( !nbrIn( 0x0101 ) && !nbrIn( 0x0102 ) );
+}
+
+static void testHysteresis( void )
+{
+  nwkNbrMgrStats_t stats;
+
+  reset();
+  fillKept( 100, 5 );
+
+  // 79 against the worst kept 74, inside the hysteresis of 16
+  nbrSet( 14, 0x0200, 110, 5 );
+  nbrSet( 15, 0x0201, 110, 5 );
+  NwkNbrMgr_Process();
+
+  NwkNbrMgr_GetStats( &stats, TRUE );
+  ZTEST_CHECK( stats.rejected == 2 );
+  ZTEST_CHECK( !nbrIn( 0x0200 ) && !nbrIn( 0x0201 ) );
+
+  // Without hysteresis the better one stays
+  ZTEST_CHECK( NwkNbrMgr_Config( TEST_LIMIT, 0 ) == ZSuccess );
+  nbrSet( 14, 0x0200, 110, 5 );
+  nbrSet( 15, 0x0201, 100, 5 );
+  NwkNbrMgr_Process();
+
+  NwkNbrMgr_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.passes == 1 );
+  ZTEST_CHECK( (stats.evicted == 1) && (stats.rejected == 1) );
+  ZTEST_CHECK( nbrIn( 0x0200 ) && !nbrIn( 0x0201 ) );
+}
+
+static void testOtherPan( void )
+{
+  reset();
+  fillKept( 100, 5 );
+
+  // A neighbor of another PAN scores 0 and goes first
+  nbrSet( 3, 0x0103, 255, 1 );
+  neighborTable[3].panId = PAN_ID + 1;
+  nbrSet( 14, 0x0200, 150, 5 );
+  nbrSet( 15, 0x0201, 10, 7 );
+  NwkNbrMgr_Process();
+
+  ZTEST_CHECK( !nbrIn( 0x0103 ) );
+  ZTEST_CHECK( nbrIn( 0x0200 ) );
+  ZTEST_CHECK( !nbrIn( 0x0201 ) );
+}
+
+static void testNextHopsKept( void )
+{
+  nwkNbrMgrStats_t stats;
+  uint16_t relays[2] = { 0x0205, 0x0102 };
+  uint8_t x;
+
+  reset();
+  ZTEST_CHECK( NwkNbrMgr_Config( 2, 0 ) == ZSuccess );
+
+  for ( x = 0; x < 4; x++ )
+  {
+    nbrSet( x, 0x0100 + x, 10, 7 );
+  }
+
+  // Next hop of a route and first relay of a source route, the relay
+  // list runs from the destination
+  rtgTable[0].status = RT_ACTIVE;
+  rtgTable[0].nextHopAddress = 0x0101;
+  rtgTable[1].nextHopAddress = 0x0103;   // Not active
+  rtgSrcTable[0].relayCount = 2;
+  rtgSrcTable[0].relayList = relays;
+  NwkNbrMgr_Process();
+
+  NwkNbrMgr_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.nextHops == 2 );
+  ZTEST_CHECK( stats.used == 2 );
+  ZTEST_CHECK( nbrIn( 0x0101 ) && nbrIn( 0x0102 ) );
+  ZTEST_CHECK( !nbrIn( 0x0100 ) && !nbrIn( 0x0103 ) );
+
+  // Only next hops left over the limit, they all stay
+  ZTEST_CHECK( NwkNbrMgr_Config( 1, 0 ) == ZSuccess );
+  NwkNbrMgr_Process();
+  NwkNbrMgr_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.used == 2 );
+  ZTEST_CHECK( nbrIn( 0x0101 ) && nbrIn( 0x0102 ) );
+}
+
+static void testDefaultOff( void )
+{
+  nwkNbrMgrStats_t stats;
+  uint8_t x;
+
+  reset();
+  ZTEST_CHECK( NwkNbrMgr_Config( NWK_NBR_MGR_LIMIT, NWK_NBR_MGR_HYSTERESIS ) == ZSuccess );
+  ZTEST_CHECK( NWK_NBR_MGR_LIMIT == MAX_NEIGHBOR_ENTRIES );
+
+  // A full table of weak neighbors, then strong new ones in their place
+  fillKept( 20, 7 );
+  nbrSet( 14, 0x0200, 250, 1 );
+  nbrSet( 15, 0x0201, 10, 7 );
+  NwkNbrMgr_Process();
+
+  NwkNbrMgr_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.used == MAX_NEIGHBOR_ENTRIES );
+  ZTEST_CHECK( stats.limit == MAX_NEIGHBOR_ENTRIES );
+  ZTEST_CHECK( (stats.evicted == 0) && (stats.rejected == 0) );
+  for ( x = 0; x < TEST_LIMIT; x++ )
+  {
+    ZTEST_CHECK( nbrIn( 0x0100 + x ) );
+  }
+  ZTEST_CHECK( nbrIn( 0x0200 ) && nbrIn( 0x0201 ) );
+}
+
+static void testConfig( void )
+{
+  nwkNbrMgrStats_t stats;
+
+  reset();
+
+  ZTEST_CHECK( NwkNbrMgr_Config( 0, 0 ) == ZInvalidParameter );
+  ZTEST_CHECK( NwkNbrMgr_Config( MAX_NEIGHBOR_ENTRIES + 1, 0 ) == ZInvalidParameter );
+  ZTEST_CHECK( NwkNbrMgr_Config( MAX_NEIGHBOR_ENTRIES, 8 ) == ZSuccess );
+
+  NwkNbrMgr_Process();
+  NwkNbrMgr_Process();
+  NwkNbrMgr_GetStats( &stats, TRUE );
+  ZTEST_CHECK( stats.limit == MAX_NEIGHBOR_ENTRIES );
+  ZTEST_CHECK( stats.passes == 2 );
+
+  NwkNbrMgr_GetStats( &stats, FALSE );
+  ZTEST_CHECK( stats.passes == 0 );
+}
+
+/*********************************************************************
+ * SIMULATION
+ */
+typedef struct
+{
+  uint32_t changes;   // Neighbors added and removed
+  uint32_t repairs;   // Routes that lost their next hop
+  uint32_t quality;   // Mean link quality of the table, summed per period
+  nwkNbrMgrStats_t stats;
+} simResult_t;
+
+static uint32_t simSeed;
+
+static uint8_t simRand( uint8_t range )
+{
+  simSeed = simSeed * 1103515245u + 12345u;
+  return ( (uint8_t)((simSeed >> 16) % range) );
+}
+
+// Link status heard by the NWK layer: the entry is refreshed, or added
+// in a free one, or the router is not heard of if the table is full
+static void simHear( uint16_t addr, uint8_t lqi, simResult_t *pResult )
+{
+  uint8_t x;
+  uint8_t free = MAX_NEIGHBOR_ENTRIES;
+
+  for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+  {
+    if ( neighborTable[x].neighborAddress == addr )
+    {
+      neighborTable[x].age = 0;
+      neighborTable[x].linkInfo.rxLqi = lqi;
+      return;
+    }
+    if ( (neighborTable[x].neighborAddress == INVALID_NODE_ADDR) && (free == MAX_NEIGHBOR_ENTRIES) )
+    {
+      free = x;
+    }
+  }
+
+  if ( free < MAX_NEIGHBOR_ENTRIES )
+  {
+    nbrSet( free, addr, lqi, 0 );
+    pResult->changes++;
+  }
+}
+
+static void simRun( uint8_t limit, simResult_t *pResult )
+{
+  uint8_t quality[SIM_ROUTERS];
+  uint16_t period;
+  uint16_t sum;
+  uint8_t used;
+  uint8_t before;
+  uint8_t x;
+  uint8_t r;
+
+  reset();
+  (void)NwkNbrMgr_Config( limit, NWK_NBR_MGR_HYSTERESIS );
+  memset( pResult, 0, sizeof( simResult_t ) );
+
+  // Same routers at the same link qualities on both runs
+  simSeed = 0x5EED;
+  for ( r = 0; r < SIM_ROUTERS; r++ )
+  {
+    quality[r] = 30 + simRand( 200 );
+  }
+
+  for ( r = 0; r < SIM_ROUTES; r++ )
+  {
+    rtgTable[r].status = RT_ACTIVE;
+    rtgTable[r].nextHopAddress = INVALID_NODE_ADDR;
+  }
+
+  for ( period = 0; period < SIM_PERIODS; period++ )
+  {
+    // The NWK layer ages the routers out
+    for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+    {
+      if ( (neighborTable[x].neighborAddress != INVALID_NODE_ADDR) &&
+           (++neighborTable[x].age > SIM_AGE_LIMIT) )
+      {
+        neighborTable[x].neighborAddress = INVALID_NODE_ADDR;
+        pResult->changes++;
+      }
+    }
+
+    // Nine link status frames in ten get through, at +/-20 LQI
+    for ( r = 0; r < SIM_ROUTERS; r++ )
+    {
+      if ( simRand( 10 ) != 0 )
+      {
+        simHear( 0x2000 + r, quality[r] - 20 + simRand( 41 ), pResult );
+      }
+    }
+
+    before = 0;
+    for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+    {
+      before += ( neighborTable[x].neighborAddress != INVALID_NODE_ADDR );
+    }
+    NwkNbrMgr_Process();
+
+    sum = 0;
+    used = 0;
+    for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+    {
+      if ( neighborTable[x].neighborAddress != INVALID_NODE_ADDR )
+      {
+        sum += quality[neighborTable[x].neighborAddress - 0x2000];
+        used++;
+      }
+    }
+    pResult->changes += before - used;
+    pResult->quality += ( used > 0 ) ? ( sum / used ) : 0;
+
+    // A route whose next hop left the table is repaired through the
+    // best router in it
+    for ( r = 0; r < SIM_ROUTES; r++ )
+    {
+      if ( !nbrIn( rtgTable[r].nextHopAddress ) )
+      {
+        uint16_t best = INVALID_NODE_ADDR;
+
+        for ( x = 0; x < MAX_NEIGHBOR_ENTRIES; x++ )
+        {
+          uint16_t addr = neighborTable[x].neighborAddress;
+
+          if ( (addr != INVALID_NODE_ADDR) &&
+               ((best == INVALID_NODE_ADDR) || (quality[addr - 0x2000] > quality[best - 0x2000])) )
+          {
+            best = addr;
+          }
+        }
+        if ( rtgTable[r].nextHopAddress != INVALID_NODE_ADDR )
+        {
+          pResult->repairs++;
+        }
+        rtgTable[r].nextHopAddress = best;
+      }
+    }
+  }
+
+  pResult->quality /= SIM_PERIODS;
+  NwkNbrMgr_GetStats( &pResult->stats, FALSE );
+}
+
+static void testAudibleRouters( void )
+{
+  simResult_t off;
+  simResult_t on;
+
+  simRun( NWK_NBR_MGR_LIMIT, &off );
+  simRun( TEST_LIMIT, &on );
+
+  printf( "%u routers, %u entries, %u periods\n",
+          SIM_ROUTERS, MAX_NEIGHBOR_ENTRIES, SIM_PERIODS );
+  printf( "off:      %5lu table changes, %3lu route repairs, LQI %3lu, %lu evicted %lu rejected\n",
+          (unsigned long)off.changes, (unsigned long)off.repairs, (unsigned long)off.quality,
+          (unsigned long)off.stats.evicted, (unsigned long)off.stats.rejected );
+  printf( "limit %2u: %5lu table changes, %3lu route repairs, LQI %3lu, %lu evicted %lu rejected\n",
+          TEST_LIMIT, (unsigned long)on.changes, (unsigned long)on.repairs, (unsigned long)on.quality,
+          (unsigned long)on.stats.evicted, (unsigned long)on.stats.rejected );
+
+  // Off, the NWK layer's own table is left alone
+  ZTEST_CHECK( (off.stats.evicted == 0) && (off.stats.rejected == 0) );
+
+  // On, the free entries churn through the routers not kept, for a
+  // better table
+  ZTEST_CHECK( on.changes > off.changes );
+  ZTEST_CHECK( on.stats.rejected > 0 );
+  ZTEST_CHECK( on.quality > off.quality );
+  ZTEST_CHECK( on.repairs <= off.repairs );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testUnderLimit );
+  ZTEST_RUN( testNewRejected );
+  ZTEST_RUN( testNewReplaces );
+  ZTEST_RUN( testHysteresis );
+  ZTEST_RUN( testOtherPan );
+  ZTEST_RUN( testNextHopsKept );
+  ZTEST_RUN( testDefaultOff );
+  ZTEST_RUN( testConfig );
+  ZTEST_RUN( testAudibleRouters );
+
+  return ( ZTEST_RESULT );
+}
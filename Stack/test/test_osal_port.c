@@ -0,0 +1,560 @@
+/**************************************************************************************************
+  Filename:       test_osal_port.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the shared OSAL messages: the reference
+                  count in the message header, the queue links of
+                  OsalPort_msgSendShared() and the messages holding a
+                  shared buffer, delivered to several consumers in a
+                  random order.  Every allocation is tracked, a buffer
+                  used after its last reference or left behind fails.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "osal_port.h"
+
+#ifndef TRUE
+  #define TRUE  1
+#endif
+#ifndef FALSE
+  #define FALSE 0
+#endif
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define MAX_TASKS       15
+#define HEAP_BLOCKS     512
+
+// Task table, the fields the message calls use
+typedef struct
+{
+  uint8_t taskId;
+  OsalPort_MsgQ qHandle;
+} TaskEntry;
+
+TaskEntry taskTbl[MAX_TASKS];
+uint8_t taskCnt = 0;
+
+// Live heap blocks, a freed block is filled so stale reads show
+static void *heapBlocks[HEAP_BLOCKS];
+static uint16_t heapLive;
+static uint16_t heapFailIn;     // Fail the n-th allocation from now, 0 never
+
+void* OsalPort_malloc( uint32_t size )
+{
+  uint16_t x;
+  void *pBuf;
+
+  if ( heapFailIn && (--heapFailIn == 0) )
+  {
+    return ( NULL );
+  }
+
+  pBuf = malloc( size + sizeof( uint32_t ) );
+  if ( pBuf == NULL )
+  {
+    return ( NULL );
+  }
+  memcpy( pBuf, &size, sizeof( uint32_t ) );
+
+  for ( x = 0; x < HEAP_BLOCKS; x++ )
+  {
+    if ( heapBlocks[x] == NULL )
+    {
+      heapBlocks[x] = pBuf;
+      heapLive++;
+      break;
+    }
+  }
+
+  return ( (uint8_t *)pBuf + sizeof( uint32_t ) );
+}
+
+void OsalPort_free( void* buf )
+{
+  uint8_t *pBuf = (uint8_t *)buf - sizeof( uint32_t );
+  uint32_t size;
+  uint16_t x;
+
+  for ( x = 0; x < HEAP_BLOCKS; x++ )
+  {
+    if ( heapBlocks[x] == pBuf )
+    {
+      heapBlocks[x] = NULL;
+      heapLive--;
+      memcpy( &size, pBuf, sizeof( uint32_t ) );
+      memset( buf, 0xDD, size );
+      free( pBuf );
+      return;
+    }
+  }
+
+  // Freed twice or never allocated
+  ZTEST_CHECK( x < HEAP_BLOCKS );
+}
+
+static uint8_t heapHas( void *pMsg )
+{
+  uint8_t *pBuf = (uint8_t *)pMsg - sizeof( OsalPort_MsgHdr ) - sizeof( uint32_t );
+  uint16_t x;
+
+  for ( x = 0; x < HEAP_BLOCKS; x++ )
+  {
+    if ( heapBlocks[x] == pBuf )
+    {
+      return ( TRUE );
+    }
+  }
+
+  return ( FALSE );
+}
+
+uint32_t OsalPort_enterCS( void )
+{
+  return ( 0 );
+}
+
+void OsalPort_leaveCS( uint32_t key )
+{
+  (void)key;
+}
+
+uint8_t OsalPort_setEvent( uint8_t destinationTask, uint32_t eventFlag )
+{
+  (void)destinationTask;
+  (void)eventFlag;
+  return ( OsalPort_SUCCESS );
+}
+
+void OsalPort_clearEvent( uint8_t TaskID, uint32_t eventFlag )
+{
+  (void)TaskID;
+  (void)eventFlag;
+}
+
+#include "test_osal_port_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define CONSUMERS       6
+#define SHARED_MAX      8
+#define ROUNDS          2000
+
+// Message a subscriber gets in place of the shared one: its own header
+// and a pointer into the shared buffer, as the AF incoming message
+typedef struct
+{
+  OsalPort_EventHdr hdr;
+  uint8_t *pData;
+  uint8_t dataLen;
+} refMsg_t;
+
+#define EVT_SHARED      0x1A
+#define EVT_REF         0x1B
+
+static uint32_t seed;
+
+static uint32_t rnd( uint32_t n )
+{
+  seed = (seed * 1103515245UL) + 12345UL;
+
+  return ( (seed >> 8) % n );
+}
+
+static void reset( void )
+{
+  uint8_t x;
+
+  for ( x = 0; x < MAX_TASKS; x++ )
+  {
+    memset( &taskTbl[x], 0, sizeof( TaskEntry ) );
+    taskTbl[x].taskId = x;
+  }
+  taskCnt = CONSUMERS;
+  heapFailIn = 0;
+}
+
+// Shared message whose payload after the header is a pattern of its length
+static uint8_t *sharedNew( uint8_t len )
+{
+  uint8_t *pMsg = OsalPort_msgAllocate( sizeof( OsalPort_EventHdr ) + len );
+  uint8_t x;
+
+  if ( pMsg != NULL )
+  {
+    ((OsalPort_EventHdr *)pMsg)->event = EVT_SHARED;
+    ((OsalPort_EventHdr *)pMsg)->status = len;
+    for ( x = 0; x < len; x++ )
+    {
+      pMsg[sizeof( OsalPort_EventHdr ) + x] = (uint8_t)(len + x);
+    }
+  }
+
+  return ( pMsg );
+}
+
+static uint8_t sharedIntact( uint8_t *pMsg )
+{
+  uint8_t len = ((OsalPort_EventHdr *)pMsg)->status;
+  uint8_t x;
+
+  if ( !heapHas( pMsg ) || (((OsalPort_EventHdr *)pMsg)->event != EVT_SHARED) )
+  {
+    return ( FALSE );
+  }
+  for ( x = 0; x < len; x++ )
+  {
+    if ( pMsg[sizeof( OsalPort_EventHdr ) + x] != (uint8_t)(len + x) )
+    {
+      return ( FALSE );
+    }
+  }
+
+  return ( TRUE );
+}
+
+static uint8_t refSend( uint8_t task, uint8_t *pShared )
+{
+  refMsg_t *pRef = (refMsg_t *)OsalPort_msgAllocateRef( sizeof( refMsg_t ), pShared );
+
+  if ( pRef == NULL )
+  {
+    return ( FALSE );
+  }
+
+  pRef->hdr.event = EVT_REF;
+  pRef->pData = pShared + sizeof( OsalPort_EventHdr );
+  pRef->dataLen = ((OsalPort_EventHdr *)pShared)->status;
+  OsalPort_msgSend( task, (uint8_t *)pRef );
+
+  return ( TRUE );
+}
+
+// Check and release one received message
+static void consume( uint8_t *pMsg )
+{
+  refMsg_t *pRef;
+  uint8_t x;
+
+  if ( ((OsalPort_EventHdr *)pMsg)->event == EVT_REF )
+  {
+    pRef = (refMsg_t *)pMsg;
+    ZTEST_CHECK( sharedIntact( pRef->pData - sizeof( OsalPort_EventHdr ) ) );
+    for ( x = 0; x < pRef->dataLen; x++ )
+    {
+      ZTEST_CHECK( pRef->pData[x] == (uint8_t)(pRef->dataLen + x) );
+    }
+  }
+  else
+  {
+    ZTEST_CHECK( sharedIntact( pMsg ) );
+  }
+
+  ZTEST_CHECK( OsalPort_msgDeallocate( pMsg ) == OsalPort_SUCCESS );
+}
+
+static uint16_t queued( uint8_t task )
+{
+  uint16_t cnt = 0;
+  void *pMsg;
+
+  for ( pMsg = taskTbl[task].qHandle; pMsg != NULL; pMsg = OsalPort_MSG_NEXT( pMsg ) )
+  {
+    cnt++;
+  }
+
+  return ( cnt );
+}
+
+// Receive from random consumers until every queue is empty
+static void drain( void )
+{
+  uint8_t task;
+  uint8_t *pMsg;
+
+  for ( ;; )
+  {
+    for ( task = 0; task < CONSUMERS; task++ )
+    {
+      if ( taskTbl[task].qHandle != NULL )
+      {
+        break;
+      }
+    }
+    if ( task == CONSUMERS )
+    {
+      return;
+    }
+
+    do
+    {
+      task = (uint8_t)rnd( CONSUMERS );
+    } while ( taskTbl[task].qHandle == NULL );
+
+    pMsg = OsalPort_msgReceive( task );
+    ZTEST_CHECK( pMsg != NULL );
+    if ( pMsg != NULL )
+    {
+      consume( pMsg );
+    }
+  }
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testSingle( void )
+{
+  uint8_t *pMsg;
+
+  reset();
+
+  // Not shared, freed by its only owner
+  pMsg = sharedNew( 10 );
+  ZTEST_CHECK( OsalPort_MSG_REF( pMsg ) == 1 );
+  ZTEST_CHECK( OsalPort_msgSend( 2, pMsg ) == OsalPort_SUCCESS );
+  ZTEST_CHECK( OsalPort_msgReceive( 2 ) == pMsg );
+  ZTEST_CHECK( OsalPort_msgDeallocate( pMsg ) == OsalPort_SUCCESS );
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void testCount( void )
+{
+  uint8_t *pMsg[3];
+  uint8_t x;
+
+  reset();
+
+  // Plain and shared messages count alike, up to the limit asked for
+  for ( x = 0; x < 3; x++ )
+  {
+    pMsg[x] = sharedNew( 10 );
+  }
+  ZTEST_CHECK( OsalPort_msgCount( 2, 10 ) == 0 );
+  ZTEST_CHECK( OsalPort_msgSend( 2, pMsg[0] ) == OsalPort_SUCCESS );
+  ZTEST_CHECK( OsalPort_msgSendShared( 2, pMsg[1] ) == OsalPort_SUCCESS );
+  ZTEST_CHECK( OsalPort_msgSend( 2, pMsg[2] ) == OsalPort_SUCCESS );
+  ZTEST_CHECK( OsalPort_msgCount( 2, 10 ) == 3 );
+  ZTEST_CHECK( OsalPort_msgCount( 2, 2 ) == 2 );
+  ZTEST_CHECK( OsalPort_msgCount( 3, 10 ) == 0 );
+  ZTEST_CHECK( OsalPort_msgCount( MAX_TASKS, 10 ) == 0 );
+
+  for ( x = 0; x < 3; x++ )
+  {
+    ZTEST_CHECK( OsalPort_msgReceive( 2 ) == pMsg[x] );
+    ZTEST_CHECK( OsalPort_msgCount( 2, 10 ) == 2 - x );
+    OsalPort_msgDeallocate( pMsg[x] );
+  }
+
+  // The sender's reference to the shared one
+  OsalPort_msgDeallocate( pMsg[1] );
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void testShared( void )
+{
+  uint8_t *pMsg;
+  uint8_t task;
+
+  reset();
+
+  pMsg = sharedNew( 20 );
+  for ( task = 0; task < CONSUMERS; task++ )
+  {
+    ZTEST_CHECK( OsalPort_msgSendShared( task, pMsg ) == OsalPort_SUCCESS );
+  }
+  ZTEST_CHECK( (OsalPort_MSG_REF( pMsg ) & OsalPort_MSG_REF_CNT_MASK) == CONSUMERS + 1 );
+
+  // The sender lets go first, the receivers still see it
+  ZTEST_CHECK( OsalPort_msgDeallocate( pMsg ) == OsalPort_SUCCESS );
+  for ( task = 0; task < CONSUMERS; task++ )
+  {
+    ZTEST_CHECK( OsalPort_msgReceive( task ) == pMsg );
+    ZTEST_CHECK( sharedIntact( pMsg ) );
+    OsalPort_msgDeallocate( pMsg );
+  }
+  ZTEST_CHECK( heapLive == 0 );
+
+  // A link to a task that does not exist takes no reference
+  pMsg = sharedNew( 4 );
+  ZTEST_CHECK( OsalPort_msgSendShared( MAX_TASKS, pMsg ) == OsalPort_INVALID_TASK );
+  ZTEST_CHECK( OsalPort_MSG_REF( pMsg ) == 1 );
+  ZTEST_CHECK( heapLive == 1 );
+  OsalPort_msgDeallocate( pMsg );
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void testAttached( void )
+{
+  uint8_t *pMsg;
+  uint8_t *pRef;
+
+  reset();
+
+  pMsg = sharedNew( 30 );
+  ZTEST_CHECK( refSend( 1, pMsg ) );
+  ZTEST_CHECK( refSend( 3, pMsg ) );
+  OsalPort_msgDeallocate( pMsg );
+  ZTEST_CHECK( sharedIntact( pMsg ) );
+
+  // The reference is hidden after the payload
+  pRef = OsalPort_msgReceive( 3 );
+  ZTEST_CHECK( OsalPort_MSG_LEN( pRef ) == sizeof( refMsg_t ) );
+  ZTEST_CHECK( OsalPort_MSG_REF( pRef ) == (OsalPort_MSG_REF_ATTACHED | 1) );
+  consume( pRef );
+  ZTEST_CHECK( sharedIntact( pMsg ) );
+
+  // The last one holding it frees it
+  consume( OsalPort_msgReceive( 1 ) );
+  ZTEST_CHECK( heapLive == 0 );
+
+  // A message holding a buffer is itself shared
+  pMsg = sharedNew( 5 );
+  pRef = OsalPort_msgAllocateRef( sizeof( refMsg_t ), pMsg );
+  ((refMsg_t *)pRef)->hdr.event = EVT_REF;
+  ((refMsg_t *)pRef)->pData = pMsg + sizeof( OsalPort_EventHdr );
+  ((refMsg_t *)pRef)->dataLen = 5;
+  OsalPort_msgDeallocate( pMsg );
+  ZTEST_CHECK( OsalPort_msgSendShared( 0, pRef ) == OsalPort_SUCCESS );
+  ZTEST_CHECK( OsalPort_msgSendShared( 4, pRef ) == OsalPort_SUCCESS );
+  ZTEST_CHECK( OsalPort_MSG_REF( pRef ) == (OsalPort_MSG_REF_ATTACHED | 3) );
+  OsalPort_msgDeallocate( pRef );
+  drain();
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void testSaturated( void )
+{
+  uint8_t *pMsg;
+  uint8_t x;
+
+  reset();
+
+  pMsg = sharedNew( 8 );
+  for ( x = 1; x < OsalPort_MSG_REF_CNT_MASK; x++ )
+  {
+    ZTEST_CHECK( OsalPort_msgSendShared( (uint8_t)(x % CONSUMERS), pMsg ) == OsalPort_SUCCESS );
+  }
+  ZTEST_CHECK( OsalPort_MSG_REF( pMsg ) == OsalPort_MSG_REF_CNT_MASK );
+
+  // Refused without touching the flags or leaving a link behind
+  x = (uint8_t)heapLive;
+  ZTEST_CHECK( OsalPort_msgSendShared( 0, pMsg ) == OsalPort_MSG_BUFFER_NOT_AVAIL );
+  ZTEST_CHECK( OsalPort_msgAllocateRef( sizeof( refMsg_t ), pMsg ) == NULL );
+  ZTEST_CHECK( OsalPort_MSG_REF( pMsg ) == OsalPort_MSG_REF_CNT_MASK );
+  ZTEST_CHECK( heapLive == x );
+
+  OsalPort_msgDeallocate( pMsg );
+  drain();
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void testOutOfMemory( void )
+{
+  uint8_t *pMsg;
+
+  reset();
+
+  pMsg = sharedNew( 8 );
+
+  // The link, then the message holding the buffer can't be allocated
+  heapFailIn = 1;
+  ZTEST_CHECK( OsalPort_msgSendShared( 0, pMsg ) == OsalPort_MSG_BUFFER_NOT_AVAIL );
+  ZTEST_CHECK( OsalPort_MSG_REF( pMsg ) == 1 );
+  heapFailIn = 1;
+  ZTEST_CHECK( OsalPort_msgAllocateRef( sizeof( refMsg_t ), pMsg ) == NULL );
+  ZTEST_CHECK( OsalPort_MSG_REF( pMsg ) == 1 );
+
+  OsalPort_msgDeallocate( pMsg );
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void testRandomOrder( void )
+{
+  uint8_t *shared[SHARED_MAX];
+  uint8_t cnt;
+  uint8_t task;
+  uint16_t round;
+  uint16_t peak = 0;
+  uint8_t x;
+
+  reset();
+  seed = 0x5EED;
+
+  for ( round = 0; round < ROUNDS; round++ )
+  {
+    // Several buffers in flight at once, each to a random set of
+    // consumers, shared, through messages holding it or both
+    cnt = (uint8_t)(1 + rnd( SHARED_MAX ));
+    for ( x = 0; x < cnt; x++ )
+    {
+      shared[x] = sharedNew( (uint8_t)(1 + rnd( 100 )) );
+      for ( task = 0; task < CONSUMERS; task++ )
+      {
+        switch ( rnd( 4 ) )
+        {
+          case 0:
+            break;
+          case 1:
+            ZTEST_CHECK( OsalPort_msgSendShared( task, shared[x] ) == OsalPort_SUCCESS );
+            break;
+          case 2:
+            ZTEST_CHECK( refSend( task, shared[x] ) );
+            break;
+          default:
+            ZTEST_CHECK( OsalPort_msgSendShared( task, shared[x] ) == OsalPort_SUCCESS );
+            ZTEST_CHECK( refSend( task, shared[x] ) );
+            break;
+        }
+      }
+
+      // Now and then a consumer runs before the producer is done
+      if ( rnd( 3 ) == 0 )
+      {
+        task = (uint8_t)rnd( CONSUMERS );
+        if ( taskTbl[task].qHandle != NULL )
+        {
+          consume( OsalPort_msgReceive( task ) );
+        }
+      }
+    }
+
+    if ( heapLive > peak )
+    {
+      peak = heapLive;
+    }
+
+    // The producer lets go in a random order
+    for ( x = cnt; x > 0; x-- )
+    {
+      task = (uint8_t)rnd( x );
+      ZTEST_CHECK( OsalPort_msgDeallocate( shared[task] ) == OsalPort_SUCCESS );
+      shared[task] = shared[x - 1];
+    }
+
+    drain();
+    ZTEST_CHECK( heapLive == 0 );
+  }
+
+  printf( "%u rounds, up to %u blocks live\n", ROUNDS, peak );
+  for ( task = 0; task < CONSUMERS; task++ )
+  {
+    ZTEST_CHECK( queued( task ) == 0 );
+  }
+}
+
+int main( void )
+{
+  ZTEST_RUN( testSingle );
+  ZTEST_RUN( testCount );
+  ZTEST_RUN( testShared );
+  ZTEST_RUN( testAttached );
+  ZTEST_RUN( testSaturated );
+  ZTEST_RUN( testOutOfMemory );
+  ZTEST_RUN( testRandomOrder );
+
+  return ( ZTEST_RESULT );
+}
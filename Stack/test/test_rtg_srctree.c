@@ -0,0 +1,332 @@
+/**************************************************************************************************
+  Filename:       test_rtg_srctree.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the shared source route relay store:
+                  insertion, eviction, re-parenting, the destination
+                  index and the delivery checks.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "rtg_srctree.h"
+#include "rtg.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+uint32_t ztestClock = 0;
+uint8_t gMAX_SOURCE_ROUTE = MAX_SOURCE_ROUTE;
+
+static uint8_t srcTableHit = FALSE;
+static uint16_t srcTableDst = INVALID_NODE_ADDR;
+static uint8_t srcTableCnt = 0;
+
+RTG_Status_t RTG_GetRtgSrcEntry( uint16_t dstAddr, uint8_t* pRelayCnt, uint16_t** ppRelayList )
+{
+  (void)pRelayCnt;
+  (void)ppRelayList;
+  return ( (srcTableHit && (dstAddr == srcTableDst)) ? RTG_SUCCESS : RTG_FAIL );
+}
+
+RTG_Status_t RTG_AddSrcRtgEntry_Guaranteed( uint16_t srcAddr, uint8_t relayCnt, uint16_t* pRelayList )
+{
+  (void)pRelayList;
+  srcTableDst = srcAddr;
+  srcTableCnt = relayCnt;
+  return ( RTG_SUCCESS );
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+static int routeIs( uint16_t dstAddr, uint8_t cnt, const uint16_t *pExp )
+{
+  uint16_t list[MAX_SOURCE_ROUTE];
+  uint8_t got = 0xFF;
+  uint8_t i;
+
+  if ( RTG_SrcTreeGet( dstAddr, &got, list ) == FALSE )
+  {
+    return ( 0 );
+  }
+
+  if ( got != cnt )
+  {
+    return ( 0 );
+  }
+
+  for ( i = 0; i < cnt; i++ )
+  {
+    if ( list[i] != pExp[i] )
+    {
+      return ( 0 );
+    }
+  }
+
+  return ( 1 );
+}
+
+static int routeGone( uint16_t dstAddr )
+{
+  uint16_t list[MAX_SOURCE_ROUTE];
+  uint8_t cnt;
+
+  return ( RTG_SrcTreeGet( dstAddr, &cnt, list ) == FALSE );
+}
+
+static void reset( void )
+{
+  ztestClock = 0;
+  srcTableHit = FALSE;
+  srcTableDst = INVALID_NODE_ADDR;
+  RTG_SrcTreeInit();
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testInsertShared( void )
+{
+  uint16_t a[] = { 0x0010, 0x0020, 0x0030 };
+  uint16_t b[] = { 0x0011, 0x0020, 0x0030 };
+  uint16_t c[] = { 0x0030 };
+
+  reset();
+
+  // Four relays fill RTG_SRC_TREE_NODES, the shared ones are kept once
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 3, a ) == ZSuccess );
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0002, 3, b ) == ZSuccess );
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0003, 1, c ) == ZSuccess );
+  ZTEST_CHECK( routeIs( 0x0001, 3, a ) );
+  ZTEST_CHECK( routeIs( 0x0002, 3, b ) );
+  ZTEST_CHECK( routeIs( 0x0003, 1, c ) );
+
+  // A direct route holds no relay
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0004, 0, NULL ) == ZSuccess );
+  ZTEST_CHECK( routeIs( 0x0004, 0, NULL ) );
+
+  ZTEST_CHECK( routeGone( 0x0005 ) );
+}
+
+static void testInsertInvalid( void )
+{
+  uint16_t loop[] = { 0x0010, 0x0020, 0x0010 };
+  uint16_t self[] = { 0x0010, 0x0001 };
+  uint16_t relay[] = { 0x0010 };
+
+  reset();
+
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 3, loop ) == ZInvalidParameter );
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 2, self ) == ZInvalidParameter );
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, MAX_SOURCE_ROUTE + 1, loop ) == ZInvalidParameter );
+  ZTEST_CHECK( RTG_SrcTreeAdd( INVALID_NODE_ADDR, 1, relay ) == ZInvalidParameter );
+  ZTEST_CHECK( routeGone( 0x0001 ) );
+  ZTEST_CHECK( routeGone( INVALID_NODE_ADDR ) );
+}
+
+static void testReparent( void )
+{
+  uint16_t a[] = { 0x0010, 0x0020, 0x0030 };
+  uint16_t b[] = { 0x0020, 0x0030 };
+  uint16_t moved[] = { 0x0040 };
+  uint16_t a2[] = { 0x0010, 0x0020, 0x0040 };
+  uint16_t b2[] = { 0x0020, 0x0040 };
+  uint16_t up[] = { 0x0050 };
+  uint16_t a3[] = { 0x0010, 0x0020, 0x0050 };
+  uint16_t b3[] = { 0x0020, 0x0050 };
+  uint16_t direct[] = { 0x0010 };
+  uint16_t b4[] = { 0x0020 };
+
+  reset();
+
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 3, a ) == ZSuccess );
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0002, 2, b ) == ZSuccess );
+
+  // A record of relay 0x0020 moves every route through it
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0020, 1, moved ) == ZSuccess );
+  ZTEST_CHECK( routeIs( 0x0001, 3, a2 ) );
+  ZTEST_CHECK( routeIs( 0x0002, 2, b2 ) );
+  ZTEST_CHECK( routeIs( 0x0020, 1, moved ) );
+
+  // Relay 0x0030 is no longer used, so there is room for another one
+  // without evicting a route
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0020, 1, up ) == ZSuccess );
+  ZTEST_CHECK( routeIs( 0x0001, 3, a3 ) );
+  ZTEST_CHECK( routeIs( 0x0002, 2, b3 ) );
+
+  // A destination relaying others takes them onto its new path, and a
+  // relay of a shorter record leaves the path it had
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0020, 0, NULL ) == ZSuccess );
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 1, direct ) == ZSuccess );
+  ZTEST_CHECK( routeIs( 0x0001, 1, direct ) );
+  ZTEST_CHECK( routeIs( 0x0002, 1, b4 ) );
+}
+
+static void testEvictOldest( void )
+{
+  uint16_t a[] = { 0x0010, 0x0020 };
+  uint16_t b[] = { 0x0030, 0x0040 };
+  uint16_t c[] = { 0x0050 };
+
+  reset();
+
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 2, a ) == ZSuccess );
+  ztestClock = 5000;
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0002, 2, b ) == ZSuccess );
+
+  // Out of relays, the route with the oldest record goes
+  ztestClock = 9000;
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0003, 1, c ) == ZSuccess );
+  ZTEST_CHECK( routeGone( 0x0001 ) );
+  ZTEST_CHECK( routeIs( 0x0002, 2, b ) );
+  ZTEST_CHECK( routeIs( 0x0003, 1, c ) );
+}
+
+static void testEvictDsts( void )
+{
+  uint16_t relay[] = { 0x0010 };
+  uint16_t x;
+
+  reset();
+
+  // Fill every destination entry, one second apart
+  for ( x = 0; x < RTG_SRC_TREE_DSTS; x++ )
+  {
+    ztestClock = x * 1000;
+    ZTEST_CHECK( RTG_SrcTreeAdd( 0x0100 + x, 1, relay ) == ZSuccess );
+  }
+
+  ztestClock = RTG_SRC_TREE_DSTS * 1000;
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0200, 1, relay ) == ZSuccess );
+  ZTEST_CHECK( routeGone( 0x0100 ) );
+  ZTEST_CHECK( routeIs( 0x0101, 1, relay ) );
+  ZTEST_CHECK( routeIs( 0x0200, 1, relay ) );
+}
+
+static void testExpiry( void )
+{
+  uint16_t a[] = { 0x0010 };
+  uint16_t b[] = { 0x0020, 0x0030, 0x0040 };
+
+  reset();
+
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 1, a ) == ZSuccess );
+  ztestClock = (uint32_t)(RTG_SRC_TREE_EXPIRY + 1) * 1000;
+  ZTEST_CHECK( routeGone( 0x0001 ) );
+
+  // Expired routes are freed before live ones when making room
+  reset();
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 1, a ) == ZSuccess );
+  ztestClock = (uint32_t)(RTG_SRC_TREE_EXPIRY + 1) * 1000;
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0002, 3, b ) == ZSuccess );
+  ZTEST_CHECK( routeIs( 0x0002, 3, b ) );
+}
+
+static void testIndexChains( void )
+{
+  uint16_t relay[] = { 0x0010 };
+  uint16_t addr[4];
+  uint8_t i;
+
+  reset();
+
+  // Addresses of the same bucket
+  for ( i = 0; i < 4; i++ )
+  {
+    addr[i] = (uint16_t)( 0x0005 + (i * RTG_SRC_TREE_HASH_SIZE * 128) );
+    ZTEST_CHECK( RTG_SrcTreeAdd( addr[i], 1, relay ) == ZSuccess );
+  }
+
+  // Take one out of the middle of the chain
+  RTG_SrcTreeRemove( addr[1] );
+  ZTEST_CHECK( routeGone( addr[1] ) );
+  ZTEST_CHECK( routeIs( addr[0], 1, relay ) );
+  ZTEST_CHECK( routeIs( addr[2], 1, relay ) );
+  ZTEST_CHECK( routeIs( addr[3], 1, relay ) );
+
+  // Its entry is used again
+  ZTEST_CHECK( RTG_SrcTreeAdd( addr[1], 0, NULL ) == ZSuccess );
+  ZTEST_CHECK( routeIs( addr[1], 0, NULL ) );
+
+  // Removing what isn't there leaves the rest
+  RTG_SrcTreeRemove( 0x7777 );
+  RTG_SrcTreeRemove( INVALID_NODE_ADDR );
+  ZTEST_CHECK( routeIs( addr[3], 1, relay ) );
+}
+
+static void testDeliveryCheck( void )
+{
+  uint16_t a[] = { 0x0010 };
+
+  reset();
+
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 1, a ) == ZSuccess );
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0002, 1, a ) == ZSuccess );
+
+  // Delivered, the route stays
+  RTG_SrcTreeSent( 0x0001, 8, 0x40 );
+  RTG_SrcTreeConfirm( 8, 0x40, ZSuccess );
+  ZTEST_CHECK( routeIs( 0x0001, 1, a ) );
+
+  // Not delivered, the route goes
+  RTG_SrcTreeSent( 0x0001, 8, 0x41 );
+  RTG_SrcTreeSent( 0x0002, 8, 0x42 );
+  RTG_SrcTreeConfirm( 8, 0x41, ZApsNoAck );
+  ZTEST_CHECK( routeGone( 0x0001 ) );
+  ZTEST_CHECK( routeIs( 0x0002, 1, a ) );
+
+  // Confirms of frames not waited for are ignored
+  RTG_SrcTreeConfirm( 9, 0x42, ZApsNoAck );
+  RTG_SrcTreeConfirm( 8, 0x41, ZApsNoAck );
+  ZTEST_CHECK( routeIs( 0x0002, 1, a ) );
+
+  // The oldest frame waited for is given up when there is no room
+  RTG_SrcTreeSent( 0x0003, 8, 0x50 );
+  RTG_SrcTreeSent( 0x0002, 8, 0x51 );
+  RTG_SrcTreeSent( 0x0002, 8, 0x52 );
+  RTG_SrcTreeSent( 0x0002, 8, 0x53 );
+  RTG_SrcTreeSent( 0x0002, 8, 0x54 );
+  RTG_SrcTreeSent( 0x0002, 8, 0x55 );
+  RTG_SrcTreeConfirm( 8, 0x51, ZApsNoAck );
+  ZTEST_CHECK( routeIs( 0x0002, 1, a ) );
+  RTG_SrcTreeConfirm( 8, 0x55, ZApsNoAck );
+  ZTEST_CHECK( routeGone( 0x0002 ) );
+}
+
+static void testRestore( void )
+{
+  uint16_t a[] = { 0x0010, 0x0020 };
+
+  reset();
+
+  ZTEST_CHECK( RTG_SrcTreeRestore( 0x0001 ) == FALSE );
+
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0001, 2, a ) == ZSuccess );
+  ZTEST_CHECK( RTG_SrcTreeRestore( 0x0001 ) == TRUE );
+  ZTEST_CHECK( (srcTableDst == 0x0001) && (srcTableCnt == 2) );
+
+  // Still in the source route table, nothing to put back
+  srcTableHit = TRUE;
+  ZTEST_CHECK( RTG_SrcTreeRestore( 0x0001 ) == FALSE );
+
+  // A direct route is not put in the source route table
+  srcTableHit = FALSE;
+  ZTEST_CHECK( RTG_SrcTreeAdd( 0x0002, 0, NULL ) == ZSuccess );
+  ZTEST_CHECK( RTG_SrcTreeRestore( 0x0002 ) == FALSE );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testInsertShared );
+  ZTEST_RUN( testInsertInvalid );
+  ZTEST_RUN( testReparent );
+  ZTEST_RUN( testEvictOldest );
+  ZTEST_RUN( testEvictDsts );
+  ZTEST_RUN( testExpiry );
+  ZTEST_RUN( testIndexChains );
+  ZTEST_RUN( testDeliveryCheck );
+  ZTEST_RUN( testRestore );
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,534 @@
+/**************************************************************************************************
+  Filename:       test_stack_sched.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host harness of the stack task scheduler: a synthetic
+                  MT command flood from the host runs alongside periodic
+                  MAC events on a simulated clock, through stackTaskRun()
+                  with MT_ProcessEvent() as the MT service function.  The
+                  MAC event latency, the MAC queue drops and the wait of
+                  a low priority service function are measured against
+                  the first-ready scheduler with the unbudgeted MT drain
+                  it replaced.  The run-time accounting is checked
+                  against the passes the harness counted.
+**************************************************************************************************/
+
+#include <stdio.h>
+
+#include "ztest.h"
+#include "comdef.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define SYS_EVENT_MSG                       0x8000
+#define NWK_DATA_EVT                        0x0001
+#define ZDO_TIMER_EVT                       0x0001
+
+// Simulated clock, one tick is 10 us as on the device
+static const uint32_t Clock_tickPeriod = 10;
+static uint32_t simTicks;
+
+static uint32_t Clock_getTicks( void )
+{
+  return ( simTicks );
+}
+
+uint32_t OsalPort_enterCS( void )
+{
+  return ( 0 );
+}
+
+void OsalPort_leaveCS( uint32_t key )
+{
+  (void)key;
+}
+
+// Service function costs and the traffic profile, in ticks
+#define MAC_EVT_TICKS                       5
+#define NWK_EVT_TICKS                       5
+#define ZDO_EVT_TICKS                       10
+#define MAC_Q_MAX                           8
+
+typedef struct
+{
+  uint16_t mtCmds;          // Commands the host writes at mtAt
+  uint32_t mtAt;
+  uint32_t mtCmdTicks;      // Cost of one command
+  uint32_t macPeriod;       // One MAC event per period, none if 0
+  uint32_t zdoPeriod;       // One ZDO timer event per period, none if 0
+  uint32_t endTicks;
+} simProfile_t;
+
+typedef struct
+{
+  uint32_t passes;
+  uint32_t mtDone;
+  uint32_t macArrived;
+  uint32_t macDone;
+  uint32_t macDrops;
+  uint32_t macMaxLatency;
+  uint32_t macSumLatency;
+  uint32_t zdoDone;
+  uint32_t zdoMaxWait;
+} simResult_t;
+
+static simResult_t sim;
+
+// Service function event words, as registered with OsalPort
+static uint32_t mtEvents;
+static uint32_t macEvents;
+static uint32_t nwkEvents;
+static uint32_t zdoEvents;
+
+// MT: the host commands queued on the MT task
+typedef struct
+{
+  uint8_t cmd;
+} mtOSALSerialData_t;
+
+uint8_t MT_TaskID = 0;
+static mtOSALSerialData_t mtMsg;
+static uint16_t mtQueued;
+static uint32_t mtCmdTicks;
+
+uint8_t *OsalPort_msgReceive( uint8_t taskId )
+{
+  (void)taskId;
+
+  if ( mtQueued == 0 )
+  {
+    mtEvents &= ~SYS_EVENT_MSG;
+    return ( NULL );
+  }
+
+  // As osal_port.c: the message event stays set while messages are left
+  if ( --mtQueued )
+  {
+    mtEvents |= SYS_EVENT_MSG;
+  }
+  else
+  {
+    mtEvents &= ~SYS_EVENT_MSG;
+  }
+  return ( (uint8_t *)&mtMsg );
+}
+
+uint8_t OsalPort_msgDeallocate( uint8_t *pMsg )
+{
+  (void)pMsg;
+  return ( 0 );
+}
+
+void MT_ProcessIncomingCommand( mtOSALSerialData_t *pMsg )
+{
+  (void)pMsg;
+  simTicks += mtCmdTicks;
+  sim.mtDone++;
+}
+
+void MT_Init( void )
+{
+}
+
+void MT_AfExec( void )
+{
+}
+
+void MT_AfTxClassExec( void )
+{
+}
+
+uint32_t MT_ProcessEvent( uint8_t task_id, uint32_t events );
+
+// MAC: one event off the queue per call, each one hands a frame to NWK
+static uint32_t macQueue[MAC_Q_MAX];
+static uint8_t macHead;
+static uint8_t macCnt;
+
+static uint32_t ZMacEventLoop( uint8_t task_id, uint32_t events )
+{
+  uint32_t latency;
+
+  (void)task_id;
+
+  if ( macCnt == 0 )
+  {
+    return ( 0 );
+  }
+
+  latency = simTicks - macQueue[macHead];
+  if ( latency > sim.macMaxLatency )
+  {
+    sim.macMaxLatency = latency;
+  }
+  sim.macSumLatency += latency;
+  sim.macDone++;
+  macHead = (macHead + 1) % MAC_Q_MAX;
+  macCnt--;
+
+  simTicks += MAC_EVT_TICKS;
+  nwkEvents |= NWK_DATA_EVT;
+
+  return ( macCnt ? events : 0 );
+}
+
+static uint32_t nwk_event_loop( uint8_t task_id, uint32_t events )
+{
+  (void)task_id;
+  simTicks += NWK_EVT_TICKS;
+  return ( events ^ NWK_DATA_EVT );
+}
+
+// Lowest priority: a ZDO timer, waits counted from its arrival
+static uint32_t zdoArrival;
+
+static uint32_t ZDApp_event_loop( uint8_t task_id, uint32_t events )
+{
+  (void)task_id;
+  if ( simTicks - zdoArrival > sim.zdoMaxWait )
+  {
+    sim.zdoMaxWait = simTicks - zdoArrival;
+  }
+  sim.zdoDone++;
+  simTicks += ZDO_EVT_TICKS;
+  return ( events ^ ZDO_TIMER_EVT );
+}
+
+uint32_t (* const zstackTasksArr[])( uint8_t task_id, uint32_t event ) =
+{
+  MT_ProcessEvent,
+  ZMacEventLoop,
+  nwk_event_loop,
+  ZDApp_event_loop
+};
+
+#include "test_stack_sched_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+
+// The scheduler stackTaskRun() replaced: the first ready service
+// function runs, MT drains its whole queue in one call
+static uint32_t legacyMtProcessEvent( uint8_t task_id, uint32_t events )
+{
+  mtOSALSerialData_t *pMsg;
+
+  (void)task_id;
+
+  if ( events & SYS_EVENT_MSG )
+  {
+    while ((pMsg = (mtOSALSerialData_t *) OsalPort_msgReceive(MT_TaskID)) != NULL)
+    {
+      MT_ProcessIncomingCommand(pMsg);
+      OsalPort_msgDeallocate((uint8_t *)pMsg);
+    }
+    return (events ^ SYS_EVENT_MSG);
+  }
+  return ( 0 );
+}
+
+static void legacyTaskRun( void )
+{
+  uint32_t events;
+  uint8_t idx;
+
+  for ( idx = 0; idx < zstackTasksCnt; idx++ )
+  {
+    if ( *(pTasksEvents[idx]) )
+    {
+      break;
+    }
+  }
+
+  if ( idx < zstackTasksCnt )
+  {
+    events = *(pTasksEvents[idx]);
+    *(pTasksEvents[idx]) = 0;
+
+    if ( idx == 0 )
+    {
+      events = legacyMtProcessEvent( 0U, events );
+    }
+    else
+    {
+      events = (zstackTasksArr[idx])( 0U, events );
+    }
+
+    *(pTasksEvents[idx]) |= events;
+  }
+}
+
+static uint32_t *simEvents[] = { &mtEvents, &macEvents, &nwkEvents, &zdoEvents };
+
+static void simReset( void )
+{
+  memset( &sim, 0, sizeof( sim ) );
+  simTicks = 0;
+  mtEvents = macEvents = nwkEvents = zdoEvents = 0;
+  mtQueued = 0;
+  mtCmdTicks = 0;
+  macHead = macCnt = 0;
+  zdoArrival = 0;
+
+  pTasksEvents = simEvents;
+  stackTask_clearTaskStats();
+  memset( stackTaskReady, 0, sizeof( stackTaskReady ) );
+  memset( stackTaskYielded, 0, sizeof( stackTaskYielded ) );
+  stackTaskLastIdx = STACK_TASK_NONE;
+  stackTaskRunStreak = 0;
+}
+
+// Time driven run: the host commands and the MAC and ZDO events arrive
+// on their schedule, between passes as from an interrupt, and the stack
+// task runs a pass whenever a service function is ready
+static void simRun( const simProfile_t *pProf, void (*pfnPass)( void ) )
+{
+  uint32_t macNext = pProf->macPeriod;
+  uint32_t zdoNext = pProf->zdoPeriod;
+  uint8_t mtPending = (pProf->mtCmds != 0);
+
+  simReset();
+  mtCmdTicks = pProf->mtCmdTicks;
+
+  while ( simTicks < pProf->endTicks )
+  {
+    uint32_t next = pProf->endTicks;
+
+    if ( mtPending && (simTicks >= pProf->mtAt) )
+    {
+      mtPending = FALSE;
+      mtQueued += pProf->mtCmds;
+      mtEvents |= SYS_EVENT_MSG;
+    }
+
+    while ( pProf->macPeriod && (simTicks >= macNext) )
+    {
+      sim.macArrived++;
+      if ( macCnt == MAC_Q_MAX )
+      {
+        sim.macDrops++;
+      }
+      else
+      {
+        macQueue[(macHead + macCnt) % MAC_Q_MAX] = macNext;
+        macCnt++;
+        macEvents |= SYS_EVENT_MSG;
+      }
+      macNext += pProf->macPeriod;
+    }
+
+    while ( pProf->zdoPeriod && (simTicks >= zdoNext) )
+    {
+      if ( (zdoEvents & ZDO_TIMER_EVT) == 0 )
+      {
+        zdoArrival = zdoNext;
+      }
+      zdoEvents |= ZDO_TIMER_EVT;
+      zdoNext += pProf->zdoPeriod;
+    }
+
+    if ( mtEvents || macEvents || nwkEvents || zdoEvents )
+    {
+      sim.passes++;
+      pfnPass();
+      continue;
+    }
+
+    // Idle until the next arrival
+    if ( mtPending && (pProf->mtAt < next) )
+    {
+      next = pProf->mtAt;
+    }
+    if ( pProf->macPeriod && (macNext < next) )
+    {
+      next = macNext;
+    }
+    if ( pProf->zdoPeriod && (zdoNext < next) )
+    {
+      next = zdoNext;
+    }
+    simTicks = next;
+  }
+}
+
+static void simPrint( const char *pName, const simResult_t *pRes )
+{
+  printf( "  %-8s MT %4u cmds, MAC %3u/%3u events %2u dropped, latency max %4u avg %4u ticks, "
+          "ZDO %2u events max wait %4u ticks\n",
+          pName, (unsigned)pRes->mtDone, (unsigned)pRes->macDone, (unsigned)pRes->macArrived,
+          (unsigned)pRes->macDrops, (unsigned)pRes->macMaxLatency,
+          (unsigned)(pRes->macDone ? pRes->macSumLatency / pRes->macDone : 0),
+          (unsigned)pRes->zdoDone, (unsigned)pRes->zdoMaxWait );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+
+// A host flood of 400 commands of 250 us, 100 ms of MT work, with a MAC
+// event every 2 ms and a ZDO timer every 5 ms
+static const simProfile_t floodProfile = { 400, 1000, 25, 200, 500, 20000 };
+
+static void testFloodMacLatency( void )
+{
+  simResult_t legacy, budget;
+  uint32_t starveTicks = (STACK_TASK_STARVE_MS * 1000) / Clock_tickPeriod;
+  uint32_t mtTurn = STACK_TASK_RUN_BUDGET * MT_MSG_BUDGET * floodProfile.mtCmdTicks;
+
+  simRun( &floodProfile, legacyTaskRun );
+  legacy = sim;
+  simRun( &floodProfile, stackTaskRun );
+  budget = sim;
+
+  printf( "  MT flood of %u commands with a MAC event every %u ticks:\n",
+          floodProfile.mtCmds, (unsigned)floodProfile.macPeriod );
+  simPrint( "legacy", &legacy );
+  simPrint( "budget", &budget );
+
+  // Every command and every MAC event the queue took is processed
+  ZTEST_CHECK( legacy.mtDone == floodProfile.mtCmds );
+  ZTEST_CHECK( budget.mtDone == floodProfile.mtCmds );
+  ZTEST_CHECK( legacy.macDone + legacy.macDrops == legacy.macArrived );
+  ZTEST_CHECK( budget.macDone + budget.macDrops == budget.macArrived );
+
+  // The unbudgeted drain holds MAC off for the whole flood
+  ZTEST_CHECK( legacy.macDrops > 0 );
+  ZTEST_CHECK( legacy.macMaxLatency >= floodProfile.mtCmds * floodProfile.mtCmdTicks / 2 );
+
+  // With the budgets MAC keeps up: no drops, latency bounded by a turn of
+  // MT and the MAC queue ahead of it
+  ZTEST_CHECK( budget.macDrops == 0 );
+  ZTEST_CHECK( budget.macMaxLatency <= mtTurn + MAC_Q_MAX * (MAC_EVT_TICKS + NWK_EVT_TICKS) );
+  ZTEST_CHECK( budget.zdoMaxWait <= mtTurn + 2 * (MAC_EVT_TICKS + NWK_EVT_TICKS) );
+  ZTEST_CHECK( budget.zdoMaxWait < starveTicks );
+}
+
+// Past what a round of the run budget carries: a MAC event every 1 ms
+// outruns four MAC events per 4 ms turn of MT, the budget only limits the
+// drops
+static void testFloodMacOverload( void )
+{
+  static const simProfile_t overloadProfile = { 400, 1000, 25, 100, 500, 20000 };
+  simResult_t legacy, budget;
+
+  simRun( &overloadProfile, legacyTaskRun );
+  legacy = sim;
+  simRun( &overloadProfile, stackTaskRun );
+  budget = sim;
+
+  printf( "  MT flood of %u commands with a MAC event every %u ticks:\n",
+          overloadProfile.mtCmds, (unsigned)overloadProfile.macPeriod );
+  simPrint( "legacy", &legacy );
+  simPrint( "budget", &budget );
+
+  ZTEST_CHECK( budget.mtDone == overloadProfile.mtCmds );
+  ZTEST_CHECK( budget.macDrops * 10 < legacy.macDrops );
+  ZTEST_CHECK( budget.macMaxLatency * 10 < legacy.macMaxLatency );
+}
+
+static void testIdleMacLatency( void )
+{
+  static const simProfile_t idleProfile = { 0, 0, 0, 100, 500, 20000 };
+  simResult_t legacy, budget;
+
+  simRun( &idleProfile, legacyTaskRun );
+  legacy = sim;
+  simRun( &idleProfile, stackTaskRun );
+  budget = sim;
+
+  // Without a flood both schedulers run MAC as soon as it arrives
+  ZTEST_CHECK( legacy.macMaxLatency == 0 );
+  ZTEST_CHECK( budget.macMaxLatency == 0 );
+  ZTEST_CHECK( budget.macDone == budget.macArrived );
+  ZTEST_CHECK( budget.passes == legacy.passes );
+}
+
+static void testTaskStats( void )
+{
+  stackTaskStats_t stats;
+  uint32_t runs = 0;
+  uint16_t yields = 0;
+  uint16_t boosts = 0;
+  uint8_t idx;
+
+  simRun( &floodProfile, stackTaskRun );
+
+  ZTEST_CHECK( stackTask_getTaskCnt() == zstackTasksCnt );
+  ZTEST_CHECK( stackTask_getTaskStats( zstackTasksCnt, &stats ) == FALSE );
+
+  for ( idx = 0; idx < zstackTasksCnt; idx++ )
+  {
+    ZTEST_CHECK( stackTask_getTaskStats( idx, &stats ) == TRUE );
+    ZTEST_CHECK( stats.maxRunTicks <= stats.runTicks );
+    runs += stats.runCnt;
+    yields += stats.yieldCnt;
+    boosts += stats.boostCnt;
+  }
+
+  // Every pass ran one service function, MT yielded during the flood
+  // and nobody waited long enough for a boost
+  ZTEST_CHECK( runs == sim.passes );
+  ZTEST_CHECK( boosts == 0 );
+  ZTEST_CHECK( stackTask_getTaskStats( 0, &stats ) == TRUE );
+  ZTEST_CHECK( stats.runCnt == floodProfile.mtCmds / MT_MSG_BUDGET );
+  ZTEST_CHECK( stats.runTicks == floodProfile.mtCmds * floodProfile.mtCmdTicks );
+  ZTEST_CHECK( stats.maxRunTicks == MT_MSG_BUDGET * floodProfile.mtCmdTicks );
+  ZTEST_CHECK( stats.yieldCnt > 0 );
+  ZTEST_CHECK( stats.yieldCnt == yields );
+  ZTEST_CHECK( stackTask_getTaskStats( 1, &stats ) == TRUE );
+  ZTEST_CHECK( stats.runCnt == sim.macDone );
+  ZTEST_CHECK( stackTask_getTaskStats( 3, &stats ) == TRUE );
+  ZTEST_CHECK( stats.runCnt == sim.zdoDone );
+
+  stackTask_clearTaskStats();
+  for ( idx = 0; idx < zstackTasksCnt; idx++ )
+  {
+    ZTEST_CHECK( stackTask_getTaskStats( idx, &stats ) == TRUE );
+    ZTEST_CHECK( stats.runCnt == 0 );
+    ZTEST_CHECK( stats.maxWaitTicks == 0 );
+  }
+}
+
+// Commands of 2 ms: a turn of MT outlasts STACK_TASK_STARVE_MS, the
+// ones waiting behind it are boosted ahead of it
+static void testStarveBoost( void )
+{
+  static const simProfile_t slowProfile = { 200, 0, 200, 1000, 500, 60000 };
+  uint32_t starveTicks = (STACK_TASK_STARVE_MS * 1000) / Clock_tickPeriod;
+  stackTaskStats_t stats;
+  uint16_t boosts = 0;
+  uint8_t idx;
+
+  simRun( &slowProfile, stackTaskRun );
+  printf( "  MT flood of %u commands of %u ticks:\n",
+          slowProfile.mtCmds, (unsigned)slowProfile.mtCmdTicks );
+  simPrint( "budget", &sim );
+
+  ZTEST_CHECK( sim.mtDone == slowProfile.mtCmds );
+  ZTEST_CHECK( sim.macDrops == 0 );
+  for ( idx = 0; idx < zstackTasksCnt; idx++ )
+  {
+    ZTEST_CHECK( stackTask_getTaskStats( idx, &stats ) == TRUE );
+    boosts += stats.boostCnt;
+
+    // Waits end at the first pass past the limit, or behind the others
+    // boosted in that pass
+    ZTEST_CHECK( stats.maxWaitTicks < starveTicks + MT_MSG_BUDGET * slowProfile.mtCmdTicks +
+                                      zstackTasksCnt * (MAC_EVT_TICKS + NWK_EVT_TICKS + ZDO_EVT_TICKS) );
+  }
+  ZTEST_CHECK( boosts > 0 );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testFloodMacLatency );
+  ZTEST_RUN( testFloodMacOverload );
+  ZTEST_RUN( testIdleMacLatency );
+  ZTEST_RUN( testTaskStats );
+  ZTEST_RUN( testStarveBoost );
+
+  return ( ZTEST_RESULT );
+}
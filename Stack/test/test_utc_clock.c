@@ -0,0 +1,247 @@
+/**************************************************************************************************
+  Filename:       test_utc_clock.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the UTC clock discipline: stepping, the
+                  bounded slew and the drift estimate.  The module keeps
+                  its state between cases, each starts with a step.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include <ti/drivers/dpl/ClockP.h>
+#include "comdef.h"
+#include "utc_clock.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define TICK_US   10      // Microseconds per system tick
+
+uint32_t ztestTicks = 0;
+uint32_t ztestTickPeriod = TICK_US;
+ClockP_Fxn ztestClockFxn = NULL;
+
+/*********************************************************************
+ * HELPERS
+ */
+// Time kept by the host, in milliseconds since 1 January 2000
+static uint64_t hostMs = 0;
+
+// Let ms of local time pass, in steps of the clock period
+static void runMs( uint32_t ms, uint32_t step )
+{
+  UTCTime prev = UTC_getClock();
+
+  while ( ms )
+  {
+    uint32_t n = (ms < step) ? ms : step;
+
+    ztestTicks += n * (1000 / TICK_US);
+    ztestClockFxn( 0 );
+    ms -= n;
+
+    ZTEST_CHECK( UTC_getClock() >= prev );
+    prev = UTC_getClock();
+  }
+}
+
+static uint8_t sync( void )
+{
+  return ( UTC_discipline( (UTCTime)(hostMs / 1000), (uint16_t)(hostMs % 1000) ) );
+}
+
+// Step the clock to the host time, a new drift reference
+static void stepTo( uint64_t ms )
+{
+  hostMs = ms;
+  ZTEST_CHECK( sync() == UTC_SYNC_STEP );
+  ZTEST_CHECK( UTC_getClock() == (UTCTime)(ms / 1000) );
+}
+
+static UTCDiscipline disc( void )
+{
+  UTCDiscipline state;
+
+  UTC_getDiscipline( &state );
+
+  return ( state );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testInit( void )
+{
+  UTC_init();
+  ZTEST_CHECK( ztestClockFxn != NULL );
+  ZTEST_CHECK( disc().set == FALSE );
+
+  runMs( 1000, 1000 );
+  ZTEST_CHECK( UTC_getClock() == 1 );
+
+  // Not set yet, the first sync point steps whatever the offset
+  hostMs = 1000;
+  ZTEST_CHECK( sync() == UTC_SYNC_STEP );
+  ZTEST_CHECK( disc().set == TRUE );
+  ZTEST_CHECK( disc().offsetMSec == 0 );
+  ZTEST_CHECK( disc().driftPpm == 0 );
+}
+
+static void testStep( void )
+{
+  const uint64_t base = 100000000ULL;
+
+  stepTo( base );
+
+  // Just above the threshold
+  runMs( 1000, 1000 );
+  hostMs = base + 1000 + UTC_STEP_THRESHOLD + 1;
+  ZTEST_CHECK( sync() == UTC_SYNC_STEP );
+  ZTEST_CHECK( disc().offsetMSec == UTC_STEP_THRESHOLD + 1 );
+  ZTEST_CHECK( disc().lastSetTime == (UTCTime)(hostMs / 1000) );
+  ZTEST_CHECK( UTC_getClock() == (UTCTime)(hostMs / 1000) );
+
+  // At the threshold
+  runMs( 1000, 1000 );
+  hostMs += 1000 + UTC_STEP_THRESHOLD;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().slewMSec == UTC_STEP_THRESHOLD );
+  ZTEST_CHECK( UTC_getClock() == (UTCTime)((hostMs - UTC_STEP_THRESHOLD) / 1000) );
+
+  // Behind by more than the threshold, the pending slew is dropped
+  hostMs -= UTC_STEP_THRESHOLD + UTC_STEP_THRESHOLD + 1;
+  ZTEST_CHECK( sync() == UTC_SYNC_STEP );
+  ZTEST_CHECK( disc().offsetMSec == -(UTC_STEP_THRESHOLD + 1) );
+  ZTEST_CHECK( disc().slewMSec == 0 );
+  ZTEST_CHECK( UTC_getClock() == (UTCTime)(hostMs / 1000) );
+}
+
+static void testSlew( void )
+{
+  const uint64_t base = 200000000ULL;
+
+  stepTo( base + 250 );
+
+  // Ahead by 500 ms, slewed out at 1/UTC_SLEW_DIV of the elapsed time
+  runMs( 10000, 1000 );
+  hostMs += 10000 + 500;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == 500 );
+  ZTEST_CHECK( disc().slewMSec == 500 );
+
+  runMs( 1000, 1000 );
+  ZTEST_CHECK( disc().slewMSec == 500 - 1000 / UTC_SLEW_DIV );
+  runMs( 100, 100 );
+  ZTEST_CHECK( disc().slewMSec == 500 - 1100 / UTC_SLEW_DIV );
+  runMs( 8900, 100 );
+  ZTEST_CHECK( disc().slewMSec == 0 );
+
+  hostMs += 10000;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == 0 );
+
+  // Behind by a second, the clock slows down but doesn't go back
+  hostMs -= 1000;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().slewMSec == -1000 );
+  runMs( 20000, 100 );
+  ZTEST_CHECK( disc().slewMSec == 0 );
+
+  hostMs += 20000;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == 0 );
+
+  // Less than UTC_DRIFT_MIN_INTERVAL since the step
+  ZTEST_CHECK( disc().driftPpm == 0 );
+}
+
+static void testSetClock( void )
+{
+  const uint64_t base = 300000000ULL;
+
+  stepTo( base );
+
+  UTC_setClock( (UTCTime)(base / 1000) + 1000 );
+  ZTEST_CHECK( UTC_getClock() == (UTCTime)(base / 1000) + 1000 );
+  ZTEST_CHECK( disc().lastSync == UTC_SYNC_STEP );
+  ZTEST_CHECK( disc().offsetMSec == 0 );
+  hostMs = base + 1000000;
+
+  // Not a drift reference, this offset doesn't feed the estimate
+  runMs( 60000, 1000 );
+  hostMs += 60000 - 1000;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == -1000 );
+  ZTEST_CHECK( disc().driftPpm == 0 );
+}
+
+static void testDrift( void )
+{
+  const uint64_t base = 400000000ULL;
+
+  // Local clock 200 ppm fast, 6 ms over 30 s
+  stepTo( base );
+  runMs( 30000, 1000 );
+  hostMs += 30000 - 6;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == -6 );
+  ZTEST_CHECK( disc().driftPpm == 0 );
+
+  // UTC_DRIFT_MIN_INTERVAL since the reference, halfway to -200 ppm
+  runMs( 30000, 1000 );
+  hostMs += 30000 - 6;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == -6 );
+  ZTEST_CHECK( disc().driftPpm == -100 );
+
+  // Corrected by 100 ppm, the error left moves it halfway again
+  runMs( 60000, 1000 );
+  hostMs += 60000 - 12;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == -6 );
+  ZTEST_CHECK( disc().driftPpm == -150 );
+
+  // Closer to the 200 ppm, half the error left
+  runMs( 60000, 1000 );
+  hostMs += 60000 - 12;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == -3 );
+  ZTEST_CHECK( disc().driftPpm == -175 );
+
+  // Steps restart the reference but keep the estimate
+  hostMs += 100000;
+  ZTEST_CHECK( sync() == UTC_SYNC_STEP );
+  ZTEST_CHECK( disc().driftPpm == -175 );
+}
+
+static void testDriftClamp( void )
+{
+  const uint64_t base = 500000000ULL;
+
+  stepTo( base );
+  runMs( 60000, 1000 );
+  hostMs += 60000 - 1900;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().driftPpm == -UTC_DRIFT_MAX_PPM );
+
+  // 500 ppm slow now, 30 ms lost over the minute
+  stepTo( base + 1000000 );
+  runMs( 60000, 1000 );
+  hostMs += 60000 + 1900;
+  ZTEST_CHECK( sync() == UTC_SYNC_SLEW );
+  ZTEST_CHECK( disc().offsetMSec == 1900 + (60000 * UTC_DRIFT_MAX_PPM) / 1000000 );
+  ZTEST_CHECK( disc().driftPpm == UTC_DRIFT_MAX_PPM );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testInit );
+  ZTEST_RUN( testStep );
+  ZTEST_RUN( testSlew );
+  ZTEST_RUN( testSetClock );
+  ZTEST_RUN( testDrift );
+  ZTEST_RUN( testDriftClamp );
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,476 @@
+/**************************************************************************************************
+  Filename:       test_utc_timesrv.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the Time cluster server: endpoint
+                  configuration, the Read Attributes responder and the
+                  Default Response rules.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include <ti/drivers/dpl/ClockP.h>
+#include "zcomdef.h"
+#include "af.h"
+#include "zd_app.h"
+#include "utc_clock.h"
+#include "utc_timesrv.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define EP_MAX    4
+
+uint32_t ztestTicks = 0;
+uint32_t ztestTickPeriod = 10;
+ClockP_Fxn ztestClockFxn = NULL;
+
+uint8_t ZDAppTaskID = 0;
+
+// AF endpoints
+static epList_t epList[EP_MAX];
+static uint8_t epRegFail = FALSE;
+static uint8_t epRegCnt = 0;
+
+// Last frame sent
+static uint8_t txBuf[128];
+static uint16_t txLen;
+static uint16_t txCnt;
+static afAddrType_t txDst;
+static uint16_t txCluster;
+static endPointDesc_t *txSrc;
+
+epList_t *afRegisterExtended( endPointDesc_t *epDesc, pDescCB descFn, pApplCB applFn )
+{
+  uint8_t i;
+
+  if ( epRegFail )
+  {
+    return ( NULL );
+  }
+
+  for ( i = 0; i < EP_MAX; i++ )
+  {
+    if ( epList[i].epDesc == NULL )
+    {
+      epList[i].epDesc = epDesc;
+      epList[i].pfnDescCB = descFn;
+      epList[i].pfnApplCB = applFn;
+      epList[i].pfnIncomingCB = NULL;
+      epRegCnt++;
+      return ( &epList[i] );
+    }
+  }
+
+  return ( NULL );
+}
+
+static epList_t *epFind( uint8_t endPoint )
+{
+  uint8_t i;
+
+  for ( i = 0; i < EP_MAX; i++ )
+  {
+    if ( (epList[i].epDesc != NULL) && (epList[i].epDesc->endPoint == endPoint) )
+    {
+      return ( &epList[i] );
+    }
+  }
+
+  return ( NULL );
+}
+
+afStatus_t afDelete( uint8_t EndPoint )
+{
+  epList_t *ep = epFind( EndPoint );
+
+  if ( ep == NULL )
+  {
+    return ( afStatus_INVALID_PARAMETER );
+  }
+
+  memset( ep, 0, sizeof( epList_t ) );
+
+  return ( afStatus_SUCCESS );
+}
+
+endPointDesc_t *afFindEndPointDesc( uint8_t endPoint )
+{
+  epList_t *ep = epFind( endPoint );
+
+  return ( (ep != NULL) ? ep->epDesc : NULL );
+}
+
+uint8_t afSetIncomingCB( uint8_t endPoint, pIncomingCB pIncomingFn )
+{
+  epList_t *ep = epFind( endPoint );
+
+  if ( ep == NULL )
+  {
+    return ( FALSE );
+  }
+
+  ep->pfnIncomingCB = pIncomingFn;
+
+  return ( TRUE );
+}
+
+afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                           uint16_t cID, uint16_t len, uint8_t *buf, uint8_t *transID,
+                           uint8_t options, uint8_t radius )
+{
+  (void)options;
+  (void)radius;
+
+  ZTEST_CHECK( len <= sizeof( txBuf ) );
+  memcpy( txBuf, buf, len );
+  txLen = len;
+  txDst = *dstAddr;
+  txSrc = srcEP;
+  txCluster = cID;
+  txCnt++;
+  (*transID)++;
+
+  return ( afStatus_SUCCESS );
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+#define SRV_EP      10
+#define HOST_EP     8
+
+#define SRC_ADDR    0x1234
+#define SRC_EP      0x22
+
+// Host endpoint, registered through MT
+static SimpleDescriptionFormat_t hostSimpleDesc = { HOST_EP, 0x0104, 0, 0, 0, 0, NULL, 0, NULL };
+static endPointDesc_t hostEpDesc = { HOST_EP, 0, &ZDAppTaskID, &hostSimpleDesc, noLatencyReqs };
+
+static void reset( void )
+{
+  epRegFail = FALSE;
+  ZTEST_CHECK( UTC_timeServerConfig( 0, 0, 0, 0, 0 ) == ZSuccess );
+  memset( epList, 0, sizeof( epList ) );
+  epRegCnt = 0;
+  txCnt = 0;
+  txLen = 0;
+}
+
+// Deliver a frame to the server endpoint
+static void deliver( uint16_t clusterId, uint8_t *frame, uint16_t len,
+                     uint8_t wasBroadcast, uint16_t groupId )
+{
+  afIncomingMSGPacket_t pkt;
+  epList_t *ep = epFind( SRV_EP );
+
+  ZTEST_CHECK( (ep != NULL) && (ep->pfnIncomingCB != NULL) );
+  if ( (ep == NULL) || (ep->pfnIncomingCB == NULL) )
+  {
+    return;
+  }
+
+  memset( &pkt, 0, sizeof( pkt ) );
+  pkt.groupId = groupId;
+  pkt.clusterId = clusterId;
+  pkt.srcAddr.addrMode = afAddr16Bit;
+  pkt.srcAddr.addr.shortAddr = SRC_ADDR;
+  pkt.srcAddr.endPoint = SRC_EP;
+  pkt.endPoint = SRV_EP;
+  pkt.wasBroadcast = wasBroadcast;
+  pkt.cmd.DataLength = len;
+  pkt.cmd.Data = frame;
+
+  ZTEST_CHECK( ep->pfnIncomingCB( &pkt ) == TRUE );
+}
+
+// Send Read Attributes of n attributes
+static void readAttrs( uint8_t seq, const uint16_t *attrs, uint8_t n )
+{
+  uint8_t frame[64];
+  uint8_t i;
+
+  frame[0] = 0x00;
+  frame[1] = seq;
+  frame[2] = 0x00;
+  for ( i = 0; i < n; i++ )
+  {
+    frame[3 + 2 * i] = LO_UINT16( attrs[i] );
+    frame[4 + 2 * i] = HI_UINT16( attrs[i] );
+  }
+
+  txCnt = 0;
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 3 + 2 * n, FALSE, 0 );
+}
+
+// Record of an attribute in the last Read Attributes Response, NULL if none
+static uint8_t *rspRecord( uint16_t attrId )
+{
+  uint8_t *p = &txBuf[3];
+
+  while ( p < &txBuf[txLen] )
+  {
+    if ( BUILD_UINT16( p[0], p[1] ) == attrId )
+    {
+      return ( p );
+    }
+    if ( p[2] != 0x00 )
+    {
+      p += 3;
+    }
+    else
+    {
+      p += (p[3] == 0x18) ? 5 : 8;
+    }
+  }
+
+  return ( NULL );
+}
+
+static uint32_t rspValue( uint8_t *p )
+{
+  return ( (uint32_t)p[4] | ((uint32_t)p[5] << 8) | ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 24) );
+}
+
+// Check a 32-bit attribute of the last response
+static void checkAttr( uint16_t attrId, uint8_t type, uint32_t value )
+{
+  uint8_t *p = rspRecord( attrId );
+
+  ZTEST_CHECK( p != NULL );
+  if ( p != NULL )
+  {
+    ZTEST_CHECK( p[2] == 0x00 );
+    ZTEST_CHECK( p[3] == type );
+    ZTEST_CHECK( rspValue( p ) == value );
+  }
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testConfig( void )
+{
+  reset();
+
+  ZTEST_CHECK( UTC_timeServerConfig( 241, 0, 0, 0, 0 ) == ZInvalidParameter );
+  ZTEST_CHECK( UTC_timeServerEndpoint() == 0 );
+
+  // Taken by the host
+  ZTEST_CHECK( afRegisterExtended( &hostEpDesc, NULL, NULL ) != NULL );
+  ZTEST_CHECK( UTC_timeServerConfig( HOST_EP, 0, 0, 0, 0 ) == ZInvalidParameter );
+  ZTEST_CHECK( UTC_timeServerEndpoint() == 0 );
+
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 0, 0, 0, 0 ) == ZSuccess );
+  ZTEST_CHECK( UTC_timeServerEndpoint() == SRV_EP );
+  ZTEST_CHECK( epFind( SRV_EP ) != NULL );
+  ZTEST_CHECK( epFind( SRV_EP )->pfnIncomingCB != NULL );
+  ZTEST_CHECK( epFind( SRV_EP )->epDesc->simpleDesc->EndPoint == SRV_EP );
+  ZTEST_CHECK( epRegCnt == 2 );
+
+  // Same endpoint, only the settings change
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 3600, 0, 0, 0 ) == ZSuccess );
+  ZTEST_CHECK( epRegCnt == 2 );
+
+  // Moved
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP + 1, 0, 0, 0, 0 ) == ZSuccess );
+  ZTEST_CHECK( epFind( SRV_EP ) == NULL );
+  ZTEST_CHECK( epFind( SRV_EP + 1 ) != NULL );
+  ZTEST_CHECK( UTC_timeServerEndpoint() == SRV_EP + 1 );
+
+  // Removed by the host behind its back, then moved
+  ZTEST_CHECK( afDelete( SRV_EP + 1 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 0, 0, 0, 0 ) == ZSuccess );
+  ZTEST_CHECK( epFind( SRV_EP ) != NULL );
+
+  // Out of memory, no endpoint left
+  epRegFail = TRUE;
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP + 2, 0, 0, 0, 0 ) == ZMemError );
+  ZTEST_CHECK( UTC_timeServerEndpoint() == 0 );
+  ZTEST_CHECK( epFind( SRV_EP ) == NULL );
+  epRegFail = FALSE;
+
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 0, 0, 0, 0 ) == ZSuccess );
+  ZTEST_CHECK( UTC_timeServerConfig( 0, 0, 0, 0, 0 ) == ZSuccess );
+  ZTEST_CHECK( UTC_timeServerEndpoint() == 0 );
+  ZTEST_CHECK( epFind( SRV_EP ) == NULL );
+  ZTEST_CHECK( epFind( HOST_EP ) != NULL );
+}
+
+static void testReadUnset( void )
+{
+  const uint16_t attrs[] = { 0x0000, 0x0001, 0x0002, 0x0006, 0x0007, 0x0008, 0x0009, 0xFFFF };
+  uint8_t *p;
+
+  reset();
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, -18000, 0, 0, 0 ) == ZSuccess );
+
+  readAttrs( 0x5A, attrs, 8 );
+  ZTEST_CHECK( txCnt == 1 );
+  ZTEST_CHECK( txCluster == UTC_TIMESRV_CLUSTER_ID );
+  ZTEST_CHECK( txSrc->endPoint == SRV_EP );
+  ZTEST_CHECK( (txDst.addrMode == afAddr16Bit) && (txDst.addr.shortAddr == SRC_ADDR) );
+  ZTEST_CHECK( txDst.endPoint == SRC_EP );
+
+  // Server to client, no Default Response, same sequence number
+  ZTEST_CHECK( (txBuf[0] == 0x18) && (txBuf[1] == 0x5A) && (txBuf[2] == 0x01) );
+  ZTEST_CHECK( txLen == 3 + 8 + 5 + 8 + 8 + 8 + 8 + 3 + 3 );
+
+  checkAttr( 0x0000, 0xE2, 0xFFFFFFFF );
+  p = rspRecord( 0x0001 );
+  ZTEST_CHECK( (p != NULL) && (p[2] == 0x00) && (p[3] == 0x18) && (p[4] == 0x00) );
+  checkAttr( 0x0002, 0x2B, (uint32_t)-18000 );
+  checkAttr( 0x0006, 0x23, 0xFFFFFFFF );
+  checkAttr( 0x0007, 0x23, 0xFFFFFFFF );
+  checkAttr( 0x0008, 0xE2, 0xFFFFFFFF );
+  p = rspRecord( 0x0009 );
+  ZTEST_CHECK( (p != NULL) && (p[2] == 0x86) );
+  p = rspRecord( 0xFFFF );
+  ZTEST_CHECK( (p != NULL) && (p[2] == 0x86) );
+}
+
+static void testReadSet( void )
+{
+  const uint16_t attrs[] = { 0x0000, 0x0001, 0x0002, 0x0003, 0x0004,
+                             0x0005, 0x0006, 0x0007, 0x0008 };
+  const UTCTime now = 800000000;
+  uint8_t *p;
+
+  reset();
+  UTC_setClock( now );
+
+  // In daylight saving time
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 3600, now - 10, now + 10, 1800 ) == ZSuccess );
+  readAttrs( 1, attrs, 9 );
+  ZTEST_CHECK( txCnt == 1 );
+  checkAttr( 0x0000, 0xE2, now );
+  p = rspRecord( 0x0001 );
+  ZTEST_CHECK( (p != NULL) && (p[2] == 0x00) && (p[3] == 0x18) && (p[4] == 0x03) );
+  checkAttr( 0x0002, 0x2B, 3600 );
+  checkAttr( 0x0003, 0x23, now - 10 );
+  checkAttr( 0x0004, 0x23, now + 10 );
+  checkAttr( 0x0005, 0x2B, 1800 );
+  checkAttr( 0x0006, 0x23, now + 3600 );
+  checkAttr( 0x0007, 0x23, now + 3600 + 1800 );
+  checkAttr( 0x0008, 0xE2, now );
+
+  // Starts now
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 3600, now, now + 10, 1800 ) == ZSuccess );
+  readAttrs( 2, &attrs[7], 1 );
+  checkAttr( 0x0007, 0x23, now + 3600 + 1800 );
+
+  // Ended now
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 3600, now - 10, now, 1800 ) == ZSuccess );
+  readAttrs( 3, &attrs[7], 1 );
+  checkAttr( 0x0007, 0x23, now + 3600 );
+
+  // Time set from a sync point
+  ZTEST_CHECK( UTC_discipline( now + 100, 0 ) == UTC_SYNC_STEP );
+  readAttrs( 4, attrs, 9 );
+  checkAttr( 0x0000, 0xE2, now + 100 );
+  checkAttr( 0x0008, 0xE2, now + 100 );
+}
+
+static void testReadMany( void )
+{
+  uint16_t attrs[20];
+  uint8_t frame[8];
+  uint8_t i;
+
+  reset();
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 0, 0, 0, 0 ) == ZSuccess );
+
+  // More than fit, the response is cut short at a whole record
+  memset( attrs, 0, sizeof( attrs ) );
+  readAttrs( 1, attrs, 20 );
+  ZTEST_CHECK( txCnt == 1 );
+  ZTEST_CHECK( txLen == 3 + 12 * 8 );
+
+  for ( i = 0; i < 20; i++ )
+  {
+    attrs[i] = 0x0100 + i;
+  }
+  readAttrs( 2, attrs, 20 );
+  ZTEST_CHECK( txLen == 3 + 20 * 3 );
+
+  // A trailing odd byte is ignored, no attributes is an empty response
+  frame[0] = 0x00;
+  frame[1] = 3;
+  frame[2] = 0x00;
+  frame[3] = 0x00;
+  txCnt = 0;
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 4, FALSE, 0 );
+  ZTEST_CHECK( (txCnt == 1) && (txLen == 3) );
+}
+
+static void testDefaultRsp( void )
+{
+  const uint16_t attr = 0x0000;
+  uint8_t frame[8];
+
+  reset();
+  ZTEST_CHECK( UTC_timeServerConfig( SRV_EP, 0, 0, 0, 0 ) == ZSuccess );
+
+  // Write Attributes, a profile-wide command it doesn't support
+  frame[0] = 0x00;
+  frame[1] = 7;
+  frame[2] = 0x02;
+  txCnt = 0;
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 3, FALSE, 0 );
+  ZTEST_CHECK( txCnt == 1 );
+  ZTEST_CHECK( txLen == 5 );
+  ZTEST_CHECK( (txBuf[0] == 0x18) && (txBuf[1] == 7) && (txBuf[2] == 0x0B) );
+  ZTEST_CHECK( (txBuf[3] == 0x02) && (txBuf[4] == 0x82) );
+
+  // A cluster command
+  frame[0] = 0x01;
+  frame[2] = 0x00;
+  txCnt = 0;
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 3, FALSE, 0 );
+  ZTEST_CHECK( (txCnt == 1) && (txBuf[3] == 0x00) && (txBuf[4] == 0x81) );
+
+  // No Default Response asked for, or to a broadcast or groupcast
+  frame[0] = 0x10;
+  frame[2] = 0x02;
+  txCnt = 0;
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 3, FALSE, 0 );
+  frame[0] = 0x00;
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 3, TRUE, 0 );
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 3, FALSE, 0x0001 );
+  ZTEST_CHECK( txCnt == 0 );
+
+  // Dropped: manufacturer specific, server to client, other clusters, runts
+  frame[0] = 0x04;
+  frame[1] = 0x34;
+  frame[2] = 0x12;
+  frame[3] = 8;
+  frame[4] = 0x00;
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 5, FALSE, 0 );
+  frame[0] = 0x08;
+  frame[2] = 0x00;
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 3, FALSE, 0 );
+  frame[0] = 0x00;
+  deliver( 0x0006, frame, 3, FALSE, 0 );
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 2, FALSE, 0 );
+  ZTEST_CHECK( txCnt == 0 );
+
+  // Read Attributes is answered whatever the addressing
+  frame[0] = 0x10;
+  frame[1] = 9;
+  frame[2] = 0x00;
+  frame[3] = LO_UINT16( attr );
+  frame[4] = HI_UINT16( attr );
+  deliver( UTC_TIMESRV_CLUSTER_ID, frame, 5, TRUE, 0 );
+  ZTEST_CHECK( (txCnt == 1) && (txBuf[1] == 9) && (txBuf[2] == 0x01) );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testConfig );
+  ZTEST_RUN( testReadUnset );
+  ZTEST_RUN( testReadSet );
+  ZTEST_RUN( testReadMany );
+  ZTEST_RUN( testDefaultRsp );
+
+  return ( ZTEST_RESULT );
+}
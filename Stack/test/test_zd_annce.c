@@ -0,0 +1,582 @@
+/**************************************************************************************************
+  Filename:       test_zd_annce.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the device announce processing of a
+                  router: the tables updated at once, the notifications
+                  held for the batch, and the per device suppression of
+                  repeated announces.  A storm of 300 devices announcing
+                  with relayed copies counts the table updates.
+**************************************************************************************************/
+
+#include <stdlib.h>
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "nwk.h"
+#include "nwk_util.h"
+#include "assoc_list.h"
+#include "addr_mgr.h"
+#include "zd_app.h"
+#include "rom_jt_154.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define ZG_BUILD_RTR_TYPE           1
+#define ZG_DEVICE_RTR_TYPE          1
+#define ZG_DEVICE_ENDDEVICE_TYPE    0
+#define ZSTACK_ROUTER_BUILD         1
+#define ZSTACK_END_DEVICE_BUILD     0
+
+#define ZDO_DEVICE_ANNCE_BATCH_EVT  0x00010000
+#define ZMacCoordShortAddress       0x4B
+
+#define MY_ADDR                     0x0001
+#define PARENT_ADDR                 0x0000
+
+typedef struct
+{
+  uint16_t macDestAddr;
+  uint16_t nwkAddr;
+  uint8_t  extAddr[Z_EXTADDR_LEN];
+} zdoIncomingMsg_t;
+
+uint32_t ztestClock = 0;
+uint8_t ZDAppTaskID = 2;
+nwkIB_t _NIB;
+uint8_t zgRxAlwaysOn = TRUE;
+uint8_t zgChildAgingEnable = TRUE;
+
+static uint8_t myExt[Z_EXTADDR_LEN] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+static uint8_t parentExt[Z_EXTADDR_LEN] = { 2, 2, 2, 2, 2, 2, 2, 2 };
+
+// Calls into the tables
+static struct
+{
+  uint32_t sweeps;
+  uint32_t rtgRemoves;
+  uint32_t nbrRemoves;
+  uint32_t assocRemoves;
+  uint32_t notMyChildDeletes;
+  uint32_t addrUpdates;
+  uint32_t leaveFlushes;
+  uint32_t notifies;
+} cnt;
+
+// Address manager, by device
+#define DEVS_MAX    320
+static uint16_t devNwk[DEVS_MAX];
+static uint8_t devChild[DEVS_MAX];      // An end device child of ours
+
+static uint8_t timerArmed;
+static uint32_t timerDue;
+
+static uint16_t devOf( uint8_t *extAddr )
+{
+  return ( BUILD_UINT16( extAddr[0], extAddr[1] ) );
+}
+
+// Defined after the items, with their ZDO_DeviceAnnce_t
+static void ZDO_ParseDeviceAnnce( zdoIncomingMsg_t *inMsg, void *pAnnce );
+
+static uint8_t *NLME_GetExtAddr( void )
+{
+  return ( myExt );
+}
+
+static uint16_t NLME_GetShortAddr( void )
+{
+  return ( MY_ADDR );
+}
+
+static uint16_t NLME_GetCoordShortAddr( void )
+{
+  return ( _NIB.nwkCoordAddress );
+}
+
+static void NLME_GetCoordExtAddr( uint8_t *buf )
+{
+  osal_cpyExtAddr( buf, parentExt );
+}
+
+static ZStatus_t NLME_CheckNewAddrSet( uint16_t nwkAddr, uint8_t *extAddr )
+{
+  (void)nwkAddr;
+  (void)extAddr;
+
+  return ( ZSuccess );
+}
+
+static void ZMacSetReq( uint8_t attr, uint8_t *value )
+{
+  (void)attr;
+  (void)value;
+}
+
+static void nwkNeighborRemoveAllStranded( void )
+{
+  cnt.sweeps++;
+}
+
+void nwkNeighborRemove( uint16_t NeighborAddress, uint16_t PanId )
+{
+  (void)NeighborAddress;
+  (void)PanId;
+  cnt.nbrRemoves++;
+}
+
+static void RTG_RemoveRtgEntry( uint16_t DstAddress, uint8_t options )
+{
+  (void)DstAddress;
+  (void)options;
+  cnt.rtgRemoves++;
+}
+
+static associated_devices_t childEntry;
+
+static associated_devices_t *AssocGetWithExt( uint8_t *extAddr )
+{
+  uint16_t dev = devOf( extAddr );
+
+  if ( (dev >= DEVS_MAX) || !devChild[dev] )
+  {
+    return ( NULL );
+  }
+  childEntry.shortAddr = devNwk[dev];
+  childEntry.nodeRelation = CHILD_RFD;
+
+  return ( &childEntry );
+}
+
+byte AssocRemove( byte *extAddr )
+{
+  devChild[devOf( extAddr )] = FALSE;
+  cnt.assocRemoves++;
+
+  return ( TRUE );
+}
+
+static uint8_t notMyChildDelete( uint16_t devAddr )
+{
+  (void)devAddr;
+  cnt.notMyChildDeletes++;
+
+  return ( TRUE );
+}
+
+uint8_t (*pNwkNotMyChildListDelete)( uint16_t devAddr ) = notMyChildDelete;
+
+uint8_t AddrMgrEntryLookupNwk( AddrMgrEntry_t *entry )
+{
+  uint16_t dev;
+
+  for ( dev = 0; dev < DEVS_MAX; dev++ )
+  {
+    if ( devNwk[dev] == entry->nwkAddr )
+    {
+      memset( entry->extAddr, 0, Z_EXTADDR_LEN );
+      entry->extAddr[0] = LO_UINT16( dev );
+      entry->extAddr[1] = HI_UINT16( dev );
+      entry->index = dev;
+      return ( TRUE );
+    }
+  }
+
+  return ( FALSE );
+}
+
+uint8_t AddrMgrEntryLookupExt( AddrMgrEntry_t *entry )
+{
+  uint16_t dev = devOf( entry->extAddr );
+
+  if ( dev >= DEVS_MAX )
+  {
+    return ( FALSE );
+  }
+  entry->nwkAddr = devNwk[dev];
+  entry->index = dev;
+
+  return ( TRUE );
+}
+
+static void AddrMgrExtAddrSet( uint8_t *dstExt, uint8_t *srcExt )
+{
+  osal_cpyExtAddr( dstExt, srcExt );
+}
+
+static uint8_t AddrMgrEntryUpdate( AddrMgrEntry_t *entry )
+{
+  devNwk[entry->index] = entry->nwkAddr;
+  cnt.addrUpdates++;
+
+  return ( TRUE );
+}
+
+static void ZDApp_LeaveBatchFlush( uint8_t *extAddr )
+{
+  (void)extAddr;
+  cnt.leaveFlushes++;
+}
+
+static void gpCheck( uint8_t *sinkIEEE, uint16_t sinkNwkAddr )
+{
+  (void)sinkIEEE;
+  (void)sinkNwkAddr;
+  cnt.notifies++;
+}
+
+void (*GP_CheckAnnouncedDeviceGCB)( uint8_t *sinkIEEE, uint16_t sinkNwkAddr ) = gpCheck;
+
+static uint8_t OsalPort_memcmp( const void *src1, const void *src2, uint32_t len )
+{
+  return ( memcmp( src1, src2, len ) == 0 );
+}
+
+static uint8_t OsalPortTimers_startTimer( uint8_t taskId, uint32_t eventId, uint32_t timeout )
+{
+  (void)taskId;
+  (void)eventId;
+  timerArmed = TRUE;
+  timerDue = ztestClock + timeout;
+
+  return ( ZSuccess );
+}
+
+static uint8_t OsalPortTimers_stopTimer( uint8_t taskId, uint32_t eventId )
+{
+  (void)taskId;
+  (void)eventId;
+  timerArmed = FALSE;
+
+  return ( ZSuccess );
+}
+
+#include "test_zd_annce_items.c"
+
+static void ZDO_ParseDeviceAnnce( zdoIncomingMsg_t *inMsg, void *pAnnce )
+{
+  ZDO_DeviceAnnce_t *p = pAnnce;
+
+  p->nwkAddr = inMsg->nwkAddr;
+  osal_cpyExtAddr( p->extAddr, inMsg->extAddr );
+  p->capabilities = 0;
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+static void reset( void )
+{
+  uint16_t dev;
+
+  memset( &cnt, 0, sizeof( cnt ) );
+  memset( zdoAnnceRecent, 0, sizeof( zdoAnnceRecent ) );
+  zdoAnnceBatchCnt = 0;
+  timerArmed = FALSE;
+  ztestClock = 1000;
+
+  _NIB.nwkState = NWK_ROUTER;
+  _NIB.nwkCoordAddress = PARENT_ADDR;
+
+  for ( dev = 0; dev < DEVS_MAX; dev++ )
+  {
+    devNwk[dev] = 0x1000 + dev;
+    devChild[dev] = FALSE;
+  }
+}
+
+// An announce of a device, unicast to us when it is our child
+static void annce( uint16_t dev, uint16_t nwkAddr, uint8_t toMe )
+{
+  zdoIncomingMsg_t inMsg;
+
+  memset( &inMsg, 0, sizeof( inMsg ) );
+  inMsg.macDestAddr = toMe ? MY_ADDR : 0xFFFF;
+  inMsg.nwkAddr = nwkAddr;
+  inMsg.extAddr[0] = LO_UINT16( dev );
+  inMsg.extAddr[1] = HI_UINT16( dev );
+
+  ZDO_ProcessDeviceAnnce( &inMsg );
+}
+
+static void runTimer( void )
+{
+  if ( timerArmed && ((int32_t)(ztestClock - timerDue) >= 0) )
+  {
+    timerArmed = FALSE;
+    ZDO_ProcessDeviceAnnceBatch();
+  }
+}
+
+// Entries the suppression keeps of a device
+static uint8_t recentOf( uint16_t dev )
+{
+  uint8_t n = 0;
+  uint8_t i;
+
+  for ( i = 0; i < ZDO_ANNCE_RECENT_MAX; i++ )
+  {
+    if ( (zdoAnnceRecent[i].time != 0) && (devOf( zdoAnnceRecent[i].extAddr ) == dev) )
+    {
+      n++;
+    }
+  }
+
+  return ( n );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testInline( void )
+{
+  reset();
+
+  annce( 5, 0x2005, FALSE );
+
+  // The tables at once
+  ZTEST_CHECK( (cnt.sweeps == 1) && (cnt.rtgRemoves == 1) && (cnt.nbrRemoves == 1) );
+  ZTEST_CHECK( (cnt.addrUpdates == 1) && (devNwk[5] == 0x2005) );
+  ZTEST_CHECK( cnt.leaveFlushes == 1 );
+
+  // The notification with the batch
+  ZTEST_CHECK( (cnt.notifies == 0) && timerArmed );
+  ztestClock += ZDO_ANNCE_BATCH_DELAY;
+  runTimer();
+  ZTEST_CHECK( cnt.notifies == 1 );
+
+  // Not while the network is down
+  annce( 6, 0x2006, FALSE );
+  _NIB.nwkState = NWK_REJOINING;
+  ztestClock += ZDO_ANNCE_BATCH_DELAY;
+  runTimer();
+  ZTEST_CHECK( (cnt.notifies == 1) && (zdoAnnceBatchCnt == 0) );
+  annce( 7, 0x2007, FALSE );
+  ZTEST_CHECK( cnt.rtgRemoves == 2 );
+}
+
+static void testChild( void )
+{
+  reset();
+
+  // From our own child, unicast to us: it stays our child
+  devChild[9] = TRUE;
+  annce( 9, 0x1009, TRUE );
+  ZTEST_CHECK( devChild[9] && (cnt.assocRemoves == 0) && (cnt.notMyChildDeletes == 0) );
+
+  // The same device heard through another parent is no repeat
+  ztestClock += 10;
+  annce( 9, 0x1009, FALSE );
+  ZTEST_CHECK( !devChild[9] && (cnt.assocRemoves == 1) && (cnt.notMyChildDeletes == 1) );
+  ZTEST_CHECK( cnt.rtgRemoves == 2 );
+  ZTEST_CHECK( recentOf( 9 ) == 1 );
+}
+
+static void testRepeat( void )
+{
+  reset();
+
+  annce( 3, 0x2003, FALSE );
+  ztestClock += ZDO_ANNCE_DEDUP_WINDOW - 1;
+  annce( 3, 0x2003, FALSE );
+  ZTEST_CHECK( (cnt.rtgRemoves == 1) && (cnt.leaveFlushes == 1) );
+
+  // A new address is applied
+  annce( 3, 0x2103, FALSE );
+  ZTEST_CHECK( (cnt.rtgRemoves == 2) && (devNwk[3] == 0x2103) );
+  ZTEST_CHECK( recentOf( 3 ) == 1 );
+
+  // So is the old one again
+  ztestClock += 1;
+  annce( 3, 0x2003, FALSE );
+  ZTEST_CHECK( (cnt.rtgRemoves == 3) && (devNwk[3] == 0x2003) );
+
+  // Past the window, the stale entry does not hold it back
+  ztestClock += ZDO_ANNCE_DEDUP_WINDOW;
+  annce( 3, 0x2003, FALSE );
+  ZTEST_CHECK( cnt.rtgRemoves == 4 );
+  ZTEST_CHECK( recentOf( 3 ) == 1 );
+  annce( 3, 0x2003, FALSE );
+  ZTEST_CHECK( cnt.rtgRemoves == 4 );
+
+  // One notification per device in the batch, with its last address
+  ztestClock += ZDO_ANNCE_BATCH_DELAY;
+  runTimer();
+  ZTEST_CHECK( cnt.notifies == 1 );
+}
+
+static void testSlots( void )
+{
+  uint16_t dev;
+
+  reset();
+
+  // More devices than entries: the oldest goes
+  for ( dev = 0; dev <= ZDO_ANNCE_RECENT_MAX; dev++ )
+  {
+    annce( dev, 0x2000 + dev, FALSE );
+    annce( dev, 0x2000 + dev, FALSE );
+    ztestClock++;
+  }
+  ZTEST_CHECK( cnt.rtgRemoves == ZDO_ANNCE_RECENT_MAX + 1 );
+  ZTEST_CHECK( recentOf( 0 ) == 0 );
+  for ( dev = 1; dev <= ZDO_ANNCE_RECENT_MAX; dev++ )
+  {
+    ZTEST_CHECK( recentOf( dev ) == 1 );
+  }
+
+  // A suppressed repeat keeps the time it was applied, device 0 takes
+  // the entry of device 1 as the oldest
+  annce( 1, 0x2001, FALSE );
+  ZTEST_CHECK( cnt.rtgRemoves == ZDO_ANNCE_RECENT_MAX + 1 );
+  annce( 0, 0x2000, FALSE );
+  ZTEST_CHECK( cnt.rtgRemoves == ZDO_ANNCE_RECENT_MAX + 2 );
+  ZTEST_CHECK( (recentOf( 0 ) == 1) && (recentOf( 1 ) == 0) && (recentOf( 2 ) == 1) );
+  ZTEST_CHECK( recentOf( ZDO_ANNCE_RECENT_MAX ) == 1 );
+}
+
+/*********************************************************************
+ * STORM
+ *
+ * STORM_DEVS devices announce over STORM_SPAN ms, each heard
+ * STORM_COPIES times as neighbors relay the broadcast within
+ * STORM_RELAY ms.  Some change their address a little later, as after
+ * an address conflict, and some of our children announce again through
+ * another parent.  Either is a new announce to apply.
+ */
+#define STORM_DEVS      300
+#define STORM_SPAN      10000
+#define STORM_COPIES    4
+#define STORM_RELAY     150
+#define STORM_MOVED     30
+#define STORM_CHILDREN  20
+
+typedef struct
+{
+  uint32_t time;
+  uint16_t dev;
+  uint16_t nwkAddr;
+  uint8_t toMe;
+} stormEvt_t;
+
+static int stormCmp( const void *a, const void *b )
+{
+  const stormEvt_t *x = a;
+  const stormEvt_t *y = b;
+
+  return ( (x->time > y->time) - (x->time < y->time) );
+}
+
+static void testStorm( void )
+{
+  static stormEvt_t evts[(STORM_DEVS + STORM_MOVED + STORM_CHILDREN) * STORM_COPIES];
+  uint32_t evtCnt = 0;
+  uint32_t annces = 0;
+  uint32_t t;
+  uint16_t dev;
+  uint8_t c;
+  uint32_t i;
+
+  reset();
+  srand( 115 );
+
+  for ( dev = 0; dev < STORM_DEVS; dev++ )
+  {
+    uint16_t nwkAddr = 0x3000 + dev;
+    uint8_t child = (dev < STORM_CHILDREN);
+
+    devChild[dev] = child;
+    t = 1000 + (uint32_t)(rand() % STORM_SPAN);
+
+    // A child's own announce is unicast to us, once
+    for ( c = 0; c < (child ? 1 : STORM_COPIES); c++ )
+    {
+      evts[evtCnt].time = t + ((c == 0) ? 0 : (uint32_t)(rand() % STORM_RELAY));
+      evts[evtCnt].dev = dev;
+      evts[evtCnt].nwkAddr = nwkAddr;
+      evts[evtCnt++].toMe = child;
+    }
+    annces++;
+
+    if ( child )
+    {
+      // Moved to another parent
+      t += 200 + (uint32_t)(rand() % 500);
+      for ( c = 0; c < STORM_COPIES; c++ )
+      {
+        evts[evtCnt].time = t + ((c == 0) ? 0 : (uint32_t)(rand() % STORM_RELAY));
+        evts[evtCnt].dev = dev;
+        evts[evtCnt].nwkAddr = nwkAddr;
+        evts[evtCnt++].toMe = FALSE;
+      }
+      annces++;
+    }
+    else if ( dev < (STORM_CHILDREN + STORM_MOVED) )
+    {
+      // A new address after a conflict
+      t += 200 + (uint32_t)(rand() % 500);
+      for ( c = 0; c < STORM_COPIES; c++ )
+      {
+        evts[evtCnt].time = t + ((c == 0) ? 0 : (uint32_t)(rand() % STORM_RELAY));
+        evts[evtCnt].dev = dev;
+        evts[evtCnt].nwkAddr = nwkAddr + 0x1000;
+        evts[evtCnt++].toMe = FALSE;
+      }
+      annces++;
+    }
+  }
+
+  qsort( evts, evtCnt, sizeof( stormEvt_t ), stormCmp );
+
+  for ( i = 0; i < evtCnt; i++ )
+  {
+    while ( timerArmed && ((int32_t)(evts[i].time - timerDue) >= 0) )
+    {
+      ztestClock = timerDue;
+      runTimer();
+    }
+    ztestClock = evts[i].time;
+    annce( evts[i].dev, evts[i].nwkAddr, evts[i].toMe );
+  }
+  ztestClock += ZDO_ANNCE_BATCH_DELAY;
+  runTimer();
+
+  printf( "%u frames of %u announces: %u applied, %u sweeps, %u route and %u neighbor "
+          "removals, %u notifications\n",
+          (unsigned)evtCnt, (unsigned)annces, (unsigned)cnt.leaveFlushes, (unsigned)cnt.sweeps,
+          (unsigned)cnt.rtgRemoves, (unsigned)cnt.nbrRemoves, (unsigned)cnt.notifies );
+
+  // Every announce applied once, its relayed copies suppressed
+  ZTEST_CHECK( cnt.leaveFlushes == annces );
+  ZTEST_CHECK( (cnt.rtgRemoves == annces) && (cnt.nbrRemoves == annces) );
+  ZTEST_CHECK( cnt.sweeps == annces );
+  ZTEST_CHECK( cnt.assocRemoves == STORM_CHILDREN );
+  ZTEST_CHECK( cnt.notifies <= annces );
+  ZTEST_CHECK( cnt.notifies >= STORM_DEVS );
+
+  // The last address of every device
+  for ( dev = 0; dev < STORM_DEVS; dev++ )
+  {
+    uint16_t expect = 0x3000 + dev;
+
+    if ( (dev >= STORM_CHILDREN) && (dev < (STORM_CHILDREN + STORM_MOVED)) )
+    {
+      expect += 0x1000;
+    }
+    ZTEST_CHECK( devNwk[dev] == expect );
+    ZTEST_CHECK( recentOf( dev ) <= 1 );
+  }
+}
+
+int main( void )
+{
+  ZTEST_RUN( testInline );
+  ZTEST_RUN( testChild );
+  ZTEST_RUN( testRepeat );
+  ZTEST_RUN( testSlots );
+  ZTEST_RUN( testStorm );
+
+  return ( ZTEST_RESULT );
+}
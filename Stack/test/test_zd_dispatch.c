@@ -0,0 +1,555 @@
+/**************************************************************************************************
+  Filename:       test_zd_dispatch.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the ZDO dispatch by cluster index: the
+                  index is a perfect hash of the ZDO clusters, every
+                  cluster reaches the zdpMsgProcs[] handler the table scan
+                  found, and the subscriber bitmaps deliver to the tasks
+                  the registration list did for every permutation of
+                  registrations and removals, once per task.  Tasks and
+                  clusters that can't be indexed fall back to the list.
+                  A benchmark counts the list entries and table entries
+                  a device announce storm went through before the index.
+**************************************************************************************************/
+
+#include <stdlib.h>
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "af.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define CONST                               const
+#define ZDO_CB_MSG                          0xD3
+#define OsalPort_SUCCESS                    0x00
+
+// Every ZDO handler in zdpMsgProcs[]
+#define RFD_RX_ALWAYS_ON_CAPABLE            TRUE
+#define ZG_BUILD_RTR_TYPE                   TRUE
+#define ZG_BUILD_ENDDEVICE_TYPE             TRUE
+#define ZDO_MGMT_NWKDISC_RESPONSE
+#define ZDO_MGMT_LQI_RESPONSE
+#define ZDO_MGMT_RTG_RESPONSE
+#define ZDO_MGMT_BIND_RESPONSE
+#define ZDO_MGMT_LEAVE_RESPONSE
+#define ZDO_MGMT_PERMIT_JOIN_RESPONSE
+#define ZDO_USERDESC_RESPONSE
+#define ZDO_USERDESCSET_RESPONSE
+#define ZDO_SERVERDISC_RESPONSE
+
+#define SEND_LOG_MAX                        64
+
+static uint16_t heapLive;
+
+void *OsalPort_malloc( uint32_t size )
+{
+  heapLive++;
+  return ( malloc( size ) );
+}
+
+void OsalPort_free( void *buf )
+{
+  ZTEST_CHECK( heapLive > 0 );
+  heapLive--;
+  free( buf );
+}
+
+void *OsalPort_memcpy( void *dst, const void *src, unsigned int len )
+{
+  memcpy( dst, src, len );
+  return ( (uint8_t *)dst + len );
+}
+
+// Messages sent to the tasks, consumed as they are logged
+static uint8_t sendTasks[SEND_LOG_MAX];
+static uint8_t *sendMsgs[SEND_LOG_MAX];
+static uint8_t sendCnt;
+static uint8_t msgAllocs;
+
+uint8_t *OsalPort_msgAllocate( uint16_t len )
+{
+  msgAllocs++;
+  return ( OsalPort_malloc( len ) );
+}
+
+uint8_t OsalPort_msgDeallocate( uint8_t *pMsg )
+{
+  OsalPort_free( pMsg );
+  return ( OsalPort_SUCCESS );
+}
+
+uint8_t OsalPort_msgSendShared( uint8_t destinationTask, uint8_t *pMsg )
+{
+  if ( sendCnt < SEND_LOG_MAX )
+  {
+    ZTEST_CHECK( ((OsalPort_EventHdr *)pMsg)->event == ZDO_CB_MSG );
+    sendTasks[sendCnt] = destinationTask;
+    sendMsgs[sendCnt++] = pMsg;
+  }
+  return ( OsalPort_SUCCESS );
+}
+
+// The ZDO handlers of zdpMsgProcs[], defined below the items
+#define HANDLERS                                                        \
+  HANDLER( ZDO_ProcessDeviceAnnce )                                     \
+  HANDLER( ZDO_ProcessParentAnnce )                                     \
+  HANDLER( ZDO_ProcessParentAnnceRsp )                                  \
+  HANDLER( zdpProcessAddrReq )                                          \
+  HANDLER( ZDO_ProcessNodeDescReq )                                     \
+  HANDLER( ZDO_ProcessNodeDescRsp )                                     \
+  HANDLER( ZDO_ProcessPowerDescReq )                                    \
+  HANDLER( ZDO_ProcessSimpleDescReq )                                   \
+  HANDLER( ZDO_ProcessSimpleDescRsp )                                   \
+  HANDLER( ZDO_ProcessActiveEPReq )                                     \
+  HANDLER( ZDO_ProcessMatchDescReq )                                    \
+  HANDLER( ZDO_ProcessMgmtNwkDiscReq )                                  \
+  HANDLER( ZDO_ProcessMgmtLqiReq )                                      \
+  HANDLER( ZDO_ProcessMgmtRtgReq )                                      \
+  HANDLER( ZDO_ProcessMgmtBindReq )                                     \
+  HANDLER( ZDO_ProcessMgmtLeaveReq )                                    \
+  HANDLER( ZDO_ProcessMgmtPermitJoinReq )                               \
+  HANDLER( ZDO_ProcessUserDescReq )                                     \
+  HANDLER( ZDO_ProcessUserDescSet )                                     \
+  HANDLER( ZDO_ProcessServerDiscReq )                                   \
+  HANDLER( ZDApp_InMsgCB )
+
+#define HANDLER( name )   void name();
+HANDLERS
+#undef HANDLER
+
+void ZQuirkSetManufCode( uint16_t nwkAddr, uint16_t manufCode )
+{
+  (void)nwkAddr;
+  (void)manufCode;
+}
+
+#include "test_zd_dispatch_items.c"
+
+// The handler ZDP_IncomingData() called last and for which cluster
+static pfnZDPMsgProcessor handlerFn;
+static uint16_t handlerCluster;
+
+#define HANDLER( name )                                                 \
+  void name( zdoIncomingMsg_t *inMsg )                                  \
+  {                                                                     \
+    handlerFn = name;                                                   \
+    handlerCluster = inMsg->clusterID;                                  \
+  }
+HANDLERS
+#undef HANDLER
+
+/*********************************************************************
+ * HELPERS
+ */
+#define TASKS         4     // Each registered for none, the cluster, all messages or both
+
+// Every ZDO cluster ID defined in zd_profile.h
+static const uint16_t clusters[] =
+{
+  NWK_addr_req, IEEE_addr_req, Node_Desc_req, Power_Desc_req, Simple_Desc_req,
+  Active_EP_req, Match_Desc_req, NWK_addr_rsp, IEEE_addr_rsp, Node_Desc_rsp,
+  Power_Desc_rsp, Simple_Desc_rsp, Active_EP_rsp, Match_Desc_rsp,
+  Complex_Desc_req, User_Desc_req, Discovery_Cache_req, Device_annce,
+  User_Desc_set, Server_Discovery_req, Parent_annce, Complex_Desc_rsp,
+  User_Desc_rsp, Discovery_Cache_rsp, User_Desc_conf, Server_Discovery_rsp,
+  Parent_annce_rsp, End_Device_Bind_req, Bind_req, Unbind_req, Bind_rsp,
+  End_Device_Bind_rsp, Unbind_rsp, Mgmt_NWK_Disc_req, Mgmt_Lqi_req,
+  Mgmt_Rtg_req, Mgmt_Bind_req, Mgmt_Leave_req, Mgmt_Direct_Join_req,
+  Mgmt_Permit_Join_req, Mgmt_NWK_Update_req, Mgmt_NWK_Disc_rsp, Mgmt_Lqi_rsp,
+  Mgmt_Rtg_rsp, Mgmt_Bind_rsp, Mgmt_Leave_rsp, Mgmt_Direct_Join_rsp,
+  Mgmt_Permit_Join_rsp, Mgmt_NWK_Update_notify,
+};
+#define CLUSTER_CNT   ( sizeof( clusters ) / sizeof( clusters[0] ) )
+
+// Clusters ZDO doesn't define, through the index or not
+static const uint16_t others[] = { 0x0007, 0x8007, 0x003F, 0x803F, ZDO_invalid_cmd_req, 0x1234, 0x4013 };
+#define OTHER_CNT     ( sizeof( others ) / sizeof( others[0] ) )
+
+static uint8_t frameData[] = { 0x5A, 0x01, 0x02, 0x03 };
+
+static void removeAll( void )
+{
+  while ( zdoMsgCBs != NULL )
+  {
+    ZTEST_CHECK( ZDO_RemoveRegisteredCB( zdoMsgCBs->taskID, zdoMsgCBs->clusterID ) == ZSuccess );
+  }
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+static void frameIn( afIncomingMSGPacket_t *pData, uint16_t clusterID )
+{
+  memset( pData, 0, sizeof( afIncomingMSGPacket_t ) );
+  pData->srcAddr.addr.shortAddr = 0x1234;
+  pData->clusterId = clusterID;
+  pData->cmd.DataLength = sizeof( frameData );
+  pData->cmd.Data = frameData;
+}
+
+// Tasks the registration list delivered a frame of clusterID to, in list
+// order and once per matching registration
+static uint8_t listTasks( uint16_t clusterID, uint8_t *pTasks )
+{
+  ZDO_MsgCB_t *pList = zdoMsgCBs;
+  uint8_t cnt = 0;
+
+  while ( pList )
+  {
+    if ( (pList->clusterID == clusterID)
+       || ((pList->clusterID == ZDO_ALL_MSGS_CLUSTERID)
+           && ((clusterID & ZDO_RESPONSE_BIT) || (clusterID == Device_annce))) )
+    {
+      pTasks[cnt++] = pList->taskID;
+    }
+    pList = (ZDO_MsgCB_t *)pList->next;
+  }
+
+  return ( cnt );
+}
+
+// A frame of clusterID goes to the tasks of the list: once each and in
+// task order through the index, as the list does without it
+static uint8_t sendsMatch( uint16_t clusterID )
+{
+  zdoIncomingMsg_t inMsg;
+  uint8_t tasks[SEND_LOG_MAX];
+  uint8_t cnt = listTasks( clusterID, tasks );
+  uint16_t live = heapLive;
+  uint8_t handled;
+  uint8_t x, y;
+
+  memset( &inMsg, 0, sizeof( inMsg ) );
+  inMsg.clusterID = clusterID;
+  inMsg.asdu = frameData;
+  inMsg.asduLen = sizeof( frameData );
+
+  sendCnt = 0;
+  msgAllocs = 0;
+  handled = ZDO_SendMsgCBs( &inMsg );
+
+  if ( (handled != (cnt != 0)) || (msgAllocs != (cnt != 0)) || (heapLive != live) )
+  {
+    return ( FALSE );
+  }
+
+  if ( !zdoMsgCBsUnindexed && ZDO_CLUSTER_INDEXABLE( clusterID ) )
+  {
+    // Sorted, without duplicates
+    for ( x = 1; x < cnt; x++ )
+    {
+      uint8_t task = tasks[x];
+
+      for ( y = x; (y > 0) && (tasks[y - 1] >= task); y-- )
+      {
+        tasks[y] = tasks[y - 1];
+      }
+      tasks[y] = task;
+    }
+    for ( x = y = 0; x < cnt; x++ )
+    {
+      if ( (y == 0) || (tasks[y - 1] != tasks[x]) )
+      {
+        tasks[y++] = tasks[x];
+      }
+    }
+    cnt = y;
+  }
+
+  if ( sendCnt != cnt )
+  {
+    return ( FALSE );
+  }
+  for ( x = 0; x < cnt; x++ )
+  {
+    if ( (sendTasks[x] != tasks[x]) || (sendMsgs[x] != sendMsgs[0]) )
+    {
+      return ( FALSE );
+    }
+  }
+
+  return ( TRUE );
+}
+
+// Register each task's option for clusterID, in task order or reversed
+static void registerOptions( uint16_t clusterID, uint8_t options, uint8_t reversed )
+{
+  uint8_t n, task;
+
+  for ( n = 0; n < TASKS; n++ )
+  {
+    uint8_t opt;
+
+    task = reversed ? (TASKS - 1 - n) : n;
+    opt = (options >> (task * 2)) & 0x03;
+
+    if ( opt & 0x01 )
+    {
+      ZTEST_CHECK( ZDO_RegisterForZDOMsg( task, clusterID ) == ZSuccess );
+    }
+    if ( opt & 0x02 )
+    {
+      ZTEST_CHECK( ZDO_RegisterForZDOMsg( task, ZDO_ALL_MSGS_CLUSTERID ) == ZSuccess );
+    }
+  }
+}
+
+// Every cluster and the other clusters dispatch as the list does
+static uint8_t allMatch( void )
+{
+  uint8_t c;
+
+  for ( c = 0; c < CLUSTER_CNT; c++ )
+  {
+    if ( !sendsMatch( clusters[c] ) )
+    {
+      printf( "  cluster 0x%04X\n", clusters[c] );
+      return ( FALSE );
+    }
+  }
+  for ( c = 0; c < OTHER_CNT; c++ )
+  {
+    if ( !sendsMatch( others[c] ) )
+    {
+      printf( "  cluster 0x%04X\n", others[c] );
+      return ( FALSE );
+    }
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testIndex( void )
+{
+  uint8_t seen[ZDO_CLUSTER_IDX_CNT];
+  uint8_t c;
+
+  memset( seen, 0, sizeof( seen ) );
+  for ( c = 0; c < CLUSTER_CNT; c++ )
+  {
+    uint8_t idx = ZDO_CLUSTER_IDX( clusters[c] );
+
+    ZTEST_CHECK( ZDO_CLUSTER_INDEXABLE( clusters[c] ) );
+    ZTEST_CHECK( (idx < ZDO_CLUSTER_IDX_CNT) && !seen[idx] );
+    seen[idx] = TRUE;
+  }
+
+  ZTEST_CHECK( !ZDO_CLUSTER_INDEXABLE( ZDO_invalid_cmd_req ) );
+  ZTEST_CHECK( !ZDO_CLUSTER_INDEXABLE( ZDO_ALL_MSGS_CLUSTERID ) );
+  ZTEST_CHECK( !ZDO_CLUSTER_INDEXABLE( 0x4013 ) );
+}
+
+static void testHandlers( void )
+{
+  afIncomingMSGPacket_t pkt;
+  uint16_t clusterID;
+  uint8_t x;
+
+  // Built on the first frame
+  ZTEST_CHECK( !zdpMsgProcIdxReady );
+
+  for ( clusterID = 0; clusterID < 0x0100; clusterID++ )
+  {
+    uint16_t ids[2];
+    uint8_t n;
+
+    ids[0] = clusterID;
+    ids[1] = clusterID | ZDO_RESPONSE_BIT;
+    for ( n = 0; n < 2; n++ )
+    {
+      pfnZDPMsgProcessor expect = ZDApp_InMsgCB;
+
+      // The handler of the table scan
+      for ( x = 0; zdpMsgProcs[x].clusterID != 0xFFFF; x++ )
+      {
+        if ( zdpMsgProcs[x].clusterID == ids[n] )
+        {
+          expect = zdpMsgProcs[x].pFn;
+          break;
+        }
+      }
+
+      handlerFn = NULL;
+      frameIn( &pkt, ids[n] );
+      ZDP_IncomingData( &pkt );
+
+      ZTEST_CHECK( (handlerFn == expect) && (handlerCluster == ids[n]) );
+    }
+  }
+
+  ZTEST_CHECK( zdpMsgProcIdxReady );
+}
+
+static void testRegistrations( void )
+{
+  uint16_t options;
+  uint8_t c, r;
+
+  // Every subscription of TASKS tasks to each cluster, registered in both
+  // orders, beside a registration of another cluster
+  for ( c = 0; c < CLUSTER_CNT; c++ )
+  {
+    uint16_t otherID = clusters[(c + 1) % CLUSTER_CNT];
+
+    for ( options = 0; options < (1 << (TASKS * 2)); options++ )
+    {
+      for ( r = 0; r < 2; r++ )
+      {
+        ZTEST_CHECK( ZDO_RegisterForZDOMsg( TASKS, otherID ) == ZSuccess );
+        registerOptions( clusters[c], (uint8_t)options, r );
+
+        // Registering twice changes nothing
+        registerOptions( clusters[c], (uint8_t)options, !r );
+
+        if ( !sendsMatch( clusters[c] ) || !sendsMatch( otherID ) ||
+             !sendsMatch( Device_annce ) || !sendsMatch( Mgmt_Lqi_rsp ) )
+        {
+          printf( "  cluster 0x%04X options 0x%02X\n", clusters[c], options );
+          ZTEST_CHECK( FALSE );
+          removeAll();
+          return;
+        }
+
+        // Removed from the front, each step dispatches as the list
+        while ( zdoMsgCBs != NULL )
+        {
+          ZTEST_CHECK( ZDO_RemoveRegisteredCB( zdoMsgCBs->taskID, zdoMsgCBs->clusterID ) == ZSuccess );
+          ZTEST_CHECK( sendsMatch( clusters[c] ) );
+        }
+        ZTEST_CHECK( heapLive == 0 );
+      }
+    }
+  }
+
+  // Every cluster with the last registration of each task removed first
+  for ( options = 0; options < (1 << (TASKS * 2)); options += 0x15 )
+  {
+    for ( c = 0; c < CLUSTER_CNT; c++ )
+    {
+      registerOptions( clusters[c], (uint8_t)options, c & 0x01 );
+    }
+    ZTEST_CHECK( allMatch() );
+
+    for ( c = CLUSTER_CNT; c-- > 0; )
+    {
+      ZDO_RemoveRegisteredCB( c % TASKS, clusters[c] );
+      ZDO_RemoveRegisteredCB( c % TASKS, ZDO_ALL_MSGS_CLUSTERID );
+      ZTEST_CHECK( allMatch() );
+    }
+    removeAll();
+  }
+
+  ZTEST_CHECK( ZDO_RemoveRegisteredCB( 1, Device_annce ) == ZFailure );
+}
+
+static void testUnindexed( void )
+{
+  // A task past the bitmap takes every frame through the list
+  ZTEST_CHECK( ZDO_RegisterForZDOMsg( 2, Device_annce ) == ZSuccess );
+  ZTEST_CHECK( ZDO_RegisterForZDOMsg( 2, ZDO_ALL_MSGS_CLUSTERID ) == ZSuccess );
+  ZTEST_CHECK( !zdoMsgCBsUnindexed );
+  ZTEST_CHECK( ZDO_RegisterForZDOMsg( ZDO_CB_TASKS_MAX, Device_annce ) == ZSuccess );
+  ZTEST_CHECK( zdoMsgCBsUnindexed );
+  ZTEST_CHECK( allMatch() );
+
+  // Delivered as the list did, twice to a task registered twice
+  ZTEST_CHECK( sendsMatch( Device_annce ) && (sendCnt == 3) );
+
+  ZTEST_CHECK( ZDO_RemoveRegisteredCB( ZDO_CB_TASKS_MAX, Device_annce ) == ZSuccess );
+  ZTEST_CHECK( !zdoMsgCBsUnindexed );
+  ZTEST_CHECK( sendsMatch( Device_annce ) && (sendCnt == 1) );
+
+  // So does a cluster ZDO doesn't define outside the index
+  ZTEST_CHECK( ZDO_RegisterForZDOMsg( 3, 0x4013 ) == ZSuccess );
+  ZTEST_CHECK( zdoMsgCBsUnindexed );
+  ZTEST_CHECK( allMatch() );
+  ZTEST_CHECK( sendsMatch( 0x4013 ) && (sendCnt == 1) && (sendTasks[0] == 3) );
+
+  ZTEST_CHECK( ZDO_RemoveRegisteredCB( 3, 0x4013 ) == ZSuccess );
+  ZTEST_CHECK( !zdoMsgCBsUnindexed );
+  ZTEST_CHECK( allMatch() );
+
+  removeAll();
+}
+
+static void testStorm( void )
+{
+  static const uint16_t subscriptions[][2] =
+  {
+    // Tasks of a coordinator: ZDApp, the application, MT, the NWK manager
+    { 1, NWK_addr_rsp }, { 1, IEEE_addr_rsp }, { 1, Match_Desc_rsp },
+    { 2, Node_Desc_rsp }, { 2, Simple_Desc_rsp }, { 2, Active_EP_rsp },
+    { 2, Bind_rsp }, { 2, Unbind_rsp }, { 2, Mgmt_Lqi_rsp },
+    { 3, ZDO_ALL_MSGS_CLUSTERID }, { 4, Mgmt_NWK_Update_notify }, { 5, Device_annce },
+  };
+  // A device announce storm during a network crawl, per 10 frames
+  static const uint16_t mix[] =
+  {
+    Device_annce, Device_annce, Device_annce, Device_annce, Device_annce,
+    Mgmt_Lqi_rsp, Node_Desc_rsp, Active_EP_rsp, Simple_Desc_rsp, Mgmt_Lqi_req,
+  };
+  uint8_t subCnt = sizeof( subscriptions ) / sizeof( subscriptions[0] );
+  afIncomingMSGPacket_t pkt;
+  uint32_t listSteps = 0;
+  uint32_t tableSteps = 0;
+  uint32_t sends = 0;
+  uint16_t frames;
+  uint8_t x;
+
+  for ( x = 0; x < subCnt; x++ )
+  {
+    ZTEST_CHECK( ZDO_RegisterForZDOMsg( (uint8_t)subscriptions[x][0], subscriptions[x][1] ) == ZSuccess );
+  }
+
+  for ( frames = 0; frames < 1000; frames++ )
+  {
+    uint16_t clusterID = mix[frames % (sizeof( mix ) / sizeof( mix[0] ))];
+    uint8_t tasks[SEND_LOG_MAX];
+
+    // Before the index: the whole list and the table up to the entry
+    listSteps += subCnt;
+    for ( x = 0; zdpMsgProcs[x].clusterID != 0xFFFF; x++ )
+    {
+      tableSteps++;
+      if ( zdpMsgProcs[x].clusterID == clusterID )
+      {
+        break;
+      }
+    }
+
+    frameIn( &pkt, clusterID );
+    sendCnt = 0;
+    handlerFn = NULL;
+    ZDP_IncomingData( &pkt );
+    sends += sendCnt;
+    ZTEST_CHECK( sendCnt == listTasks( clusterID, tasks ) );
+
+    // Handled by ZDO or by the subscribers
+    ZTEST_CHECK( (handlerFn != NULL) ? (handlerCluster == clusterID) : (sendCnt != 0) );
+  }
+  ZTEST_CHECK( heapLive == subCnt );
+
+  printf( "  %u frames: %lu list entries and %lu table entries walked before,"
+          " %u bitmaps and %u table entries read now, %lu sends\n",
+          frames, (unsigned long)listSteps, (unsigned long)tableSteps, frames, frames,
+          (unsigned long)sends );
+  ZTEST_CHECK( (listSteps > 10UL * frames) && (tableSteps > 5UL * frames) );
+
+  removeAll();
+}
+
+int main( void )
+{
+  ZTEST_RUN( testIndex );
+  ZTEST_RUN( testHandlers );
+  ZTEST_RUN( testRegistrations );
+  ZTEST_RUN( testUnindexed );
+  ZTEST_RUN( testStorm );
+
+  return ( ZTEST_RESULT );
+}
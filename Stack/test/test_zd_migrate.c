@@ -0,0 +1,462 @@
+/**************************************************************************************************
+  Filename:       test_zd_migrate.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the channel migration of the network
+                  manager: off by default, turned off under way, the old
+                  channel windows held until the NWK data buffers drain
+                  and closed once the update unicasts are out, and a
+                  150 node network with lost frames, against windows of
+                  a fixed length.
+**************************************************************************************************/
+
+#define NWK_MAX_DEVICES   150
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "nwk.h"
+#include "assoc_list.h"
+#include "af.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define ZDO_CHAN_MIGRATE_CBID   0
+#define MAX_ZDO_CB_FUNC         1
+#define ZMacChannel             0xE1
+
+typedef void* (*pfnZdoCb)( void *param );
+
+nwkIB_t _NIB;
+associated_devices_t AssociatedDevList[NWK_MAX_DEVICES];
+uint8_t ZDNwkMgr_TaskID = 7;
+uint8_t ZDNwkMgr_NewChannel;
+pfnZdoCb zdoCBFunc[MAX_ZDO_CB_FUNC];
+
+static uint32_t now;            // ms
+static uint8_t timerOn;
+static uint32_t timerDue;
+
+uint8_t OsalPortTimers_startTimer( uint8_t taskId, uint32_t eventId, uint32_t timeout )
+{
+  ZTEST_CHECK( taskId == ZDNwkMgr_TaskID );
+  (void)eventId;
+  timerOn = TRUE;
+  timerDue = now + timeout;
+  return ( SUCCESS );
+}
+
+uint8_t OsalPortTimers_stopTimer( uint8_t taskId, uint32_t eventId )
+{
+  (void)taskId;
+  (void)eventId;
+  timerOn = FALSE;
+  return ( SUCCESS );
+}
+
+// Child aging deadlines, moved on by each poll heard
+static uint32_t deadline[NWK_MAX_DEVICES];
+
+uint32_t NwkChildAge_Deadline( uint16_t devIdx )
+{
+  return ( deadline[devIdx] );
+}
+
+// The MAC: one channel for everything, a FIFO of frames sent one at a time
+#define MAC_Q_MAX       64
+#define MAC_FRAME_MS    5       // Air time and CSMA of a frame
+#define FRAME_UPDATE    0x8000  // Mgmt_NWK_Update_req to a device, else other traffic
+
+static uint8_t macChannel;
+static uint16_t macQ[MAC_Q_MAX];
+static uint8_t macQCnt;
+static uint32_t macDoneAt;      // End of the frame on air, 0 if none
+static uint8_t macTxChannel;
+
+uint8_t ZMacSetReq( uint8_t attr, uint8_t *value )
+{
+  ZTEST_CHECK( attr == ZMacChannel );
+  macChannel = *value;
+  return ( SUCCESS );
+}
+
+static void macQueue( uint16_t frame )
+{
+  ZTEST_CHECK( macQCnt < MAC_Q_MAX );
+  macQ[macQCnt++] = frame;
+}
+
+afStatus_t ZDP_MgmtNwkUpdateReq( zAddrType_t *dstAddr, uint32_t ChannelMask, uint8_t ScanDuration,
+                                 uint8_t ScanCount, uint8_t NwkUpdateId, uint16_t NwkManagerAddr )
+{
+  ZTEST_CHECK( ChannelMask == ((uint32_t)1 << ZDNwkMgr_NewChannel) );
+  ZTEST_CHECK( ScanDuration == 0xfe );
+  (void)ScanCount;
+  (void)NwkUpdateId;
+  (void)NwkManagerAddr;
+  macQueue( FRAME_UPDATE | dstAddr->addr.shortAddr );
+  return ( afStatus_SUCCESS );
+}
+
+// Model of the windows before the buffers were looked at: every window
+// is ZDNWKMGR_MIGRATE_WINDOW long and opens whatever is queued
+static uint8_t fixedWindows;
+static uint8_t inWindow;
+
+uint8_t nwkDB_CountTypes( uint8_t type );
+
+#include "test_zd_migrate_items.c"
+
+uint8_t nwkDB_CountTypes( uint8_t type )
+{
+  if ( fixedWindows )
+  {
+    return ( (inWindow && (type == NWK_DATABUF_WAITING)) ? 1 : 0 );
+  }
+
+  if ( type == NWK_DATABUF_WAITING )
+  {
+    return ( macQCnt - ((macDoneAt != 0) ? 1 : 0) );
+  }
+  if ( type == NWK_DATABUF_SENT )
+  {
+    return ( (macDoneAt != 0) ? 1 : 0 );
+  }
+  return ( 0 );
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+#define OLD_CHANNEL     11
+#define NEW_CHANNEL     20
+#define ROUTERS         60
+#define DEV_ADDR( x )   ( 0x0100 + (x) )
+
+typedef struct
+{
+  uint8_t  channel;     // Channel the device is on
+  uint32_t nextTx;      // Next frame or poll it sends
+} simDev_t;
+
+static simDev_t simDev[NWK_MAX_DEVICES];
+static uint32_t seed;
+
+static uint8_t reports;
+static ZDNwkMgr_MigrateReport_t lastReport;
+
+static void *reportCB( void *param )
+{
+  reports++;
+  lastReport = *(ZDNwkMgr_MigrateReport_t *)param;
+  return ( NULL );
+}
+
+static uint16_t rnd( uint16_t range )
+{
+  seed = (seed * 1103515245UL) + 12345UL;
+  return ( (uint16_t)((seed >> 12) % range) );
+}
+
+// Routers first, then children
+static void reset( uint16_t devices )
+{
+  uint16_t x;
+
+  memset( AssociatedDevList, 0, sizeof( AssociatedDevList ) );
+  memset( deadline, 0, sizeof( deadline ) );
+  memset( &ZDNwkMgr_Migrate, 0, sizeof( ZDNwkMgr_Migrate ) );
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    AssociatedDevList[x].shortAddr = INVALID_NODE_ADDR;
+    AssociatedDevList[x].nodeRelation = NOTUSED;
+    if ( x < devices )
+    {
+      AssociatedDevList[x].shortAddr = DEV_ADDR( x );
+      AssociatedDevList[x].nodeRelation = (x < ROUTERS) ? NEIGHBOR : CHILD_RFD_RX_IDLE;
+      AssociatedDevList[x].linkInfo.inFrmCntr = 1000 + x;
+      deadline[x] = 60000;
+    }
+  }
+
+  _NIB.nwkLogicalChannel = OLD_CHANNEL;
+  _NIB.BroadcastDeliveryTime = 30;
+  macChannel = OLD_CHANNEL;
+  macQCnt = 0;
+  macDoneAt = 0;
+  now = 0;
+  timerOn = FALSE;
+  fixedWindows = FALSE;
+  inWindow = FALSE;
+  reports = 0;
+  zdoCBFunc[ZDO_CHAN_MIGRATE_CBID] = reportCB;
+  ZDNwkMgr_MigrateEnable( TRUE );
+}
+
+// The network manager side of ZDNWKMGR_CHANNEL_CHANGE_EVT
+static void changeChannel( void )
+{
+  ZDNwkMgr_NewChannel = NEW_CHANNEL;
+  ZDNwkMgr_MigrateStart( _NIB.nwkLogicalChannel );
+  _NIB.nwkLogicalChannel = NEW_CHANNEL;
+  ZMacSetReq( ZMacChannel, &ZDNwkMgr_NewChannel );
+}
+
+// Run the migration timer up to ms
+static void runTimer( uint32_t ms )
+{
+  while ( timerOn && (timerDue <= ms) )
+  {
+    now = timerDue;
+    timerOn = FALSE;
+    inWindow = (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_OLD_CHANNEL);
+    ZDNwkMgr_MigrateProcess();
+  }
+  now = ms;
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testDisabled( void )
+{
+  reset( 10 );
+  ZDNwkMgr_MigrateEnable( FALSE );
+
+  changeChannel();
+  ZTEST_CHECK( ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_IDLE );
+  ZTEST_CHECK( !timerOn && (reports == 0) );
+
+  // Off by default
+  ZTEST_CHECK( ZDNWKMGR_MIGRATE_ENABLE == FALSE );
+}
+
+static void testTurnedOff( void )
+{
+  reset( 10 );
+
+  changeChannel();
+  ZTEST_CHECK( (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_TRACKING) &&
+               (ZDNwkMgr_Migrate.total == 10) );
+
+  // First window opened for the stragglers
+  runTimer( timerDue );
+  ZTEST_CHECK( ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_OLD_CHANNEL );
+  ZTEST_CHECK( (macChannel == OLD_CHANNEL) && (macQCnt == ZDNWKMGR_MIGRATE_BURST) );
+
+  // Back to the network right away
+  ZDNwkMgr_MigrateEnable( FALSE );
+  ZTEST_CHECK( (macChannel == NEW_CHANNEL) && !timerOn );
+  ZTEST_CHECK( (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_DONE) && (reports == 1) );
+}
+
+static void testDrained( void )
+{
+  uint8_t x;
+
+  reset( 10 );
+  changeChannel();
+
+  // Frames for the network queued, the window waits for them
+  macQueue( 1 );
+  macQueue( 2 );
+  runTimer( timerDue );
+  ZTEST_CHECK( (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_TRACKING) &&
+               (macChannel == NEW_CHANNEL) );
+  ZTEST_CHECK( timerOn && (timerDue == now + ZDNWKMGR_MIGRATE_POLL) );
+
+  macQCnt = 0;
+  runTimer( timerDue );
+  ZTEST_CHECK( (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_OLD_CHANNEL) &&
+               (macChannel == OLD_CHANNEL) );
+
+  // Stays while the updates go out, back once they are
+  for ( x = 0; x < 3; x++ )
+  {
+    runTimer( timerDue );
+    ZTEST_CHECK( macChannel == OLD_CHANNEL );
+  }
+  macQCnt = 0;
+  runTimer( timerDue );
+  ZTEST_CHECK( (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_TRACKING) &&
+               (macChannel == NEW_CHANNEL) );
+  ZTEST_CHECK( timerDue == now + ZDNWKMGR_MIGRATE_INTERVAL );
+
+  // Never longer than a window
+  runTimer( timerDue );
+  ZTEST_CHECK( macChannel == OLD_CHANNEL );
+  runTimer( now + ZDNWKMGR_MIGRATE_WINDOW + ZDNWKMGR_MIGRATE_POLL );
+  ZTEST_CHECK( (macChannel == NEW_CHANNEL) && (macQCnt == ZDNWKMGR_MIGRATE_BURST) );
+}
+
+/*********************************************************************
+ * SIMULATION
+ */
+typedef struct
+{
+  uint16_t missed;      // Devices that missed the broadcast
+  uint16_t heard;
+  uint16_t recovered;
+  uint32_t oldMs;       // Time spent on the old channel
+  uint32_t windows;
+  uint32_t traffic;     // Frames for the network
+  uint32_t offChannel;  // Of them, sent on the old channel
+  uint32_t endMs;
+} simResult_t;
+
+// 150 devices, 60 neighbor routers and 90 children, kept awake, each
+// sending every 1 to 10 s.  A fifth missed the channel change, 10% of
+// the frames heard on the new channel are lost and 30% of the updates
+// sent on the old one.  Other traffic reaches the MAC every 40 ms on
+// average.
+static void simRun( uint8_t fixed, simResult_t *pRes )
+{
+  uint16_t x;
+  uint16_t frame;
+  uint16_t devIdx;
+  uint32_t windowOpen = 0;
+  uint8_t lastState = ZDNWKMGR_MIGRATE_TRACKING;
+
+  reset( NWK_MAX_DEVICES );
+  fixedWindows = fixed;
+  seed = 0xC0FFEE;
+  memset( pRes, 0, sizeof( simResult_t ) );
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    simDev[x].channel = (rnd( 5 ) == 0) ? OLD_CHANNEL : NEW_CHANNEL;
+    simDev[x].nextTx = 1000 + rnd( 9000 );
+    pRes->missed += (simDev[x].channel == OLD_CHANNEL);
+  }
+
+  changeChannel();
+
+  for ( now = 1; now < 180000; now++ )
+  {
+    // Traffic for the network
+    if ( rnd( 40 ) == 0 )
+    {
+      macQueue( 1 );
+      pRes->traffic++;
+    }
+
+    // The devices heard on the new channel
+    for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+    {
+      if ( simDev[x].nextTx <= now )
+      {
+        simDev[x].nextTx = now + 1000 + rnd( 9000 );
+        if ( (simDev[x].channel == NEW_CHANNEL) && (macChannel == NEW_CHANNEL) && (rnd( 10 ) != 0) )
+        {
+          if ( x < ROUTERS )
+          {
+            AssociatedDevList[x].linkInfo.inFrmCntr++;
+          }
+          else
+          {
+            deadline[x] = now + 60000;
+          }
+        }
+      }
+    }
+
+    // The MAC
+    if ( (macDoneAt != 0) && (macDoneAt <= now) )
+    {
+      frame = macQ[0];
+      macQCnt--;
+      memmove( macQ, macQ + 1, macQCnt * sizeof( macQ[0] ) );
+      macDoneAt = 0;
+
+      if ( frame & FRAME_UPDATE )
+      {
+        devIdx = (frame & ~FRAME_UPDATE) - DEV_ADDR( 0 );
+        if ( (macTxChannel == OLD_CHANNEL) && (simDev[devIdx].channel == OLD_CHANNEL) &&
+             (rnd( 10 ) >= 3) )
+        {
+          simDev[devIdx].channel = NEW_CHANNEL;
+        }
+      }
+      else if ( macTxChannel != NEW_CHANNEL )
+      {
+        pRes->offChannel++;
+      }
+    }
+    if ( (macDoneAt == 0) && (macQCnt > 0) )
+    {
+      macDoneAt = now + MAC_FRAME_MS;
+      macTxChannel = macChannel;
+    }
+
+    // The migration
+    if ( timerOn && (timerDue <= now) )
+    {
+      runTimer( now );
+    }
+
+    if ( (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_OLD_CHANNEL) &&
+         (lastState != ZDNWKMGR_MIGRATE_OLD_CHANNEL) )
+    {
+      windowOpen = now;
+      pRes->windows++;
+    }
+    else if ( (ZDNwkMgr_Migrate.state != ZDNWKMGR_MIGRATE_OLD_CHANNEL) &&
+              (lastState == ZDNWKMGR_MIGRATE_OLD_CHANNEL) )
+    {
+      pRes->oldMs += now - windowOpen;
+    }
+    lastState = ZDNwkMgr_Migrate.state;
+
+    if ( (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_DONE) && (pRes->endMs == 0) )
+    {
+      pRes->endMs = now;
+    }
+  }
+
+  ZTEST_CHECK( ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_DONE );
+  ZTEST_CHECK( (reports > 0) && (lastReport.state == ZDNWKMGR_MIGRATE_DONE) );
+  ZTEST_CHECK( lastReport.total == NWK_MAX_DEVICES );
+  pRes->heard = lastReport.heard;
+  pRes->recovered = lastReport.recovered;
+}
+
+static void testNetwork( void )
+{
+  simResult_t res[2];
+  uint8_t x;
+
+  simRun( TRUE, &res[0] );
+  simRun( FALSE, &res[1] );
+
+  for ( x = 0; x < 2; x++ )
+  {
+    printf( "%s windows: %u missed, %u heard, %u recovered, done at %lu ms\n"
+            "               %lu windows, %lu ms on the old channel, %lu of %lu frames sent there\n",
+            (x == 0) ? "fixed  " : "drained",
+            res[x].missed, res[x].heard, res[x].recovered, (unsigned long)res[x].endMs,
+            (unsigned long)res[x].windows, (unsigned long)res[x].oldMs,
+            (unsigned long)res[x].offChannel, (unsigned long)res[x].traffic );
+  }
+
+  for ( x = 0; x < 2; x++ )
+  {
+    // Most stragglers brought over in their windows
+    ZTEST_CHECK( res[x].recovered > (res[x].missed * 3) / 4 );
+    ZTEST_CHECK( res[x].heard >= NWK_MAX_DEVICES - (res[x].missed / 4) );
+  }
+
+  ZTEST_CHECK( res[1].oldMs < res[0].oldMs / 2 );
+  ZTEST_CHECK( res[1].offChannel < res[0].offChannel / 2 );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testDisabled );
+  ZTEST_RUN( testTurnedOff );
+  ZTEST_RUN( testDrained );
+  ZTEST_RUN( testNetwork );
+
+  return ( ZTEST_RESULT );
+}
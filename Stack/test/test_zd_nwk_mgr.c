@@ -0,0 +1,312 @@
+/**************************************************************************************************
+  Filename:       test_zd_nwk_mgr.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the formation channel evaluation of the
+                  network manager: ED scan passes, scoring, the Wi-Fi
+                  penalty and a failed scan, and the Mgmt_NWK_Update_notify
+                  confirm among the confirms of other endpoints.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "nwk.h"
+#include "af.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define ZDO_EP  0
+
+uint8_t ZDNwkMgr_TaskID = 7;
+nwkIB_t _NIB;
+
+static uint8_t timerCnt;
+static uint32_t timerEvt;
+static uint32_t timerTimeout;
+
+static uint8_t scanCnt;
+static uint32_t scanMask;
+static uint8_t scanDuration;
+static ZStatus_t scanStatus = ZSuccess;
+
+uint8_t OsalPortTimers_startTimer( uint8_t taskId, uint32_t eventId, uint32_t timeout )
+{
+  ZTEST_CHECK( taskId == ZDNwkMgr_TaskID );
+  timerCnt++;
+  timerEvt = eventId;
+  timerTimeout = timeout;
+  return ( SUCCESS );
+}
+
+ZStatus_t NLME_EDScanRequest( uint32_t ScanChannels, uint8_t duration )
+{
+  scanCnt++;
+  scanMask = ScanChannels;
+  scanDuration = duration;
+  return ( scanStatus );
+}
+
+static uint8_t failuresCleared;
+
+uint8_t nwkTransmissionFailures( uint8_t clear )
+{
+  failuresCleared += clear;
+  return ( 0 );
+}
+
+#include "test_zd_nwk_mgr_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define ALL_CHANNELS  0x07FFF800
+
+static uint8_t doneCnt;
+static uint8_t doneChannel;
+
+static void doneCB( uint8_t channel )
+{
+  doneCnt++;
+  doneChannel = channel;
+}
+
+static void reset( uint8_t passes, uint16_t wifiChannels )
+{
+  ZDNwkMgr_ChanEvalCfg_t cfg = { passes, 3, 250, wifiChannels };
+
+  ZDNwkMgr_ChanEvalConfig( &cfg );
+  timerCnt = 0;
+  scanCnt = 0;
+  scanStatus = ZSuccess;
+  doneCnt = 0;
+  doneChannel = 0xFF;
+}
+
+// Confirm of an ED scan pass, energy of each channel from a table
+static void confirm( uint8_t status, uint32_t scanned, const uint8_t *energy )
+{
+  ZDNwkMgr_EDScanConfirm_t msg;
+  uint8_t ch;
+
+  memset( &msg, 0, sizeof( msg ) );
+  msg.status = status;
+  msg.scannedChannels = scanned;
+  for ( ch = ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL; ch < ED_SCAN_MAXCHANNELS; ch++ )
+  {
+    msg.energyDetectList[ch] = energy ? energy[ch - ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL] : 0;
+  }
+
+  ZDNwkMgr_ChanEvalProcessScan( &msg );
+}
+
+static void fill( uint8_t *energy, uint8_t value )
+{
+  memset( energy, value, ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testConfig( void )
+{
+  ZDNwkMgr_ChanEvalCfg_t cfg;
+
+  // Disabled by default
+  ZDNwkMgr_ChanEvalGetConfig( &cfg );
+  ZTEST_CHECK( cfg.passes == ZDNWKMGR_CHAN_EVAL_PASSES );
+  ZTEST_CHECK( cfg.scanDuration == ZDNWKMGR_CHAN_EVAL_SCAN_DURATION );
+  ZTEST_CHECK( cfg.interval == ZDNWKMGR_CHAN_EVAL_INTERVAL );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == FALSE );
+
+  reset( 4, 0x0421 );
+  ZDNwkMgr_ChanEvalGetConfig( &cfg );
+  ZTEST_CHECK( (cfg.passes == 4) && (cfg.scanDuration == 3) );
+  ZTEST_CHECK( (cfg.interval == 250) && (cfg.wifiChannels == 0x0421) );
+}
+
+static void testStart( void )
+{
+  reset( 2, 0 );
+
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( 0, doneCB ) == FALSE );
+  ZTEST_CHECK( scanCnt == 0 );
+
+  // The first scan refused, not busy after
+  scanStatus = ZFailure;
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == FALSE );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalMask == 0 );
+  scanStatus = ZSuccess;
+
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == TRUE );
+  ZTEST_CHECK( (scanMask == ALL_CHANNELS) && (scanDuration == 3) );
+
+  // One at a time
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == FALSE );
+
+  confirm( ZSuccess, ALL_CHANNELS, NULL );
+  confirm( ZSuccess, ALL_CHANNELS, NULL );
+  ZTEST_CHECK( doneCnt == 1 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == TRUE );
+  confirm( ZSuccess, ALL_CHANNELS, NULL );
+  confirm( ZSuccess, ALL_CHANNELS, NULL );
+  ZTEST_CHECK( doneCnt == 2 );
+}
+
+static void testPasses( void )
+{
+  uint8_t energy[ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS];
+  ZDNwkMgr_ChanEvalScore_t score;
+
+  reset( 3, 0 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == TRUE );
+  ZTEST_CHECK( scanCnt == 1 );
+
+  // Channel 15 steady at 40, 20 at 10 with a burst of 100, 25 steady at 30
+  fill( energy, 200 );
+  energy[15 - 11] = 40;
+  energy[20 - 11] = 10;
+  energy[25 - 11] = 30;
+  confirm( ZSuccess, ALL_CHANNELS, energy );
+  ZTEST_CHECK( (timerCnt == 1) && (timerEvt == ZDNWKMGR_CHAN_EVAL_EVT) && (timerTimeout == 250) );
+  ZTEST_CHECK( doneCnt == 0 );
+
+  confirm( ZSuccess, ALL_CHANNELS, energy );
+  ZTEST_CHECK( timerCnt == 2 );
+
+  energy[20 - 11] = 100;
+  confirm( ZSuccess, ALL_CHANNELS, energy );
+  ZTEST_CHECK( timerCnt == 2 );
+  ZTEST_CHECK( (doneCnt == 1) && (doneChannel == 25) );
+
+  ZDNwkMgr_ChanEvalGetScore( 15, &score );
+  ZTEST_CHECK( (score.mean == 40) && (score.peak == 40) && (score.score == 40) );
+  ZDNwkMgr_ChanEvalGetScore( 20, &score );
+  ZTEST_CHECK( (score.mean == 40) && (score.peak == 100) && (score.score == (3 * 40 + 100) / 4) );
+  ZDNwkMgr_ChanEvalGetScore( 25, &score );
+  ZTEST_CHECK( (score.mean == 30) && (score.peak == 30) && (score.score == 30) );
+  ZDNwkMgr_ChanEvalGetScore( 10, &score );
+  ZTEST_CHECK( score.score == 0xFF );
+  ZDNwkMgr_ChanEvalGetScore( 27, &score );
+  ZTEST_CHECK( score.score == 0xFF );
+
+  // Only the channels asked for
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalBest( ALL_CHANNELS & ~BV( 25 ) ) == 15 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalBest( BV( 20 ) | BV( 26 ) ) == 20 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalBest( BV( 26 ) ) == 26 );
+}
+
+static void testWifi( void )
+{
+  uint8_t energy[ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS];
+  ZDNwkMgr_ChanEvalScore_t score;
+
+  // Wi-Fi channels 1, 6 and 11
+  reset( 1, BV( 0 ) | BV( 5 ) | BV( 10 ) );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == TRUE );
+  fill( energy, 20 );
+  confirm( ZSuccess, ALL_CHANNELS, energy );
+
+  // Ties go to the lowest channel
+  ZTEST_CHECK( (doneCnt == 1) && (doneChannel == 25) );
+
+  ZDNwkMgr_ChanEvalGetScore( 11, &score );
+  ZTEST_CHECK( score.score == 20 + ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY );
+  ZDNwkMgr_ChanEvalGetScore( 14, &score );
+  ZTEST_CHECK( score.score == 20 + ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY );
+  ZDNwkMgr_ChanEvalGetScore( 15, &score );
+  ZTEST_CHECK( score.score == 20 + ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY / 2 );
+  ZDNwkMgr_ChanEvalGetScore( 20, &score );
+  ZTEST_CHECK( score.score == 20 + ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY / 2 );
+  ZDNwkMgr_ChanEvalGetScore( 24, &score );
+  ZTEST_CHECK( score.score == 20 + ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY );
+  ZDNwkMgr_ChanEvalGetScore( 26, &score );
+  ZTEST_CHECK( score.score == 20 );
+
+  // Penalty and energy add up to no more than 0xFF
+  reset( 1, BV( 0 ) );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == TRUE );
+  fill( energy, 0xF0 );
+  confirm( ZSuccess, ALL_CHANNELS, energy );
+  ZDNwkMgr_ChanEvalGetScore( 11, &score );
+  ZTEST_CHECK( score.score == 0xFF );
+  ZTEST_CHECK( doneChannel == 15 );
+}
+
+static void testScanFail( void )
+{
+  uint8_t energy[ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS];
+
+  // Picks from the passes done so far
+  reset( 3, 0 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == TRUE );
+  fill( energy, 50 );
+  energy[26 - 11] = 5;
+  confirm( ZSuccess, ALL_CHANNELS, energy );
+  confirm( ZFailure, 0, NULL );
+  ZTEST_CHECK( (doneCnt == 1) && (doneChannel == 26) );
+  ZTEST_CHECK( timerCnt == 1 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalMask == 0 );
+
+  // None done, no channel
+  reset( 3, 0 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == TRUE );
+  confirm( ZFailure, 0, NULL );
+  ZTEST_CHECK( (doneCnt == 1) && (doneChannel == 0) );
+}
+
+static void testUnscanned( void )
+{
+  uint8_t energy[ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS];
+
+  // Channels left out of every pass never win
+  reset( 2, 0 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalStart( ALL_CHANNELS, doneCB ) == TRUE );
+  fill( energy, 0 );
+  energy[20 - 11] = 90;
+  energy[21 - 11] = 80;
+  confirm( ZSuccess, BV( 20 ) | BV( 21 ), energy );
+  confirm( ZSuccess, BV( 20 ) | BV( 21 ), energy );
+  ZTEST_CHECK( (doneCnt == 1) && (doneChannel == 21) );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalBest( BV( 20 ) | BV( 26 ) ) == 20 );
+  ZTEST_CHECK( ZDNwkMgr_ChanEvalBest( BV( 11 ) | BV( 26 ) ) == 0 );
+}
+
+static void testNotifyConfirm( void )
+{
+  afDataConfirm_t cnf = { { 0, ZSuccess }, ZDO_EP, 0, 0 };
+
+  ZDNwkMgr_WaitingForNotifyConfirm = TRUE;
+  _NIB.nwkTotalTransmissions = 100;
+  failuresCleared = 0;
+
+  // The UTC time server's first response confirms through ZDApp too
+  cnf.endpoint = 10;
+  ZDNwkMgr_ProcessDataConfirm( &cnf );
+  ZTEST_CHECK( ZDNwkMgr_WaitingForNotifyConfirm == TRUE );
+  ZTEST_CHECK( (_NIB.nwkTotalTransmissions == 100) && (failuresCleared == 0) );
+
+  cnf.endpoint = ZDO_EP;
+  cnf.hdr.status = ZFailure;
+  ZDNwkMgr_ProcessDataConfirm( &cnf );
+  ZTEST_CHECK( ZDNwkMgr_WaitingForNotifyConfirm == TRUE );
+
+  cnf.hdr.status = ZSuccess;
+  ZDNwkMgr_ProcessDataConfirm( &cnf );
+  ZTEST_CHECK( ZDNwkMgr_WaitingForNotifyConfirm == FALSE );
+  ZTEST_CHECK( (_NIB.nwkTotalTransmissions == 0) && (failuresCleared == 1) );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testConfig );
+  ZTEST_RUN( testStart );
+  ZTEST_RUN( testPasses );
+  ZTEST_RUN( testWifi );
+  ZTEST_RUN( testScanFail );
+  ZTEST_RUN( testUnscanned );
+  ZTEST_RUN( testNotifyConfirm );
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,263 @@
+/**************************************************************************************************
+  Filename:       test_zd_object.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the sorted view of the RFD children ZDO
+                  checks Child_info entries against: which children are
+                  in it, the binary search, and rebuilding it only when
+                  the association table changed.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "nwk_globals.h"
+#include "assoc_list.h"
+#include "addr_mgr.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+associated_devices_t AssociatedDevList[NWK_MAX_DEVICES];
+
+// Address manager, extended addresses by index
+static uint8_t addrExt[NWK_MAX_ADDRESSES][Z_EXTADDR_LEN];
+static uint8_t addrUsed[NWK_MAX_ADDRESSES];
+static uint16_t addrGets;
+
+uint8_t AddrMgrEntryGet( AddrMgrEntry_t* entry )
+{
+  addrGets++;
+  if ( (entry->index >= NWK_MAX_ADDRESSES) || !addrUsed[entry->index] )
+  {
+    return ( FALSE );
+  }
+
+  osal_cpyExtAddr( entry->extAddr, addrExt[entry->index] );
+
+  return ( TRUE );
+}
+
+#include "test_zd_object_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+static void reset( void )
+{
+  uint16_t x;
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    memset( &AssociatedDevList[x], 0, sizeof( associated_devices_t ) );
+    AssociatedDevList[x].shortAddr = INVALID_NODE_ADDR;
+    AssociatedDevList[x].nodeRelation = NOTUSED;
+  }
+  memset( addrUsed, 0, sizeof( addrUsed ) );
+  addrGets = 0;
+  zdoRfdChildViewValid = FALSE;
+}
+
+// Extended address with the first (most significant) byte and the last
+static void extOf( uint8_t *extAddr, uint8_t hi, uint8_t lo )
+{
+  memset( extAddr, 0x55, Z_EXTADDR_LEN );
+  extAddr[0] = hi;
+  extAddr[Z_EXTADDR_LEN - 1] = lo;
+}
+
+static void childAdd( uint16_t x, uint16_t shortAddr, uint8_t relation, bool keepalive,
+                      uint16_t addrIdx, uint8_t hi )
+{
+  associated_devices_t *dev = &AssociatedDevList[x];
+
+  dev->shortAddr = shortAddr;
+  dev->nodeRelation = relation;
+  dev->keepaliveRcv = keepalive;
+  dev->addrIdx = addrIdx;
+
+  if ( addrIdx < NWK_MAX_ADDRESSES )
+  {
+    extOf( addrExt[addrIdx], hi, (uint8_t)x );
+    addrUsed[addrIdx] = TRUE;
+  }
+}
+
+static uint8_t find( uint8_t hi, uint8_t lo )
+{
+  uint8_t extAddr[Z_EXTADDR_LEN];
+
+  extOf( extAddr, hi, lo );
+
+  return ( zdoRfdChildViewFind( extAddr ) );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testEmpty( void )
+{
+  reset();
+
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( zdoRfdChildViewCnt == 0 );
+  ZTEST_CHECK( find( 0x55, 0x55 ) == FALSE );
+  ZTEST_CHECK( addrGets == 0 );
+}
+
+static void testSorted( void )
+{
+  const uint8_t his[] = { 0x90, 0x10, 0xF0, 0x50, 0x30, 0x00, 0xFF, 0x70 };
+  uint16_t x;
+
+  reset();
+
+  for ( x = 0; x < sizeof( his ); x++ )
+  {
+    childAdd( x, 0x1000 + x, CHILD_RFD, TRUE, x + 3, his[x] );
+  }
+
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( zdoRfdChildViewCnt == sizeof( his ) );
+  for ( x = 1; x < zdoRfdChildViewCnt; x++ )
+  {
+    ZTEST_CHECK( memcmp( zdoRfdChildView[x - 1].extAddr, zdoRfdChildView[x].extAddr,
+                         Z_EXTADDR_LEN ) < 0 );
+  }
+
+  for ( x = 0; x < sizeof( his ); x++ )
+  {
+    ZTEST_CHECK( find( his[x], (uint8_t)x ) == TRUE );
+  }
+
+  // Below, between and above the children
+  ZTEST_CHECK( find( 0x00, 0x00 ) == FALSE );
+  ZTEST_CHECK( find( 0x50, 0x04 ) == FALSE );
+  ZTEST_CHECK( find( 0x60, 0x03 ) == FALSE );
+  ZTEST_CHECK( find( 0xFF, 0xFF ) == FALSE );
+}
+
+static void testWhichChildren( void )
+{
+  reset();
+
+  childAdd( 0, 0x1000, CHILD_RFD, TRUE, 0, 0x10 );
+  childAdd( 1, 0x1001, CHILD_RFD_RX_IDLE, TRUE, 1, 0x20 );
+  childAdd( 2, 0x1002, CHILD_RFD, FALSE, 2, 0x30 );
+  childAdd( 3, 0x1003, CHILD_FFD, TRUE, 3, 0x40 );
+  childAdd( 4, 0x1004, NEIGHBOR, TRUE, 4, 0x50 );
+  childAdd( 5, INVALID_NODE_ADDR, CHILD_RFD, TRUE, 5, 0x60 );
+
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( zdoRfdChildViewCnt == 2 );
+  ZTEST_CHECK( zdoRfdChildKeyCnt == 2 );
+  ZTEST_CHECK( find( 0x10, 0 ) == TRUE );
+  ZTEST_CHECK( find( 0x20, 1 ) == TRUE );
+  ZTEST_CHECK( find( 0x30, 2 ) == FALSE );
+  ZTEST_CHECK( find( 0x40, 3 ) == FALSE );
+  ZTEST_CHECK( find( 0x50, 4 ) == FALSE );
+  ZTEST_CHECK( find( 0x60, 5 ) == FALSE );
+
+  // A child the address manager lost is left out of the view only
+  reset();
+  childAdd( 0, 0x1000, CHILD_RFD, TRUE, 0, 0x10 );
+  childAdd( 1, 0x1001, CHILD_RFD, TRUE, 1, 0x20 );
+  addrUsed[0] = FALSE;
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( (zdoRfdChildKeyCnt == 2) && (zdoRfdChildViewCnt == 1) );
+  ZTEST_CHECK( find( 0x10, 0 ) == FALSE );
+  ZTEST_CHECK( find( 0x20, 1 ) == TRUE );
+}
+
+static void testRebuild( void )
+{
+  uint16_t gets;
+
+  reset();
+
+  childAdd( 0, 0x1000, CHILD_RFD, TRUE, 0, 0x10 );
+  childAdd( 2, 0x1002, CHILD_RFD, TRUE, 2, 0x30 );
+  childAdd( 4, 0x1004, CHILD_RFD, TRUE, 4, 0x50 );
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == 3 );
+
+  // Nothing changed
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == 3 );
+
+  // Changes to other entries don't count
+  childAdd( 1, 0x1001, CHILD_FFD, TRUE, 1, 0x20 );
+  AssociatedDevList[0].age = 7;
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == 3 );
+
+  // Added last
+  childAdd( 6, 0x1006, CHILD_RFD, TRUE, 6, 0x70 );
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == 3 + 4 );
+  ZTEST_CHECK( find( 0x70, 6 ) == TRUE );
+
+  // Removed last
+  gets = addrGets;
+  AssociatedDevList[6].shortAddr = INVALID_NODE_ADDR;
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == gets + 3 );
+  ZTEST_CHECK( find( 0x70, 6 ) == FALSE );
+
+  // Keep alive cleared
+  gets = addrGets;
+  AssociatedDevList[2].keepaliveRcv = FALSE;
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == gets + 2 );
+  ZTEST_CHECK( find( 0x30, 2 ) == FALSE );
+
+  // Another device in the same entry
+  gets = addrGets;
+  childAdd( 4, 0x2004, CHILD_RFD, TRUE, 4, 0x58 );
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == gets + 2 );
+  ZTEST_CHECK( find( 0x50, 4 ) == FALSE );
+  ZTEST_CHECK( find( 0x58, 4 ) == TRUE );
+
+  // Same device, moved in the address manager
+  gets = addrGets;
+  childAdd( 4, 0x2004, CHILD_RFD, TRUE, 9, 0x5C );
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == gets + 2 );
+  ZTEST_CHECK( find( 0x5C, 4 ) == TRUE );
+
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( addrGets == gets + 2 );
+}
+
+static void testFull( void )
+{
+  uint16_t x;
+
+  reset();
+
+  // Every entry a child, in descending order
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    childAdd( x, 0x1000 + x, CHILD_RFD, TRUE, x, (uint8_t)(0xF0 - (x * 8)) );
+  }
+
+  zdoRfdChildViewSync();
+  ZTEST_CHECK( zdoRfdChildViewCnt == NWK_MAX_DEVICES );
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    ZTEST_CHECK( find( (uint8_t)(0xF0 - (x * 8)), (uint8_t)x ) == TRUE );
+    ZTEST_CHECK( find( (uint8_t)(0xF0 - (x * 8) + 1), (uint8_t)x ) == FALSE );
+  }
+}
+
+int main( void )
+{
+  ZTEST_RUN( testEmpty );
+  ZTEST_RUN( testSorted );
+  ZTEST_RUN( testWhichChildren );
+  ZTEST_RUN( testRebuild );
+  ZTEST_RUN( testFull );
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,1081 @@
+/**************************************************************************************************
+  Filename:       test_zd_profile.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the ZDP frames built in place by the
+                  ZDP_Build* writer.  Every ZDP request and response is
+                  sent with fixed arguments and the frames handed to AF
+                  (cluster, TX options, destination and bytes) are
+                  compared with the frames the ZDP_TmpBuf builders sent
+                  for the same arguments, recorded in EXPECTED FRAMES.
+                  Frames past the old 80 byte buffer, the writer's
+                  bounds and frames built side by side are checked too.
+**************************************************************************************************/
+
+#include <stdlib.h>
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "af.h"
+#include "assoc_list.h"
+#include "addr_mgr.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define CONST                               const
+#define ZSUCCESS                            ZSuccess
+#define ZBufferFull                         0x11
+#define afStatus_FAILED                     0x80
+
+#define ZSTACK_ROUTER_BUILD                 TRUE
+#define BEACON_ORDER_NO_BEACONS             15
+#define NWK_BROADCAST_SHORTADDR_DEVALL      0xFFFF
+#define NWK_BROADCAST_SHORTADDR_DEVRXON     0xFFFD
+#define NWK_BROADCAST_SHORTADDR_DEVZCZR     0xFFFC
+
+#define HEAP_BLOCKS                         32
+#define SENT_LOG_MAX                        1024
+
+// As in the tree, returns the end of the copy
+#undef osal_cpyExtAddr
+#define osal_cpyExtAddr( a, b )             OsalPort_memcpy( (a), (b), Z_EXTADDR_LEN )
+
+static uint16_t heapLive;
+static uint16_t heapFailIn;     // Fail the n-th allocation from now, 0 never
+
+void* OsalPort_malloc( uint32_t size )
+{
+  if ( heapFailIn && (--heapFailIn == 0) )
+  {
+    return ( NULL );
+  }
+
+  heapLive++;
+  return ( malloc( size ) );
+}
+
+void OsalPort_free( void* buf )
+{
+  ZTEST_CHECK( heapLive > 0 );
+  heapLive--;
+  free( buf );
+}
+
+void *OsalPort_memcpy( void *dst, const void *src, unsigned int len )
+{
+  memcpy( dst, src, len );
+  return ( (uint8_t *)dst + len );
+}
+
+uint8_t *OsalPort_bufferUint32( uint8_t *buf, uint32_t val )
+{
+  *buf++ = (uint8_t)val;
+  *buf++ = (uint8_t)(val >> 8);
+  *buf++ = (uint8_t)(val >> 16);
+  *buf++ = (uint8_t)(val >> 24);
+  return ( buf );
+}
+
+static uint8_t ownExtAddr[Z_EXTADDR_LEN] = { 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8 };
+
+uint8_t *saveExtAddr = ownExtAddr;
+zAddrType_t ZDAppNwkAddr = { { 0x0000 }, Addr16Bit };
+uint8_t ZDAppTaskID = 4;
+endPointDesc_t ZDApp_epDesc;
+
+uint16_t NLME_GetShortAddr( void )
+{
+  return ( ZDAppNwkAddr.addr.shortAddr );
+}
+
+uint8_t *NLME_GetExtAddr( void )
+{
+  return ( saveExtAddr );
+}
+
+static uint8_t parentAnnceTimers;
+
+void ZDApp_SetParentAnnceTimer( void )
+{
+  parentAnnceTimers++;
+}
+
+uint8_t OsalPortTimers_startTimer( uint8_t task, uint32_t event, uint32_t timeout )
+{
+  (void)task;
+  (void)event;
+  (void)timeout;
+  parentAnnceTimers++;
+  return ( 0 );
+}
+
+// Association table: one RFD child, the end devices of AssocMakeList()
+static associated_devices_t rfdChild = { 0x3344, 2, CHILD_RFD };
+static uint8_t rfdChildExt[Z_EXTADDR_LEN] = { 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38 };
+static uint8_t assocCnt;
+
+associated_devices_t *AssocGetWithExt( uint8_t *extAddr )
+{
+  return ( osal_ExtAddrEqual( extAddr, rfdChildExt ) ? &rfdChild : NULL );
+}
+
+associated_devices_t *AssocGetWithShort( uint16_t shortAddr )
+{
+  return ( (shortAddr == rfdChild.shortAddr) ? &rfdChild : NULL );
+}
+
+uint16_t *AssocMakeList( uint8_t *pCount )
+{
+  uint16_t *pList;
+  uint8_t x;
+
+  *pCount = assocCnt;
+  if ( assocCnt == 0 )
+  {
+    return ( NULL );
+  }
+
+  pList = OsalPort_malloc( assocCnt * sizeof( uint16_t ) );
+  for ( x = 0; x < assocCnt; x++ )
+  {
+    pList[x] = 0x7000 + x;
+  }
+
+  return ( pList );
+}
+
+uint8_t AddrMgrEntryGet( AddrMgrEntry_t *entry )
+{
+  if ( entry->index != rfdChild.addrIdx )
+  {
+    return ( FALSE );
+  }
+
+  memcpy( entry->extAddr, rfdChildExt, Z_EXTADDR_LEN );
+  return ( TRUE );
+}
+
+// AF: each frame logged as | cluster 2 | options | addrMode | dst 2 | len | frame |
+static uint8_t sentLog[SENT_LOG_MAX];
+static uint16_t sentLen;
+static uint8_t sentFrames;
+static afStatus_t afStatus = afStatus_SUCCESS;
+
+afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                           uint16_t cID, uint16_t len, uint8_t *buf, uint8_t *transID,
+                           uint8_t options, uint8_t radius )
+{
+  uint8_t *pLog = sentLog + sentLen;
+
+  (void)transID;
+  (void)radius;
+
+  ZTEST_CHECK( srcEP == &ZDApp_epDesc );
+  ZTEST_CHECK( dstAddr->endPoint == 0 );
+
+  if ( afStatus != afStatus_SUCCESS )
+  {
+    return ( afStatus );
+  }
+
+  ZTEST_CHECK( sentLen + 7 + len <= SENT_LOG_MAX );
+  *pLog++ = LO_UINT16( cID );
+  *pLog++ = HI_UINT16( cID );
+  *pLog++ = options;
+  *pLog++ = dstAddr->addrMode;
+  *pLog++ = LO_UINT16( dstAddr->addr.shortAddr );
+  *pLog++ = HI_UINT16( dstAddr->addr.shortAddr );
+  *pLog++ = (uint8_t)len;
+  memcpy( pLog, buf, len );
+
+  sentLen += 7 + len;
+  sentFrames++;
+
+  return ( afStatus_SUCCESS );
+}
+
+#include "test_zd_profile_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define SENT_IS( exp )      sentIs( (exp), sizeof( exp ) )
+
+static uint8_t ieeeA[Z_EXTADDR_LEN] = { 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18 };
+static uint8_t ieeeB[Z_EXTADDR_LEN] = { 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28 };
+static cId_t inClusters[] = { 0x0006, 0x0008, 0x0300 };
+static cId_t outClusters[] = { 0x0019, 0x0500 };
+
+static zAddrType_t dst16;
+
+// Start a frame: a known sequence number, an empty log
+static void sendStart( void )
+{
+  ZTEST_CHECK( heapLive == 0 );
+  ZDP_SeqNum = 0x40;
+  ZDP_TxOptions = AF_TX_OPTIONS_NONE;
+  sentLen = 0;
+  sentFrames = 0;
+  afStatus = afStatus_SUCCESS;
+  heapFailIn = 0;
+  dst16.addrMode = Addr16Bit;
+  dst16.addr.shortAddr = 0x1234;
+}
+
+static uint8_t sentIs( const uint8_t *pExp, uint16_t len )
+{
+  return ( (sentLen == len) && (memcmp( sentLog, pExp, len ) == 0) );
+}
+
+static zdoIncomingMsg_t *inMsgSet( zdoIncomingMsg_t *pMsg, cId_t clusterID, uint8_t *pAsdu,
+                                   uint8_t asduLen, uint8_t wasBroadcast )
+{
+  memset( pMsg, 0, sizeof( zdoIncomingMsg_t ) );
+  pMsg->srcAddr.addrMode = Addr16Bit;
+  pMsg->srcAddr.addr.shortAddr = 0x2468;
+  pMsg->wasBroadcast = wasBroadcast;
+  pMsg->clusterID = clusterID;
+  pMsg->TransSeq = 0x5A;
+  pMsg->asdu = pAsdu;
+  pMsg->asduLen = asduLen;
+
+  return ( pMsg );
+}
+
+static void lqiItemSet( ZDP_MgmtLqiItem_t *pItem, uint8_t x )
+{
+  memset( pItem->extPanID, 0xD0 + x, Z_EXTADDR_LEN );
+  memset( pItem->extAddr, 0xE0 + x, Z_EXTADDR_LEN );
+  pItem->panID = 0x1A62;
+  pItem->nwkAddr = 0x6000 + x;
+  pItem->devType = x % 3;
+  pItem->rxOnIdle = (x & 1) ? ZDP_MGMT_BOOL_RECEIVER_ON : ZDP_MGMT_BOOL_RECEIVER_OFF;
+  pItem->relation = x % 4;
+  pItem->permit = x & 1;
+  pItem->depth = x + 1;
+  pItem->lqi = 200 - x;
+}
+
+/*********************************************************************
+ * EXPECTED FRAMES
+ *
+ * Sent by the ZDP_TmpBuf builders for the arguments of the tests below,
+ * in the sentLog layout.
+ */
+static const uint8_t expNodeDescReq[] =
+{
+  0x02, 0x00, 0x00, 0x02, 0x34, 0x12, 0x03, 0x40, 0x78, 0x56,
+};
+
+static const uint8_t expPowerDescReq[] =
+{
+  0x03, 0x00, 0x00, 0x02, 0x34, 0x12, 0x03, 0x40, 0x78, 0x56,
+};
+
+static const uint8_t expActiveEPReq[] =
+{
+  0x05, 0x00, 0x00, 0x02, 0x34, 0x12, 0x03, 0x40, 0x78, 0x56,
+};
+
+static const uint8_t expComplexDescReq[] =
+{
+  0x10, 0x00, 0x00, 0x02, 0x34, 0x12, 0x03, 0x40, 0x78, 0x56,
+};
+
+static const uint8_t expUserDescReq[] =
+{
+  0x11, 0x00, 0x00, 0x02, 0x34, 0x12, 0x03, 0x40, 0x78, 0x56,
+};
+
+static const uint8_t expMgmtLqiReq[] =
+{
+  0x31, 0x00, 0x00, 0x02, 0x34, 0x12, 0x02, 0x40, 0x02,
+};
+
+static const uint8_t expMgmtRtgReq[] =
+{
+  0x32, 0x00, 0x00, 0x02, 0x34, 0x12, 0x02, 0x40, 0x02,
+};
+
+static const uint8_t expMgmtBindReq[] =
+{
+  0x33, 0x00, 0x40, 0x02, 0x34, 0x12, 0x02, 0x40, 0x02,
+};
+
+static const uint8_t expStatusRsps[] =
+{
+  0x14, 0x80, 0x00, 0x02, 0x34, 0x12, 0x02, 0x77, 0x84,
+  0x20, 0x80, 0x00, 0x02, 0x34, 0x12, 0x02, 0x78, 0x84,
+  0x21, 0x80, 0x00, 0x02, 0x34, 0x12, 0x02, 0x79, 0x84,
+  0x22, 0x80, 0x00, 0x02, 0x34, 0x12, 0x02, 0x7A, 0x84,
+  0x34, 0x80, 0x00, 0x02, 0x34, 0x12, 0x02, 0x7B, 0x84,
+  0x36, 0x80, 0x00, 0x02, 0x34, 0x12, 0x02, 0x7C, 0x84,
+  0x35, 0x80, 0x00, 0x02, 0x34, 0x12, 0x02, 0x7D, 0x84,
+};
+
+static const uint8_t expNwkAddrReq[] =
+{
+  0x00, 0x00, 0x00, 0x0F, 0xFD, 0xFF, 0x0B, 0x40, 0x11, 0x12, 0x13, 0x14,
+    0x15, 0x16, 0x17, 0x18, 0x01, 0x02,
+  0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x0B, 0x41, 0xA1, 0xA2, 0xA3, 0xA4,
+    0xA5, 0xA6, 0xA7, 0xA8, 0x00, 0x00,
+};
+
+static const uint8_t expIEEEAddrReq[] =
+{
+  0x01, 0x00, 0x00, 0x02, 0x78, 0x56, 0x05, 0x40, 0x78, 0x56, 0x00, 0x00,
+};
+
+static const uint8_t expMatchDescReq[] =
+{
+  0x06, 0x00, 0x00, 0x02, 0xFD, 0xFF, 0x11, 0x40, 0xFD, 0xFF, 0x04, 0x01,
+    0x03, 0x06, 0x00, 0x08, 0x00, 0x00, 0x03, 0x02, 0x19, 0x00, 0x00, 0x05,
+};
+
+static const uint8_t expSimpleDescReq[] =
+{
+  0x04, 0x00, 0x00, 0x02, 0x34, 0x12, 0x04, 0x40, 0x78, 0x56, 0x08,
+};
+
+static const uint8_t expUserDescSet[] =
+{
+  0x14, 0x00, 0x00, 0x02, 0x34, 0x12, 0x14, 0x40, 0x78, 0x56, 0x07, 0x6B,
+    0x69, 0x74, 0x63, 0x68, 0x65, 0x6E, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20,
+};
+
+static const uint8_t expServerDiscReq[] =
+{
+  0x15, 0x00, 0x40, 0x0F, 0xFD, 0xFF, 0x03, 0x40, 0x41, 0x00,
+  0x15, 0x00, 0x00, 0x0F, 0xFD, 0xFF, 0x03, 0x41, 0x04, 0x00,
+};
+
+static const uint8_t expDeviceAnnce[] =
+{
+  0x13, 0x00, 0x00, 0x0F, 0xFD, 0xFF, 0x0C, 0x40, 0x78, 0x56, 0x11, 0x12,
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x8E,
+};
+
+static const uint8_t expParentAnnce[] =
+{
+  0x1F, 0x00, 0x00, 0x0F, 0xFC, 0xFF, 0x1A, 0x40, 0x03, 0x90, 0x90, 0x90,
+    0x90, 0x90, 0x90, 0x90, 0x90, 0x91, 0x91, 0x91, 0x91, 0x91, 0x91, 0x91,
+    0x91, 0x92, 0x92, 0x92, 0x92, 0x92, 0x92, 0x92, 0x92,
+};
+
+static const uint8_t expParentAnnceSplit[] =
+{
+  0x1F, 0x00, 0x00, 0x0F, 0xFC, 0xFF, 0x4A, 0x40, 0x09, 0x90, 0x90, 0x90,
+    0x90, 0x90, 0x90, 0x90, 0x90, 0x91, 0x91, 0x91, 0x91, 0x91, 0x91, 0x91,
+    0x91, 0x92, 0x92, 0x92, 0x92, 0x92, 0x92, 0x92, 0x92, 0x93, 0x93, 0x93,
+    0x93, 0x93, 0x93, 0x93, 0x93, 0x94, 0x94, 0x94, 0x94, 0x94, 0x94, 0x94,
+    0x94, 0x95, 0x95, 0x95, 0x95, 0x95, 0x95, 0x95, 0x95, 0x96, 0x96, 0x96,
+    0x96, 0x96, 0x96, 0x96, 0x96, 0x97, 0x97, 0x97, 0x97, 0x97, 0x97, 0x97,
+    0x97, 0x98, 0x98, 0x98, 0x98, 0x98, 0x98, 0x98, 0x98,
+  0x1F, 0x00, 0x00, 0x0F, 0xFC, 0xFF, 0x12, 0x41, 0x02, 0x99, 0x99, 0x99,
+    0x99, 0x99, 0x99, 0x99, 0x99, 0x9A, 0x9A, 0x9A, 0x9A, 0x9A, 0x9A, 0x9A,
+    0x9A,
+};
+
+static const uint8_t expParentAnnceRsp[] =
+{
+  0x1F, 0x80, 0x00, 0x02, 0x34, 0x12, 0x13, 0x30, 0x00, 0x02, 0x90, 0x90,
+    0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0x91, 0x91, 0x91, 0x91, 0x91, 0x91,
+    0x91, 0x91,
+};
+
+static const uint8_t expNwkAddrRspOwn[] =
+{
+  0x00, 0x80, 0x10, 0x02, 0x68, 0x24, 0x0C, 0x5A, 0x00, 0xA1, 0xA2, 0xA3,
+    0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0x00, 0x00,
+};
+
+static const uint8_t expIEEEAddrRspExt[] =
+{
+  0x01, 0x80, 0x10, 0x02, 0x68, 0x24, 0x14, 0x5A, 0x00, 0xA1, 0xA2, 0xA3,
+    0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0x00, 0x00, 0x03, 0x01, 0x01, 0x70, 0x02,
+    0x70, 0x03, 0x70,
+};
+
+static const uint8_t expIEEEAddrRspNoDev[] =
+{
+  0x01, 0x80, 0x10, 0x02, 0x68, 0x24, 0x0D, 0x5A, 0x00, 0xA1, 0xA2, 0xA3,
+    0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t expAddrRspChild[] =
+{
+  0x01, 0x80, 0x10, 0x02, 0x68, 0x24, 0x0C, 0x5A, 0x00, 0x31, 0x32, 0x33,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x44, 0x33,
+  0x00, 0x80, 0x10, 0x02, 0x68, 0x24, 0x0C, 0x5A, 0x00, 0x31, 0x32, 0x33,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x44, 0x33,
+};
+
+static const uint8_t expAddrRspNotFound[] =
+{
+  // The IEEE address of the IEEE_addr_rsp is all 0xFF as of CCB 2113, the
+  // old builder copied it from a stack array gone out of scope
+  0x00, 0x80, 0x10, 0x02, 0x68, 0x24, 0x0C, 0x5A, 0x81, 0x21, 0x22, 0x23,
+    0x24, 0x25, 0x26, 0x27, 0x28, 0xFF, 0xFF,
+  0x01, 0x80, 0x10, 0x02, 0x68, 0x24, 0x0C, 0x5A, 0x81, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x99, 0x99,
+};
+
+static const uint8_t expAddrRspInvalid[] =
+{
+  0x00, 0x80, 0x10, 0x02, 0x68, 0x24, 0x0C, 0x5A, 0x80, 0xA1, 0xA2, 0xA3,
+    0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0x00, 0x00,
+};
+
+static const uint8_t expNodeDescRsp[] =
+{
+  0x02, 0x80, 0x00, 0x02, 0x68, 0x24, 0x11, 0x5A, 0x00, 0x78, 0x56, 0x11,
+    0x40, 0x8E, 0x51, 0x04, 0x50, 0xA0, 0x00, 0x40, 0x2C, 0xA0, 0x00, 0x00,
+};
+
+static const uint8_t expPowerDescRsp[] =
+{
+  0x03, 0x80, 0x00, 0x02, 0x68, 0x24, 0x06, 0x5A, 0x00, 0x78, 0x56, 0x30,
+    0x81,
+};
+
+static const uint8_t expSimpleDescRsp[] =
+{
+  0x04, 0x80, 0x00, 0x02, 0x68, 0x24, 0x17, 0x5A, 0x00, 0x78, 0x56, 0x12,
+    0x08, 0x04, 0x01, 0x00, 0x01, 0x01, 0x03, 0x06, 0x00, 0x08, 0x00, 0x00,
+    0x03, 0x02, 0x19, 0x00, 0x00, 0x05,
+  0x04, 0x80, 0x00, 0x02, 0x68, 0x24, 0x05, 0x5A, 0x83, 0x78, 0x56, 0x00,
+};
+
+static const uint8_t expEPRsp[] =
+{
+  0x05, 0x80, 0x00, 0x02, 0x34, 0x12, 0x08, 0x21, 0x00, 0x78, 0x56, 0x03,
+    0x01, 0x08, 0xF2,
+  0x06, 0x80, 0x10, 0x02, 0x34, 0x12, 0x07, 0x22, 0x00, 0x78, 0x56, 0x02,
+    0x08, 0xF2,
+  0x05, 0x80, 0x00, 0x02, 0x34, 0x12, 0x05, 0x23, 0x81, 0x78, 0x56, 0x00,
+};
+
+static const uint8_t expOtherRsps[] =
+{
+  0x11, 0x80, 0x00, 0x02, 0x34, 0x12, 0x0A, 0x24, 0x00, 0x78, 0x56, 0x05,
+    0x70, 0x6F, 0x72, 0x63, 0x68,
+  0x15, 0x80, 0x10, 0x02, 0x34, 0x12, 0x04, 0x25, 0x00, 0x01, 0x00,
+  0x10, 0x80, 0x00, 0x02, 0x34, 0x12, 0x05, 0x26, 0x84, 0x78, 0x56, 0x00,
+};
+
+static const uint8_t expEndDeviceBindReq[] =
+{
+  0x20, 0x00, 0x00, 0x02, 0x34, 0x12, 0x1A, 0x40, 0x00, 0x00, 0xA1, 0xA2,
+    0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0x08, 0x04, 0x01, 0x03, 0x06, 0x00,
+    0x08, 0x00, 0x00, 0x03, 0x02, 0x19, 0x00, 0x00, 0x05,
+};
+
+static const uint8_t expBindUnbindReq[] =
+{
+  0x21, 0x00, 0x10, 0x02, 0x34, 0x12, 0x16, 0x40, 0x11, 0x12, 0x13, 0x14,
+    0x15, 0x16, 0x17, 0x18, 0x08, 0x06, 0x00, 0x03, 0x21, 0x22, 0x23, 0x24,
+    0x25, 0x26, 0x27, 0x28, 0x01,
+  0x22, 0x00, 0x10, 0x02, 0x34, 0x12, 0x0F, 0x41, 0x11, 0x12, 0x13, 0x14,
+    0x15, 0x16, 0x17, 0x18, 0x08, 0x06, 0x00, 0x01, 0x0E, 0x0F,
+};
+
+static const uint8_t expMgmtNwkDiscReq[] =
+{
+  0x30, 0x00, 0x00, 0x02, 0x34, 0x12, 0x07, 0x40, 0x00, 0xF8, 0xFF, 0x07,
+    0x03, 0x01,
+};
+
+static const uint8_t expMgmtDirectJoinReq[] =
+{
+  0x35, 0x00, 0x00, 0x02, 0x34, 0x12, 0x0A, 0x40, 0x11, 0x12, 0x13, 0x14,
+    0x15, 0x16, 0x17, 0x18, 0x8E,
+};
+
+static const uint8_t expMgmtPermitJoinReq[] =
+{
+  0x36, 0x00, 0x00, 0x02, 0x00, 0x00, 0x03, 0x40, 0x3C, 0x01,
+  0x36, 0x00, 0x00, 0x0F, 0xFC, 0xFF, 0x03, 0x41, 0x3C, 0x01,
+  0x36, 0x00, 0x00, 0x02, 0x34, 0x12, 0x03, 0x42, 0x00, 0x00,
+};
+
+static const uint8_t expMgmtLeaveReq[] =
+{
+  0x34, 0x00, 0x00, 0x02, 0x34, 0x12, 0x0A, 0x40, 0x11, 0x12, 0x13, 0x14,
+    0x15, 0x16, 0x17, 0x18, 0xC0,
+  0x34, 0x00, 0x00, 0x02, 0x34, 0x12, 0x0A, 0x41, 0x21, 0x22, 0x23, 0x24,
+    0x25, 0x26, 0x27, 0x28, 0x00,
+};
+
+static const uint8_t expMgmtNwkUpdateReq[] =
+{
+  0x38, 0x00, 0x00, 0x02, 0x34, 0x12, 0x07, 0x40, 0x00, 0xF8, 0xFF, 0x07,
+    0x03, 0x02,
+  0x38, 0x00, 0x00, 0x0F, 0xFC, 0xFF, 0x07, 0x41, 0x00, 0x80, 0x00, 0x00,
+    0xFE, 0x06,
+  0x38, 0x00, 0x00, 0x0F, 0xFC, 0xFF, 0x09, 0x42, 0x00, 0xF8, 0xFF, 0x07,
+    0xFF, 0x07, 0x57, 0x13,
+};
+
+static const uint8_t expMgmtNwkDiscRsp[] =
+{
+  0x30, 0x80, 0x00, 0x02, 0x34, 0x12, 0x1D, 0x31, 0x00, 0x05, 0x01, 0x02,
+    0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0x0B, 0x22, 0xFF, 0x01,
+    0xC1, 0xC1, 0xC1, 0xC1, 0xC1, 0xC1, 0xC1, 0xC1, 0x0F, 0x22, 0xFF, 0x00,
+};
+
+static const uint8_t expMgmtLqiRsp[] =
+{
+  0x31, 0x80, 0x00, 0x02, 0x34, 0x12, 0x47, 0x32, 0x00, 0x09, 0x03, 0x03,
+    0xD0, 0xD0, 0xD0, 0xD0, 0xD0, 0xD0, 0xD0, 0xD0, 0xE0, 0xE0, 0xE0, 0xE0,
+    0xE0, 0xE0, 0xE0, 0xE0, 0x00, 0x60, 0x00, 0x00, 0x01, 0xC8, 0xD1, 0xD1,
+    0xD1, 0xD1, 0xD1, 0xD1, 0xD1, 0xD1, 0xE1, 0xE1, 0xE1, 0xE1, 0xE1, 0xE1,
+    0xE1, 0xE1, 0x01, 0x60, 0x15, 0x01, 0x02, 0xC7, 0xD2, 0xD2, 0xD2, 0xD2,
+    0xD2, 0xD2, 0xD2, 0xD2, 0xE2, 0xE2, 0xE2, 0xE2, 0xE2, 0xE2, 0xE2, 0xE2,
+    0x02, 0x60, 0x22, 0x00, 0x03, 0xC6,
+  0x31, 0x80, 0x00, 0x02, 0x34, 0x12, 0x02, 0x33, 0x84,
+};
+
+static const uint8_t expMgmtRtgRsp[] =
+{
+  0x32, 0x80, 0x00, 0x02, 0x34, 0x12, 0x14, 0x34, 0x00, 0x03, 0x00, 0x03,
+    0x11, 0x11, 0x00, 0x22, 0x22, 0x33, 0x33, 0x31, 0x44, 0x44, 0x55, 0x55,
+    0x1B, 0x66, 0x66,
+};
+
+static const uint8_t expMgmtBindRsp[] =
+{
+  0x33, 0x80, 0x00, 0x02, 0x34, 0x12, 0x28, 0x35, 0x00, 0x02, 0x00, 0x02,
+    0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0x08, 0x06, 0x00, 0x03,
+    0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x01, 0xA1, 0xA2, 0xA3,
+    0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0x09, 0x00, 0x03, 0x01, 0x0E, 0x0F,
+};
+
+static const uint8_t expMgmtNwkUpdateNotify[] =
+{
+  0x38, 0x80, 0x10, 0x02, 0x34, 0x12, 0x10, 0x36, 0x00, 0x00, 0xF8, 0xFF,
+    0x07, 0x2C, 0x03, 0x11, 0x00, 0x05, 0x90, 0xA8, 0xB0, 0xC2, 0xFF,
+};
+
+
+/*********************************************************************
+ * TESTS
+ */
+
+// Requests carrying an address of interest or a single byte
+static void testShortRequests( void )
+{
+  uint8_t startIdx = 2;
+  uint8_t status = ZDP_NOT_SUPPORTED;
+  uint8_t seq = 0x77;
+
+  sendStart();
+  ZTEST_CHECK( ZDP_NodeDescReq( &dst16, 0x5678, 0 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( SENT_IS( expNodeDescReq ) );
+  ZTEST_CHECK( ZDP_SeqNum == 0x41 );
+
+  sendStart();
+  ZDP_PowerDescReq( &dst16, 0x5678, 0 );
+  ZTEST_CHECK( SENT_IS( expPowerDescReq ) );
+
+  sendStart();
+  ZDP_ActiveEPReq( &dst16, 0x5678, 0 );
+  ZTEST_CHECK( SENT_IS( expActiveEPReq ) );
+
+  sendStart();
+  ZDP_ComplexDescReq( &dst16, 0x5678, 0 );
+  ZTEST_CHECK( SENT_IS( expComplexDescReq ) );
+
+  sendStart();
+  ZDP_UserDescReq( &dst16, 0x5678, 0 );
+  ZTEST_CHECK( SENT_IS( expUserDescReq ) );
+
+  sendStart();
+  ZDP_MgmtLqiReq( &dst16, startIdx, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtLqiReq ) );
+
+  sendStart();
+  ZDP_MgmtRtgReq( &dst16, startIdx, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtRtgReq ) );
+
+  sendStart();
+  ZDP_MgmtBindReq( &dst16, startIdx, TRUE );
+  ZTEST_CHECK( SENT_IS( expMgmtBindReq ) );
+
+  sendStart();
+  ZDP_UserDescConf( seq, &dst16, status, 0 );
+  ZDP_EndDeviceBindRsp( seq, &dst16, status, 0 );
+  ZDP_BindRsp( seq, &dst16, status, 0 );
+  ZDP_UnbindRsp( seq, &dst16, status, 0 );
+  ZDP_MgmtLeaveRsp( seq, &dst16, status, 0 );
+  ZDP_MgmtPermitJoinRsp( seq, &dst16, status, 0 );
+  ZDP_MgmtDirectJoinRsp( seq, &dst16, status, 0 );
+  ZTEST_CHECK( SENT_IS( expStatusRsps ) );
+  ZTEST_CHECK( seq == 0x77 + 7 );
+}
+
+// Discovery requests and announcements
+static void testRequests( void )
+{
+  zAddrType_t dstAll = { { NWK_BROADCAST_SHORTADDR_DEVALL }, Addr16Bit };
+  UserDescriptorFormat_t userDesc = { 7, "kitchen" };
+
+  sendStart();
+  ZDP_NwkAddrReq( ieeeA, ZDP_ADDR_REQTYPE_EXTENDED, 2, 0 );
+  ZDP_NwkAddrReq( ownExtAddr, ZDP_ADDR_REQTYPE_SINGLE, 0, 0 );
+  ZTEST_CHECK( SENT_IS( expNwkAddrReq ) );
+
+  sendStart();
+  ZDP_IEEEAddrReq( 0x5678, ZDP_ADDR_REQTYPE_SINGLE, 0, 0 );
+  ZTEST_CHECK( SENT_IS( expIEEEAddrReq ) );
+
+  sendStart();
+  ZDP_MatchDescReq( &dstAll, NWK_BROADCAST_SHORTADDR_DEVALL, 0x0104,
+                    3, inClusters, 2, outClusters, 0 );
+  ZTEST_CHECK( SENT_IS( expMatchDescReq ) );
+
+  sendStart();
+  ZDP_SimpleDescReq( &dst16, 0x5678, 8, 0 );
+  ZTEST_CHECK( SENT_IS( expSimpleDescReq ) );
+
+  sendStart();
+  ZDP_UserDescSet( &dst16, 0x5678, &userDesc, 0 );
+  ZTEST_CHECK( SENT_IS( expUserDescSet ) );
+
+  sendStart();
+  ZDP_ServerDiscReq( PRIM_TRUST_CENTER | NETWORK_MANAGER, TRUE );
+  ZDP_ServerDiscReq( PRIM_BIND_TABLE, FALSE );
+  ZTEST_CHECK( SENT_IS( expServerDiscReq ) );
+
+  sendStart();
+  ZDP_DeviceAnnce( 0x5678, ieeeA, 0x8E, 0 );
+  ZTEST_CHECK( SENT_IS( expDeviceAnnce ) );
+}
+
+// Parent announcements, MAX_PARENT_ANNCE_CHILD children per frame
+static void testParentAnnce( void )
+{
+  ZDO_ChildInfo_t children[MAX_PARENT_ANNCE_CHILD + 2];
+  zAddrType_t dstBcast;
+  uint8_t seq = 0x30;
+  uint8_t x;
+
+  for ( x = 0; x < MAX_PARENT_ANNCE_CHILD + 2; x++ )
+  {
+    memset( children[x].extAddr, 0x90 + x, Z_EXTADDR_LEN );
+  }
+
+  sendStart();
+  dstBcast.addrMode = AddrBroadcast;
+  dstBcast.addr.shortAddr = NWK_BROADCAST_SHORTADDR_DEVALL;
+  parentAnnceTimers = 0;
+  childIndex = 0;
+  ZDP_ParentAnnceReq( dstBcast, 3, (uint8_t *)children, 0 );
+  ZTEST_CHECK( SENT_IS( expParentAnnce ) );
+  ZTEST_CHECK( parentAnnceTimers == 0 );
+
+  // Two frames, the timer set for the second
+  sendStart();
+  ZDP_ParentAnnceReq( dstBcast, MAX_PARENT_ANNCE_CHILD + 2, (uint8_t *)children, 0 );
+  ZTEST_CHECK( parentAnnceTimers == 1 );
+  ZDP_ParentAnnceReq( dstBcast, MAX_PARENT_ANNCE_CHILD + 2, (uint8_t *)children, 0 );
+  ZTEST_CHECK( parentAnnceTimers == 1 );
+  ZTEST_CHECK( SENT_IS( expParentAnnceSplit ) );
+  ZTEST_CHECK( childIndex == 0 );
+
+  sendStart();
+  ZDP_ParentAnnceRsp( seq, dst16, 2, (uint8_t *)children, 0 );
+  ZTEST_CHECK( SENT_IS( expParentAnnceRsp ) );
+}
+
+// NWK_addr_rsp and IEEE_addr_rsp
+static void testAddrRsp( void )
+{
+  zdoIncomingMsg_t inMsg;
+  uint8_t asdu[Z_EXTADDR_LEN + 2];
+
+  // Own address, single
+  sendStart();
+  assocCnt = 0;
+  memcpy( asdu, ownExtAddr, Z_EXTADDR_LEN );
+  asdu[Z_EXTADDR_LEN] = ZDP_ADDR_REQTYPE_SINGLE;
+  asdu[Z_EXTADDR_LEN + 1] = 0;
+  zdpProcessAddrReq( inMsgSet( &inMsg, NWK_addr_req, asdu, sizeof( asdu ), TRUE ) );
+  ZTEST_CHECK( SENT_IS( expNwkAddrRspOwn ) );
+
+  // Own address, extended from the second end device
+  sendStart();
+  assocCnt = 4;
+  asdu[0] = LO_UINT16( ZDAppNwkAddr.addr.shortAddr );
+  asdu[1] = HI_UINT16( ZDAppNwkAddr.addr.shortAddr );
+  asdu[2] = ZDP_ADDR_REQTYPE_EXTENDED;
+  asdu[3] = 1;
+  zdpProcessAddrReq( inMsgSet( &inMsg, IEEE_addr_req, asdu, 4, FALSE ) );
+  ZTEST_CHECK( SENT_IS( expIEEEAddrRspExt ) );
+
+  // Extended without end devices
+  sendStart();
+  assocCnt = 0;
+  zdpProcessAddrReq( inMsgSet( &inMsg, IEEE_addr_req, asdu, 4, FALSE ) );
+  ZTEST_CHECK( SENT_IS( expIEEEAddrRspNoDev ) );
+
+  // Sleeping child answered for
+  sendStart();
+  asdu[0] = LO_UINT16( rfdChild.shortAddr );
+  asdu[1] = HI_UINT16( rfdChild.shortAddr );
+  asdu[2] = ZDP_ADDR_REQTYPE_SINGLE;
+  zdpProcessAddrReq( inMsgSet( &inMsg, IEEE_addr_req, asdu, 4, FALSE ) );
+  memcpy( asdu, rfdChildExt, Z_EXTADDR_LEN );
+  asdu[Z_EXTADDR_LEN] = ZDP_ADDR_REQTYPE_SINGLE;
+  zdpProcessAddrReq( inMsgSet( &inMsg, NWK_addr_req, asdu, sizeof( asdu ), TRUE ) );
+  ZTEST_CHECK( SENT_IS( expAddrRspChild ) );
+
+  // Not found: unicast answered, broadcast not
+  sendStart();
+  memcpy( asdu, ieeeB, Z_EXTADDR_LEN );
+  zdpProcessAddrReq( inMsgSet( &inMsg, NWK_addr_req, asdu, sizeof( asdu ), TRUE ) );
+  ZTEST_CHECK( sentFrames == 0 );
+  zdpProcessAddrReq( inMsgSet( &inMsg, NWK_addr_req, asdu, sizeof( asdu ), FALSE ) );
+  asdu[0] = 0x99;
+  asdu[1] = 0x99;
+  zdpProcessAddrReq( inMsgSet( &inMsg, IEEE_addr_req, asdu, 4, FALSE ) );
+  ZTEST_CHECK( SENT_IS( expAddrRspNotFound ) );
+
+  // Invalid request type
+  sendStart();
+  memcpy( asdu, ownExtAddr, Z_EXTADDR_LEN );
+  asdu[Z_EXTADDR_LEN] = 7;
+  zdpProcessAddrReq( inMsgSet( &inMsg, NWK_addr_req, asdu, sizeof( asdu ), FALSE ) );
+  ZTEST_CHECK( SENT_IS( expAddrRspInvalid ) );
+}
+
+// Descriptor and endpoint responses
+static void testDescRsp( void )
+{
+  NodeDescriptorFormat_t nodeDesc;
+  NodePowerDescriptorFormat_t powerDesc;
+  SimpleDescriptionFormat_t simpleDesc;
+  UserDescriptorFormat_t userDesc = { 5, "porch" };
+  zdoIncomingMsg_t inMsg;
+  uint8_t asdu[3] = { 0x78, 0x56, 8 };
+  uint8_t eps[3] = { 1, 8, 242 };
+
+  memset( &nodeDesc, 0, sizeof( nodeDesc ) );
+  nodeDesc.LogicalType = NODETYPE_ROUTER;
+  nodeDesc.UserDescAvail = 1;
+  nodeDesc.APSFlags = 0;
+  nodeDesc.FrequencyBand = NODEFREQ_2400;
+  nodeDesc.CapabilityFlags = 0x8E;
+  nodeDesc.ManufacturerCode[0] = 0x51;
+  nodeDesc.ManufacturerCode[1] = 0x04;
+  nodeDesc.MaxBufferSize = 80;
+  nodeDesc.MaxInTransferSize[0] = 160;
+  nodeDesc.ServerMask = 0x2C40;
+  nodeDesc.MaxOutTransferSize[0] = 160;
+  nodeDesc.DescriptorCapability = 0;
+
+  sendStart();
+  ZDP_NodeDescMsg( inMsgSet( &inMsg, Node_Desc_req, asdu, 2, FALSE ), 0x5678, &nodeDesc );
+  ZTEST_CHECK( SENT_IS( expNodeDescRsp ) );
+  ZTEST_CHECK( inMsg.TransSeq == 0x5B );
+
+  powerDesc.PowerMode = NODECURPWR_RCVR_ALWAYS_ON;
+  powerDesc.AvailablePowerSources = NODEAVAILPWR_MAINS | NODEAVAILPWR_RECHARGE;
+  powerDesc.CurrentPowerSource = NODEAVAILPWR_MAINS;
+  powerDesc.CurrentPowerSourceLevel = NODEPOWER_LEVEL_66;
+
+  sendStart();
+  ZDP_PowerDescMsg( inMsgSet( &inMsg, Power_Desc_req, asdu, 2, FALSE ), 0x5678, &powerDesc );
+  ZTEST_CHECK( SENT_IS( expPowerDescRsp ) );
+
+  memset( &simpleDesc, 0, sizeof( simpleDesc ) );
+  simpleDesc.EndPoint = 8;
+  simpleDesc.AppProfId = 0x0104;
+  simpleDesc.AppDeviceId = 0x0100;
+  simpleDesc.AppDevVer = 1;
+  simpleDesc.AppNumInClusters = 3;
+  simpleDesc.pAppInClusterList = inClusters;
+  simpleDesc.AppNumOutClusters = 2;
+  simpleDesc.pAppOutClusterList = outClusters;
+
+  sendStart();
+  ZDP_SimpleDescMsg( inMsgSet( &inMsg, Simple_Desc_req, asdu, 3, FALSE ), ZDP_SUCCESS, &simpleDesc );
+  ZDP_SimpleDescMsg( inMsgSet( &inMsg, Simple_Desc_req, asdu, 3, FALSE ), ZDP_NOT_ACTIVE, NULL );
+  ZTEST_CHECK( SENT_IS( expSimpleDescRsp ) );
+
+  sendStart();
+  ZDP_ActiveEPRsp( 0x21, &dst16, ZDP_SUCCESS, 0x5678, 3, eps, 0 );
+  ZDP_MatchDescRsp( 0x22, &dst16, ZDP_SUCCESS, 0x5678, 2, eps + 1, 0 );
+  ZDP_ActiveEPRsp( 0x23, &dst16, ZDP_DEVICE_NOT_FOUND, 0x5678, 0, eps, 0 );
+  ZTEST_CHECK( SENT_IS( expEPRsp ) );
+
+  sendStart();
+  ZDP_UserDescRsp( 0x24, &dst16, 0x5678, &userDesc, 0 );
+  ZDP_ServerDiscRsp( 0x25, &dst16, ZDP_SUCCESS, 0x5678, PRIM_TRUST_CENTER, 0 );
+  ZDP_GenericRsp( 0x26, &dst16, ZDP_NOT_SUPPORTED, 0x5678, Complex_Desc_rsp, 0 );
+  ZTEST_CHECK( SENT_IS( expOtherRsps ) );
+}
+
+// Binding requests
+static void testBinding( void )
+{
+  zAddrType_t dstExt;
+  zAddrType_t dstGroup;
+
+  sendStart();
+  ZTEST_CHECK( ZDP_EndDeviceBindReq( &dst16, ZDAppNwkAddr.addr.shortAddr, 8, 0x0104,
+                                     3, inClusters, 2, outClusters, 0 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( ZDP_EndDeviceBindReq( &dst16, 0x4321, 8, 0x0104,
+                                     3, inClusters, 2, outClusters, 0 ) == afStatus_INVALID_PARAMETER );
+  ZTEST_CHECK( SENT_IS( expEndDeviceBindReq ) );
+
+  dstExt.addrMode = Addr64Bit;
+  memcpy( dstExt.addr.extAddr, ieeeB, Z_EXTADDR_LEN );
+  dstGroup.addrMode = AddrGroup;
+  dstGroup.addr.shortAddr = 0x0F0E;
+
+  sendStart();
+  ZDP_BindReq( &dst16, ieeeA, 8, 0x0006, &dstExt, 1, 0 );
+  ZDP_UnbindReq( &dst16, ieeeA, 8, 0x0006, &dstGroup, 1, 0 );
+  ZTEST_CHECK( SENT_IS( expBindUnbindReq ) );
+}
+
+// Network management requests
+static void testMgmtRequests( void )
+{
+  zAddrType_t dstBcast = { { NWK_BROADCAST_SHORTADDR_DEVZCZR }, AddrBroadcast };
+
+  sendStart();
+  ZDP_MgmtNwkDiscReq( &dst16, 0x07FFF800, 3, 1, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtNwkDiscReq ) );
+
+  sendStart();
+  ZDP_MgmtDirectJoinReq( &dst16, ieeeA, 0x8E, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtDirectJoinReq ) );
+
+  // A broadcast also goes to this device
+  sendStart();
+  ZDP_MgmtPermitJoinReq( &dstBcast, 60, TRUE, 0 );
+  ZDP_MgmtPermitJoinReq( &dst16, 0, FALSE, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtPermitJoinReq ) );
+  ZTEST_CHECK( ZDP_SeqNum == 0x43 );
+
+  sendStart();
+  ZDP_MgmtLeaveReq( &dst16, ieeeA, TRUE, TRUE, 0 );
+  ZDP_MgmtLeaveReq( &dst16, ieeeB, FALSE, FALSE, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtLeaveReq ) );
+
+  sendStart();
+  ZDP_MgmtNwkUpdateReq( &dst16, 0x07FFF800, 3, 2, 5, 0x0000 );
+  ZDP_MgmtNwkUpdateReq( &dstBcast, 0x00008000, 0xFE, 0, 6, 0x0000 );
+  ZDP_MgmtNwkUpdateReq( &dstBcast, 0x07FFF800, 0xFF, 0, 7, 0x1357 );
+  ZTEST_CHECK( SENT_IS( expMgmtNwkUpdateReq ) );
+}
+
+// Network management responses
+static void testMgmtResponses( void )
+{
+  networkDesc_t nwks[2];
+  ZDP_MgmtLqiItem_t lqiItems[3];
+  rtgItem_t rtgItems[3];
+  apsBindingItem_t bindItems[2];
+  uint8_t energy[5] = { 0x90, 0xA8, 0xB0, 0xC2, 0xFF };
+  uint8_t x;
+
+  memset( nwks, 0, sizeof( nwks ) );
+  for ( x = 0; x < 2; x++ )
+  {
+    memset( nwks[x].extendedPANID, 0xC0 + x, Z_EXTADDR_LEN );
+    nwks[x].logicalChannel = 11 + (x * 4);
+    nwks[x].stackProfile = 2;
+    nwks[x].version = 2;
+    nwks[x].chosenRouter = x ? INVALID_NODE_ADDR : 0x0000;
+  }
+  nwks[0].nextDesc = &nwks[1];
+
+  sendStart();
+  ZDP_MgmtNwkDiscRsp( 0x31, &dst16, ZDP_SUCCESS, 5, 1, 2, nwks, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtNwkDiscRsp ) );
+
+  for ( x = 0; x < 3; x++ )
+  {
+    lqiItemSet( &lqiItems[x], x );
+  }
+
+  sendStart();
+  ZDP_MgmtLqiRsp( 0x32, &dst16, ZSuccess, 9, 3, 3, lqiItems, 0 );
+  ZDP_MgmtLqiRsp( 0x33, &dst16, ZDP_NOT_SUPPORTED, 0, 0, 0, NULL, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtLqiRsp ) );
+
+  rtgItems[0].dstAddress = 0x1111;
+  rtgItems[0].nextHopAddress = 0x2222;
+  rtgItems[0].status = ZDO_MGMT_RTG_ENTRY_ACTIVE;
+  rtgItems[0].options = 0;
+  rtgItems[1].dstAddress = 0x3333;
+  rtgItems[1].nextHopAddress = 0x4444;
+  rtgItems[1].status = ZDO_MGMT_RTG_ENTRY_DISCOVERY_UNDERWAY;
+  rtgItems[1].options = ZP_MTO_ROUTE_RC | ZP_RTG_RECORD;
+  rtgItems[2].dstAddress = 0x5555;
+  rtgItems[2].nextHopAddress = 0x6666;
+  rtgItems[2].status = ZDO_MGMT_RTG_ENTRY_INACTIVE;
+  rtgItems[2].options = ZP_MTO_ROUTE_NRC;
+
+  sendStart();
+  ZDP_MgmtRtgRsp( 0x34, &dst16, ZSuccess, 3, 0, 3, rtgItems, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtRtgRsp ) );
+
+  memset( bindItems, 0, sizeof( bindItems ) );
+  memcpy( bindItems[0].srcAddr, ownExtAddr, Z_EXTADDR_LEN );
+  bindItems[0].srcEP = 8;
+  bindItems[0].clusterID = 0x0006;
+  bindItems[0].dstAddr.addrMode = Addr64Bit;
+  memcpy( bindItems[0].dstAddr.addr.extAddr, ieeeA, Z_EXTADDR_LEN );
+  bindItems[0].dstEP = 1;
+  memcpy( bindItems[1].srcAddr, ownExtAddr, Z_EXTADDR_LEN );
+  bindItems[1].srcEP = 9;
+  bindItems[1].clusterID = 0x0300;
+  bindItems[1].dstAddr.addrMode = AddrGroup;
+  bindItems[1].dstAddr.addr.shortAddr = 0x0F0E;
+
+  sendStart();
+  ZDP_MgmtBindRsp( 0x35, &dst16, ZSuccess, 2, 0, 2, bindItems, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtBindRsp ) );
+
+  sendStart();
+  ZDP_MgmtNwkUpdateNotify( 0x36, &dst16, ZSuccess, 0x07FFF800, 812, 17,
+                           sizeof( energy ), energy, AF_MSG_ACK_REQUEST, 0 );
+  ZTEST_CHECK( SENT_IS( expMgmtNwkUpdateNotify ) );
+}
+
+// Frames past the old 80 byte ZDP_TmpBuf go out whole
+static void testLargeFrames( void )
+{
+  ZDP_MgmtLqiItem_t lqiItems[10];
+  zdoIncomingMsg_t inMsg;
+  uint8_t asdu[4];
+  uint8_t x;
+
+  for ( x = 0; x < 10; x++ )
+  {
+    lqiItemSet( &lqiItems[x], x );
+  }
+
+  sendStart();
+  ZTEST_CHECK( ZDP_MgmtLqiRsp( 0x32, &dst16, ZSuccess, 10, 0, 10, lqiItems, 0 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( sentFrames == 1 );
+  ZTEST_CHECK( sentLog[6] == 1 + 4 + (10 * ZDP_MGMTLQI_EXTENDED_SIZE) );
+  // Last entry's address, depth and LQI
+  ZTEST_CHECK( memcmp( sentLog + 7 + 5 + (9 * ZDP_MGMTLQI_EXTENDED_SIZE) + Z_EXTADDR_LEN,
+                       lqiItems[9].extAddr, Z_EXTADDR_LEN ) == 0 );
+  ZTEST_CHECK( sentLog[7 + 5 + (10 * ZDP_MGMTLQI_EXTENDED_SIZE) - 1] == 200 - 9 );
+  ZTEST_CHECK( heapLive == 0 );
+
+  // Extended address response listing 60 end devices
+  sendStart();
+  assocCnt = 60;
+  asdu[0] = LO_UINT16( ZDAppNwkAddr.addr.shortAddr );
+  asdu[1] = HI_UINT16( ZDAppNwkAddr.addr.shortAddr );
+  asdu[2] = ZDP_ADDR_REQTYPE_EXTENDED;
+  asdu[3] = 0;
+  zdpProcessAddrReq( inMsgSet( &inMsg, IEEE_addr_req, asdu, 4, FALSE ) );
+  ZTEST_CHECK( sentFrames == 1 );
+  ZTEST_CHECK( sentLog[6] == 1 + 1 + Z_EXTADDR_LEN + 2 + 2 + (60 * 2) );
+  ZTEST_CHECK( sentLog[7 + 1 + 1 + Z_EXTADDR_LEN + 2] == 60 );
+  ZTEST_CHECK( BUILD_UINT16( sentLog[sentLen - 2], sentLog[sentLen - 1] ) == 0x7000 + 59 );
+  ZTEST_CHECK( heapLive == 0 );
+  assocCnt = 0;
+}
+
+// Fields past the buffer are refused and the frame is not sent
+static void testBounds( void )
+{
+  uint8_t buf[ZDP_BUILD_SIZE( 3 )];
+  zdpBuilder_t bld;
+
+  sendStart();
+  ZTEST_CHECK( ZDP_BuildInit( &bld, buf, sizeof( buf ) ) == ZSuccess );
+  ZDP_BuildUint16( &bld, 0x1234 );
+  ZDP_BuildUint8( &bld, 0x56 );
+  ZTEST_CHECK( bld.status == ZSuccess );
+  ZTEST_CHECK( ZDP_BuildReserve( &bld, 1 ) == NULL );
+  ZTEST_CHECK( bld.status == ZBufferFull );
+  ZDP_BuildUint16( &bld, 0x789A );
+  ZTEST_CHECK( bld.len == sizeof( buf ) );
+  ZTEST_CHECK( ZDP_BuildSend( &bld, &ZDP_SeqNum, &dst16, Node_Desc_req, 0 ) == afStatus_MEM_FAIL );
+  ZTEST_CHECK( sentFrames == 0 );
+  ZTEST_CHECK( ZDP_SeqNum == 0x40 );
+
+  // No heap for the frame
+  sendStart();
+  heapFailIn = 1;
+  ZTEST_CHECK( ZDP_MatchDescReq( &dst16, 0x5678, 0x0104, 3, inClusters, 2, outClusters, 0 )
+               == afStatus_MEM_FAIL );
+  ZTEST_CHECK( ZDP_BuildInit( &bld, NULL, 0 ) == ZMemError );
+  ZTEST_CHECK( sentFrames == 0 );
+  ZTEST_CHECK( heapLive == 0 );
+
+  // Refused by AF: the sequence number is kept, the frame released
+  sendStart();
+  afStatus = afStatus_FAILED;
+  ZTEST_CHECK( ZDP_MatchDescReq( &dst16, 0x5678, 0x0104, 3, inClusters, 2, outClusters, 0 )
+               == afStatus_FAILED );
+  ZTEST_CHECK( ZDP_SeqNum == 0x40 );
+  ZTEST_CHECK( heapLive == 0 );
+}
+
+// A frame built by a caller while ZDO sends others is left intact
+static void testSideBySide( void )
+{
+  uint8_t buf[ZDP_BUILD_SIZE( 2 + Z_EXTADDR_LEN + 1 )];
+  uint8_t annce[7 + ZDP_BUILD_SIZE( 2 + Z_EXTADDR_LEN + 1 )];
+  zAddrType_t dstRxOn = { { NWK_BROADCAST_SHORTADDR_DEVRXON }, AddrBroadcast };
+  zdpBuilder_t bld;
+  zdpBuilder_t big;
+  uint8_t seq = 0x10;
+
+  sendStart();
+  ZDP_DeviceAnnce( 0x5678, ieeeA, 0x8E, 0 );
+  memcpy( annce, sentLog, sentLen );
+
+  sendStart();
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildInit( &big, NULL, ZDP_BUILD_SIZE( 120 ) );
+  ZDP_BuildUint16( &bld, 0x5678 );
+  ZDP_BuildFill( &big, 0xEE, 60 );
+  ZDP_MgmtLeaveReq( &dst16, ieeeB, FALSE, FALSE, 0 );
+  ZDP_BuildExtAddr( &bld, ieeeA );
+  ZDP_BuildFill( &big, 0xEE, 60 );
+  ZDP_NodeDescReq( &dst16, 0x5678, 0 );
+  ZDP_BuildUint8( &bld, 0x8E );
+  ZTEST_CHECK( big.status == ZSuccess );
+  ZDP_BuildFree( &big );
+  ZTEST_CHECK( heapLive == 0 );
+
+  sentLen = 0;
+  ZDP_SeqNum = 0x40;
+  ZTEST_CHECK( ZDP_BuildSend( &bld, &ZDP_SeqNum, &dstRxOn, Device_annce, 0 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( memcmp( sentLog, annce, sentLen ) == 0 );
+
+  // Sent again from the caller's buffer
+  ZTEST_CHECK( ZDP_BuildSend( &bld, &seq, &dst16, Device_annce, 0 ) == afStatus_SUCCESS );
+  ZTEST_CHECK( seq == 0x11 );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testShortRequests );
+  ZTEST_RUN( testRequests );
+  ZTEST_RUN( testParentAnnce );
+  ZTEST_RUN( testAddrRsp );
+  ZTEST_RUN( testDescRsp );
+  ZTEST_RUN( testBinding );
+  ZTEST_RUN( testMgmtRequests );
+  ZTEST_RUN( testMgmtResponses );
+  ZTEST_RUN( testLargeFrames );
+  ZTEST_RUN( testBounds );
+  ZTEST_RUN( testSideBySide );
+
+  return ( ZTEST_RESULT );
+}
@@ -0,0 +1,427 @@
+/**************************************************************************************************
+  Filename:       test_zevtlog.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the network event log over osal_nv.c and
+                  NVOCMP built with NV_LINUX, on a flash image shared by
+                  the boots of the device.  Each boot is a child process,
+                  so NVOCMP and the log start over from flash as after a
+                  reset.  The log wraps around its blocks and sequence
+                  numbers, and power is cut at every stage of block
+                  writes and compactions: the records flushed before the
+                  cut are all found again, in order, and appending goes
+                  on from them.
+**************************************************************************************************/
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ztest.h"
+#include "zcomdef.h"
+#include "osal_nv.h"
+#include "nvocmp.h"
+#include "zstackconfig.h"
+#include "nv_linux.h"
+#include "zevtlog.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define FLASH_PAGES     2     // NVOCMP_NVPAGES
+
+// Flash and what the boots tell each other, shared by the processes
+typedef struct
+{
+  uint8_t  flash[FLASH_PAGES][FLASH_PAGE_SIZE];
+  uint32_t cutIn;             // Flash bytes written until the power cut, 0 never
+  uint32_t bytes;             // Flash bytes written
+  uint32_t erases;            // Flash pages erased
+  uint16_t added;             // Newest record added
+  uint16_t flushed;           // Newest record ZEvtLogFlush() returned for
+  uint16_t newest;            // Newest record found at boot
+  uint8_t  count;             // Records found at boot
+} flashState_t;
+
+static flashState_t *pState;
+
+uint32_t ztestClock = 0;
+uint8_t ZDAppTaskID = 4;
+zstack_Config_t *pZStackCfg;
+
+static zstack_Config_t zstackCfg;
+
+uint8_t OsalPortTimers_startTimer( uint8_t taskId, uint32_t eventId, uint32_t timeoutValue )
+{
+  (void)taskId;
+  (void)eventId;
+  (void)timeoutValue;
+  return ( 0 );
+}
+
+uint8_t OsalPortTimers_stopTimer( uint8_t taskId, uint32_t eventId )
+{
+  (void)taskId;
+  (void)eventId;
+  return ( 0 );
+}
+
+uint32_t OsalPortTimers_getTimerTimeout( uint8_t taskId, uint32_t eventId )
+{
+  (void)taskId;
+  (void)eventId;
+  return ( 0 );
+}
+
+void NV_LINUX_init( void )
+{
+}
+
+void NV_LINUX_save( void )
+{
+}
+
+void NV_LINUX_read( uint8_t pg, uint16_t off, uint8_t *pBuf, uint16_t len )
+{
+  ZTEST_CHECK( (pg < FLASH_PAGES) && ((uint32_t)off + len <= FLASH_PAGE_SIZE) );
+  memcpy( pBuf, &pState->flash[pg][off], len );
+}
+
+// NOR flash: programming only clears bits.  The power is cut after
+// cutIn bytes, in the middle of a write if it comes to that.
+int NV_LINUX_write( uint8_t pg, uint16_t off, uint8_t *pBuf, uint16_t len )
+{
+  uint16_t x;
+
+  ZTEST_CHECK( (pg < FLASH_PAGES) && ((uint32_t)off + len <= FLASH_PAGE_SIZE) );
+
+  for ( x = 0; x < len; x++ )
+  {
+    if ( pState->cutIn && (--pState->cutIn == 0) )
+    {
+      fflush( stdout );
+      _exit( ZTEST_RESULT );
+    }
+    pState->flash[pg][off + x] &= pBuf[x];
+    pState->bytes++;
+  }
+
+  return ( 0 );
+}
+
+int NV_LINUX_erase( uint8_t pg )
+{
+  ZTEST_CHECK( pg < FLASH_PAGES );
+
+  if ( pState->cutIn && (--pState->cutIn == 0) )
+  {
+    fflush( stdout );
+    _exit( ZTEST_RESULT );
+  }
+  memset( pState->flash[pg], 0xFF, FLASH_PAGE_SIZE );
+  pState->erases++;
+
+  return ( 0 );
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+#define LOG_RECS      ( ZEVTLOG_BLOCK_RECS * ZEVTLOG_NUM_BLOCKS )
+
+static uint32_t lcg;
+
+static uint32_t nextRandom( void )
+{
+  lcg = lcg * 1103515245 + 12345;
+  return ( (lcg >> 16) & 0x7FFF );
+}
+
+// Record n of the device, the contents follow from n
+static void recordAdd( uint16_t n )
+{
+  uint8_t extAddr[Z_EXTADDR_LEN];
+  uint8_t x;
+
+  for ( x = 0; x < Z_EXTADDR_LEN; x++ )
+  {
+    extAddr[x] = (uint8_t)(n >> (x & 1 ? 8 : 0)) ^ x;
+  }
+
+  // Before the add, which flushes a full block itself
+  pState->added = n;
+  ztestClock = (uint32_t)n * 1000;
+  ZEvtLogAdd( ZEVTLOG_TYPE_JOIN + (n % 5), (uint8_t)n, (uint8_t)(n >> 8), n,
+              (n % 3) ? extAddr : NULL );
+}
+
+static uint8_t recordIs( zevtlogRecord_t *pRec, uint16_t n )
+{
+  uint8_t x;
+
+  for ( x = 0; x < Z_EXTADDR_LEN; x++ )
+  {
+    uint8_t expect = (n % 3) ? ((uint8_t)(n >> (x & 1 ? 8 : 0)) ^ x) : 0;
+
+    if ( pRec->extAddr[x] != expect )
+    {
+      return ( FALSE );
+    }
+  }
+
+  return ( (pRec->time == n) && (pRec->type == ZEVTLOG_TYPE_JOIN + (n % 5)) &&
+           (pRec->info == (uint8_t)n) && (pRec->param == (uint8_t)(n >> 8)) &&
+           (pRec->nwkAddr == n) && (pRec->reserved == 0) );
+}
+
+// A boot of the device: NV and the log from flash, then pfnRun
+static int boot( void (*pfnRun)( void ) )
+{
+  pid_t pid;
+  int status;
+
+  fflush( stdout );
+  pid = fork();
+  if ( pid == 0 )
+  {
+    // The exit status counts the checks failed in this boot only
+    ztestFailed = 0;
+    pZStackCfg = &zstackCfg;
+    NVOCMP_loadApiPtrs( &zstackCfg.nvFps );
+    osal_nv_init( NULL );
+    ZEvtLogInit();
+
+    pfnRun();
+    fflush( stdout );
+    _exit( ZTEST_RESULT );
+  }
+
+  ZTEST_CHECK( (pid > 0) && (waitpid( pid, &status, 0 ) == pid) );
+  return ( WIFEXITED( status ) ? WEXITSTATUS( status ) : -1 );
+}
+
+// Check the log found at boot: consecutive records, newest first, with
+// the contents they were added with, and ZEvtLogRead() filters
+static void bootCheck( void )
+{
+  zevtlogRecord_t recs[LOG_RECS];
+  zevtlogRecord_t rec;
+  uint8_t leaves;
+  uint8_t cnt;
+  uint8_t x;
+
+  cnt = ZEvtLogRead( ZEVTLOG_TYPE_ANY, INVALID_NODE_ADDR, 0, LOG_RECS, recs );
+  pState->count = cnt;
+  if ( cnt == 0 )
+  {
+    return;
+  }
+  pState->newest = recs[0].nwkAddr;
+
+  for ( x = 0; x < cnt; x++ )
+  {
+    uint16_t n = (uint16_t)(pState->newest - x);
+
+    ZTEST_CHECK( recordIs( &recs[x], n ) );
+    ZTEST_CHECK( (x == 0) || (recs[x].seqNum == (uint16_t)(recs[x - 1].seqNum - 1)) );
+  }
+
+  // Filtered and paged as the whole log
+  for ( x = 0; x < cnt; x++ )
+  {
+    ZTEST_CHECK( ZEvtLogRead( ZEVTLOG_TYPE_ANY, INVALID_NODE_ADDR, x, 1, &rec ) == 1 );
+    ZTEST_CHECK( rec.seqNum == recs[x].seqNum );
+    if ( recs[x].nwkAddr != INVALID_NODE_ADDR )
+    {
+      ZTEST_CHECK( ZEvtLogRead( recs[x].type, recs[x].nwkAddr, 0, 1, &rec ) == 1 );
+      ZTEST_CHECK( rec.seqNum == recs[x].seqNum );
+    }
+  }
+  ZTEST_CHECK( ZEvtLogRead( ZEVTLOG_TYPE_ANY, INVALID_NODE_ADDR, cnt, 1, &rec ) == 0 );
+
+  leaves = 0;
+  for ( x = 0; x < cnt; x++ )
+  {
+    leaves += ( recs[x].type == ZEVTLOG_TYPE_LEAVE );
+  }
+  ZTEST_CHECK( ZEvtLogRead( ZEVTLOG_TYPE_LEAVE, INVALID_NODE_ADDR, 0, LOG_RECS, recs ) == leaves );
+  for ( x = 0; x < leaves; x++ )
+  {
+    ZTEST_CHECK( recs[x].type == ZEVTLOG_TYPE_LEAVE );
+  }
+}
+
+// Records after the newest in the log, flushed at random
+static uint16_t runRecs;
+
+static void runAdd( void )
+{
+  zevtlogRecord_t rec;
+  uint16_t n = 0;
+  uint16_t x;
+
+  if ( ZEvtLogRead( ZEVTLOG_TYPE_ANY, INVALID_NODE_ADDR, 0, 1, &rec ) == 1 )
+  {
+    n = rec.nwkAddr + 1;
+  }
+
+  for ( x = 0; x < runRecs; x++, n++ )
+  {
+    recordAdd( n );
+    if ( (nextRandom() % 4) == 0 )
+    {
+      ZEvtLogFlush();
+      pState->flushed = n;
+    }
+  }
+  ZEvtLogFlush();
+  pState->flushed = pState->added;
+}
+
+// Records added and lost in RAM at the power cut
+static void runAddNoFlush( void )
+{
+  uint16_t n;
+
+  for ( n = 0; n < runRecs; n++ )
+  {
+    recordAdd( n );
+  }
+}
+
+static void flashReset( void )
+{
+  memset( pState, 0, sizeof( flashState_t ) );
+  memset( pState->flash, 0xFF, sizeof( pState->flash ) );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testEmpty( void )
+{
+  flashReset();
+
+  ZTEST_CHECK( boot( bootCheck ) == 0 );
+  ZTEST_CHECK( pState->count == 0 );
+
+  // Records kept in RAM are lost without a flush
+  runRecs = 3;
+  ZTEST_CHECK( boot( runAddNoFlush ) == 0 );
+  ZTEST_CHECK( boot( bootCheck ) == 0 );
+  ZTEST_CHECK( pState->count == 0 );
+
+  lcg = 0;
+  ZTEST_CHECK( boot( runAdd ) == 0 );
+  ZTEST_CHECK( boot( bootCheck ) == 0 );
+  ZTEST_CHECK( (pState->count == 3) && (pState->newest == 2) );
+}
+
+static void testWrap( void )
+{
+  uint16_t run;
+
+  flashReset();
+
+  // Appending across reboots, over the oldest blocks and through
+  // NVOCMP compactions
+  for ( run = 0; run < 40; run++ )
+  {
+    uint16_t total;
+
+    lcg = run;
+    runRecs = 1 + (nextRandom() % (3 * ZEVTLOG_BLOCK_RECS));
+    ZTEST_CHECK( boot( runAdd ) == 0 );
+    ZTEST_CHECK( boot( bootCheck ) == 0 );
+
+    total = pState->added + 1;
+    ZTEST_CHECK( pState->newest == pState->added );
+    ZTEST_CHECK( pState->count == ((total < LOG_RECS) ? total :
+                 (LOG_RECS - ZEVTLOG_BLOCK_RECS + (total % ZEVTLOG_BLOCK_RECS))) );
+  }
+  ZTEST_CHECK( pState->erases > 0 );
+}
+
+static void testSeqWrap( void )
+{
+  flashReset();
+
+  // Past 0xFFFF in one boot, then in small runs across the wrap
+  runRecs = 0xFFF0;
+  ZTEST_CHECK( boot( runAdd ) == 0 );
+  ZTEST_CHECK( boot( bootCheck ) == 0 );
+  ZTEST_CHECK( (pState->newest == 0xFFEF) && (pState->count >= LOG_RECS - ZEVTLOG_BLOCK_RECS) );
+
+  for ( runRecs = 1; runRecs <= 5; runRecs++ )
+  {
+    ZTEST_CHECK( boot( runAdd ) == 0 );
+    ZTEST_CHECK( boot( bootCheck ) == 0 );
+    ZTEST_CHECK( pState->newest == pState->added );
+    ZTEST_CHECK( pState->count >= LOG_RECS - ZEVTLOG_BLOCK_RECS );
+  }
+  ZTEST_CHECK( pState->newest == (uint16_t)(0xFFEF + 15) );
+}
+
+static void testPowerCut( void )
+{
+  uint32_t writeBytes;
+  uint32_t cut;
+  uint16_t cuts = 0;
+
+  flashReset();
+
+  // Bytes a run writes, compactions included
+  lcg = 1;
+  runRecs = 4 * LOG_RECS;
+  ZTEST_CHECK( boot( runAdd ) == 0 );
+  ZTEST_CHECK( boot( bootCheck ) == 0 );
+  writeBytes = pState->bytes;
+
+  // Cut the power after every few bytes of such runs, in block writes,
+  // item invalidations, compaction copies and page erases
+  for ( cut = 1; cut < writeBytes; cut += 1 + (cut / 64), cuts++ )
+  {
+    uint16_t flushed;
+
+    lcg = cut;
+    pState->cutIn = cut;
+    pState->flushed = pState->newest;
+    ZTEST_CHECK( boot( runAdd ) == 0 );
+    pState->cutIn = 0;
+    flushed = pState->flushed;
+
+    ZTEST_CHECK( boot( bootCheck ) == 0 );
+
+    // Every flushed record is found, none that wasn't added
+    ZTEST_CHECK( pState->count >= LOG_RECS - ZEVTLOG_BLOCK_RECS );
+    ZTEST_CHECK( (int16_t)(pState->newest - flushed) >= 0 );
+    ZTEST_CHECK( (int16_t)(pState->added - pState->newest) >= 0 );
+  }
+
+  printf( "  %u power cuts over %lu bytes of log writes\n", cuts, (unsigned long)writeBytes );
+
+  // The log goes on after the last cut
+  runRecs = 2 * LOG_RECS;
+  ZTEST_CHECK( boot( runAdd ) == 0 );
+  ZTEST_CHECK( boot( bootCheck ) == 0 );
+  ZTEST_CHECK( (pState->newest == pState->added) && (pState->count >= LOG_RECS - ZEVTLOG_BLOCK_RECS) );
+}
+
+int main( void )
+{
+  pState = mmap( NULL, sizeof( flashState_t ), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+  if ( pState == MAP_FAILED )
+  {
+    return ( 1 );
+  }
+
+  ZTEST_RUN( testEmpty );
+  ZTEST_RUN( testWrap );
+  ZTEST_RUN( testSeqWrap );
+  ZTEST_RUN( testPowerCut );
+
+  return ( ZTEST_RESULT );
+}
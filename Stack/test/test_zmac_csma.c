@@ -0,0 +1,457 @@
+/**************************************************************************************************
+  Filename:       test_zmac_csma.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host simulation of the channel access accounting and
+                  the adaptive CSMA controller of zmac_cb.c.  Frames go
+                  through an unslotted CSMA-CA with the PIB parameters
+                  the controller sets, on a channel occupied by bursts
+                  of other traffic and shared with other contenders,
+                  and every data confirm is fed to
+                  ZMacChanAccessUpdate().  Quiet, apartment, bursty and
+                  saturated contention profiles are run with the
+                  controller and with the static parameters, counting
+                  the CCA failures, the collisions, the backoff time and
+                  the parameters the controller went through.
+**************************************************************************************************/
+
+#include <stdio.h>
+
+#include "ztest.h"
+#include "comdef.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define CODE
+#define MIN( n, m )                         ( ((n) < (m)) ? (n) : (m) )
+#define MAX( n, m )                         ( ((n) > (m)) ? (n) : (m) )
+
+typedef uint8_t ZMacStatus_t;
+
+#define ZMacSuccess                         0x00
+#define ZMacInvalidParameter                0xE8
+#define MAC_SUCCESS                         0x00
+#define MAC_CHANNEL_ACCESS_FAILURE          0xE1
+#define MAC_NO_ACK                          0xE9
+#define MAC_TRANSACTION_EXPIRED             0xF0
+#define MAC_TRANSACTION_OVERFLOW            0xF1
+#define MAC_TXOPTION_PWR_CHAN               0x40
+
+#define MAC_LOGICAL_CHANNEL                 0xE1
+#define MAC_MAX_CSMA_BACKOFFS               0x4E
+
+typedef struct
+{
+  uint8_t channel;
+} simMacDataReq_t;
+
+typedef struct
+{
+  uint8_t txOptions;
+  uint8_t nb;
+} simMacTxIntData_t;
+
+typedef struct
+{
+  simMacDataReq_t mac;
+  simMacTxIntData_t internal;
+} macMcpsDataReq_t;
+
+// MAC PIB: the logical channel and the CSMA-CA parameters
+static uint8_t pibChannel = 15;
+static uint8_t pibMinBe = 3;
+static uint8_t pibMaxBe = 5;
+static uint8_t pibMaxBackoffs = 4;
+static uint16_t pibSets;
+
+static uint8_t *simPib( uint8_t pibAttribute )
+{
+  switch ( pibAttribute )
+  {
+    case MAC_LOGICAL_CHANNEL:
+      return ( &pibChannel );
+    case 0x4F:  // ZMAC_PIB_MIN_BE
+      return ( &pibMinBe );
+    case 0x57:  // ZMAC_PIB_MAX_BE
+      return ( &pibMaxBe );
+    case MAC_MAX_CSMA_BACKOFFS:
+      return ( &pibMaxBackoffs );
+  }
+  ZTEST_CHECK( 0 );
+  return ( &pibChannel );
+}
+
+uint8_t MAP_MAC_MlmeGetReq( uint8_t pibAttribute, void *pValue )
+{
+  *(uint8_t *)pValue = *simPib( pibAttribute );
+  return ( MAC_SUCCESS );
+}
+
+uint8_t MAP_MAC_MlmeSetReq( uint8_t pibAttribute, void *pValue )
+{
+  // The MAC keeps macMinBE <= macMaxBE
+  if ( pibAttribute == 0x4F )
+  {
+    ZTEST_CHECK( *(uint8_t *)pValue <= pibMaxBe );
+  }
+  *simPib( pibAttribute ) = *(uint8_t *)pValue;
+  pibSets++;
+  return ( MAC_SUCCESS );
+}
+
+void *OsalPort_memcpy( void *dst, const void *src, unsigned int len )
+{
+  memcpy( dst, src, len );
+  return ( (uint8_t *)dst + len );
+}
+
+#include "test_zmac_csma_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define SIM_BASE_MIN_BE                     3
+#define SIM_BASE_MAX_BE                     5
+#define SIM_BASE_BACKOFFS                   4
+#define SIM_FRAME_SLOTS                     12      // A frame and its ACK, in backoff periods
+#define SIM_GAP_SLOTS                       40      // Between our frames
+
+// Contention profile: the channel is busy for bursts of other traffic of
+// burst backoff periods on average with idle gaps of gap on average, and
+// contenders other CSMA-CA senders pick their slot as we do
+typedef struct
+{
+  uint16_t burst;
+  uint16_t gap;
+  uint8_t  contenders;
+} simContention_t;
+
+typedef struct
+{
+  uint32_t frames;
+  uint32_t ccaFail;
+  uint32_t collided;
+  uint32_t backoffSlots;
+  uint8_t  maxLevel;
+  uint8_t  maxMinBe;
+  uint8_t  maxMaxBe;
+  uint8_t  maxBackoffs;
+} simCsmaStats_t;
+
+static uint32_t simSeed;
+static uint8_t simBusy;
+
+static uint32_t simRand( uint32_t range )
+{
+  simSeed = simSeed * 1103515245 + 12345;
+  return ( ((simSeed >> 8) & 0xFFFFFF) % range );
+}
+
+// The other traffic, one backoff period at a time
+static void simAdvance( const simContention_t *pProf, uint32_t slots )
+{
+  while ( slots-- )
+  {
+    if ( simBusy )
+    {
+      simBusy = (simRand( pProf->burst ) != 0);
+    }
+    else if ( pProf->burst != 0 )
+    {
+      simBusy = (simRand( pProf->gap ) == 0);
+    }
+  }
+}
+
+// One frame through unslotted CSMA-CA, confirmed to the controller
+static void simFrame( const simContention_t *pProf, simCsmaStats_t *pStats )
+{
+  macMcpsDataReq_t req;
+  uint8_t be = pibMinBe;
+  uint8_t nb = 0;
+  uint8_t status = MAC_SUCCESS;
+  uint32_t slots;
+  ZMacCsmaParams_t params;
+  uint8_t level;
+
+  for ( ;; )
+  {
+    slots = simRand( 1 << be );
+    pStats->backoffSlots += slots;
+    simAdvance( pProf, slots );
+
+    if ( !simBusy )
+    {
+      // Another contender that ended its backoff in the same period
+      uint8_t i;
+
+      for ( i = 0; i < pProf->contenders; i++ )
+      {
+        if ( simRand( (1 << be) * 4 ) == 0 )
+        {
+          status = MAC_NO_ACK;
+          pStats->collided++;
+          break;
+        }
+      }
+      simAdvance( pProf, SIM_FRAME_SLOTS );
+      break;
+    }
+
+    if ( ++nb > pibMaxBackoffs )
+    {
+      status = MAC_CHANNEL_ACCESS_FAILURE;
+      pStats->ccaFail++;
+      nb--;
+      break;
+    }
+    be = MIN( be + 1, pibMaxBe );
+  }
+
+  pStats->frames++;
+  memset( &req, 0, sizeof( req ) );
+  req.internal.nb = nb;
+  ZMacChanAccessUpdate( &req, status );
+
+  level = ZMacCsmaCtrlGet( &params );
+  pStats->maxLevel = MAX( pStats->maxLevel, level );
+  pStats->maxMinBe = MAX( pStats->maxMinBe, params.minBe );
+  pStats->maxMaxBe = MAX( pStats->maxMaxBe, params.maxBe );
+  pStats->maxBackoffs = MAX( pStats->maxBackoffs, params.maxBackoffs );
+
+  simAdvance( pProf, SIM_GAP_SLOTS );
+}
+
+static void simReset( uint8_t ctrl )
+{
+  ZMacCsmaCtrlEnable( FALSE );
+  zmacCsmaLevel = 0;
+  pibMinBe = SIM_BASE_MIN_BE;
+  pibMaxBe = SIM_BASE_MAX_BE;
+  pibMaxBackoffs = SIM_BASE_BACKOFFS;
+  pibChannel = 15;
+  ZMacChanAccessClear();
+  ZMacCsmaCtrlEnable( ctrl );
+
+  simSeed = 7;
+  simBusy = FALSE;
+}
+
+static void simRun( const simContention_t *pProf, uint32_t frames, uint8_t ctrl,
+                    simCsmaStats_t *pStats )
+{
+  memset( pStats, 0, sizeof( *pStats ) );
+  simReset( ctrl );
+  while ( frames-- )
+  {
+    simFrame( pProf, pStats );
+  }
+}
+
+static void simPrint( const char *pName, const simCsmaStats_t *pStats )
+{
+  printf( "  %-8s %5u frames: %4u CCA failures, %4u collisions, %3u slots of backoff per frame, "
+          "level %u, BE %u-%u, %u backoffs\n",
+          pName, (unsigned)pStats->frames, (unsigned)pStats->ccaFail,
+          (unsigned)pStats->collided, (unsigned)(pStats->backoffSlots / pStats->frames),
+          pStats->maxLevel, pStats->maxMinBe, pStats->maxMaxBe, pStats->maxBackoffs );
+}
+
+static void simCompare( const char *pName, const simContention_t *pProf, uint32_t frames,
+                        simCsmaStats_t *pCtrl, simCsmaStats_t *pStatic )
+{
+  simRun( pProf, frames, FALSE, pStatic );
+  simRun( pProf, frames, TRUE, pCtrl );
+
+  printf( "  %s:\n", pName );
+  simPrint( "static", pStatic );
+  simPrint( "ctrl", pCtrl );
+
+  // Never past the safe bounds
+  ZTEST_CHECK( pStatic->maxLevel == 0 );
+  ZTEST_CHECK( pCtrl->maxMinBe <= ZMAC_CSMA_MAX_MIN_BE );
+  ZTEST_CHECK( pCtrl->maxMaxBe <= ZMAC_CSMA_MAX_MAX_BE );
+  ZTEST_CHECK( pCtrl->maxBackoffs <= ZMAC_CSMA_MAX_BACKOFFS );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+
+static void testChanAccessStats( void )
+{
+  ZMacChanAccessStats_t stats;
+  uint32_t hist[ZMAC_CSMA_NB_BINS];
+  macMcpsDataReq_t req;
+
+  simReset( FALSE );
+  memset( &req, 0, sizeof( req ) );
+
+  req.internal.nb = 0;
+  ZMacChanAccessUpdate( &req, MAC_SUCCESS );
+  req.internal.nb = 1;
+  ZMacChanAccessUpdate( &req, MAC_NO_ACK );
+  req.internal.nb = 4;
+  ZMacChanAccessUpdate( &req, MAC_CHANNEL_ACCESS_FAILURE );
+  req.internal.nb = 9;
+  ZMacChanAccessUpdate( &req, MAC_SUCCESS );
+
+  // Overflows are counted but never reached the channel
+  req.internal.nb = 0;
+  ZMacChanAccessUpdate( &req, MAC_TRANSACTION_OVERFLOW );
+
+  // Frames sent with their own channel count there
+  req.internal.txOptions = MAC_TXOPTION_PWR_CHAN;
+  req.mac.channel = 20;
+  ZMacChanAccessUpdate( &req, MAC_SUCCESS );
+
+  ZTEST_CHECK( ZMacChanAccessGetStats( 15, &stats ) == ZMacSuccess );
+  ZTEST_CHECK( stats.txCnt == 5 );
+  ZTEST_CHECK( stats.ccaFailCnt == 1 );
+  ZTEST_CHECK( stats.noAckCnt == 1 );
+  ZTEST_CHECK( stats.overflowCnt == 1 );
+  ZTEST_CHECK( ZMacChanAccessGetStats( 20, &stats ) == ZMacSuccess );
+  ZTEST_CHECK( stats.txCnt == 1 );
+
+  ZTEST_CHECK( ZMacChanAccessGetStats( 10, &stats ) == ZMacInvalidParameter );
+  ZTEST_CHECK( ZMacChanAccessGetStats( 27, &stats ) == ZMacInvalidParameter );
+
+  ZMacChanAccessGetBackoffHist( hist );
+  ZTEST_CHECK( hist[0] == 2 );
+  ZTEST_CHECK( hist[1] == 1 );
+  ZTEST_CHECK( hist[4] == 1 );
+  ZTEST_CHECK( hist[ZMAC_CSMA_NB_BINS - 1] == 1 );
+
+  ZMacChanAccessClear();
+  ZMacChanAccessGetBackoffHist( hist );
+  ZTEST_CHECK( hist[0] == 0 );
+  ZTEST_CHECK( ZMacChanAccessGetStats( 15, &stats ) == ZMacSuccess );
+  ZTEST_CHECK( stats.txCnt == 0 );
+}
+
+// The controller only backs off further than the parameters it found and
+// puts them back when it is disabled
+static void testCsmaCtrlRestore( void )
+{
+  static const simContention_t busy = { 30, 30, 4 };
+  simCsmaStats_t stats;
+  ZMacCsmaParams_t params;
+
+  memset( &stats, 0, sizeof( stats ) );
+  simReset( TRUE );
+  pibSets = 0;
+  while ( ZMacCsmaCtrlGet( &params ) == 0 )
+  {
+    simFrame( &busy, &stats );
+  }
+  ZTEST_CHECK( pibSets == 3 );
+  ZTEST_CHECK( stats.frames == ZMAC_CSMA_CTRL_WINDOW );
+  ZTEST_CHECK( params.maxBackoffs == SIM_BASE_BACKOFFS + 1 );
+
+  ZMacCsmaCtrlEnable( FALSE );
+  ZTEST_CHECK( ZMacCsmaCtrlGet( &params ) == 0 );
+  ZTEST_CHECK( params.minBe == SIM_BASE_MIN_BE );
+  ZTEST_CHECK( params.maxBe == SIM_BASE_MAX_BE );
+  ZTEST_CHECK( params.maxBackoffs == SIM_BASE_BACKOFFS );
+
+  // Disabled, the confirms don't move the parameters
+  pibSets = 0;
+  simFrame( &busy, &stats );
+  ZTEST_CHECK( pibSets == 0 );
+}
+
+static void testCsmaProfileQuiet( void )
+{
+  static const simContention_t quiet = { 0, 1, 0 };
+  simCsmaStats_t ctrl, fixed;
+
+  simCompare( "quiet channel", &quiet, 4000, &ctrl, &fixed );
+
+  ZTEST_CHECK( ctrl.maxLevel == 0 );
+  ZTEST_CHECK( ctrl.ccaFail == 0 );
+  ZTEST_CHECK( ctrl.backoffSlots == fixed.backoffSlots );
+}
+
+static void testCsmaProfileApartment( void )
+{
+  static const simContention_t apartment = { 40, 60, 3 };
+  simCsmaStats_t ctrl, fixed;
+
+  simCompare( "apartment, 40% occupied in bursts", &apartment, 4000, &ctrl, &fixed );
+
+  // Longer backoffs get past the bursts: fewer frames lost to a busy
+  // channel or a collision, for more time in backoff
+  ZTEST_CHECK( ctrl.maxLevel > 0 );
+  ZTEST_CHECK( ctrl.ccaFail * 2 < fixed.ccaFail );
+  ZTEST_CHECK( ctrl.ccaFail + ctrl.collided < fixed.ccaFail + fixed.collided );
+}
+
+static void testCsmaProfileBursty( void )
+{
+  static const simContention_t phases[2] = { { 0, 1, 0 }, { 40, 40, 3 } };
+  simCsmaStats_t ctrl;
+  ZMacCsmaParams_t params;
+  uint8_t phase, levelBusy = 0;
+  uint32_t i, settle = 0;
+
+  memset( &ctrl, 0, sizeof( ctrl ) );
+
+  // Busy and quiet spells of 1000 frames: up during the busy ones, back to
+  // the base parameters in the quiet ones
+  simReset( TRUE );
+  for ( phase = 0; phase < 6; phase++ )
+  {
+    for ( i = 0; i < 1000; i++ )
+    {
+      simFrame( &phases[phase & 1], &ctrl );
+      if ( ((phase & 1) == 0) && (phase != 0) && (settle < i) &&
+           (ZMacCsmaCtrlGet( &params ) != 0) )
+      {
+        settle = i + 1;
+      }
+    }
+    if ( phase & 1 )
+    {
+      levelBusy = MAX( levelBusy, ZMacCsmaCtrlGet( &params ) );
+    }
+    else
+    {
+      ZTEST_CHECK( ZMacCsmaCtrlGet( &params ) == 0 );
+      ZTEST_CHECK( params.minBe == SIM_BASE_MIN_BE );
+      ZTEST_CHECK( params.maxBackoffs == SIM_BASE_BACKOFFS );
+    }
+  }
+
+  printf( "  bursty: level %u in the busy spells, base parameters %u frames into the quiet ones\n",
+          levelBusy, (unsigned)settle );
+  ZTEST_CHECK( levelBusy > 0 );
+  ZTEST_CHECK( settle <= ZMAC_CSMA_NUM_LEVELS * ZMAC_CSMA_CTRL_WINDOW );
+}
+
+static void testCsmaProfileSaturated( void )
+{
+  static const simContention_t saturated = { 200, 20, 6 };
+  simCsmaStats_t ctrl, fixed;
+
+  simCompare( "saturated, 90% occupied", &saturated, 4000, &ctrl, &fixed );
+
+  // Up to the bounds and held there
+  ZTEST_CHECK( ctrl.maxLevel == ZMAC_CSMA_NUM_LEVELS - 1 );
+  ZTEST_CHECK( ctrl.maxMinBe == ZMAC_CSMA_MAX_MIN_BE );
+  ZTEST_CHECK( ctrl.maxBackoffs == ZMAC_CSMA_MAX_BACKOFFS );
+  ZTEST_CHECK( ctrl.ccaFail <= fixed.ccaFail );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testChanAccessStats );
+  ZTEST_RUN( testCsmaCtrlRestore );
+  ZTEST_RUN( testCsmaProfileQuiet );
+  ZTEST_RUN( testCsmaProfileApartment );
+  ZTEST_RUN( testCsmaProfileBursty );
+  ZTEST_RUN( testCsmaProfileSaturated );
+
+  return ( ZTEST_RESULT );
+}
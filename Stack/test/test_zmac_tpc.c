@@ -0,0 +1,428 @@
+/**************************************************************************************************
+  Filename:       test_zmac_tpc.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host model of the per-destination transmit power
+                  control of zmac.c: unicasts to a neighbor go through
+                  zmacTpcSelectPower(), a simulated link with a path-loss
+                  trace and fading decides the MAC retries and the data
+                  confirm fed back through ZMacTpcTxUpdate(), and the
+                  neighbor's own frames come back through
+                  ZMacTpcRxUpdate().  Static, walk-away, obstructed and
+                  edge-of-range traces are run against the same traces
+                  at full power, counting the transmit power, the
+                  attempts and the frames lost.
+**************************************************************************************************/
+
+#include <stdio.h>
+
+#include "ztest.h"
+#include "comdef.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+typedef uint8_t ZMacStatus_t;
+
+#define ZMacSuccess                         0x00
+#define ZMacInvalidParameter                0xE8
+#define MAC_SUCCESS                         0x00
+#define MAC_NO_ACK                          0xE9
+#define MAC_PHY_TRANSMIT_POWER_SIGNED       0xE0
+
+// CC26X2 2.4 GHz power table, sorted by increasing power
+#define RF_TxPowerTable_INVALID_DBM         127
+
+typedef struct
+{
+  int8_t   power;
+  uint32_t value;
+} RF_TxPowerTable_Entry;
+
+static RF_TxPowerTable_Entry simPowerTable[] =
+{
+  { -20, 0 }, { -18, 0 }, { -15, 0 }, { -12, 0 }, { -10, 0 }, { -9, 0 }, { -6, 0 },
+  { -5, 0 }, { -3, 0 }, { 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 }, { 5, 0 },
+  { RF_TxPowerTable_INVALID_DBM, 0 }
+};
+
+RF_TxPowerTable_Entry *pRfPowerTable = simPowerTable;
+
+// MAC_PHY_TRANSMIT_POWER_SIGNED, the power set with MT_SYS_SET_TX_POWER
+static int8_t simMaxPower = 5;
+
+uint8_t MAP_MAC_MlmeGetReq( uint8_t pibAttribute, void *pValue )
+{
+  ZTEST_CHECK( pibAttribute == MAC_PHY_TRANSMIT_POWER_SIGNED );
+  *(int8_t *)pValue = simMaxPower;
+  return ( MAC_SUCCESS );
+}
+
+#include "test_zmac_tpc_items.c"
+
+/*********************************************************************
+ * HELPERS
+ */
+#define SIM_NBR_ADDR                        0x1234
+#define SIM_NBR_POWER                       5       // Neighbor transmits at full power
+#define SIM_SENSITIVITY                     ZMAC_TPC_DEFAULT_SENSITIVITY
+#define SIM_FADE_DB                         6       // Fading of each frame, +/- dB
+#define SIM_MAC_RETRIES                     3
+
+typedef struct
+{
+  uint16_t frames;
+  uint16_t lost;            // Frames the MAC gave up on
+  uint32_t attempts;
+  int32_t  powerSum;        // Transmit power of every attempt, dBm
+  uint16_t reduced;         // Frames sent below full power
+} simLinkStats_t;
+
+static uint32_t simSeed;
+
+// Fading of one frame, uniform over +/- SIM_FADE_DB
+static int8_t simFade( void )
+{
+  simSeed = simSeed * 1103515245 + 12345;
+  return ( (int8_t)((int32_t)((simSeed >> 16) % (2 * SIM_FADE_DB + 1)) - SIM_FADE_DB) );
+}
+
+// A frame sent at power over the path loss is received when it is above
+// the sensitivity after fading
+static uint8_t simHeard( int8_t power, uint8_t pathLoss, int8_t *pRssi )
+{
+  int16_t rssi = (int16_t)power - pathLoss + simFade();
+
+  *pRssi = (int8_t)rssi;
+  return ( rssi >= SIM_SENSITIVITY );
+}
+
+// One unicast to the neighbor and its MAC retries, then a frame back from
+// the neighbor
+static void simUnicast( uint8_t pathLoss, simLinkStats_t *pStats )
+{
+  int8_t power = simMaxPower;
+  int8_t rssi, ackRssi = 0;
+  uint8_t status = MAC_NO_ACK;
+  uint8_t retries;
+
+  if ( (zmacTpcCfg.enabled == TRUE) && (zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == TRUE) )
+  {
+    ZTEST_CHECK( power < simMaxPower );
+    pStats->reduced++;
+  }
+
+  for ( retries = 0; retries <= SIM_MAC_RETRIES; retries++ )
+  {
+    pStats->attempts++;
+    pStats->powerSum += power;
+    if ( simHeard( power, pathLoss, &rssi ) && simHeard( SIM_NBR_POWER, pathLoss, &ackRssi ) )
+    {
+      status = MAC_SUCCESS;
+      break;
+    }
+  }
+
+  pStats->frames++;
+  if ( status == MAC_NO_ACK )
+  {
+    pStats->lost++;
+    retries = SIM_MAC_RETRIES;
+  }
+  ZMacTpcTxUpdate( SIM_NBR_ADDR, status, retries, ackRssi );
+
+  if ( simHeard( SIM_NBR_POWER, pathLoss, &rssi ) )
+  {
+    ZMacTpcRxUpdate( SIM_NBR_ADDR, rssi );
+  }
+}
+
+// Path loss in dB of frame i of a trace
+typedef uint8_t (*simTrace_t)( uint16_t i );
+
+static void simTpcRun( simTrace_t pfnTrace, uint16_t frames, uint8_t tpc, simLinkStats_t *pStats )
+{
+  ZMacTpcCfg_t cfg = { FALSE, ZMAC_TPC_DEFAULT_MARGIN, ZMAC_TPC_DEFAULT_SENSITIVITY,
+                       ZMAC_TPC_DEFAULT_FALLBACK };
+  uint16_t i;
+
+  ZMacTpcConfig( &cfg );
+  cfg.enabled = tpc;
+  ZTEST_CHECK( ZMacTpcConfig( &cfg ) == ZMacSuccess );
+
+  memset( pStats, 0, sizeof( *pStats ) );
+  simSeed = 1;
+  for ( i = 0; i < frames; i++ )
+  {
+    simUnicast( pfnTrace( i ), pStats );
+  }
+}
+
+static void simPrint( const char *pName, const simLinkStats_t *pStats )
+{
+  printf( "  %-10s %4u frames %3u lost, %4u attempts, %4u reduced, mean power %3d dBm\n",
+          pName, pStats->frames, pStats->lost, (unsigned)pStats->attempts, pStats->reduced,
+          (int)(pStats->powerSum / (int32_t)pStats->attempts) );
+}
+
+// Path-loss traces
+static uint8_t traceStatic( uint16_t i )
+{
+  (void)i;
+  return ( 70 );
+}
+
+// Walking away from 60 to 100 dB over 1000 frames
+static uint8_t traceWalkAway( uint16_t i )
+{
+  return ( (uint8_t)(60 + i / 25) );
+}
+
+// A door shuts after 300 frames: 18 dB more
+static uint8_t traceObstructed( uint16_t i )
+{
+  return ( (i < 300) ? 70 : 88 );
+}
+
+// Edge of range, fading costs retries at full power
+static uint8_t traceEdge( uint16_t i )
+{
+  (void)i;
+  return ( 99 );
+}
+
+static void simCompare( const char *pName, simTrace_t pfnTrace, uint16_t frames,
+                        simLinkStats_t *pTpc, simLinkStats_t *pFull )
+{
+  simTpcRun( pfnTrace, frames, FALSE, pFull );
+  simTpcRun( pfnTrace, frames, TRUE, pTpc );
+
+  printf( "  %s:\n", pName );
+  simPrint( "full", pFull );
+  simPrint( "tpc", pTpc );
+
+  ZTEST_CHECK( pFull->reduced == 0 );
+  ZTEST_CHECK( pFull->powerSum == (int32_t)pFull->attempts * simMaxPower );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+
+static void testTpcConfig( void )
+{
+  ZMacTpcCfg_t cfg = { 2, ZMAC_TPC_DEFAULT_MARGIN, ZMAC_TPC_DEFAULT_SENSITIVITY,
+                       ZMAC_TPC_DEFAULT_FALLBACK };
+  ZMacTpcCfg_t get;
+  int8_t power;
+
+  // Enabled is a boolean and a margin of 0 would leave none for fading
+  ZTEST_CHECK( ZMacTpcConfig( &cfg ) == ZMacInvalidParameter );
+  cfg.enabled = TRUE;
+  cfg.margin = 0;
+  ZTEST_CHECK( ZMacTpcConfig( &cfg ) == ZMacInvalidParameter );
+
+  cfg.margin = 12;
+  ZTEST_CHECK( ZMacTpcConfig( &cfg ) == ZMacSuccess );
+  ZMacTpcGetConfig( &get );
+  ZTEST_CHECK( memcmp( &get, &cfg, sizeof( cfg ) ) == 0 );
+
+  // Switching it on again starts over from full power
+  ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == FALSE );
+  ZMacTpcRxUpdate( SIM_NBR_ADDR, -40 );
+  ZTEST_CHECK( zmacTpcFind( SIM_NBR_ADDR ) != NULL );
+  cfg.enabled = FALSE;
+  ZTEST_CHECK( ZMacTpcConfig( &cfg ) == ZMacSuccess );
+  cfg.enabled = TRUE;
+  ZTEST_CHECK( ZMacTpcConfig( &cfg ) == ZMacSuccess );
+  ZTEST_CHECK( zmacTpcFind( SIM_NBR_ADDR ) == NULL );
+
+  // Broadcast and reserved addresses are never tracked
+  ZTEST_CHECK( zmacTpcFind( 0xFFFD ) == NULL );
+  ZTEST_CHECK( zmacTpcFind( ZMAC_TPC_ADDR_FREE ) == NULL );
+
+  cfg.enabled = FALSE;
+  ZMacTpcConfig( &cfg );
+}
+
+static void testTpcSelect( void )
+{
+  ZMacTpcCfg_t cfg = { TRUE, 20, -97, 8 };
+  int8_t power;
+
+  ZMacTpcConfig( &cfg );
+
+  // Not heard yet: full power
+  ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == FALSE );
+
+  // -65 dBm is 32 dB above the sensitivity, 12 dB can be shed with a
+  // margin of 20: the lowest entry at or above -7 dBm
+  ZMacTpcRxUpdate( SIM_NBR_ADDR, -65 );
+  ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == TRUE );
+  ZTEST_CHECK( power == -6 );
+
+  // Below the margin: full power
+  ZMacTpcRxUpdate( SIM_NBR_ADDR, -90 );
+  ZMacTpcRxUpdate( SIM_NBR_ADDR, -90 );
+  ZMacTpcRxUpdate( SIM_NBR_ADDR, -90 );
+  ZMacTpcRxUpdate( SIM_NBR_ADDR, -90 );
+  ZMacTpcRxUpdate( SIM_NBR_ADDR, -90 );
+  ZTEST_CHECK( zmacTpcFind( SIM_NBR_ADDR )->rssi <= -85 );
+  ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == FALSE );
+
+  // A missed ACK: full power for the fallback frames, a margin bias after
+  zmacTpcFind( SIM_NBR_ADDR )->rssi = -60;
+  ZMacTpcTxUpdate( SIM_NBR_ADDR, MAC_NO_ACK, SIM_MAC_RETRIES, 0 );
+  ZTEST_CHECK( zmacTpcFind( SIM_NBR_ADDR )->bias == ZMAC_TPC_MARGIN_STEP );
+  for ( power = 0; power < 8; power++ )
+  {
+    int8_t sel;
+    ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &sel ) == FALSE );
+  }
+  ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == TRUE );
+  ZTEST_CHECK( power == -9 );
+
+  // Never above the power set with MT_SYS_SET_TX_POWER
+  simMaxPower = 0;
+  ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == TRUE );
+  ZTEST_CHECK( power == -12 );
+  zmacTpcFind( SIM_NBR_ADDR )->rssi = -80;
+  ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == FALSE );
+  simMaxPower = 5;
+
+  cfg.enabled = FALSE;
+  ZMacTpcConfig( &cfg );
+}
+
+// More destinations than entries: the least recently sent to is dropped
+static void testTpcTableLru( void )
+{
+  ZMacTpcCfg_t cfg = { TRUE, 20, -97, 8 };
+  int8_t power;
+  uint16_t addr;
+
+  ZMacTpcConfig( &cfg );
+
+  for ( addr = 1; addr <= ZMAC_TPC_MAX_ENTRIES; addr++ )
+  {
+    zmacTpcSelectPower( addr, &power );
+    ZMacTpcRxUpdate( addr, -50 );
+  }
+  zmacTpcSelectPower( 1, &power );
+  zmacTpcSelectPower( ZMAC_TPC_MAX_ENTRIES + 1, &power );
+
+  ZTEST_CHECK( zmacTpcFind( 1 ) != NULL );
+  ZTEST_CHECK( zmacTpcFind( 2 ) == NULL );
+  ZTEST_CHECK( zmacTpcFind( ZMAC_TPC_MAX_ENTRIES + 1 ) != NULL );
+  ZTEST_CHECK( zmacTpcFind( ZMAC_TPC_MAX_ENTRIES + 1 )->rssi == ZMAC_TPC_RSSI_UNKNOWN );
+
+  // Frames from an untracked neighbor don't take an entry
+  ZMacTpcRxUpdate( 0x4000, -50 );
+  ZTEST_CHECK( zmacTpcFind( 0x4000 ) == NULL );
+
+  cfg.enabled = FALSE;
+  ZMacTpcConfig( &cfg );
+  ZMacTpcRxUpdate( 1, -90 );
+  ZTEST_CHECK( zmacTpcFind( 1 )->rssi == -50 );
+}
+
+static void testTpcTraceStatic( void )
+{
+  simLinkStats_t tpc, full;
+
+  simCompare( "static link, 70 dB", traceStatic, 500, &tpc, &full );
+
+  // Down to the lowest entry that keeps the margin, nothing lost
+  ZTEST_CHECK( tpc.lost == 0 );
+  ZTEST_CHECK( tpc.attempts == tpc.frames );
+  ZTEST_CHECK( tpc.reduced >= tpc.frames - 1 );
+  ZTEST_CHECK( tpc.powerSum / (int32_t)tpc.attempts <= -5 );
+}
+
+static void testTpcTraceWalkAway( void )
+{
+  simLinkStats_t tpc, full;
+
+  simCompare( "walking away, 60 to 100 dB", traceWalkAway, 1000, &tpc, &full );
+
+  // The power follows the path loss up, the link fails no more often
+  // than at full power
+  ZTEST_CHECK( tpc.powerSum / (int32_t)tpc.attempts <= full.powerSum / (int32_t)full.attempts - 5 );
+  ZTEST_CHECK( tpc.lost <= full.lost + 2 );
+  ZTEST_CHECK( tpc.attempts <= full.attempts + full.attempts / 20 );
+}
+
+static void testTpcTraceObstructed( void )
+{
+  simLinkStats_t tpc, full;
+  simLinkStats_t before, after;
+  uint16_t i, recover = 0;
+  int8_t power;
+  ZMacTpcCfg_t cfg = { TRUE, ZMAC_TPC_DEFAULT_MARGIN, ZMAC_TPC_DEFAULT_SENSITIVITY,
+                       ZMAC_TPC_DEFAULT_FALLBACK };
+
+  simCompare( "obstructed, 70 then 88 dB", traceObstructed, 600, &tpc, &full );
+
+  ZTEST_CHECK( tpc.lost <= full.lost + 1 );
+  ZTEST_CHECK( tpc.powerSum / (int32_t)tpc.attempts < full.powerSum / (int32_t)full.attempts );
+
+  // Frame by frame through the step: back at full power within the
+  // frames it takes the smoothed RSSI or a missed ACK to notice
+  cfg.enabled = FALSE;
+  ZMacTpcConfig( &cfg );
+  cfg.enabled = TRUE;
+  ZMacTpcConfig( &cfg );
+  memset( &before, 0, sizeof( before ) );
+  simSeed = 1;
+  for ( i = 0; i < 300; i++ )
+  {
+    simUnicast( traceObstructed( i ), &before );
+  }
+  ZTEST_CHECK( zmacTpcSelectPower( SIM_NBR_ADDR, &power ) == TRUE );
+  ZTEST_CHECK( power < 0 );
+
+  memset( &after, 0, sizeof( after ) );
+  for ( ; i < 600; i++ )
+  {
+    simUnicast( traceObstructed( i ), &after );
+    if ( (recover == 0) && (after.reduced < after.frames) )
+    {
+      recover = after.frames;
+    }
+  }
+  printf( "  obstructed: full power %u frames after the step, %u lost\n", recover, after.lost );
+
+  ZTEST_CHECK( recover != 0 );
+  ZTEST_CHECK( recover <= 8 );
+  ZTEST_CHECK( after.lost <= 1 );
+  ZTEST_CHECK( after.reduced <= recover + 2 );
+
+  cfg.enabled = FALSE;
+  ZMacTpcConfig( &cfg );
+}
+
+static void testTpcTraceEdge( void )
+{
+  simLinkStats_t tpc, full;
+
+  simCompare( "edge of range, 99 dB", traceEdge, 500, &tpc, &full );
+
+  // No power to shed
+  ZTEST_CHECK( tpc.reduced == 0 );
+  ZTEST_CHECK( tpc.lost == full.lost );
+  ZTEST_CHECK( tpc.attempts == full.attempts );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testTpcConfig );
+  ZTEST_RUN( testTpcSelect );
+  ZTEST_RUN( testTpcTableLru );
+  ZTEST_RUN( testTpcTraceStatic );
+  ZTEST_RUN( testTpcTraceWalkAway );
+  ZTEST_RUN( testTpcTraceObstructed );
+  ZTEST_RUN( testTpcTraceEdge );
+
+  return ( ZTEST_RESULT );
+}
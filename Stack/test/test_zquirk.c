@@ -0,0 +1,321 @@
+/**************************************************************************************************
+  Filename:       test_zquirk.c
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Host tests of the device quirk table: key precedence,
+                  the cached behaviors per device across short address
+                  changes, table maintenance and the NV copy.
+**************************************************************************************************/
+
+#include "ztest.h"
+#include "zquirk.h"
+#include "addr_mgr.h"
+#include "osal_nv.h"
+
+/*********************************************************************
+ * STAND-INS
+ */
+#define NV_LEN  ( ZQUIRK_MAX_ENTRIES * sizeof( zquirkEntry_t ) )
+
+uint32_t ztestClock = 0;
+
+static uint8_t nvItem[NV_LEN];
+static uint16_t nvLen = 0;        // 0 when the item doesn't exist
+static uint16_t nvWrites = 0;
+
+// Address manager: devices by index
+#define DEVS  4
+static uint16_t devNwk[DEVS];
+static uint8_t devExt[DEVS][Z_EXTADDR_LEN];
+static uint16_t addrLookups = 0;
+
+uint8_t osal_nv_item_init_ex( uint16_t id, uint16_t subId, uint16_t len, void *buf )
+{
+  ZTEST_CHECK( (id == ZCD_NV_EX_QUIRK_TABLE) && (subId == 0) && (len == NV_LEN) );
+  memcpy( nvItem, buf, len );
+  nvLen = len;
+  return ( NV_ITEM_UNINIT );
+}
+
+uint8_t osal_nv_write_ex( uint16_t id, uint16_t subId, uint16_t len, void *buf )
+{
+  ZTEST_CHECK( (id == ZCD_NV_EX_QUIRK_TABLE) && (subId == 0) );
+  if ( nvLen == 0 )
+  {
+    return ( NV_ITEM_UNINIT );
+  }
+  memcpy( nvItem, buf, len );
+  nvWrites++;
+  return ( SUCCESS );
+}
+
+uint8_t osal_nv_read_ex( uint16_t id, uint16_t subId, uint16_t offset, uint16_t len, void *buf )
+{
+  (void)id;
+  (void)subId;
+  memcpy( buf, &nvItem[offset], len );
+  return ( SUCCESS );
+}
+
+uint16_t osal_nv_item_len_ex( uint16_t id, uint16_t subId )
+{
+  (void)id;
+  (void)subId;
+  return ( nvLen );
+}
+
+uint8_t AddrMgrEntryLookupNwk( AddrMgrEntry_t* entry )
+{
+  uint16_t i;
+
+  addrLookups++;
+  for ( i = 0; i < DEVS; i++ )
+  {
+    if ( devNwk[i] == entry->nwkAddr )
+    {
+      entry->index = i;
+      memcpy( entry->extAddr, devExt[i], Z_EXTADDR_LEN );
+      return ( TRUE );
+    }
+  }
+
+  return ( FALSE );
+}
+
+uint8_t AddrMgrEntryLookupExt( AddrMgrEntry_t* entry )
+{
+  uint16_t i;
+
+  addrLookups++;
+  for ( i = 0; i < DEVS; i++ )
+  {
+    if ( (devNwk[i] != INVALID_NODE_ADDR) &&
+         (memcmp( devExt[i], entry->extAddr, Z_EXTADDR_LEN ) == 0) )
+    {
+      entry->index = i;
+      entry->nwkAddr = devNwk[i];
+      return ( TRUE );
+    }
+  }
+
+  return ( FALSE );
+}
+
+/*********************************************************************
+ * HELPERS
+ */
+// IEEE addresses are LSB first, the OUI is in the last three bytes
+static uint8_t extA[Z_EXTADDR_LEN] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x0B, 0x57, 0xCC };
+static uint8_t extB[Z_EXTADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0B, 0x57, 0xCC };
+static uint8_t extC[Z_EXTADDR_LEN] = { 0x03, 0x00, 0x00, 0x00, 0x00, 0x11, 0x22, 0x33 };
+
+static uint8_t ouiCC570B[3] = { 0x0B, 0x57, 0xCC };
+static uint8_t manuf1234[2] = { 0x34, 0x12 };
+
+static void reset( void )
+{
+  uint16_t i;
+
+  nvLen = 0;
+  nvWrites = 0;
+  addrLookups = 0;
+  for ( i = 0; i < DEVS; i++ )
+  {
+    devNwk[i] = INVALID_NODE_ADDR;
+  }
+
+  ZQuirkInit();
+}
+
+static void devSet( uint16_t i, uint16_t nwkAddr, uint8_t *extAddr )
+{
+  devNwk[i] = nwkAddr;
+  memcpy( devExt[i], extAddr, Z_EXTADDR_LEN );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+static void testEmpty( void )
+{
+  reset();
+
+  devSet( 0, 0x1001, extA );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == 0 );
+  ZTEST_CHECK( ZQuirkLookupExt( extA ) == 0 );
+
+  // No entries, no address manager lookups
+  ZTEST_CHECK( addrLookups == 0 );
+}
+
+static void testPrecedence( void )
+{
+  reset();
+
+  devSet( 0, 0x1001, extA );
+  devSet( 1, 0x1002, extB );
+
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_OUI, ouiCC570B, ZQUIRK_APS_ACK ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == ZQUIRK_APS_ACK );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1002 ) == ZQUIRK_APS_ACK );
+  ZTEST_CHECK( ZQuirkLookupExt( extC ) == 0 );
+
+  // A manufacturer code entry only applies once the code is seen
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_MANUF, manuf1234, ZQUIRK_NO_APS_ACK ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == ZQUIRK_APS_ACK );
+  ZQuirkSetManufCode( 0x1001, 0x1234 );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == ZQUIRK_NO_APS_ACK );
+  ZTEST_CHECK( ZQuirkLookupExt( extA ) == ZQUIRK_NO_APS_ACK );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1002 ) == ZQUIRK_APS_ACK );
+
+  // The IEEE address entry overrides both, whatever the table order
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE, extA, ZQUIRK_NO_SRC_ROUTE ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == ZQUIRK_NO_SRC_ROUTE );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1002 ) == ZQUIRK_APS_ACK );
+
+  // Unknown to the address manager, manufacturer code entries can't apply
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_OUI, &extC[5], ZQUIRK_ANY_PROFILE ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkLookupExt( extC ) == ZQUIRK_ANY_PROFILE );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1003 ) == 0 );
+}
+
+static void testCache( void )
+{
+  reset();
+
+  devSet( 0, 0x1001, extA );
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_MANUF, manuf1234, ZQUIRK_APS_ACK ) == ZSuccess );
+  ZQuirkSetManufCode( 0x1001, 0x1234 );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == ZQUIRK_APS_ACK );
+
+  // A table change stales the cached behaviors
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_MANUF, manuf1234, ZQUIRK_NO_APS_ACK ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == ZQUIRK_NO_APS_ACK );
+
+  // Another device took the address manager entry, its code isn't known
+  devSet( 0, 0x2001, extB );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x2001 ) == 0 );
+  ZQuirkSetManufCode( 0x2001, 0x1234 );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x2001 ) == ZQUIRK_NO_APS_ACK );
+
+  // Back at the generation the behaviors were cached with after a wrap
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_OUI, ouiCC570B, ZQUIRK_ANY_PROFILE ) == ZSuccess );
+  devSet( 1, 0x1002, extA );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1002 ) == ZQUIRK_ANY_PROFILE );
+  {
+    uint16_t n;
+
+    for ( n = 0; n < 254; n++ )
+    {
+      ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE, extC, (n & 1) ? 0 : ZQUIRK_APS_ACK ) == ZSuccess );
+    }
+  }
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_OUI, ouiCC570B, ZQUIRK_APS_ACK ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1002 ) == ZQUIRK_APS_ACK );
+}
+
+static void testNewAddress( void )
+{
+  reset();
+
+  devSet( 0, 0x1001, extA );
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_MANUF, manuf1234, ZQUIRK_NO_SRC_ROUTE ) == ZSuccess );
+  ZQuirkSetManufCode( 0x1001, 0x1234 );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == ZQUIRK_NO_SRC_ROUTE );
+
+  // Rejoined under a new short address, its manufacturer code is kept
+  devSet( 0, 0x3001, extA );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x3001 ) == ZQUIRK_NO_SRC_ROUTE );
+  ZTEST_CHECK( ZQuirkLookupExt( extA ) == ZQUIRK_NO_SRC_ROUTE );
+
+  // Another device that took the old short address isn't given it
+  devSet( 1, 0x1001, extB );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == 0 );
+}
+
+static void testSet( void )
+{
+  zquirkEntry_t entry;
+  uint8_t key[Z_EXTADDR_LEN];
+  uint8_t i;
+
+  reset();
+
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_NONE, extA, ZQUIRK_APS_ACK ) == ZInvalidParameter );
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE + 1, extA, ZQUIRK_APS_ACK ) == ZInvalidParameter );
+
+  // Removing what isn't there
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE, extA, 0 ) == ZSuccess );
+  ZTEST_CHECK( nvWrites == 0 );
+
+  memset( key, 0, sizeof( key ) );
+  for ( i = 0; i < ZQUIRK_MAX_ENTRIES; i++ )
+  {
+    key[0] = i;
+    ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE, key, ZQUIRK_APS_ACK ) == ZSuccess );
+  }
+  key[0] = i;
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE, key, ZQUIRK_APS_ACK ) == ZNwkTableFull );
+
+  // Updating an entry doesn't need a free one
+  key[0] = 3;
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE, key, ZQUIRK_NO_APS_ACK ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkRead( 3, &entry ) == TRUE );
+  ZTEST_CHECK( (entry.keyType == ZQUIRK_KEY_IEEE) && (entry.quirks == ZQUIRK_NO_APS_ACK) );
+
+  // Removed, its place is reused
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE, key, 0 ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkRead( 3, &entry ) && (entry.keyType == ZQUIRK_KEY_NONE) );
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_OUI, ouiCC570B, ZQUIRK_APS_ACK ) == ZSuccess );
+  ZTEST_CHECK( ZQuirkRead( 3, &entry ) && (entry.keyType == ZQUIRK_KEY_OUI) );
+  ZTEST_CHECK( memcmp( entry.key, ouiCC570B, 3 ) == 0 );
+  ZTEST_CHECK( (entry.key[3] == 0) && (entry.key[7] == 0) );
+
+  ZTEST_CHECK( ZQuirkRead( ZQUIRK_MAX_ENTRIES, &entry ) == FALSE );
+
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_ALL, NULL, 0 ) == ZSuccess );
+  for ( i = 0; i < ZQUIRK_MAX_ENTRIES; i++ )
+  {
+    ZTEST_CHECK( ZQuirkRead( i, &entry ) && (entry.keyType == ZQUIRK_KEY_NONE) );
+  }
+}
+
+static void testNv( void )
+{
+  zquirkEntry_t entry;
+
+  reset();
+
+  devSet( 0, 0x1001, extA );
+
+  // The first change creates the item
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_IEEE, extA, ZQUIRK_APS_ACK ) == ZSuccess );
+  ZTEST_CHECK( nvLen == NV_LEN );
+  ZTEST_CHECK( ZQuirkSet( ZQUIRK_KEY_OUI, ouiCC570B, ZQUIRK_NO_SRC_ROUTE ) == ZSuccess );
+  ZTEST_CHECK( nvWrites == 1 );
+
+  // Back after a reset
+  ZQuirkInit();
+  ZTEST_CHECK( ZQuirkRead( 0, &entry ) && (entry.keyType == ZQUIRK_KEY_IEEE) );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == ZQUIRK_APS_ACK );
+  ZTEST_CHECK( ZQuirkLookupExt( extB ) == ZQUIRK_NO_SRC_ROUTE );
+
+  // An item of another size is ignored
+  nvLen = NV_LEN - 1;
+  ZQuirkInit();
+  ZTEST_CHECK( ZQuirkRead( 0, &entry ) && (entry.keyType == ZQUIRK_KEY_NONE) );
+  ZTEST_CHECK( ZQuirkLookupNwk( 0x1001 ) == 0 );
+}
+
+int main( void )
+{
+  ZTEST_RUN( testEmpty );
+  ZTEST_RUN( testPrecedence );
+  ZTEST_RUN( testCache );
+  ZTEST_RUN( testNewAddress );
+  ZTEST_RUN( testSet );
+  ZTEST_RUN( testNv );
+
+  return ( ZTEST_RESULT );
+}
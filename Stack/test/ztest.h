@@ -0,0 +1,38 @@
+/**************************************************************************************************
+  Filename:       ztest.h
+  Revised:        $Date: 2026-10-18 00:00:00 -0700 (Sun, 18 Oct 2026) $
+  Revision:       $Revision: 1 $
+
+  Description:    Checks of the host test programs.  Each program runs
+                  its cases with ZTEST_RUN and returns ZTEST_RESULT from
+                  main, a failed check prints its file and line.
+**************************************************************************************************/
+
+#ifndef ZTEST_H
+#define ZTEST_H
+
+#include <stdio.h>
+
+static int ztestFailed = 0;
+static int ztestCases = 0;
+
+#define ZTEST_CHECK( cond )                                               \
+  do {                                                                    \
+    if ( !(cond) )                                                        \
+    {                                                                     \
+      printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond );   \
+      ztestFailed++;                                                      \
+    }                                                                     \
+  } while ( 0 )
+
+#define ZTEST_RUN( test )                                                 \
+  do {                                                                    \
+    int failed = ztestFailed;                                             \
+    ztestCases++;                                                         \
+    test();                                                               \
+    printf( "%-48s %s\n", #test, (ztestFailed == failed) ? "ok" : "FAILED" ); \
+  } while ( 0 )
+
+#define ZTEST_RESULT   ( (ztestFailed == 0) ? 0 : 1 )
+
+#endif /* ZTEST_H */
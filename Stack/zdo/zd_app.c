@@ -69,6 +69,11 @@
 
 #include "bdb.h"
 #include "ssp.h"
+#include "zevtlog.h"
+#include "zquirk.h"
+#include "rtg_srctree.h"
+#include "nwk_nbrmgr.h"
+#include "nwk_childage.h"
 
 #if defined( MT_MAC_FUNC ) || defined( MT_MAC_CB_FUNC )
   #error "ERROR! MT_MAC functionalities should be disabled on ZDO devices"
@@ -116,6 +121,15 @@
 // Address Manager Stub Implementation
 #define ZDApp_NwkWriteNVRequest AddrMgrWriteNVRequest
 
+// Leaves of other devices held to be cleaned up and indicated together, and
+// the time in ms the first one is held
+#if !defined ( ZDAPP_LEAVE_BATCH_MAX )
+  #define ZDAPP_LEAVE_BATCH_MAX     16
+#endif
+#if !defined ( ZDAPP_LEAVE_BATCH_DELAY )
+  #define ZDAPP_LEAVE_BATCH_DELAY   100
+#endif
+
 
 #if !defined ZDO_NV_SAVE_RFDs
 #define ZDO_NV_SAVE_RFDs  TRUE
@@ -217,6 +231,10 @@ void ZDApp_LeaveCtrlSet( uint8_t ra );
 uint8_t ZDApp_LeaveCtrlBypass( void );
 void ZDApp_LeaveCtrlStartup( devStates_t* state, uint16_t* startDelay );
 void ZDApp_LeaveUpdate( uint16_t nwkAddr, uint8_t* extAddr, uint8_t removeChildren, uint8_t rejoin );
+static void ZDApp_LeaveCleanup( uint16_t nwkAddr, uint8_t* extAddr, uint8_t removeChildren, uint8_t rejoin );
+static void ZDApp_LeaveBatchAdd( uint16_t nwkAddr, uint8_t* extAddr, uint8_t reason,
+                                 uint8_t request, uint8_t removeChildren, uint8_t rejoin );
+static void ZDApp_ChildAgedCB( uint16_t nwkAddr, uint8_t *extAddr );
 void ZDApp_NodeProfileSync( uint8_t stackProfile );
 void ZDApp_ProcessMsgCBs( zdoIncomingMsg_t *inMsg );
 void ZDApp_RegisterCBs( void );
@@ -240,6 +258,9 @@ uint8_t nwkStatus;
 endPointDesc_t *ZDApp_AutoFindMode_epDesc = (endPointDesc_t *)NULL;
 uint8_t ZDApp_LeaveCtrl;
 
+static zdoLeaveRec_t ZDApp_LeaveBatch[ZDAPP_LEAVE_BATCH_MAX];
+static uint8_t ZDApp_LeaveBatchCnt = 0;
+
 devStates_t devState = DEV_HOLD;
 
 // previous rejoin state
@@ -308,6 +329,22 @@ void ZDApp_Init( uint8_t task_id )
 #if defined ( ZDP_BIND_VALIDATION )
   ZDApp_InitPendingBind();
 #endif
+
+  ZEvtLogInit();
+
+  ZQuirkInit();
+
+#if defined ( RTG_SRC_TREE )
+  RTG_SrcTreeInit();
+#endif
+
+  if ( ZSTACK_ROUTER_BUILD )
+  {
+    pNwkChildAgedCB = ZDApp_ChildAgedCB;
+
+    NwkNbrMgr_Init();
+    OsalPortTimers_startReloadTimer( ZDAppTaskID, ZDO_NBR_MGR_EVT, NWK_NBR_MGR_PERIOD );
+  }
 } /* ZDApp_Init() */
 
 /*********************************************************************
@@ -506,6 +543,44 @@ uint32_t ZDApp_event_loop( uint8_t task_id, uint32_t events )
     return (events ^ ZDO_PENDING_BIND_REQ_EVT);
   }
 #endif
+
+  if ( events & ZDO_DEVICE_ANNCE_BATCH_EVT )
+  {
+    ZDO_ProcessDeviceAnnceBatch();
+
+    // Return unprocessed events
+    return (events ^ ZDO_DEVICE_ANNCE_BATCH_EVT);
+  }
+
+  if ( events & ZDO_LEAVE_BATCH_EVT )
+  {
+    ZDApp_ProcessLeaveBatch();
+
+    // Return unprocessed events
+    return (events ^ ZDO_LEAVE_BATCH_EVT);
+  }
+
+  if ( events & ZDO_NBR_MGR_EVT )
+  {
+    if ( ZSTACK_ROUTER_BUILD &&
+         ( (devState == DEV_ROUTER) || (devState == DEV_ZB_COORD) ) )
+    {
+      NwkNbrMgr_Process();
+    }
+
+    // Return unprocessed events
+    return (events ^ ZDO_NBR_MGR_EVT);
+  }
+
+#if defined ( FEATURE_EVENT_LOG )
+  if ( events & ZDO_EVENT_LOG_FLUSH_EVT )
+  {
+    ZEvtLogFlush();
+
+    // Return unprocessed events
+    return (events ^ ZDO_EVENT_LOG_FLUSH_EVT);
+  }
+#endif
   return ( ZDApp_ProcessSecEvent( task_id, events ) );
 }
 
@@ -2093,6 +2168,28 @@ void ZDApp_LeaveReset( uint8_t ra )
  */
 void ZDApp_LeaveUpdate( uint16_t nwkAddr, uint8_t* extAddr,
                         uint8_t removeChildren, uint8_t rejoin )
+{
+  ZDApp_LeaveCleanup( nwkAddr, extAddr, removeChildren, rejoin );
+
+  // Schedule to save data to NV
+  ZDApp_NwkWriteNVRequest();
+}
+
+/*********************************************************************
+ * @fn      ZDApp_LeaveCleanup
+ *
+ * @brief   Remove the data of a leaving device from the tables, without
+ *          scheduling the NV update.
+ *
+ * @param   nwkAddr        - NWK address of leaving device
+ * @param   extAddr        - EXT address of leaving device
+ * @param   removeChildren - remove children of leaving device
+ * @param   rejoin         - if device will rejoin or not
+ *
+ * @return  none
+ */
+static void ZDApp_LeaveCleanup( uint16_t nwkAddr, uint8_t* extAddr,
+                                uint8_t removeChildren, uint8_t rejoin )
 {
   uint8_t TC_ExtAddr[Z_EXTADDR_LEN];
   // Remove Apps Key for leaving device
@@ -2163,11 +2260,180 @@ void ZDApp_LeaveUpdate( uint16_t nwkAddr, uint8_t* extAddr,
   // Remove Routing table related entry
   RTG_RemoveRtgEntry( nwkAddr, 0 );
 
+#if defined ( RTG_SRC_TREE )
+  // Forget the kept source route to it
+  RTG_SrcTreeRemove( nwkAddr );
+#endif
+
   // Remove entry from neighborTable
   nwkNeighborRemove( nwkAddr, _NIB.nwkPanId );
+}
+
+/*********************************************************************
+ * @fn      ZDApp_LeaveBatchAdd
+ *
+ * @brief   Hold the NV update and the indication of a leave of another
+ *          device, whose data the caller already removed, until
+ *          ZDApp_ProcessLeaveBatch.  That runs ZDAPP_LEAVE_BATCH_DELAY
+ *          after the first held leave, when the batch is full or when a
+ *          held device joins or announces again.
+ *
+ * @param   nwkAddr        - NWK address of leaving device
+ * @param   extAddr        - EXT address of leaving device
+ * @param   reason         - ZDO_LEAVE_REASON_*
+ * @param   request        - leave request flag of the indication
+ * @param   removeChildren - remove children of leaving device
+ * @param   rejoin         - if device will rejoin or not
+ *
+ * @return  none
+ */
+static void ZDApp_LeaveBatchAdd( uint16_t nwkAddr, uint8_t* extAddr, uint8_t reason,
+                                 uint8_t request, uint8_t removeChildren, uint8_t rejoin )
+{
+  zdoLeaveRec_t *pRec;
+  uint8_t i;
+
+  // A device leaving again before the batch runs only keeps its latest leave
+  for ( i = 0; i < ZDApp_LeaveBatchCnt; i++ )
+  {
+    if ( osal_ExtAddrEqual( ZDApp_LeaveBatch[i].extAddr, extAddr ) )
+    {
+      break;
+    }
+  }
+
+  if ( i == ZDApp_LeaveBatchCnt )
+  {
+    if ( ZDApp_LeaveBatchCnt >= ZDAPP_LEAVE_BATCH_MAX )
+    {
+      OsalPortTimers_stopTimer( ZDAppTaskID, ZDO_LEAVE_BATCH_EVT );
+      ZDApp_ProcessLeaveBatch();
+    }
+
+    i = ZDApp_LeaveBatchCnt++;
+    osal_cpyExtAddr( ZDApp_LeaveBatch[i].extAddr, extAddr );
+
+    if ( ZDApp_LeaveBatchCnt == 1 )
+    {
+      OsalPortTimers_startTimer( ZDAppTaskID, ZDO_LEAVE_BATCH_EVT, ZDAPP_LEAVE_BATCH_DELAY );
+    }
+  }
+
+  pRec = &ZDApp_LeaveBatch[i];
+  pRec->nwkAddr = nwkAddr;
+  pRec->reason = reason;
+  pRec->request = request;
+  pRec->removeChildren = removeChildren;
+  pRec->rejoin = rejoin;
+}
+
+/*********************************************************************
+ * @fn      ZDApp_LeaveBatchFlush
+ *
+ * @brief   Process the leave batch now when it holds a leave of the
+ *          device, so the host sees the leave before it joins or
+ *          announces again.
+ *
+ * @param   extAddr - EXT address of the joining or announcing device
+ *
+ * @return  none
+ */
+void ZDApp_LeaveBatchFlush( uint8_t* extAddr )
+{
+  uint8_t i;
+
+  for ( i = 0; i < ZDApp_LeaveBatchCnt; i++ )
+  {
+    if ( osal_ExtAddrEqual( ZDApp_LeaveBatch[i].extAddr, extAddr ) )
+    {
+      OsalPortTimers_stopTimer( ZDAppTaskID, ZDO_LEAVE_BATCH_EVT );
+      ZDApp_ProcessLeaveBatch();
+      return;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      ZDApp_ChildAgedCB
+ *
+ * @brief   A child the NWK layer aged out and removed from the
+ *          association and neighbor tables.  Its NV update and
+ *          indication go with the leaves held in the batch, nothing
+ *          else is removed as it is expected to rejoin.
+ *
+ * @param   nwkAddr - NWK address of the child
+ * @param   extAddr - EXT address of the child, NULL if not known
+ *
+ * @return  none
+ */
+static void ZDApp_ChildAgedCB( uint16_t nwkAddr, uint8_t *extAddr )
+{
+  // It's told to leave and is expected to rejoin when it polls again,
+  // so its keys, bindings and the Trust Center are left alone
+  if ( extAddr != NULL )
+  {
+    ZDApp_LeaveBatchAdd( nwkAddr, extAddr, ZDO_LEAVE_REASON_AGED, FALSE, FALSE, TRUE );
+  }
+  else
+  {
+    ZDApp_NwkWriteNVRequest();
+  }
+}
+
+/*********************************************************************
+ * @fn      ZDApp_ProcessLeaveBatch
+ *
+ * @brief   Schedule one NV update for the held leaving devices and
+ *          indicate them together through ZDO_LEAVE_BATCH_IND_CBID.
+ *          Without that callback the NLME leave indications go one by
+ *          one through ZDO_LEAVE_IND_CBID.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void ZDApp_ProcessLeaveBatch( void )
+{
+  zdoLeaveRec_t *pRec;
+  uint8_t i;
+
+  if ( ZDApp_LeaveBatchCnt == 0 )
+  {
+    return;
+  }
 
   // Schedule to save data to NV
   ZDApp_NwkWriteNVRequest();
+
+  if ( zdoCBFunc[ZDO_LEAVE_BATCH_IND_CBID] != NULL )
+  {
+    zdoLeaveBatch_t batch;
+
+    batch.count = ZDApp_LeaveBatchCnt;
+    batch.pRecs = ZDApp_LeaveBatch;
+    (void)zdoCBFunc[ZDO_LEAVE_BATCH_IND_CBID]( &batch );
+  }
+  else if ( zdoCBFunc[ZDO_LEAVE_IND_CBID] != NULL )
+  {
+    NLME_LeaveInd_t ind;
+
+    for ( i = 0; i < ZDApp_LeaveBatchCnt; i++ )
+    {
+      pRec = &ZDApp_LeaveBatch[i];
+      // Aged out children were never NLME leave indications
+      if ( pRec->reason == ZDO_LEAVE_REASON_IND )
+      {
+        ind.srcAddr = pRec->nwkAddr;
+        osal_cpyExtAddr( ind.extAddr, pRec->extAddr );
+        ind.request = pRec->request;
+        ind.removeChildren = pRec->removeChildren;
+        ind.rejoin = pRec->rejoin;
+        (void)zdoCBFunc[ZDO_LEAVE_IND_CBID]( &ind );
+      }
+    }
+  }
+
+  ZDApp_LeaveBatchCnt = 0;
 }
 
 /*********************************************************************
@@ -2760,6 +3026,8 @@ void ZDO_AddrChangeIndicationCB( uint16_t newAddr )
   ZDO_AddrChangeInd_t *pZDOAddrChangeMsg;
   epList_t *pItem = epList;
 
+  ZEvtLogAdd( ZEVTLOG_TYPE_ADDR_CHANGE, 0, 0, newAddr, NLME_GetExtAddr() );
+
   // Notify to save info into NV
   ZDApp_NVUpdate();
 
@@ -2804,13 +3072,20 @@ void ZDO_AddrChangeIndicationCB( uint16_t newAddr )
 ZStatus_t ZDO_JoinIndicationCB(uint16_t ShortAddress, uint8_t *ExtendedAddress,
                                 uint8_t CapabilityFlags, uint8_t type)
 {
-  (void)ExtendedAddress;
   //check if the device is leaving before responding to rejoin request
   if( OsalPortTimers_getTimerTimeout( ZDAppTaskID , ZDO_DEVICE_RESET) )
   {
     return ZFailure; // device leaving , hence do not allow rejoin
   }
 
+  ZEvtLogAdd( ZEVTLOG_TYPE_JOIN, type, CapabilityFlags, ShortAddress, ExtendedAddress );
+
+  // Start aging a new end device child from now
+  NwkChildAge_Sync( ShortAddress );
+
+  // Its held leave is indicated before the join
+  ZDApp_LeaveBatchFlush( ExtendedAddress );
+
 #if ZDO_NV_SAVE_RFDs
     (void)CapabilityFlags;
 
@@ -2927,11 +3202,16 @@ void ZDO_LeaveCnf( NLME_LeaveCnf_t* cnf )
   }
   else if ( ZSTACK_ROUTER_BUILD )
   {
-    // Remove device address(optionally descendents) from data
-    ZDApp_LeaveUpdate( cnf->dstAddr,
-                       cnf->extAddr,
-                       cnf->removeChildren,
-                       cnf->rejoin );
+    // Remove device address(optionally descendents) from data, the NV
+    // update is done together with the other leaves of the batch
+    ZDApp_LeaveCleanup( cnf->dstAddr, cnf->extAddr,
+                        cnf->removeChildren, cnf->rejoin );
+    ZDApp_LeaveBatchAdd( cnf->dstAddr,
+                         cnf->extAddr,
+                         ZDO_LEAVE_REASON_CNF,
+                         TRUE,
+                         cnf->removeChildren,
+                         cnf->rejoin );
   }
 }
 
@@ -2950,6 +3230,12 @@ void ZDO_LeaveInd( NLME_LeaveInd_t* ind )
 {
   uint8_t leave;
 
+  ZEvtLogAdd( ZEVTLOG_TYPE_LEAVE,
+              (ind->request ? ZEVTLOG_LEAVE_REQUEST : 0)
+              | (ind->removeChildren ? ZEVTLOG_LEAVE_REMOVE_CHILDREN : 0)
+              | (ind->rejoin ? ZEVTLOG_LEAVE_REJOIN : 0),
+              0, ind->srcAddr, ind->extAddr );
+
   // NWK layer filters out illegal requests
   if ( ind->request == TRUE )
   {
@@ -3014,11 +3300,17 @@ void ZDO_LeaveInd( NLME_LeaveInd_t* ind )
     }
     else
     {
-      // Remove device address(optionally descendents) from data
-      ZDApp_LeaveUpdate( ind->srcAddr,
-                         ind->extAddr,
-                         ind->removeChildren,
-                         ind->rejoin );
+      // Remove device address(optionally descendents) from data, the NV
+      // update and the indication go with the other leaves of the batch
+      ZDApp_LeaveCleanup( ind->srcAddr, ind->extAddr,
+                          ind->removeChildren, ind->rejoin );
+      ZDApp_LeaveBatchAdd( ind->srcAddr,
+                           ind->extAddr,
+                           ZDO_LEAVE_REASON_IND,
+                           ind->request,
+                           ind->removeChildren,
+                           ind->rejoin );
+      return;
     }
   }
 
@@ -3122,7 +3414,10 @@ void ZDO_PollConfirmCB( uint8_t status )
  */
 void ZDO_NetworkStatusCB( uint16_t nwkDstAddr, uint8_t statusCode, uint16_t dstAddr )
 {
-  (void)dstAddr;     // Remove this line if this parameter is used.
+  if ( nwkDstAddr == NLME_GetShortAddr() )
+  {
+    ZEvtLogAdd( ZEVTLOG_TYPE_NWK_STATUS, statusCode, 0, dstAddr, NULL );
+  }
 
   if ( (nwkDstAddr == NLME_GetShortAddr())
       && (statusCode == NWKSTAT_NONTREE_LINK_FAILURE) )
@@ -3130,6 +3425,19 @@ void ZDO_NetworkStatusCB( uint16_t nwkDstAddr, uint8_t statusCode, uint16_t dstA
     // Routing error for dstAddr, this is informational and a Route
     // Request should happen automatically.
   }
+#if defined ( RTG_SRC_TREE )
+  if ( (nwkDstAddr == NLME_GetShortAddr()) &&
+       ( (statusCode == NWKSTAT_NO_ROUTE_AVAIL) ||
+         (statusCode == NWKSTAT_TREE_LINK_FAILURE) ||
+         (statusCode == NWKSTAT_NONTREE_LINK_FAILURE) ||
+         (statusCode == NWKSTAT_SOURCE_ROUTE_FAILURE) ||
+         (statusCode == NWKSTAT_TARGET_DEVICE_UNAVAIL) ) )
+  {
+    // The kept source route to dstAddr failed, don't put it back again
+    RTG_SrcTreeRemove( dstAddr );
+  }
+#endif
+
   if ((nwkDstAddr == NLME_GetShortAddr())&& (statusCode == NWKSTAT_SOURCE_ROUTE_FAILURE))
    {
       // Received a source route failure, remove route and rediscover.
@@ -3426,6 +3734,11 @@ void ZDO_SrcRtgIndCB (uint16_t srcAddr, uint8_t relayCnt, uint16_t* pRelayList )
   srcRtg.relayCnt = relayCnt;
   srcRtg.pRelayList = pRelayList;
 
+#if defined ( RTG_SRC_TREE )
+  // Keep the route beyond the source route table
+  (void)RTG_SrcTreeAdd( srcAddr, relayCnt, pRelayList );
+#endif
+
   if( zdoCBFunc[ZDO_SRC_RTG_IND_CBID] != NULL )
   {
     zdoCBFunc[ZDO_SRC_RTG_IND_CBID]( (void*)&srcRtg );
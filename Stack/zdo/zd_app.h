@@ -84,7 +84,13 @@ extern "C"
 #if defined ( ZDP_BIND_VALIDATION )
 #define ZDO_PENDING_BIND_REQ_EVT      0x1000
 #endif
+#if defined ( FEATURE_EVENT_LOG )
+#define ZDO_EVENT_LOG_FLUSH_EVT   0x2000
+#endif
 #define ZDO_PARENT_ANNCE_EVT      0x4000
+#define ZDO_DEVICE_ANNCE_BATCH_EVT  0x00010000
+#define ZDO_LEAVE_BATCH_EVT         0x00020000
+#define ZDO_NBR_MGR_EVT             0x00040000
 
 // Incoming to ZDO
 #define ZDO_NWK_DISC_CNF        0x01
@@ -314,6 +320,8 @@ enum
   ZDO_LEAVE_IND_CBID,
   ZDO_PERMIT_JOIN_CBID,
   ZDO_TC_DEVICE_CBID,
+  ZDO_LEAVE_BATCH_IND_CBID,
+  ZDO_CHAN_MIGRATE_CBID,
   MAX_ZDO_CB_FUNC               // Must be at the bottom of the list
 };
 
@@ -355,6 +363,28 @@ typedef struct
   uint16_t parentAddr;
 } zdoJoinCnf_t;
 
+/* Source of a leave in zdoLeaveBatch_t */
+#define ZDO_LEAVE_REASON_IND    0x00  // The device left, NLME leave indication
+#define ZDO_LEAVE_REASON_CNF    0x01  // This device had it leave, NLME leave confirm
+#define ZDO_LEAVE_REASON_AGED   0x02  // The child aged out
+
+typedef struct
+{
+  uint16_t nwkAddr;
+  uint8_t  extAddr[Z_EXTADDR_LEN];
+  uint8_t  reason;          // ZDO_LEAVE_REASON_*
+  uint8_t  request;
+  uint8_t  removeChildren;
+  uint8_t  rejoin;
+} zdoLeaveRec_t;
+
+/* ZDO_LEAVE_BATCH_IND_CBID parameter */
+typedef struct
+{
+  uint8_t count;
+  zdoLeaveRec_t *pRecs;
+} zdoLeaveBatch_t;
+
 typedef struct
 {
   uint8_t       srcAddress[Z_EXTADDR_LEN];
@@ -689,6 +719,18 @@ extern void ZDApp_LeaveReset( uint8_t ra );
  */
 extern void ZDApp_LeaveCtrlReset( void );
 
+/*
+ * ZDApp_ProcessLeaveBatch
+ *    - Save and indicate the held leaves of other devices
+ */
+extern void ZDApp_ProcessLeaveBatch( void );
+
+/*
+ * ZDApp_LeaveBatchFlush
+ *    - Save and indicate the held leaves if one is of the given device
+ */
+extern void ZDApp_LeaveBatchFlush( uint8_t* extAddr );
+
 /*
  * ZDApp_DeviceConfigured
  *    - Check to see if the local device is configured
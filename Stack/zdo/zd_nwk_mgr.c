@@ -51,6 +51,8 @@ extern "C"
 #include "zd_object.h"
 #include "zglobals.h"
 #include "zd_nwk_mgr.h"
+#include "nwk_childage.h"
+#include "nwk_bufs.h"
 
 #if defined( MT_ZDO_FUNC )
   #include "mt_zdo.h"
@@ -75,10 +77,30 @@ extern "C"
   const char NwkMgrStr_4[]     = "NM-energy not up";
 #endif
 
+// Channel migration device flags
+#define ZDNWKMGR_MIGRATE_HEARD    0x01  // Seen on the new channel
+#define ZDNWKMGR_MIGRATE_GONE     0x02  // Left the tables during the migration
+
 /******************************************************************************
  * TYPEDEFS
  */
 
+// Child or neighbor router followed by the channel migration
+typedef struct
+{
+  uint16_t shortAddr;
+  uint16_t devIdx;      // Index in AssociatedDevList
+  uint32_t frmCntr;     // Last NWK security frame counter seen
+  uint32_t timeout;     // Last child timer seen, see ZDNwkMgr_MigrateTimer()
+  uint8_t  flags;       // ZDNWKMGR_MIGRATE_HEARD, ZDNWKMGR_MIGRATE_GONE
+  uint8_t  tries;       // Old channel windows it was sent the update in
+} ZDNwkMgr_MigrateDev_t;
+
+/******************************************************************************
+ * EXTERNAL VARIABLES
+ */
+extern pfnZdoCb zdoCBFunc[MAX_ZDO_CB_FUNC];
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -110,11 +132,33 @@ uint16_t ZDNwkMgr_LastChannelFailureRate = 0;
 
 uint8_t ZDNwkMgr_NewChannel;
 
+// Formation channel evaluation variables
+static ZDNwkMgr_ChanEvalCfg_t ZDNwkMgr_ChanEvalCfg =
+{
+  ZDNWKMGR_CHAN_EVAL_PASSES,
+  ZDNWKMGR_CHAN_EVAL_SCAN_DURATION,
+  ZDNWKMGR_CHAN_EVAL_INTERVAL,
+  0
+};
+static uint32_t ZDNwkMgr_ChanEvalMask = 0;  // Channels under evaluation, 0 when idle
+static pZDNwkMgr_ChanEvalCB_t ZDNwkMgr_ChanEvalDoneCB = NULL;
+static uint8_t  ZDNwkMgr_ChanEvalPassCnt = 0;
+static uint16_t ZDNwkMgr_ChanEvalSum[ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS];
+static uint8_t  ZDNwkMgr_ChanEvalPeak[ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS];
+static uint16_t ZDNwkMgr_ChanEvalScanned;  // Bit per channel scanned in at least one pass
+
 // PAN ID Conflict variables
 #if defined ( NWK_MANAGER )
 uint8_t ZDNwkMgr_PanIdUpdateInProgress = FALSE;
 #endif // NWK_MANAGER
 
+// Channel migration variables
+static ZDNwkMgr_MigrateDev_t ZDNwkMgr_MigrateDev[NWK_MAX_DEVICES];
+static ZDNwkMgr_MigrateReport_t ZDNwkMgr_Migrate = { ZDNWKMGR_MIGRATE_IDLE };
+static uint16_t ZDNwkMgr_MigrateCursor;  // Round robin start of the next window
+static uint16_t ZDNwkMgr_MigrateWait;    // ms spent in the current old channel window
+static uint8_t ZDNwkMgr_MigrateEnabled = ZDNWKMGR_MIGRATE_ENABLE;
+
 /*********************************************************************
  * GLOBAL FUNCTIONS
  */
@@ -141,6 +185,14 @@ static void ZDNwkMgr_ProcessMgmtNwkUpdateReq( zdoIncomingMsg_t *inMsg );
 static void ZDNwkMgr_ProcessChannelInterference( ZDNwkMgr_ChanInterference_t *pChanInterference );
 static void ZDNwkMgr_ProcessEDScanConfirm( ZDNwkMgr_EDScanConfirm_t *pEDScanConfirm );
 static void ZDNwkMgr_CheckForChannelInterference( ZDNwkMgr_EDScanConfirm_t *pEDScanConfirm );
+static void ZDNwkMgr_ChanEvalProcessScan( ZDNwkMgr_EDScanConfirm_t *pEDScanConfirm );
+static void ZDNwkMgr_ChanEvalDone( void );
+static uint8_t ZDNwkMgr_ChanEvalWifiPenalty( uint8_t channel );
+static void ZDNwkMgr_MigrateCheck( void );
+static uint32_t ZDNwkMgr_MigrateTimer( uint16_t devIdx );
+static uint8_t ZDNwkMgr_MigrateMacBusy( void );
+static void ZDNwkMgr_MigrateProcess( void );
+static void ZDNwkMgr_MigrateReport( void );
 static void ZDNwkMgr_BuildAndSendUpdateNotify( uint8_t TransSeq, zAddrType_t *dstAddr,
                                                uint16_t totalTransmissions, uint16_t txFailures,
                                                ZDNwkMgr_EDScanConfirm_t *pEDScanConfirm, uint8_t txOptions );
@@ -270,6 +322,16 @@ uint32_t ZDNwkMgr_event_loop( byte task_id, uint32_t events )
 
   if ( events & ZDNWKMGR_CHANNEL_CHANGE_EVT )
   {
+    // The network manager or the coordinator, which start the channel
+    // change, make sure the children and neighbor routers follow onto
+    // the new channel
+    if ( ZSTACK_ROUTER_BUILD &&
+         ( ZG_DEVICE_COORDINATOR_TYPE ||
+           (_NIB.nwkManagerAddr == NLME_GetShortAddr()) ) )
+    {
+      ZDNwkMgr_MigrateStart( _NIB.nwkLogicalChannel );
+    }
+
     // Switch channel
     _NIB.nwkLogicalChannel = ZDNwkMgr_NewChannel;
     ZMacSetReq( ZMacChannel, &ZDNwkMgr_NewChannel );
@@ -328,6 +390,28 @@ uint32_t ZDNwkMgr_event_loop( byte task_id, uint32_t events )
     return ( events ^ ZDNWKMGR_SCAN_REQUEST_EVT );
   }
 
+  if ( events & ZDNWKMGR_CHAN_EVAL_EVT )
+  {
+    if ( ZDNwkMgr_ChanEvalMask != 0 )
+    {
+      if ( NLME_EDScanRequest( ZDNwkMgr_ChanEvalMask,
+                               ZDNwkMgr_ChanEvalCfg.scanDuration ) != ZSuccess )
+      {
+        // Pick from the passes done so far
+        ZDNwkMgr_ChanEvalDone();
+      }
+    }
+
+    return ( events ^ ZDNWKMGR_CHAN_EVAL_EVT );
+  }
+
+  if ( events & ZDNWKMGR_MIGRATE_EVT )
+  {
+    ZDNwkMgr_MigrateProcess();
+
+    return ( events ^ ZDNWKMGR_MIGRATE_EVT );
+  }
+
   // Discard or make more handlers
   return 0;
 }
@@ -685,7 +769,12 @@ static void ZDNwkMgr_ProcessChannelInterference( ZDNwkMgr_ChanInterference_t *pC
  */
 static void ZDNwkMgr_ProcessEDScanConfirm( ZDNwkMgr_EDScanConfirm_t *pEDScanConfirm )
 {
-  if ( ZDNwkMgr_MgmtNwkUpdateReq.scanCount == 0xFF )
+  if ( ZDNwkMgr_ChanEvalMask != 0 )
+  {
+    // Confirm to a formation channel evaluation pass
+    ZDNwkMgr_ChanEvalProcessScan( pEDScanConfirm );
+  }
+  else if ( ZDNwkMgr_MgmtNwkUpdateReq.scanCount == 0xFF )
   {
     // Confirm to scan all channels for channel interference check
     ZDNwkMgr_CheckForChannelInterference( pEDScanConfirm );
@@ -709,6 +798,604 @@ static void ZDNwkMgr_ProcessEDScanConfirm( ZDNwkMgr_EDScanConfirm_t *pEDScanConf
   }
 }
 
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalProcessScan
+ *
+ * @brief       This function adds an ED scan pass to the formation
+ *              channel evaluation and schedules the next pass, or
+ *              completes the evaluation. A failed scan completes it
+ *              with the passes done so far.
+ *
+ * @param       pEDScanConfirm - SD Scan Confirmation message
+ *
+ * @return      none
+ */
+static void ZDNwkMgr_ChanEvalProcessScan( ZDNwkMgr_EDScanConfirm_t *pEDScanConfirm )
+{
+  if ( pEDScanConfirm->status != ZSuccess )
+  {
+    // Pick from the passes done so far
+    ZDNwkMgr_ChanEvalDone();
+    return;
+  }
+
+  ZDNwkMgr_ChanEvalAddPass( pEDScanConfirm->scannedChannels,
+                            pEDScanConfirm->energyDetectList );
+
+  if ( ZDNwkMgr_ChanEvalPassCnt < ZDNwkMgr_ChanEvalCfg.passes )
+  {
+    OsalPortTimers_startTimer( ZDNwkMgr_TaskID, ZDNWKMGR_CHAN_EVAL_EVT,
+                               ZDNwkMgr_ChanEvalCfg.interval );
+  }
+  else
+  {
+    ZDNwkMgr_ChanEvalDone();
+  }
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalDone
+ *
+ * @brief       This function completes the formation channel evaluation
+ *              and gives the picked channel to the requester.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void ZDNwkMgr_ChanEvalDone( void )
+{
+  pZDNwkMgr_ChanEvalCB_t pDoneCB = ZDNwkMgr_ChanEvalDoneCB;
+  uint8_t channel = ZDNwkMgr_ChanEvalBest( ZDNwkMgr_ChanEvalMask );
+
+  ZDNwkMgr_ChanEvalMask = 0;
+  ZDNwkMgr_ChanEvalDoneCB = NULL;
+
+  if ( pDoneCB )
+  {
+    pDoneCB( channel );
+  }
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalConfig
+ *
+ * @brief       This function sets the formation channel evaluation
+ *              configuration, used from the next evaluation.
+ *
+ * @param       pCfg - new configuration
+ *
+ * @return      none
+ */
+void ZDNwkMgr_ChanEvalConfig( ZDNwkMgr_ChanEvalCfg_t *pCfg )
+{
+  ZDNwkMgr_ChanEvalCfg = *pCfg;
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalGetConfig
+ *
+ * @brief       This function gets the formation channel evaluation
+ *              configuration.
+ *
+ * @param       pCfg - configuration copy
+ *
+ * @return      none
+ */
+void ZDNwkMgr_ChanEvalGetConfig( ZDNwkMgr_ChanEvalCfg_t *pCfg )
+{
+  *pCfg = ZDNwkMgr_ChanEvalCfg;
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalStart
+ *
+ * @brief       This function starts evaluating the channels of a mask
+ *              for network formation.  Energy is sampled by several ED
+ *              scan passes, pDoneCB gets the channel with the lowest
+ *              score when they are done.
+ *
+ * @param       channelMask - channels to evaluate
+ * @param       pDoneCB - called with the picked channel
+ *
+ * @return      TRUE if started, FALSE if the evaluation is disabled,
+ *              busy or the scan can't be started
+ */
+uint8_t ZDNwkMgr_ChanEvalStart( uint32_t channelMask, pZDNwkMgr_ChanEvalCB_t pDoneCB )
+{
+  if ( (ZDNwkMgr_ChanEvalCfg.passes == 0) || (ZDNwkMgr_ChanEvalMask != 0) ||
+       (channelMask == 0) )
+  {
+    return ( FALSE );
+  }
+
+  // Start a new evaluation
+  ZDNwkMgr_ChanEvalPassCnt = 0;
+  ZDNwkMgr_ChanEvalScanned = 0;
+  memset( ZDNwkMgr_ChanEvalSum, 0, sizeof( ZDNwkMgr_ChanEvalSum ) );
+  memset( ZDNwkMgr_ChanEvalPeak, 0, sizeof( ZDNwkMgr_ChanEvalPeak ) );
+
+  if ( NLME_EDScanRequest( channelMask, ZDNwkMgr_ChanEvalCfg.scanDuration ) != ZSuccess )
+  {
+    return ( FALSE );
+  }
+
+  ZDNwkMgr_ChanEvalMask = channelMask;
+  ZDNwkMgr_ChanEvalDoneCB = pDoneCB;
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalAddPass
+ *
+ * @brief       This function adds the result of an ED scan pass to the
+ *              formation channel evaluation.
+ *
+ * @param       scannedChannels - channels of the pass
+ * @param       energyDetectList - energy per channel number
+ *
+ * @return      none
+ */
+void ZDNwkMgr_ChanEvalAddPass( uint32_t scannedChannels, uint8_t *energyDetectList )
+{
+  uint8_t i;
+  uint8_t energy;
+
+  for ( i = 0; i < ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS; i++ )
+  {
+    if ( scannedChannels & ( (uint32_t)1 << (i + ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL) ) )
+    {
+      energy = energyDetectList[i + ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL];
+
+      ZDNwkMgr_ChanEvalSum[i] += energy;
+      if ( energy > ZDNwkMgr_ChanEvalPeak[i] )
+      {
+        ZDNwkMgr_ChanEvalPeak[i] = energy;
+      }
+      ZDNwkMgr_ChanEvalScanned |= BV( i );
+    }
+  }
+
+  ZDNwkMgr_ChanEvalPassCnt++;
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalWifiPenalty
+ *
+ * @brief       This function gets the score penalty of a channel
+ *              overlapping the Wi-Fi channels hinted by the host.
+ *
+ * @param       channel - 802.15.4 channel (11-26)
+ *
+ * @return      penalty
+ */
+static uint8_t ZDNwkMgr_ChanEvalWifiPenalty( uint8_t channel )
+{
+  uint8_t wifi;
+  uint8_t penalty = 0;
+  int16_t offset;
+
+  for ( wifi = 1; wifi <= 13; wifi++ )
+  {
+    if ( ZDNwkMgr_ChanEvalCfg.wifiChannels & BV( wifi - 1 ) )
+    {
+      // Channel centers: 802.15.4 2405 + 5 * (channel - 11) MHz,
+      // Wi-Fi 2412 + 5 * (wifi - 1) MHz
+      offset = (int16_t)(5 * ((int16_t)channel - wifi)) - 57;
+      if ( offset < 0 )
+      {
+        offset = -offset;
+      }
+
+      if ( offset <= 9 )
+      {
+        penalty = ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY;
+      }
+      else if ( (offset <= 12) && (penalty < (ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY / 2)) )
+      {
+        penalty = ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY / 2;
+      }
+    }
+  }
+
+  return ( penalty );
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalGetScore
+ *
+ * @brief       This function gets the formation channel evaluation
+ *              result of a channel.
+ *
+ * @param       channel - 802.15.4 channel (11-26)
+ * @param       pScore - result of the channel
+ *
+ * @return      none
+ */
+void ZDNwkMgr_ChanEvalGetScore( uint8_t channel, ZDNwkMgr_ChanEvalScore_t *pScore )
+{
+  uint8_t i = channel - ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL;
+  uint16_t score;
+
+  pScore->mean = 0;
+  pScore->peak = 0;
+  pScore->score = 0xFF;
+
+  if ( (i >= ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS) || (ZDNwkMgr_ChanEvalPassCnt == 0) )
+  {
+    return;
+  }
+
+  pScore->mean = (uint8_t)(ZDNwkMgr_ChanEvalSum[i] / ZDNwkMgr_ChanEvalPassCnt);
+  pScore->peak = ZDNwkMgr_ChanEvalPeak[i];
+
+  score = ( (pScore->mean * ZDNWKMGR_CHAN_EVAL_MEAN_WEIGHT) +
+            (pScore->peak * ZDNWKMGR_CHAN_EVAL_PEAK_WEIGHT) ) /
+          ( ZDNWKMGR_CHAN_EVAL_MEAN_WEIGHT + ZDNWKMGR_CHAN_EVAL_PEAK_WEIGHT );
+  score += ZDNwkMgr_ChanEvalWifiPenalty( channel );
+
+  pScore->score = ( score > 0xFF ) ? 0xFF : (uint8_t)score;
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_ChanEvalBest
+ *
+ * @brief       This function picks the channel of a mask with the
+ *              lowest formation channel evaluation score, the lowest
+ *              channel on a tie.
+ *
+ * @param       channelMask - channels to pick from
+ *
+ * @return      channel, 0 if no channel of the mask was scanned
+ */
+uint8_t ZDNwkMgr_ChanEvalBest( uint32_t channelMask )
+{
+  ZDNwkMgr_ChanEvalScore_t result;
+  uint16_t bestScore = 0x100;
+  uint8_t best = 0;
+  uint8_t i;
+
+  for ( i = 0; i < ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS; i++ )
+  {
+    if ( ( channelMask & ( (uint32_t)1 << (i + ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL) ) ) &&
+         ( ZDNwkMgr_ChanEvalScanned & BV( i ) ) )
+    {
+      ZDNwkMgr_ChanEvalGetScore( i + ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL, &result );
+      if ( result.score < bestScore )
+      {
+        bestScore = result.score;
+        best = i + ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL;
+      }
+    }
+  }
+
+  return ( best );
+}
+
+/*********************************************************************
+ * Channel Migration Routines
+ */
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_MigrateStart
+ *
+ * @brief       Snapshot the children and neighbor routers before this
+ *              device leaves oldChannel.  They are tracked on the new
+ *              channel, a device counts as heard once its NWK security
+ *              frame counter moves or, for a child, once its timeout
+ *              counter is refreshed by a poll or keepalive.  Devices not
+ *              heard after ZDNWKMGR_MIGRATE_GRACE are sent the channel
+ *              change again by unicast in short windows on oldChannel.
+ *              Nothing is done unless enabled by ZDNwkMgr_MigrateEnable().
+ *
+ * @param       oldChannel - channel being left
+ *
+ * @return      none
+ */
+void ZDNwkMgr_MigrateStart( uint8_t oldChannel )
+{
+  associated_devices_t *pDev;
+  ZDNwkMgr_MigrateDev_t *pRec;
+  uint16_t x;
+
+  if ( !ZDNwkMgr_MigrateEnabled )
+  {
+    return;
+  }
+
+  // A migration still in an old channel window is dropped, the caller
+  // is about to set the MAC channel
+  OsalPortTimers_stopTimer( ZDNwkMgr_TaskID, ZDNWKMGR_MIGRATE_EVT );
+
+  memset( &ZDNwkMgr_Migrate, 0, sizeof( ZDNwkMgr_Migrate ) );
+  ZDNwkMgr_Migrate.state = ZDNWKMGR_MIGRATE_TRACKING;
+  ZDNwkMgr_Migrate.channel = ZDNwkMgr_NewChannel;
+  ZDNwkMgr_Migrate.oldChannel = oldChannel;
+  ZDNwkMgr_MigrateCursor = 0;
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    pDev = &AssociatedDevList[x];
+    if ( (pDev->nodeRelation >= CHILD_RFD) && (pDev->nodeRelation <= NEIGHBOR) &&
+         (pDev->shortAddr != INVALID_NODE_ADDR) )
+    {
+      pRec = &ZDNwkMgr_MigrateDev[ZDNwkMgr_Migrate.total++];
+      pRec->shortAddr = pDev->shortAddr;
+      pRec->devIdx = x;
+      pRec->frmCntr = pDev->linkInfo.inFrmCntr;
+      pRec->timeout = ZDNwkMgr_MigrateTimer( x );
+      pRec->flags = 0;
+      pRec->tries = 0;
+    }
+  }
+
+  ZDNwkMgr_Migrate.pending = ZDNwkMgr_Migrate.total;
+
+  OsalPortTimers_startTimer( ZDNwkMgr_TaskID, ZDNWKMGR_MIGRATE_EVT,
+                             ZDNWKMGR_BCAST_DELIVERY_TIME + ZDNWKMGR_MIGRATE_GRACE );
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_MigrateGetReport
+ *
+ * @brief       Get the progress of the last channel migration.
+ *
+ * @param       pReport - output
+ *
+ * @return      none
+ */
+void ZDNwkMgr_MigrateGetReport( ZDNwkMgr_MigrateReport_t *pReport )
+{
+  *pReport = ZDNwkMgr_Migrate;
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_MigrateEnable
+ *
+ * @brief       Turn the channel migration on or off.  Turned off, a
+ *              migration under way is stopped where it is and this
+ *              device goes back to the channel of the network.
+ *
+ * @param       enable - TRUE to follow the devices after a channel change
+ *
+ * @return      none
+ */
+void ZDNwkMgr_MigrateEnable( uint8_t enable )
+{
+  ZDNwkMgr_MigrateEnabled = enable;
+
+  if ( !enable && ( (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_TRACKING) ||
+                    (ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_OLD_CHANNEL) ) )
+  {
+    OsalPortTimers_stopTimer( ZDNwkMgr_TaskID, ZDNWKMGR_MIGRATE_EVT );
+
+    if ( ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_OLD_CHANNEL )
+    {
+      ZMacSetReq( ZMacChannel, &_NIB.nwkLogicalChannel );
+    }
+
+    ZDNwkMgr_Migrate.state = ZDNWKMGR_MIGRATE_DONE;
+    ZDNwkMgr_MigrateReport();
+  }
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_MigrateTimer
+ *
+ * @brief       Get the child timer that goes up when a child polls: its
+ *              aging deadline when the children are aged by deadline,
+ *              its timeout counter otherwise.
+ *
+ * @param       devIdx - association list entry
+ *
+ * @return      timer
+ */
+static uint32_t ZDNwkMgr_MigrateTimer( uint16_t devIdx )
+{
+  uint32_t deadline = NwkChildAge_Deadline( devIdx );
+
+  if ( deadline != 0 )
+  {
+    return ( deadline );
+  }
+
+  return ( AssociatedDevList[devIdx].timeoutCounter );
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_MigrateCheck
+ *
+ * @brief       Update which of the followed devices were heard on the
+ *              new channel and recount the migration.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void ZDNwkMgr_MigrateCheck( void )
+{
+  associated_devices_t *pDev;
+  ZDNwkMgr_MigrateDev_t *pRec;
+  uint16_t x;
+
+  ZDNwkMgr_Migrate.heard = 0;
+  ZDNwkMgr_Migrate.recovered = 0;
+  ZDNwkMgr_Migrate.pending = 0;
+
+  for ( x = 0; x < ZDNwkMgr_Migrate.total; x++ )
+  {
+    pRec = &ZDNwkMgr_MigrateDev[x];
+    pDev = &AssociatedDevList[pRec->devIdx];
+
+    if ( (pRec->flags & (ZDNWKMGR_MIGRATE_HEARD | ZDNWKMGR_MIGRATE_GONE)) == 0 )
+    {
+      if ( (pDev->shortAddr != pRec->shortAddr) || (pDev->nodeRelation < CHILD_RFD) ||
+           (pDev->nodeRelation > NEIGHBOR) )
+      {
+        // Left or aged out, nothing to follow anymore
+        pRec->flags |= ZDNWKMGR_MIGRATE_GONE;
+      }
+      else if ( (pDev->linkInfo.inFrmCntr != pRec->frmCntr) ||
+                ((pDev->nodeRelation != NEIGHBOR) &&
+                 (ZDNwkMgr_MigrateTimer( pRec->devIdx ) > pRec->timeout)) )
+      {
+        pRec->flags |= ZDNWKMGR_MIGRATE_HEARD;
+      }
+      else
+      {
+        // The timeout counter counts down between polls, follow it
+        pRec->timeout = ZDNwkMgr_MigrateTimer( pRec->devIdx );
+      }
+    }
+
+    if ( pRec->flags & ZDNWKMGR_MIGRATE_HEARD )
+    {
+      ZDNwkMgr_Migrate.heard++;
+      if ( pRec->tries > 0 )
+      {
+        ZDNwkMgr_Migrate.recovered++;
+      }
+    }
+    else if ( ((pRec->flags & ZDNWKMGR_MIGRATE_GONE) == 0) &&
+              (pRec->tries < ZDNWKMGR_MIGRATE_TRIES) )
+    {
+      ZDNwkMgr_Migrate.pending++;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_MigrateMacBusy
+ *
+ * @brief       Check for NWK data buffers on their way through the MAC,
+ *              which sends them on whatever channel it is set to.
+ *              Frames held for sleeping children wait for a poll and
+ *              are not counted.
+ *
+ * @param       none
+ *
+ * @return      TRUE if a frame is queued, scheduled or being sent
+ */
+static uint8_t ZDNwkMgr_MigrateMacBusy( void )
+{
+  return ( (nwkDB_CountTypes( NWK_DATABUF_WAITING ) != 0) ||
+           (nwkDB_CountTypes( NWK_DATABUF_SCHEDULED ) != 0) ||
+           (nwkDB_CountTypes( NWK_DATABUF_SENT ) != 0) ||
+           (nwkDB_CountTypes( NWK_DATABUF_CONFIRMED ) != 0) );
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_MigrateProcess
+ *
+ * @brief       Step the channel migration: come back from an old
+ *              channel window, or recount the devices and open the next
+ *              window for up to ZDNWKMGR_MIGRATE_BURST stragglers.
+ *
+ *              The MAC moves as a whole, so a window only opens with
+ *              the NWK data buffers drained and closes as soon as the
+ *              update unicasts are through the MAC, ZDNWKMGR_MIGRATE_WINDOW
+ *              at the most.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void ZDNwkMgr_MigrateProcess( void )
+{
+  ZDNwkMgr_MigrateDev_t *pRec;
+  zAddrType_t dstAddr;
+  uint16_t x;
+  uint8_t sent = 0;
+
+  if ( ZDNwkMgr_Migrate.state == ZDNWKMGR_MIGRATE_OLD_CHANNEL )
+  {
+    if ( ZDNwkMgr_MigrateMacBusy() && (ZDNwkMgr_MigrateWait < ZDNWKMGR_MIGRATE_WINDOW) )
+    {
+      ZDNwkMgr_MigrateWait += ZDNWKMGR_MIGRATE_POLL;
+      OsalPortTimers_startTimer( ZDNwkMgr_TaskID, ZDNWKMGR_MIGRATE_EVT, ZDNWKMGR_MIGRATE_POLL );
+      return;
+    }
+
+    // Back to the channel of the network
+    ZMacSetReq( ZMacChannel, &_NIB.nwkLogicalChannel );
+    ZDNwkMgr_Migrate.state = ZDNWKMGR_MIGRATE_TRACKING;
+
+    ZDNwkMgr_MigrateReport();
+
+    OsalPortTimers_startTimer( ZDNwkMgr_TaskID, ZDNWKMGR_MIGRATE_EVT, ZDNWKMGR_MIGRATE_INTERVAL );
+    return;
+  }
+
+  if ( ZDNwkMgr_Migrate.state != ZDNWKMGR_MIGRATE_TRACKING )
+  {
+    return;
+  }
+
+  ZDNwkMgr_MigrateCheck();
+
+  if ( ZDNwkMgr_Migrate.pending == 0 )
+  {
+    ZDNwkMgr_Migrate.state = ZDNWKMGR_MIGRATE_DONE;
+    ZDNwkMgr_MigrateReport();
+    return;
+  }
+
+  // Frames queued now are for the network, let them out on its channel
+  if ( ZDNwkMgr_MigrateMacBusy() )
+  {
+    OsalPortTimers_startTimer( ZDNwkMgr_TaskID, ZDNWKMGR_MIGRATE_EVT, ZDNWKMGR_MIGRATE_POLL );
+    return;
+  }
+
+  dstAddr.addrMode = Addr16Bit;
+
+  // Round robin over the stragglers so each gets its windows in turn
+  for ( x = 0; (x < ZDNwkMgr_Migrate.total) && (sent < ZDNWKMGR_MIGRATE_BURST); x++ )
+  {
+    pRec = &ZDNwkMgr_MigrateDev[(ZDNwkMgr_MigrateCursor + x) % ZDNwkMgr_Migrate.total];
+
+    if ( ((pRec->flags & (ZDNWKMGR_MIGRATE_HEARD | ZDNWKMGR_MIGRATE_GONE)) == 0) &&
+         (pRec->tries < ZDNWKMGR_MIGRATE_TRIES) )
+    {
+      if ( sent == 0 )
+      {
+        ZMacSetReq( ZMacChannel, &ZDNwkMgr_Migrate.oldChannel );
+      }
+
+      dstAddr.addr.shortAddr = pRec->shortAddr;
+      ZDP_MgmtNwkUpdateReq( &dstAddr, (uint32_t)1 << ZDNwkMgr_Migrate.channel,
+                            0xfe, 0, _NIB.nwkUpdateId, 0 );
+      pRec->tries++;
+      sent++;
+    }
+  }
+  ZDNwkMgr_MigrateCursor = (ZDNwkMgr_MigrateCursor + x) % ZDNwkMgr_Migrate.total;
+
+  ZDNwkMgr_Migrate.state = ZDNWKMGR_MIGRATE_OLD_CHANNEL;
+  ZDNwkMgr_MigrateWait = 0;
+  OsalPortTimers_startTimer( ZDNwkMgr_TaskID, ZDNWKMGR_MIGRATE_EVT, ZDNWKMGR_MIGRATE_POLL );
+}
+
+/*********************************************************************
+ * @fn          ZDNwkMgr_MigrateReport
+ *
+ * @brief       Pass the migration progress to the registered callback.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void ZDNwkMgr_MigrateReport( void )
+{
+  if ( zdoCBFunc[ZDO_CHAN_MIGRATE_CBID] != NULL )
+  {
+    ZDNwkMgr_MigrateReport_t report = ZDNwkMgr_Migrate;
+
+    (void)zdoCBFunc[ZDO_CHAN_MIGRATE_CBID]( &report );
+  }
+}
+
 /*********************************************************************
  * @fn          ZDNwkMgr_CheckForChannelInterference
  *
@@ -930,7 +1617,9 @@ void ZDNwkMgr_EDScanConfirmCB( NLME_EDScanConfirm_t *EDScanConfirm )
 /*********************************************************************
  * @fn      ZDNwkMgr_ProcessDataConfirm
  *
- * @brief   Process received Confirmation for Mgmt NWK Update Notify message
+ * @brief   Process received Confirmation for Mgmt NWK Update Notify message.
+ *          ZDApp also gets the confirms of the endpoints registered with
+ *          its task ID, like the UTC time server, so only ZDO's count.
  *
  * @param   none
  *
@@ -939,6 +1628,7 @@ void ZDNwkMgr_EDScanConfirmCB( NLME_EDScanConfirm_t *EDScanConfirm )
 void ZDNwkMgr_ProcessDataConfirm( afDataConfirm_t *afDataConfirm )
 {
   if (   ZDNwkMgr_WaitingForNotifyConfirm  &&
+       ( afDataConfirm->endpoint == ZDO_EP ) &&
        ( afDataConfirm->transID == 0 )     &&
        ( afDataConfirm->hdr.status == ZSuccess ) )
   {
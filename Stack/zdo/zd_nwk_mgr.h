@@ -90,9 +90,63 @@ extern "C"
 #define ZDNWKMGR_UPDATE_NOTIFY_EVT        0x0002
 #define ZDNWKMGR_UPDATE_REQUEST_EVT       0x0004
 #define ZDNWKMGR_SCAN_REQUEST_EVT         0x0008
+#define ZDNWKMGR_CHAN_EVAL_EVT            0x0010
+#define ZDNWKMGR_MIGRATE_EVT              0x0020
+
+// Formation channel evaluation, see ZDNwkMgr_ChanEvalStart()
+#if !defined ( ZDNWKMGR_CHAN_EVAL_PASSES )
+  #define ZDNWKMGR_CHAN_EVAL_PASSES       0     // ED scan passes, 0 forms on the mask as configured
+#endif
+#if !defined ( ZDNWKMGR_CHAN_EVAL_SCAN_DURATION )
+  #define ZDNWKMGR_CHAN_EVAL_SCAN_DURATION 2    // ED scan duration exponent of each pass
+#endif
+#if !defined ( ZDNWKMGR_CHAN_EVAL_INTERVAL )
+  #define ZDNWKMGR_CHAN_EVAL_INTERVAL     500   // ms between passes
+#endif
+#if !defined ( ZDNWKMGR_CHAN_EVAL_MEAN_WEIGHT )
+  #define ZDNWKMGR_CHAN_EVAL_MEAN_WEIGHT  3     // Weight of the mean energy in the score
+#endif
+#if !defined ( ZDNWKMGR_CHAN_EVAL_PEAK_WEIGHT )
+  #define ZDNWKMGR_CHAN_EVAL_PEAK_WEIGHT  1     // Weight of the peak energy in the score
+#endif
+#if !defined ( ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY )
+  #define ZDNWKMGR_CHAN_EVAL_WIFI_PENALTY 0x40  // Added inside a hinted Wi-Fi channel, half on its skirts
+#endif
+
+#define ZDNWKMGR_CHAN_EVAL_FIRST_CHANNEL  11
+#define ZDNWKMGR_CHAN_EVAL_NUM_CHANNELS   16
 
 #define ZDNWKMGR_BCAST_DELIVERY_TIME      ( _NIB.BroadcastDeliveryTime * 100 )
 
+// Channel migration, see ZDNwkMgr_MigrateStart()
+#if !defined ( ZDNWKMGR_MIGRATE_ENABLE )
+  #define ZDNWKMGR_MIGRATE_ENABLE         FALSE // Follow the devices after a channel change, see ZDNwkMgr_MigrateEnable()
+#endif
+#if !defined ( ZDNWKMGR_MIGRATE_GRACE )
+  #define ZDNWKMGR_MIGRATE_GRACE          20000 // ms on the new channel before looking for stragglers
+#endif
+#if !defined ( ZDNWKMGR_MIGRATE_INTERVAL )
+  #define ZDNWKMGR_MIGRATE_INTERVAL       5000  // ms on the new channel between old channel windows
+#endif
+#if !defined ( ZDNWKMGR_MIGRATE_WINDOW )
+  #define ZDNWKMGR_MIGRATE_WINDOW         100   // Most ms spent on the old channel per window
+#endif
+#if !defined ( ZDNWKMGR_MIGRATE_POLL )
+  #define ZDNWKMGR_MIGRATE_POLL           10    // ms between looks at the NWK data buffers around a window
+#endif
+#if !defined ( ZDNWKMGR_MIGRATE_BURST )
+  #define ZDNWKMGR_MIGRATE_BURST          4     // Stragglers sent the update per window
+#endif
+#if !defined ( ZDNWKMGR_MIGRATE_TRIES )
+  #define ZDNWKMGR_MIGRATE_TRIES          3     // Windows per straggler, 0 only tracks the migration
+#endif
+
+// Channel migration states
+#define ZDNWKMGR_MIGRATE_IDLE             0x00  // No migration since reset
+#define ZDNWKMGR_MIGRATE_TRACKING         0x01  // On the new channel, waiting for the devices
+#define ZDNWKMGR_MIGRATE_OLD_CHANNEL      0x02  // Window on the old channel for stragglers
+#define ZDNWKMGR_MIGRATE_DONE             0x03  // All devices heard or out of windows
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -160,6 +214,38 @@ typedef struct
   uint16_t newPanID;
 } ZDNwkMgr_NetworkUpdate_t;
 
+// Formation channel evaluation configuration
+typedef struct
+{
+  uint8_t  passes;        // ED scan passes, 0 disables the evaluation
+  uint8_t  scanDuration;  // ED scan duration exponent of each pass
+  uint16_t interval;      // ms between passes
+  uint16_t wifiChannels;  // Bit (n - 1) set for Wi-Fi channel n (1-13) in use nearby
+} ZDNwkMgr_ChanEvalCfg_t;
+
+// Formation channel evaluation result of one channel
+typedef struct
+{
+  uint8_t mean;   // Mean energy over the passes
+  uint8_t peak;   // Peak energy over the passes
+  uint8_t score;  // Weighted energy plus Wi-Fi penalty, lower is better
+} ZDNwkMgr_ChanEvalScore_t;
+
+// Called with the channel picked by the evaluation, 0 if none could be picked
+typedef void (*pZDNwkMgr_ChanEvalCB_t)( uint8_t channel );
+
+// Channel migration progress, ZDO_CHAN_MIGRATE_CBID parameter
+typedef struct
+{
+  uint8_t  state;       // ZDNWKMGR_MIGRATE_*
+  uint8_t  channel;     // New channel
+  uint8_t  oldChannel;
+  uint16_t total;       // Children and neighbor routers when switching
+  uint16_t heard;       // Heard on the new channel
+  uint16_t recovered;   // Of heard, after being sent the update on the old channel
+  uint16_t pending;     // Not heard yet, with windows left
+} ZDNwkMgr_MigrateReport_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -201,6 +287,56 @@ extern void (*pZDNwkMgr_NetworkUpdateCB)( ZDNwkMgr_NetworkUpdate_t *pUpdate );
 extern void NwkMgr_SetNwkManager( void );
 #endif
 
+// Formation channel evaluation functions
+/*
+ * Set the formation channel evaluation configuration
+ */
+extern void ZDNwkMgr_ChanEvalConfig( ZDNwkMgr_ChanEvalCfg_t *pCfg );
+
+/*
+ * Get the formation channel evaluation configuration
+ */
+extern void ZDNwkMgr_ChanEvalGetConfig( ZDNwkMgr_ChanEvalCfg_t *pCfg );
+
+/*
+ * Evaluate the channels of a mask with ED scan passes, the result is given to pDoneCB
+ *  - returns TRUE if started, FALSE if disabled or the scan can't be started
+ */
+extern uint8_t ZDNwkMgr_ChanEvalStart( uint32_t channelMask, pZDNwkMgr_ChanEvalCB_t pDoneCB );
+
+/*
+ * Add the result of an ED scan pass to the evaluation
+ */
+extern void ZDNwkMgr_ChanEvalAddPass( uint32_t scannedChannels, uint8_t *energyDetectList );
+
+/*
+ * Get the evaluation result of a channel
+ */
+extern void ZDNwkMgr_ChanEvalGetScore( uint8_t channel, ZDNwkMgr_ChanEvalScore_t *pScore );
+
+/*
+ * Pick the channel with the lowest score in a mask
+ *  - returns the channel, 0 if no channel of the mask was scanned
+ */
+extern uint8_t ZDNwkMgr_ChanEvalBest( uint32_t channelMask );
+
+// Channel migration functions
+/*
+ * Snapshot the children and neighbor routers before leaving a channel
+ * and follow them onto the new one, when the migration is enabled
+ */
+extern void ZDNwkMgr_MigrateStart( uint8_t oldChannel );
+
+/*
+ * Get the progress of the last channel migration
+ */
+extern void ZDNwkMgr_MigrateGetReport( ZDNwkMgr_MigrateReport_t *pReport );
+
+/*
+ * Turn the channel migration on or off, off stops a migration under way
+ */
+extern void ZDNwkMgr_MigrateEnable( uint8_t enable );
+
 /******************************************************************************
 ******************************************************************************/
 
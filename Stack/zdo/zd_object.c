@@ -80,6 +80,32 @@
 // NLME Stub Implementations
 #define ZDO_ProcessMgmtPermitJoinTimeout NLME_PermitJoiningTimeout
 
+// Device announces held for the batch of notifications
+#if !defined ( ZDO_ANNCE_BATCH_MAX )
+  #define ZDO_ANNCE_BATCH_MAX       16
+#endif
+
+// Delay in ms from the first held announce to the notifications
+#if !defined ( ZDO_ANNCE_BATCH_DELAY )
+  #define ZDO_ANNCE_BATCH_DELAY     50
+#endif
+
+// Time in ms an applied announce suppresses identical repeats
+#if !defined ( ZDO_ANNCE_DEDUP_WINDOW )
+  #define ZDO_ANNCE_DEDUP_WINDOW    2000
+#endif
+
+// Devices whose last applied announce is remembered for the dedup window
+#if !defined ( ZDO_ANNCE_RECENT_MAX )
+  #define ZDO_ANNCE_RECENT_MAX      16
+#endif
+
+// End device child that is listed in a Parent_annce_rsp
+#define ZDO_RFD_CHILD_KEEPALIVE( dev )  (((dev)->shortAddr != INVALID_NODE_ADDR) &&        \
+                                         (((dev)->nodeRelation == CHILD_RFD) ||           \
+                                          ((dev)->nodeRelation == CHILD_RFD_RX_IDLE)) &&  \
+                                         ((dev)->keepaliveRcv == TRUE))
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -98,6 +124,20 @@ typedef struct
   byte status;
 } ZDO_EDBind_t;
 
+typedef struct
+{
+  uint16_t nwkAddr;
+  uint8_t  extAddr[Z_EXTADDR_LEN];
+} zdoAnnceEntry_t;
+
+typedef struct
+{
+  uint16_t nwkAddr;
+  uint8_t  extAddr[Z_EXTADDR_LEN];
+  uint8_t  notForMe;      // It was not unicast to us by the device as its parent
+  uint32_t time;          // System clock when the announce was applied, 0 when free
+} zdoAnnceRecent_t;
+
 enum
 {
   ZDMATCH_INIT,           // Initialized
@@ -142,6 +182,22 @@ extern bool  requestNewTrustCenterLinkKey;
 static uint16_t ZDOBuildBuf[26];       // temp area to build data without allocation
 static ZDO_EDBind_t *ZDO_EDBind;     // Null when not used
 
+static zdoAnnceEntry_t zdoAnnceBatch[ZDO_ANNCE_BATCH_MAX];
+static uint8_t zdoAnnceBatchCnt = 0;
+static zdoAnnceRecent_t zdoAnnceRecent[ZDO_ANNCE_RECENT_MAX];
+
+// Sorted view of the end device children that have sent a keepalive, with
+// the association table entries it was built from in table order
+static struct
+{
+  uint16_t shortAddr;
+  uint16_t addrIdx;
+} zdoRfdChildKey[NWK_MAX_DEVICES];
+static ZDO_ChildInfo_t zdoRfdChildView[NWK_MAX_DEVICES];
+static uint16_t zdoRfdChildKeyCnt = 0;
+static uint16_t zdoRfdChildViewCnt = 0;
+static uint8_t zdoRfdChildViewValid = FALSE;
+
 #if defined ( MANAGED_SCAN )
   uint32_t managedScanNextChannel = 0;
   uint32_t managedScanChannelMask = 0;
@@ -172,6 +228,11 @@ static void ZDO_SendEDBindRsp( byte TransSeq, zAddrType_t *dstAddr, byte Status,
 #endif
 uint8_t *ZDO_ConvertOTAClusters( uint8_t cnt, uint8_t *inBuf, uint16_t *outList );
 static void zdoSendStateChangeMsg(uint8_t state, uint8_t taskId);
+static uint8_t zdoAnnceIsRecent( ZDO_DeviceAnnce_t *pAnnce, uint8_t notForMe );
+static void zdoAnnceRemember( ZDO_DeviceAnnce_t *pAnnce, uint8_t notForMe );
+static void zdoAnnceNotify( ZDO_DeviceAnnce_t *pAnnce );
+static void zdoRfdChildViewSync( void );
+static uint8_t zdoRfdChildViewFind( uint8_t *extAddr );
 
 /*********************************************************************
  * @fn          ZDO_Init
@@ -2099,7 +2160,10 @@ void ZDO_ProcessUserDescSet( zdoIncomingMsg_t *inMsg )
 /*********************************************************************
  * @fn          ZDO_ProcessDeviceAnnce
  *
- * @brief       This function processes a device annouce message.
+ * @brief       This function processes a device annouce message. The
+ *              tables are updated at once, the notifications of the
+ *              announce are held, one per device, and sent by
+ *              ZDO_ProcessDeviceAnnceBatch() shortly after.
  *
  * @param       inMsg - incoming message
  *
@@ -2110,6 +2174,7 @@ void ZDO_ProcessDeviceAnnce( zdoIncomingMsg_t *inMsg )
   ZDO_DeviceAnnce_t Annce;
   AddrMgrEntry_t addrEntry;
   uint8_t parentExt[Z_EXTADDR_LEN];
+  uint8_t notForMe;
 
   if ( ZG_DEVICE_ENDDEVICE_TYPE && zgRxAlwaysOn == FALSE )
   {
@@ -2136,6 +2201,18 @@ void ZDO_ProcessDeviceAnnce( zdoIncomingMsg_t *inMsg )
     }
   }
 
+  // The dev annce from our own children is unicast to us
+  notForMe = ( inMsg->macDestAddr != NLME_GetShortAddr() );
+
+  // The same announce has just been applied
+  if ( zdoAnnceIsRecent( &Annce, notForMe ) )
+  {
+    return;
+  }
+
+  // A leave of the device still held is indicated before its announce
+  ZDApp_LeaveBatchFlush( Annce.extAddr );
+
   // Clean up the neighbor table
   nwkNeighborRemoveAllStranded();
 
@@ -2167,7 +2244,7 @@ void ZDO_ProcessDeviceAnnce( zdoIncomingMsg_t *inMsg )
     // So check the mac destination address)
     // Remove it from the associated device list. If it is not
     // a child, no action will be taken in AssocRemove() anyway.
-    if ( inMsg->macDestAddr != NLME_GetShortAddr() )
+    if ( notForMe )
     {
       associated_devices_t *dev_ptr;
 
@@ -2222,6 +2299,8 @@ void ZDO_ProcessDeviceAnnce( zdoIncomingMsg_t *inMsg )
     }
   }
 
+  zdoAnnceRemember( &Annce, notForMe );
+
 #if !defined (DISABLE_GREENPOWER_BASIC_PROXY) && (ZG_BUILD_RTR_TYPE)
   if(ZG_DEVICE_RTR_TYPE)
   {
@@ -2231,137 +2310,336 @@ void ZDO_ProcessDeviceAnnce( zdoIncomingMsg_t *inMsg )
 
     if( ( GP_CheckAnnouncedDeviceGCB != NULL ) && !OsalPort_memcmp( Annce.extAddr, invalidIEEE, Z_EXTADDR_LEN ) )
     {
-      GP_CheckAnnouncedDeviceGCB( Annce.extAddr, Annce.nwkAddr );
+      zdoAnnceNotify( &Annce );
     }
   }
 #endif
 }
 
 /*********************************************************************
- * @fn          ZDO_ProcessParentAnnce
+ * @fn          ZDO_ProcessDeviceAnnceBatch
  *
- * @brief       This function processes a Parent annouce message.
+ * @brief       This function sends the notifications of the held
+ *              device announces.
  *
- * @param       inMsg - incoming message
+ * @param       none
  *
  * @return      none
  */
-void ZDO_ProcessParentAnnce( zdoIncomingMsg_t *inMsg )
+void ZDO_ProcessDeviceAnnceBatch( void )
 {
-  ZDO_ParentAnnce_t *parentAnnce;
-  uint8_t x;
-  uint8_t childCount = 0;
+  uint8_t i;
 
-  ZDO_ChildInfoList_t *listHead = NULL;
-  ZDO_ChildInfoList_t *listTail;
-  ZDO_ChildInfoList_t *newNode;
+  if ( (_NIB.nwkState != NWK_ROUTER) && (_NIB.nwkState != NWK_ENDDEVICE) )
+  {
+    // we aren't stable anymore, drop the held announces
+    zdoAnnceBatchCnt = 0;
+    return;
+  }
 
-  // Parse incoming message, memory is allocated by the parse function,
-  // it should be free after processing the message
-  parentAnnce = ZDO_ParseParentAnnce( inMsg );
+  for ( i = 0; i < zdoAnnceBatchCnt; i++ )
+  {
+#if !defined (DISABLE_GREENPOWER_BASIC_PROXY) && (ZG_BUILD_RTR_TYPE)
+    if ( GP_CheckAnnouncedDeviceGCB != NULL )
+    {
+      GP_CheckAnnouncedDeviceGCB( zdoAnnceBatch[i].extAddr, zdoAnnceBatch[i].nwkAddr );
+    }
+#endif
+  }
 
-  if ( parentAnnce != NULL )
+  zdoAnnceBatchCnt = 0;
+}
+
+/*********************************************************************
+ * @fn          zdoAnnceNotify
+ *
+ * @brief       Hold the notifications of an applied announce for
+ *              ZDO_ProcessDeviceAnnceBatch(). A device announcing again
+ *              before they are sent only keeps its latest address.
+ *
+ * @param       pAnnce - parsed announce
+ *
+ * @return      none
+ */
+static void zdoAnnceNotify( ZDO_DeviceAnnce_t *pAnnce )
+{
+  zdoAnnceEntry_t *pEntry;
+  uint8_t i;
+
+  for ( i = 0; i < zdoAnnceBatchCnt; i++ )
   {
-    for ( x = 0; x < parentAnnce->numOfChildren; x++ )
+    if ( osal_ExtAddrEqual( zdoAnnceBatch[i].extAddr, pAnnce->extAddr ) )
     {
-      associated_devices_t *dev_ptr;
+      zdoAnnceBatch[i].nwkAddr = pAnnce->nwkAddr;
+      return;
+    }
+  }
 
-      // If it's an End Device child
-      dev_ptr = AssocGetWithExt( parentAnnce->childInfo[x].extAddr );
+  if ( zdoAnnceBatchCnt >= ZDO_ANNCE_BATCH_MAX )
+  {
+    OsalPortTimers_stopTimer( ZDAppTaskID, ZDO_DEVICE_ANNCE_BATCH_EVT );
+    ZDO_ProcessDeviceAnnceBatch();
+  }
 
-      if ( dev_ptr )
-      {
-        if ( dev_ptr->nodeRelation == CHILD_RFD ||
-             dev_ptr->nodeRelation == CHILD_RFD_RX_IDLE )
-        {
-          if ( dev_ptr->keepaliveRcv == TRUE )
-          {
-            // Add one element to the list
-            newNode = (ZDO_ChildInfoList_t *)OsalPort_malloc( sizeof(ZDO_ChildInfoList_t) );
+  pEntry = &zdoAnnceBatch[zdoAnnceBatchCnt++];
+  pEntry->nwkAddr = pAnnce->nwkAddr;
+  osal_cpyExtAddr( pEntry->extAddr, pAnnce->extAddr );
 
-            if(newNode != NULL)
-            {
-              osal_cpyExtAddr( newNode->child.extAddr, parentAnnce->childInfo[x].extAddr );
+  if ( zdoAnnceBatchCnt == 1 )
+  {
+    OsalPortTimers_startTimer( ZDAppTaskID, ZDO_DEVICE_ANNCE_BATCH_EVT, ZDO_ANNCE_BATCH_DELAY );
+  }
+}
 
-              newNode->next = NULL;
+/*********************************************************************
+ * @fn          zdoAnnceIsRecent
+ *
+ * @brief       Check whether the device applied the same announce
+ *              within ZDO_ANNCE_DEDUP_WINDOW. An announce with another
+ *              address, or received through another parent than the
+ *              last one, is not the same.
+ *
+ * @param       pAnnce - parsed announce
+ * @param       notForMe - it was not unicast to us
+ *
+ * @return      TRUE if it did
+ */
+static uint8_t zdoAnnceIsRecent( ZDO_DeviceAnnce_t *pAnnce, uint8_t notForMe )
+{
+  uint8_t i;
 
-              if ( listHead == NULL )
-              {
-                // Initialize the head of the list
-                listHead = listTail = newNode;
-              }
-              else
-              {
-                // Add new element to the end
-                listTail->next = newNode;
+  for ( i = 0; i < ZDO_ANNCE_RECENT_MAX; i++ )
+  {
+    if ( (zdoAnnceRecent[i].time != 0) &&
+         osal_ExtAddrEqual( zdoAnnceRecent[i].extAddr, pAnnce->extAddr ) )
+    {
+      // One entry per device
+      return ( (zdoAnnceRecent[i].nwkAddr == pAnnce->nwkAddr) &&
+               (zdoAnnceRecent[i].notForMe == notForMe) &&
+               ((MAP_osal_GetSystemClock() - zdoAnnceRecent[i].time) < ZDO_ANNCE_DEDUP_WINDOW) );
+    }
+  }
 
-                listTail = listTail->next;
-              }
+  return ( FALSE );
+}
 
-              childCount++;
-            }
-            else
-            {
-              // TODO: handle malloc error
-            }
-          }
-        }
-      }
+/*********************************************************************
+ * @fn          zdoAnnceRemember
+ *
+ * @brief       Remember the applied announce of a device, in its own
+ *              entry, else in a free one, else in the oldest.
+ *
+ * @param       pAnnce - parsed announce
+ * @param       notForMe - it was not unicast to us
+ *
+ * @return      none
+ */
+static void zdoAnnceRemember( ZDO_DeviceAnnce_t *pAnnce, uint8_t notForMe )
+{
+  zdoAnnceRecent_t *pRecent = &zdoAnnceRecent[0];
+  zdoAnnceRecent_t *pItem;
+  uint32_t now = MAP_osal_GetSystemClock();
+  uint8_t i;
+
+  for ( i = 0; i < ZDO_ANNCE_RECENT_MAX; i++ )
+  {
+    pItem = &zdoAnnceRecent[i];
+
+    if ( (pItem->time != 0) && osal_ExtAddrEqual( pItem->extAddr, pAnnce->extAddr ) )
+    {
+      pRecent = pItem;
+      break;
     }
 
-    // If the device has children that match some in the received list,
-    // it should send a unicast Parent_Annce_rsp message.
-    if ( childCount > 0 )
+    if ( (pRecent->time != 0) &&
+         ((pItem->time == 0) || ((now - pItem->time) > (now - pRecent->time))) )
     {
-      ZDO_ChildInfo_t *childInfo;
-      zAddrType_t dstAddr;
+      pRecent = pItem;
+    }
+  }
 
-      dstAddr.addrMode = (afAddrMode_t)Addr16Bit;
-      dstAddr.addr.shortAddr = inMsg->srcAddr.addr.shortAddr;
+  pRecent->nwkAddr = pAnnce->nwkAddr;
+  osal_cpyExtAddr( pRecent->extAddr, pAnnce->extAddr );
+  pRecent->notForMe = notForMe;
+  pRecent->time = now;
+  if ( pRecent->time == 0 )
+  {
+    pRecent->time = 1;
+  }
+}
 
-      x = 0;
+/*********************************************************************
+ * @fn          ZDO_ProcessParentAnnce
+ *
+ * @brief       This function processes a Parent annouce message.
+ *
+ * @param       inMsg - incoming message
+ *
+ * @return      none
+ */
+void ZDO_ProcessParentAnnce( zdoIncomingMsg_t *inMsg )
+{
+  ZDO_ChildInfo_t childInfo[MAX_PARENT_ANNCE_CHILD];
+  uint8_t *msg;
+  uint8_t numChildren;
+  uint8_t x;
+  uint8_t childCount = 0;
 
-      childInfo = (ZDO_ChildInfo_t *)OsalPort_malloc( childCount * sizeof(ZDO_ChildInfo_t) );
+  if ( inMsg->asduLen == 0 )
+  {
+    return;
+  }
 
-      if ( childInfo != NULL )
-      {
-        // Copy the content of the link list into this buffer
-        while ( listHead != NULL )
-        {
-          listTail = listHead;
+  msg = inMsg->asdu;
+  numChildren = *msg++;
 
-          osal_cpyExtAddr( childInfo[x].extAddr,  listHead->child.extAddr );
+  // Never read past the end of the frame
+  if ( numChildren > ((inMsg->asduLen - 1) / Z_EXTADDR_LEN) )
+  {
+    numChildren = (inMsg->asduLen - 1) / Z_EXTADDR_LEN;
+  }
 
-          x++;
+  zdoRfdChildViewSync();
 
-          listHead = listTail->next;
+  for ( x = 0; (x < numChildren) && (childCount < MAX_PARENT_ANNCE_CHILD); x++ )
+  {
+    // If it's an End Device child that has sent a keepalive
+    if ( zdoRfdChildViewFind( msg ) )
+    {
+      osal_cpyExtAddr( childInfo[childCount].extAddr, msg );
+      childCount++;
+    }
 
-          // Free this element of the link list
-          OsalPort_free( listTail );
-        }
+    msg += Z_EXTADDR_LEN;
+  }
+
+  // If the device has children that match some in the received list,
+  // it should send a unicast Parent_Annce_rsp message.
+  if ( childCount > 0 )
+  {
+    zAddrType_t dstAddr;
 
-        ZDP_ParentAnnceRsp( (inMsg->TransSeq), dstAddr, childCount,
-                            ((uint8_t *)childInfo), 0 );
+    dstAddr.addrMode = (afAddrMode_t)Addr16Bit;
+    dstAddr.addr.shortAddr = inMsg->srcAddr.addr.shortAddr;
 
+    ZDP_ParentAnnceRsp( (inMsg->TransSeq), dstAddr, childCount,
+                        ((uint8_t *)childInfo), 0 );
+  }
+}
 
-        OsalPort_free(childInfo);
+/*********************************************************************
+ * @fn          zdoRfdChildViewSync
+ *
+ * @brief       Bring the sorted view of the end device children that
+ *              have sent a keepalive up to date with the association
+ *              table. The view is only rebuilt when the children in
+ *              the association table differ from the ones it was
+ *              built from.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void zdoRfdChildViewSync( void )
+{
+  associated_devices_t *dev_ptr;
+  AddrMgrEntry_t addrEntry;
+  ZDO_ChildInfo_t tmp;
+  uint16_t x;
+  uint16_t y;
+  uint16_t keyCnt = 0;
+  uint8_t same = zdoRfdChildViewValid;
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    dev_ptr = &AssociatedDevList[x];
+    if ( ZDO_RFD_CHILD_KEEPALIVE( dev_ptr ) )
+    {
+      if ( (keyCnt >= zdoRfdChildKeyCnt) ||
+           (zdoRfdChildKey[keyCnt].shortAddr != dev_ptr->shortAddr) ||
+           (zdoRfdChildKey[keyCnt].addrIdx != dev_ptr->addrIdx) )
+      {
+        same = FALSE;
+        break;
       }
-      else
+      keyCnt++;
+    }
+  }
+
+  if ( same && (keyCnt == zdoRfdChildKeyCnt) )
+  {
+    return;
+  }
+
+  zdoRfdChildKeyCnt = 0;
+  zdoRfdChildViewCnt = 0;
+  addrEntry.user = ADDRMGR_USER_DEFAULT;
+
+  for ( x = 0; x < NWK_MAX_DEVICES; x++ )
+  {
+    dev_ptr = &AssociatedDevList[x];
+    if ( ZDO_RFD_CHILD_KEEPALIVE( dev_ptr ) )
+    {
+      zdoRfdChildKey[zdoRfdChildKeyCnt].shortAddr = dev_ptr->shortAddr;
+      zdoRfdChildKey[zdoRfdChildKeyCnt].addrIdx = dev_ptr->addrIdx;
+      zdoRfdChildKeyCnt++;
+
+      addrEntry.index = dev_ptr->addrIdx;
+      if ( AddrMgrEntryGet( &addrEntry ) )
       {
-        while(listHead != NULL)
+        // Insertion sort, the table is small and mostly built once
+        y = zdoRfdChildViewCnt++;
+        osal_cpyExtAddr( tmp.extAddr, addrEntry.extAddr );
+        while ( (y > 0) &&
+                (memcmp( zdoRfdChildView[y - 1].extAddr, tmp.extAddr, Z_EXTADDR_LEN ) > 0) )
         {
-          listTail = listHead;
-          listHead = listTail->next;
-
-          // Free this element of the link list
-          OsalPort_free( listTail );
+          zdoRfdChildView[y] = zdoRfdChildView[y - 1];
+          y--;
         }
+        zdoRfdChildView[y] = tmp;
       }
     }
+  }
 
-    // Free memory allocated by parsing function
-    OsalPort_free( parentAnnce );
+  zdoRfdChildViewValid = TRUE;
+}
+
+/*********************************************************************
+ * @fn          zdoRfdChildViewFind
+ *
+ * @brief       Binary search of the sorted view of the end device
+ *              children that have sent a keepalive.
+ *
+ * @param       extAddr - IEEE address to look for
+ *
+ * @return      TRUE if found
+ */
+static uint8_t zdoRfdChildViewFind( uint8_t *extAddr )
+{
+  uint16_t lo = 0;
+  uint16_t hi = zdoRfdChildViewCnt;
+  uint16_t mid;
+  int cmp;
+
+  while ( lo < hi )
+  {
+    mid = lo + ((hi - lo) / 2);
+    cmp = memcmp( zdoRfdChildView[mid].extAddr, extAddr, Z_EXTADDR_LEN );
+    if ( cmp == 0 )
+    {
+      return ( TRUE );
+    }
+    if ( cmp < 0 )
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
   }
+
+  return ( FALSE );
 }
 
 /*********************************************************************
@@ -400,6 +400,8 @@ extern void ZDO_ProcessUserDescSet( zdoIncomingMsg_t *inMsg );
 
 extern void ZDO_ProcessDeviceAnnce( zdoIncomingMsg_t *inMsg );
 
+extern void ZDO_ProcessDeviceAnnceBatch( void );
+
 extern void ZDO_ProcessParentAnnce( zdoIncomingMsg_t *inMsg );
 
 extern void ZDO_ProcessParentAnnceRsp( zdoIncomingMsg_t *inMsg );
@@ -52,6 +52,7 @@
 #include "zd_profile.h"
 #include "zd_object.h"
 #include "zd_nwk_mgr.h"
+#include "zquirk.h"
 
 #if defined( LCD_SUPPORTED )
 
@@ -73,39 +74,19 @@
   (AFADDR).addr.shortAddr = (pZADDR)->addr.shortAddr;                  \
 }
 
-#define FillAndSendBuffer( TRANSSEQ, ADDR, ID, LEN, BUF ) {     \
-  afStatus_t stat;                                    \
-  ZDP_TmpBuf = (BUF)+1;                               \
-  stat = fillAndSend( (TRANSSEQ), (ADDR), (ID), (LEN) );          \
-  OsalPort_free( (BUF) );                             \
-  ZDP_TmpBuf = ZDP_Buf+1;                             \
-  return stat;                                        \
-}
-
-#define FillAndSendTxOptions( TRANSSEQ, ADDR, ID, LEN, TxO ) {  \
-  afStatus_t stat;                                    \
-  ZDP_TxOptions = (TxO);                              \
-  stat = fillAndSend( (TRANSSEQ), (ADDR), (ID), (LEN) );          \
-  ZDP_TxOptions = AF_TX_OPTIONS_NONE;                 \
-  return stat;                                        \
-}
-
-#define FillAndSendBufferTxOptions( TRANSSEQ, ADDR, ID, LEN, BUF, TxO ) { \
-  afStatus_t stat;                                    \
-  ZDP_TmpBuf = (BUF)+1;                               \
-  ZDP_TxOptions = (TxO);                              \
-  stat = fillAndSend( (TRANSSEQ), (ADDR), (ID), (LEN) );          \
-  OsalPort_free( (BUF) );                             \
-  ZDP_TmpBuf = ZDP_Buf+1;                             \
-  ZDP_TxOptions = AF_TX_OPTIONS_NONE;                 \
-  return stat;                                        \
-}
-
 /*********************************************************************
  * CONSTANTS
  */
 
-#define ZDP_BUF_SZ          80
+// Compact ZDO cluster index: the low 6 bits of the cluster ID plus the
+// response bit.  This is a perfect hash of all defined ZDO clusters.
+#define ZDO_CLUSTER_IDX_CNT             128
+#define ZDO_CLUSTER_INDEXABLE( cId )    ( ((cId) & ~(ZDO_RESPONSE_BIT | 0x003F)) == 0 )
+#define ZDO_CLUSTER_IDX( cId )          ( (uint8_t)(((cId) & 0x003F) | (((cId) & ZDO_RESPONSE_BIT) >> 9)) )
+#define ZDO_CLUSTER_IDX_NONE            0xFF
+
+// Tasks that fit in a subscriber bitmap
+#define ZDO_CB_TASKS_MAX                16
 
 CONST byte ZDP_AF_ENDPOINT = 0;
 
@@ -148,21 +129,30 @@ extern void ZDApp_SetParentAnnceTimer( void );
  * LOCAL FUNCTIONS
  */
 
-static afStatus_t fillAndSend( uint8_t *transSeq, zAddrType_t *addr, cId_t clusterID, byte len );
 uint8_t ZDO_SendMsgCBs( zdoIncomingMsg_t *inMsg );
+static void zdoMsgCBsBuildIndex( void );
+static uint8_t zdoSendMsgCB( uint8_t taskID, zdoIncomingMsg_t *inMsg, zdoIncomingMsg_t **ppMsg );
+static void zdpMsgProcsBuildIndex( void );
 void zdpProcessAddrReq( zdoIncomingMsg_t *inMsg );
 
 /*********************************************************************
  * LOCAL VARIABLES
  */
 
-static uint8_t  ZDP_Buf[ ZDP_BUF_SZ ];
-static uint8_t *ZDP_TmpBuf = ZDP_Buf+1;
 static uint8_t ZDP_TransID = 0;
 
 byte ZDP_TxOptions = AF_TX_OPTIONS_NONE;
 ZDO_MsgCB_t *zdoMsgCBs = (ZDO_MsgCB_t *)NULL;
 
+// Subscriber bitmap over task IDs per cluster index, built from zdoMsgCBs
+static uint16_t zdoMsgCBsMap[ZDO_CLUSTER_IDX_CNT];
+// Set when a registration can't be indexed, zdoMsgCBs is walked instead
+static uint8_t zdoMsgCBsUnindexed = FALSE;
+
+// zdpMsgProcs[] entry per cluster index, built on first use
+static uint8_t zdpMsgProcIdx[ZDO_CLUSTER_IDX_CNT];
+static uint8_t zdpMsgProcIdxReady = FALSE;
+
 /*********************************************************************
  * ZDO Message Processing table
  */
@@ -228,37 +218,285 @@ CONST zdpMsgProcItem_t zdpMsgProcs[] =
 };
 
 /*********************************************************************
- * @fn          fillAndSend
+ * ZDP frame builder
+ */
+
+/*********************************************************************
+ * @fn          ZDP_BuildInit
  *
- * @brief       Combined to reduce space
+ * @brief       Start building a ZDP frame.  The first byte of the
+ *              buffer is reserved for the transaction sequence number.
  *
- * @param
- * @param
+ * @param       pBld - builder to initialize
+ * @param       pBuf - frame buffer, NULL to allocate one
+ * @param       size - buffer size, see ZDP_BUILD_SIZE()
  *
- * @return      afStatus_t
+ * @return      ZSuccess, ZMemError if the buffer can't be allocated
  */
-static afStatus_t fillAndSend( uint8_t *transSeq, zAddrType_t *addr, cId_t clusterID, byte len )
+ZStatus_t ZDP_BuildInit( zdpBuilder_t *pBld, uint8_t *pBuf, uint16_t size )
 {
-  afAddrType_t afAddr;
-  afStatus_t status = afStatus_FAILED;
+  pBld->allocated = FALSE;
+
+  if ( (pBuf == NULL) && (size >= ZDP_BUILD_HDR_LEN) )
+  {
+    pBuf = OsalPort_malloc( size );
+    pBld->allocated = (pBuf != NULL);
+  }
+
+  pBld->pBuf = pBuf;
+  pBld->size = size;
+  pBld->len = ZDP_BUILD_HDR_LEN;
+  pBld->status = ZSuccess;
+
+  if ( (pBuf == NULL) || (size < ZDP_BUILD_HDR_LEN) )
+  {
+    pBld->status = ZMemError;
+  }
+
+  return ( pBld->status );
+}
+
+/*********************************************************************
+ * @fn          ZDP_BuildReserve
+ *
+ * @brief       Claim the next bytes of the frame, for fields that are
+ *              filled in directly or after the fact.
+ *
+ * @param       pBld - builder
+ * @param       len - number of bytes
+ *
+ * @return      pointer to the claimed bytes, NULL if they don't fit
+ */
+uint8_t *ZDP_BuildReserve( zdpBuilder_t *pBld, uint16_t len )
+{
+  uint8_t *pField;
+
+  if ( (pBld->status != ZSuccess) || (len > (pBld->size - pBld->len)) )
+  {
+    if ( pBld->status == ZSuccess )
+    {
+      pBld->status = ZBufferFull;
+    }
+    return ( NULL );
+  }
+
+  pField = pBld->pBuf + pBld->len;
+  pBld->len += len;
+
+  return ( pField );
+}
+
+/*********************************************************************
+ * @fn          ZDP_BuildUint8
+ *
+ * @brief       Append a byte to the frame.
+ *
+ * @param       pBld - builder
+ * @param       value - byte to append
+ *
+ * @return      none
+ */
+void ZDP_BuildUint8( zdpBuilder_t *pBld, uint8_t value )
+{
+  uint8_t *pField = ZDP_BuildReserve( pBld, 1 );
+
+  if ( pField != NULL )
+  {
+    *pField = value;
+  }
+}
 
-  memset( &afAddr, 0, sizeof(afAddrType_t) );
-  ZADDR_TO_AFADDR( addr, afAddr );
+/*********************************************************************
+ * @fn          ZDP_BuildUint16
+ *
+ * @brief       Append a little endian 16 bit value to the frame.
+ *
+ * @param       pBld - builder
+ * @param       value - value to append
+ *
+ * @return      none
+ */
+void ZDP_BuildUint16( zdpBuilder_t *pBld, uint16_t value )
+{
+  uint8_t *pField = ZDP_BuildReserve( pBld, sizeof( uint16_t ) );
+
+  if ( pField != NULL )
+  {
+    pField[0] = LO_UINT16( value );
+    pField[1] = HI_UINT16( value );
+  }
+}
+
+/*********************************************************************
+ * @fn          ZDP_BuildUint32
+ *
+ * @brief       Append a little endian 32 bit value to the frame.
+ *
+ * @param       pBld - builder
+ * @param       value - value to append
+ *
+ * @return      none
+ */
+void ZDP_BuildUint32( zdpBuilder_t *pBld, uint32_t value )
+{
+  uint8_t *pField = ZDP_BuildReserve( pBld, sizeof( uint32_t ) );
+
+  if ( pField != NULL )
+  {
+    OsalPort_bufferUint32( pField, value );
+  }
+}
+
+/*********************************************************************
+ * @fn          ZDP_BuildExtAddr
+ *
+ * @brief       Append a 64 bit IEEE address to the frame.
+ *
+ * @param       pBld - builder
+ * @param       pExtAddr - address to append
+ *
+ * @return      none
+ */
+void ZDP_BuildExtAddr( zdpBuilder_t *pBld, uint8_t *pExtAddr )
+{
+  uint8_t *pField = ZDP_BuildReserve( pBld, Z_EXTADDR_LEN );
 
-  *(ZDP_TmpBuf-1) = *transSeq;
+  if ( pField != NULL )
+  {
+    osal_cpyExtAddr( pField, pExtAddr );
+  }
+}
 
-  status = AF_DataRequest( &afAddr, &ZDApp_epDesc, clusterID,
-                           (uint16_t)(len+1), (uint8_t*)(ZDP_TmpBuf-1),
-                           &ZDP_TransID, ZDP_TxOptions,  AF_DEFAULT_RADIUS );
+/*********************************************************************
+ * @fn          ZDP_BuildBuf
+ *
+ * @brief       Append a byte string to the frame.
+ *
+ * @param       pBld - builder
+ * @param       pData - bytes to append
+ * @param       len - number of bytes
+ *
+ * @return      none
+ */
+void ZDP_BuildBuf( zdpBuilder_t *pBld, uint8_t *pData, uint16_t len )
+{
+  uint8_t *pField = ZDP_BuildReserve( pBld, len );
 
-  if ( status == afStatus_SUCCESS )
+  if ( (pField != NULL) && (len != 0) )
   {
-    (*transSeq)++;
+    OsalPort_memcpy( pField, pData, len );
   }
+}
+
+/*********************************************************************
+ * @fn          ZDP_BuildFill
+ *
+ * @brief       Append a run of identical bytes to the frame.
+ *
+ * @param       pBld - builder
+ * @param       value - fill value
+ * @param       len - number of bytes
+ *
+ * @return      none
+ */
+void ZDP_BuildFill( zdpBuilder_t *pBld, uint8_t value, uint16_t len )
+{
+  uint8_t *pField = ZDP_BuildReserve( pBld, len );
+
+  if ( (pField != NULL) && (len != 0) )
+  {
+    memset( pField, value, len );
+  }
+}
+
+/*********************************************************************
+ * @fn          ZDP_BuildClusterList
+ *
+ * @brief       Append a cluster count followed by the cluster IDs.
+ *
+ * @param       pBld - builder
+ * @param       numClusters - number of clusters
+ * @param       pClusterList - cluster ID list
+ *
+ * @return      none
+ */
+void ZDP_BuildClusterList( zdpBuilder_t *pBld, uint8_t numClusters, cId_t *pClusterList )
+{
+  uint8_t i;
+
+  ZDP_BuildUint8( pBld, numClusters );
+
+  for ( i = 0; i < numClusters; i++ )
+  {
+    ZDP_BuildUint16( pBld, pClusterList[i] );
+  }
+}
+
+/*********************************************************************
+ * @fn          ZDP_BuildSend
+ *
+ * @brief       Send a built ZDP frame.  A buffer allocated by
+ *              ZDP_BuildInit() is released, a caller's buffer is left
+ *              intact so the frame can be sent again.
+ *
+ * @param       pBld - builder
+ * @param       transSeq - transaction sequence number, incremented
+ *                         when the frame is accepted
+ * @param       dstAddr - destination address
+ * @param       clusterID - ZDO cluster ID
+ * @param       txOptions - AF transmit options
+ *
+ * @return      afStatus_t, afStatus_MEM_FAIL if the frame didn't fit
+ */
+afStatus_t ZDP_BuildSend( zdpBuilder_t *pBld, uint8_t *transSeq, zAddrType_t *dstAddr,
+                          cId_t clusterID, uint8_t txOptions )
+{
+  afAddrType_t afAddr;
+  afStatus_t status = afStatus_MEM_FAIL;
+
+  if ( pBld->status == ZSuccess )
+  {
+    memset( &afAddr, 0, sizeof(afAddrType_t) );
+    ZADDR_TO_AFADDR( dstAddr, afAddr );
+
+    pBld->pBuf[0] = *transSeq;
+
+    status = AF_DataRequest( &afAddr, &ZDApp_epDesc, clusterID,
+                             pBld->len, pBld->pBuf,
+                             &ZDP_TransID, txOptions, AF_DEFAULT_RADIUS );
+
+    if ( status == afStatus_SUCCESS )
+    {
+      (*transSeq)++;
+    }
+  }
+
+  ZDP_BuildFree( pBld );
 
   return status;
 }
 
+/*********************************************************************
+ * @fn          ZDP_BuildFree
+ *
+ * @brief       Release a buffer allocated by ZDP_BuildInit(), for frames
+ *              that are abandoned instead of sent.
+ *
+ * @param       pBld - builder
+ *
+ * @return      none
+ */
+void ZDP_BuildFree( zdpBuilder_t *pBld )
+{
+  if ( pBld->allocated )
+  {
+    OsalPort_free( pBld->pBuf );
+    pBld->pBuf = NULL;
+    pBld->allocated = FALSE;
+    pBld->status = ZMemError;
+  }
+}
+
 /*********************************************************************
  * @fn          ZDP_SendData
  *
@@ -276,15 +514,16 @@ static afStatus_t fillAndSend( uint8_t *transSeq, zAddrType_t *addr, cId_t clust
 afStatus_t ZDP_SendData( uint8_t *TransSeq, zAddrType_t *dstAddr, uint16_t cmd,
                         byte len, uint8_t *buf, byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte cnt = len;
+  zdpBuilder_t bld;
 
-  while ( cnt-- )
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
   {
-    *pBuf++ = *buf++;
+    return afStatus_MEM_FAIL;
   }
 
-  FillAndSendTxOptions( TransSeq, dstAddr, cmd, len, ((SecurityEnable) ? AF_EN_SECURITY : 0) );
+  ZDP_BuildBuf( &bld, buf, len );
+
+  return ZDP_BuildSend( &bld, TransSeq, dstAddr, cmd, ((SecurityEnable) ? AF_EN_SECURITY : 0) );
 }
 
 /*********************************************************************
@@ -302,12 +541,15 @@ afStatus_t ZDP_SendData( uint8_t *TransSeq, zAddrType_t *dstAddr, uint16_t cmd,
 afStatus_t ZDP_NWKAddrOfInterestReq( zAddrType_t *dstAddr, uint16_t nwkAddr,
                                      byte cmd, byte SecurityEnable )
 {
+  uint8_t buf[ZDP_BUILD_SIZE( 2 )];
+  zdpBuilder_t bld;
+
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
-  ZDP_TmpBuf[0] = LO_UINT16( nwkAddr );
-  ZDP_TmpBuf[1] = HI_UINT16( nwkAddr );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildUint16( &bld, nwkAddr );
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, cmd, 2 );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, cmd, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -329,8 +571,8 @@ afStatus_t ZDP_NWKAddrOfInterestReq( zAddrType_t *dstAddr, uint16_t nwkAddr,
 afStatus_t ZDP_NwkAddrReq( uint8_t *IEEEAddress, byte ReqType,
                            byte StartIndex, byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len = Z_EXTADDR_LEN + 1 + 1;  // IEEEAddress + ReqType + StartIndex.
+  uint8_t buf[ZDP_BUILD_SIZE( Z_EXTADDR_LEN + 1 + 1 )];  // IEEEAddress + ReqType + StartIndex.
+  zdpBuilder_t bld;
   zAddrType_t dstAddr;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
@@ -346,12 +588,12 @@ afStatus_t ZDP_NwkAddrReq( uint8_t *IEEEAddress, byte ReqType,
     dstAddr.addr.shortAddr = ZDAppNwkAddr.addr.shortAddr;
   }
 
-  pBuf = osal_cpyExtAddr( pBuf, IEEEAddress );
-
-  *pBuf++ = ReqType;
-  *pBuf++ = StartIndex;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildExtAddr( &bld, IEEEAddress );
+  ZDP_BuildUint8( &bld, ReqType );
+  ZDP_BuildUint8( &bld, StartIndex );
 
-  return fillAndSend( &ZDP_SeqNum, &dstAddr, NWK_addr_req, len );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, &dstAddr, NWK_addr_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -370,8 +612,8 @@ afStatus_t ZDP_NwkAddrReq( uint8_t *IEEEAddress, byte ReqType,
 afStatus_t ZDP_IEEEAddrReq( uint16_t shortAddr, byte ReqType,
                             byte StartIndex, byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len = 2 + 1 + 1;  // shortAddr + ReqType + StartIndex.
+  uint8_t buf[ZDP_BUILD_SIZE( 2 + 1 + 1 )];  // shortAddr + ReqType + StartIndex.
+  zdpBuilder_t bld;
   zAddrType_t dstAddr;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
@@ -379,13 +621,12 @@ afStatus_t ZDP_IEEEAddrReq( uint16_t shortAddr, byte ReqType,
   dstAddr.addrMode = (afAddrMode_t)Addr16Bit;
   dstAddr.addr.shortAddr = shortAddr;
 
-  *pBuf++ = LO_UINT16( shortAddr );
-  *pBuf++ = HI_UINT16( shortAddr );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildUint16( &bld, shortAddr );
+  ZDP_BuildUint8( &bld, ReqType );
+  ZDP_BuildUint8( &bld, StartIndex );
 
-  *pBuf++ = ReqType;
-  *pBuf++ = StartIndex;
-
-  return fillAndSend( &ZDP_SeqNum, &dstAddr, IEEE_addr_req, len );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, &dstAddr, IEEE_addr_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -413,19 +654,13 @@ afStatus_t ZDP_MatchDescReq( zAddrType_t *dstAddr, uint16_t nwkAddr,
                                 byte NumOutClusters, cId_t *OutClusterList,
                                 byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  // nwkAddr+ProfileID+NumInClusters+NumOutClusters.
-  byte i, len = 2 + 2 + 1 + 1;  // nwkAddr+ProfileID+NumInClusters+NumOutClusters.
+  zdpBuilder_t bld;
+  uint16_t len = 2 + 2 + 1 + 1;  // nwkAddr+ProfileID+NumInClusters+NumOutClusters.
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
   len += (NumInClusters + NumOutClusters) * sizeof(uint16_t);
 
-  if ( len >= ZDP_BUF_SZ-1 )
-  {
-    return afStatus_MEM_FAIL;
-  }
-
   // The spec changed in Zigbee 2007 (2.4.3.1.7.1) to not allow sending
   // this command to 0xFFFF.  So, here we will filter this and replace
   // with 0xFFFD to only send to devices with RX ON.  This includes the
@@ -440,31 +675,17 @@ afStatus_t ZDP_MatchDescReq( zAddrType_t *dstAddr, uint16_t nwkAddr,
     nwkAddr = NWK_BROADCAST_SHORTADDR_DEVRXON;
   }
 
-  *pBuf++ = LO_UINT16( nwkAddr );   // NWKAddrOfInterest
-  *pBuf++ = HI_UINT16( nwkAddr );
-
-  *pBuf++ = LO_UINT16( ProfileID );   // Profile ID
-  *pBuf++ = HI_UINT16( ProfileID );
-
-  *pBuf++ = NumInClusters; // Input cluster list
-  if ( NumInClusters )
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
   {
-    for (i=0; i<NumInClusters; ++i)  {
-      *pBuf++ = LO_UINT16( InClusterList[i] );
-      *pBuf++ = HI_UINT16( InClusterList[i] );
-    }
+    return afStatus_MEM_FAIL;
   }
 
-  *pBuf++ = NumOutClusters; // Output cluster list
-  if ( NumOutClusters )
-  {
-    for (i=0; i<NumOutClusters; ++i)  {
-      *pBuf++ = LO_UINT16( OutClusterList[i] );
-      *pBuf++ = HI_UINT16( OutClusterList[i] );
-    }
-  }
+  ZDP_BuildUint16( &bld, nwkAddr );     // NWKAddrOfInterest
+  ZDP_BuildUint16( &bld, ProfileID );   // Profile ID
+  ZDP_BuildClusterList( &bld, NumInClusters, InClusterList );   // Input cluster list
+  ZDP_BuildClusterList( &bld, NumOutClusters, OutClusterList ); // Output cluster list
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, Match_Desc_req, len );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, Match_Desc_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -485,13 +706,16 @@ afStatus_t ZDP_SimpleDescReq( zAddrType_t *dstAddr, uint16_t nwkAddr,
                                     byte endPoint, byte SecurityEnable )
 
 {
+  uint8_t buf[ZDP_BUILD_SIZE( 2 + 1 )];  // nwkAddr + endPoint.
+  zdpBuilder_t bld;
+
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
-  ZDP_TmpBuf[0] = LO_UINT16( nwkAddr );
-  ZDP_TmpBuf[1] = HI_UINT16( nwkAddr );
-  ZDP_TmpBuf[2] = endPoint;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildUint16( &bld, nwkAddr );
+  ZDP_BuildUint8( &bld, endPoint );
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, Simple_Desc_req, 3 );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, Simple_Desc_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -512,24 +736,21 @@ afStatus_t ZDP_UserDescSet( zAddrType_t *dstAddr, uint16_t nwkAddr,
                           UserDescriptorFormat_t *UserDescriptor,
                           byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
+  // nwkAddr + descriptor length + padded user descriptor.
+  uint8_t buf[ZDP_BUILD_SIZE( 2 + 1 + AF_MAX_USER_DESCRIPTOR_LEN )];
+  zdpBuilder_t bld;
   byte len = (UserDescriptor->len < AF_MAX_USER_DESCRIPTOR_LEN) ?
               UserDescriptor->len : AF_MAX_USER_DESCRIPTOR_LEN;
-  byte addrLen = 2;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
-  *pBuf++ = LO_UINT16( nwkAddr );
-  *pBuf++ = HI_UINT16( nwkAddr );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildUint16( &bld, nwkAddr );
+  ZDP_BuildUint8( &bld, len );
+  ZDP_BuildBuf( &bld, UserDescriptor->desc, len );
+  ZDP_BuildFill( &bld, AF_USER_DESCRIPTOR_FILL, (AF_MAX_USER_DESCRIPTOR_LEN - len) );
 
-  *pBuf++ = len;
-  addrLen = 3;
-
-  memset( pBuf, AF_USER_DESCRIPTOR_FILL, AF_MAX_USER_DESCRIPTOR_LEN);
-
-  OsalPort_memcpy( pBuf, UserDescriptor->desc, len );
-
-  return fillAndSend( &ZDP_SeqNum, dstAddr, User_Desc_set, (AF_MAX_USER_DESCRIPTOR_LEN + addrLen) );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, User_Desc_set, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -544,17 +765,18 @@ afStatus_t ZDP_UserDescSet( zAddrType_t *dstAddr, uint16_t nwkAddr,
  */
 afStatus_t ZDP_ServerDiscReq( uint16_t serverMask, byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
+  uint8_t buf[ZDP_BUILD_SIZE( 2 )];  // serverMask.
+  zdpBuilder_t bld;
   zAddrType_t dstAddr;
 
   dstAddr.addrMode = AddrBroadcast;
   dstAddr.addr.shortAddr = NWK_BROADCAST_SHORTADDR_DEVRXON;
 
-  *pBuf++ = LO_UINT16( serverMask );
-  *pBuf = HI_UINT16( serverMask );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildUint16( &bld, serverMask );
 
-  FillAndSendTxOptions( &ZDP_SeqNum, &dstAddr, Server_Discovery_req, 2,
-             ((SecurityEnable) ? AF_EN_SECURITY : AF_TX_OPTIONS_NONE) );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, &dstAddr, Server_Discovery_req,
+                        ((SecurityEnable) ? AF_EN_SECURITY : AF_TX_OPTIONS_NONE) );
 }
 
 /*********************************************************************
@@ -574,23 +796,21 @@ afStatus_t ZDP_ServerDiscReq( uint16_t serverMask, byte SecurityEnable )
 afStatus_t ZDP_DeviceAnnce( uint16_t nwkAddr, uint8_t *IEEEAddr,
                               byte capabilities, byte SecurityEnable )
 {
+  uint8_t buf[ZDP_BUILD_SIZE( 2 + Z_EXTADDR_LEN + 1 )];  // nwkAddr + IEEEAddr + capabilities.
+  zdpBuilder_t bld;
   zAddrType_t dstAddr;
-  uint8_t len;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
   dstAddr.addrMode = (afAddrMode_t)AddrBroadcast;
   dstAddr.addr.shortAddr = NWK_BROADCAST_SHORTADDR_DEVRXON;
 
-  ZDP_TmpBuf[0] = LO_UINT16( nwkAddr );
-  ZDP_TmpBuf[1] = HI_UINT16( nwkAddr );
-  osal_cpyExtAddr( &ZDP_TmpBuf[2], IEEEAddr );
-  len = 2 + Z_EXTADDR_LEN;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildUint16( &bld, nwkAddr );
+  ZDP_BuildExtAddr( &bld, IEEEAddr );
+  ZDP_BuildUint8( &bld, capabilities );
 
-  ZDP_TmpBuf[10] = capabilities;
-  len++;
-
-  return fillAndSend( &ZDP_SeqNum, &dstAddr, Device_annce, len );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, &dstAddr, Device_annce, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -615,9 +835,9 @@ afStatus_t ZDP_ParentAnnce( uint8_t *TransSeq,
                             cId_t clusterID,
                             uint8_t SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
+  zdpBuilder_t bld;
   ZDO_ChildInfo_t *pChildInfo;
-  uint8_t i, len;
+  uint8_t i;
   uint8_t *numOfChild;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
@@ -629,37 +849,37 @@ afStatus_t ZDP_ParentAnnce( uint8_t *TransSeq,
     // Make sure is sent to 0xFFFC
     dstAddr->addr.shortAddr = NWK_BROADCAST_SHORTADDR_DEVZCZR;
   }
-  len = 1;
+
+  // Status + NumberOfChildren + ChildInfo list.
+  if ( ZDP_BuildInit( &bld, NULL,
+         ZDP_BUILD_SIZE( 1 + 1 + (MAX_PARENT_ANNCE_CHILD * Z_EXTADDR_LEN) ) ) != ZSuccess )
+  {
+    return afStatus_MEM_FAIL;
+  }
+
   if ( clusterID == Parent_annce_rsp )
   {
-    // + Status Byte
-    len += 1;
     // Set the status bit to success
-    *pBuf++ = 0;
+    ZDP_BuildUint8( &bld, 0 );
   }
 
-  numOfChild = pBuf;
-  *pBuf++ = numberOfChildren;
+  numOfChild = ZDP_BuildReserve( &bld, 1 );
+  *numOfChild = MAX_PARENT_ANNCE_CHILD;
 
   for ( i = 0; i < MAX_PARENT_ANNCE_CHILD; i++ )
   {
-    pBuf = osal_cpyExtAddr( pBuf, pChildInfo[childIndex].extAddr );
+    ZDP_BuildExtAddr( &bld, pChildInfo[childIndex].extAddr );
     childIndex++;
 
-    len += Z_EXTADDR_LEN;
-
     if ( childIndex == numberOfChildren )
     {
-      pBuf = numOfChild;
-      *pBuf = i + 1;
+      *numOfChild = i + 1;
       // All childs are taken, restart index and go out
       childIndex = 0;
-      return fillAndSend( TransSeq, dstAddr, clusterID, len );
+      return ZDP_BuildSend( &bld, TransSeq, dstAddr, clusterID, ZDP_TxOptions );
     }
   }
 
-  pBuf = numOfChild;
-  *pBuf = MAX_PARENT_ANNCE_CHILD;
   if ( childIndex < numberOfChildren )
   {
     if ( clusterID == Parent_annce )
@@ -672,7 +892,7 @@ afStatus_t ZDP_ParentAnnce( uint8_t *TransSeq,
     }
   }
 
-  return fillAndSend( TransSeq, dstAddr, clusterID, len );
+  return ZDP_BuildSend( &bld, TransSeq, dstAddr, clusterID, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -692,6 +912,7 @@ afStatus_t ZDP_ParentAnnce( uint8_t *TransSeq,
 void zdpProcessAddrReq( zdoIncomingMsg_t *inMsg )
 {
   associated_devices_t *pAssoc;
+  AddrMgrEntry_t addrEntry;     // Holds ieee of a child until it is sent
   uint8_t reqType;
   uint16_t aoi = INVALID_NODE_ADDR;
   uint8_t *ieee = NULL;
@@ -729,7 +950,6 @@ void zdpProcessAddrReq( zdoIncomingMsg_t *inMsg )
       && (((pAssoc = AssocGetWithShort( aoi )) != NULL)
              && (pAssoc->nodeRelation == CHILD_RFD)) )
     {
-      AddrMgrEntry_t addrEntry;
       addrEntry.user = ADDRMGR_USER_DEFAULT;
       addrEntry.index = pAssoc->addrIdx;
       if ( AddrMgrEntryGet( &addrEntry ) )
@@ -745,9 +965,13 @@ void zdpProcessAddrReq( zdoIncomingMsg_t *inMsg )
   if ( ((aoi != INVALID_NODE_ADDR) && (ieee != NULL)) || (inMsg->wasBroadcast == FALSE) )
   {
     uint8_t stat;
-    uint8_t *pBuf = ZDP_TmpBuf;
+    zdpBuilder_t bld;
     // Status + IEEE-Addr + Nwk-Addr.
-    uint8_t len = 1 + Z_EXTADDR_LEN + 2;
+    uint16_t len = 1 + Z_EXTADDR_LEN + 2;
+    uint16_t *list = NULL;
+    uint8_t  cnt = 0;
+    uint8_t  idx = 0;
+    uint8_t  extended = FALSE;
 
     // If aoi and iee are both setup, we found results
     if ( (aoi != INVALID_NODE_ADDR) && (ieee != NULL) )
@@ -779,83 +1003,97 @@ void zdpProcessAddrReq( zdoIncomingMsg_t *inMsg )
       }
       else
       {
-        //CCB 2113 Zigbee Core spec
-        uint8_t invalidIEEEAddr[Z_EXTADDR_LEN];
-        memset(invalidIEEEAddr,0xFF,Z_EXTADDR_LEN);
-        ieee = invalidIEEEAddr;
+        //CCB 2113 Zigbee Core spec, sent as all 0xFF below
+        ieee = NULL;
       }
     }
 
-    *pBuf++ = stat;
-
-    if(ieee != NULL)
-    {
-      pBuf = osal_cpyExtAddr( pBuf, ieee );
-    }
-    else
-    {
-      uint8_t invalidIEEEAddr[Z_EXTADDR_LEN];
-      memset(invalidIEEEAddr,0xFF,Z_EXTADDR_LEN);
-      pBuf = osal_cpyExtAddr( pBuf, invalidIEEEAddr );
-    }
-
-    *pBuf++ = LO_UINT16( aoi );
-    *pBuf++ = HI_UINT16( aoi );
-
     if ( ZSTACK_ROUTER_BUILD )
     {
       if ( (reqType == ZDP_ADDR_REQTYPE_EXTENDED) && (aoi == ZDAppNwkAddr.addr.shortAddr)
            && (stat == ZDP_SUCCESS) )
       {
-        uint8_t  cnt = 0;
+        extended = TRUE;
 
         //Updated to only search for ZED devices as per R21 spec (2.4.3.1.1.2)
-        uint16_t *list = AssocMakeList( &cnt );
+        list = AssocMakeList( &cnt );
 
         if ( list != NULL )
         {
-          byte idx = inMsg->asdu[(((inMsg->clusterID == NWK_addr_req) ? Z_EXTADDR_LEN : sizeof( uint16_t )) + 1)];
-          uint16_t *pList = list + idx;
+          idx = inMsg->asdu[(((inMsg->clusterID == NWK_addr_req) ? Z_EXTADDR_LEN : sizeof( uint16_t )) + 1)];
 
           // NumAssocDev field is only present on success.
           if ( cnt > idx )
           {
             cnt -= idx;
-            len += (cnt * sizeof( uint16_t ));
           }
           else
           {
             cnt = 0;
           }
-          *pBuf++ = cnt;
-          len++;
-
-          // StartIndex field is only present if NumAssocDev field is non-zero.
-          *pBuf++ = idx;
-          len++;
-
-          while ( cnt != 0 )
-          {
-            *pBuf++ = LO_UINT16( *pList );
-            *pBuf++ = HI_UINT16( *pList );
-            pList++;
-            cnt--;
-          }
 
-          OsalPort_free( (uint8_t *)list );
+          // NumAssocDev + StartIndex + NWKAddrAssocDevList.
+          len += 1 + 1 + (cnt * sizeof( uint16_t ));
         }
         else
         {
           // NumAssocDev field is only present on success.
-          *pBuf++ = 0;
           len++;
         }
       }
     }
 
-    ZDP_TxOptions = AF_MSG_ACK_REQUEST;
-    fillAndSend( &(inMsg->TransSeq), &(inMsg->srcAddr), (cId_t)(inMsg->clusterID | ZDO_RESPONSE_BIT), len );
-    ZDP_TxOptions = AF_TX_OPTIONS_NONE;
+    if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
+    {
+      if ( list != NULL )
+      {
+        OsalPort_free( (uint8_t *)list );
+      }
+      return;
+    }
+
+    ZDP_BuildUint8( &bld, stat );
+
+    if(ieee != NULL)
+    {
+      ZDP_BuildExtAddr( &bld, ieee );
+    }
+    else
+    {
+      ZDP_BuildFill( &bld, 0xFF, Z_EXTADDR_LEN );
+    }
+
+    ZDP_BuildUint16( &bld, aoi );
+
+    if ( extended )
+    {
+      if ( list != NULL )
+      {
+        uint16_t *pList = list + idx;
+
+        ZDP_BuildUint8( &bld, cnt );
+
+        // StartIndex field is only present if NumAssocDev field is non-zero.
+        ZDP_BuildUint8( &bld, idx );
+
+        while ( cnt != 0 )
+        {
+          ZDP_BuildUint16( &bld, *pList );
+          pList++;
+          cnt--;
+        }
+
+        OsalPort_free( (uint8_t *)list );
+      }
+      else
+      {
+        // NumAssocDev field is only present on success.
+        ZDP_BuildUint8( &bld, 0 );
+      }
+    }
+
+    ZDP_BuildSend( &bld, &(inMsg->TransSeq), &(inMsg->srcAddr),
+                   (cId_t)(inMsg->clusterID | ZDO_RESPONSE_BIT), AF_MSG_ACK_REQUEST );
   }
 }
 
@@ -874,35 +1112,29 @@ void zdpProcessAddrReq( zdoIncomingMsg_t *inMsg )
 afStatus_t ZDP_NodeDescMsg( zdoIncomingMsg_t *inMsg,
                            uint16_t nwkAddr, NodeDescriptorFormat_t *pNodeDesc )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len;
-
-  len = 1 + 2 + 13;  // Status + nwkAddr + Node descriptor
+  uint8_t buf[ZDP_BUILD_SIZE( 1 + 2 + 13 )];  // Status + nwkAddr + Node descriptor
+  zdpBuilder_t bld;
 
-  *pBuf++ = ZDP_SUCCESS;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
 
-  *pBuf++ = LO_UINT16( nwkAddr );
-  *pBuf++ = HI_UINT16( nwkAddr );
+  ZDP_BuildUint8( &bld, ZDP_SUCCESS );
+  ZDP_BuildUint16( &bld, nwkAddr );
 
-  *pBuf++ = (byte)((pNodeDesc->ComplexDescAvail << 3) |
-                     (pNodeDesc->UserDescAvail << 4) |
-                     (pNodeDesc->LogicalType & 0x07));
+  ZDP_BuildUint8( &bld, (byte)((pNodeDesc->ComplexDescAvail << 3) |
+                               (pNodeDesc->UserDescAvail << 4) |
+                               (pNodeDesc->LogicalType & 0x07)) );
 
-  *pBuf++ = (byte)((pNodeDesc->FrequencyBand << 3) | (pNodeDesc->APSFlags & 0x07));
-  *pBuf++ = pNodeDesc->CapabilityFlags;
-  *pBuf++ = pNodeDesc->ManufacturerCode[0];
-  *pBuf++ = pNodeDesc->ManufacturerCode[1];
-  *pBuf++ = pNodeDesc->MaxBufferSize;
-  *pBuf++ = pNodeDesc->MaxInTransferSize[0];
-  *pBuf++ = pNodeDesc->MaxInTransferSize[1];
+  ZDP_BuildUint8( &bld, (byte)((pNodeDesc->FrequencyBand << 3) | (pNodeDesc->APSFlags & 0x07)) );
+  ZDP_BuildUint8( &bld, pNodeDesc->CapabilityFlags );
+  ZDP_BuildBuf( &bld, pNodeDesc->ManufacturerCode, 2 );
+  ZDP_BuildUint8( &bld, pNodeDesc->MaxBufferSize );
+  ZDP_BuildBuf( &bld, pNodeDesc->MaxInTransferSize, 2 );
 
-  *pBuf++ = LO_UINT16( pNodeDesc->ServerMask );
-  *pBuf++ = HI_UINT16( pNodeDesc->ServerMask );
-  *pBuf++ = pNodeDesc->MaxOutTransferSize[0];
-  *pBuf++ = pNodeDesc->MaxOutTransferSize[1];
-  *pBuf = pNodeDesc->DescriptorCapability;
+  ZDP_BuildUint16( &bld, pNodeDesc->ServerMask );
+  ZDP_BuildBuf( &bld, pNodeDesc->MaxOutTransferSize, 2 );
+  ZDP_BuildUint8( &bld, pNodeDesc->DescriptorCapability );
 
-  return fillAndSend( &(inMsg->TransSeq), &(inMsg->srcAddr), Node_Desc_rsp, len );
+  return ZDP_BuildSend( &bld, &(inMsg->TransSeq), &(inMsg->srcAddr), Node_Desc_rsp, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -920,20 +1152,20 @@ afStatus_t ZDP_NodeDescMsg( zdoIncomingMsg_t *inMsg,
 afStatus_t ZDP_PowerDescMsg( zdoIncomingMsg_t *inMsg,
                      uint16_t nwkAddr, NodePowerDescriptorFormat_t *pPowerDesc )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len = 1 + 2 + 2;  // Status + nwkAddr + Node Power descriptor.
+  uint8_t buf[ZDP_BUILD_SIZE( 1 + 2 + 2 )];  // Status + nwkAddr + Node Power descriptor.
+  zdpBuilder_t bld;
 
-  *pBuf++ = ZDP_SUCCESS;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
 
-  *pBuf++ = LO_UINT16( nwkAddr );
-  *pBuf++ = HI_UINT16( nwkAddr );
+  ZDP_BuildUint8( &bld, ZDP_SUCCESS );
+  ZDP_BuildUint16( &bld, nwkAddr );
 
-  *pBuf++ = (byte)((pPowerDesc->AvailablePowerSources << 4)
-                    | (pPowerDesc->PowerMode & 0x0F));
-  *pBuf++ = (byte)((pPowerDesc->CurrentPowerSourceLevel << 4)
-                    | (pPowerDesc->CurrentPowerSource & 0x0F));
+  ZDP_BuildUint8( &bld, (byte)((pPowerDesc->AvailablePowerSources << 4)
+                               | (pPowerDesc->PowerMode & 0x0F)) );
+  ZDP_BuildUint8( &bld, (byte)((pPowerDesc->CurrentPowerSourceLevel << 4)
+                               | (pPowerDesc->CurrentPowerSource & 0x0F)) );
 
-  return fillAndSend( &(inMsg->TransSeq), &(inMsg->srcAddr), Power_Desc_rsp, len );
+  return ZDP_BuildSend( &bld, &(inMsg->TransSeq), &(inMsg->srcAddr), Power_Desc_rsp, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -951,8 +1183,8 @@ afStatus_t ZDP_PowerDescMsg( zdoIncomingMsg_t *inMsg,
 afStatus_t ZDP_SimpleDescMsg( zdoIncomingMsg_t *inMsg, byte Status,
                               SimpleDescriptionFormat_t *pSimpleDesc )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  uint8_t i, len;
+  zdpBuilder_t bld;
+  uint16_t len;
 
   if ( Status == ZDP_SUCCESS && pSimpleDesc )
   {
@@ -964,57 +1196,43 @@ afStatus_t ZDP_SimpleDescMsg( zdoIncomingMsg_t *inMsg, byte Status,
   {
     len = 1 + 2 + 1; // Status + desc length
   }
-  if ( len >= ZDP_BUF_SZ-1 )
+
+  // The descriptor length field is a single byte
+  if ( (len - 4) > 0xFF )
+  {
+    return afStatus_MEM_FAIL;
+  }
+
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
   {
     return afStatus_MEM_FAIL;
   }
 
-  *pBuf++ = Status;
+  ZDP_BuildUint8( &bld, Status );
 
   //From spec 2.4.3.1.5 The NWKAddrOfInterest field shall match
   //that specified in the original Simple_Desc_req command
-  *pBuf++ = inMsg->asdu[0];
-  *pBuf++ = inMsg->asdu[1];
+  ZDP_BuildBuf( &bld, inMsg->asdu, 2 );
 
   if ( len > 4 )
   {
-    *pBuf++ = len - 4;   // Simple descriptor length
-
-    *pBuf++ = pSimpleDesc->EndPoint;
-    *pBuf++ = LO_UINT16( pSimpleDesc->AppProfId );
-    *pBuf++ = HI_UINT16( pSimpleDesc->AppProfId );
-    *pBuf++ = LO_UINT16( pSimpleDesc->AppDeviceId );
-    *pBuf++ = HI_UINT16( pSimpleDesc->AppDeviceId );
+    ZDP_BuildUint8( &bld, (uint8_t)(len - 4) );   // Simple descriptor length
 
-    *pBuf++ = (byte)(pSimpleDesc->AppDevVer & 0x0F);
+    ZDP_BuildUint8( &bld, pSimpleDesc->EndPoint );
+    ZDP_BuildUint16( &bld, pSimpleDesc->AppProfId );
+    ZDP_BuildUint16( &bld, pSimpleDesc->AppDeviceId );
 
-    *pBuf++ = pSimpleDesc->AppNumInClusters;
-    if ( pSimpleDesc->AppNumInClusters )
-    {
-      for (i=0; i<pSimpleDesc->AppNumInClusters; ++i)
-      {
-        *pBuf++ = LO_UINT16( pSimpleDesc->pAppInClusterList[i] );
-        *pBuf++ = HI_UINT16( pSimpleDesc->pAppInClusterList[i] );
-      }
-    }
+    ZDP_BuildUint8( &bld, (byte)(pSimpleDesc->AppDevVer & 0x0F) );
 
-    *pBuf++ = pSimpleDesc->AppNumOutClusters;
-    if ( pSimpleDesc->AppNumOutClusters )
-    {
-      for (i=0; i<pSimpleDesc->AppNumOutClusters; ++i)
-      {
-        *pBuf++ = LO_UINT16( pSimpleDesc->pAppOutClusterList[i] );
-        *pBuf++ = HI_UINT16( pSimpleDesc->pAppOutClusterList[i] );
-      }
-    }
+    ZDP_BuildClusterList( &bld, pSimpleDesc->AppNumInClusters, pSimpleDesc->pAppInClusterList );
+    ZDP_BuildClusterList( &bld, pSimpleDesc->AppNumOutClusters, pSimpleDesc->pAppOutClusterList );
   }
-
   else
   {
-    *pBuf = 0; // Description Length = 0;
+    ZDP_BuildUint8( &bld, 0 ); // Description Length = 0;
   }
 
-  return fillAndSend( &(inMsg->TransSeq), &(inMsg->srcAddr), Simple_Desc_rsp, len );
+  return ZDP_BuildSend( &bld, &(inMsg->TransSeq), &(inMsg->srcAddr), Simple_Desc_rsp, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1040,8 +1258,8 @@ afStatus_t ZDP_EPRsp( uint16_t MsgType, byte TransSeq, zAddrType_t *dstAddr,
                         uint8_t *pEPList,
                         byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len = 1 + 2 + 1;  // Status + nwkAddr + endpoint/interface count.
+  zdpBuilder_t bld;
+  uint16_t len = 1 + 2 + 1;  // Status + nwkAddr + endpoint/interface count.
   byte txOptions;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
@@ -1051,19 +1269,18 @@ afStatus_t ZDP_EPRsp( uint16_t MsgType, byte TransSeq, zAddrType_t *dstAddr,
   else
     txOptions = 0;
 
-    *pBuf++ = Status;
-  *pBuf++ = LO_UINT16( nwkAddr );
-  *pBuf++ = HI_UINT16( nwkAddr );
-
-  *pBuf++ = Count;   // Endpoint/Interface count
-
-  if ( Count )
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len + Count ) ) != ZSuccess )
   {
-    len += Count;
-    OsalPort_memcpy( pBuf, pEPList, Count );
+    return afStatus_MEM_FAIL;
   }
 
-  FillAndSendTxOptions( &TransSeq, dstAddr, MsgType, len, txOptions );
+  ZDP_BuildUint8( &bld, Status );
+  ZDP_BuildUint16( &bld, nwkAddr );
+
+  ZDP_BuildUint8( &bld, Count );   // Endpoint/Interface count
+  ZDP_BuildBuf( &bld, pEPList, Count );
+
+  return ZDP_BuildSend( &bld, &TransSeq, dstAddr, MsgType, txOptions );
 }
 
 /*********************************************************************
@@ -1083,22 +1300,21 @@ ZStatus_t ZDP_UserDescRsp( byte TransSeq, zAddrType_t *dstAddr,
                 uint16_t nwkAddrOfInterest, UserDescriptorFormat_t *userDesc,
                 byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len = 1 + 2 + 1;  // Status + nwkAddr + descriptor length.
+  // Status + nwkAddr + descriptor length + descriptor.
+  uint8_t buf[ZDP_BUILD_SIZE( 1 + 2 + 1 + AF_MAX_USER_DESCRIPTOR_LEN )];
+  zdpBuilder_t bld;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
-  len += userDesc->len;
-
-  *pBuf++ = ZSUCCESS;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
 
-  *pBuf++ = LO_UINT16( nwkAddrOfInterest );
-  *pBuf++ = HI_UINT16( nwkAddrOfInterest );
+  ZDP_BuildUint8( &bld, ZSUCCESS );
+  ZDP_BuildUint16( &bld, nwkAddrOfInterest );
 
-  *pBuf++ = userDesc->len;
-  OsalPort_memcpy( pBuf, userDesc->desc, userDesc->len );
+  ZDP_BuildUint8( &bld, userDesc->len );
+  ZDP_BuildBuf( &bld, userDesc->desc, userDesc->len );
 
-  return (ZStatus_t)fillAndSend( &TransSeq, dstAddr, User_Desc_rsp, len );
+  return (ZStatus_t)ZDP_BuildSend( &bld, &TransSeq, dstAddr, User_Desc_rsp, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1118,24 +1334,20 @@ ZStatus_t ZDP_UserDescRsp( byte TransSeq, zAddrType_t *dstAddr,
 ZStatus_t ZDP_ServerDiscRsp( byte transID, zAddrType_t *dstAddr, byte status,
                            uint16_t aoi, uint16_t serverMask, byte SecurityEnable )
 {
-  const byte len = 1  + 2;  // status + aoi + mask.
-  uint8_t *pBuf = ZDP_TmpBuf;
-  ZStatus_t stat;
+  uint8_t buf[ZDP_BUILD_SIZE( 1 + 2 )];  // status + mask.
+  zdpBuilder_t bld;
 
   // Intentionally unreferenced parameters
   (void)aoi;
   (void)SecurityEnable;
 
-  *pBuf++ = status;
-
-  *pBuf++ = LO_UINT16( serverMask );
-  *pBuf++ = HI_UINT16( serverMask );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
 
-  ZDP_TxOptions = AF_MSG_ACK_REQUEST;
-  stat = fillAndSend( &transID, dstAddr, Server_Discovery_rsp, len );
-  ZDP_TxOptions = AF_TX_OPTIONS_NONE;
+  ZDP_BuildUint8( &bld, status );
+  ZDP_BuildUint16( &bld, serverMask );
 
-  return ( stat );
+  return ( (ZStatus_t)ZDP_BuildSend( &bld, &transID, dstAddr, Server_Discovery_rsp,
+                                     AF_MSG_ACK_REQUEST ) );
 }
 
 /*********************************************************************
@@ -1158,19 +1370,20 @@ ZStatus_t ZDP_ServerDiscRsp( byte transID, zAddrType_t *dstAddr, byte status,
 afStatus_t ZDP_GenericRsp( byte TransSeq, zAddrType_t *dstAddr,
                      byte status, uint16_t aoi, uint16_t rspID, byte SecurityEnable )
 {
-  uint8_t len;
+  uint8_t buf[ZDP_BUILD_SIZE( 1 + 2 + 1 )];  // status + aoi + length.
+  zdpBuilder_t bld;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
-  ZDP_TmpBuf[0] = status;
-  ZDP_TmpBuf[1] = LO_UINT16( aoi );
-  ZDP_TmpBuf[2] = HI_UINT16( aoi );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+
+  ZDP_BuildUint8( &bld, status );
+  ZDP_BuildUint16( &bld, aoi );
 
   // Length byte
-  ZDP_TmpBuf[3] = 0;
-  len = 4;
+  ZDP_BuildUint8( &bld, 0 );
 
-  return fillAndSend( &TransSeq, dstAddr, rspID, len );
+  return ZDP_BuildSend( &bld, &TransSeq, dstAddr, rspID, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1209,9 +1422,8 @@ afStatus_t ZDP_EndDeviceBindReq( zAddrType_t *dstAddr,
                                  byte NumOutClusters, cId_t *OutClusterList,
                                  byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  uint8_t i, len;
-  uint8_t *ieeeAddr;
+  zdpBuilder_t bld;
+  uint16_t len;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
@@ -1219,42 +1431,24 @@ afStatus_t ZDP_EndDeviceBindReq( zAddrType_t *dstAddr,
   len = 2 + Z_EXTADDR_LEN + 1 + 2 + 1 + 1;
   len += (NumInClusters + NumOutClusters) * sizeof ( uint16_t );
 
-  if ( len >= ZDP_BUF_SZ-1 )
-  {
-    return afStatus_MEM_FAIL;
-  }
-
   if ( LocalCoordinator != NLME_GetShortAddr() )
   {
     return afStatus_INVALID_PARAMETER;
   }
 
-  *pBuf++ = LO_UINT16( LocalCoordinator );
-  *pBuf++ = HI_UINT16( LocalCoordinator );
-
-  ieeeAddr = NLME_GetExtAddr();
-  pBuf = osal_cpyExtAddr( pBuf, ieeeAddr );
-
-  *pBuf++ = endPoint;
-
-  *pBuf++ = LO_UINT16( ProfileID );   // Profile ID
-  *pBuf++ = HI_UINT16( ProfileID );
-
-  *pBuf++ = NumInClusters; // Input cluster list
-  for ( i = 0; i < NumInClusters; ++i )
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
   {
-    *pBuf++ = LO_UINT16(InClusterList[i]);
-    *pBuf++ = HI_UINT16(InClusterList[i]);
+    return afStatus_MEM_FAIL;
   }
 
-  *pBuf++ = NumOutClusters; // Output cluster list
-  for ( i = 0; i < NumOutClusters; ++i )
-  {
-    *pBuf++ = LO_UINT16(OutClusterList[i]);
-    *pBuf++ = HI_UINT16(OutClusterList[i]);
-  }
+  ZDP_BuildUint16( &bld, LocalCoordinator );
+  ZDP_BuildExtAddr( &bld, NLME_GetExtAddr() );
+  ZDP_BuildUint8( &bld, endPoint );
+  ZDP_BuildUint16( &bld, ProfileID );   // Profile ID
+  ZDP_BuildClusterList( &bld, NumInClusters, InClusterList );   // Input cluster list
+  ZDP_BuildClusterList( &bld, NumOutClusters, OutClusterList ); // Output cluster list
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, End_Device_Bind_req, len );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, End_Device_Bind_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1281,37 +1475,30 @@ afStatus_t ZDP_BindUnbindReq( uint16_t BindOrUnbind, zAddrType_t *dstAddr,
                               zAddrType_t *destinationAddr, byte DstEndPoint,
                               byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len;
+  // SourceAddr + SrcEPIntf + ClusterID + addrMode + DstAddr + DstEPIntf.
+  uint8_t buf[ZDP_BUILD_SIZE( Z_EXTADDR_LEN + 1 + sizeof( cId_t ) + 1 + Z_EXTADDR_LEN + 1 )];
+  zdpBuilder_t bld;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
-  // SourceAddr + SrcEPIntf + ClusterID +  addrMode.
-  len = Z_EXTADDR_LEN + 1 + sizeof( cId_t ) + sizeof( uint8_t );
-  if ( destinationAddr->addrMode == Addr64Bit )
-    len += Z_EXTADDR_LEN + 1;     // +1 for DstEPIntf
-  else if ( destinationAddr->addrMode == AddrGroup )
-    len += sizeof ( uint16_t );
-
-  pBuf = osal_cpyExtAddr( pBuf, SourceAddr );
-  *pBuf++ = SrcEndPoint;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
 
-  *pBuf++ = LO_UINT16( ClusterID );
+  ZDP_BuildExtAddr( &bld, SourceAddr );
+  ZDP_BuildUint8( &bld, SrcEndPoint );
+  ZDP_BuildUint16( &bld, ClusterID );
 
-  *pBuf++ = HI_UINT16( ClusterID );
-  *pBuf++ = destinationAddr->addrMode;
+  ZDP_BuildUint8( &bld, destinationAddr->addrMode );
   if ( destinationAddr->addrMode == Addr64Bit )
   {
-    pBuf = osal_cpyExtAddr( pBuf, destinationAddr->addr.extAddr );
-    *pBuf = DstEndPoint;
+    ZDP_BuildExtAddr( &bld, destinationAddr->addr.extAddr );
+    ZDP_BuildUint8( &bld, DstEndPoint );
   }
   else if ( destinationAddr->addrMode == AddrGroup )
   {
-    *pBuf++ = LO_UINT16( destinationAddr->addr.shortAddr );
-    *pBuf++ = HI_UINT16( destinationAddr->addr.shortAddr );
+    ZDP_BuildUint16( &bld, destinationAddr->addr.shortAddr );
   }
 
-  FillAndSendTxOptions( &ZDP_SeqNum, dstAddr, BindOrUnbind, len, AF_MSG_ACK_REQUEST );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, BindOrUnbind, AF_MSG_ACK_REQUEST );
 }
 
 /*********************************************************************
@@ -1338,17 +1525,18 @@ afStatus_t ZDP_MgmtNwkDiscReq( zAddrType_t *dstAddr,
                                byte StartIndex,
                                byte SecurityEnable )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len = sizeof( uint32_t )+1+1;  // ScanChannels + ScanDuration + StartIndex.
+  uint8_t buf[ZDP_BUILD_SIZE( sizeof( uint32_t )+1+1 )];  // ScanChannels + ScanDuration + StartIndex.
+  zdpBuilder_t bld;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
-  pBuf = OsalPort_bufferUint32( pBuf, ScanChannels );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
 
-  *pBuf++ = ScanDuration;
-  *pBuf = StartIndex;
+  ZDP_BuildUint32( &bld, ScanChannels );
+  ZDP_BuildUint8( &bld, ScanDuration );
+  ZDP_BuildUint8( &bld, StartIndex );
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, Mgmt_NWK_Disc_req, len );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, Mgmt_NWK_Disc_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1368,12 +1556,17 @@ afStatus_t ZDP_MgmtDirectJoinReq( zAddrType_t *dstAddr,
                                byte capInfo,
                                byte SecurityEnable )
 {
+  uint8_t buf[ZDP_BUILD_SIZE( Z_EXTADDR_LEN + 1 )];  // DeviceAddress + CapabilityInformation.
+  zdpBuilder_t bld;
+
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
-  osal_cpyExtAddr( ZDP_TmpBuf, deviceAddr );
-  ZDP_TmpBuf[Z_EXTADDR_LEN] = capInfo;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, Mgmt_Direct_Join_req, (Z_EXTADDR_LEN + 1) );
+  ZDP_BuildExtAddr( &bld, deviceAddr );
+  ZDP_BuildUint8( &bld, capInfo );
+
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, Mgmt_Direct_Join_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1390,11 +1583,15 @@ afStatus_t ZDP_MgmtDirectJoinReq( zAddrType_t *dstAddr,
 afStatus_t ZDP_MgmtPermitJoinReq( zAddrType_t *dstAddr, byte duration,
                                   byte TcSignificance, byte SecurityEnable )
 {
+  uint8_t buf[ZDP_BUILD_SIZE( ZDP_MGMT_PERMIT_JOIN_REQ_SIZE )];
+  zdpBuilder_t bld;
+
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
   // Build buffer
-  ZDP_TmpBuf[ZDP_MGMT_PERMIT_JOIN_REQ_DURATION] = duration;
-  ZDP_TmpBuf[ZDP_MGMT_PERMIT_JOIN_REQ_TC_SIG]   = TcSignificance;
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildUint8( &bld, duration );         // ZDP_MGMT_PERMIT_JOIN_REQ_DURATION
+  ZDP_BuildUint8( &bld, TcSignificance );   // ZDP_MGMT_PERMIT_JOIN_REQ_TC_SIG
 
   // Check of this is a broadcast message
   if ( ((dstAddr->addrMode == Addr16Bit) || (dstAddr->addrMode == AddrBroadcast))
@@ -1408,13 +1605,11 @@ afStatus_t ZDP_MgmtPermitJoinReq( zAddrType_t *dstAddr, byte duration,
     tmpAddr.addrMode = Addr16Bit;
     tmpAddr.addr.shortAddr = NLME_GetShortAddr();
 
-    fillAndSend( &ZDP_SeqNum, &tmpAddr, Mgmt_Permit_Join_req,
-                      ZDP_MGMT_PERMIT_JOIN_REQ_SIZE );
+    ZDP_BuildSend( &bld, &ZDP_SeqNum, &tmpAddr, Mgmt_Permit_Join_req, ZDP_TxOptions );
   }
 
-  // Send the message
-  return fillAndSend( &ZDP_SeqNum, dstAddr, Mgmt_Permit_Join_req,
-                      ZDP_MGMT_PERMIT_JOIN_REQ_SIZE );
+  // Send the message, the frame in buf is still intact
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, Mgmt_Permit_Join_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1435,21 +1630,27 @@ afStatus_t ZDP_MgmtLeaveReq( zAddrType_t *dstAddr, uint8_t *IEEEAddr, uint8_t Re
                  uint8_t Rejoin, uint8_t SecurityEnable )
 
 {
-  (void)SecurityEnable;  // Intentionally unreferenced parameter
+  uint8_t buf[ZDP_BUILD_SIZE( Z_EXTADDR_LEN + 1 )];  // DeviceAddress + options.
+  zdpBuilder_t bld;
+  uint8_t options = 0;
 
-  osal_cpyExtAddr( ZDP_TmpBuf, IEEEAddr );
-  ZDP_TmpBuf[Z_EXTADDR_LEN] = 0;
+  (void)SecurityEnable;  // Intentionally unreferenced parameter
 
   if ( RemoveChildren == TRUE )
   {
-    ZDP_TmpBuf[Z_EXTADDR_LEN] |= ZDP_MGMT_LEAVE_REQ_RC;
+    options |= ZDP_MGMT_LEAVE_REQ_RC;
   }
   if ( Rejoin == TRUE )
   {
-    ZDP_TmpBuf[Z_EXTADDR_LEN] |= ZDP_MGMT_LEAVE_REQ_REJOIN;
+    options |= ZDP_MGMT_LEAVE_REQ_REJOIN;
   }
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, Mgmt_Leave_req, (Z_EXTADDR_LEN + 1) );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+
+  ZDP_BuildExtAddr( &bld, IEEEAddr );
+  ZDP_BuildUint8( &bld, options );
+
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, Mgmt_Leave_req, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1475,37 +1676,32 @@ afStatus_t ZDP_MgmtNwkUpdateReq( zAddrType_t *dstAddr,
                                  uint8_t NwkUpdateId,
                                  uint16_t NwkManagerAddr )
 {
-  uint8_t *pBuf = ZDP_TmpBuf;
-  byte len = sizeof( uint32_t ) + 1;  // ChannelMask + ScanDuration
+  // ChannelMask + ScanDuration + NwkUpdateId + NwkManagerAddr
+  uint8_t buf[ZDP_BUILD_SIZE( sizeof( uint32_t ) + 1 + 1 + sizeof( uint16_t ) )];
+  zdpBuilder_t bld;
 
-  pBuf = OsalPort_bufferUint32( pBuf, ChannelMask );
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
 
-  *pBuf++ = ScanDuration;
+  ZDP_BuildUint32( &bld, ChannelMask );
+  ZDP_BuildUint8( &bld, ScanDuration );
 
   if ( ScanDuration <= 0x05 )
   {
     // Request is to scan over channelMask
-    len += sizeof( uint8_t );
-
-    *pBuf++ = ScanCount;
+    ZDP_BuildUint8( &bld, ScanCount );
   }
   else if ( ( ScanDuration == 0xFE ) || ( ScanDuration == 0xFF ) )
   {
     // Request is to change Channel (0xFE) or apsChannelMask and NwkManagerAddr (0xFF)
-    len += sizeof( uint8_t );
-
-    *pBuf++ = NwkUpdateId;
+    ZDP_BuildUint8( &bld, NwkUpdateId );
 
     if ( ScanDuration == 0xFF )
     {
-      len += sizeof( uint16_t );
-
-      *pBuf++  = LO_UINT16( NwkManagerAddr );
-      *pBuf++  = HI_UINT16( NwkManagerAddr );
+      ZDP_BuildUint16( &bld, NwkManagerAddr );
     }
   }
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, Mgmt_NWK_Update_req, len );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, Mgmt_NWK_Update_req, ZDP_TxOptions );
 }
 
 
@@ -1539,52 +1735,41 @@ afStatus_t ZDP_MgmtNwkDiscRsp( byte TransSeq, zAddrType_t *dstAddr,
                             networkDesc_t *NetworkList,
                             byte SecurityEnable )
 {
-  uint8_t *buf;
-  uint8_t *pBuf;
-  byte len = 1+1+1+1;  // Status + NetworkCount + StartIndex + NetworkCountList.
+  zdpBuilder_t bld;
+  uint16_t len = 1+1+1+1;  // Status + NetworkCount + StartIndex + NetworkCountList.
   byte idx;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
   len += (NetworkListCount * ( ZDP_NETWORK_EXTENDED_DISCRIPTOR_SIZE - 2 ));
 
-  buf = OsalPort_malloc( len+1 );
-  if ( buf == NULL )
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
   {
     return afStatus_MEM_FAIL;
   }
 
-  pBuf = buf+1;
-
-  *pBuf++ = Status;
-  *pBuf++ = NetworkCount;
-  *pBuf++ = StartIndex;
-  *pBuf++ = NetworkListCount;
+  ZDP_BuildUint8( &bld, Status );
+  ZDP_BuildUint8( &bld, NetworkCount );
+  ZDP_BuildUint8( &bld, StartIndex );
+  ZDP_BuildUint8( &bld, NetworkListCount );
 
   for ( idx = 0; idx < NetworkListCount; idx++ )
   {
-    osal_cpyExtAddr( pBuf, NetworkList->extendedPANID);
-    pBuf += Z_EXTADDR_LEN;
+    ZDP_BuildExtAddr( &bld, NetworkList->extendedPANID );
 
-    *pBuf++  = NetworkList->logicalChannel;                // LogicalChannel
-    *pBuf    = NetworkList->stackProfile;                  // Stack profile
-    *pBuf++ |= (byte)(NetworkList->version << 4);          // ZigBee Version
-    *pBuf    = BEACON_ORDER_NO_BEACONS;                    // Beacon Order
-    *pBuf++ |= (uint8_t)(BEACON_ORDER_NO_BEACONS << 4);      // Superframe Order
+    ZDP_BuildUint8( &bld, NetworkList->logicalChannel );               // LogicalChannel
+    ZDP_BuildUint8( &bld, (byte)(NetworkList->stackProfile             // Stack profile
+                                 | (NetworkList->version << 4)) );     // ZigBee Version
+    ZDP_BuildUint8( &bld, (uint8_t)(BEACON_ORDER_NO_BEACONS            // Beacon Order
+                                    | (BEACON_ORDER_NO_BEACONS << 4)) ); // Superframe Order
 
-    if ( NetworkList->chosenRouter != INVALID_NODE_ADDR )
-    {
-      *pBuf++ = TRUE;                         // Permit Joining
-    }
-    else
-    {
-      *pBuf++ = FALSE;
-    }
+    // Permit Joining
+    ZDP_BuildUint8( &bld, (NetworkList->chosenRouter != INVALID_NODE_ADDR) ? TRUE : FALSE );
 
     NetworkList = NetworkList->nextDesc;    // Move to next list entry
   }
 
-  FillAndSendBuffer( &TransSeq, dstAddr, Mgmt_NWK_Disc_rsp, len, buf );
+  return ZDP_BuildSend( &bld, &TransSeq, dstAddr, Mgmt_NWK_Disc_rsp, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1614,68 +1799,53 @@ ZStatus_t ZDP_MgmtLqiRsp( byte TransSeq, zAddrType_t *dstAddr,
                           byte SecurityEnable )
 {
   ZDP_MgmtLqiItem_t* list = NeighborList;
-  uint8_t *buf, *pBuf;
-  byte len, x;
+  uint8_t statusBuf[ZDP_BUILD_SIZE( 1 )];
+  zdpBuilder_t bld;
+  uint16_t len;
+  byte x;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
   if ( ZSuccess != Status )
   {
-    ZDP_TmpBuf[0] = Status;
-    return fillAndSend( &TransSeq, dstAddr, Mgmt_Lqi_rsp, 1 );
+    ZDP_BuildInit( &bld, statusBuf, sizeof( statusBuf ) );
+    ZDP_BuildUint8( &bld, Status );
+    return ZDP_BuildSend( &bld, &TransSeq, dstAddr, Mgmt_Lqi_rsp, ZDP_TxOptions );
   }
 
   // (Status + NeighborLqiEntries + StartIndex + NeighborLqiCount) +
   //  neighbor LQI data.
   len = (1 + 1 + 1 + 1) + (NeighborLqiCount * ZDP_MGMTLQI_EXTENDED_SIZE);
 
-  buf = OsalPort_malloc( len+1 );
-  if ( buf == NULL )
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
   {
     return afStatus_MEM_FAIL;
   }
 
-  pBuf = buf+1;
-
-  *pBuf++ = Status;
-  *pBuf++ = NeighborLqiEntries;
-  *pBuf++ = StartIndex;
-  *pBuf++ = NeighborLqiCount;
+  ZDP_BuildUint8( &bld, Status );
+  ZDP_BuildUint8( &bld, NeighborLqiEntries );
+  ZDP_BuildUint8( &bld, StartIndex );
+  ZDP_BuildUint8( &bld, NeighborLqiCount );
 
   for ( x = 0; x < NeighborLqiCount; x++ )
   {
-    osal_cpyExtAddr( pBuf, list->extPanID);         // Extended PanID
-    pBuf += Z_EXTADDR_LEN;
-
-    // EXTADDR
-    pBuf = osal_cpyExtAddr( pBuf, list->extAddr );
+    ZDP_BuildExtAddr( &bld, list->extPanID );   // Extended PanID
+    ZDP_BuildExtAddr( &bld, list->extAddr );    // EXTADDR
+    ZDP_BuildUint16( &bld, list->nwkAddr );     // NWKADDR
 
-    // NWKADDR
-    *pBuf++ = LO_UINT16( list->nwkAddr );
-    *pBuf++ = HI_UINT16( list->nwkAddr );
+    // DEVICETYPE, RXONIDLE and RELATIONSHIP
+    ZDP_BuildUint8( &bld, (uint8_t)(list->devType
+                                    | (list->rxOnIdle << 2)
+                                    | (list->relation << 4)) );
 
-    // DEVICETYPE
-    *pBuf = list->devType;
-
-    // RXONIDLE
-    *pBuf |= (uint8_t)(list->rxOnIdle << 2);
-
-    // RELATIONSHIP
-    *pBuf++ |= (uint8_t)(list->relation << 4);
-
-    // PERMITJOINING
-    *pBuf++ = (uint8_t)(list->permit);
-
-    // DEPTH
-    *pBuf++ = list->depth;
-
-    // LQI
-    *pBuf++ = list->lqi;
+    ZDP_BuildUint8( &bld, (uint8_t)(list->permit) );  // PERMITJOINING
+    ZDP_BuildUint8( &bld, list->depth );              // DEPTH
+    ZDP_BuildUint8( &bld, list->lqi );                // LQI
 
     list++; // next list entry
   }
 
-  FillAndSendBuffer( &TransSeq, dstAddr, Mgmt_Lqi_rsp, len, buf );
+  return ZDP_BuildSend( &bld, &TransSeq, dstAddr, Mgmt_Lqi_rsp, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1703,10 +1873,9 @@ ZStatus_t ZDP_MgmtRtgRsp( byte TransSeq, zAddrType_t *dstAddr,
                             rtgItem_t *RoutingTableList,
                             byte SecurityEnable )
 {
-  uint8_t *buf;
-  uint8_t *pBuf;
+  zdpBuilder_t bld;
   // Status + RoutingTableEntries + StartIndex + RoutingListCount.
-  byte len = 1 + 1 + 1 + 1;
+  uint16_t len = 1 + 1 + 1 + 1;
   byte x;
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
@@ -1714,25 +1883,22 @@ ZStatus_t ZDP_MgmtRtgRsp( byte TransSeq, zAddrType_t *dstAddr,
   // Add an array for Routing List data
   len += (RoutingListCount * ZDP_ROUTINGENTRY_SIZE);
 
-  buf = OsalPort_malloc( (short)(len+1) );
-  if ( buf == NULL )
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
   {
     return afStatus_MEM_FAIL;
   }
 
-  pBuf = buf+1;
-
-  *pBuf++ = Status;
-  *pBuf++ = RoutingTableEntries;
-  *pBuf++ = StartIndex;
-  *pBuf++ = RoutingListCount;
+  ZDP_BuildUint8( &bld, Status );
+  ZDP_BuildUint8( &bld, RoutingTableEntries );
+  ZDP_BuildUint8( &bld, StartIndex );
+  ZDP_BuildUint8( &bld, RoutingListCount );
 
   for ( x = 0; x < RoutingListCount; x++ )
   {
-    *pBuf++ = LO_UINT16( RoutingTableList->dstAddress );  // Destination Address
-    *pBuf++ = HI_UINT16( RoutingTableList->dstAddress );
+    uint8_t status = (RoutingTableList->status & 0x07);
+
+    ZDP_BuildUint16( &bld, RoutingTableList->dstAddress );  // Destination Address
 
-    *pBuf = (RoutingTableList->status & 0x07);
     if ( RoutingTableList->options & (ZP_MTO_ROUTE_RC | ZP_MTO_ROUTE_NRC) )
     {
       uint8_t options = 0;
@@ -1748,16 +1914,15 @@ ZStatus_t ZDP_MgmtRtgRsp( byte TransSeq, zAddrType_t *dstAddr,
         options |= ZDO_MGMT_RTG_ENTRY_MEMORY_CONSTRAINED;
       }
 
-      *pBuf |= (options << 3);
+      status |= (options << 3);
     }
-    pBuf++;
+    ZDP_BuildUint8( &bld, status );
 
-    *pBuf++ = LO_UINT16( RoutingTableList->nextHopAddress );  // Next hop
-    *pBuf++ = HI_UINT16( RoutingTableList->nextHopAddress );
+    ZDP_BuildUint16( &bld, RoutingTableList->nextHopAddress );  // Next hop
     RoutingTableList++;    // Move to next list entry
   }
 
-  FillAndSendBuffer( &TransSeq, dstAddr, Mgmt_Rtg_rsp, len, buf );
+  return ZDP_BuildSend( &bld, &TransSeq, dstAddr, Mgmt_Rtg_rsp, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1785,65 +1950,50 @@ ZStatus_t ZDP_MgmtBindRsp( byte TransSeq, zAddrType_t *dstAddr,
                             apsBindingItem_t *BindingTableList,
                             byte SecurityEnable )
 {
-  uint8_t *buf;
-  uint8_t *pBuf;
-  uint8_t maxLen; // maxLen is the maximum packet length to allocate enough memory space
-  uint8_t len;    // Actual length varies due to different addrMode
+  zdpBuilder_t bld;
+  uint16_t maxLen; // maxLen is the maximum packet length to allocate enough memory space
   uint8_t x;
   byte extZdpBindEntrySize = ZDP_BINDINGENTRY_SIZE + 1 + 1; // One more byte for cluserID and DstAddrMode
-  byte shortZdpBindEntrySize = ZDP_BINDINGENTRY_SIZE + 1 + 1 + 2 - 8 - 1; // clusterID + DstAddrMode + shortAddr - ExtAddr - DstEndpoint
 
   (void)SecurityEnable;  // Intentionally unreferenced parameter
 
   // Status + BindingTableEntries + StartIndex + BindingTableListCount.
   maxLen = 1 + 1 + 1 + 1;
   maxLen += (BindingTableListCount * extZdpBindEntrySize );  //max length
-  buf = OsalPort_malloc( maxLen + 1 );  // +1 for transaction ID
 
-  if ( buf == NULL )
+  // Actual length varies due to different addrMode, the builder tracks it
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( maxLen ) ) != ZSuccess )
   {
     return afStatus_MEM_FAIL;
   }
 
-  pBuf = buf+1;
+  ZDP_BuildUint8( &bld, Status );
+  ZDP_BuildUint8( &bld, BindingTableEntries );
+  ZDP_BuildUint8( &bld, StartIndex );
+  ZDP_BuildUint8( &bld, BindingTableListCount );
 
-  *pBuf++ = Status;
-  *pBuf++ = BindingTableEntries;
-  *pBuf++ = StartIndex;
-  *pBuf++ = BindingTableListCount;
-
-  // Initial length = Status + BindingTableEntries + StartIndex + BindingTableListCount.
-  // length += ZDP_BINDINGENTRY_SIZE   -- Version 1.0
-  //           extZdpBindEntrySize     -- Version 1.1 extended address mode
-  //           shortZdpBindEntrySize   -- Version 1.1 group address mode
-
-  len = 1 + 1 + 1 + 1;
   for ( x = 0; x < BindingTableListCount; x++ )
   {
-    pBuf = osal_cpyExtAddr( pBuf, BindingTableList->srcAddr );
-    *pBuf++ = BindingTableList->srcEP;
+    ZDP_BuildExtAddr( &bld, BindingTableList->srcAddr );
+    ZDP_BuildUint8( &bld, BindingTableList->srcEP );
 
     // Cluster ID
-    *pBuf++ = LO_UINT16( BindingTableList->clusterID );
-    *pBuf++ = HI_UINT16( BindingTableList->clusterID );
+    ZDP_BuildUint16( &bld, BindingTableList->clusterID );
 
-    *pBuf++ = BindingTableList->dstAddr.addrMode;
+    ZDP_BuildUint8( &bld, BindingTableList->dstAddr.addrMode );
     if ( BindingTableList->dstAddr.addrMode == Addr64Bit )
     {
-      len += extZdpBindEntrySize;
-      pBuf = osal_cpyExtAddr( pBuf, BindingTableList->dstAddr.addr.extAddr );
-      *pBuf++ = BindingTableList->dstEP;
+      ZDP_BuildExtAddr( &bld, BindingTableList->dstAddr.addr.extAddr );
+      ZDP_BuildUint8( &bld, BindingTableList->dstEP );
     }
     else
     {
-      len += shortZdpBindEntrySize;
-      *pBuf++ = LO_UINT16( BindingTableList->dstAddr.addr.shortAddr );
-      *pBuf++ = HI_UINT16( BindingTableList->dstAddr.addr.shortAddr );
+      ZDP_BuildUint16( &bld, BindingTableList->dstAddr.addr.shortAddr );
     }
     BindingTableList++;    // Move to next list entry
   }
 
-  FillAndSendBuffer( &TransSeq, dstAddr, Mgmt_Bind_rsp, len, buf );
+  return ZDP_BuildSend( &bld, &TransSeq, dstAddr, Mgmt_Bind_rsp, ZDP_TxOptions );
 }
 
 /*********************************************************************
@@ -1871,39 +2021,27 @@ afStatus_t ZDP_MgmtNwkUpdateNotify( uint8_t TransSeq, zAddrType_t *dstAddr,
                                     uint8_t listCount, uint8_t *energyValues, uint8_t txOptions,
                                     uint8_t securityEnable )
 {
-  uint8_t *buf;
-  uint8_t *pBuf;
-  uint8_t len;
+  zdpBuilder_t bld;
+  uint16_t len;
 
   (void)securityEnable;  // Intentionally unreferenced parameter
 
   // Status + ScannedChannels + totalTransmissions + transmissionFailures + ListCount + energyValues
   len = 1 + 4 + 2 + 2 + 1 + listCount;
 
-  buf = OsalPort_malloc( len+1 ); // +1 for transaction ID
-  if ( buf == NULL )
+  if ( ZDP_BuildInit( &bld, NULL, ZDP_BUILD_SIZE( len ) ) != ZSuccess )
   {
     return afStatus_MEM_FAIL;
   }
 
-  pBuf = buf+1;
-
-  *pBuf++ = status;
-
-  pBuf = OsalPort_bufferUint32( pBuf, scannedChannels );
-
-  *pBuf++ = LO_UINT16( totalTransmissions );
-  *pBuf++ = HI_UINT16( totalTransmissions );
-
-  *pBuf++ = LO_UINT16( transmissionFailures );
-  *pBuf++ = HI_UINT16( transmissionFailures );
+  ZDP_BuildUint8( &bld, status );
+  ZDP_BuildUint32( &bld, scannedChannels );
+  ZDP_BuildUint16( &bld, totalTransmissions );
+  ZDP_BuildUint16( &bld, transmissionFailures );
+  ZDP_BuildUint8( &bld, listCount );
+  ZDP_BuildBuf( &bld, energyValues, listCount );
 
-  *pBuf++ = listCount;
-
-  if ( listCount > 0 )
-    OsalPort_memcpy( pBuf, energyValues, listCount );
-
-  FillAndSendBufferTxOptions( &TransSeq, dstAddr, Mgmt_NWK_Update_notify, len, buf, txOptions );
+  return ZDP_BuildSend( &bld, &TransSeq, dstAddr, Mgmt_NWK_Update_notify, txOptions );
 }
 
 /*********************************************************************
@@ -1955,6 +2093,7 @@ ZStatus_t ZDO_RegisterForZDOMsg( uint8_t taskID, uint16_t clusterID )
     }
     else
       zdoMsgCBs = pNew;
+    zdoMsgCBsBuildIndex();
     return ( ZSuccess );
   }
   else
@@ -1998,6 +2137,7 @@ ZStatus_t ZDO_RemoveRegisteredCB( uint8_t taskID, uint16_t clusterID )
         zdoMsgCBs = (ZDO_MsgCB_t *)NULL;
       }
       OsalPort_free( pList );
+      zdoMsgCBsBuildIndex();
       return ( ZSuccess );
     }
     pLast = pList;
@@ -2007,11 +2147,132 @@ ZStatus_t ZDO_RemoveRegisteredCB( uint8_t taskID, uint16_t clusterID )
   return ( ZFailure );
 }
 
+/*********************************************************************
+ * @fn          zdoMsgCBsBuildIndex
+ *
+ * @brief       Rebuild the per-cluster subscriber bitmaps from the
+ *              registration list.  ZDO_ALL_MSGS_CLUSTERID subscribers
+ *              are folded into every response and Device_annce.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void zdoMsgCBsBuildIndex( void )
+{
+  ZDO_MsgCB_t *pList = zdoMsgCBs;
+  uint16_t allMap = 0;
+  uint8_t x;
+
+  memset( zdoMsgCBsMap, 0, sizeof( zdoMsgCBsMap ) );
+  zdoMsgCBsUnindexed = FALSE;
+
+  while ( pList )
+  {
+    if ( pList->taskID >= ZDO_CB_TASKS_MAX )
+    {
+      zdoMsgCBsUnindexed = TRUE;
+    }
+    else if ( pList->clusterID == ZDO_ALL_MSGS_CLUSTERID )
+    {
+      allMap |= BV( pList->taskID );
+    }
+    else if ( ZDO_CLUSTER_INDEXABLE( pList->clusterID ) )
+    {
+      zdoMsgCBsMap[ZDO_CLUSTER_IDX( pList->clusterID )] |= BV( pList->taskID );
+    }
+    else
+    {
+      zdoMsgCBsUnindexed = TRUE;
+    }
+    pList = (ZDO_MsgCB_t *)pList->next;
+  }
+
+  if ( allMap )
+  {
+    for ( x = ZDO_CLUSTER_IDX( ZDO_RESPONSE_BIT ); x < ZDO_CLUSTER_IDX_CNT; x++ )
+    {
+      zdoMsgCBsMap[x] |= allMap;
+    }
+    zdoMsgCBsMap[ZDO_CLUSTER_IDX( Device_annce )] |= allMap;
+  }
+}
+
+/*********************************************************************
+ * @fn          zdpMsgProcsBuildIndex
+ *
+ * @brief       Map each cluster index to its zdpMsgProcs[] entry.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void zdpMsgProcsBuildIndex( void )
+{
+  uint8_t x = 0;
+
+  memset( zdpMsgProcIdx, ZDO_CLUSTER_IDX_NONE, sizeof( zdpMsgProcIdx ) );
+
+  while ( zdpMsgProcs[x].clusterID != 0xFFFF )
+  {
+    if ( ZDO_CLUSTER_INDEXABLE( zdpMsgProcs[x].clusterID ) )
+    {
+      zdpMsgProcIdx[ZDO_CLUSTER_IDX( zdpMsgProcs[x].clusterID )] = x;
+    }
+    x++;
+  }
+
+  zdpMsgProcIdxReady = TRUE;
+}
+
+/*********************************************************************
+ * @fn          zdoSendMsgCB
+ *
+ * @brief       Send an incoming message to one registered task.  The
+ *              message is built on the first call and shared after.
+ *
+ * @param       taskID - task to deliver to
+ * @param       inMsg - incoming message
+ * @param       ppMsg - in/out shared ZDO_CB_MSG
+ *
+ * @return      TRUE if sent, FALSE if not
+ */
+static uint8_t zdoSendMsgCB( uint8_t taskID, zdoIncomingMsg_t *inMsg, zdoIncomingMsg_t **ppMsg )
+{
+  zdoIncomingMsg_t *msgPtr = *ppMsg;
+
+  if ( msgPtr == NULL )
+  {
+    msgPtr = (zdoIncomingMsg_t *)OsalPort_msgAllocate( sizeof( zdoIncomingMsg_t ) + inMsg->asduLen );
+    if ( msgPtr == NULL )
+    {
+      return ( FALSE );
+    }
+
+    // copy struct
+    OsalPort_memcpy( msgPtr, inMsg, sizeof( zdoIncomingMsg_t ));
+
+    if ( inMsg->asduLen )
+    {
+      msgPtr->asdu = (byte*)(((byte*)msgPtr) + sizeof( zdoIncomingMsg_t ));
+      OsalPort_memcpy( msgPtr->asdu, inMsg->asdu, inMsg->asduLen );
+    }
+
+    msgPtr->hdr.event = ZDO_CB_MSG;
+    *ppMsg = msgPtr;
+  }
+
+  // Send the address to the task
+  return ( OsalPort_msgSendShared( taskID, (uint8_t *)msgPtr ) == OsalPort_SUCCESS );
+}
+
 /*********************************************************************
  * @fn          ZDO_SendMsgCBs
  *
  * @brief       This function sends messages to registered tasks.
  *              Local to ZDO and shouldn't be called outside of ZDO.
+ *              A single read-only copy of the message is shared by
+ *              all subscribers, and each indexed task gets it once.
  *
  * @param       inMsg - incoming message
  *
@@ -2020,35 +2281,45 @@ ZStatus_t ZDO_RemoveRegisteredCB( uint8_t taskID, uint16_t clusterID )
 uint8_t ZDO_SendMsgCBs( zdoIncomingMsg_t *inMsg )
 {
   uint8_t ret = FALSE;
-  ZDO_MsgCB_t *pList = zdoMsgCBs;
-  while ( pList )
+  zdoIncomingMsg_t *msgPtr = NULL;
+
+  if ( !zdoMsgCBsUnindexed && ZDO_CLUSTER_INDEXABLE( inMsg->clusterID ) )
   {
-    if ( (pList->clusterID == inMsg->clusterID)
-       || ((pList->clusterID == ZDO_ALL_MSGS_CLUSTERID)
-           && ((inMsg->clusterID & ZDO_RESPONSE_BIT) || (inMsg->clusterID == Device_annce))) )
-    {
-      zdoIncomingMsg_t *msgPtr;
+    uint16_t taskMap = zdoMsgCBsMap[ZDO_CLUSTER_IDX( inMsg->clusterID )];
+    uint8_t taskID;
 
-      // Send the address to the task
-      msgPtr = (zdoIncomingMsg_t *)OsalPort_msgAllocate( sizeof( zdoIncomingMsg_t ) + inMsg->asduLen );
-      if ( msgPtr )
+    for ( taskID = 0; taskMap != 0; taskID++, taskMap >>= 1 )
+    {
+      if ( (taskMap & 0x0001) && zdoSendMsgCB( taskID, inMsg, &msgPtr ) )
       {
-        // copy struct
-        OsalPort_memcpy( msgPtr, inMsg, sizeof( zdoIncomingMsg_t ));
-
-        if ( inMsg->asduLen )
+        ret = TRUE;
+      }
+    }
+  }
+  else
+  {
+    ZDO_MsgCB_t *pList = zdoMsgCBs;
+    while ( pList )
+    {
+      if ( (pList->clusterID == inMsg->clusterID)
+         || ((pList->clusterID == ZDO_ALL_MSGS_CLUSTERID)
+             && ((inMsg->clusterID & ZDO_RESPONSE_BIT) || (inMsg->clusterID == Device_annce))) )
+      {
+        if ( zdoSendMsgCB( pList->taskID, inMsg, &msgPtr ) )
         {
-          msgPtr->asdu = (byte*)(((byte*)msgPtr) + sizeof( zdoIncomingMsg_t ));
-          OsalPort_memcpy( msgPtr->asdu, inMsg->asdu, inMsg->asduLen );
+          ret = TRUE;
         }
-
-        msgPtr->hdr.event = ZDO_CB_MSG;
-        OsalPort_msgSend( pList->taskID, (uint8_t *)msgPtr );
-        ret = TRUE;
       }
+      pList = (ZDO_MsgCB_t *)pList->next;
     }
-    pList = (ZDO_MsgCB_t *)pList->next;
   }
+
+  if ( msgPtr != NULL )
+  {
+    // Release the reference held while sending
+    OsalPort_msgDeallocate( (uint8_t *)msgPtr );
+  }
+
   return ( ret );
 }
 
@@ -2084,6 +2355,14 @@ void ZDP_IncomingData( afIncomingMSGPacket_t *pData )
   inMsg.macDestAddr = pData->macDestAddr;
   inMsg.macSrcAddr = pData->macSrcAddr;
 
+  if ( (inMsg.clusterID == Node_Desc_rsp) && (inMsg.asduLen >= 8)
+      && (inMsg.asdu[0] == ZDP_SUCCESS) )
+  {
+    // Manufacturer code of the node descriptor, for the host loaded quirks
+    ZQuirkSetManufCode( BUILD_UINT16( inMsg.asdu[1], inMsg.asdu[2] ),
+                        BUILD_UINT16( inMsg.asdu[6], inMsg.asdu[7] ) );
+  }
+
   handled = ZDO_SendMsgCBs( &inMsg );
 
 #if (defined MT_ZDO_CB_FUNC)
@@ -2095,14 +2374,31 @@ void ZDP_IncomingData( afIncomingMSGPacket_t *pData )
   }
 #endif
 
-  while ( zdpMsgProcs[x].clusterID != 0xFFFF )
+  if ( ZDO_CLUSTER_INDEXABLE( inMsg.clusterID ) )
   {
-    if ( zdpMsgProcs[x].clusterID == inMsg.clusterID )
+    if ( !zdpMsgProcIdxReady )
+    {
+      zdpMsgProcsBuildIndex();
+    }
+
+    x = zdpMsgProcIdx[ZDO_CLUSTER_IDX( inMsg.clusterID )];
+    if ( x != ZDO_CLUSTER_IDX_NONE )
     {
       zdpMsgProcs[x].pFn( &inMsg );
       return;
     }
-    x++;
+  }
+  else
+  {
+    while ( zdpMsgProcs[x].clusterID != 0xFFFF )
+    {
+      if ( zdpMsgProcs[x].clusterID == inMsg.clusterID )
+      {
+        zdpMsgProcs[x].pFn( &inMsg );
+        return;
+      }
+      x++;
+    }
   }
 
   // Handle unhandled messages
@@ -2125,13 +2421,13 @@ void ZDP_IncomingData( afIncomingMSGPacket_t *pData )
 afStatus_t ZDP_InvalidCmdReq( zAddrType_t *dstAddr )
 
 {
-  uint8_t index;
-  for(index = 0; index < ZDO_INVALID_CMD_LEN; index++)
-  {
-      ZDP_TmpBuf[index] = 0;
-  }
+  uint8_t buf[ZDP_BUILD_SIZE( ZDO_INVALID_CMD_LEN )];
+  zdpBuilder_t bld;
+
+  ZDP_BuildInit( &bld, buf, sizeof( buf ) );
+  ZDP_BuildFill( &bld, 0, ZDO_INVALID_CMD_LEN );
 
-  return fillAndSend( &ZDP_SeqNum, dstAddr, ZDO_invalid_cmd_req, ZDO_INVALID_CMD_LEN );
+  return ZDP_BuildSend( &bld, &ZDP_SeqNum, dstAddr, ZDO_invalid_cmd_req, ZDP_TxOptions );
 }
 
 #endif
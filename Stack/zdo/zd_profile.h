@@ -284,6 +284,24 @@ typedef struct
   uint16_t *outClusters;
 } ZDEndDeviceBind_t;
 
+// Length-checked writer for an outgoing ZDP frame.  The frame is built
+// in place, in a caller's buffer or one allocated by ZDP_BuildInit(),
+// so frames can be built from more than one context at a time.
+typedef struct
+{
+  uint8_t  *pBuf;      // Frame, transaction sequence number first
+  uint16_t size;       // Buffer size
+  uint16_t len;        // Bytes written, including the sequence number
+  uint8_t  status;     // ZSuccess, ZBufferFull once a field didn't fit
+  uint8_t  allocated;  // TRUE if pBuf is released by the builder
+} zdpBuilder_t;
+
+// Transaction sequence number in front of every ZDP frame
+#define ZDP_BUILD_HDR_LEN           1
+
+// Buffer size for a ZDP frame with len bytes of payload
+#define ZDP_BUILD_SIZE( len )       ( (len) + ZDP_BUILD_HDR_LEN )
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -295,6 +313,39 @@ extern byte ZDP_TxOptions;
  * MACROS
  */
 
+/*
+ * ZDP frame builder - start a frame in pBuf, or an allocated buffer
+ * when pBuf is NULL.
+ */
+extern ZStatus_t ZDP_BuildInit( zdpBuilder_t *pBld, uint8_t *pBuf, uint16_t size );
+
+/*
+ * ZDP frame builder - claim len bytes of the frame, NULL if they don't fit
+ */
+extern uint8_t *ZDP_BuildReserve( zdpBuilder_t *pBld, uint16_t len );
+
+/*
+ * ZDP frame builder - append fields, in over the air byte order
+ */
+extern void ZDP_BuildUint8( zdpBuilder_t *pBld, uint8_t value );
+extern void ZDP_BuildUint16( zdpBuilder_t *pBld, uint16_t value );
+extern void ZDP_BuildUint32( zdpBuilder_t *pBld, uint32_t value );
+extern void ZDP_BuildExtAddr( zdpBuilder_t *pBld, uint8_t *pExtAddr );
+extern void ZDP_BuildBuf( zdpBuilder_t *pBld, uint8_t *pData, uint16_t len );
+extern void ZDP_BuildFill( zdpBuilder_t *pBld, uint8_t value, uint16_t len );
+extern void ZDP_BuildClusterList( zdpBuilder_t *pBld, uint8_t numClusters, cId_t *pClusterList );
+
+/*
+ * ZDP frame builder - send the frame and release an allocated buffer
+ */
+extern afStatus_t ZDP_BuildSend( zdpBuilder_t *pBld, uint8_t *transSeq, zAddrType_t *dstAddr,
+                                 cId_t clusterID, uint8_t txOptions );
+
+/*
+ * ZDP frame builder - release an allocated buffer without sending
+ */
+extern void ZDP_BuildFree( zdpBuilder_t *pBld );
+
 /*
  * Generic data send function
  */
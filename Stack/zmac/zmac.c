@@ -62,6 +62,7 @@
 #include "zglobals.h"
 #endif
 #include "mac_api.h"
+#include "mac_user_config.h"
 
 /********************************************************************************************************
  *                                                 MACROS
@@ -78,6 +79,15 @@
   #define MAX_ED_THRESHOLD 0xEB
 #endif
 
+// Smoothed RSSI of a destination that has not been heard yet
+#define ZMAC_TPC_RSSI_UNKNOWN  (-128)
+
+// Short address of a free transmit power control entry
+#define ZMAC_TPC_ADDR_FREE     0xFFFE
+
+// Highest unicast short address
+#define ZMAC_TPC_ADDR_MAX      0xFFF7
+
 // TBD: these need to be set to the 2.4G settings
 #define DEFAULT_PHYID 0
 #define DEFAULT_CHANNELPAGE 0
@@ -90,6 +100,8 @@ uint32_t _ScanChannels;
 
 extern uint8_t aExtendedAddress[];
 
+extern RF_TxPowerTable_Entry *pRfPowerTable;
+
 static void convertCapInfo(ApiMac_capabilityInfo_t *pDst, uint8_t srcCapInfo);
 static void convertToTxOptions(ApiMac_txOptions_t *pDst, uint16_t srcTxOptions);
 
@@ -136,10 +148,35 @@ extern void MAP_macMgmtReset(void);
  *                                               LOCALS
  ********************************************************************************************************/
 
+// Per-destination transmit power control state
+typedef struct
+{
+  uint16_t shortAddr;   // ZMAC_TPC_ADDR_FREE when the entry is free
+  int8_t   rssi;        // Smoothed RSSI of frames received from the destination
+  uint8_t  bias;        // Margin in dB added after missed ACKs
+  uint8_t  fallback;    // Frames left to send at full power
+  uint8_t  cleanCnt;    // Consecutive ACKs received without retries
+  uint16_t lastUse;     // Value of zmacTpcUseCnt at the last transmission
+} zmacTpcEntry_t;
+
+static ZMacTpcCfg_t zmacTpcCfg =
+{
+  FALSE,
+  ZMAC_TPC_DEFAULT_MARGIN,
+  ZMAC_TPC_DEFAULT_SENSITIVITY,
+  ZMAC_TPC_DEFAULT_FALLBACK
+};
+
+static zmacTpcEntry_t zmacTpcTable[ZMAC_TPC_MAX_ENTRIES];
+static uint16_t zmacTpcUseCnt;
+
 /********************************************************************************************************
  * FUNCTION PROTOTYPES
  ********************************************************************************************************/
 extern void NLME_SetEnergyThreshold( uint8_t value );
+static zmacTpcEntry_t *zmacTpcFind( uint16_t shortAddr );
+static void zmacTpcClear( void );
+static uint8_t zmacTpcSelectPower( uint16_t shortAddr, int8_t *pPower );
 /********************************************************************************************************
  *                                                TYPEDEFS
  ********************************************************************************************************/
@@ -1106,6 +1143,23 @@ uint8_t ZMacDataReqSec( ZMacDataReq_t *pData, applySecCB_t secCB )
   dataReq.channel = pData->Channel;
   dataReq.power = pData->Power;
 
+  // Direct unicasts go out at the lowest power that keeps the destination's link margin
+  if ( (zmacTpcCfg.enabled == TRUE) &&
+       (pData->DstAddr.addrMode == Addr16Bit) &&
+       (pData->DstAddr.addr.shortAddr <= ZMAC_TPC_ADDR_MAX) &&
+       ((pData->TxOptions & (ZMAC_TXOPTION_ACK | ZMAC_TXOPTION_INDIRECT |
+                             MAC_TXOPTION_PWR_CHAN | ZMAC_TXOPTION_GREEN_PWR)) == ZMAC_TXOPTION_ACK) )
+  {
+    int8_t power;
+
+    if ( zmacTpcSelectPower( pData->DstAddr.addr.shortAddr, &power ) == TRUE )
+    {
+      MAP_MAC_MlmeGetReq( MAC_LOGICAL_CHANNEL, &dataReq.channel );
+      dataReq.power = (uint8_t)power;
+      dataReq.txOptions.usePowerAndChannel = true;
+    }
+  }
+
   dataReq.gpOffset = pData->GpOffset;
   dataReq.gpDuration = pData->GpDuration;
 
@@ -1155,6 +1209,275 @@ uint8_t ZMacDataReq( ZMacDataReq_t *pData )
   return ZMacDataReqSec( pData, NULL );
 }
 
+/********************************************************************************************************
+ * @fn      ZMacTpcConfig
+ *
+ * @brief   Set the per-destination transmit power control configuration. While enabled, each
+ *          direct unicast is sent at the lowest power table entry that keeps the destination's
+ *          link margin, never above the transmit power set in MAC_PHY_TRANSMIT_POWER_SIGNED.
+ *
+ * @param   pCfg - new configuration
+ *
+ * @return  ZMacSuccess or ZMacInvalidParameter
+ ********************************************************************************************************/
+ZMacStatus_t ZMacTpcConfig( ZMacTpcCfg_t *pCfg )
+{
+  if ( (pCfg->enabled > TRUE) || (pCfg->margin == 0) )
+  {
+    return ( ZMacInvalidParameter );
+  }
+
+  // Start over from full power when the control is switched on again
+  if ( (pCfg->enabled == TRUE) && (zmacTpcCfg.enabled == FALSE) )
+  {
+    zmacTpcClear();
+  }
+
+  zmacTpcCfg = *pCfg;
+
+  return ( ZMacSuccess );
+}
+
+/********************************************************************************************************
+ * @fn      ZMacTpcGetConfig
+ *
+ * @brief   Return the per-destination transmit power control configuration.
+ *
+ * @param   pCfg - buffer for the configuration
+ *
+ * @return  none
+ ********************************************************************************************************/
+void ZMacTpcGetConfig( ZMacTpcCfg_t *pCfg )
+{
+  *pCfg = zmacTpcCfg;
+}
+
+/********************************************************************************************************
+ * @fn      ZMacTpcRxUpdate
+ *
+ * @brief   Fold the RSSI of a frame received from a tracked destination into its smoothed RSSI.
+ *
+ * @param   shortAddr - source of the frame
+ * @param   rssi - RSSI of the frame in dBm
+ *
+ * @return  none
+ ********************************************************************************************************/
+void ZMacTpcRxUpdate( uint16_t shortAddr, int8_t rssi )
+{
+  zmacTpcEntry_t *pEntry;
+
+  if ( zmacTpcCfg.enabled == FALSE )
+  {
+    return;
+  }
+
+  pEntry = zmacTpcFind( shortAddr );
+  if ( pEntry != NULL )
+  {
+    if ( pEntry->rssi == ZMAC_TPC_RSSI_UNKNOWN )
+    {
+      pEntry->rssi = rssi;
+    }
+    else
+    {
+      // Rounded to nearest, truncating would hold it up to 3 dB above a falling RSSI
+      int16_t sum = (int16_t)pEntry->rssi * 3 + rssi;
+
+      pEntry->rssi = (int8_t)((sum + ((sum < 0) ? -2 : 2)) / 4);
+    }
+  }
+}
+
+/********************************************************************************************************
+ * @fn      ZMacTpcTxUpdate
+ *
+ * @brief   Update a tracked destination with the result of an acknowledged transmission. A missed
+ *          ACK sends the next frames at full power and raises the destination's margin, clean
+ *          ACKs slowly take that margin back.
+ *
+ * @param   shortAddr - destination of the frame
+ * @param   status - MAC status of the data confirm
+ * @param   retries - number of retransmissions
+ * @param   ackRssi - RSSI of the ACK in dBm
+ *
+ * @return  none
+ ********************************************************************************************************/
+void ZMacTpcTxUpdate( uint16_t shortAddr, uint8_t status, uint8_t retries, int8_t ackRssi )
+{
+  zmacTpcEntry_t *pEntry;
+
+  if ( zmacTpcCfg.enabled == FALSE )
+  {
+    return;
+  }
+
+  pEntry = zmacTpcFind( shortAddr );
+  if ( pEntry == NULL )
+  {
+    return;
+  }
+
+  if ( status == MAC_NO_ACK )
+  {
+    pEntry->fallback = zmacTpcCfg.fallback;
+    pEntry->cleanCnt = 0;
+    pEntry->bias += ZMAC_TPC_MARGIN_STEP;
+    if ( pEntry->bias > ZMAC_TPC_MARGIN_BIAS_MAX )
+    {
+      pEntry->bias = ZMAC_TPC_MARGIN_BIAS_MAX;
+    }
+  }
+  else if ( status == MAC_SUCCESS )
+  {
+    ZMacTpcRxUpdate( shortAddr, ackRssi );
+
+    if ( retries != 0 )
+    {
+      pEntry->cleanCnt = 0;
+      if ( pEntry->bias < ZMAC_TPC_MARGIN_BIAS_MAX )
+      {
+        pEntry->bias++;
+      }
+    }
+    else if ( ++pEntry->cleanCnt >= ZMAC_TPC_BIAS_DECAY_CNT )
+    {
+      pEntry->cleanCnt = 0;
+      if ( pEntry->bias != 0 )
+      {
+        pEntry->bias--;
+      }
+    }
+  }
+}
+
+/********************************************************************************************************
+ * @fn      zmacTpcFind
+ *
+ * @brief   Find the transmit power control entry of a destination.
+ *
+ * @param   shortAddr - destination
+ *
+ * @return  pointer to the entry, NULL if the destination is not tracked
+ ********************************************************************************************************/
+static zmacTpcEntry_t *zmacTpcFind( uint16_t shortAddr )
+{
+  uint8_t i;
+
+  if ( shortAddr > ZMAC_TPC_ADDR_MAX )
+  {
+    return ( NULL );
+  }
+
+  for ( i = 0; i < ZMAC_TPC_MAX_ENTRIES; i++ )
+  {
+    if ( zmacTpcTable[i].shortAddr == shortAddr )
+    {
+      return ( &zmacTpcTable[i] );
+    }
+  }
+
+  return ( NULL );
+}
+
+/********************************************************************************************************
+ * @fn      zmacTpcClear
+ *
+ * @brief   Forget all tracked destinations.
+ *
+ * @param   none
+ *
+ * @return  none
+ ********************************************************************************************************/
+static void zmacTpcClear( void )
+{
+  uint8_t i;
+
+  memset( zmacTpcTable, 0, sizeof( zmacTpcTable ) );
+  for ( i = 0; i < ZMAC_TPC_MAX_ENTRIES; i++ )
+  {
+    zmacTpcTable[i].shortAddr = ZMAC_TPC_ADDR_FREE;
+  }
+  zmacTpcUseCnt = 0;
+}
+
+/********************************************************************************************************
+ * @fn      zmacTpcSelectPower
+ *
+ * @brief   Select the transmit power for a direct unicast. Links are taken as symmetric: the
+ *          destination's smoothed RSSI, less the sensitivity and the target margin, is the power
+ *          that can be shed from full power. The lowest power table entry covering the rest is
+ *          used. A destination that is not tracked yet replaces the least recently used entry
+ *          and is sent to at full power until it has been heard.
+ *
+ * @param   shortAddr - destination
+ * @param   pPower - selected power in dBm
+ *
+ * @return  TRUE if a reduced power was selected, FALSE to send at full power
+ ********************************************************************************************************/
+static uint8_t zmacTpcSelectPower( uint16_t shortAddr, int8_t *pPower )
+{
+  zmacTpcEntry_t *pEntry;
+  RF_TxPowerTable_Entry *pTable;
+  int8_t maxPower;
+  int16_t needed;
+  uint8_t i;
+
+  zmacTpcUseCnt++;
+
+  pEntry = zmacTpcFind( shortAddr );
+  if ( pEntry == NULL )
+  {
+    pEntry = &zmacTpcTable[0];
+    for ( i = 1; i < ZMAC_TPC_MAX_ENTRIES; i++ )
+    {
+      if ( (uint16_t)(zmacTpcUseCnt - zmacTpcTable[i].lastUse) >
+           (uint16_t)(zmacTpcUseCnt - pEntry->lastUse) )
+      {
+        pEntry = &zmacTpcTable[i];
+      }
+    }
+
+    pEntry->shortAddr = shortAddr;
+    pEntry->rssi = ZMAC_TPC_RSSI_UNKNOWN;
+    pEntry->bias = 0;
+    pEntry->fallback = 0;
+    pEntry->cleanCnt = 0;
+  }
+  pEntry->lastUse = zmacTpcUseCnt;
+
+  if ( pEntry->fallback != 0 )
+  {
+    pEntry->fallback--;
+    return ( FALSE );
+  }
+
+  if ( (pEntry->rssi == ZMAC_TPC_RSSI_UNKNOWN) || (pRfPowerTable == NULL) )
+  {
+    return ( FALSE );
+  }
+
+  MAP_MAC_MlmeGetReq( MAC_PHY_TRANSMIT_POWER_SIGNED, &maxPower );
+
+  needed = (int16_t)maxPower - ((int16_t)pEntry->rssi - zmacTpcCfg.sensitivity)
+           + zmacTpcCfg.margin + pEntry->bias;
+
+  // The power table is sorted by increasing power
+  for ( pTable = pRfPowerTable; pTable->power != RF_TxPowerTable_INVALID_DBM; pTable++ )
+  {
+    if ( pTable->power >= maxPower )
+    {
+      break;
+    }
+    if ( pTable->power >= needed )
+    {
+      *pPower = pTable->power;
+      return ( TRUE );
+    }
+  }
+
+  return ( FALSE );
+}
+
 /********************************************************************************************************
  * @fn      ZMacPurgeReq
  *
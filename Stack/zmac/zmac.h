@@ -194,6 +194,64 @@ typedef struct
   int8_t           rssi;
 } ZMacDataCnf_t;
 
+/* TRANSMIT POWER CONTROL */
+
+/* Number of destinations tracked by the transmit power control */
+#if !defined ( ZMAC_TPC_MAX_ENTRIES )
+  #define ZMAC_TPC_MAX_ENTRIES           16
+#endif
+
+#define ZMAC_TPC_DEFAULT_MARGIN          20     // Target link margin in dB
+#define ZMAC_TPC_DEFAULT_SENSITIVITY     (-97)  // Receiver sensitivity in dBm
+#define ZMAC_TPC_DEFAULT_FALLBACK        8      // Frames sent at full power after a missed ACK
+
+#define ZMAC_TPC_MARGIN_STEP             3      // dB added to a destination's margin per missed ACK
+#define ZMAC_TPC_MARGIN_BIAS_MAX         15     // Limit of the margin added by missed ACKs
+#define ZMAC_TPC_BIAS_DECAY_CNT          16     // Consecutive clean ACKs that remove 1 dB of bias
+
+/* Transmit power control configuration */
+typedef struct
+{
+  uint8_t enabled;      /* TRUE to select the transmit power per destination */
+  uint8_t margin;       /* Link margin in dB to keep above the receiver sensitivity */
+  int8_t  sensitivity;  /* Receiver sensitivity in dBm */
+  uint8_t fallback;     /* Frames sent at full power to a destination after a missed ACK */
+} ZMacTpcCfg_t;
+
+/* CHANNEL ACCESS */
+
+#define ZMAC_CSMA_FIRST_CHANNEL          11     // Channel of the first per-channel record
+#define ZMAC_CSMA_NUM_CHANNELS           16     // Channels 11 - 26
+#define ZMAC_CSMA_NB_BINS                6      // Backoffs needed per frame: 0 - 4, 5 or more
+
+/* Adaptive CSMA controller, evaluated once per window of data confirms */
+#if !defined ( ZMAC_CSMA_CTRL_WINDOW )
+  #define ZMAC_CSMA_CTRL_WINDOW          32
+#endif
+#define ZMAC_CSMA_CTRL_BUSY_HIGH         10     // % of CCA failures in a window that backs off further
+#define ZMAC_CSMA_CTRL_DEEP_HIGH         25     // % of frames needing 2+ backoffs that backs off further
+#define ZMAC_CSMA_CTRL_DEEP_LOW          5      // % of frames needing 2+ backoffs, below it steps back
+#define ZMAC_CSMA_MAX_MIN_BE             5      // Upper bound of macMinBE
+#define ZMAC_CSMA_MAX_MAX_BE             8      // Upper bound of macMaxBE
+#define ZMAC_CSMA_MAX_BACKOFFS           5      // Upper bound of macMaxCSMABackoffs
+
+/* Channel access outcomes of the data requests sent on one channel */
+typedef struct
+{
+  uint32_t txCnt;         /* Data confirms */
+  uint32_t ccaFailCnt;    /* MAC_CHANNEL_ACCESS_FAILURE, the channel stayed busy */
+  uint32_t noAckCnt;      /* MAC_NO_ACK */
+  uint32_t overflowCnt;   /* MAC_TRANSACTION_OVERFLOW */
+} ZMacChanAccessStats_t;
+
+/* CSMA-CA parameters */
+typedef struct
+{
+  uint8_t minBe;
+  uint8_t maxBe;
+  uint8_t maxBackoffs;
+} ZMacCsmaParams_t;
+
 
 /* ASSOCIATION TYPES */
 
@@ -670,6 +728,53 @@ typedef enum
    */
   extern ZMacLqiAdjust_t ZMacLqiAdjustMode( ZMacLqiAdjust_t mode );
 
+  /*
+   * This function sets the per-destination transmit power control configuration.
+   */
+  extern ZMacStatus_t ZMacTpcConfig( ZMacTpcCfg_t *pCfg );
+
+  /*
+   * This function returns the per-destination transmit power control configuration.
+   */
+  extern void ZMacTpcGetConfig( ZMacTpcCfg_t *pCfg );
+
+  /*
+   * This function feeds the RSSI of a frame received from a neighbor to the
+   * transmit power control.
+   */
+  extern void ZMacTpcRxUpdate( uint16_t shortAddr, int8_t rssi );
+
+  /*
+   * This function feeds the result of an acknowledged transmission to the
+   * transmit power control.
+   */
+  extern void ZMacTpcTxUpdate( uint16_t shortAddr, uint8_t status, uint8_t retries, int8_t ackRssi );
+
+  /*
+   * This function returns the channel access outcomes of one channel.
+   */
+  extern ZMacStatus_t ZMacChanAccessGetStats( uint8_t channel, ZMacChanAccessStats_t *pStats );
+
+  /*
+   * This function returns the histogram of backoffs needed per frame.
+   */
+  extern void ZMacChanAccessGetBackoffHist( uint32_t *pHist );
+
+  /*
+   * This function clears the channel access statistics.
+   */
+  extern void ZMacChanAccessClear( void );
+
+  /*
+   * This function enables or disables the adaptive CSMA controller.
+   */
+  extern void ZMacCsmaCtrlEnable( uint8_t enable );
+
+  /*
+   * This function returns the adaptive CSMA controller state and the CSMA-CA parameters in use.
+   */
+  extern uint8_t ZMacCsmaCtrlGet( ZMacCsmaParams_t *pParams );
+
   /*
    * This function sends out an enhanced active scan request
    */
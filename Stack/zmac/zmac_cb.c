@@ -94,6 +94,20 @@ const uint8_t CODE zmacCBSizeTable [] = {
   0                                 // MAC_MLME_WS_ASYNC_IND       18  WiSUN Async frame indication
 };
 
+/* CSMA-CA PIB attributes; MAC_MIN_BE and MAC_MAX_BE are redefined in mac_api.h */
+#define ZMAC_PIB_MIN_BE          0x4F
+#define ZMAC_PIB_MAX_BE          0x57
+
+/* Increase of the CSMA-CA parameters over the base ones per controller level */
+static const ZMacCsmaParams_t CODE zmacCsmaLevels[] = {
+  { 0, 0, 0 },
+  { 0, 0, 1 },
+  { 1, 1, 1 },
+  { 2, 2, 1 },
+  { 2, 3, 1 }
+};
+#define ZMAC_CSMA_NUM_LEVELS     (sizeof(zmacCsmaLevels) / sizeof(zmacCsmaLevels[0]))
+
 /********************************************************************************************************
  *                                               LOCALS
  ********************************************************************************************************/
@@ -104,6 +118,21 @@ static ZMacLqiAdjust_t lqiAdjMode = LQI_ADJ_OFF;
 /* LQI Adjustment Function */
 static void ZMacLqiAdjust( uint8_t corr, uint8_t* lqi );
 
+/* Channel access statistics */
+static ZMacChanAccessStats_t zmacChanAccessStats[ZMAC_CSMA_NUM_CHANNELS];
+static uint32_t zmacBackoffHist[ZMAC_CSMA_NB_BINS];
+
+/* Adaptive CSMA controller */
+static uint8_t zmacCsmaCtrlOn = FALSE;
+static uint8_t zmacCsmaLevel;
+static ZMacCsmaParams_t zmacCsmaBase;
+static uint8_t zmacCsmaWinCnt;
+static uint8_t zmacCsmaWinBusy;
+static uint8_t zmacCsmaWinDeep;
+
+static void ZMacChanAccessUpdate( macMcpsDataReq_t *pReq, uint8_t status );
+static void ZMacCsmaCtrlApply( void );
+
 /*********************************************************************
  * ZMAC Function Pointers
  */
@@ -327,6 +356,13 @@ void MAC_CbackEvent(macCbackEvent_t *pData)
       else
       {
         macDataInd_t *pInd = &msgPtr->dataInd.mac;
+
+        // Track the link to the sender for the transmit power control
+        if ( pInd->srcAddr.addrMode == SADDR_MODE_SHORT )
+        {
+          ZMacTpcRxUpdate( pInd->srcAddr.addr.shortAddr, pInd->rssi );
+        }
+
         // See if LQI needs adjustment due to frame correlation
         ZMacLqiAdjust( pInd->correlation, &pInd->mpduLinkQuality );
 
@@ -370,6 +406,18 @@ void MAC_CbackEvent(macCbackEvent_t *pData)
 
   if (event == MAC_MCPS_DATA_CNF && (pData->dataCnf.pDataReq != NULL))
   {
+    macMcpsDataReq_t *pReq = pData->dataCnf.pDataReq;
+
+    ZMacChanAccessUpdate( pReq, pData->hdr.status );
+
+    // Feed acknowledged direct unicasts back to the transmit power control
+    if ( (pReq->mac.dstAddr.addrMode == SADDR_MODE_SHORT) &&
+         ((pReq->internal.txOptions & (MAC_TXOPTION_ACK | MAC_TXOPTION_INDIRECT)) == MAC_TXOPTION_ACK) )
+    {
+      ZMacTpcTxUpdate( pReq->mac.dstAddr.addr.shortAddr, pData->hdr.status,
+                       pData->dataCnf.retries, pData->dataCnf.rssi );
+    }
+
     // If the application needs 'pDataReq' then we cannot free it here.
     // The application must free it after using it. Note that 'pDataReq'
     // is of macMcpsDataReq_t (and not ZMacDataReq_t) type.
@@ -428,6 +476,234 @@ uint8_t MAC_CbackQueryRetransmit(void)
 }
 
 
+/********************************************************************************************************
+ * @fn      ZMacChanAccessGetStats
+ *
+ * @brief   Return the channel access outcomes of one channel
+ *
+ * @param   channel - logical channel, ZMAC_CSMA_FIRST_CHANNEL and up
+ * @param   pStats - buffer for the outcomes
+ *
+ * @return  ZMacSuccess or ZMacInvalidParameter
+ ********************************************************************************************************/
+ZMacStatus_t ZMacChanAccessGetStats( uint8_t channel, ZMacChanAccessStats_t *pStats )
+{
+  if ( (channel < ZMAC_CSMA_FIRST_CHANNEL) ||
+       (channel >= ZMAC_CSMA_FIRST_CHANNEL + ZMAC_CSMA_NUM_CHANNELS) )
+  {
+    return ( ZMacInvalidParameter );
+  }
+
+  *pStats = zmacChanAccessStats[channel - ZMAC_CSMA_FIRST_CHANNEL];
+
+  return ( ZMacSuccess );
+}
+
+/********************************************************************************************************
+ * @fn      ZMacChanAccessGetBackoffHist
+ *
+ * @brief   Return the histogram of backoffs needed per frame
+ *
+ * @param   pHist - buffer for ZMAC_CSMA_NB_BINS counts
+ *
+ * @return  none
+ ********************************************************************************************************/
+void ZMacChanAccessGetBackoffHist( uint32_t *pHist )
+{
+  OsalPort_memcpy( pHist, zmacBackoffHist, sizeof( zmacBackoffHist ) );
+}
+
+/********************************************************************************************************
+ * @fn      ZMacChanAccessClear
+ *
+ * @brief   Clear the channel access statistics
+ *
+ * @param   none
+ *
+ * @return  none
+ ********************************************************************************************************/
+void ZMacChanAccessClear( void )
+{
+  memset( zmacChanAccessStats, 0, sizeof( zmacChanAccessStats ) );
+  memset( zmacBackoffHist, 0, sizeof( zmacBackoffHist ) );
+}
+
+/********************************************************************************************************
+ * @fn      ZMacCsmaCtrlEnable
+ *
+ * @brief   Enable or disable the adaptive CSMA controller. The CSMA-CA parameters in use when it is
+ *          enabled are its base, it only ever backs off further than those and restores them when
+ *          it is disabled.
+ *
+ * @param   enable - TRUE to enable
+ *
+ * @return  none
+ ********************************************************************************************************/
+void ZMacCsmaCtrlEnable( uint8_t enable )
+{
+  if ( enable && !zmacCsmaCtrlOn )
+  {
+    MAP_MAC_MlmeGetReq( ZMAC_PIB_MIN_BE, &zmacCsmaBase.minBe );
+    MAP_MAC_MlmeGetReq( ZMAC_PIB_MAX_BE, &zmacCsmaBase.maxBe );
+    MAP_MAC_MlmeGetReq( MAC_MAX_CSMA_BACKOFFS, &zmacCsmaBase.maxBackoffs );
+    zmacCsmaWinCnt = 0;
+    zmacCsmaWinBusy = 0;
+    zmacCsmaWinDeep = 0;
+    zmacCsmaCtrlOn = TRUE;
+  }
+  else if ( !enable && zmacCsmaCtrlOn )
+  {
+    zmacCsmaLevel = 0;
+    ZMacCsmaCtrlApply();
+    zmacCsmaCtrlOn = FALSE;
+  }
+}
+
+/********************************************************************************************************
+ * @fn      ZMacCsmaCtrlGet
+ *
+ * @brief   Return the adaptive CSMA controller state and the CSMA-CA parameters in use
+ *
+ * @param   pParams - buffer for the parameters
+ *
+ * @return  controller level, 0 when disabled or not backing off
+ ********************************************************************************************************/
+uint8_t ZMacCsmaCtrlGet( ZMacCsmaParams_t *pParams )
+{
+  MAP_MAC_MlmeGetReq( ZMAC_PIB_MIN_BE, &pParams->minBe );
+  MAP_MAC_MlmeGetReq( ZMAC_PIB_MAX_BE, &pParams->maxBe );
+  MAP_MAC_MlmeGetReq( MAC_MAX_CSMA_BACKOFFS, &pParams->maxBackoffs );
+
+  return ( zmacCsmaCtrlOn ? zmacCsmaLevel : 0 );
+}
+
+/********************************************************************************************************
+ * @fn      ZMacChanAccessUpdate
+ *
+ * @brief   Account a data confirm to its channel and run the adaptive CSMA controller. At the end of
+ *          each window the controller steps up one level when too many frames found the channel
+ *          busy, and steps back down once the channel is quiet again.
+ *
+ * @param   pReq - the confirmed data request
+ * @param   status - MAC status of the confirm
+ *
+ * @return  none
+ ********************************************************************************************************/
+static void ZMacChanAccessUpdate( macMcpsDataReq_t *pReq, uint8_t status )
+{
+  ZMacChanAccessStats_t *pStats;
+  uint8_t channel;
+  uint8_t nb = pReq->internal.nb;
+
+  if ( pReq->internal.txOptions & MAC_TXOPTION_PWR_CHAN )
+  {
+    channel = pReq->mac.channel;
+  }
+  else
+  {
+    MAP_MAC_MlmeGetReq( MAC_LOGICAL_CHANNEL, &channel );
+  }
+
+  if ( (channel >= ZMAC_CSMA_FIRST_CHANNEL) &&
+       (channel < ZMAC_CSMA_FIRST_CHANNEL + ZMAC_CSMA_NUM_CHANNELS) )
+  {
+    pStats = &zmacChanAccessStats[channel - ZMAC_CSMA_FIRST_CHANNEL];
+    pStats->txCnt++;
+    if ( status == MAC_CHANNEL_ACCESS_FAILURE )
+    {
+      pStats->ccaFailCnt++;
+    }
+    else if ( status == MAC_NO_ACK )
+    {
+      pStats->noAckCnt++;
+    }
+    else if ( status == MAC_TRANSACTION_OVERFLOW )
+    {
+      pStats->overflowCnt++;
+    }
+  }
+
+  // Overflowed and expired transactions never reached the channel
+  if ( (status == MAC_TRANSACTION_OVERFLOW) || (status == MAC_TRANSACTION_EXPIRED) )
+  {
+    return;
+  }
+
+  zmacBackoffHist[(nb < ZMAC_CSMA_NB_BINS) ? nb : (ZMAC_CSMA_NB_BINS - 1)]++;
+
+  if ( !zmacCsmaCtrlOn )
+  {
+    return;
+  }
+
+  if ( status == MAC_CHANNEL_ACCESS_FAILURE )
+  {
+    zmacCsmaWinBusy++;
+  }
+  if ( nb >= 2 )
+  {
+    zmacCsmaWinDeep++;
+  }
+
+  if ( ++zmacCsmaWinCnt < ZMAC_CSMA_CTRL_WINDOW )
+  {
+    return;
+  }
+
+  if ( ((zmacCsmaWinBusy * 100) >= (ZMAC_CSMA_CTRL_BUSY_HIGH * ZMAC_CSMA_CTRL_WINDOW)) ||
+       ((zmacCsmaWinDeep * 100) >= (ZMAC_CSMA_CTRL_DEEP_HIGH * ZMAC_CSMA_CTRL_WINDOW)) )
+  {
+    if ( zmacCsmaLevel < (ZMAC_CSMA_NUM_LEVELS - 1) )
+    {
+      zmacCsmaLevel++;
+      ZMacCsmaCtrlApply();
+    }
+  }
+  else if ( (zmacCsmaWinBusy == 0) &&
+            ((zmacCsmaWinDeep * 100) < (ZMAC_CSMA_CTRL_DEEP_LOW * ZMAC_CSMA_CTRL_WINDOW)) )
+  {
+    if ( zmacCsmaLevel > 0 )
+    {
+      zmacCsmaLevel--;
+      ZMacCsmaCtrlApply();
+    }
+  }
+
+  zmacCsmaWinCnt = 0;
+  zmacCsmaWinBusy = 0;
+  zmacCsmaWinDeep = 0;
+}
+
+/********************************************************************************************************
+ * @fn      ZMacCsmaCtrlApply
+ *
+ * @brief   Set the CSMA-CA parameters of the current controller level, within the safe bounds
+ *
+ * @param   none
+ *
+ * @return  none
+ ********************************************************************************************************/
+static void ZMacCsmaCtrlApply( void )
+{
+  ZMacCsmaParams_t params;
+
+  params.minBe = zmacCsmaBase.minBe + zmacCsmaLevels[zmacCsmaLevel].minBe;
+  params.maxBe = zmacCsmaBase.maxBe + zmacCsmaLevels[zmacCsmaLevel].maxBe;
+  params.maxBackoffs = zmacCsmaBase.maxBackoffs + zmacCsmaLevels[zmacCsmaLevel].maxBackoffs;
+
+  if ( zmacCsmaLevel != 0 )
+  {
+    params.minBe = MIN( params.minBe, ZMAC_CSMA_MAX_MIN_BE );
+    params.maxBe = MIN( params.maxBe, ZMAC_CSMA_MAX_MAX_BE );
+    params.maxBackoffs = MIN( params.maxBackoffs, ZMAC_CSMA_MAX_BACKOFFS );
+    params.minBe = MIN( params.minBe, params.maxBe );
+  }
+
+  MAP_MAC_MlmeSetReq( ZMAC_PIB_MAX_BE, &params.maxBe );
+  MAP_MAC_MlmeSetReq( ZMAC_PIB_MIN_BE, &params.minBe );
+  MAP_MAC_MlmeSetReq( MAC_MAX_CSMA_BACKOFFS, &params.maxBackoffs );
+}
+
 /********************************************************************************************************
  * @fn      ZMacLqiAdjustMode
  *